@@ -0,0 +1,164 @@
+#include <benchmark/benchmark.h>
+
+#include <flexcore/extended/ports/connection_buffer.hpp>
+#include <flexcore/extended/ports/node_aware.hpp>
+#include <flexcore/scheduler/cyclecontrol.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace fc
+{
+namespace bench
+{
+
+// Benchmarks of buffers between regions.
+// Buffers are ticked directly, which measures the cost of the buffer itself
+// without threads. The number of events per cycle is the range of the benchmarks,
+// the payload is the template parameter.
+
+using fc::operator>>;
+
+using small_payload = int;
+using medium_payload = std::array<char, 256>;
+using large_payload = std::vector<float>;
+
+template<class payload_t>
+payload_t make_payload() { return payload_t{}; }
+
+template<>
+large_payload make_payload<large_payload>() { return large_payload(1024, 1.0f); }
+
+/// sends range(0) events per cycle through buffer_t.
+template<class buffer_t, class payload_t>
+void event_buffer_throughput(buffer_t& buffer, benchmark::State& state) {
+	const auto payload = make_payload<payload_t>();
+	size_t received = 0;
+	pure::event_source<payload_t> source{};
+	pure::event_sink<payload_t> sink{[&received](const payload_t&){ ++received; }};
+	source >> buffer.in();
+	buffer.out() >> sink;
+
+	const auto events_per_cycle = state.range(0);
+	while (state.KeepRunning()) {
+		for (int i = 0; i != events_per_cycle; ++i)
+			source.fire(payload);
+		buffer.switch_active_passive_tick()();
+		buffer.work_tick()();
+		benchmark::DoNotOptimize(received);
+	}
+	state.SetItemsProcessed(state.iterations() * events_per_cycle);
+}
+
+template<class payload_t>
+void vector_event_buffer(benchmark::State& state) {
+	event_buffer<payload_t> buffer{};
+	event_buffer_throughput<event_buffer<payload_t>, payload_t>(buffer, state);
+}
+
+template<class payload_t>
+void ring_buffer(benchmark::State& state) {
+	ring_event_buffer<payload_t> buffer{static_cast<size_t>(state.range(0))};
+	event_buffer_throughput<ring_event_buffer<payload_t>, payload_t>(buffer, state);
+}
+
+template<class payload_t>
+void coalescing_buffer(benchmark::State& state) {
+	coalescing_event_buffer<payload_t> buffer{};
+	event_buffer_throughput<coalescing_event_buffer<payload_t>, payload_t>(buffer, state);
+}
+
+/// a batch of range(0) events per cycle, which is passed on at once.
+template<class payload_t>
+void batched_event_buffer(benchmark::State& state) {
+	event_buffer<payload_t> buffer{};
+	std::vector<payload_t> batch(state.range(0), make_payload<payload_t>());
+	size_t received = 0;
+	pure::event_source<payload_t> source{};
+	pure::event_sink<payload_t> sink{[&received](const payload_t&){ ++received; },
+		[&received](span<const payload_t> events){ received += events.size(); }};
+	source >> buffer.in();
+	buffer.out() >> sink;
+
+	while (state.KeepRunning()) {
+		source.fire_batch(batch);
+		buffer.switch_active_passive_tick()();
+		buffer.work_tick()();
+		benchmark::DoNotOptimize(received);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/// states are written once per cycle and read range(0) times.
+template<class payload_t>
+void state_buffer_reads(benchmark::State& state) {
+	const auto payload = make_payload<payload_t>();
+	fc::state_buffer<payload_t> buffer{};
+	pure::state_source<payload_t> source{[&payload]() { return payload; }};
+	pure::state_sink<payload_t> sink{};
+	source >> buffer.in();
+	buffer.out() >> sink;
+
+	const auto reads_per_cycle = state.range(0);
+	while (state.KeepRunning()) {
+		buffer.work_tick()();
+		buffer.switch_active_passive_tick()();
+		for (int i = 0; i != reads_per_cycle; ++i)
+			benchmark::DoNotOptimize(sink.get());
+	}
+	state.SetItemsProcessed(state.iterations() * reads_per_cycle);
+}
+
+/// a single event sent to range(0) sinks in another region, each with its own buffer.
+void fan_out_across_regions(benchmark::State& state) {
+	constexpr auto tick = thread::cycle_control::fast_tick;
+	auto source_region = std::make_shared<parallel_region>("source", tick);
+	auto sink_region = std::make_shared<parallel_region>("sink", tick);
+
+	size_t received = 0;
+	node_aware<pure::event_source<medium_payload>> source{*source_region};
+	std::vector<std::unique_ptr<node_aware<pure::event_sink<medium_payload>>>> sinks;
+	for (int i = 0; i != state.range(0); ++i) {
+		sinks.push_back(std::make_unique<node_aware<pure::event_sink<medium_payload>>>(
+				*sink_region, [&received](const medium_payload&){ ++received; }));
+		source >> *sinks.back();
+	}
+
+	const medium_payload payload{};
+	while (state.KeepRunning()) {
+		source.fire(payload);
+		source_region->ticks.switch_buffers();
+		sink_region->ticks.in_work()();
+		benchmark::DoNotOptimize(received);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+constexpr int max_events_per_cycle = 4096;
+
+BENCHMARK_TEMPLATE(vector_event_buffer, small_payload)
+		->RangeMultiplier(8)->Range(1, max_events_per_cycle);
+BENCHMARK_TEMPLATE(vector_event_buffer, medium_payload)
+		->RangeMultiplier(8)->Range(1, max_events_per_cycle);
+BENCHMARK_TEMPLATE(vector_event_buffer, large_payload)
+		->RangeMultiplier(8)->Range(1, max_events_per_cycle);
+BENCHMARK_TEMPLATE(ring_buffer, small_payload)
+		->RangeMultiplier(8)->Range(1, max_events_per_cycle);
+BENCHMARK_TEMPLATE(ring_buffer, medium_payload)
+		->RangeMultiplier(8)->Range(1, max_events_per_cycle);
+BENCHMARK_TEMPLATE(coalescing_buffer, small_payload)
+		->RangeMultiplier(8)->Range(1, max_events_per_cycle);
+BENCHMARK_TEMPLATE(coalescing_buffer, medium_payload)
+		->RangeMultiplier(8)->Range(1, max_events_per_cycle);
+BENCHMARK_TEMPLATE(batched_event_buffer, small_payload)
+		->RangeMultiplier(8)->Range(1, max_events_per_cycle);
+BENCHMARK_TEMPLATE(batched_event_buffer, medium_payload)
+		->RangeMultiplier(8)->Range(1, max_events_per_cycle);
+BENCHMARK_TEMPLATE(state_buffer_reads, small_payload)->RangeMultiplier(8)->Range(1, 512);
+BENCHMARK_TEMPLATE(state_buffer_reads, large_payload)->RangeMultiplier(8)->Range(1, 512);
+BENCHMARK(fan_out_across_regions)->RangeMultiplier(2)->Range(1, 64);
+
+}
+}
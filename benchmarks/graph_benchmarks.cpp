@@ -0,0 +1,190 @@
+#include <benchmark/benchmark.h>
+
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/infrastructure.hpp>
+#include <flexcore/ports.hpp>
+#include <flexcore/scheduler/parallelscheduler.hpp>
+
+#include <malloc.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fc
+{
+namespace bench
+{
+
+// Benchmarks of synthetic graphs of increasing size, built on infrastructure.
+// The graph is shaped by the range arguments of the benchmarks:
+//   range(0) number of regions, all with the same tick rate
+//   range(1) number of nodes per region, arranged in layers
+//   range(2) fan-in of every node, the fan-out is about the same
+//   range(3) percentage of connections which pull states, the others are events
+//   range(4) bytes of the payload of every connection
+// Node i of a region receives from node i-1 of the same and following regions,
+// so connections cross regions as soon as the fan-in is larger than one.
+
+using fc::operator>>;
+using payload_t = std::vector<char>;
+
+struct graph_shape {
+	int regions;
+	int nodes;
+	int fan_in;
+	int state_percent;
+	int payload;
+};
+
+graph_shape shape_of(const benchmark::State& state) {
+	return graph_shape{static_cast<int>(state.range(0)), static_cast<int>(state.range(1)),
+			static_cast<int>(state.range(2)), static_cast<int>(state.range(3)),
+			static_cast<int>(state.range(4))};
+}
+
+/// node sending its payload to all successors once per cycle, and pulling its states.
+class relay : public tree_base_node {
+public:
+	relay(size_t payload_size, const node_args& node)
+		: tree_base_node(node)
+		, value(payload_size, 'x')
+		, out(this)
+		, state_out(this, [this]{ return value; })
+		, in(this, [this](const payload_t& payload){ received += payload.size() + 1; })
+	{
+	}
+
+	/// adds a state input, each state connection needs a sink of its own.
+	state_sink<payload_t>& add_state_input() {
+		state_in.push_back(std::make_unique<state_sink<payload_t>>(this));
+		return *state_in.back();
+	}
+
+	void step() {
+		for (auto& state : state_in)
+			received += state->get().size() + 1;
+		out.fire(value);
+	}
+
+	payload_t value;
+	event_source<payload_t> out;
+	state_source<payload_t> state_out;
+	event_sink<payload_t> in;
+	std::vector<std::unique_ptr<state_sink<payload_t>>> state_in;
+	size_t received = 0;
+};
+
+/// bytes allocated from the heap by the process.
+size_t heap_in_use() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+	return mallinfo2().uordblks;
+#else
+	return 0;
+#endif
+}
+
+/// application with a graph of the given shape, run as fast as possible.
+struct synthetic_graph {
+	explicit synthetic_graph(const graph_shape& shape)
+		: application(std::make_unique<thread::parallel_scheduler>(),
+				std::make_shared<thread::afap_main_loop>(),
+				std::make_shared<clock_domain>(),
+				[](thread::periodic_task& task) {
+					while (!task.wait_until_done(thread::cycle_control::slow_tick))
+						;
+					return true;
+				}) {
+		// regions is not resized afterwards, work ticks refer to its elements.
+		regions.resize(shape.regions);
+		for (int r = 0; r != shape.regions; ++r) {
+			const auto region = application.add_region(
+					"region_" + std::to_string(r), thread::cycle_control::fast_tick);
+			auto& nodes = regions[r];
+			for (int i = 0; i != shape.nodes; ++i)
+				nodes.push_back(&application.node_owner().make_child_named<relay>(region,
+						"node_" + std::to_string(r) + "_" + std::to_string(i),
+						static_cast<size_t>(shape.payload)));
+			region->ticks.work_tick() >> [&nodes]() {
+				for (auto node : nodes)
+					node->step();
+			};
+		}
+
+		for (int r = 0; r != shape.regions; ++r)
+			for (int i = 1; i < shape.nodes; ++i)
+				for (int k = 0; k != shape.fan_in; ++k) {
+					const int layer = i - 1 - k / shape.regions;
+					if (layer < 0)
+						break;
+					auto& source = *regions[(r + k) % shape.regions][layer];
+					auto& sink = *regions[r][i];
+					// spreads states evenly over the connections.
+					if ((connections * 37) % 100 < static_cast<size_t>(shape.state_percent))
+						source.state_out >> sink.add_state_input();
+					else
+						source.out >> sink.in;
+					++connections;
+				}
+	}
+
+	infrastructure application;
+	std::vector<std::vector<relay*>> regions;
+	size_t connections = 0;
+};
+
+/// time to construct and connect the graph, and the heap it occupies per node.
+void graph_construction(benchmark::State& state) {
+	const auto shape = shape_of(state);
+	const auto nr_of_nodes = shape.regions * shape.nodes;
+	size_t bytes = 0;
+	size_t connections = 0;
+
+	while (state.KeepRunning()) {
+		const auto before = heap_in_use();
+		auto graph = std::make_unique<synthetic_graph>(shape);
+		bytes = heap_in_use() - before;
+		connections = graph->connections;
+		state.PauseTiming();
+		graph.reset();
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * nr_of_nodes);
+	state.counters["connections"] = connections;
+	state.counters["bytes_per_node"] = static_cast<double>(bytes) / nr_of_nodes;
+}
+
+/// duration of a cycle of the whole graph, whose inverse is the highest tick rate it sustains.
+void graph_cycle(benchmark::State& state) {
+	const auto shape = shape_of(state);
+	synthetic_graph graph{shape};
+	// buffers and std::function reach their steady state within a few cycles.
+	graph.application.run_cycles(10);
+
+	while (state.KeepRunning())
+		graph.application.run_cycles(1);
+	state.SetItemsProcessed(state.iterations() * shape.regions * shape.nodes);
+	state.counters["connections"] = graph.connections;
+	state.counters["max_tick_rate"] =
+			benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+}
+
+void graph_shapes(benchmark::internal::Benchmark* benchmark) {
+	// growing number of nodes, then regions, then fan-in.
+	for (int nodes : {16, 256, 4096})
+		benchmark->Args({4, nodes, 2, 50, 64});
+	for (int regions : {1, 16, 64})
+		benchmark->Args({regions, 256, 2, 50, 64});
+	for (int fan_in : {1, 8, 32})
+		benchmark->Args({4, 256, fan_in, 50, 64});
+	// events only, states only and large payloads.
+	benchmark->Args({4, 256, 4, 0, 64});
+	benchmark->Args({4, 256, 4, 100, 64});
+	benchmark->Args({4, 256, 4, 50, 4096});
+}
+
+BENCHMARK(graph_construction)->Apply(graph_shapes)->Unit(benchmark::kMillisecond);
+BENCHMARK(graph_cycle)->Apply(graph_shapes)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+}
+}
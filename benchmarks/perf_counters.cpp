@@ -0,0 +1,120 @@
+#include "perf_counters.h"
+
+#ifdef FLEXCORE_BENCHMARK_PERF_COUNTERS
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+namespace fc
+{
+namespace bench
+{
+
+#ifdef FLEXCORE_BENCHMARK_PERF_COUNTERS
+namespace
+{
+int open_counter(uint32_t type, uint64_t config)
+{
+	perf_event_attr attr;
+	std::memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	// calling thread on any cpu, there is no glibc wrapper for perf_event_open.
+	return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+}
+
+perf_counters::perf_counters()
+	: fds{{open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES),
+			open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS),
+			open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES),
+			open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES)}}
+{
+}
+
+perf_counters::~perf_counters()
+{
+	for (auto fd : fds)
+		if (fd >= 0)
+			close(fd);
+}
+
+void perf_counters::start()
+{
+	for (auto fd : fds)
+		if (fd >= 0)
+		{
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+}
+
+void perf_counters::stop()
+{
+	for (auto fd : fds)
+		if (fd >= 0)
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+}
+
+perf_counters::values perf_counters::read() const
+{
+	values result{};
+	for (size_t e = 0; e != nr_of_events; ++e)
+		if (fds[e] < 0 || ::read(fds[e], &result[e], sizeof(uint64_t)) != sizeof(uint64_t))
+			result[e] = 0;
+	return result;
+}
+#else
+perf_counters::perf_counters()
+{
+	fds.fill(-1);
+}
+
+perf_counters::~perf_counters() = default;
+void perf_counters::start() {}
+void perf_counters::stop() {}
+perf_counters::values perf_counters::read() const { return values{}; }
+#endif
+
+bool counted_fixture::keep_running(benchmark::State& state, double items_per_iteration)
+{
+	if (!counting)
+	{
+		counting = true;
+		counters.start();
+	}
+	if (state.KeepRunning())
+		return true;
+
+	counters.stop();
+	counting = false;
+	const auto counted = counters.read();
+	const auto items = static_cast<double>(state.iterations()) * items_per_iteration;
+	if (items == 0)
+		return false;
+	const auto report = [&](const char* name, perf_counters::event e)
+	{
+		if (counters.available(e))
+			state.counters[name] = static_cast<double>(counted[e]) / items;
+	};
+	report("cycles", perf_counters::cycles);
+	report("instructions", perf_counters::instructions);
+	report("cache_misses", perf_counters::cache_misses);
+	report("branch_misses", perf_counters::branch_misses);
+	if (counters.available(perf_counters::cycles) && counters.available(perf_counters::instructions)
+			&& counted[perf_counters::cycles] != 0)
+		state.counters["IPC"] = static_cast<double>(counted[perf_counters::instructions])
+				/ counted[perf_counters::cycles];
+	return false;
+}
+
+}
+}
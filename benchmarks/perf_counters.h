@@ -0,0 +1,80 @@
+#ifndef BENCHMARKS_PERF_COUNTERS_H_
+#define BENCHMARKS_PERF_COUNTERS_H_
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+
+namespace fc
+{
+namespace bench
+{
+
+/**
+ * \brief hardware performance counters of a thread.
+ *
+ * Read with perf_event_open on linux, if the benchmarks are built with
+ * FLEXCORE_BENCHMARK_PERF_COUNTERS. Events the kernel refuses, for instance with
+ * perf_event_paranoid above 2 or inside virtual machines, are not available.
+ * Only user space of the thread constructing the counters is counted.
+ */
+class perf_counters
+{
+public:
+	enum event
+	{
+		cycles,
+		instructions,
+		cache_misses,
+		branch_misses,
+		nr_of_events
+	};
+	using values = std::array<uint64_t, nr_of_events>;
+
+	perf_counters();
+	perf_counters(const perf_counters&) = delete;
+	perf_counters& operator=(const perf_counters&) = delete;
+	~perf_counters();
+
+	bool available(event e) const { return fds[e] >= 0; }
+
+	/// resets and starts all available counters.
+	void start();
+	void stop();
+	/// returns the events counted since start, zero for counters not available.
+	values read() const;
+
+private:
+	std::array<int, nr_of_events> fds;
+};
+
+/**
+ * \brief fixture reporting hardware counters per item, for benchmarks of ports and nodes.
+ *
+ * Benchmarks loop with keep_running instead of state.KeepRunning.
+ * Items are what the benchmark is about, e.g. the ports or nodes passed in one iteration,
+ * counters are reported per item: cycles, instructions, IPC, cache_misses and branch_misses.
+ * Counters which are not available are left out.
+ *
+ *     BENCHMARK_DEFINE_F(counted_fixture, chain)(benchmark::State& state) {
+ *         ... build range(0) nodes
+ *         while (keep_running(state, state.range(0)))
+ *             ...
+ *     }
+ */
+class counted_fixture : public benchmark::Fixture
+{
+public:
+	/// starts counting at the first call, reports the counters once state is done.
+	bool keep_running(benchmark::State& state, double items_per_iteration = 1.0);
+
+private:
+	perf_counters counters;
+	bool counting = false;
+};
+
+}
+}
+
+#endif /* BENCHMARKS_PERF_COUNTERS_H_ */
@@ -2,10 +2,14 @@
 
 #include <flexcore/core/connection.hpp>
 #include <flexcore/core/connectables.hpp>
+#include <flexcore/pure/static_state_sink.hpp>
 
 #include "benchmarkfunctions.h"
+#include "perf_counters.h"
 
+#include <memory>
 #include <random>
+#include <vector>
 
 namespace fc
 {
@@ -57,6 +61,26 @@ void pure_port(benchmark::State& state) {
 	}
 }
 
+void static_port(benchmark::State& state) {
+	std::random_device rd;
+	std::mt19937 gen(rd());
+
+
+	float x = gen();
+
+	// the chain keeps its static type, thus get can be inlined like the lambda.
+	auto sink = fc::pure::make_static_state_sink([&x](){ return x; } >> fc::identity{});
+
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(x);
+
+		const float a = sink.get();
+
+		assert(a == x);
+		benchmark::DoNotOptimize(a);
+	}
+}
+
 void virtual_function(benchmark::State& state) {
 	std::random_device rd;
 	std::mt19937 gen(rd());
@@ -102,11 +126,121 @@ void extended_node(benchmark::State& state) {
 }
 
 
+constexpr int fan_out = 4;
+
+void fan_out_event_source(benchmark::State& state) {
+	std::random_device rd;
+	std::mt19937 gen(rd());
+
+	float x = gen();
+	float sum = 0.0;
+
+	fc::pure::event_source<float> source{};
+	for (int i = 0; i != fan_out; ++i)
+		source >> [&sum](float in){ sum += in; };
+
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(x);
+
+		source.fire(x);
+
+		benchmark::DoNotOptimize(sum);
+	}
+}
+
+void fan_out_static_event_source(benchmark::State& state) {
+	std::random_device rd;
+	std::mt19937 gen(rd());
+
+	float x = gen();
+	float sum = 0.0;
+
+	auto add = [&sum](float in){ sum += in; };
+	auto source = fc::pure::make_static_event_source<float>(add, add, add, add);
+	static_assert(decltype(source)::nr_connected_handlers() == fan_out,
+			"same number of handlers as in fan_out_event_source");
+
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(x);
+
+		source.fire(x);
+
+		benchmark::DoNotOptimize(sum);
+	}
+}
+
+void fan_out_virtual_function(benchmark::State& state) {
+	std::random_device rd;
+	std::mt19937 gen(rd());
+
+	float x = gen();
+	float sum = 0.0;
+
+	std::vector<std::unique_ptr<base_class>> objs;
+	for (int i = 0; i != fan_out; ++i)
+		objs.push_back(make_inherited());
+
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(x);
+
+		for (const auto& obj : objs)
+			sum += obj->foo(x);
+
+		benchmark::DoNotOptimize(sum);
+	}
+}
+
+/// event fired to range(0) pure sinks, counters are per sink.
+BENCHMARK_DEFINE_F(counted_fixture, event_ports)(benchmark::State& state) {
+	float x = 1.0;
+	float sum = 0.0;
+
+	fc::pure::event_source<float> source{};
+	for (int i = 0; i != state.range(0); ++i)
+		source >> [&sum](float in){ sum += in; };
+
+	while (keep_running(state, static_cast<double>(state.range(0)))) {
+		benchmark::DoNotOptimize(x);
+
+		source.fire(x);
+
+		benchmark::DoNotOptimize(sum);
+	}
+}
+
+/// state pulled through a chain of range(0) nodes, counters are per node.
+BENCHMARK_DEFINE_F(counted_fixture, node_chain)(benchmark::State& state) {
+	float x = 1.0;
+
+	fc::tests::owning_node owner{};
+	auto* last = &owner.make_child_named<fc::state_terminal<float>>("first");
+	[&x](){ return x; } >> last->in();
+	for (int i = 1; i != state.range(0); ++i) {
+		auto& next = owner.make_child_named<fc::state_terminal<float>>("node");
+		last->out() >> next.in();
+		last = &next;
+	}
+
+	while (keep_running(state, static_cast<double>(state.range(0)))) {
+		benchmark::DoNotOptimize(x);
+
+		const float a = last->out()();
+
+		assert(a == x);
+		benchmark::DoNotOptimize(a);
+	}
+}
 
 BENCHMARK(lambda);
 BENCHMARK(virtual_function);
 BENCHMARK(pure_port);
+BENCHMARK(static_port);
 BENCHMARK(extended_node);
+BENCHMARK(fan_out_virtual_function);
+BENCHMARK(fan_out_event_source);
+BENCHMARK(fan_out_static_event_source);
+BENCHMARK_REGISTER_F(counted_fixture, event_ports)->RangeMultiplier(8)->Range(1, 4096);
+BENCHMARK_REGISTER_F(counted_fixture, node_chain)->RangeMultiplier(8)->Range(1, 512);
 
 }
 }
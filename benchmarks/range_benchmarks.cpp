@@ -1,6 +1,7 @@
 #include <benchmark/benchmark.h>
 
 #include <flexcore/range/actions.hpp>
+#include <flexcore/range/views.hpp>
 #include <flexcore/core/connection.hpp>
 
 #include <random>
@@ -58,8 +59,35 @@ struct fc_filter_map {
 	}
 };
 
+struct fc_filter_map_lazy {
+	decltype(auto) operator()(std::vector<float> in, float x, float y) {
+		return (fc::views::filter([](auto in){ return in > filter_value;})
+				>> fc::views::map([x](auto in) {return x * in;})
+				>> fc::views::map([y](auto in) {return y + in;}))(in);
+	}
+};
+
 constexpr auto benchmark_size = 2 << 15;
 
+/// reduction of a range by fc::sum, which keeps the order of additions.
+struct fc_sum {
+	float operator()(const std::vector<float>& in) { return fc::sum(0.0f)(in); }
+};
+
+/// reduction of a range by fc::lanewise_sum, which uses independent partial sums.
+struct fc_lanewise_sum {
+	float operator()(const std::vector<float>& in) { return fc::lanewise_sum(0.0f)(in); }
+};
+
+template<class T> void reduce_f(benchmark::State& state) {
+	T f;
+	std::vector<float> in(state.range(0), 1.0f);
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(f(in));
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
 /// Copying a std::vector serves as a simple baseline
 static void VectorCopy(benchmark::State& state) {
 	std::vector<int> vec(state.range(0));
@@ -104,10 +132,17 @@ BENCHMARK_TEMPLATE(vector_f, fc_map)
 BENCHMARK_TEMPLATE(vector_f, fc_map_inline)
 		->RangeMultiplier(2)->Range(64, benchmark_size);
 
+BENCHMARK_TEMPLATE(reduce_f, fc_sum)
+		->RangeMultiplier(2)->Range(64, benchmark_size);
+BENCHMARK_TEMPLATE(reduce_f, fc_lanewise_sum)
+		->RangeMultiplier(2)->Range(64, benchmark_size);
+
 BENCHMARK_TEMPLATE(vector_f, filter_loop)
 		->RangeMultiplier(2)->Range(64, benchmark_size);
 BENCHMARK_TEMPLATE(vector_f, fc_filter_map)
 		->RangeMultiplier(2)->Range(64, benchmark_size);
+BENCHMARK_TEMPLATE(vector_f, fc_filter_map_lazy)
+		->RangeMultiplier(2)->Range(64, benchmark_size);
 
 }
 }
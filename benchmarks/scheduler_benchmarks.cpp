@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+
+#include <flexcore/scheduler/cyclecontrol.hpp>
+#include <flexcore/scheduler/parallelscheduler.hpp>
+#include <flexcore/scheduler/workstealingscheduler.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace fc
+{
+namespace bench
+{
+
+// Benchmarks of the schedulers and of cycle_control.
+// The number of worker threads is the last range argument of all benchmarks.
+
+thread::thread_config workers(int nr_of_threads) {
+	thread::thread_config config{};
+	config.nr_of_threads = nr_of_threads;
+	return config;
+}
+
+/// time from adding a single task until it has been executed by a worker.
+template<class scheduler_t>
+void dispatch_latency(benchmark::State& state) {
+	scheduler_t scheduler{workers(state.range(0))};
+	std::atomic<bool> done{false};
+
+	while (state.KeepRunning()) {
+		done.store(false);
+		scheduler.add_task([&done] { done.store(true, std::memory_order_release); });
+		while (!done.load(std::memory_order_acquire))
+			std::this_thread::yield();
+	}
+	scheduler.stop();
+}
+
+/// time to execute a batch of range(0) small tasks, added at once.
+template<class scheduler_t>
+void batch_throughput(benchmark::State& state) {
+	scheduler_t scheduler{workers(state.range(1))};
+	const auto nr_of_tasks = state.range(0);
+	std::atomic<int> remaining{0};
+	std::vector<thread::scheduler::affine_task> batch;
+
+	while (state.KeepRunning()) {
+		remaining.store(nr_of_tasks);
+		for (int i = 0; i != nr_of_tasks; ++i)
+			batch.push_back({[&remaining] { remaining.fetch_sub(1); }, 0, 0});
+		scheduler.add_tasks(batch);
+		while (remaining.load() != 0)
+			std::this_thread::yield();
+	}
+	scheduler.stop();
+	state.SetItemsProcessed(state.iterations() * nr_of_tasks);
+}
+
+/// overhead of a single cycle of cycle_control::work with range(0) empty tasks.
+void cycle_control_work(benchmark::State& state) {
+	thread::cycle_control controller{
+			std::make_unique<thread::parallel_scheduler>(workers(state.range(1))),
+			std::make_shared<thread::afap_main_loop>()};
+	std::atomic<long> executed{0};
+	for (int i = 0; i != state.range(0); ++i)
+		controller.add_task(thread::periodic_task{[&executed] { ++executed; }},
+				thread::cycle_control::fast_tick);
+
+	while (state.KeepRunning())
+		controller.work();
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	benchmark::DoNotOptimize(executed.load());
+}
+
+constexpr int max_threads = 8;
+
+BENCHMARK_TEMPLATE(dispatch_latency, thread::parallel_scheduler)
+		->RangeMultiplier(2)->Range(1, max_threads)->UseRealTime();
+BENCHMARK_TEMPLATE(dispatch_latency, thread::work_stealing_scheduler)
+		->RangeMultiplier(2)->Range(1, max_threads)->UseRealTime();
+BENCHMARK_TEMPLATE(batch_throughput, thread::parallel_scheduler)
+		->RangeMultiplier(4)->Ranges({{1, 1024}, {1, max_threads}})->UseRealTime();
+BENCHMARK_TEMPLATE(batch_throughput, thread::work_stealing_scheduler)
+		->RangeMultiplier(4)->Ranges({{1, 1024}, {1, max_threads}})->UseRealTime();
+BENCHMARK(cycle_control_work)
+		->RangeMultiplier(4)->Ranges({{1, 256}, {1, max_threads}})->UseRealTime();
+
+}
+}
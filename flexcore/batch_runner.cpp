@@ -0,0 +1,93 @@
+#include <flexcore/batch_runner.hpp>
+#include <flexcore/scheduler/shared_scheduler.hpp>
+#include <flexcore/scheduler/workstealingscheduler.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace fc
+{
+
+batch_runner::batch_runner(thread::thread_config workers, size_t nr_of_drivers)
+	: pool(std::make_shared<thread::work_stealing_scheduler>(std::move(workers)))
+	, drivers(nr_of_drivers == 0 ? pool->nr_of_threads() : nr_of_drivers)
+{
+}
+
+batch_runner::~batch_runner()
+{
+	instances.clear();
+	pool->stop();
+}
+
+infrastructure& batch_runner::add_instance(std::string name)
+{
+	const auto wait_for_task = [](thread::periodic_task& task)
+	{
+		while (!task.wait_until_done(thread::cycle_control::slow_tick))
+			;
+		return true;
+	};
+	instances.push_back(instance{std::move(name), std::make_unique<infrastructure>(
+			std::make_unique<thread::shared_scheduler>(pool),
+			std::make_shared<thread::afap_main_loop>(),
+			std::make_shared<clock_domain>(),
+			wait_for_task)});
+	return *instances.back().graph;
+}
+
+batch_report batch_runner::run(size_t cycles)
+{
+	batch_report report;
+	report.instances.resize(instances.size());
+	const auto start = wall_clock::steady::now();
+
+	std::atomic<size_t> next{0};
+	const auto drive = [&]()
+	{
+		for (size_t i = next++; i < instances.size(); i = next++)
+		{
+			auto& result = report.instances[i];
+			const auto instance_start = wall_clock::steady::now();
+			const auto time_before = instances[i].graph->clock().steady_now();
+			try
+			{
+				instances[i].graph->run_cycles(cycles);
+			}
+			catch (...)
+			{
+				result.error = std::current_exception();
+			}
+			result.time = instances[i].graph->clock().steady_now();
+			result.cycles = (result.time - time_before) / thread::cycle_control::min_tick_length;
+			result.wall_time = wall_clock::steady::now() - instance_start;
+		}
+	};
+	std::vector<std::thread> threads;
+	const auto nr_of_threads = std::min(drivers, instances.size());
+	for (size_t i = 1; i < nr_of_threads; ++i)
+		threads.emplace_back(drive);
+	drive();
+	for (auto& t : threads)
+		t.join();
+
+	report.wall_time = wall_clock::steady::now() - start;
+	for (size_t i = 0; i != instances.size(); ++i)
+	{
+		auto& result = report.instances[i];
+		result.name = instances[i].name;
+		result.timing = instances[i].graph->timing();
+		for (const auto& task : result.timing.tasks)
+		{
+			report.execution += task.execution;
+			report.queueing += task.queueing;
+		}
+		report.total_cycles += result.cycles;
+		if (result.error)
+			++report.failed_instances;
+	}
+	return report;
+}
+
+} /* namespace fc */
@@ -0,0 +1,108 @@
+#ifndef SRC_BATCH_RUNNER_HPP_
+#define SRC_BATCH_RUNNER_HPP_
+
+#include <flexcore/infrastructure.hpp>
+#include <flexcore/scheduler/timing.hpp>
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fc
+{
+namespace thread
+{
+class work_stealing_scheduler;
+}
+
+/// telemetry of a single simulation of a batch_runner.
+struct instance_report
+{
+	std::string name;
+	/// cycles executed by the last run.
+	size_t cycles = 0;
+	/// time of the clock of the simulation after the last run.
+	virtual_clock::steady::time_point time{};
+	/// time the last run of the simulation took.
+	wall_clock::steady::duration wall_time = wall_clock::steady::duration::zero();
+	/// exception which ended the last run early, nullptr if all cycles were run.
+	std::exception_ptr error;
+	/// timing of the regions of the simulation since its creation.
+	thread::timing_report timing;
+};
+
+/// telemetry of all simulations of a batch_runner, see batch_runner::run.
+struct batch_report
+{
+	/// reports of the simulations, in the order they were added.
+	std::vector<instance_report> instances;
+	/// execution time of the tasks of all simulations together.
+	thread::histogram_snapshot execution;
+	/// queueing delay of the tasks of all simulations together.
+	thread::histogram_snapshot queueing;
+	size_t total_cycles = 0;
+	size_t failed_instances = 0;
+	/// time the whole run took.
+	wall_clock::steady::duration wall_time = wall_clock::steady::duration::zero();
+};
+
+/**
+ * \brief runs many independent simulations in one process on a shared pool of workers.
+ *
+ * Every instance is an infrastructure with a clock of its own and an afap_main_loop,
+ * thus instances run as fast as possible, each at its own speed.
+ * Their work ticks go to a single work_stealing_scheduler, idle workers steal the tasks
+ * of other instances. Useful for parameter sweeps and Monte Carlo runs of a graph with
+ * different settings, which would otherwise run in a process each.
+ *
+ * Tasks queueing behind those of other instances are no overrun in a simulation,
+ * so instances wait for their tasks without timeout.
+ *
+ * Not thread safe, instances are added and run from a single thread.
+ */
+class batch_runner
+{
+public:
+	/**
+	 * \param workers worker threads of the pool shared by all instances.
+	 * \param nr_of_drivers number of instances running cycles at the same time,
+	 * 0 for as many as the pool has workers.
+	 * \throws std::system_error if the settings in workers cannot be applied.
+	 */
+	explicit batch_runner(thread::thread_config workers = thread::thread_config{},
+			size_t nr_of_drivers = 0);
+	batch_runner(const batch_runner&) = delete;
+	~batch_runner();
+
+	/// adds a new simulation, build its graph with the returned infrastructure.
+	infrastructure& add_instance(std::string name);
+	/// returns the number of simulations.
+	size_t size() const noexcept { return instances.size(); }
+	infrastructure& operator[](size_t i) { return *instances.at(i).graph; }
+
+	/**
+	 * \brief runs cycles in all simulations and returns once all of them are done.
+	 *
+	 * Simulations continue where the previous run stopped.
+	 * An exception in one simulation ends only its run, it is reported in its instance_report.
+	 */
+	batch_report run(size_t cycles);
+
+private:
+	struct instance
+	{
+		std::string name;
+		std::unique_ptr<infrastructure> graph;
+	};
+
+	std::shared_ptr<thread::work_stealing_scheduler> pool;
+	size_t drivers;
+	/// declared after the pool, so instances are destroyed first.
+	std::vector<instance> instances;
+};
+
+} /* namespace fc */
+
+#endif /* SRC_BATCH_RUNNER_HPP_ */
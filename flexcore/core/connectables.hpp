@@ -3,11 +3,141 @@
 
 #include <cmath>
 #include <cassert>
+#include <type_traits>
 #include <utility>
 
+#include <flexcore/core/connection.hpp>
+
 namespace fc
 {
 
+namespace detail
+{
+	template<class T>
+	struct add_op
+	{
+		template<class V>
+		constexpr auto operator()(V in) const { return in + summand; }
+		T summand;
+	};
+
+	template<class T>
+	struct subtract_op
+	{
+		template<class V>
+		constexpr auto operator()(V in) const { return in - subtrahend; }
+		T subtrahend;
+	};
+
+	template<class T>
+	struct multiply_op
+	{
+		template<class V>
+		constexpr auto operator()(V in) const { return factor * in; }
+		T factor;
+	};
+
+	template<class T>
+	struct divide_op
+	{
+		template<class V>
+		constexpr auto operator()(V in) const { return in / divisor; }
+		T divisor;
+	};
+
+	template<class U, class V>
+	struct clamp_op
+	{
+		template<class T>
+		constexpr auto operator()(T in) const
+		{
+			return in < min ? min: (max < in ? max : in);
+		}
+		U min;
+		V max;
+	};
+
+	template<class T>
+	struct constant_op
+	{
+		constexpr T operator()() const { return x; }
+		T x;
+	};
+
+	/**
+	 * \brief Tells if lhs_t >> rhs_t can be replaced by a single connectable.
+	 *
+	 * Specializations provide fold(lhs, rhs) returning the replacement.
+	 */
+	template<class lhs_t, class rhs_t>
+	struct fold_constants : std::false_type {};
+
+	/// (in + a) + b == in + (a + b)
+	template<class T>
+	struct fold_constants<add_op<T>, add_op<T>> : std::is_floating_point<T>
+	{
+		static constexpr auto fold(const add_op<T>& lhs, const add_op<T>& rhs)
+		{
+			return add_op<T>{lhs.summand + rhs.summand};
+		}
+	};
+
+	/// (in - a) - b == in - (a + b)
+	template<class T>
+	struct fold_constants<subtract_op<T>, subtract_op<T>> : std::is_floating_point<T>
+	{
+		static constexpr auto fold(const subtract_op<T>& lhs, const subtract_op<T>& rhs)
+		{
+			return subtract_op<T>{lhs.subtrahend + rhs.subtrahend};
+		}
+	};
+
+	/// b * (a * in) == (b * a) * in
+	template<class T>
+	struct fold_constants<multiply_op<T>, multiply_op<T>> : std::is_floating_point<T>
+	{
+		static constexpr auto fold(const multiply_op<T>& lhs, const multiply_op<T>& rhs)
+		{
+			return multiply_op<T>{rhs.factor * lhs.factor};
+		}
+	};
+
+	/// Tells if the end of chain_t can be folded with rhs_t, see fold_constants.
+	template<class chain_t, class rhs_t>
+	struct ends_in_foldable : std::false_type {};
+
+	template<class head_t, class tail_t, class rhs_t>
+	struct ends_in_foldable<connection<head_t, tail_t>, rhs_t>
+		: std::integral_constant<bool, fold_constants<tail_t, rhs_t>{}> {};
+
+	/// Folds the constants of two connectables, see fold_constants.
+	template<class source_t, class sink_t>
+	struct connect_impl<source_t, sink_t, std::enable_if_t<
+			fold_constants<std::decay_t<source_t>, std::decay_t<sink_t>>{}>>
+	{
+		constexpr auto operator()(source_t&& source, sink_t&& sink) const
+		{
+			return fold_constants<std::decay_t<source_t>, std::decay_t<sink_t>>
+					::fold(source, sink);
+		}
+	};
+
+	/// Folds the constants of the end of a chain with a following connectable.
+	template<class source_t, class sink_t>
+	struct connect_impl<source_t, sink_t, std::enable_if_t<
+			ends_in_foldable<std::decay_t<source_t>, std::decay_t<sink_t>>{}>>
+	{
+		constexpr auto operator()(source_t&& source, sink_t&& sink) const
+		{
+			using head_t = decltype(source.source);
+			using fold_t = fold_constants<decltype(source.sink), std::decay_t<sink_t>>;
+			using tail_t = decltype(fold_t::fold(source.sink, sink));
+			return connection<head_t, tail_t>{
+					std::forward<source_t>(source).source, fold_t::fold(source.sink, sink)};
+		}
+	};
+} // namespace detail
+
 /**
  * \defgroup connectables connectables
  * \brief A collection of different useful connectables.
@@ -18,6 +148,19 @@ namespace fc
 /**
  * \addtogroup connectables
  * @{
+ *
+ * The connectables with constant parameters, like multiply, add and clamp,
+ * are literal types, thus chains of them can be built and evaluated as constexpr.
+ * \code{cpp}
+ * constexpr auto celsius_to_fahrenheit = multiply(1.8) >> add(32.0);
+ * static_assert(celsius_to_fahrenheit(100.0) == 212.0, "");
+ * \endcode
+ * Connecting two multiply or two add (or subtract) with the same floating point type
+ * folds their constants into a single multiply or add,
+ * this also happens at the end of a longer chain.
+ * The result can differ from the unfolded chain by rounding,
+ * like with reassociation by the compiler.
+ * Integral constants are not folded, as the folded constant could overflow.
  */
 
 /// Increments input using prefix operator ++.
@@ -40,30 +183,30 @@ struct identity
 };
 /// Adds a constant addend to inputs.
 template<class T>
-auto add(const T summand)
+constexpr auto add(const T summand)
 {
-	return [summand](auto in){ return in + summand; };
+	return detail::add_op<T>{summand};
 }
 
 /// Subtracts a constant subtrahend from inputs.
 template<class T>
-auto subtract (const T subtrahend)
+constexpr auto subtract (const T subtrahend)
 {
-	return [subtrahend](auto in){ return in - subtrahend; };
+	return detail::subtract_op<T>{subtrahend};
 }
 
 /// Multiples input by a constant factor. (aka gain)
 template<class T>
-auto multiply(const T factor)
+constexpr auto multiply(const T factor)
 {
-	return [factor](auto in) { return factor * in; };
+	return detail::multiply_op<T>{factor};
 }
 
 /// Divides inputs by a constant divisor.
 template<class T>
-auto divide(const T divisor)
+constexpr auto divide(const T divisor)
 {
-	return [divisor](auto in) { return in / divisor; };
+	return detail::divide_op<T>{divisor};
 }
 
 /// Returns absolute value on input using std::abs.
@@ -94,13 +237,10 @@ struct logical_not
  * \post output >= min && output <= max
  */
 template<class U, class V>
-auto clamp(U min, V max)
+constexpr auto clamp(U min, V max)
 {
 	assert(min <= max);
-	return [min, max](auto in)
-	{
-		return in < min ? min: (max < in ? max : in);
-	};
+	return detail::clamp_op<U, V>{min, max};
 }
 
 /**
@@ -109,9 +249,9 @@ auto clamp(U min, V max)
  * \pre constant value needs to fulfill copy_constructible.
  */
 template<class T>
-auto constant(T x)
+constexpr auto constant(T x)
 {
-	return [x](){ return x; };
+	return detail::constant_op<T>{x};
 }
 
 namespace detail
@@ -0,0 +1,95 @@
+#ifndef SRC_CORE_COW_HPP_
+#define SRC_CORE_COW_HPP_
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace fc
+{
+
+/**
+ * \brief value with copy on write, for large states passed through ports.
+ *
+ * Copies share the same object, thus copying a cow through state_sink::get,
+ * state_buffer or hold_last only increments a reference count.
+ * write() clones the object if it is shared and returns it for modification,
+ * other copies keep seeing the old value.
+ *
+ * Copies may be read from several threads, like those in buffers between regions,
+ * a single cow object must not be written and copied concurrently.
+ * A cow converts to const T&, so sinks of T can be connected to sources of cow<T>.
+ *
+ * \tparam T type of the value, needs to be copy constructible to clone it.
+ */
+template<class T>
+class cow
+{
+	static_assert(!std::is_reference<T>{} && !std::is_const<T>{},
+			"cow manages the constness of its value itself.");
+public:
+	using value_type = T;
+
+	/// constructs a default constructed value.
+	cow() : value(std::make_shared<T>()) {}
+	cow(const T& v) : value(std::make_shared<T>(v)) {} // NOLINT implicit like the value
+	cow(T&& v) : value(std::make_shared<T>(std::move(v))) {} // NOLINT
+
+	const T& get() const noexcept { return *value; }
+	const T& operator*() const noexcept { return *value; }
+	const T* operator->() const noexcept { return value.get(); }
+	operator const T&() const noexcept { return *value; } // NOLINT implicit to pass it to sinks
+
+	/// returns the value for modification, which is cloned first if other copies share it.
+	T& write()
+	{
+		if (!unique())
+			value = std::make_shared<T>(*value);
+		return *value;
+	}
+
+	/// returns true if no other cow shares the value.
+	bool unique() const noexcept
+	{
+		if (value.use_count() != 1)
+			return false;
+		// copies released by other threads have finished reading before we write.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return true;
+	}
+
+	/// returns the number of cow objects sharing the value, for diagnostics.
+	long use_count() const noexcept { return value.use_count(); }
+
+	/// returns true if both share the same object, which is cheaper than comparing values.
+	bool shares(const cow& other) const noexcept { return value == other.value; }
+
+private:
+	/// never null, cloned by write if shared.
+	std::shared_ptr<T> value;
+};
+
+/// constructs a cow with the value constructed in place from args.
+template<class T, class... args_t>
+cow<T> make_cow(args_t&&... args)
+{
+	return cow<T>(T(std::forward<args_t>(args)...));
+}
+
+template<class T>
+bool operator==(const cow<T>& lhs, const cow<T>& rhs)
+{
+	return lhs.shares(rhs) || lhs.get() == rhs.get();
+}
+
+template<class T>
+bool operator!=(const cow<T>& lhs, const cow<T>& rhs)
+{
+	return !(lhs == rhs);
+}
+
+} // namespace fc
+
+#endif /* SRC_CORE_COW_HPP_ */
@@ -0,0 +1,232 @@
+#ifndef SRC_CORE_POOLED_HPP_
+#define SRC_CORE_POOLED_HPP_
+
+#include <flexcore/scheduler/mpsc_queue.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+namespace fc
+{
+
+template<class T>
+class payload_pool;
+
+namespace detail
+{
+template<class T>
+struct pool_state;
+
+/// storage of a single payload, owned by its pool unless it is an overflow.
+template<class T>
+struct pool_slot
+{
+	T value{};
+	std::atomic<size_t> references{0};
+	/// nullptr for slots allocated while the pool was exhausted, which are deleted on release.
+	pool_state<T>* pool = nullptr;
+};
+
+/**
+ * \brief free slots of a pool, shared by the pool and its slots in use.
+ *
+ * Counts the payload_pool and every slot in use. Whoever drops the last count
+ * deletes the free slots and the state, which lets handles outlive their pool.
+ */
+template<class T>
+struct pool_state
+{
+	explicit pool_state(size_t capacity) : free_slots(capacity) {}
+
+	void release_reference() noexcept
+	{
+		if (references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+		pool_slot<T>* slot = nullptr;
+		while (free_slots.pop(slot))
+			delete slot;
+		delete this;
+	}
+
+	/// one count for the pool and one for every slot in use.
+	std::atomic<size_t> references{1};
+	/// slots not in use, returned by whichever thread drops their last handle.
+	thread::mpsc_queue<pool_slot<T>*> free_slots;
+	/// slots owned by the pool, in use or free, only changed by acquire.
+	size_t created = 0;
+};
+} // namespace detail
+
+/**
+ * \brief handle to a payload taken from a payload_pool, for events passed between regions.
+ *
+ * Copies share the same payload, copying a pooled through an event_buffer only increments
+ * a reference count. Once the last handle is dropped, on whichever thread that happens,
+ * the payload returns to the pool of the producer instead of being freed.
+ * Like cow, a pooled converts to const T&, so sinks of T can be connected to sources of
+ * pooled<T>, and is only written by the producer while it holds the only handle.
+ *
+ * A default constructed pooled holds no payload.
+ */
+template<class T>
+class pooled
+{
+public:
+	using value_type = T;
+
+	pooled() noexcept = default;
+	pooled(const pooled& other) noexcept : slot(other.slot)
+	{
+		if (slot)
+			slot->references.fetch_add(1, std::memory_order_relaxed);
+	}
+	pooled(pooled&& other) noexcept : slot(other.slot) { other.slot = nullptr; }
+	pooled& operator=(pooled other) noexcept
+	{
+		std::swap(slot, other.slot);
+		return *this;
+	}
+	~pooled() { reset(); }
+
+	const T& get() const noexcept
+	{
+		assert(slot);
+		return slot->value;
+	}
+	const T& operator*() const noexcept { return get(); }
+	const T* operator->() const noexcept { return &get(); }
+	operator const T&() const noexcept { return get(); } // NOLINT implicit to pass it to sinks
+
+	/**
+	 * \brief returns the payload for modification.
+	 * \pre unique(), payloads are filled by the producer before they are sent.
+	 */
+	T& write() noexcept
+	{
+		assert(unique());
+		return slot->value;
+	}
+
+	/// returns true if this is the only handle to the payload.
+	bool unique() const noexcept
+	{
+		if (!slot || slot->references.load(std::memory_order_relaxed) != 1)
+			return false;
+		// handles released by other threads have finished reading before we write.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return true;
+	}
+
+	explicit operator bool() const noexcept { return slot != nullptr; }
+
+	/// drops the handle, the payload returns to its pool if this was the last one.
+	void reset() noexcept
+	{
+		if (!slot)
+			return;
+		auto released = slot;
+		slot = nullptr;
+		if (released->references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+		auto pool = released->pool;
+		if (!pool)
+		{
+			delete released;
+			return;
+		}
+		// the queue holds all slots of the pool, thus pushing cannot fail.
+		const bool returned = pool->free_slots.push(released);
+		assert(returned);
+		(void)returned;
+		pool->release_reference();
+	}
+
+private:
+	explicit pooled(detail::pool_slot<T>* new_slot) noexcept : slot(new_slot)
+	{
+		slot->references.store(1, std::memory_order_relaxed);
+	}
+
+	detail::pool_slot<T>* slot = nullptr;
+
+	friend class payload_pool<T>;
+};
+
+/**
+ * \brief pool of payloads of type T, owned by the producer of events between regions.
+ *
+ * acquire takes a payload which has been returned by the consumers,
+ * so a steady stream of events from one region to another neither allocates nor frees
+ * once the pool holds as many payloads as are in flight, and payloads stay warm in cache.
+ * Payloads keep the value they had when they were returned, like the capacity
+ * of a vector, producers overwrite or clear them.
+ *
+ * acquire must only be called by one thread at a time, usually from the work of
+ * the producing region. Handles can be dropped by any thread and may outlive the pool.
+ * If all capacity payloads are in use, acquire allocates a payload outside of the pool,
+ * which is freed when it is dropped.
+ *
+ * \tparam T type of payload, needs to be default constructible.
+ */
+template<class T>
+class payload_pool
+{
+public:
+	/**
+	 * \param capacity maximum number of payloads kept by the pool.
+	 * \pre capacity > 0, throws std::invalid_argument otherwise.
+	 */
+	explicit payload_pool(size_t capacity)
+		: state(make_state(capacity))
+	{
+	}
+	payload_pool(const payload_pool&) = delete;
+	payload_pool& operator=(const payload_pool&) = delete;
+	~payload_pool() { state->release_reference(); }
+
+	/// returns a handle to a payload, which is the only handle to it.
+	pooled<T> acquire()
+	{
+		detail::pool_slot<T>* slot = nullptr;
+		if (state->free_slots.pop(slot))
+		{
+			state->references.fetch_add(1, std::memory_order_relaxed);
+			return pooled<T>{slot};
+		}
+		if (state->created == state->free_slots.capacity())
+		{
+			++overflows_;
+			return pooled<T>{new detail::pool_slot<T>{}};
+		}
+		slot = new detail::pool_slot<T>{};
+		slot->pool = state;
+		++state->created;
+		state->references.fetch_add(1, std::memory_order_relaxed);
+		return pooled<T>{slot};
+	}
+
+	/// returns the maximum number of payloads kept, capacity rounded up to a power of two.
+	size_t capacity() const noexcept { return state->free_slots.capacity(); }
+	/// returns the number of payloads allocated by the pool so far.
+	size_t size() const noexcept { return state->created; }
+	/// returns how often acquire allocated outside of the pool, as all payloads were in use.
+	size_t overflows() const noexcept { return overflows_; }
+
+private:
+	static detail::pool_state<T>* make_state(size_t capacity)
+	{
+		if (capacity == 0)
+			throw std::invalid_argument("capacity of payload_pool needs to be positive");
+		return new detail::pool_state<T>(capacity);
+	}
+
+	detail::pool_state<T>* state;
+	size_t overflows_ = 0;
+};
+
+} // namespace fc
+
+#endif /* SRC_CORE_POOLED_HPP_ */
@@ -0,0 +1,181 @@
+#ifndef SRC_CORE_SPAN_HPP_
+#define SRC_CORE_SPAN_HPP_
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace fc
+{
+
+/**
+ * \brief non owning view of a contiguous sequence of elements.
+ *
+ * Minimal replacement of std::span, used to pass batches of events without copying them.
+ * A span<const T> can be constructed from a span<T>.
+ *
+ * \tparam T type of elements, const for read only views.
+ */
+template<class T>
+class span
+{
+public:
+	using element_type = T;
+	using value_type = std::remove_cv_t<T>;
+	using iterator = T*;
+
+	constexpr span() noexcept = default;
+	/// \pre data != nullptr || size == 0
+	constexpr span(T* data, size_t size) noexcept : data_(data), size_(size)
+	{
+		assert(data_ != nullptr || size_ == 0);
+	}
+
+	/// views all elements of vector, which needs to outlive the span.
+	template<class U, class = std::enable_if_t<std::is_convertible<U(*)[], T(*)[]>{}>>
+	span(std::vector<U>& vector) noexcept // NOLINT implicit conversion like std::span
+		: span(vector.data(), vector.size())
+	{
+	}
+	template<class U, class = std::enable_if_t<std::is_convertible<const U(*)[], T(*)[]>{}>>
+	span(const std::vector<U>& vector) noexcept // NOLINT implicit conversion like std::span
+		: span(vector.data(), vector.size())
+	{
+	}
+	template<class U, size_t N,
+			class = std::enable_if_t<std::is_convertible<U(*)[], T(*)[]>{}>>
+	constexpr span(std::array<U, N>& array) noexcept // NOLINT implicit conversion
+		: span(array.data(), N)
+	{
+	}
+	/// adds const to the elements of other.
+	template<class U, class = std::enable_if_t<std::is_convertible<U(*)[], T(*)[]>{}>>
+	constexpr span(const span<U>& other) noexcept // NOLINT implicit conversion
+		: span(other.data(), other.size())
+	{
+	}
+
+	constexpr T* data() const noexcept { return data_; }
+	constexpr size_t size() const noexcept { return size_; }
+	constexpr bool empty() const noexcept { return size_ == 0; }
+
+	constexpr iterator begin() const noexcept { return data_; }
+	constexpr iterator end() const noexcept { return data_ + size_; }
+
+	/// \pre index < size()
+	T& operator[](size_t index) const
+	{
+		assert(index < size_);
+		return data_[index];
+	}
+
+private:
+	T* data_ = nullptr;
+	size_t size_ = 0;
+};
+
+/**
+ * \brief non owning view of a sequence of elements stored in two contiguous segments.
+ *
+ * This is the layout of a ring buffer, where the elements wrap around at the end of memory.
+ * Iterating visits all elements of first, then all elements of second.
+ */
+template<class T>
+class segmented_span
+{
+public:
+	using element_type = T;
+	using value_type = std::remove_cv_t<T>;
+
+	/// forward iterator over both segments.
+	class iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = std::remove_cv_t<T>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = T*;
+		using reference = T&;
+
+		iterator() = default;
+		iterator(T* current, T* segment_end, T* next_segment, T* next_end) noexcept
+			: current(current), segment_end(segment_end)
+			, next_segment(next_segment), next_end(next_end)
+		{
+			skip_empty_segment();
+		}
+
+		T& operator*() const { return *current; }
+		T* operator->() const { return current; }
+		iterator& operator++()
+		{
+			++current;
+			skip_empty_segment();
+			return *this;
+		}
+		iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+		// the segment is compared as well, since the end of the second segment
+		// can be the begin of the first one in a full ring buffer.
+		bool operator==(const iterator& o) const
+		{
+			return current == o.current && segment_end == o.segment_end;
+		}
+		bool operator!=(const iterator& o) const { return !(*this == o); }
+
+	private:
+		void skip_empty_segment()
+		{
+			if (current == segment_end && next_segment != next_end)
+			{
+				current = next_segment;
+				segment_end = next_end;
+				next_segment = nullptr;
+				next_end = nullptr;
+			}
+		}
+
+		T* current = nullptr;
+		T* segment_end = nullptr;
+		T* next_segment = nullptr;
+		T* next_end = nullptr;
+	};
+
+	constexpr segmented_span() noexcept = default;
+	constexpr segmented_span(span<T> first, span<T> second) noexcept
+		: first_(first), second_(second)
+	{
+	}
+
+	constexpr span<T> first() const noexcept { return first_; }
+	constexpr span<T> second() const noexcept { return second_; }
+	constexpr size_t size() const noexcept { return first_.size() + second_.size(); }
+	constexpr bool empty() const noexcept { return size() == 0; }
+
+	iterator begin() const noexcept
+	{
+		return {first_.begin(), first_.end(), second_.begin(), second_.end()};
+	}
+	iterator end() const noexcept
+	{
+		return second_.empty() ? iterator{first_.end(), first_.end(), nullptr, nullptr}
+				: iterator{second_.end(), second_.end(), nullptr, nullptr};
+	}
+
+	/// \pre index < size()
+	T& operator[](size_t index) const
+	{
+		assert(index < size());
+		return index < first_.size() ? first_[index] : second_[index - first_.size()];
+	}
+
+private:
+	span<T> first_;
+	span<T> second_;
+};
+
+} // namespace fc
+
+#endif /* SRC_CORE_SPAN_HPP_ */
@@ -265,11 +265,16 @@ constexpr bool void_callable(...)
 	return false;
 }
 
+namespace detail
+{
+class connection_breaker;
+}
+
 ///Checks if type T has a member function register_callback
 template <class T>
 constexpr auto has_register_function(int)
     -> decltype(std::declval<T>().register_callback(
-                    std::declval<std::shared_ptr<std::function<void(size_t)>>&>()),
+                    std::declval<detail::connection_breaker&>()),
                 bool())
 {
 	return true;
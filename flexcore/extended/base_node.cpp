@@ -1,8 +1,14 @@
 #include <boost/algorithm/string/join.hpp>
 #include <boost/format.hpp>
 #include <flexcore/extended/base_node.hpp>
+#include <flexcore/extended/graph/graph_image.hpp>
 #include <flexcore/extended/visualization/visualization.hpp>
 
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <stack>
 
 namespace fc
@@ -37,6 +43,150 @@ std::string full_name(forest_t& forest, const tree_node& node)
 	return full_name;
 }
 
+std::string full_name(const forest_graph& fg, const tree_node& node)
+{
+	std::lock_guard<std::mutex> lock(fg.mutex);
+	return fg.index.full_name(fg.index.find(node.graph_info().get_id()));
+}
+
+void build_in_parallel(owning_base_node& parent,
+		const std::vector<std::function<void(owning_base_node&)>>& builders,
+		size_t nr_of_threads)
+{
+	nr_of_threads = std::max<size_t>(1, std::min(nr_of_threads, builders.size()));
+	auto& graph = parent.get_graph();
+	std::mutex error_mutex;
+	std::exception_ptr first_error;
+	auto run = [&](size_t first)
+	{
+		graph::connection_graph::staging_scope staging(graph);
+		for (size_t i = first; i < builders.size(); i += nr_of_threads)
+		{
+			try
+			{
+				builders[i](parent);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(error_mutex);
+				if (!first_error)
+					first_error = std::current_exception();
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t t = 1; t < nr_of_threads; ++t)
+		threads.emplace_back(run, t);
+	run(0); // the calling thread takes part in building.
+	for (auto& thread : threads)
+		thread.join();
+	if (first_error)
+		std::rethrow_exception(first_error);
+}
+
+forest_t::iterator erase_with_subtree(forest_graph& fg, forest_t::iterator position)
+{
+	std::lock_guard<std::mutex> lock(fg.mutex);
+	// every node of the subtree is visited on its leading and on its trailing edge.
+	for (auto it = adobe::leading_of(position), last = ++adobe::trailing_of(position);
+			it != last; ++it)
+	{
+		fg.index.erase((*it)->graph_info().get_id());
+	}
+	return erase_with_subtree(fg.forest, position);
+}
+
+forest_index::index_t forest_index::insert(
+		const graph::unique_id& id, forest_t::iterator position, index_t parent)
+{
+	assert(parent == no_parent || parent < entries.size());
+	index_t i = entries.size();
+	if (free_entries.empty())
+	{
+		entries.push_back(entry{position, parent, std::string{}});
+	}
+	else
+	{
+		i = free_entries.back();
+		free_entries.pop_back();
+		entries[i] = entry{position, parent, std::string{}};
+	}
+	ids[id] = i;
+	return i;
+}
+
+void forest_index::reserve(size_t nr_of_nodes)
+{
+	entries.reserve(nr_of_nodes);
+	ids.reserve(nr_of_nodes);
+}
+
+void forest_index::erase(const graph::unique_id& id)
+{
+	const auto found = ids.find(id);
+	if (found == ids.end())
+		return;
+	entries[found->second].full_name.clear();
+	free_entries.push_back(found->second);
+	ids.erase(found);
+}
+
+const std::string& forest_index::full_name(index_t i) const
+{
+	assert(i < entries.size());
+	auto& e = entries[i];
+	if (e.full_name.empty())
+	{
+		const auto& name = (*e.position)->name();
+		if (e.parent == no_parent)
+			e.full_name = name;
+		else
+			e.full_name = full_name(e.parent) + name_seperator + name;
+	}
+	return e.full_name;
+}
+
+void* node_arena::allocate(size_t size, size_t alignment)
+{
+	assert(enabled());
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!std::align(alignment, size, current, remaining))
+	{
+		// nodes larger than a block get a block of their own.
+		const size_t new_block_size = std::max(block_size, size + alignment);
+		if (numa_node_ == thread::any_numa_node)
+		{
+			blocks.push_back(std::make_unique<char[]>(new_block_size));
+			current = blocks.back().get();
+		}
+		else
+		{
+			numa_blocks.push_back(thread::allocate_on_numa_node(new_block_size, numa_node_));
+			current = numa_blocks.back().get();
+		}
+		remaining = new_block_size;
+		const auto aligned = std::align(alignment, size, current, remaining);
+		assert(aligned);
+		(void)aligned;
+	}
+	void* result = current;
+	current = static_cast<char*>(current) + size;
+	remaining -= size;
+	return result;
+}
+
+node_arena& forest_graph::arena_of(const parallel_region& region)
+{
+	if (!arena.enabled() || region.numa_node() == thread::any_numa_node)
+		return arena;
+	std::lock_guard<std::mutex> lock(numa_arenas_mutex);
+	auto& result = numa_arenas[region.numa_node()];
+	if (!result)
+		result = std::make_unique<node_arena>(arena.bytes_per_block(), region.numa_node());
+	return *result;
+}
+
 tree_base_node::tree_base_node(const node_args& args)
 	: fg_(args.fg), region_(args.r), graph_info_(args.graph_info)
 {
@@ -48,6 +198,11 @@ std::string tree_base_node::name() const
 	return graph_info_.name();
 }
 
+std::string tree_base_node::full_name() const
+{
+	return fc::full_name(fg_, *this);
+}
+
 graph::graph_node_properties tree_base_node::graph_info() const
 {
 	return graph_info_;
@@ -63,16 +218,28 @@ forest_t::iterator owning_base_node::self() const
 	return self_;
 }
 
-forest_t::iterator owning_base_node::add_child(std::unique_ptr<tree_node> child)
+forest_t::iterator owning_base_node::add_child(node_ptr child)
 {
 	assert(child);
+	std::lock_guard<std::mutex> lock(fg_.mutex);
 	auto& forest = fg_.forest;
 	auto child_it = adobe::trailing_of(forest.insert(self(), std::move(child)));
 	assert(adobe::find_parent(child_it) == self());
 	assert(adobe::find_parent(child_it) != forest.end());
+	fg_.index.insert((*child_it)->graph_info().get_id(), child_it,
+			fg_.index.find(graph_info().get_id()));
 	return child_it;
 }
 
+void owning_base_node::replace_proxy(forest_t::iterator position, node_ptr node)
+{
+	{
+		std::lock_guard<std::mutex> lock(fg_.mutex);
+		swap(*position, node);
+	}
+	// node now holds the proxy, which is destroyed without holding the lock.
+}
+
 node_args owning_base_node::new_node(node_args args)
 {
 	const auto proxy_iter = add_child(std::make_unique<tree_base_node>(args));
@@ -81,8 +248,9 @@ node_args owning_base_node::new_node(node_args args)
 }
 
 forest_owner::forest_owner(
-		graph::connection_graph& graph, std::string n, std::shared_ptr<parallel_region> r)
-	: fg_(std::make_unique<forest_graph>(graph))
+		graph::connection_graph& graph, std::string n, std::shared_ptr<parallel_region> r,
+		size_t node_arena_block_size)
+	: fg_(std::make_unique<forest_graph>(graph, node_arena_block_size))
 	, tree_root(nullptr)
 	, viz_(std::make_unique<visualization>(fg_->graph, fg_->forest))
 {
@@ -94,6 +262,7 @@ forest_owner::forest_owner(
 	const auto iter = adobe::trailing_of(
 			forest.insert(forest.begin(), std::make_unique<tree_base_node>(args)));
 	args.self = iter;
+	fg_->index.insert(args.graph_info.get_id(), iter, forest_index::no_parent);
 
 	// replace proxy with actual node
 	*iter = std::make_unique<owning_base_node>(args);
@@ -108,9 +277,94 @@ forest_owner::~forest_owner()
 {
 }
 
-void forest_owner::visualize(std::ostream& out) const
+void forest_owner::visualize(std::ostream& out, bool annotate_rates) const
 {
 	assert(viz_);
-	viz_->visualize(out);
+	viz_->visualize(out, annotate_rates);
 }
+graph::graph_image forest_owner::image() const
+{
+	graph::graph_image result;
+	std::lock_guard<std::mutex> lock(fg_->mutex);
+	std::map<graph::unique_id, uint32_t> node_indices;
+	std::map<const parallel_region*, uint32_t> region_indices;
+
+	// nodes in preorder, each after its parent.
+	std::stack<std::pair<forest_t::const_iterator, uint32_t>> pending;
+	pending.emplace(fg_->forest.begin(), graph::graph_image::none);
+	while (!pending.empty())
+	{
+		const auto position = pending.top().first;
+		const auto parent = pending.top().second;
+		pending.pop();
+		const auto info = (*position)->graph_info();
+		auto region = graph::graph_image::none;
+		if (const auto r = info.region())
+		{
+			const auto inserted = region_indices.emplace(r,
+					static_cast<uint32_t>(result.regions.size()));
+			if (inserted.second)
+				result.regions.push_back({r->get_id().key, r->get_duration()});
+			region = inserted.first->second;
+		}
+		const auto index = static_cast<uint32_t>(result.nodes.size());
+		node_indices[info.get_id()] = index;
+		result.nodes.push_back({info.name(), parent, region});
+
+		// children are pushed in reverse to be visited in order.
+		std::vector<forest_t::const_iterator> children;
+		for (auto child = adobe::child_begin(position); child != adobe::child_end(position); ++child)
+			children.push_back(child.base());
+		for (auto child = children.rbegin(); child != children.rend(); ++child)
+			pending.emplace(*child, index);
+	}
+
+	const auto changes = fg_->graph.changes_since(graph::graph_version{});
+	std::vector<const graph::graph_properties*> ports;
+	ports.reserve(changes.new_ports.size());
+	for (const auto& port : changes.new_ports)
+		ports.push_back(&port);
+	const auto node_of = [&](const graph::graph_properties& port)
+	{
+		const auto node = node_indices.find(port.node_properties.get_id());
+		return node == node_indices.end() ? graph::graph_image::none : node->second;
+	};
+	std::stable_sort(ports.begin(), ports.end(), [&](const auto* lhs, const auto* rhs)
+	{
+		return node_of(*lhs) < node_of(*rhs);
+	});
+	std::map<graph::unique_id, uint32_t> port_indices;
+	for (const auto* port : ports)
+	{
+		port_indices.emplace(port->port_properties.id(), static_cast<uint32_t>(result.ports.size()));
+		result.ports.push_back({node_of(*port), port->port_properties.description(),
+				port->port_properties.type()});
+	}
+	// ports only known from their connections are appended after all others.
+	const auto index_of = [&](const graph::graph_properties& port)
+	{
+		const auto inserted = port_indices.emplace(port.port_properties.id(),
+				static_cast<uint32_t>(result.ports.size()));
+		if (inserted.second)
+			result.ports.push_back({node_of(port), port.port_properties.description(),
+					port.port_properties.type()});
+		return inserted.first->second;
+	};
+	for (const auto& edge : changes.new_edges)
+	{
+		const auto source = index_of(edge.source);
+		result.edges.push_back({source, index_of(edge.sink)});
+	}
+	return result;
+}
+
+void forest_owner::reserve(const graph::graph_image& image)
+{
+	{
+		std::lock_guard<std::mutex> lock(fg_->mutex);
+		fg_->index.reserve(image.nodes.size());
+	}
+	fg_->graph.reserve(image.ports.size(), image.edges.size());
+}
+
 }
@@ -3,25 +3,183 @@
 
 #include <flexcore/extended/node_fwd.hpp>
 #include <flexcore/ports.hpp>
+#include <flexcore/scheduler/memory_account.hpp>
+#include <flexcore/scheduler/numa.hpp>
 #include <adobe/forest.hpp>
 
 #include <cassert>
+#include <limits>
+#include <map>
 #include <string>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 
 namespace fc
 {
+namespace graph
+{
+struct graph_image;
+}
 
 /// any class implementing node interface can be stored in forest
 using tree_node = node;
+
+/**
+ * \brief Monotonic memory resource for the nodes of a forest.
+ *
+ * Memory is taken from blocks of block_size bytes, which are allocated on demand.
+ * Nodes created one after another are thus placed next to each other.
+ * Memory of destroyed nodes is not reused,
+ * all blocks are released at once when the arena is destroyed.
+ * A block_size of zero disables the arena, nodes are allocated on the heap then.
+ * allocate is thread safe, to allow building subtrees concurrently, see build_in_parallel.
+ * Blocks of an arena with a numa node prefer memory of that node, see thread::allocate_on_numa_node.
+ */
+class node_arena
+{
+public:
+	explicit node_arena(size_t block_size = 0, int numa_node = thread::any_numa_node)
+		: block_size(block_size), numa_node_(numa_node)
+	{
+	}
+	node_arena(const node_arena&) = delete;
+	node_arena& operator=(const node_arena&) = delete;
+
+	bool enabled() const noexcept { return block_size != 0; }
+	/// returns memory for size bytes aligned to alignment, valid until the arena is destroyed.
+	void* allocate(size_t size, size_t alignment);
+	/// returns the number of blocks allocated so far.
+	size_t nr_of_blocks() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return blocks.size() + numa_blocks.size();
+	}
+	size_t bytes_per_block() const noexcept { return block_size; }
+	int numa_node() const noexcept { return numa_node_; }
+
+private:
+	size_t block_size;
+	int numa_node_;
+	mutable std::mutex mutex;
+	std::vector<std::unique_ptr<char[]>> blocks;
+	/// blocks of an arena with a numa node, which are mapped page by page.
+	std::vector<thread::numa_memory> numa_blocks;
+	void* current = nullptr;
+	size_t remaining = 0;
+};
+
+/// deletes nodes, which are either allocated on the heap or in a node_arena.
+struct node_deleter
+{
+	node_deleter() = default;
+	explicit node_deleter(bool in_arena) noexcept : in_arena(in_arena) {}
+	/// allows conversion from std::unique_ptr with default deleter.
+	template<class T>
+	node_deleter(const std::default_delete<T>&) noexcept {}
+
+	void operator()(tree_node* n) const noexcept
+	{
+		if (in_arena)
+			n->~tree_node();
+		else
+			delete n;
+	}
+
+	bool in_arena = false;
+};
+
+/// owning pointer to node in forest
+using node_ptr = std::unique_ptr<tree_node, node_deleter>;
 /// the ownership tree of all nodes
-using forest_t = adobe::forest<std::unique_ptr<tree_node>>;
+using forest_t = adobe::forest<node_ptr>;
+
+/// creates node_t in arena, or on the heap if arena is disabled.
+template<class node_t, class... args_t>
+node_ptr make_node(node_arena& arena, args_t&&... args)
+{
+	if (!arena.enabled())
+		return node_ptr{new node_t(std::forward<args_t>(args)...)};
+	void* memory = arena.allocate(sizeof(node_t), alignof(node_t));
+	return node_ptr{new (memory) node_t(std::forward<args_t>(args)...), node_deleter{true}};
+}
+
+/**
+ * \brief Flat index of the nodes in a forest by the id of the nodes.
+ *
+ * Every node gets an entry storing its position in the forest
+ * and the index of the entry of its parent.
+ * Thus finding a node is O(1) and walking to the root is O(depth),
+ * while the forest itself would need to be searched linearly.
+ * Indices of erased entries are reused.
+ *
+ * The full name of a node is built on first request and cached in its entry,
+ * using the cached full name of its parent.
+ * Inserting or erasing an entry invalidates the cached name of that entry.
+ */
+class forest_index
+{
+public:
+	using index_t = size_t;
+	static constexpr index_t no_parent = std::numeric_limits<index_t>::max();
+
+	/// adds entry for node id at position with parent, returns the index of the entry.
+	index_t insert(const graph::unique_id& id, forest_t::iterator position, index_t parent);
+	/// removes entry of node id, does nothing if there is none.
+	void erase(const graph::unique_id& id);
+	/// \returns index of the entry of node id, throws std::out_of_range if there is none.
+	index_t find(const graph::unique_id& id) const { return ids.at(id); }
+
+	forest_t::iterator position(index_t i) const { assert(i < entries.size()); return entries[i].position; }
+	index_t parent(index_t i) const { assert(i < entries.size()); return entries[i].parent; }
+	size_t size() const { return ids.size(); }
+	/// allocates memory for nr_of_nodes entries upfront.
+	void reserve(size_t nr_of_nodes);
+	/// returns the full name of the node of entry i, see fc::full_name.
+	const std::string& full_name(index_t i) const;
+
+private:
+	struct entry
+	{
+		forest_t::iterator position;
+		index_t parent;
+		/// full name of the node, empty until requested.
+		mutable std::string full_name;
+	};
+	std::vector<entry> entries;
+	std::vector<index_t> free_entries;
+	std::unordered_map<graph::unique_id, index_t, boost::hash<graph::unique_id>> ids;
+};
 
 struct forest_graph
 {
-	forest_graph(graph::connection_graph& graph) : graph(graph) {}
+	explicit forest_graph(graph::connection_graph& graph, size_t arena_block_size = 0)
+		: arena(arena_block_size), graph(graph)
+	{
+	}
+	/**
+	 * \brief returns the arena nodes of region are created in.
+	 *
+	 * Regions with a numa node get an arena on that node, if arena is enabled.
+	 * MT-safe.
+	 */
+	node_arena& arena_of(const parallel_region& region);
+
+	/// memory of nodes in forest, declared first to outlive them.
+	node_arena arena;
+	/// arenas of regions with a numa node by node, also declared before forest.
+	std::map<int, std::unique_ptr<node_arena>> numa_arenas;
+	std::mutex numa_arenas_mutex;
+	/// guards forest and index, when nodes are created concurrently by owning_base_node.
+	mutable std::mutex mutex;
 	forest_t forest;
+	/// index of all nodes in forest, which are created through owning_base_node.
+	forest_index index;
 	graph::connection_graph& graph;
 };
 
@@ -73,6 +231,8 @@ public:
 
 	std::shared_ptr<parallel_region> region() override { assert(region_); return region_; }
 	std::string name() const override;
+	/// returns the name of the node prefixed by the names of its parents, see fc::full_name.
+	std::string full_name() const override;
 
 	graph::graph_node_properties graph_info() const override;
 	graph::connection_graph& get_graph() final override;
@@ -84,7 +244,10 @@ private:
 	std::shared_ptr<parallel_region> region_;
 	/// Stores the metainformation of the node used by the abstract graph
 	graph::graph_node_properties graph_info_;
+	/// size of the node charged to its region, set by owning_base_node::make_child.
+	thread::memory_charge memory_;
 
+	friend class owning_base_node;
 };
 
 /**
@@ -213,17 +376,24 @@ private:
 		//first create a proxy node to get the node_args with a correct iterator
 		node_args n = new_node(std::move(nargs));
 		//then replace proxy with proper node
-		*n.self = std::make_unique<node_t>(std::forward<Args>(args)..., n);
-		return dynamic_cast<node_t&>(**n.self);
+		auto child = make_node<node_t>(fg_.arena_of(*n.r), std::forward<Args>(args)..., n);
+		auto& result = dynamic_cast<node_t&>(*child);
+		static_cast<tree_base_node&>(result).memory_ =
+				thread::memory_charge{n.r->shared_memory_account(), sizeof(node_t)};
+		replace_proxy(n.self, std::move(child));
+		return result;
 	}
 
+	/// replaces the proxy node at position by node.
+	void replace_proxy(forest_t::iterator position, node_ptr node);
+
 	forest_t::iterator self_;
 	/**
 	 * Takes ownership of child node and inserts into tree.
 	 * \return iterator to child node
 	 * \pre child != nullptr
 	 */
-	forest_t::iterator add_child(std::unique_ptr<tree_node> child);
+	forest_t::iterator add_child(node_ptr child);
 
 	/// Helper: create a new tree_base_node in tree from node_args.
 	node_args new_node(node_args args);
@@ -249,12 +419,31 @@ public:
 	 * \param graph access to the abstract connectopn graph
 	 * \param n Human readable name of the root node
 	 * \param r parallel_region the root node belongs to
+	 * \param node_arena_block_size size of the blocks of the node_arena
+	 * nodes created by make_child are placed in, zero allocates every node on the heap.
 	 * \pre r != nullptr
 	 */
-	forest_owner(graph::connection_graph& graph, std::string n, std::shared_ptr<parallel_region> r);
+	forest_owner(graph::connection_graph& graph, std::string n, std::shared_ptr<parallel_region> r,
+			size_t node_arena_block_size = 0);
 	~forest_owner();
 	owning_base_node& nodes() { assert(tree_root); return *tree_root; }
-	void visualize(std::ostream& out) const;
+	/// prints the graph in graphviz format, see visualization::visualize.
+	void visualize(std::ostream& out, bool annotate_rates = false) const;
+
+	/**
+	 * \brief captures the topology of the forest and of its graph, see graph::graph_image.
+	 *
+	 * Ports of a node keep the order they were added in,
+	 * thus images of applications built the same way compare equal in graph::same_topology.
+	 */
+	graph::graph_image image() const;
+	/**
+	 * \brief preallocates the index of the forest and the graph for the application of image.
+	 *
+	 * Call it before building the nodes, the graph is best recorded deferred meanwhile,
+	 * see connection_graph::recording.
+	 */
+	void reserve(const graph::graph_image& image);
 
 private:
 	std::unique_ptr<forest_graph> fg_;
@@ -283,15 +472,53 @@ erase_with_subtree(
 			++adobe::trailing_of(position));
 }
 
+/**
+ * \brief Runs builders concurrently, each can build an independent subtree of parent.
+ *
+ * The builders are distributed over nr_of_threads threads.
+ * make_child and make_child_named can be called concurrently,
+ * connections and ports added to the graph are collected per thread
+ * and merged into the graph once a thread has run all of its builders,
+ * see connection_graph::staging_scope.
+ * The order of children created by different builders is unspecified.
+ *
+ * Builders must only connect ports of the nodes they create themselves.
+ * Ports shared between builders, for example the ticks of a common region,
+ * are not thread safe and have to be connected before or after.
+ * \throws the first exception thrown by a builder, after all threads have finished.
+ */
+void build_in_parallel(owning_base_node& parent,
+		const std::vector<std::function<void(owning_base_node&)>>& builders,
+		size_t nr_of_threads = std::thread::hardware_concurrency());
+
+/**
+ * \brief Erases node and recursively erases all children from forest and index.
+ *
+ * Prefer this overload to keep the index of forest_graph small,
+ * if nodes are erased during the runtime of the program.
+ * \pre position must be in fg.forest.
+ * \returns trailing iterator pointing to parent of position.
+ */
+forest_t::iterator erase_with_subtree(forest_graph& fg, forest_t::iterator position);
+
 /**
  * \brief Returns the full name of a node.
  *
  * The full name consists of the chained name of the nodes parent, grandparent etc.
  * and the name of the node itself.
  * The names are separated by a separation token.
+ * This overload searches node in forest, which is linear in the size of the forest.
  */
 std::string full_name(forest_t& forest, const tree_node& node);
 
+/**
+ * \brief Returns the full name of a node using the index of the forest.
+ *
+ * Equal to full_name(fg.forest, node), but linear in the depth of node.
+ * \pre node has been created through an owning_base_node of fg.
+ */
+std::string full_name(const forest_graph& fg, const tree_node& node);
+
 } // namespace fc
 
 #endif /* SRC_NODES_BASE_NODE_HPP_ */
@@ -0,0 +1,116 @@
+#include <flexcore/extended/graph/components.hpp>
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace fc
+{
+namespace graph
+{
+
+namespace
+{
+/// union find over node indices, with path halving.
+class disjoint_sets
+{
+public:
+	size_t add()
+	{
+		parent.push_back(parent.size());
+		return parent.size() - 1;
+	}
+
+	size_t find(size_t i)
+	{
+		while (parent[i] != i)
+		{
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	}
+
+	void join(size_t a, size_t b)
+	{
+		a = find(a);
+		b = find(b);
+		// the smaller index stays the root, so components keep the order of their nodes.
+		if (b < a)
+			std::swap(a, b);
+		parent[b] = a;
+	}
+
+private:
+	std::vector<size_t> parent;
+};
+}
+
+region_components independent_components(
+		const connection_graph& graph, const parallel_region& region)
+{
+	const auto content = graph.changes_since(graph_version{});
+
+	// nodes of region and nodes without region, which may connect nodes of region.
+	std::map<unique_id, size_t> index;
+	std::vector<std::pair<unique_id, bool>> nodes;
+	disjoint_sets sets;
+	const auto add_node = [&](const graph_node_properties& node) -> std::pair<size_t, bool>
+	{
+		if (node.region() != nullptr && node.region() != &region)
+			return {0, false};
+		const auto inserted = index.emplace(node.get_id(), nodes.size());
+		if (inserted.second)
+		{
+			nodes.emplace_back(node.get_id(), node.region() == &region);
+			sets.add();
+		}
+		return {inserted.first->second, true};
+	};
+	for (const auto& port : content.new_ports)
+		add_node(port.node_properties);
+	for (const auto& edge : content.new_edges)
+	{
+		const auto source = add_node(edge.source.node_properties);
+		const auto sink = add_node(edge.sink.node_properties);
+		if (source.second && sink.second)
+			sets.join(source.first, sink.first);
+	}
+
+	region_components result;
+	std::map<size_t, size_t> component_of_root;
+	for (size_t i = 0; i != nodes.size(); ++i)
+	{
+		if (!nodes[i].second)
+			continue;
+		const auto inserted =
+				component_of_root.emplace(sets.find(i), result.nr_of_components);
+		if (inserted.second)
+			++result.nr_of_components;
+		result.component_of_node.emplace(nodes[i].first, inserted.first->second);
+	}
+	return result;
+}
+
+size_t run_components_in_parallel(
+		const connection_graph& graph, parallel_region& region, thread::scheduler& pool)
+{
+	const auto components = independent_components(graph, region);
+
+	// region_worker_nodes own their workers by their address as tree_base_node.
+	std::map<const void*, size_t> component_of_owner;
+	for (const auto* owner : region.workers().owners())
+	{
+		const auto& node = *static_cast<const tree_base_node*>(owner);
+		const auto it = components.component_of_node.find(node.graph_info().get_id());
+		if (it != components.component_of_node.end())
+			component_of_owner.emplace(owner, it->second);
+	}
+	region.workers().set_components(std::move(component_of_owner), pool);
+	return components.nr_of_components;
+}
+
+} // namespace graph
+} // namespace fc
@@ -0,0 +1,58 @@
+#ifndef SRC_GRAPH_COMPONENTS_HPP_
+#define SRC_GRAPH_COMPONENTS_HPP_
+
+#include <flexcore/extended/graph/graph.hpp>
+
+#include <cstddef>
+#include <map>
+
+namespace fc
+{
+namespace thread
+{
+class scheduler;
+}
+
+namespace graph
+{
+
+/// connected components of the nodes of a region found by independent_components.
+struct region_components
+{
+	/// index of the component in [0, nr_of_components) by id of node.
+	std::map<unique_id, size_t> component_of_node;
+	size_t nr_of_components = 0;
+};
+
+/**
+ * \brief finds the sets of nodes of region which are not connected to each other.
+ *
+ * Nodes are connected by edges between them, directly or through nodes
+ * without a region, like pure nodes.
+ * Edges to nodes of other regions do not connect, as these are buffered.
+ * Nodes of different components thus do not exchange events or states within a cycle.
+ * Components are numbered in the order their first node was added to the graph.
+ */
+region_components independent_components(
+		const connection_graph& graph, const parallel_region& region);
+
+/**
+ * \brief runs the independent components of region in parallel within each work tick.
+ *
+ * Finds the components of the region with independent_components and passes them
+ * to the work_groups of the region, so that the region_worker_nodes of one component
+ * run serially and the components in parallel on pool. No buffers are needed between them.
+ * Needs to be called again after nodes have been added or connections changed,
+ * workers of nodes added later run serially before the components.
+ *
+ * Only use this if the nodes of the region share no state besides their connections.
+ * Owners of workers of region need to be tree_base_nodes, like those of region_worker_node.
+ * \returns the number of components found.
+ */
+size_t run_components_in_parallel(
+		const connection_graph& graph, parallel_region& region, thread::scheduler& pool);
+
+} // namespace graph
+} // namespace fc
+
+#endif /* SRC_GRAPH_COMPONENTS_HPP_ */
@@ -1,11 +1,19 @@
 #include <flexcore/extended/graph/graph.hpp>
+#include <flexcore/extended/graph/node_profiler.hpp>
 #include <flexcore/scheduler/parallelregion.hpp>
+#include <flexcore/utils/demangle.hpp>
 
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/graphviz.hpp>
 #include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
 
+#include <cassert>
 #include <mutex>
+#include <ostream>
+#include <typeindex>
+#include <unordered_set>
+#include <unordered_map>
 
 namespace fc
 {
@@ -38,16 +46,37 @@ struct connection_graph::impl
 {
 	/// Adds a new Connection without ports to the graph.
 	void add_connection(const graph_properties& source_node, const graph_properties& sink_node);
+	/// \pre graph_mutex is locked.
+	void add_connection_locked(
+			const graph_properties& source_node, const graph_properties& sink_node);
 
 	void add_port(const graph_properties& port_info);
 
-	const std::set<graph_properties>& ports() const;
-	const std::unordered_set<graph_edge>& edges() const;
+	/// materialize pending connections first, thus not const.
+	const std::set<graph_properties>& ports();
+	const std::unordered_set<graph_edge>& edges();
 
 	dataflow_graph_t dataflow_graph;
 	std::map<graph::unique_id, dataflow_graph_t::vertex_descriptor> vertex_map;
 	std::unordered_set<graph_edge> edge_set;
 	std::set<graph_properties> port_set;
+	/// elements of edge_set and port_set in the order they were added, see changes_since.
+	std::vector<const graph_edge*> edge_log;
+	std::vector<const graph_properties*> port_log;
+	/// adds port to port_set and port_log. \pre graph_mutex is locked.
+	void add_port_locked(const graph_properties& port_info);
+	std::unordered_map<graph_edge, std::shared_ptr<thread::duration_histogram>> latency_map;
+	std::map<unique_id, std::shared_ptr<port_counters>> counter_map;
+	std::atomic<bool> count_ports{false};
+	std::shared_ptr<node_profiler> profiler;
+	std::atomic<bool> track_nodes{false};
+
+	connection_graph::recording mode = connection_graph::recording::immediate;
+	/// connections and ports added in deferred mode, which are not in the graph yet.
+	std::vector<std::pair<graph_properties, graph_properties>> pending_connections;
+	std::vector<graph_properties> pending_ports;
+	/// adds pending connections and ports to the graph. \pre graph_mutex is locked.
+	void materialize_locked();
 
 	mutable std::mutex graph_mutex;
 };
@@ -72,6 +101,46 @@ connection_graph::connection_graph() : pimpl(std::make_unique<impl>())
 {
 }
 
+connection_graph::connection_graph(recording mode) : connection_graph()
+{
+	pimpl->mode = mode;
+}
+
+symbol::symbol(const std::string& str)
+{
+	static std::mutex table_mutex;
+	// elements of unordered_set keep their address on rehash.
+	static std::unordered_set<std::string> table;
+	std::lock_guard<std::mutex> lock(table_mutex);
+	str_ = &*table.insert(str).first;
+}
+
+symbol symbol::of_type(const std::type_info& type)
+{
+	static std::mutex cache_mutex;
+	static std::unordered_map<std::type_index, symbol> cache;
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		const auto cached = cache.find(type);
+		if (cached != cache.end())
+			return cached->second;
+	}
+	// demangling allocates and may take long, so it is done without holding the lock.
+	const symbol demangled{demangle(type.name())};
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	return cache.emplace(type, demangled).first->second;
+}
+
+namespace
+{
+/// returns a random id, seeding a generator takes far longer than drawing from it.
+unique_id new_id()
+{
+	thread_local boost::uuids::random_generator generator;
+	return generator();
+}
+}
+
 graph_node_properties::graph_node_properties(
 		const std::string& name, parallel_region* region, unique_id id, bool is_pure)
 	: human_readable_name_(name), id_(id), region_(region), is_pure_(is_pure)
@@ -80,18 +149,24 @@ graph_node_properties::graph_node_properties(
 
 graph_node_properties::graph_node_properties(
 		const std::string& name, parallel_region* region, bool is_pure)
-	: graph_node_properties(name, region, boost::uuids::random_generator()(), is_pure)
+	: graph_node_properties(name, region, new_id(), is_pure)
 {
 }
 
 graph_port_properties::graph_port_properties(
 		std::string description, unique_id owning_node, port_type type)
-	: description_(std::move(description))
+	: graph_port_properties(symbol{description}, std::move(owning_node), std::move(type))
+{
+}
+
+graph_port_properties::graph_port_properties(
+		symbol description, unique_id owning_node, port_type type)
+	: description_(description)
 	, owning_node_(std::move(owning_node))
-	, id_(boost::uuids::random_generator()())
+	, id_(new_id())
 	, type_(std::move(type))
 {
-	assert(!description_.empty());
+	assert(!description_.str().empty());
 	assert(owning_node_ != id_);
 }
 
@@ -104,16 +179,126 @@ connection_graph::~connection_graph() = default;
 
 void connection_graph::print(std::ostream& stream) const
 {
-	std::lock_guard<std::mutex> lock(pimpl->graph_mutex);
-	const auto& graph = pimpl->dataflow_graph;
+	dataflow_graph_t graph;
+	{
+		// the copy is printed without holding the lock.
+		std::lock_guard<std::mutex> lock(pimpl->graph_mutex);
+		pimpl->materialize_locked();
+		graph = pimpl->dataflow_graph;
+	}
 	boost::write_graphviz(stream, graph, vertex_printer{graph},
 			boost::make_label_writer(boost::get(&edge::name, graph)));
 }
 
+graph_changes connection_graph::changes_since(const graph_version& version) const
+{
+	graph_changes changes;
+	std::lock_guard<std::mutex> lock(pimpl->graph_mutex);
+	pimpl->materialize_locked();
+	const auto& ports = pimpl->port_log;
+	const auto& edges = pimpl->edge_log;
+	assert(version.ports <= ports.size());
+	assert(version.edges <= edges.size());
+	changes.new_ports.reserve(ports.size() - version.ports);
+	for (auto it = ports.begin() + version.ports; it != ports.end(); ++it)
+		changes.new_ports.push_back(**it);
+	changes.new_edges.reserve(edges.size() - version.edges);
+	for (auto it = edges.begin() + version.edges; it != edges.end(); ++it)
+		changes.new_edges.push_back(**it);
+	changes.version.ports = ports.size();
+	changes.version.edges = edges.size();
+	return changes;
+}
+
+namespace
+{
+void write_json_string(std::ostream& stream, const std::string& str)
+{
+	stream << '"';
+	for (const char c : str)
+	{
+		switch (c)
+		{
+		case '"': stream << "\\\""; break;
+		case '\\': stream << "\\\\"; break;
+		case '\n': stream << "\\n"; break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20)
+				stream << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 0xf];
+			else
+				stream << c;
+		}
+	}
+	stream << '"';
+}
+
+const char* port_type_name(graph_port_properties::port_type type)
+{
+	switch (type)
+	{
+	case graph_port_properties::port_type::EVENT: return "event";
+	case graph_port_properties::port_type::STATE: return "state";
+	default: return "undefined";
+	}
+}
+}
+
+void write_json(std::ostream& stream, const graph_changes& changes)
+{
+	stream << "{\"version\":{\"ports\":" << changes.version.ports
+			<< ",\"edges\":" << changes.version.edges << "},\"ports\":[";
+	bool first = true;
+	for (const auto& port : changes.new_ports)
+	{
+		stream << (first ? "" : ",") << "{\"id\":\"" << port.port_properties.id()
+				<< "\",\"node\":\"" << port.node_properties.get_id() << "\",\"node_name\":";
+		write_json_string(stream, port.node_properties.name());
+		stream << ",\"description\":";
+		write_json_string(stream, port.port_properties.description());
+		stream << ",\"type\":\"" << port_type_name(port.port_properties.type()) << "\"}";
+		first = false;
+	}
+	stream << "],\"edges\":[";
+	first = true;
+	for (const auto& edge : changes.new_edges)
+	{
+		stream << (first ? "" : ",") << "{\"source\":\"" << edge.source.port_properties.id()
+				<< "\",\"sink\":\"" << edge.sink.port_properties.id() << "\"}";
+		first = false;
+	}
+	stream << "]}\n";
+}
+
 void connection_graph::impl::add_connection(
 		const graph_properties& source_node, const graph_properties& sink_node)
 {
 	std::lock_guard<std::mutex> lock(graph_mutex);
+	if (mode == connection_graph::recording::deferred)
+		pending_connections.emplace_back(source_node, sink_node);
+	else
+		add_connection_locked(source_node, sink_node);
+}
+
+void connection_graph::impl::materialize_locked()
+{
+	for (const auto& connection : pending_connections)
+		add_connection_locked(connection.first, connection.second);
+	pending_connections.clear();
+	for (const auto& port : pending_ports)
+		add_port_locked(port);
+	pending_ports.clear();
+}
+
+void connection_graph::impl::add_port_locked(const graph_properties& port_info)
+{
+	const auto inserted = port_set.insert(port_info);
+	if (inserted.second)
+		port_log.push_back(&*inserted.first);
+}
+
+void connection_graph::impl::add_connection_locked(
+		const graph_properties& source_node, const graph_properties& sink_node)
+{
 	auto region_to_hash = [](parallel_region* reg) {
 		if (!reg)
 			return ~std::size_t(0);
@@ -121,7 +306,9 @@ void connection_graph::impl::add_connection(
 		return std::hash<std::string>{}(reg->get_id().key);
 	};
 
-	edge_set.emplace(source_node, sink_node);
+	const auto inserted = edge_set.emplace(source_node, sink_node);
+	if (inserted.second)
+		edge_log.push_back(&*inserted.first);
 
 	// check if vertex is already included, as add_vertex would add it again.
 	if (vertex_map.find(source_node.node_properties.get_id()) == vertex_map.end())
@@ -142,35 +329,96 @@ void connection_graph::impl::add_connection(
 			vertex_map[sink_node.node_properties.get_id()], edge{""}, dataflow_graph);
 }
 
+void connection_graph::reserve(size_t nr_of_ports, size_t nr_of_edges)
+{
+	std::lock_guard<std::mutex> lock(pimpl->graph_mutex);
+	pimpl->edge_set.reserve(nr_of_edges);
+	pimpl->edge_log.reserve(nr_of_edges);
+	pimpl->port_log.reserve(nr_of_ports);
+	if (pimpl->mode == recording::deferred)
+	{
+		pimpl->pending_connections.reserve(nr_of_edges);
+		pimpl->pending_ports.reserve(nr_of_ports);
+	}
+}
+
 void connection_graph::impl::add_port(const graph_properties& port_info)
 {
 	std::lock_guard<std::mutex> lock(graph_mutex);
-	port_set.emplace(port_info);
+	if (mode == connection_graph::recording::deferred)
+		pending_ports.push_back(port_info);
+	else
+		add_port_locked(port_info);
 }
 
-const std::set<graph_properties>& connection_graph::impl::ports() const
+const std::set<graph_properties>& connection_graph::impl::ports()
 {
 	std::lock_guard<std::mutex> lock(graph_mutex);
+	materialize_locked();
 	return port_set;
 }
 
-const std::unordered_set<graph_edge>& connection_graph::impl::edges() const
+const std::unordered_set<graph_edge>& connection_graph::impl::edges()
 {
 	std::lock_guard<std::mutex> lock(graph_mutex);
+	materialize_locked();
 	return edge_set;
 }
 
+namespace
+{
+/// innermost staging_scope of the current thread.
+thread_local connection_graph::staging_scope* current_staging = nullptr;
+}
+
 void connection_graph::add_connection(
 		const graph_properties& source_node, const graph_properties& sink_node)
 {
+	for (auto scope = current_staging; scope; scope = scope->previous)
+		if (&scope->graph == this)
+		{
+			scope->connections.emplace_back(source_node, sink_node);
+			return;
+		}
 	pimpl->add_connection(source_node, sink_node);
 }
 
 void connection_graph::add_port(const graph_properties& port_info)
 {
+	for (auto scope = current_staging; scope; scope = scope->previous)
+		if (&scope->graph == this)
+		{
+			scope->new_ports.push_back(port_info);
+			return;
+		}
 	pimpl->add_port(port_info);
 }
 
+connection_graph::staging_scope::staging_scope(connection_graph& graph)
+	: graph(graph), previous(current_staging)
+{
+	current_staging = this;
+}
+
+connection_graph::staging_scope::~staging_scope()
+{
+	assert(current_staging == this);
+	current_staging = previous;
+	auto& impl = *graph.pimpl;
+	std::lock_guard<std::mutex> lock(impl.graph_mutex);
+	if (impl.mode == recording::deferred)
+	{
+		impl.pending_connections.insert(
+				impl.pending_connections.end(), connections.begin(), connections.end());
+		impl.pending_ports.insert(impl.pending_ports.end(), new_ports.begin(), new_ports.end());
+		return;
+	}
+	for (const auto& connection : connections)
+		impl.add_connection_locked(connection.first, connection.second);
+	for (const auto& port : new_ports)
+		impl.add_port_locked(port);
+}
+
 const std::set<graph_properties>& connection_graph::ports() const
 {
 	return pimpl->ports();
@@ -181,9 +429,84 @@ const std::unordered_set<graph_edge>& connection_graph::edges() const
 	return pimpl->edges();
 }
 
+std::shared_ptr<thread::duration_histogram> connection_graph::latency_histogram(
+		const graph_edge& edge)
+{
+	std::lock_guard<std::mutex> lock(pimpl->graph_mutex);
+	auto& histogram = pimpl->latency_map[edge];
+	if (!histogram)
+		histogram = std::make_shared<thread::duration_histogram>();
+	return histogram;
+}
+
+std::vector<std::pair<graph_edge, thread::histogram_snapshot>> connection_graph::latencies() const
+{
+	std::lock_guard<std::mutex> lock(pimpl->graph_mutex);
+	std::vector<std::pair<graph_edge, thread::histogram_snapshot>> result;
+	result.reserve(pimpl->latency_map.size());
+	for (const auto& edge : pimpl->latency_map)
+		result.emplace_back(edge.first, edge.second->snapshot());
+	return result;
+}
+
+void connection_graph::enable_port_counters()
+{
+	pimpl->count_ports = true;
+}
+
+bool connection_graph::port_counters_enabled() const
+{
+	return pimpl->count_ports;
+}
+
+std::shared_ptr<port_counters> connection_graph::counters(const graph_port_properties& port)
+{
+	if (!port_counters_enabled())
+		return nullptr;
+	std::lock_guard<std::mutex> lock(pimpl->graph_mutex);
+	auto& result = pimpl->counter_map[port.id()];
+	if (!result)
+		result = std::make_shared<port_counters>();
+	return result;
+}
+
+void connection_graph::enable_node_profiling(size_t events_per_thread)
+{
+	std::lock_guard<std::mutex> lock(pimpl->graph_mutex);
+	if (!pimpl->profiler)
+		pimpl->profiler = std::make_shared<node_profiler>(events_per_thread);
+}
+
+std::shared_ptr<node_profiler> connection_graph::node_profiling() const
+{
+	std::lock_guard<std::mutex> lock(pimpl->graph_mutex);
+	return pimpl->profiler;
+}
+
+void connection_graph::enable_node_tracking()
+{
+	pimpl->track_nodes = true;
+}
+
+bool connection_graph::tracks_nodes() const
+{
+	return pimpl->track_nodes;
+}
+
+std::map<unique_id, port_statistics> connection_graph::statistics() const
+{
+	std::lock_guard<std::mutex> lock(pimpl->graph_mutex);
+	std::map<unique_id, port_statistics> result;
+	for (const auto& port : pimpl->counter_map)
+		result.emplace(port.first, port.second->snapshot());
+	return result;
+}
+
 void connection_graph::clear_graph()
 {
 	std::lock_guard<std::mutex> lock(pimpl->graph_mutex);
+	pimpl->pending_connections.clear();
+	pimpl->pending_ports.clear();
 	auto& graph = pimpl->dataflow_graph;
 	graph.clear();
 }
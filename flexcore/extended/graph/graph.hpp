@@ -2,13 +2,22 @@
 #define SRC_GRAPH_GRAPH_HPP_
 
 #include <flexcore/core/traits.hpp>
+#include <flexcore/scheduler/timing.hpp>
 
 #include <boost/functional/hash.hpp>
 #include <boost/uuid/uuid.hpp>
 
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
 #include <map>
+#include <memory>
 #include <set>
+#include <string>
+#include <typeinfo>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace fc
 {
@@ -25,6 +34,48 @@ namespace graph
 ///objects in graph are identified by a uuid
 using unique_id = boost::uuids::uuid;
 
+class node_profiler;
+
+/**
+ * \brief false if flexcore is built with FLEXCORE_DISABLE_GRAPH.
+ *
+ * Then ports neither add themselves nor their connections to the connection_graph,
+ * which saves the bookkeeping in applications which do not visualize their graph.
+ * Port counters and latency histograms still work.
+ */
+#ifdef FLEXCORE_DISABLE_GRAPH
+constexpr bool graph_recording_enabled = false;
+#else
+constexpr bool graph_recording_enabled = true;
+#endif
+
+/**
+ * \brief Handle to a string stored once in a global table of names.
+ *
+ * Names of nodes and descriptions of ports repeat a lot in large graphs,
+ * symbols of equal strings share the same storage and compare by address.
+ * Strings are never removed from the table, symbol is cheap to copy.
+ */
+class symbol
+{
+public:
+	/// interns str, thread safe.
+	explicit symbol(const std::string& str);
+
+	/**
+	 * \brief returns the demangled name of type, thread safe.
+	 * Each type is demangled once, later calls only look up the symbol.
+	 */
+	static symbol of_type(const std::type_info& type);
+
+	const std::string& str() const noexcept { return *str_; }
+	bool operator==(const symbol& o) const noexcept { return str_ == o.str_; }
+	bool operator!=(const symbol& o) const noexcept { return str_ != o.str_; }
+
+private:
+	const std::string* str_;
+};
+
 /**
  * \brief Contains the information carried by a node of the dataflow graph
  */
@@ -44,12 +95,12 @@ public:
 
 	bool operator==(const graph_node_properties& o) const { return id_ == o.id_; }
 
-	const std::string& name() const { return human_readable_name_; }
+	const std::string& name() const { return human_readable_name_.str(); }
 	unique_id get_id() const { return id_; }
 	parallel_region* region() const { return region_; }
 	bool is_pure() const { return is_pure_; }
 private:
-	std::string human_readable_name_;
+	symbol human_readable_name_;
 	unique_id id_;
 	parallel_region* region_;
 	bool is_pure_;
@@ -70,6 +121,8 @@ public:
 
 	/// \post !description.empty()
 	graph_port_properties(std::string description, unique_id owning_node, port_type type);
+	/// \post !description.str().empty()
+	graph_port_properties(symbol description, unique_id owning_node, port_type type);
 
 	template <class T>
 	static constexpr port_type to_port_type()
@@ -85,13 +138,13 @@ public:
 	bool operator<(const graph_port_properties&) const;
 	bool operator==(const graph_port_properties& o) const { return id_ == o.id_; }
 
-	const std::string& description() const { return description_; }
+	const std::string& description() const { return description_.str(); }
 	unique_id owning_node() const { return owning_node_; }
 	unique_id id() const { return id_; }
 	port_type type() const { return type_; }
 
 private:
-	std::string description_;
+	symbol description_;
 	unique_id owning_node_;
 	unique_id id_;
 	port_type type_;
@@ -126,6 +179,77 @@ struct graph_edge
 	bool operator==(const graph_edge& o) const { return source == o.source && sink == o.sink; }
 };
 
+/// position in the history of a connection_graph, see connection_graph::changes_since.
+struct graph_version
+{
+	/// number of ports added to the graph.
+	size_t ports = 0;
+	/// number of edges added to the graph.
+	size_t edges = 0;
+};
+
+/// ports and edges added to a connection_graph after a graph_version.
+struct graph_changes
+{
+	/// version of the graph including these changes, pass to the next changes_since.
+	graph_version version;
+	std::vector<graph_properties> new_ports;
+	std::vector<graph_edge> new_edges;
+};
+
+/**
+ * \brief writes changes as a single line of JSON to stream.
+ *
+ * Ports are written as objects with id, node, node_name, description and type,
+ * edges refer to the ids of their source and sink ports.
+ * A monitor mirrors the graph by applying the changes in order.
+ */
+void write_json(std::ostream& stream, const graph_changes& changes);
+
+/// values of port_counters at a single point in time.
+struct port_statistics
+{
+	uint64_t events = 0;
+	uint64_t bytes = 0;
+	uint64_t pulls = 0;
+};
+
+/**
+ * \brief throughput counters of a single port.
+ *
+ * Ports count what they do actively: event sources count fired events
+ * and state sinks count pulled states. Counting only uses relaxed atomic increments,
+ * since every port is used by the thread of its region, they are never contended.
+ * Bytes are counted as the size of the token type, memory owned by tokens is not included.
+ */
+class port_counters
+{
+public:
+	void count_events(uint64_t nr_of_events, uint64_t token_size) noexcept
+	{
+		events.fetch_add(nr_of_events, std::memory_order_relaxed);
+		bytes.fetch_add(nr_of_events * token_size, std::memory_order_relaxed);
+	}
+	void count_pull(uint64_t token_size) noexcept
+	{
+		pulls.fetch_add(1, std::memory_order_relaxed);
+		bytes.fetch_add(token_size, std::memory_order_relaxed);
+	}
+	port_statistics snapshot() const noexcept
+	{
+		port_statistics result;
+		result.events = events.load(std::memory_order_relaxed);
+		result.bytes = bytes.load(std::memory_order_relaxed);
+		result.pulls = pulls.load(std::memory_order_relaxed);
+		return result;
+	}
+
+private:
+	std::atomic<uint64_t> events{0};
+	std::atomic<uint64_t> bytes{0};
+	std::atomic<uint64_t> pulls{0};
+};
+
 /**
  * \brief The abstract connection graph of a flexcore application.
  *
@@ -137,7 +261,20 @@ struct graph_edge
 class connection_graph
 {
 public:
+	/// how connections and ports are added to the graph.
+	enum class recording
+	{
+		/// added to the graph right away.
+		immediate,
+		/**
+		 * appended to a log, which is only added to the graph
+		 * when the graph is read, for example by print, ports or edges.
+		 */
+		deferred
+	};
+
 	connection_graph();
+	explicit connection_graph(recording mode);
 	connection_graph(const connection_graph&) = delete;
 
 	/// Adds a new Connection without ports to the graph.
@@ -145,15 +282,94 @@ public:
 
 	void add_port(const graph_properties& port_info);
 
+	/**
+	 * \brief allocates memory for ports and edges upfront, see forest_owner::reserve.
+	 * Adding up to the given numbers does not reallocate the tables of the graph.
+	 */
+	void reserve(size_t nr_of_ports, size_t nr_of_edges);
+
 	const std::set<graph_properties>& ports() const;
 	const std::unordered_set<graph_edge>& edges() const;
 
+	/**
+	 * \brief returns the histogram of latencies of events sent along edge.
+	 * The histogram is created on first access, all buffers of the edge share it.
+	 * \see buffer_config::latency_sampling
+	 */
+	std::shared_ptr<thread::duration_histogram> latency_histogram(const graph_edge& edge);
+	/// returns the latencies of all edges, which have a latency_histogram.
+	std::vector<std::pair<graph_edge, thread::histogram_snapshot>> latencies() const;
+
+	/**
+	 * \brief enables port_counters for all ports added to the graph afterwards.
+	 * Without counters, ports do not count and pay a single branch per operation.
+	 */
+	void enable_port_counters();
+	bool port_counters_enabled() const;
+	/// returns the counters of port, nullptr if port counters are not enabled.
+	std::shared_ptr<port_counters> counters(const graph_port_properties& port);
+	/// returns the statistics of all ports with counters, by id of port.
+	std::map<unique_id, port_statistics> statistics() const;
+
+	/**
+	 * \brief profiles the nodes of all ports added to the graph afterwards, see node_profiler.
+	 * Without profiling, ports pay nothing. Enabling it again keeps the current profiler.
+	 * \param events_per_thread size of the ring every thread records to.
+	 */
+	void enable_node_profiling(size_t events_per_thread = 1 << 16);
+	/// returns the profiler of the nodes, nullptr if node profiling is not enabled.
+	std::shared_ptr<node_profiler> node_profiling() const;
+
+	/**
+	 * \brief lets actions of ports added afterwards tell which node the thread executes.
+	 * Violations found by thread::realtime_checks then name their node.
+	 * Without tracking, ports pay nothing.
+	 */
+	void enable_node_tracking();
+	/// returns true if ports track their node, see enable_node_tracking.
+	bool tracks_nodes() const;
+
 	/// Prints current state of the abstract graph in graphviz format to stream.
 	void print(std::ostream& stream) const;
 
+	/**
+	 * \brief returns the ports and edges added since version, in the order they were added.
+	 *
+	 * Only the changes are copied while the graph is locked,
+	 * serializing them, for example with write_json, does not block the graph.
+	 * Start with a default constructed graph_version to get the whole graph.
+	 */
+	graph_changes changes_since(const graph_version& version) const;
+
 	/// deleted the current graph \post graph is empty
 	void clear_graph();
 
+	/**
+	 * \brief Collects the connections and ports added to graph by the current thread.
+	 *
+	 * While a staging_scope is alive, add_connection and add_port called from its thread
+	 * only append to the scope, which merges them into graph on destruction in one step.
+	 * Threads building independent parts of the graph concurrently
+	 * thus do not contend for the lock of the graph on every connection.
+	 * Collected connections are not visible in the graph before the merge.
+	 */
+	class staging_scope
+	{
+	public:
+		explicit staging_scope(connection_graph& graph);
+		staging_scope(const staging_scope&) = delete;
+		staging_scope& operator=(const staging_scope&) = delete;
+		~staging_scope();
+
+	private:
+		friend class connection_graph;
+		connection_graph& graph;
+		/// scope of the thread before this one, restored on destruction.
+		staging_scope* previous;
+		std::vector<std::pair<graph_properties, graph_properties>> connections;
+		std::vector<graph_properties> new_ports;
+	};
+
 	~connection_graph();
 
 private:
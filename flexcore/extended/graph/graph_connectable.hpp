@@ -6,9 +6,13 @@
 #include <flexcore/core/detail/connection_utils.hpp>
 #include <flexcore/extended/graph/graph.hpp>
 #include <flexcore/extended/graph/traits.hpp>
-#include <flexcore/utils/demangle.hpp>
 
 #include <cassert>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace fc
 {
@@ -42,23 +46,24 @@ struct graph_adder
 
 template <class T>
 auto port_description(const std::string& node_name)
-		-> std::enable_if_t<has_token_type<T>(0), std::string>
+		-> std::enable_if_t<has_token_type<T>(0), symbol>
 {
 	if (!node_name.empty())
-		return "'" + node_name + "'";
-	else
-		return demangle(typeid(typename T::token_t).name());
+		return symbol{"'" + node_name + "'"};
+	// looked up once per token type, ports only copy the symbol.
+	static const symbol token_name = symbol::of_type(typeid(typename T::token_t));
+	return token_name;
 }
 
-/// \post !result.empty()
+/// \post !result.str().empty()
 template <class T>
 auto port_description(const std::string& node_name)
-		-> std::enable_if_t<!has_token_type<T>(0), std::string>
+		-> std::enable_if_t<!has_token_type<T>(0), symbol>
 {
 	if (!node_name.empty())
-		return "'" + node_name + "'";
-	else
-		return "'AdHoc'";
+		return symbol{"'" + node_name + "'"};
+	static const symbol ad_hoc{"'AdHoc'"};
+	return ad_hoc;
 }
 
 template <class T>
@@ -84,6 +89,73 @@ void set_graph_object(T&, connection_graph*)
 {
 }
 
+/**
+ * \brief lets the buffer of the next connection of port record to the latency of its edge.
+ *
+ * Only ports with a buffer_config which samples latencies and has no histogram of its own
+ * are traced, and only if the connection crosses regions.
+ * \param nodes nodes of the connection, starting with port.
+ * \returns true if the histogram has been set and needs to be reset after connecting.
+ */
+template <class T>
+auto trace_edge(T& port, connection_graph& graph, const std::vector<graph_properties>& nodes,
+		int) -> decltype(port.get_buffer_config(), bool())
+{
+	auto config = port.get_buffer_config();
+	if (config.latency_sampling == 0 || config.latency_histogram || nodes.size() < 2)
+		return false;
+	if (nodes.front().node_properties.region() == nodes.back().node_properties.region())
+		return false;
+	config.latency_histogram = graph.latency_histogram(graph_edge{nodes[0], nodes[1]});
+	port.set_buffer_config(std::move(config));
+	return true;
+}
+
+template <class T>
+bool trace_edge(T&, connection_graph&, const std::vector<graph_properties>&, long)
+{
+	return false;
+}
+
+template <class T>
+auto untrace_edge(T& port, int) -> decltype(port.get_buffer_config(), void())
+{
+	auto config = port.get_buffer_config();
+	config.latency_histogram.reset();
+	port.set_buffer_config(std::move(config));
+}
+
+template <class T>
+void untrace_edge(T&, long)
+{
+}
+
+/// size in bytes of tokens counted by port_counters, zero for void events.
+template <class T>
+struct token_size : std::integral_constant<uint64_t, sizeof(T)>
+{
+};
+
+template <>
+struct token_size<void> : std::integral_constant<uint64_t, 0>
+{
+};
+
+/// resets the latency histogram set by trace_edge, once the connection has been made.
+template <class T>
+struct edge_trace
+{
+	edge_trace(T& traced_port, bool is_traced) : port(traced_port), traced(is_traced) {}
+	edge_trace(const edge_trace&) = delete;
+	~edge_trace()
+	{
+		if (traced)
+			untrace_edge(port, 0);
+	}
+	T& port;
+	bool traced;
+};
+
 } // namespace detail
 
 /**
@@ -111,8 +183,10 @@ struct graph_connectable : base_t
 		, graph_port_info(detail::port_description<base_t>(std::string{}), graph_info.get_id(),
 				  graph_port_properties::to_port_type<base_t>())
 		, graph(&central_graph)
+		, counters(central_graph.counters(graph_port_info))
 	{
-		graph->add_port({graph_info, graph_port_info});
+		if (graph_recording_enabled)
+			graph->add_port({graph_info, graph_port_info});
 		assert(graph != nullptr);
 	}
 
@@ -124,6 +198,7 @@ struct graph_connectable : base_t
 		, graph_port_info(detail::port_description<base_t>(graph_info.name()), graph_info.get_id(),
 				  graph_port_properties::to_port_type<base_t>())
 		, graph(nullptr)
+		, counters()
 	{
 	}
 
@@ -147,25 +222,89 @@ struct graph_connectable : base_t
 		detail::set_graph_object(conn, current_graph);
 		graph = current_graph;
 		assert(graph != nullptr);
+		if (!counters)
+			counters = graph->counters(graph_port_info);
 
 		// traverse connection and build up graph
-		if (is_active_sink<base_t>{}) // condition set at compile_time
+		std::vector<graph_properties> event_nodes;
+		if (!graph_recording_enabled)
+		{
+			// only the nodes needed to trace the edge.
+			if (is_active_source<base_t>{})
+				event_nodes = connection_nodes(conn);
+		}
+		else if (is_active_sink<base_t>{}) // condition set at compile_time
 		{
 			add_state_connection(conn, *graph);
 		}
 		else if (is_active_source<base_t>{}) // condition set at compile_time
 		{
-			add_event_connection(conn, *graph);
+			event_nodes = add_event_connection(conn, *graph);
 		}
 
+		base_t& port = *this;
+		const detail::edge_trace<base_t> trace{
+				port, detail::trace_edge(port, *graph, event_nodes, 0)};
 		return base_t::connect(std::forward<arg_t>(conn));
 	}
 
+	/// Fires events through base_t and counts them, if port counters are enabled.
+	template <class... T, class check_t = base_t>
+	auto fire(T&&... event) -> decltype(std::declval<check_t&>().fire(std::forward<T>(event)...))
+	{
+		if (counters)
+			counters->count_events(1, token_size<check_t>());
+		return base_t::fire(std::forward<T>(event)...);
+	}
+
+	template <class events_t, class check_t = base_t>
+	auto fire_batch(events_t&& events) -> decltype(std::declval<check_t&>().fire_batch(events))
+	{
+		if (counters)
+			counters->count_events(events.size(), token_size<check_t>());
+		return base_t::fire_batch(events);
+	}
+
+	template <class events_t, class check_t = base_t>
+	auto fire_batch_move(events_t&& events)
+			-> decltype(std::declval<check_t&>().fire_batch_move(events))
+	{
+		if (counters)
+			counters->count_events(events.size(), token_size<check_t>());
+		return base_t::fire_batch_move(events);
+	}
+
+	/// Pulls state through base_t and counts the pull, if port counters are enabled.
+	template <class check_t = base_t>
+	auto get() const -> decltype(std::declval<const check_t&>().get())
+	{
+		if (counters)
+			counters->count_pull(token_size<check_t>());
+		return base_t::get();
+	}
+
 	///graph_info needs to be public as it is checked by graph adding methods.
 	graph_node_properties graph_info;
 	graph_port_properties graph_port_info;
 	graph::connection_graph* graph;
+	/// counters of this port, nullptr if the graph does not count ports.
+	std::shared_ptr<port_counters> counters;
 private:
+	template <class port_t>
+	static constexpr uint64_t token_size()
+	{
+		return detail::token_size<std::remove_reference_t<typename port_t::token_t>>{};
+	}
+
+	/// \returns the nodes of an event connection, starting with this port.
+	template <class connection_t>
+	std::vector<graph_properties> connection_nodes(connection_t& conn) const
+	{
+		std::vector<graph_properties> node_list;
+		node_list.emplace_back(graph_info, graph_port_info);
+		::fc::detail::apply(detail::graph_adder{node_list}, conn);
+		return node_list;
+	}
 
 	template <class connection_t>
 	void add_state_connection(connection_t& conn, graph::connection_graph& current_graph) const
@@ -184,14 +323,13 @@ private:
 			current_graph.add_port(node);
 	}
 
+	/// \returns the nodes of the connection, starting with this port.
 	template <class connection_t>
-	void add_event_connection(connection_t& conn, graph::connection_graph& current_graph) const
+	std::vector<graph_properties> add_event_connection(
+			connection_t& conn, graph::connection_graph& current_graph) const
 	{
-		std::vector<graph_properties> node_list;
-
 		// event source is first, thus added before connection
-		node_list.emplace_back(graph_info, graph_port_info);
-		::fc::detail::apply(detail::graph_adder{node_list}, conn);
+		auto node_list = connection_nodes(conn);
 
 		if (node_list.size() >= 2)
 			for (auto it = node_list.begin() + 1; it != node_list.end(); ++it)
@@ -199,6 +337,7 @@ private:
 
 		for (auto& node : node_list)
 			current_graph.add_port(node);
+		return node_list;
 	}
 };
 
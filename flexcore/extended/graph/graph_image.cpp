@@ -0,0 +1,199 @@
+#include <flexcore/extended/graph/graph_image.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <tuple>
+
+namespace fc
+{
+namespace graph
+{
+
+constexpr uint32_t graph_image::none;
+
+namespace
+{
+constexpr char magic[4] = {'F', 'C', 'G', 'I'};
+constexpr uint32_t format_version = 1;
+
+/// writes integers little endian, independent of the platform.
+void write_uint(std::ostream& stream, uint64_t value, size_t bytes)
+{
+	char buffer[8];
+	for (size_t i = 0; i != bytes; ++i)
+		buffer[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+	stream.write(buffer, static_cast<std::streamsize>(bytes));
+}
+
+void write_string(std::ostream& stream, const std::string& str)
+{
+	write_uint(stream, str.size(), 4);
+	stream.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+uint64_t read_uint(std::istream& stream, size_t bytes)
+{
+	unsigned char buffer[8];
+	if (!stream.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(bytes)))
+		throw std::runtime_error("graph image is truncated");
+	uint64_t value = 0;
+	for (size_t i = 0; i != bytes; ++i)
+		value |= static_cast<uint64_t>(buffer[i]) << (8 * i);
+	return value;
+}
+
+std::string read_string(std::istream& stream)
+{
+	std::string result(read_uint(stream, 4), '\0');
+	if (!stream.read(&result[0], static_cast<std::streamsize>(result.size())))
+		throw std::runtime_error("graph image is truncated");
+	return result;
+}
+
+/// reads a count of entries, allocation is limited by the size of the stream itself.
+size_t read_count(std::istream& stream)
+{
+	return static_cast<size_t>(read_uint(stream, 4));
+}
+
+/// reads an index, which needs to refer to one of size entries or be none.
+uint32_t read_index(std::istream& stream, size_t size)
+{
+	const auto index = static_cast<uint32_t>(read_uint(stream, 4));
+	if (index != graph_image::none && index >= size)
+		throw std::runtime_error("graph image refers to a missing entry");
+	return index;
+}
+} // namespace
+
+void write_image(std::ostream& stream, const graph_image& image)
+{
+	stream.write(magic, sizeof(magic));
+	write_uint(stream, format_version, 4);
+
+	write_uint(stream, image.regions.size(), 4);
+	for (const auto& region : image.regions)
+	{
+		write_string(stream, region.name);
+		write_uint(stream, static_cast<uint64_t>(region.tick.count()), 8);
+	}
+	write_uint(stream, image.nodes.size(), 4);
+	for (const auto& node : image.nodes)
+	{
+		write_string(stream, node.name);
+		write_uint(stream, node.parent, 4);
+		write_uint(stream, node.region, 4);
+	}
+	write_uint(stream, image.ports.size(), 4);
+	for (const auto& port : image.ports)
+	{
+		write_uint(stream, port.node, 4);
+		write_string(stream, port.description);
+		write_uint(stream, static_cast<uint64_t>(port.type), 1);
+	}
+	write_uint(stream, image.edges.size(), 4);
+	for (const auto& edge : image.edges)
+	{
+		write_uint(stream, edge.source, 4);
+		write_uint(stream, edge.sink, 4);
+	}
+}
+
+graph_image read_image(std::istream& stream)
+{
+	char header[sizeof(magic)];
+	if (!stream.read(header, sizeof(header)) || !std::equal(header, header + sizeof(header), magic))
+		throw std::runtime_error("stream does not contain a graph image");
+	if (read_uint(stream, 4) != format_version)
+		throw std::runtime_error("graph image has an unsupported version");
+
+	graph_image image;
+	// entries are appended one by one, a corrupt count fails on the end of the stream.
+	for (auto n = read_count(stream); n != 0; --n)
+	{
+		auto name = read_string(stream);
+		const auto ticks = static_cast<virtual_clock::rep>(read_uint(stream, 8));
+		image.regions.push_back({std::move(name), virtual_clock::steady::duration{ticks}});
+	}
+	for (auto n = read_count(stream); n != 0; --n)
+	{
+		auto name = read_string(stream);
+		const auto parent = read_index(stream, image.nodes.size());
+		const auto region = read_index(stream, image.regions.size());
+		image.nodes.push_back({std::move(name), parent, region});
+	}
+	for (auto n = read_count(stream); n != 0; --n)
+	{
+		const auto node = read_index(stream, image.nodes.size());
+		auto description = read_string(stream);
+		const auto type = read_uint(stream, 1);
+		if (type > static_cast<uint64_t>(graph_port_properties::port_type::STATE))
+			throw std::runtime_error("graph image contains an unknown port type");
+		image.ports.push_back({node, std::move(description),
+				static_cast<graph_port_properties::port_type>(type)});
+	}
+	for (auto n = read_count(stream); n != 0; --n)
+	{
+		const auto source = read_index(stream, image.ports.size());
+		const auto sink = read_index(stream, image.ports.size());
+		if (source == graph_image::none || sink == graph_image::none)
+			throw std::runtime_error("graph image contains an edge without port");
+		image.edges.push_back({source, sink});
+	}
+	return image;
+}
+
+bool same_topology(const graph_image& lhs, const graph_image& rhs)
+{
+	const auto same_region = [](const auto& l, const auto& r)
+	{
+		return l.name == r.name && l.tick == r.tick;
+	};
+	const auto same_node = [](const auto& l, const auto& r)
+	{
+		return l.name == r.name && l.parent == r.parent && l.region == r.region;
+	};
+	const auto same_port = [](const auto& l, const auto& r)
+	{
+		return l.node == r.node && l.description == r.description && l.type == r.type;
+	};
+	if (lhs.regions.size() != rhs.regions.size() || lhs.nodes.size() != rhs.nodes.size()
+			|| lhs.ports.size() != rhs.ports.size() || lhs.edges.size() != rhs.edges.size())
+		return false;
+	if (!std::equal(lhs.regions.begin(), lhs.regions.end(), rhs.regions.begin(), same_region)
+			|| !std::equal(lhs.nodes.begin(), lhs.nodes.end(), rhs.nodes.begin(), same_node)
+			|| !std::equal(lhs.ports.begin(), lhs.ports.end(), rhs.ports.begin(), same_port))
+		return false;
+
+	const auto sorted_edges = [](const graph_image& image)
+	{
+		auto edges = image.edges;
+		std::sort(edges.begin(), edges.end(), [](const auto& l, const auto& r)
+		{
+			return std::tie(l.source, l.sink) < std::tie(r.source, r.sink);
+		});
+		return edges;
+	};
+	const auto l = sorted_edges(lhs);
+	const auto r = sorted_edges(rhs);
+	return std::equal(l.begin(), l.end(), r.begin(), [](const auto& a, const auto& b)
+	{
+		return a.source == b.source && a.sink == b.sink;
+	});
+}
+
+std::vector<std::shared_ptr<parallel_region>> make_regions(const graph_image& image,
+		std::shared_ptr<clock_domain> clock)
+{
+	std::vector<std::shared_ptr<parallel_region>> regions;
+	regions.reserve(image.regions.size());
+	for (const auto& region : image.regions)
+		regions.push_back(std::make_shared<parallel_region>(region.name, region.tick, clock));
+	return regions;
+}
+
+} // namespace graph
+} // namespace fc
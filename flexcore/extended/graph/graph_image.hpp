@@ -0,0 +1,95 @@
+#ifndef SRC_GRAPH_GRAPH_IMAGE_HPP_
+#define SRC_GRAPH_GRAPH_IMAGE_HPP_
+
+#include <flexcore/extended/graph/graph.hpp>
+#include <flexcore/scheduler/clock.hpp>
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fc
+{
+class parallel_region;
+
+namespace graph
+{
+
+/**
+ * \brief binary description of the topology of a constructed application.
+ *
+ * Contains the forest of nodes with their names and regions
+ * and the ports and connections of the connection_graph.
+ * Entries refer to each other by their index, nodes are stored in preorder,
+ * so the parent of a node always comes before it.
+ * An image is captured with forest_owner::image and stored with write_image.
+ *
+ * Nodes are instances of C++ types, which an image cannot recreate by itself.
+ * Instead the application builds its nodes as before,
+ * forest_owner::reserve preallocates the forest, index and graph in one pass,
+ * and make_regions creates the regions of the image in one go.
+ * same_topology verifies that the rebuilt application matches the stored one.
+ */
+struct graph_image
+{
+	static constexpr uint32_t none = UINT32_MAX;
+
+	struct region_entry
+	{
+		std::string name;
+		virtual_clock::steady::duration tick;
+	};
+	struct node_entry
+	{
+		std::string name;
+		/// index of the parent node, none for the root.
+		uint32_t parent;
+		/// index of the region, none for nodes without region.
+		uint32_t region;
+	};
+	struct port_entry
+	{
+		/// index of the node, none for ports of nodes outside the forest.
+		uint32_t node;
+		std::string description;
+		graph_port_properties::port_type type;
+	};
+	struct edge_entry
+	{
+		uint32_t source;
+		uint32_t sink;
+	};
+
+	std::vector<region_entry> regions;
+	std::vector<node_entry> nodes;
+	std::vector<port_entry> ports;
+	std::vector<edge_entry> edges;
+};
+
+/// writes image to stream in a compact binary format, which does not depend on the platform.
+void write_image(std::ostream& stream, const graph_image& image);
+
+/**
+ * \brief reads an image written by write_image.
+ * \throws std::runtime_error if stream does not contain a valid image
+ * or one of a different version.
+ */
+graph_image read_image(std::istream& stream);
+
+/**
+ * \brief returns true if both images describe the same application.
+ *
+ * Regions, nodes and ports are compared in order, edges regardless of their order.
+ */
+bool same_topology(const graph_image& lhs, const graph_image& rhs);
+
+/// creates the regions of image in order, all running on clock.
+std::vector<std::shared_ptr<parallel_region>> make_regions(const graph_image& image,
+		std::shared_ptr<clock_domain> clock = clock_domain::global());
+
+} // namespace graph
+} // namespace fc
+
+#endif /* SRC_GRAPH_GRAPH_IMAGE_HPP_ */
@@ -0,0 +1,98 @@
+#include <flexcore/extended/graph/node_profiler.hpp>
+
+#include <ostream>
+#include <utility>
+
+namespace fc
+{
+namespace graph
+{
+
+node_profiler::node_profiler(size_t events_per_thread)
+	: rings(events_per_thread, true)
+{
+}
+
+uint32_t node_profiler::add_node(const graph_node_properties& node)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto inserted = index.emplace(node.get_id(), static_cast<uint32_t>(nodes.size()));
+	if (inserted.second)
+	{
+		nodes.push_back(node.get_id());
+		names.emplace(node.get_id(), node.name());
+	}
+	return inserted.first->second;
+}
+
+node_profile node_profiler::snapshot() const
+{
+	node_profile result;
+	// nodes are copied last, so they contain the nodes of all events copied.
+	const auto threads = rings.snapshot();
+	std::lock_guard<std::mutex> lock(mutex);
+	result.names = names;
+	for (const auto& thread : threads)
+	{
+		std::vector<node_event> events;
+		events.reserve(thread.events.size());
+		for (const auto& e : thread.events)
+			events.push_back(node_event{nodes[e.first >> 1], (e.first & 1) == 0, e.second});
+		result.threads.push_back(std::move(events));
+	}
+	return result;
+}
+
+void write_folded(std::ostream& stream, const node_profile& profile,
+		const std::function<std::string(const unique_id&)>& name_of)
+{
+	const auto name = [&](const unique_id& node)
+	{
+		if (name_of)
+			return name_of(node);
+		const auto it = profile.names.find(node);
+		return it == profile.names.end() ? std::string{"unknown node"} : it->second;
+	};
+
+	struct frame
+	{
+		unique_id node;
+		wall_clock::steady::time_point start;
+		wall_clock::steady::duration nested;
+		/// names of the frames up to and including this one.
+		std::string stack;
+	};
+	std::map<std::string, int64_t> self_times;
+	for (const auto& events : profile.threads)
+	{
+		std::vector<frame> stack;
+		for (const auto& e : events)
+		{
+			if (e.enter)
+			{
+				auto path = stack.empty() ? name(e.node) : stack.back().stack + ';' + name(e.node);
+				stack.push_back(frame{e.node, e.time, wall_clock::steady::duration::zero(),
+						std::move(path)});
+				continue;
+			}
+			// leaving a node entered before the oldest event kept by the ring.
+			if (stack.empty() || stack.back().node != e.node)
+			{
+				stack.clear();
+				continue;
+			}
+			const auto total = e.time - stack.back().start;
+			self_times[stack.back().stack] +=
+					std::chrono::duration_cast<std::chrono::nanoseconds>(
+							total - stack.back().nested).count();
+			stack.pop_back();
+			if (!stack.empty())
+				stack.back().nested += total;
+		}
+	}
+	for (const auto& line : self_times)
+		stream << line.first << ' ' << line.second << '\n';
+}
+
+} // namespace graph
+} // namespace fc
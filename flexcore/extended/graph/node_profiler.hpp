@@ -0,0 +1,141 @@
+#ifndef SRC_GRAPH_NODE_PROFILER_HPP_
+#define SRC_GRAPH_NODE_PROFILER_HPP_
+
+#include <flexcore/extended/graph/graph.hpp>
+#include <flexcore/scheduler/clock.hpp>
+#include <flexcore/scheduler/trace.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fc
+{
+namespace graph
+{
+
+/// node entered or left by a thread, as recorded by node_profiler.
+struct node_event
+{
+	unique_id node;
+	bool enter;
+	wall_clock::steady::time_point time;
+};
+
+/// events recorded by node_profiler, oldest first for every thread.
+struct node_profile
+{
+	std::vector<std::vector<node_event>> threads;
+	/// names of the nodes, as given when their ports were profiled.
+	std::map<unique_id, std::string> names;
+};
+
+/**
+ * \brief Records which node is executed by which thread, for flame graphs by node.
+ *
+ * Ports of nodes, which are created while the connection_graph profiles,
+ * record entering and leaving the action of their node: event_sinks when receiving events,
+ * state_sources when pulled. See connection_graph::enable_node_profiling.
+ * Thus the time of a node includes the nodes it calls through its ports,
+ * which shows in a flame graph as the nested frames of the called nodes.
+ *
+ * Every thread records to a ring of its own, which keeps its most recent events.
+ * Recording takes neither locks nor allocations, except for the first event of a thread,
+ * two timestamps and six relaxed atomic stores per action are left.
+ * snapshot can be taken while threads record, it misses the events being written.
+ */
+class node_profiler
+{
+public:
+	/// \param events_per_thread size of the ring of every thread, rounded up to a power of two.
+	explicit node_profiler(size_t events_per_thread = 1 << 16);
+
+	/// returns the index recorded for node, cold path called by ports on construction.
+	uint32_t add_node(const graph_node_properties& node);
+
+	void enter(uint32_t node) noexcept { rings.record(static_cast<uint64_t>(node) << 1); }
+	void leave(uint32_t node) noexcept { rings.record(static_cast<uint64_t>(node) << 1 | 1); }
+
+	/// copies the events of all threads, MT-safe.
+	node_profile snapshot() const;
+
+private:
+	thread::detail::event_rings rings;
+	mutable std::mutex mutex;
+	std::vector<unique_id> nodes;
+	std::map<unique_id, uint32_t> index;
+	std::map<unique_id, std::string> names;
+};
+
+/**
+ * \brief writes the self time of the nodes in the folded stack format of flame graphs.
+ *
+ * Every line holds the names of the nested nodes separated by ';' and their time
+ * in nanoseconds, without the time of the nodes within, as flamegraph.pl expects.
+ * Events cut off by the ring of a thread are skipped.
+ * \param name_of returns the name of a node in the flame graph,
+ * by default the name given to node_profiler::add_node.
+ */
+void write_folded(std::ostream& stream, const node_profile& profile,
+		const std::function<std::string(const unique_id&)>& name_of = {});
+
+namespace detail
+{
+/// records entering and leaving the node for the lifetime of the scope, even on exceptions.
+struct profile_scope
+{
+	profile_scope(node_profiler& profiler, uint32_t node) noexcept
+		: profiler(profiler), node(node)
+	{
+		profiler.enter(node);
+	}
+	profile_scope(const profile_scope&) = delete;
+	~profile_scope() { profiler.leave(node); }
+	node_profiler& profiler;
+	uint32_t node;
+};
+
+template<class signature>
+struct profiled_action;
+
+/**
+ * \brief wraps actions of ports, so that they record their node to the profiler of graph.
+ *
+ * If the graph does not profile, the action is returned as std::function unchanged,
+ * which the port moves into its own std::function, without any additional cost.
+ */
+template<class result_t, class... args_t>
+struct profiled_action<std::function<result_t(args_t...)>>
+{
+	using function_t = std::function<result_t(args_t...)>;
+
+	template<class action_t>
+	static function_t wrap(connection_graph& graph,
+			const graph_node_properties& node, action_t&& action)
+	{
+		function_t result(std::forward<action_t>(action));
+		auto profiler = graph.node_profiling();
+		if (!profiler)
+			return result;
+		const auto index = profiler->add_node(node);
+		return [profiler = std::move(profiler), index, wrapped = std::move(result)](
+				args_t... args) -> result_t
+		{
+			const profile_scope scope{*profiler, index};
+			return wrapped(std::forward<args_t>(args)...);
+		};
+	}
+};
+} // namespace detail
+
+} // namespace graph
+} // namespace fc
+
+#endif /* SRC_GRAPH_NODE_PROFILER_HPP_ */
@@ -0,0 +1,226 @@
+#include <flexcore/extended/graph/partitioning.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace fc
+{
+namespace graph
+{
+
+namespace
+{
+struct node_info
+{
+	unique_id id;
+	const parallel_region* region;
+	double load;
+	/// neighbour index and summed weight of the edges to it.
+	std::vector<std::pair<size_t, double>> neighbours;
+};
+
+double edge_weight(const graph_edge& edge, const std::map<unique_id, port_statistics>& statistics)
+{
+	double weight = 0.0;
+	bool counted = false;
+	for (const auto& port : {edge.source.port_properties.id(), edge.sink.port_properties.id()})
+	{
+		const auto it = statistics.find(port);
+		if (it == statistics.end())
+			continue;
+		weight += static_cast<double>(it->second.bytes);
+		counted = true;
+	}
+	return counted ? weight : 1.0;
+}
+
+/// collects the nodes of graph with their loads and the weighted edges between them.
+std::vector<node_info> collect_nodes(
+		const connection_graph& graph, const partitioning_options& options)
+{
+	// copies are taken while the graph is locked, the rest works without the lock.
+	const auto content = graph.changes_since(graph_version{});
+	const auto statistics = graph.statistics();
+
+	std::map<unique_id, size_t> index;
+	std::vector<node_info> nodes;
+	const auto add_node = [&](const graph_node_properties& node)
+	{
+		const auto inserted = index.emplace(node.get_id(), nodes.size());
+		if (inserted.second)
+			nodes.push_back(node_info{node.get_id(), node.region(), 0.0, {}});
+		return inserted.first->second;
+	};
+	for (const auto& port : content.new_ports)
+		add_node(port.node_properties);
+
+	std::map<std::pair<size_t, size_t>, double> weights;
+	for (const auto& edge : content.new_edges)
+	{
+		auto source = add_node(edge.source.node_properties);
+		auto sink = add_node(edge.sink.node_properties);
+		if (source == sink)
+			continue;
+		if (sink < source)
+			std::swap(source, sink);
+		weights[std::make_pair(source, sink)] += edge_weight(edge, statistics);
+	}
+	for (const auto& w : weights)
+	{
+		nodes[w.first.first].neighbours.emplace_back(w.first.second, w.second);
+		nodes[w.first.second].neighbours.emplace_back(w.first.first, w.second);
+	}
+
+	std::map<const parallel_region*, size_t> nodes_per_region;
+	for (const auto& node : nodes)
+		++nodes_per_region[node.region];
+	for (auto& node : nodes)
+	{
+		const auto measured = options.region_loads.find(node.region);
+		node.load = measured == options.region_loads.end()
+				? options.default_node_load
+				: measured->second / static_cast<double>(nodes_per_region[node.region]);
+	}
+	return nodes;
+}
+
+/// summed weight of the edges from node to each region.
+std::vector<double> connectivity(const node_info& node,
+		const std::vector<size_t>& assignment, size_t nr_of_regions)
+{
+	std::vector<double> result(nr_of_regions, 0.0);
+	for (const auto& neighbour : node.neighbours)
+		if (assignment[neighbour.first] < nr_of_regions)
+			result[assignment[neighbour.first]] += neighbour.second;
+	return result;
+}
+}
+
+region_proposal propose_regions(const connection_graph& graph, const partitioning_options& options)
+{
+	const auto k = options.nr_of_regions;
+	if (k == 0)
+		throw std::invalid_argument("propose_regions needs at least one region");
+
+	const auto nodes = collect_nodes(graph, options);
+	const auto total_load = std::accumulate(nodes.begin(), nodes.end(), 0.0,
+			[](double sum, const node_info& node) { return sum + node.load; });
+	double capacity = (1.0 + options.max_imbalance) * total_load / static_cast<double>(k);
+	for (const auto& node : nodes)
+		capacity = std::max(capacity, node.load);
+
+	// greedy placement, heaviest nodes first, unassigned nodes have region k.
+	std::vector<size_t> order(nodes.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(),
+			[&nodes](size_t l, size_t r) { return nodes[l].load > nodes[r].load; });
+	std::vector<size_t> assignment(nodes.size(), k);
+	std::vector<double> loads(k, 0.0);
+	for (const auto i : order)
+	{
+		const auto& node = nodes[i];
+		const auto conn = connectivity(node, assignment, k);
+		size_t best = 0;
+		for (size_t r = 1; r != k; ++r)
+		{
+			const bool fits = loads[r] + node.load <= capacity;
+			const bool best_fits = loads[best] + node.load <= capacity;
+			if (fits != best_fits)
+			{
+				if (fits)
+					best = r;
+			}
+			else if (fits ? (conn[r] > conn[best] ||
+						(conn[r] == conn[best] && loads[r] < loads[best]))
+					: loads[r] < loads[best])
+			{
+				best = r;
+			}
+		}
+		assignment[i] = best;
+		loads[best] += node.load;
+	}
+
+	// refinement, moves single nodes to the region they gain most.
+	for (size_t pass = 0; pass != options.max_refinement_passes; ++pass)
+	{
+		bool moved = false;
+		for (size_t i = 0; i != nodes.size(); ++i)
+		{
+			const auto& node = nodes[i];
+			const auto current = assignment[i];
+			const auto conn = connectivity(node, assignment, k);
+			auto best = current;
+			double best_gain = 0.0;
+			for (size_t r = 0; r != k; ++r)
+			{
+				if (r == current || loads[r] + node.load > capacity)
+					continue;
+				const auto gain = conn[r] - conn[current];
+				// moves without gain are only made if they improve the balance,
+				// which makes sure that refinement terminates.
+				const bool balances = gain == 0.0 && loads[r] + node.load < loads[current]
+						&& (best == current || loads[r] < loads[best]);
+				if (gain > best_gain || (best_gain == 0.0 && balances))
+				{
+					best = r;
+					best_gain = std::max(gain, 0.0);
+				}
+			}
+			if (best == current)
+				continue;
+			loads[current] -= node.load;
+			loads[best] += node.load;
+			assignment[i] = best;
+			moved = true;
+		}
+		if (!moved)
+			break;
+	}
+
+	region_proposal result;
+	result.loads = loads;
+	for (size_t i = 0; i != nodes.size(); ++i)
+	{
+		result.region_of_node.emplace(nodes[i].id, assignment[i]);
+		for (const auto& neighbour : nodes[i].neighbours)
+		{
+			if (neighbour.first < i)
+				continue;
+			if (assignment[neighbour.first] != assignment[i])
+				result.cut_weight += neighbour.second;
+			if (nodes[neighbour.first].region != nodes[i].region)
+				result.current_cut_weight += neighbour.second;
+		}
+	}
+	return result;
+}
+
+std::vector<cross_numa_edge> cross_numa_edges(const connection_graph& graph)
+{
+	const auto content = graph.changes_since(graph_version{});
+	const auto statistics = graph.statistics();
+	const auto numa_node = [](const graph_node_properties& node)
+	{
+		return node.region() ? node.region()->numa_node() : thread::any_numa_node;
+	};
+
+	std::vector<cross_numa_edge> result;
+	for (const auto& edge : content.new_edges)
+	{
+		const int source = numa_node(edge.source.node_properties);
+		const int sink = numa_node(edge.sink.node_properties);
+		if (source == thread::any_numa_node || sink == thread::any_numa_node || source == sink)
+			continue;
+		result.push_back(cross_numa_edge{edge, source, sink, edge_weight(edge, statistics)});
+	}
+	std::stable_sort(result.begin(), result.end(),
+			[](const cross_numa_edge& l, const cross_numa_edge& r) { return l.weight > r.weight; });
+	return result;
+}
+
+} // namespace graph
+} // namespace fc
@@ -0,0 +1,85 @@
+#ifndef SRC_GRAPH_PARTITIONING_HPP_
+#define SRC_GRAPH_PARTITIONING_HPP_
+
+#include <flexcore/extended/graph/graph.hpp>
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace fc
+{
+namespace graph
+{
+
+/// parameters of propose_regions.
+struct partitioning_options
+{
+	/// number of regions to propose, usually the number of threads of the scheduler.
+	size_t nr_of_regions = 1;
+	/// how much the load of a proposed region may exceed the mean load, 0.1 allows 10%.
+	double max_imbalance = 0.1;
+	/// maximum number of passes moving single nodes between regions.
+	size_t max_refinement_passes = 8;
+	/**
+	 * measured load of existing regions, for example the mean of
+	 * periodic_task::execution_time, which is split evenly between the nodes of the region.
+	 */
+	std::map<const parallel_region*, double> region_loads;
+	/// load of nodes in regions without a measured load.
+	double default_node_load = 1.0;
+};
+
+/// assignment of nodes to regions proposed by propose_regions.
+struct region_proposal
+{
+	/// index of the proposed region in [0, nr_of_regions) by id of node.
+	std::map<unique_id, size_t> region_of_node;
+	/// summed load of the nodes of each proposed region.
+	std::vector<double> loads;
+	/// summed weight of edges between nodes in different proposed regions.
+	double cut_weight = 0.0;
+	/// summed weight of edges between nodes in different regions of the current assignment.
+	double current_cut_weight = 0.0;
+};
+
+/**
+ * \brief proposes an assignment of the nodes of graph to regions.
+ *
+ * Edges crossing regions need buffers, thus the proposal minimizes the summed weight
+ * of edges between regions, while keeping the load of every region
+ * below (1 + max_imbalance) times the mean load.
+ * Edges weigh the bytes counted by the port_counters of their ports,
+ * edges without counters weigh one.
+ *
+ * Nodes are placed greedily, heaviest first, into the region they are connected to most,
+ * afterwards single nodes are moved as long as that reduces the cut.
+ * The result is a heuristic, not the optimal partitioning.
+ *
+ * \pre options.nr_of_regions > 0, throws std::invalid_argument otherwise.
+ */
+region_proposal propose_regions(const connection_graph& graph, const partitioning_options& options);
+
+/// edge between nodes of regions on different numa nodes, see cross_numa_edges.
+struct cross_numa_edge
+{
+	graph_edge edge;
+	int source_numa_node;
+	int sink_numa_node;
+	/// bytes counted by the port_counters of the ports of the edge, one without counters.
+	double weight;
+};
+
+/**
+ * \brief returns the edges of graph whose nodes are in regions on different numa nodes.
+ *
+ * Tokens sent along these edges cross the interconnect between the sockets.
+ * Edges to nodes in regions without numa node, see parallel_region::set_numa_node,
+ * are not reported. Sorted by descending weight, so the costliest edges come first.
+ */
+std::vector<cross_numa_edge> cross_numa_edges(const connection_graph& graph);
+
+} // namespace graph
+} // namespace fc
+
+#endif /* SRC_GRAPH_PARTITIONING_HPP_ */
@@ -21,6 +21,8 @@ public:
 	virtual graph::connection_graph& get_graph() = 0;
 	virtual std::shared_ptr<parallel_region> region() = 0;
 	virtual std::string name() const = 0;
+	/// returns the name of the node including its parents, by default its name.
+	virtual std::string full_name() const { return name(); }
 };
 } // namespace fc
 
@@ -0,0 +1,176 @@
+#ifndef SRC_NODES_ASYNC_NODE_HPP_
+#define SRC_NODES_ASYNC_NODE_HPP_
+
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/pure/event_sinks.hpp>
+#include <flexcore/scheduler/mpsc_queue.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+#include <flexcore/scheduler/scheduler.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace fc
+{
+
+/**
+ * \brief Node which runs blocking operations, like I/O, outside of its region.
+ *
+ * Every request received through in() is handed to operation, which is executed by
+ * a separate scheduler, usually a parallel_scheduler reserved for I/O.
+ * The worker of the region is thus not blocked while the operation runs,
+ * other regions on that worker keep running.
+ * Results are taken on the switch tick of the region after the operation completed
+ * and sent through out() on the following work tick, in the order of completion.
+ *
+ * At most max_in_flight operations run at once, further requests wait in the node
+ * and are started as soon as earlier operations completed.
+ * An exception thrown by operation is rethrown in the work tick of the region,
+ * after the results completed before it have been sent.
+ * Operations still running when the node is destroyed are finished, their results dropped.
+ *
+ * \tparam request_t type of requests, needs to be movable.
+ * \tparam result_t type of results, needs to be default constructible and movable.
+ * \ingroup nodes
+ */
+template<class request_t, class result_t>
+class async_node : public tree_base_node
+{
+public:
+	static constexpr auto default_name = "async_node";
+	using operation_t = std::function<result_t(request_t)>;
+
+	/**
+	 * \param operation executed for every request by io, needs to be thread safe,
+	 * if io runs more than one operation at once.
+	 * \param io scheduler executing operation, which needs to outlive the node.
+	 * \param max_in_flight maximum number of operations started but not yet taken back.
+	 * \pre max_in_flight > 0
+	 */
+	async_node(operation_t operation, thread::scheduler& io, size_t max_in_flight,
+			const node_args& node)
+		: tree_base_node(node)
+		, shared(std::make_shared<shared_state>(std::move(operation), max_in_flight))
+		, io(io)
+		, max_in_flight(max_in_flight)
+		, in_port(this, [this](request_t request) { receive(std::move(request)); })
+		, out_port(this)
+		, switch_tick([this]() { take_results(); })
+		, work_tick([this]() { send_results(); })
+	{
+		assert(max_in_flight > 0);
+		staged.reserve(shared->done.capacity());
+		region()->switch_tick() >> switch_tick;
+		region()->work_tick() >> work_tick;
+	}
+
+	/// Event in Port expecting requests, which start an operation each.
+	auto& in() noexcept { return in_port; }
+	/// Event out Port sending the results of the operations.
+	auto& out() noexcept { return out_port; }
+
+	/// returns the number of operations started, whose results were not taken yet.
+	size_t in_flight() const noexcept { return running; }
+	/// returns the number of requests waiting for an operation to complete.
+	size_t waiting_requests() const noexcept { return waiting.size(); }
+
+private:
+	struct completion
+	{
+		result_t result{};
+		std::exception_ptr error;
+	};
+
+	/// shared with running operations, which may outlive the node.
+	struct shared_state
+	{
+		shared_state(operation_t operation, size_t max_in_flight)
+			: operation(std::move(operation)), done(max_in_flight)
+		{
+		}
+		operation_t operation;
+		thread::mpsc_queue<completion> done;
+	};
+
+	void receive(request_t request)
+	{
+		if (running == max_in_flight)
+			waiting.push_back(std::move(request));
+		else
+			start(std::move(request));
+	}
+
+	void start(request_t request)
+	{
+		++running;
+		io.add_task([state = shared, request = std::move(request)]() mutable
+		{
+			completion c;
+			try
+			{
+				c.result = state->operation(std::move(request));
+			}
+			catch (...)
+			{
+				c.error = std::current_exception();
+			}
+			// the queue holds max_in_flight completions, the node never starts more.
+			const bool pushed = state->done.push(c);
+			assert(pushed);
+			(void)pushed;
+		});
+	}
+
+	void take_results()
+	{
+		completion c;
+		while (shared->done.pop(c))
+		{
+			--running;
+			if (c.error && !error)
+				error = c.error;
+			if (!c.error)
+				staged.push_back(std::move(c.result));
+		}
+		while (running != max_in_flight && !waiting.empty())
+		{
+			start(std::move(waiting.front()));
+			waiting.pop_front();
+		}
+	}
+
+	void send_results()
+	{
+		if (!staged.empty())
+		{
+			out_port.fire_batch_move(staged);
+			staged.clear();
+		}
+		if (error)
+			std::rethrow_exception(std::exchange(error, nullptr));
+	}
+
+	std::shared_ptr<shared_state> shared;
+	thread::scheduler& io;
+	const size_t max_in_flight;
+	/// number of operations started, whose completion has not been taken yet.
+	size_t running = 0;
+	std::deque<request_t> waiting;
+	/// results taken on the switch tick, sent on the work tick.
+	std::vector<result_t> staged;
+	std::exception_ptr error;
+	event_sink<request_t> in_port;
+	event_source<result_t> out_port;
+	pure::event_sink<void> switch_tick;
+	pure::event_sink<void> work_tick;
+};
+
+} // namespace fc
+
+#endif /* SRC_NODES_ASYNC_NODE_HPP_ */
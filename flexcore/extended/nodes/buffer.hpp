@@ -1,9 +1,19 @@
 #ifndef SRC_NODES_BUFFER_HPP_
 #define SRC_NODES_BUFFER_HPP_
 
+#include <flexcore/core/span.hpp>
 #include <flexcore/core/traits.hpp>
+#include <flexcore/scheduler/checkpoints.hpp>
+#include <flexcore/scheduler/memory_account.hpp>
 
 #include <boost/circular_buffer.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <memory>
 #include <vector>
 
 namespace fc
@@ -21,6 +31,18 @@ namespace detail
 {
 template<class data_t, template<class...> class container_t, class base_t>
 class base_event_to_state;
+
+/// memory account of the region of node, nullptr for nodes without region.
+template<class node_t>
+auto memory_account_of(node_t& node, int) -> decltype(node.region()->shared_memory_account())
+{
+	return node.region()->shared_memory_account();
+}
+template<class node_t>
+std::shared_ptr<thread::memory_account> memory_account_of(node_t&, long)
+{
+	return nullptr;
+}
 }
 /**
  * \brief Buffer that takes events and provides a range as state
@@ -53,6 +75,14 @@ struct swap_on_pull {};
  *
  * Sends the buffer as state when pulled.
  * inputs are made available on tick received at port swap_buffers.
+ *
+ * If the state is not read between swap ticks, the events of each cycle
+ * are kept as a separate segment, so a swap tick is O(1) independent of the backlog.
+ * Segments are joined when the state is pulled.
+ * The backlog can be limited, in which case the oldest elements are dropped.
+ * The memory of the buffers is charged to the region of the collector on swap ticks.
+ * While its account is over the soft limit, only the newest segment is kept
+ * and the spare memory is released.
  * \ingroup nodes
  */
 template<class data_t, class base_t>
@@ -60,40 +90,171 @@ class list_collector<data_t, swap_on_tick, base_t>
 		: public detail::base_event_to_state<data_t, std::vector, base_t>
 {
 public:
+	static constexpr size_t unlimited = std::numeric_limits<size_t>::max();
+
 	template<class... args_t>
 	explicit list_collector(args_t&&... args)
 		: detail::base_event_to_state<data_t, std::vector, base_t>{
 				[this]()
 				{
-					data_read = true;
+					join_segments();
 					return std::vector<data_t>(
 							this->buffer_state.begin(),
 							this->buffer_state.end());
 				},
 				std::forward<args_t>(args)...}
+		, view_port(this, [this]()
+				{
+					join_segments();
+					return span<const data_t>{this->buffer_state};
+				})
+		, backlog_port(this, [this]() { return backlog(); })
+		, memory(detail::memory_account_of(*this, 0))
 	{}
 
+	/**
+	 * \brief State out port providing a view of the buffer instead of a copy.
+	 *
+	 * Pulling it counts as reading the data, like out().
+	 * The view is valid until the next swap tick.
+	 * It must only be read within the region of the collector.
+	 */
+	auto& out_view() noexcept { return view_port; }
+	/// State out port providing the number of elements the next pull of out() returns.
+	auto& out_backlog() noexcept { return backlog_port; }
+
+	/**
+	 * \brief limits the number of elements kept while the state is not read.
+	 * \param max_elements maximum backlog, older elements are dropped on swap ticks.
+	 */
+	void limit_backlog(size_t max_elements) { max_backlog = max_elements; }
+	/// returns the total number of elements dropped because of the backlog limit.
+	size_t dropped_elements() const noexcept { return dropped; }
+
+	/// allocates memory for nr_of_elements collected per cycle, see thread::capacity_profile.
+	void reserve(size_t nr_of_elements)
+	{
+		this->buffer_collect->reserve(nr_of_elements);
+		this->buffer_state.reserve(nr_of_elements);
+		charge_memory();
+	}
+	/// returns the number of elements which can be collected in a cycle without allocating.
+	size_t capacity() const noexcept { return this->buffer_collect->capacity(); }
+
 	auto swap_buffers() noexcept
 	{
 		return [this]()
 		{
-			if (data_read) //move data from collect buffer to output, and clear collect buffer
+			if (data_read) // discard the data, which has been read.
 			{
 				this->buffer_state.clear();
-				this->buffer_state.swap(*this->buffer_collect);
 				data_read = false;
 			}
-			else //just move data from collect buffer to output buffer
+			if (this->buffer_collect->empty())
+				return;
+
+			// keep the collected data as a new segment and collect into a spare vector.
+			segments.emplace_back();
+			segments.back().swap(*this->buffer_collect);
+			segments_capacity += segments.back().capacity();
+			if (!spare_segments.empty())
 			{
-				this->buffer_state.insert(end(*this->buffer_collect),
-						begin(*this->buffer_collect), end(*this->buffer_collect));
-				this->buffer_collect->clear();
+				this->buffer_collect->swap(spare_segments.back());
+				spare_segments.pop_back();
+				segments_capacity -= this->buffer_collect->capacity();
 			}
+			segments_size += segments.back().size();
+			drop_oldest(max_backlog);
+			if (memory.over_soft_limit())
+				release_memory();
+			charge_memory();
 		};
 	}
 
 private:
+	size_t backlog() const noexcept { return this->buffer_state.size() + segments_size; }
+
+	/// appends all segments to buffer_state, keeping their memory for reuse.
+	void join_segments()
+	{
+		data_read = true;
+		for (auto& segment : segments)
+		{
+			this->buffer_state.insert(end(this->buffer_state),
+					std::make_move_iterator(begin(segment)), std::make_move_iterator(end(segment)));
+			recycle(segment);
+		}
+		segments.clear();
+		segments_size = 0;
+	}
+
+	void drop_oldest(size_t max_elements)
+	{
+		while (backlog() > max_elements)
+		{
+			const auto excess = backlog() - max_elements;
+			if (!this->buffer_state.empty())
+			{
+				const auto nr_dropped = std::min(excess, this->buffer_state.size());
+				this->buffer_state.erase(begin(this->buffer_state),
+						begin(this->buffer_state) + nr_dropped);
+				dropped += nr_dropped;
+				continue;
+			}
+			assert(!segments.empty());
+			auto& oldest = segments.front();
+			if (oldest.size() <= excess)
+			{
+				dropped += oldest.size();
+				segments_size -= oldest.size();
+				recycle(oldest);
+				segments.pop_front();
+			}
+			else
+			{
+				oldest.erase(begin(oldest), begin(oldest) + excess);
+				dropped += excess;
+				segments_size -= excess;
+			}
+		}
+	}
+
+	void recycle(std::vector<data_t>& segment)
+	{
+		segment.clear();
+		spare_segments.emplace_back();
+		spare_segments.back().swap(segment);
+	}
+
+	/// keeps only the newest segment and frees the spare vectors.
+	void release_memory()
+	{
+		drop_oldest(segments.empty() ? 0 : segments.back().size());
+		for (const auto& spare : spare_segments)
+			segments_capacity -= spare.capacity();
+		spare_segments.clear();
+		spare_segments.shrink_to_fit();
+	}
+
+	void charge_memory()
+	{
+		memory.update((segments_capacity + this->buffer_state.capacity()
+				+ this->buffer_collect->capacity()) * sizeof(data_t));
+	}
+
 	bool data_read = false;
+	/// data collected in cycles since the state has last been joined in buffer_state.
+	std::deque<std::vector<data_t>> segments;
+	size_t segments_size = 0;
+	/// cleared vectors, which keep their capacity for the next cycles.
+	std::vector<std::vector<data_t>> spare_segments;
+	/// capacity of all vectors in segments and spare_segments.
+	size_t segments_capacity = 0;
+	size_t max_backlog = unlimited;
+	size_t dropped = 0;
+	typename base_t::template state_source<span<const data_t>> view_port;
+	typename base_t::template state_source<size_t> backlog_port;
+	thread::memory_charge memory;
 };
 
 /**
@@ -114,17 +275,37 @@ public:
 					return this->get_state();
 				},
 				std::forward<args_t>(args)...}
+		, view_port(this, [this]()
+				{
+					swap_state();
+					return span<const data_t>{this->buffer_state};
+				})
 	{}
 
+	/**
+	 * \brief State out port providing a view of the buffer instead of a copy.
+	 *
+	 * Pulling it swaps the buffers like out().
+	 * The view is valid until the next pull of out() or out_view().
+	 * It must only be read within the region of the collector.
+	 */
+	auto& out_view() noexcept { return view_port; }
+
 private:
-	std::vector<data_t> get_state()
+	void swap_state()
 	{
 		this->buffer_state.clear();
 		this->buffer_state.swap(*this->buffer_collect);
+	}
+	std::vector<data_t> get_state()
+	{
+		swap_state();
 		return std::vector<data_t>(
 				this->buffer_state.begin(),
 				this->buffer_state.end());
 	}
+
+	typename base_t::template state_source<span<const data_t>> view_port;
 };
 
 namespace detail
@@ -144,6 +325,8 @@ struct collector
 		//check if the node owning the buffer has been deleted. which is a bug.
 		assert(buffer);
 		buffer->insert(end(*buffer), begin(range), end(range));
+		if (checkpoint)
+			checkpoint->mark_changed();
 	}
 
 	void operator()(const data_t& single_input)
@@ -151,9 +334,13 @@ struct collector
 		//check if the node owning the buffer has been deleted. which is a bug.
 		assert(buffer);
 		buffer->insert(end(*buffer), single_input);
+		if (checkpoint)
+			checkpoint->mark_changed();
 	}
 
 	container_t<data_t>* buffer; ///< non-owning access to the buffer of node.
+	/// marked on every input, if the node checkpoints the buffer.
+	checkpoint_handle* checkpoint = nullptr;
 };
 
 /**
@@ -224,7 +411,7 @@ public:
 	explicit hold_last(const data_t& initial_value, args_t&&... args)
 		: base_t(std::forward<args_t>(args)...)
 		, storage(initial_value)
-		, in_port{this, [this](data_t in){ storage = in; }}
+		, in_port{this, [this](data_t in){ storage = in; checkpointed.mark_changed(); }}
 		, out_port{this,[this](){ return storage;} }
 	{
 	}
@@ -233,10 +420,26 @@ public:
 	auto& in() { return in_port; }
 	/// State out port supplying data_t.
 	auto& out() { return out_port; }
+
+	/**
+	 * \brief writes the stored value to the checkpoints of the region, see region_checkpoints.
+	 *
+	 * Restores the value from the checkpoint file right away, if it has one under key.
+	 * Does nothing if the region has no checkpoints enabled.
+	 * \tparam archive_t archive serializing data_t, fixed_layout or a Cereal binary archive.
+	 * \param key of the value in the file, the full name of the node by default.
+	 */
+	template<class archive_t = fixed_layout>
+	void checkpoint(std::string key = {})
+	{
+		checkpointed = detail::checkpoint_node<archive_t>(*this, std::move(key), storage);
+	}
 private:
 	data_t storage;
 	typename base_t::template event_sink<data_t> in_port;
 	typename base_t::template state_source<data_t> out_port;
+	/// declared last, so it is removed before storage.
+	checkpoint_handle checkpointed;
 };
 
 /**
@@ -244,6 +447,7 @@ private:
  *
  * hold_n accepts events of data_t and ranges of data_t as inputs
  * and stores them in a circular buffer.
+ * The capacity of the buffer is charged to the region of the node.
  *
  * \tparam data_t type of data stored in buffer
  * \invariant capacity of buffer is > 0.
@@ -275,6 +479,16 @@ public:
 							storage->begin(),
 							storage->end());
 				} )
+		, view_port(this,
+				[this]()
+				{
+					const auto& buffer = *storage;
+					const auto one = buffer.array_one();
+					const auto two = buffer.array_two();
+					return segmented_span<const data_t>{
+							{one.first, one.second}, {two.first, two.second}};
+				} )
+		, memory(detail::memory_account_of(*this, 0), capacity * sizeof(data_t))
 		{
 			assert(capacity > 0); //precondition
 			assert(storage->capacity() > 0); //invariant
@@ -285,13 +499,56 @@ public:
 	{
 		using collector = detail::collector<data_t, boost::circular_buffer>;
 
-		return typename base_t::template mixin<collector>{this, collector{storage.get()}};
+		return typename base_t::template mixin<collector>{
+				this, collector{storage.get(), &checkpointed}};
 	}
 	/// State out port supplying range of data_t.
 	auto& out() noexcept { return out_port; }
+	/**
+	 * \brief State out port supplying a view of the buffer, oldest element first.
+	 *
+	 * The view is valid until the next event is received.
+	 * It must only be read within the region of the buffer.
+	 */
+	auto& out_view() noexcept { return view_port; }
+
+	/**
+	 * \brief writes the buffer to the checkpoints of the region, see region_checkpoints.
+	 *
+	 * The buffer is written oldest element first, like out provides it.
+	 * If the checkpoint file has a buffer under key, it is restored right away,
+	 * keeping the newest elements if it holds more than the capacity.
+	 * Does nothing if the region has no checkpoints enabled.
+	 * \tparam archive_t archive serializing std::vector<data_t>.
+	 * \param key of the buffer in the file, the full name of the node by default.
+	 */
+	template<class archive_t = fixed_layout>
+	void checkpoint(std::string key = {})
+	{
+		using codec_t = detail::checkpoint_codec<std::vector<data_t>, archive_t>;
+		auto codec = std::make_shared<codec_t>();
+		// keeps its capacity, thus only the first checkpoints allocate.
+		auto scratch = std::make_shared<std::vector<data_t>>();
+		checkpointed = detail::checkpoint_node(*this, std::move(key),
+				[this, codec, scratch]()
+				{
+					scratch->assign(storage->begin(), storage->end());
+					return codec->serialize(*scratch);
+				},
+				[this, codec](const_byte_span bytes)
+				{
+					const auto restored = codec->restore(bytes);
+					storage->clear();
+					storage->insert(storage->end(), restored.begin(), restored.end());
+				});
+	}
 private:
 	std::unique_ptr<buffer_t> storage;
 	typename base_t::template state_source<std::vector<data_t>> out_port;
+	typename base_t::template state_source<segmented_span<const data_t>> view_port;
+	thread::memory_charge memory;
+	/// declared last, so it is removed before storage.
+	checkpoint_handle checkpointed;
 };
 
 }  // namespace fc
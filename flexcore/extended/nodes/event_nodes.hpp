@@ -5,8 +5,8 @@
 #include <flexcore/pure/event_sinks.hpp>
 #include <flexcore/pure/event_sources.hpp>
 #include <flexcore/pure/pure_node.hpp>
+#include <flexcore/utils/key_routing.hpp>
 
-#include <map>
 #include <utility>
 
 namespace fc
@@ -85,7 +85,11 @@ private:
 /**
  * \brief Forwards events if and only if the state at in_control is true.
  *
- * State sink in_control must be connected when events are received!
+ * State sink in_control must be connected when events are received,
+ * unless the gate is latched.
+ * Connect latch_tick() to a tick to pull in_control only once per tick,
+ * or send the control to in_control_event(). Once latched,
+ * the gate keeps the last value and no longer pulls in_control per event.
  *
  * \tparam event_t type of event expected and forwarded
  * \ingroup nodes
@@ -99,18 +103,36 @@ public:
 		generic_event_node<event_t, event_t, base_t>(
 				[this](auto&&... in)
 				{
-					if (control.get())
+					if (latched ? open : control.get())
 						this->out_port.fire(std::forward<decltype(in)>(in)...);
 				},
 				std::forward<base_args>(args)...),
-			control(this)
+			control(this),
+			control_event(this, [this](bool o){ latch(o); })
 	{
 	}
 	/// State sink expecting bool. Events are forwarded if this state is true.
 	auto& in_control() noexcept { return control; }
+	/// Event sink expecting bool, latches the gate open or closed.
+	auto& in_control_event() noexcept { return control_event; }
+
+	/// Event input port expects event of type void, pulls in_control once for all following events.
+	auto latch_tick()
+	{
+		return [this]() { latch(control.get()); };
+	}
 
 private:
+	void latch(bool o) noexcept
+	{
+		open = o;
+		latched = true;
+	}
+
 	typename base_t::template state_sink<bool> control;
+	typename base_t::template event_sink<bool> control_event;
+	bool latched = false;
+	bool open = false;
 };
 
 /// Creates gate_with_predicate with predicate p of type event_t.
@@ -133,12 +155,15 @@ auto gate()
  * pair_splitter has one output port per key.
  * On incoming std::pair<key_t, data_t> it sends the second element of the pair
  * out on the output port corresponding to the first element (the key).
+ * Events with keys no output port has been requested for are dropped.
  * \tparam data_t type of event expected and forwarded
  * \tparam key_t type of key used in pair, needs to provide operator <
+ * \tparam routing how ports are looked up by key,
+ * one of ordered_keys, hashed_keys or dense_keys.
  * \ingroup nodes
  * \see pair_joiner
  */
-template<class key_t, class data_t, class base = pure::pure_node>
+template<class key_t, class data_t, class base = pure::pure_node, class routing = ordered_keys>
 class pair_splitter : public base
 {
 public:
@@ -151,7 +176,8 @@ public:
 		in_port{this,
 			[this](const std::pair<key_t, data_t>& in)
 			{
-				this->out(in.first).fire(in.second);
+				if (auto* port = out_ports.find(in.first))
+					port->fire(in.second);
 			}},
 		out_ports{}
 	{
@@ -163,14 +189,13 @@ public:
 	/// event_source sending data_t
 	out_port_t& out(const key_t& key)
 	{
-		auto it = out_ports.find(key);
-		if (it == out_ports.end())
-			it = out_ports.insert(std::make_pair(key, out_port_t{this})).first;
-		return it->second;
+		if (auto* existing = out_ports.find(key))
+			return *existing;
+		return out_ports.emplace(key, out_port_t{this});
 	}
 private:
 	in_port_t in_port;
-	std::map<key_t, out_port_t> out_ports;
+	detail::key_map<routing, key_t, out_port_t> out_ports;
 };
 
 /**
@@ -179,10 +204,12 @@ private:
  * On incoming data on port key it sends a std::pair<key_t, data_t> as output.
  * \tparam data_t type of event expected and forwarded
  * \tparam key_t type of key used in pair, needs to provide operator <
+ * \tparam routing how ports are looked up by key,
+ * one of ordered_keys, hashed_keys or dense_keys.
  * \ingroup nodes
  * \see pair_splitter
  */
-template<class key_t, class data_t, class base = pure::pure_node>
+template<class key_t, class data_t, class base = pure::pure_node, class routing = ordered_keys>
 class pair_joiner : public base
 {
 public:
@@ -197,16 +224,13 @@ public:
 	///event_sink expecing data_t
 	auto& in(const key_t& id)
 	{
+		if (auto* existing = in_ports.find(id))
+			return *existing;
+
 		auto fire_pair = [this, id](data_t input){
 			out_port.fire(std::make_pair(id, input));
 		};
-
-		auto it = in_ports.find(id);
-		if (it == in_ports.end())
-			it = in_ports.insert(
-					std::make_pair(id, in_port_t{this,fire_pair})
-					).first;
-		return it->second;
+		return in_ports.emplace(id, in_port_t{this, fire_pair});
 	}
 
 	///event_source sending std::pair<key_t, data_t>
@@ -216,7 +240,7 @@ public:
 	using out_port_t = typename base::template event_source<std::pair<key_t, data_t>>;
 private:
 
-	std::map<key_t, in_port_t> in_ports;
+	detail::key_map<routing, key_t, in_port_t> in_ports;
 	out_port_t out_port;
 };
 
@@ -0,0 +1,98 @@
+#ifndef SRC_NODES_EXTERNAL_EVENT_SOURCE_HPP_
+#define SRC_NODES_EXTERNAL_EVENT_SOURCE_HPP_
+
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/pure/event_sinks.hpp>
+#include <flexcore/scheduler/mpsc_queue.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace fc
+{
+
+/**
+ * \brief Node which injects events from threads outside of flexcore into its region.
+ *
+ * Any thread, for example one reading from a socket or driver, can push events.
+ * They are queued in a lock-free mpsc_queue, taken from it on the switch tick
+ * of the region and sent through out() on the next work tick of the region.
+ * Thus events pushed during a cycle are available in the following cycle,
+ * like events passed through a buffer between regions.
+ *
+ * The queue is bounded, events pushed into a full queue are dropped and counted.
+ *
+ * \tparam data_t type of events, needs to be default constructible and movable.
+ * \ingroup nodes
+ */
+template<class data_t>
+class external_event_source : public tree_base_node
+{
+public:
+	static constexpr auto default_name = "external_event_source";
+
+	/**
+	 * \param capacity maximum number of events queued between two switch ticks,
+	 * rounded up to a power of two.
+	 * \pre capacity > 0
+	 */
+	external_event_source(size_t capacity, const node_args& node)
+		: tree_base_node(node)
+		, queue(capacity)
+		, out_port(this)
+		, switch_tick([this]() { take_events(); })
+		, work_tick([this]() { send_events(); })
+	{
+		staged.reserve(queue.capacity());
+		region()->switch_tick() >> switch_tick;
+		region()->work_tick() >> work_tick;
+	}
+
+	/**
+	 * \brief queues event to be sent in the region, can be called from any thread.
+	 * \returns false if the queue is full and event has been dropped.
+	 */
+	bool push(data_t event)
+	{
+		if (queue.push(event))
+			return true;
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	/// Event out Port sending the pushed events in the region of the node.
+	auto& out() noexcept { return out_port; }
+
+	/// returns the number of events dropped because the queue was full.
+	size_t dropped_events() const noexcept { return dropped.load(std::memory_order_relaxed); }
+
+private:
+	void take_events()
+	{
+		data_t event{};
+		while (staged.size() < queue.capacity() && queue.pop(event))
+			staged.push_back(std::move(event));
+	}
+
+	void send_events()
+	{
+		if (staged.empty())
+			return;
+		out_port.fire_batch_move(staged);
+		staged.clear();
+	}
+
+	thread::mpsc_queue<data_t> queue;
+	/// events taken from the queue on the switch tick, sent on the work tick.
+	std::vector<data_t> staged;
+	std::atomic<size_t> dropped{0};
+	event_source<data_t> out_port;
+	pure::event_sink<void> switch_tick;
+	pure::event_sink<void> work_tick;
+};
+
+} // namespace fc
+
+#endif /* SRC_NODES_EXTERNAL_EVENT_SOURCE_HPP_ */
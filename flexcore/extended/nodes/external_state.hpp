@@ -0,0 +1,74 @@
+#ifndef SRC_NODES_EXTERNAL_STATE_HPP_
+#define SRC_NODES_EXTERNAL_STATE_HPP_
+
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/extended/nodes/state_nodes.hpp>
+#include <flexcore/pure/event_sinks.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+#include <flexcore/scheduler/seqlock.hpp>
+
+namespace fc
+{
+
+/**
+ * \brief Node which provides state published by threads outside of flexcore to its region.
+ *
+ * Any thread, for example one polling a device, can publish values.
+ * They are stored in a seqlock, thus publishing never waits for the region
+ * and the region never waits for a publisher.
+ * On the switch tick of the region the latest value is copied from the seqlock,
+ * all pulls of out() during the following cycle see this copy,
+ * thus reads in the cycle are consistent and do not touch shared memory.
+ *
+ * \tparam data_t type of the state, needs to be trivially copyable.
+ * \ingroup nodes
+ */
+template<class data_t>
+class external_state : public tree_base_node
+{
+public:
+	static constexpr auto default_name = "external_state";
+
+	explicit external_state(const node_args& node)
+		: external_state(data_t{}, node)
+	{
+	}
+
+	/// \param initial_value value of the state until the first publish.
+	external_state(const data_t& initial_value, const node_args& node)
+		: tree_base_node(node)
+		, shared(initial_value)
+		, current(initial_value)
+		, out_port(this, [this]() -> const data_t& { return current; })
+		, version_port(this, [this]() { return current_version; })
+		, switch_tick([this]() { take_value(); })
+	{
+		region()->switch_tick() >> switch_tick;
+	}
+
+	/// replaces the state visible from the next cycle on, can be called from any thread.
+	void publish(const data_t& value) noexcept { shared.store(value); }
+
+	/// State out Port providing the value taken on the last switch tick.
+	auto& out() noexcept { return out_port; }
+	/// State out Port providing the number of publishes visible in out().
+	auto& version_out() noexcept { return version_port; }
+
+private:
+	void take_value()
+	{
+		if (shared.version() != current_version)
+			current_version = shared.load_into(current);
+	}
+
+	thread::seqlock<data_t> shared;
+	data_t current;
+	state_version_t current_version = 0;
+	state_source<const data_t&> out_port;
+	state_source<state_version_t> version_port;
+	pure::event_sink<void> switch_tick;
+};
+
+} // namespace fc
+
+#endif /* SRC_NODES_EXTERNAL_STATE_HPP_ */
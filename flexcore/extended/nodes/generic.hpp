@@ -7,9 +7,15 @@
 #include <flexcore/pure/pure_node.hpp>
 #include <flexcore/extended/base_node.hpp>
 #include <flexcore/extended/nodes/region_worker_node.hpp>
+#include <flexcore/utils/key_routing.hpp>
 
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <stdexcept>
 #include <utility>
-#include <map>
+#include <vector>
 
 namespace fc
 {
@@ -22,33 +28,44 @@ namespace fc
  * to a state source of a type convertible to key_t.
  * is specialized for state and events, as the implementations differ.
  *
+ * By default the control is pulled on every event or pull of out().
+ * Connect latch_tick() to a tick, usually the switch tick of the region,
+ * to pull it only once per tick and keep the selected port until the next one.
+ * Alternatively send keys to control_event(), the switch then keeps the last key received.
+ * Once latched, selecting the port costs a single compare per event.
+ *
  * \tparam data_t type of data flowing through the switch
  * \tparam tag either event_tag or state_tag to set switch to event handling
  * or forwarding of state
  *
  * \tparam key_t key for lookup of inputs in switch. needs to have operator < and ==
+ * \tparam routing how ports are looked up by key,
+ * one of ordered_keys, hashed_keys or dense_keys.
  * \ingroup nodes
  */
 template<class data_t,
 		class tag,
 		class key_t = size_t,
-		class base_node = tree_base_node
+		class base_node = tree_base_node,
+		class routing = ordered_keys
 		> class n_ary_switch;
 
-template<class data_t, class key_t, class base_node>
-class n_ary_switch<data_t, state_tag, key_t, base_node> : public base_node
+template<class data_t, class key_t, class base_node, class routing>
+class n_ary_switch<data_t, state_tag, key_t, base_node, routing> : public base_node
 {
 public:
 	template<class... base_args>
 	explicit n_ary_switch(base_args&&... args)
 		: base_node(std::forward<base_args>(args)...)
 		, switch_state(this)
+		, switch_event(this, [this](const key_t& key){ latch(key); })
 		, in_ports()
-		, out_port(this, [this](){return in_ports.at(switch_state.get()).get();} )
+		, out_port(this, [this](){ return selected_port().get(); } )
 	{}
 
 	using data_sink_t = typename base_node::template state_sink<data_t>;
 	using key_sink_t = typename base_node::template state_sink<key_t>;
+	using key_event_sink_t = typename base_node::template event_sink<key_t>;
 	using state_source_t = typename base_node::template state_source<data_t>;
 
 	/**
@@ -58,31 +75,65 @@ public:
 	 * \param port key by which port is identified.
 	 * \post !in_ports.empty()
 	 */
-	auto& in(key_t port) noexcept
+	auto& in(key_t port)
 	{
-		auto it = in_ports.find(port);
-		if (it == in_ports.end())
-			it = in_ports.emplace(std::make_pair(port,
-					data_sink_t{this})).first;
-		return it->second;
+		if (auto* existing = in_ports.find(port))
+			return *existing;
+		auto& created = in_ports.emplace(port, data_sink_t{this});
+		if (latched && port == latched_key)
+			latched_port = &created;
+		return created;
 	}
 	/// parameter port controlling the switch, expects state of key_t
 	auto& control() noexcept { return switch_state; }
 	auto& out() noexcept { return out_port; }
+
+	/// event port controlling the switch, selects the port of the received key.
+	auto& control_event() noexcept { return switch_event; }
+
+	/// Event input port expects event of type void, pulls control and keeps the selected port.
+	auto latch_tick()
+	{
+		return [this]() { latch(switch_state.get()); };
+	}
+
 private:
+	void latch(const key_t& key)
+	{
+		latched_key = key;
+		latched_port = in_ports.find(latched_key);
+		latched = true;
+	}
+
+	/// \throws std::out_of_range if no port exists for the key of control.
+	data_sink_t& selected_port()
+	{
+		if (latched && latched_port)
+			return *latched_port;
+		auto* port = in_ports.find(latched ? latched_key : switch_state.get());
+		if (!port)
+			throw std::out_of_range("n_ary_switch has no port for the key of control");
+		return *port;
+	}
+
 	/// provides the current state of the switch.
 	key_sink_t switch_state;
-	std::map<key_t, data_sink_t> in_ports;
+	key_event_sink_t switch_event;
+	detail::key_map<routing, key_t, data_sink_t> in_ports;
 	state_source_t out_port;
+	bool latched = false;
+	key_t latched_key{};
+	data_sink_t* latched_port = nullptr;
 };
 
 /// partial specialization of n_ary_switch for events
-template<class data_t, class key_t, class base_node>
-class n_ary_switch<data_t, event_tag, key_t, base_node> : public base_node
+template<class data_t, class key_t, class base_node, class routing>
+class n_ary_switch<data_t, event_tag, key_t, base_node, routing> : public base_node
 {
 public:
 	using data_sink_t = typename base_node::template event_sink<data_t>;
 	using key_sink_t = typename base_node::template state_sink<key_t>;
+	using key_event_sink_t = typename base_node::template event_sink<key_t>;
 	using event_source_t = typename base_node::template event_source<data_t>;
 
 
@@ -90,6 +141,7 @@ public:
 	explicit n_ary_switch(base_args&&... args)
 		: base_node(std::forward<base_args>(args)...)
 		, switch_state(this)
+		, switch_event(this, [this](const key_t& key){ latch(key); })
 		, out_port(this)
 		, in_ports()
 	{}
@@ -103,18 +155,11 @@ public:
 	 */
 	auto& in(key_t port)
 	{
-		auto it = in_ports.find(port);
-		if (it == end(in_ports))
-		{
-			it = in_ports.emplace(std::make_pair
-				(	port,
-					data_sink_t( this,
-							[this, port](const data_t& in){ forward_call(in, port); })
-				)
-			).first;
-		} //else the port already exists, we can just return it
-
-		return it->second;
+		if (auto* existing = in_ports.find(port))
+			return *existing;
+		return in_ports.emplace(port,
+				data_sink_t( this,
+						[this, port](const data_t& in){ forward_call(in, port); }));
 	}
 
 	/// output port of events of type data_t.
@@ -122,18 +167,36 @@ public:
 	/// parameter port controlling the switch, expects state of key_t
 	auto& control() noexcept { return switch_state; }
 
+	/// event port controlling the switch, forwards events of the port of the received key.
+	auto& control_event() noexcept { return switch_event; }
+
+	/// Event input port expects event of type void, pulls control once for all following events.
+	auto latch_tick()
+	{
+		return [this]() { latch(switch_state.get()); };
+	}
 
 private:
+	void latch(const key_t& key)
+	{
+		latched_key = key;
+		latched = true;
+	}
+
 	key_sink_t switch_state;
+	key_event_sink_t switch_event;
 	event_source_t out_port;
-	std::map<key_t, data_sink_t> in_ports;
+	detail::key_map<routing, key_t, data_sink_t> in_ports;
+	bool latched = false;
+	key_t latched_key{};
+
 	/// fires incoming event if and only if it is from the currently chosen port.
-	void forward_call(data_t event, key_t port)
+	void forward_call(const data_t& event, const key_t& port)
 	{
 		assert(!in_ports.empty());
-		assert(in_ports.find(port) != end(in_ports));
+		assert(in_ports.find(port) != nullptr);
 
-		if (port == switch_state.get())
+		if (port == (latched ? latched_key : switch_state.get()))
 			out().fire(event);
 	}
 };
@@ -257,6 +320,96 @@ private:
 
 };
 
+/**
+ * \brief Watches many states against thresholds in a single work tick handler.
+ *
+ * Every watch consists of a state sink and a threshold.
+ * On every work tick of the region, all states are pulled into one array
+ * and compared to the array of thresholds in a single pass,
+ * which compilers can vectorize for arithmetic types.
+ * Triggered watches are sent together as pairs of their index and value.
+ * Use pair_splitter with dense_keys to route them to separate ports.
+ *
+ * \tparam data_t type of the watched states and thresholds.
+ * \tparam compare_t binary predicate taking value and threshold,
+ * a watch triggers if it returns true.
+ * \ingroup nodes
+ */
+template<class data_t, class compare_t = std::greater<data_t>>
+class watch_bank final : public fc::region_worker_node
+{
+public:
+	using event_t = std::pair<size_t, data_t>;
+
+	explicit watch_bank(const node_args& args)
+		: watch_bank(compare_t{}, args)
+	{
+	}
+
+	watch_bank(compare_t compare, const node_args& args)
+		: region_worker_node([this](){ check(); }, args)
+		, compare(std::move(compare))
+		, out_port{this}
+	{
+	}
+
+	watch_bank(const watch_bank&) = delete;
+	watch_bank(watch_bank&&) = delete;
+
+	/// adds a watch with threshold, \returns its index.
+	size_t add(data_t threshold)
+	{
+		thresholds.push_back(std::move(threshold));
+		in_ports.emplace_back(this);
+		values.resize(thresholds.size());
+		triggered.resize(thresholds.size());
+		return thresholds.size() - 1;
+	}
+
+	/// State input port of the watch with index, expects data_t.
+	auto& in(size_t index) { return in_ports.at(index); }
+
+	void set_threshold(size_t index, data_t threshold) { thresholds.at(index) = std::move(threshold); }
+	const data_t& threshold(size_t index) const { return thresholds.at(index); }
+
+	/// number of watches.
+	size_t size() const noexcept { return thresholds.size(); }
+
+	/// Event Output port, fires pairs of index and value of triggered watches.
+	auto& out() noexcept { return out_port; }
+
+private:
+	void check()
+	{
+		const auto n = thresholds.size();
+		for (size_t i = 0; i != n; ++i)
+			values[i] = in_ports[i].get();
+
+		const data_t* v = values.data();
+		const data_t* t = thresholds.data();
+		uint8_t* hit = triggered.data();
+		for (size_t i = 0; i != n; ++i)
+			hit[i] = compare(v[i], t[i]);
+
+		for (size_t i = 0; i != n; ++i)
+			if (hit[i])
+				events.emplace_back(i, values[i]);
+		if (events.empty())
+			return;
+		out_port.fire_batch_move(events);
+		events.clear();
+	}
+
+	compare_t compare;
+	std::vector<data_t> thresholds;
+	std::vector<data_t> values;
+	std::vector<uint8_t> triggered;
+	std::vector<event_t> events;
+	// ports need stable addresses, as connections refer to them.
+	std::deque<fc::state_sink<data_t>> in_ports;
+	fc::event_source<event_t> out_port;
+};
+
 }  // namespace fc
 
 #endif /* SRC_NODES_GENERIC_HPP_ */
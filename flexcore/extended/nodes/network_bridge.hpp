@@ -0,0 +1,571 @@
+#ifndef SRC_NODES_NETWORK_BRIDGE_HPP_
+#define SRC_NODES_NETWORK_BRIDGE_HPP_
+
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/extended/nodes/state_nodes.hpp>
+#include <flexcore/extended/ports/connection_buffer.hpp>
+#include <flexcore/pure/event_sinks.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+#include <flexcore/utils/network/bridge_link.hpp>
+#include <flexcore/utils/serialisation/deserializer.hpp>
+#include <flexcore/utils/serialisation/serializer.hpp>
+
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fc
+{
+
+namespace detail
+{
+/// receives all waiting frames of a link and passes their events to handle_event.
+template<class handler_t>
+void receive_frames(net::udp_receiver& socket, net::frame_reader& reader,
+		std::vector<char>& datagram, net::link_counters& counters,
+		uint64_t& next_sequence, handler_t&& handle_event)
+{
+	while (socket.receive(datagram))
+	{
+		const auto received = wall_clock::system::now();
+		if (!reader.parse(const_byte_span{datagram.data(), datagram.size()}))
+		{
+			counters.count_dropped();
+			continue;
+		}
+		// late frames are delivered, but do not count as lost twice.
+		if (reader.sequence() > next_sequence)
+			counters.count_lost(reader.sequence() - next_sequence);
+		if (reader.sequence() >= next_sequence)
+			next_sequence = reader.sequence() + 1;
+		counters.count_frame(reader.size(), datagram.size());
+		counters.record_latency(std::chrono::duration_cast<wall_clock::steady::duration>(
+				received - reader.send_time()));
+
+		const_byte_span event;
+		size_t decoded = 0;
+		while (reader.next(event))
+		{
+			++decoded;
+			try
+			{
+				handle_event(event, reader.sequence());
+			}
+			catch (const std::exception&)
+			{
+				counters.count_dropped();
+			}
+		}
+		if (decoded < reader.size())
+			counters.count_dropped(reader.size() - decoded);
+	}
+}
+
+/// first byte of the frames of state_delta_bridge_sender.
+enum class state_frame : char { full = 0, patch = 1 };
+} // namespace detail
+
+/**
+ * \brief Node which sends the events it receives to an event_bridge_receiver on another machine.
+ *
+ * Events are serialized as they arrive and collected in a frame.
+ * On the switch tick of the region, all events of the cycle are sent in a single UDP datagram,
+ * or several if they exceed bridge_config::max_frame_size.
+ * Events larger than a frame and frames the socket does not accept right away are dropped
+ * and counted, sending never blocks the region.
+ *
+ * \tparam data_t type of events.
+ * \tparam archive_t archive used to serialize events, fixed_layout copies them bytewise.
+ * \ingroup nodes
+ */
+template<class data_t, class archive_t = fixed_layout>
+class event_bridge_sender : public tree_base_node
+{
+public:
+	static constexpr auto default_name = "event_bridge_sender";
+
+	event_bridge_sender(const std::string& host, uint16_t port, const node_args& node)
+		: event_bridge_sender(host, port, net::bridge_config{}, node)
+	{
+	}
+
+	/// \throws std::system_error if host cannot be resolved.
+	event_bridge_sender(const std::string& host, uint16_t port,
+			const net::bridge_config& config, const node_args& node)
+		: tree_base_node(node)
+		, socket(host, port)
+		, writer(config)
+		, in_port(this, [this](const data_t& event) { add(event); })
+		, switch_tick([this]() { flush(); })
+	{
+		region()->switch_tick() >> switch_tick;
+	}
+
+	/// Event sink of the events to send.
+	auto& in() noexcept { return in_port; }
+
+	/// counters of the sent frames and events, latency is measured by the receiver.
+	net::link_statistics statistics() const noexcept { return counters.snapshot(); }
+
+private:
+	void add(const data_t& event)
+	{
+		const auto bytes = serializer(event);
+		if (!writer.fits_empty(bytes.size))
+		{
+			counters.count_dropped();
+			return;
+		}
+		if (!writer.fits(bytes.size))
+			flush();
+		writer.add(bytes);
+	}
+
+	void flush()
+	{
+		if (writer.empty())
+			return;
+		const auto nr_of_events = writer.size();
+		const auto frame = writer.finish(sequence++);
+		if (socket.send(frame))
+			counters.count_frame(nr_of_events, frame.size);
+		else
+			counters.count_dropped(nr_of_events);
+	}
+
+	net::udp_sender socket;
+	net::frame_writer writer;
+	net::link_counters counters;
+	uint64_t sequence = 0;
+	buffered_serializer<data_t, archive_t> serializer;
+	event_sink<data_t> in_port;
+	pure::event_sink<void> switch_tick;
+};
+
+/**
+ * \brief Node which sends the events of event_bridge_senders on other machines in its region.
+ *
+ * Like external_event_source, datagrams are received on the switch tick of the region
+ * and their events sent through out() in a single batch on the next work tick.
+ * Datagrams which are no valid frames and events which cannot be deserialized
+ * are dropped and counted, gaps in the sequence of frames are counted as lost.
+ *
+ * \tparam data_t type of events.
+ * \tparam archive_t archive used to deserialize events, needs to match the one of the sender.
+ * \ingroup nodes
+ */
+template<class data_t, class archive_t = fixed_layout>
+class event_bridge_receiver : public tree_base_node
+{
+public:
+	static constexpr auto default_name = "event_bridge_receiver";
+
+	/**
+	 * \param port UDP port to listen on, zero picks a free one.
+	 * \throws std::system_error if the port cannot be bound.
+	 */
+	event_bridge_receiver(uint16_t port, const node_args& node)
+		: tree_base_node(node)
+		, socket(port)
+		, out_port(this)
+		, switch_tick([this]() { take_events(); })
+		, work_tick([this]() { send_events(); })
+	{
+		region()->switch_tick() >> switch_tick;
+		region()->work_tick() >> work_tick;
+	}
+
+	/// Event out Port sending the received events in the region of the node.
+	auto& out() noexcept { return out_port; }
+
+	/// counters of the received frames and events including their latency.
+	net::link_statistics statistics() const noexcept { return counters.snapshot(); }
+
+	/// UDP port the node listens on.
+	uint16_t port() const noexcept { return socket.port(); }
+
+private:
+	void take_events()
+	{
+		detail::receive_frames(socket, reader, datagram, counters, next_sequence,
+				[this](const_byte_span event, uint64_t)
+				{
+					staged.push_back(deserializer(event));
+				});
+	}
+
+	void send_events()
+	{
+		if (staged.empty())
+			return;
+		out_port.fire_batch_move(staged);
+		staged.clear();
+	}
+
+	net::udp_receiver socket;
+	net::frame_reader reader;
+	net::link_counters counters;
+	std::vector<char> datagram;
+	uint64_t next_sequence = 0;
+	span_deserializer<data_t, archive_t> deserializer;
+	std::vector<data_t> staged;
+	event_source<data_t> out_port;
+	pure::event_sink<void> switch_tick;
+	pure::event_sink<void> work_tick;
+};
+
+/**
+ * \brief Node which provides its state to a state_bridge_receiver on another machine.
+ *
+ * On every switch tick of the region, the node pulls in() and sends the value
+ * in a frame of its own.
+ *
+ * \tparam data_t type of the state.
+ * \tparam archive_t archive used to serialize the state, fixed_layout copies it bytewise.
+ * \ingroup nodes
+ */
+template<class data_t, class archive_t = fixed_layout>
+class state_bridge_sender : public tree_base_node
+{
+public:
+	static constexpr auto default_name = "state_bridge_sender";
+
+	state_bridge_sender(const std::string& host, uint16_t port, const node_args& node)
+		: state_bridge_sender(host, port, net::bridge_config{}, node)
+	{
+	}
+
+	/// \throws std::system_error if host cannot be resolved.
+	state_bridge_sender(const std::string& host, uint16_t port,
+			const net::bridge_config& config, const node_args& node)
+		: tree_base_node(node)
+		, socket(host, port)
+		, writer(config)
+		, in_port(this)
+		, switch_tick([this]() { send(); })
+	{
+		region()->switch_tick() >> switch_tick;
+	}
+
+	/// State sink pulled on every switch tick.
+	auto& in() noexcept { return in_port; }
+
+	/// counters of the sent frames, latency is measured by the receiver.
+	net::link_statistics statistics() const noexcept { return counters.snapshot(); }
+
+private:
+	void send()
+	{
+		const auto bytes = serializer(in_port.get());
+		if (!writer.fits_empty(bytes.size))
+		{
+			counters.count_dropped();
+			return;
+		}
+		writer.add(bytes);
+		const auto frame = writer.finish(sequence++);
+		if (socket.send(frame))
+			counters.count_frame(1, frame.size);
+		else
+			counters.count_dropped();
+	}
+
+	net::udp_sender socket;
+	net::frame_writer writer;
+	net::link_counters counters;
+	uint64_t sequence = 0;
+	buffered_serializer<data_t, archive_t> serializer;
+	state_sink<data_t> in_port;
+	pure::event_sink<void> switch_tick;
+};
+
+/**
+ * \brief Node which provides the state of a state_bridge_sender on another machine.
+ *
+ * Like external_state, the newest received value is taken on the switch tick of the region,
+ * all pulls of out() during the following cycle see this copy.
+ * Values older than the current one, by sequence of their frames, are ignored.
+ * Until the first value arrives, out() provides the initial value.
+ *
+ * \tparam data_t type of the state.
+ * \tparam archive_t archive used to deserialize the state, needs to match the one of the sender.
+ * \ingroup nodes
+ */
+template<class data_t, class archive_t = fixed_layout>
+class state_bridge_receiver : public tree_base_node
+{
+public:
+	static constexpr auto default_name = "state_bridge_receiver";
+
+	/**
+	 * \param port UDP port to listen on, zero picks a free one.
+	 * \throws std::system_error if the port cannot be bound.
+	 */
+	state_bridge_receiver(uint16_t port, const node_args& node)
+		: state_bridge_receiver(port, data_t(), node)
+	{
+	}
+
+	state_bridge_receiver(uint16_t port, data_t initial, const node_args& node)
+		: tree_base_node(node)
+		, socket(port)
+		, current(std::move(initial))
+		, out_port(this, [this]() -> const data_t& { return current; })
+		, version_port(this, [this]() { return current_version; })
+		, switch_tick([this]() { take_value(); })
+	{
+		region()->switch_tick() >> switch_tick;
+	}
+
+	/// State out Port providing the value taken on the last switch tick.
+	auto& out() noexcept { return out_port; }
+	/// State out Port providing the number of values taken so far.
+	auto& version_out() noexcept { return version_port; }
+
+	/// counters of the received frames including their latency.
+	net::link_statistics statistics() const noexcept { return counters.snapshot(); }
+
+	/// UDP port the node listens on.
+	uint16_t port() const noexcept { return socket.port(); }
+
+private:
+	void take_value()
+	{
+		detail::receive_frames(socket, reader, datagram, counters, next_sequence,
+				[this](const_byte_span value, uint64_t sequence)
+				{
+					if (current_version != 0 && sequence <= newest_sequence)
+						return;
+					current = deserializer(value);
+					newest_sequence = sequence;
+					++current_version;
+				});
+	}
+
+	net::udp_receiver socket;
+	net::frame_reader reader;
+	net::link_counters counters;
+	std::vector<char> datagram;
+	uint64_t next_sequence = 0;
+	uint64_t newest_sequence = 0;
+	span_deserializer<data_t, archive_t> deserializer;
+	data_t current;
+	state_version_t current_version = 0;
+	state_source<const data_t&> out_port;
+	state_source<state_version_t> version_port;
+	pure::event_sink<void> switch_tick;
+};
+
+/**
+ * \brief Node which sends the changes of its state to a state_delta_bridge_receiver.
+ *
+ * Like state_bridge_sender, in() is pulled on every switch tick and sent in a frame of its own.
+ * Instead of the full state, frames carry a patch against the previous state, see state_delta.
+ * Every keyframe_interval frames, and whenever a patch does not fit a frame,
+ * the full state is sent, from which the receiver recovers after lost frames.
+ *
+ * \tparam data_t type of the state, state_delta needs to be specialized for it.
+ * \tparam archive_t archive used to serialize states and patches.
+ * \ingroup nodes
+ */
+template<class data_t, class archive_t = fixed_layout>
+class state_delta_bridge_sender : public tree_base_node
+{
+	using delta_t = state_delta<data_t>;
+	using patch_t = typename delta_t::patch_t;
+public:
+	static constexpr auto default_name = "state_delta_bridge_sender";
+	static constexpr size_t default_keyframe_interval = 100;
+
+	state_delta_bridge_sender(const std::string& host, uint16_t port, const node_args& node)
+		: state_delta_bridge_sender(host, port, net::bridge_config{},
+				default_keyframe_interval, node)
+	{
+	}
+
+	/**
+	 * \param keyframe_interval number of frames after which the full state is sent again.
+	 * \throws std::system_error if host cannot be resolved.
+	 */
+	state_delta_bridge_sender(const std::string& host, uint16_t port,
+			const net::bridge_config& config, size_t keyframe_interval, const node_args& node)
+		: tree_base_node(node)
+		, socket(host, port)
+		, writer(config)
+		, keyframe_interval(keyframe_interval)
+		, in_port(this)
+		, switch_tick([this]() { send(); })
+	{
+		region()->switch_tick() >> switch_tick;
+	}
+
+	/// State sink pulled on every switch tick.
+	auto& in() noexcept { return in_port; }
+
+	/// counters of the sent frames, latency is measured by the receiver.
+	net::link_statistics statistics() const noexcept { return counters.snapshot(); }
+
+private:
+	void send()
+	{
+		const auto& state = in_port.get();
+		if (sent && frames_since_keyframe + 1 < keyframe_interval)
+		{
+			auto patch = delta_t::diff(*sent, state);
+			delta_t::patch(*sent, patch);
+			if (send_frame(detail::state_frame::patch, patch_serializer(patch)))
+			{
+				++frames_since_keyframe;
+				return;
+			}
+		}
+		const auto bytes = state_serializer(state);
+		if (!send_frame(detail::state_frame::full, bytes))
+		{
+			counters.count_dropped();
+			return;
+		}
+		frames_since_keyframe = 0;
+		if (sent)
+			*sent = state;
+		else
+			sent = std::make_unique<data_t>(state);
+	}
+
+	/// returns false if the message does not fit a frame, failed sends count as dropped.
+	bool send_frame(detail::state_frame kind, const_byte_span bytes)
+	{
+		message.assign(1, static_cast<char>(kind));
+		message.insert(message.end(), bytes.begin(), bytes.end());
+		if (!writer.fits_empty(message.size()))
+			return false;
+		writer.add(const_byte_span{message.data(), message.size()});
+		const auto frame = writer.finish(sequence++);
+		if (socket.send(frame))
+			counters.count_frame(1, frame.size);
+		else
+			counters.count_dropped();
+		return true;
+	}
+
+	net::udp_sender socket;
+	net::frame_writer writer;
+	net::link_counters counters;
+	uint64_t sequence = 0;
+	const size_t keyframe_interval;
+	size_t frames_since_keyframe = 0;
+	/// state as known by a receiver, which got all frames.
+	std::unique_ptr<data_t> sent;
+	std::vector<char> message;
+	buffered_serializer<data_t, archive_t> state_serializer;
+	buffered_serializer<patch_t, archive_t> patch_serializer;
+	state_sink<data_t> in_port;
+	pure::event_sink<void> switch_tick;
+};
+
+template<class data_t, class archive_t>
+constexpr size_t state_delta_bridge_sender<data_t, archive_t>::default_keyframe_interval;
+
+/**
+ * \brief Node which provides the state of a state_delta_bridge_sender on another machine.
+ *
+ * Like state_bridge_receiver, received frames are taken on the switch tick of the region,
+ * all pulls of out() during the following cycle see the same copy.
+ * Patches are applied to this copy if they directly follow the last applied frame,
+ * after a lost frame, patches are dropped until the next full state arrives.
+ *
+ * \tparam data_t type of the state, state_delta needs to be specialized for it.
+ * \tparam archive_t archive used to deserialize, needs to match the one of the sender.
+ * \ingroup nodes
+ */
+template<class data_t, class archive_t = fixed_layout>
+class state_delta_bridge_receiver : public tree_base_node
+{
+	using delta_t = state_delta<data_t>;
+	using patch_t = typename delta_t::patch_t;
+public:
+	static constexpr auto default_name = "state_delta_bridge_receiver";
+
+	/**
+	 * \param port UDP port to listen on, zero picks a free one.
+	 * \throws std::system_error if the port cannot be bound.
+	 */
+	state_delta_bridge_receiver(uint16_t port, const node_args& node)
+		: state_delta_bridge_receiver(port, data_t(), node)
+	{
+	}
+
+	state_delta_bridge_receiver(uint16_t port, data_t initial, const node_args& node)
+		: tree_base_node(node)
+		, socket(port)
+		, current(std::move(initial))
+		, out_port(this, [this]() -> const data_t& { return current; })
+		, version_port(this, [this]() { return current_version; })
+		, switch_tick([this]() { take_changes(); })
+	{
+		region()->switch_tick() >> switch_tick;
+	}
+
+	/// State out Port providing the state as of the last switch tick.
+	auto& out() noexcept { return out_port; }
+	/// State out Port providing the number of frames applied so far.
+	auto& version_out() noexcept { return version_port; }
+
+	/// counters of the received frames including their latency.
+	net::link_statistics statistics() const noexcept { return counters.snapshot(); }
+
+	/// UDP port the node listens on.
+	uint16_t port() const noexcept { return socket.port(); }
+
+private:
+	void take_changes()
+	{
+		detail::receive_frames(socket, reader, datagram, counters, next_sequence,
+				[this](const_byte_span message, uint64_t sequence)
+				{
+					if (message.empty())
+					{
+						counters.count_dropped();
+						return;
+					}
+					const auto kind = static_cast<detail::state_frame>(message.data[0]);
+					const const_byte_span bytes{message.data + 1, message.size - 1};
+					if (kind == detail::state_frame::patch)
+					{
+						// patches only apply to the frame directly before them.
+						if (current_version == 0 || sequence != newest_sequence + 1)
+						{
+							counters.count_dropped();
+							return;
+						}
+						delta_t::patch(current, patch_deserializer(bytes));
+					}
+					else if (current_version == 0 || sequence > newest_sequence)
+						current = state_deserializer(bytes);
+					else
+						return;
+					newest_sequence = sequence;
+					++current_version;
+				});
+	}
+
+	net::udp_receiver socket;
+	net::frame_reader reader;
+	net::link_counters counters;
+	std::vector<char> datagram;
+	uint64_t next_sequence = 0;
+	uint64_t newest_sequence = 0;
+	span_deserializer<data_t, archive_t> state_deserializer;
+	span_deserializer<patch_t, archive_t> patch_deserializer;
+	data_t current;
+	state_version_t current_version = 0;
+	state_source<const data_t&> out_port;
+	state_source<state_version_t> version_port;
+	pure::event_sink<void> switch_tick;
+};
+
+} // namespace fc
+
+#endif /* SRC_NODES_NETWORK_BRIDGE_HPP_ */
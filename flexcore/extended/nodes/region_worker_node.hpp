@@ -20,6 +20,10 @@ namespace fc
  *
  * region_worker_node is a convenient way to have nodes automatically work on work tick.
  * Extend this class for your own worker nodes.
+ * Actions are added to the work_groups of the region, actions of all nodes of the
+ * same type run together in one loop. The action is removed when the node is destroyed.
+ * The node owns its worker, so graph::run_components_in_parallel can find its component,
+ * and profiles of the work_groups show the worker by the full name of the node.
  * \ingroup nodes
  */
 class region_worker_node : public tree_base_node
@@ -28,10 +32,13 @@ public:
 	template <class action_t>
 	region_worker_node(action_t&& action, const node_args& node)
 	    : tree_base_node(node)
+	    , worker(region()->add_worker(std::forward<action_t>(action),
+	    		static_cast<const tree_base_node*>(this), full_name()))
 	{
-		region()->work_tick() >> std::forward<action_t>(action);
 	}
 
+private:
+	worker_handle worker;
 };
 
 
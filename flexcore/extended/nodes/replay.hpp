@@ -0,0 +1,148 @@
+#ifndef SRC_NODES_REPLAY_HPP_
+#define SRC_NODES_REPLAY_HPP_
+
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/pure/event_sinks.hpp>
+#include <flexcore/scheduler/clock.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+#include <flexcore/utils/serialisation/deserializer.hpp>
+#include <flexcore/utils/serialisation/replay_log.hpp>
+#include <flexcore/utils/serialisation/serializer.hpp>
+
+#include <string>
+
+namespace fc
+{
+
+/**
+ * \brief Node which records the events it receives into a replay log file.
+ *
+ * Every event is serialized with buffered_serializer and stored
+ * with the time of the virtual steady clock of its region at which it arrived.
+ * Replay the file with event_replay_source.
+ *
+ * \tparam data_t type of events.
+ * \tparam archive_t archive used to serialize events, fixed_layout copies them bytewise.
+ * \ingroup nodes
+ */
+template<class data_t, class archive_t = fixed_layout>
+class event_recorder : public tree_base_node
+{
+public:
+	static constexpr auto default_name = "event_recorder";
+
+	/// creates the replay log at path, replacing an existing file.
+	event_recorder(const std::string& path, const node_args& node)
+		: event_recorder(path, replay_log_writer::default_chunk_size, node)
+	{
+	}
+
+	event_recorder(const std::string& path, size_t chunk_size, const node_args& node)
+		: tree_base_node(node)
+		, log(path, chunk_size)
+		, clock(region()->clock())
+		, in_port(this, [this](const data_t& event)
+				{
+					log.append(clock.steady_now(), serializer(event));
+				})
+	{
+	}
+
+	/// Event sink of the events to record.
+	auto& in() noexcept { return in_port; }
+
+	/// number of events recorded so far.
+	size_t size() const noexcept { return log.size(); }
+
+private:
+	replay_log_writer log;
+	/// kept alive by the region.
+	const clock_domain& clock;
+	buffered_serializer<data_t, archive_t> serializer;
+	event_sink<data_t> in_port;
+};
+
+/**
+ * \brief Node which sends the events of a replay log at the times they were recorded.
+ *
+ * On every work tick of its region, the node sends all events recorded up to
+ * the current time of the clock of its region, shifted by the offset set with play_from.
+ * Events are read from the memory mapped file in place,
+ * with fixed_layout and afap_main_loop replay is only bound by copying the events.
+ *
+ * seek and play_from must not be called concurrently to the work tick of the region.
+ *
+ * \tparam data_t type of events.
+ * \tparam archive_t archive used to deserialize events, needs to match the one of the recorder.
+ * \ingroup nodes
+ */
+template<class data_t, class archive_t = fixed_layout>
+class event_replay_source : public tree_base_node
+{
+public:
+	static constexpr auto default_name = "event_replay_source";
+
+	/// opens the replay log at path, replay starts with the first event.
+	event_replay_source(const std::string& path, const node_args& node)
+		: tree_base_node(node)
+		, log(path)
+		, next(log.begin())
+		, clock(region()->clock())
+		, out_port(this)
+		, work_tick([this]() { send_due_events(); })
+	{
+		region()->work_tick() >> work_tick;
+	}
+
+	/// continues the replay with the first event recorded at or after time.
+	void seek(virtual_clock::steady::time_point time)
+	{
+		next = log.seek(time);
+	}
+
+	/**
+	 * \brief replays the events recorded from time on, starting now.
+	 * Events are shifted by the difference between now and time.
+	 */
+	void play_from(virtual_clock::steady::time_point time)
+	{
+		seek(time);
+		offset = clock.steady_now() - time;
+	}
+
+	/// returns true if all events of the log have been sent.
+	bool done() const
+	{
+		auto pos = next;
+		replay_record record;
+		return !log.read(pos, record);
+	}
+
+	/// Event source sending the recorded events.
+	auto& out() noexcept { return out_port; }
+
+private:
+	void send_due_events()
+	{
+		const auto now = clock.steady_now();
+		auto pos = next;
+		replay_record record;
+		while (log.read(pos, record) && record.time + offset <= now)
+		{
+			next = pos;
+			out_port.fire(deserializer(record.bytes));
+		}
+	}
+
+	replay_log_reader log;
+	replay_log_reader::position next;
+	const clock_domain& clock;
+	virtual_clock::steady::duration offset{0};
+	span_deserializer<data_t, archive_t> deserializer;
+	event_source<data_t> out_port;
+	pure::event_sink<void> work_tick;
+};
+
+} // namespace fc
+
+#endif /* SRC_NODES_REPLAY_HPP_ */
@@ -0,0 +1,298 @@
+#ifndef SRC_NODES_SHARED_MEMORY_HPP_
+#define SRC_NODES_SHARED_MEMORY_HPP_
+
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/extended/nodes/state_nodes.hpp>
+#include <flexcore/pure/event_sinks.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+#include <flexcore/scheduler/seqlock.hpp>
+#include <flexcore/scheduler/shared_memory.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fc
+{
+
+namespace detail
+{
+/// describes the content of a segment, written by the publisher before anything else.
+struct shared_port_header
+{
+	enum class kind : uint32_t { events = 1, state = 2 };
+
+	/// set by the publisher once the payload is constructed.
+	std::atomic<uint32_t> ready;
+	kind content;
+	uint64_t type_size;
+};
+
+/// offset of the queue or seqlock in the segment, keeps it on its own cache lines.
+constexpr size_t shared_payload_offset = 64;
+static_assert(sizeof(shared_port_header) <= shared_payload_offset, "");
+
+/// constructs the header in segment, the caller constructs the payload and calls publish.
+template<class data_t>
+shared_port_header& create_shared_header(thread::shared_segment& segment,
+		shared_port_header::kind content)
+{
+	static_assert(alignof(data_t) <= shared_payload_offset,
+			"alignment of data_t is not supported in shared memory.");
+	auto* header = new (segment.data()) shared_port_header{};
+	header->content = content;
+	header->type_size = sizeof(data_t);
+	return *header;
+}
+
+/// \throws std::runtime_error if segment was not published for data_t and content.
+template<class data_t>
+void* open_shared_payload(thread::shared_segment& segment, shared_port_header::kind content)
+{
+	if (segment.size() < shared_payload_offset)
+		throw std::runtime_error("shared memory segment is not ready");
+	auto& header = *static_cast<shared_port_header*>(segment.data());
+	if (header.ready.load(std::memory_order_acquire) != 1)
+		throw std::runtime_error("shared memory segment is not ready");
+	if (header.content != content || header.type_size != sizeof(data_t))
+		throw std::runtime_error("shared memory segment holds a different type");
+	return static_cast<char*>(segment.data()) + shared_payload_offset;
+}
+
+inline void* shared_payload(thread::shared_segment& segment)
+{
+	return static_cast<char*>(segment.data()) + shared_payload_offset;
+}
+} // namespace detail
+
+/**
+ * \brief Node which sends the events it receives to a shared_event_subscriber in another process.
+ *
+ * Events are copied into a lock-free single producer single consumer queue
+ * in a posix shared memory segment, no serialization is involved.
+ * The node creates the segment, it needs to be constructed before the subscriber.
+ * Events received while the queue is full are dropped and counted.
+ *
+ * \tparam data_t type of events, needs to be trivially copyable
+ * and must have the same layout in both processes.
+ * \ingroup nodes
+ */
+template<class data_t>
+class shared_event_publisher : public tree_base_node
+{
+	using ring_t = thread::spsc_ring<data_t>;
+public:
+	static constexpr auto default_name = "shared_event_publisher";
+
+	/**
+	 * \param segment_name name of the shared memory segment, needs to start with a slash.
+	 * \param capacity maximum number of queued events, rounded up to a power of two.
+	 */
+	shared_event_publisher(const std::string& segment_name, size_t capacity, const node_args& node)
+		: tree_base_node(node)
+		, segment(segment_name, detail::shared_payload_offset
+				+ ring_t::bytes_needed(thread::round_up_to_power_of_two(capacity)))
+		, ring(create_ring(thread::round_up_to_power_of_two(capacity)))
+		, in_port(this, [this](const data_t& event)
+				{
+					if (!ring.push(event))
+						dropped.fetch_add(1, std::memory_order_relaxed);
+				})
+	{
+	}
+
+	/// Event sink of the events to send.
+	auto& in() noexcept { return in_port; }
+
+	/// returns the number of events dropped because the queue was full.
+	size_t dropped_events() const noexcept { return dropped.load(std::memory_order_relaxed); }
+
+private:
+	ring_t& create_ring(size_t capacity)
+	{
+		auto& header = detail::create_shared_header<data_t>(
+				segment, detail::shared_port_header::kind::events);
+		auto* r = new (detail::shared_payload(segment)) ring_t(capacity);
+		header.ready.store(1, std::memory_order_release);
+		return *r;
+	}
+
+	thread::shared_segment segment;
+	ring_t& ring;
+	std::atomic<size_t> dropped{0};
+	event_sink<data_t> in_port;
+};
+
+/**
+ * \brief Node which sends the events of a shared_event_publisher in another process in its region.
+ *
+ * Like external_event_source, events are taken from the queue on the switch tick
+ * of the region and sent through out() on the next work tick.
+ *
+ * \tparam data_t type of events, needs to match the one of the publisher.
+ * \ingroup nodes
+ */
+template<class data_t>
+class shared_event_subscriber : public tree_base_node
+{
+	using ring_t = thread::spsc_ring<data_t>;
+public:
+	static constexpr auto default_name = "shared_event_subscriber";
+
+	/**
+	 * \param segment_name name of the segment created by the publisher.
+	 * \throws std::system_error if the segment does not exist,
+	 * std::runtime_error if it does not hold events of data_t.
+	 */
+	shared_event_subscriber(const std::string& segment_name, const node_args& node)
+		: tree_base_node(node)
+		, segment(segment_name)
+		, ring(*static_cast<ring_t*>(detail::open_shared_payload<data_t>(
+				segment, detail::shared_port_header::kind::events)))
+		, out_port(this)
+		, switch_tick([this]() { take_events(); })
+		, work_tick([this]() { send_events(); })
+	{
+		staged.reserve(ring.capacity());
+		region()->switch_tick() >> switch_tick;
+		region()->work_tick() >> work_tick;
+	}
+
+	/// Event out Port sending the published events in the region of the node.
+	auto& out() noexcept { return out_port; }
+
+private:
+	void take_events()
+	{
+		data_t event;
+		while (staged.size() < ring.capacity() && ring.pop(event))
+			staged.push_back(event);
+	}
+
+	void send_events()
+	{
+		if (staged.empty())
+			return;
+		out_port.fire_batch_move(staged);
+		staged.clear();
+	}
+
+	thread::shared_segment segment;
+	ring_t& ring;
+	std::vector<data_t> staged;
+	event_source<data_t> out_port;
+	pure::event_sink<void> switch_tick;
+	pure::event_sink<void> work_tick;
+};
+
+/**
+ * \brief Node which provides its state to a shared_state_subscriber in another process.
+ *
+ * On every work tick of its region, the node pulls in() and stores the value
+ * in a seqlock in a posix shared memory segment.
+ * The value is copied once into the segment and once out of it by the subscriber,
+ * no serialization is involved and the processes never wait for each other.
+ * The node creates the segment, it needs to be constructed before the subscriber.
+ *
+ * \tparam data_t type of the state, needs to be trivially copyable
+ * and must have the same layout in both processes.
+ * \ingroup nodes
+ */
+template<class data_t>
+class shared_state_publisher : public tree_base_node
+{
+	using slot_t = thread::seqlock<data_t>;
+public:
+	static constexpr auto default_name = "shared_state_publisher";
+
+	/// \param segment_name name of the shared memory segment, needs to start with a slash.
+	shared_state_publisher(const std::string& segment_name, const node_args& node)
+		: tree_base_node(node)
+		, segment(segment_name, detail::shared_payload_offset + sizeof(slot_t))
+		, slot(create_slot())
+		, in_port(this)
+		, work_tick([this]() { slot.store(in_port.get()); })
+	{
+		region()->work_tick() >> work_tick;
+	}
+
+	/// State sink pulled on every work tick.
+	auto& in() noexcept { return in_port; }
+
+private:
+	slot_t& create_slot()
+	{
+		auto& header = detail::create_shared_header<data_t>(
+				segment, detail::shared_port_header::kind::state);
+		auto* s = new (detail::shared_payload(segment)) slot_t();
+		header.ready.store(1, std::memory_order_release);
+		return *s;
+	}
+
+	thread::shared_segment segment;
+	slot_t& slot;
+	state_sink<data_t> in_port;
+	pure::event_sink<void> work_tick;
+};
+
+/**
+ * \brief Node which provides the state of a shared_state_publisher in another process.
+ *
+ * Like external_state, the latest value is copied from the segment on the switch tick
+ * of the region, all pulls of out() during the following cycle see this copy.
+ *
+ * \tparam data_t type of the state, needs to match the one of the publisher.
+ * \ingroup nodes
+ */
+template<class data_t>
+class shared_state_subscriber : public tree_base_node
+{
+	using slot_t = thread::seqlock<data_t>;
+public:
+	static constexpr auto default_name = "shared_state_subscriber";
+
+	/**
+	 * \param segment_name name of the segment created by the publisher.
+	 * \throws std::system_error if the segment does not exist,
+	 * std::runtime_error if it does not hold a state of data_t.
+	 */
+	shared_state_subscriber(const std::string& segment_name, const node_args& node)
+		: tree_base_node(node)
+		, segment(segment_name)
+		, slot(*static_cast<slot_t*>(detail::open_shared_payload<data_t>(
+				segment, detail::shared_port_header::kind::state)))
+		, current()
+		, out_port(this, [this]() -> const data_t& { return current; })
+		, version_port(this, [this]() { return current_version; })
+		, switch_tick([this]() { take_value(); })
+	{
+		region()->switch_tick() >> switch_tick;
+	}
+
+	/// State out Port providing the value taken on the last switch tick.
+	auto& out() noexcept { return out_port; }
+	/// State out Port providing the number of values stored by the publisher visible in out().
+	auto& version_out() noexcept { return version_port; }
+
+private:
+	void take_value()
+	{
+		if (slot.version() != current_version)
+			current_version = slot.load_into(current);
+	}
+
+	thread::shared_segment segment;
+	slot_t& slot;
+	data_t current;
+	state_version_t current_version = 0;
+	state_source<const data_t&> out_port;
+	state_source<state_version_t> version_port;
+	pure::event_sink<void> switch_tick;
+};
+
+} // namespace fc
+
+#endif /* SRC_NODES_SHARED_MEMORY_HPP_ */
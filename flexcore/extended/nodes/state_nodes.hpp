@@ -3,16 +3,22 @@
 
 #include <flexcore/core/traits.hpp>
 #include <flexcore/core/tuple_meta.hpp>
+#include <flexcore/extended/ports/change_notifier.hpp>
 #include <flexcore/extended/ports/node_aware.hpp>
 #include <flexcore/pure/mux_ports.hpp>
 #include <flexcore/extended/base_node.hpp>
 #include <flexcore/pure/pure_node.hpp>
 #include <flexcore/extended/nodes/region_worker_node.hpp>
+#include <flexcore/range/parallel_actions.hpp>
+#include <flexcore/scheduler/clock.hpp>
 
+#include <deque>
 #include <utility>
 #include <tuple>
+#include <vector>
 #include <memory>
 #include <cstddef>
+#include <cstdint>
 
 namespace fc
 {
@@ -39,10 +45,68 @@ struct merge_node;
 
 namespace detail
 {
-auto as_ref = [](auto& sink)
+struct as_ref
 {
-	return std::ref(sink);
+	template<class sink_t>
+	auto operator()(sink_t& sink) const
+	{
+		return std::ref(sink);
+	}
+};
+
+/**
+ * \brief stores a value computed at the current time of a virtual clock.
+ *
+ * The virtual clock advances once per cycle of cycle_control,
+ * thus the value is computed at most once per cycle.
+ * Copies start without a value.
+ */
+template<class T>
+class tick_memo
+{
+public:
+	/// \param clock clock distinguishing the ticks, needs to outlive the memo.
+	explicit tick_memo(const clock_domain& clock = *clock_domain::global()) : clock(&clock) {}
+	tick_memo(const tick_memo& other) : clock(other.clock) {}
+	tick_memo(tick_memo&&) = default;
+	tick_memo& operator=(const tick_memo& other)
+	{
+		value.reset();
+		clock = other.clock;
+		return *this;
+	}
+	tick_memo& operator=(tick_memo&&) = default;
+
+	/// returns the value of this tick, calls compute if there is none.
+	template<class compute_t>
+	const T& get(compute_t&& compute)
+	{
+		const auto now = clock->steady_now();
+		if (!value)
+			value = std::make_unique<T>(compute());
+		else if (now != computed_at)
+			*value = compute();
+		computed_at = now;
+		return *value;
+	}
+
+private:
+	const clock_domain* clock;
+	std::unique_ptr<T> value;
+	virtual_clock::steady::time_point computed_at{};
 };
+
+/// clock of the region of node, the global clock for nodes without region.
+template<class node_t>
+auto clock_of(node_t& node, int) -> decltype(node.region()->clock())
+{
+	return node.region()->clock();
+}
+template<class node_t>
+const clock_domain& clock_of(node_t&, long)
+{
+	return *clock_domain::global();
+}
 }
 
 template<class operation, class result, class... args, class base_t>
@@ -50,7 +114,7 @@ struct merge_node<operation, result (args...), base_t> : public base_t
 {
 	using arguments = std::tuple<args...>;
 	template <typename arg>
-	using base_sink_t = typename base_t::template state_sink<arg>;
+	using base_sink_t = reactive_state_sink<typename base_t::template state_sink<arg>>;
 	using result_t = result ;
 
 	using in_ports_t = std::tuple<base_sink_t<args>...>;
@@ -63,33 +127,81 @@ struct merge_node<operation, result (args...), base_t> : public base_t
 	template<class... ctr_args_t>
 	explicit merge_node(operation o, ctr_args_t&&... ctr_args)
 		: base_t(std::forward<ctr_args_t>(ctr_args)...)
-		, in_ports(base_sink_t<args>(this)...)
+		, notifier(std::make_shared<change_notifier>())
+		, in_ports(base_sink_t<args>(notifier, this)...)
 		, op(o)
+		, memo(detail::clock_of(*this, 0))
 	{}
 
 	///calls all in ports, converts their results from tuple to varargs and calls operation
 	result_t operator()()
 	{
-		auto op = this->op;
-		auto get_and_apply = [op](auto&&... sink)
-		{
-			return op(std::forward<decltype(sink)>(sink).get()...);
-		};
-		return tuple::invoke_function(get_and_apply, in_ports);
+		if (memoize)
+			return memo.get([this]() { return merge(); });
+		return merge();
 	}
 
+	/**
+	 * \brief merges inputs at most once per cycle, if enabled.
+	 *
+	 * Further pulls in the same cycle return the stored result,
+	 * thus diamond shaped graphs of states evaluate each merge only once.
+	 * Cycles are distinguished by the virtual clock, which is advanced by cycle_control.
+	 */
+	void memoize_per_tick(bool enabled = true) noexcept { memoize = enabled; }
+
+	/**
+	 * \brief pulls all inputs concurrently on pool, which is useful for expensive inputs.
+	 *
+	 * The calling thread pulls the inputs no worker of pool has started,
+	 * and applies the operation once all are pulled, see state_sink::async_get.
+	 * All sources connected to the inputs need to be safe to pull concurrently.
+	 * \param pool scheduler to pull on, nullptr pulls the inputs one after the other.
+	 */
+	void pull_in_parallel(thread::scheduler* pool) noexcept { parallel = pool; }
+
 	/// State Sink corresponding to i-th argument of merge operation.
 	template<size_t i>
 	auto& in() noexcept { return std::get<i>(in_ports); }
 
 	mux_port<base_sink_t<args>&...> mux() noexcept
 	{
-		return {tuple::transform(in_ports, detail::as_ref)};
+		return {tuple::transform(in_ports, detail::as_ref{})};
 	}
 
+	/// passes on the changes of the inputs to caches pulling from the merge_node.
+	change_notifier& changes() noexcept { return *notifier; }
+
 protected:
+	result_t merge()
+	{
+		if (parallel && nr_of_arguments > 1)
+			return merge_parallel();
+		auto op = this->op;
+		auto get_and_apply = [op](auto&&... sink)
+		{
+			return op(std::forward<decltype(sink)>(sink).get()...);
+		};
+		return tuple::invoke_function(get_and_apply, in_ports);
+	}
+
+	result_t merge_parallel()
+	{
+		auto pool = parallel;
+		auto futures = tuple::transform(in_ports,
+				[pool](auto& sink) { return sink.async_get(*pool); });
+		auto op = this->op;
+		return tuple::invoke_function(
+				[op](auto&... future) { return op(future.get()...); }, futures);
+	}
+
+	/// shared with the inputs, which keep it when the merge_node is moved.
+	std::shared_ptr<change_notifier> notifier;
 	in_ports_t in_ports;
 	operation op;
+	thread::scheduler* parallel = nullptr;
+	bool memoize = false;
+	detail::tick_memo<result_t> memo;
 };
 
 /**
@@ -121,10 +233,24 @@ auto make_merge(operation op)
 	return node_t{op};
 }
 
+namespace detail
+{
+template<class container_t>
+auto reserve_if_possible(container_t& c, size_t n) -> decltype(c.reserve(n))
+{
+	return c.reserve(n);
+}
+template<class container_t>
+void reserve_if_possible(container_t&, ...) {}
+}
+
 /**
  * \brief Merges inputs combining incoming elements to a range of elements.
  *
  * Incoming ranges will thus be converted to a range of ranges.
+ * The output is merged into a buffer, which keeps its memory between pulls.
+ * out_ref() lends this buffer, out() copies it.
+ * Inputs can optionally be pulled in parallel, see pull_in_parallel.
  *
  * \tparam data_t type of data flowing through node.
  * \tparam out_container_t type of range used as output. Default is std::vector
@@ -136,6 +262,7 @@ class dynamic_merger final : public base_t
 public:
 	using in_port_t = typename base_t::template state_sink<data_t>;
 	using out_port_t = typename base_t::template state_source<out_container_t>;
+	using ref_port_t = typename base_t::template state_source<const out_container_t&>;
 
 	static constexpr auto default_name = "merger";
 
@@ -143,45 +270,166 @@ public:
 	explicit dynamic_merger(args_t&&... args) :
 		base_t(std::forward<args_t>(args)...),
 		in_ports(),
-		out_port(this,[this](){return merge_inputs();})
+		out_port(this,[this]() -> const out_container_t& { return merged(); }),
+		ref_port(this,[this]() -> const out_container_t& { return merged(); }),
+		memo(detail::clock_of(*this, 0))
 	{
 	}
 
 	/// state_sink of type data_t, creates a new port for each call.
 	in_port_t& in()
 	{
-		in_ports.emplace_back(std::make_unique<in_port_t>(this));
-		return *(in_ports.back());
+		// a deque keeps ports in place, which are connected by reference.
+		in_ports.emplace_back(this);
+		return in_ports.back();
 	}
 
 	/// State Output Port of type out_container_t<data_t>.
 	out_port_t& out() { return out_port; }
+	/// State Output Port lending the merged inputs, valid until the next pull.
+	ref_port_t& out_ref() { return ref_port; }
+
+	/// merges inputs at most once per cycle, if enabled, see merge_node::memoize_per_tick.
+	void memoize_per_tick(bool enabled = true) noexcept { memoize = enabled; }
+
+	/**
+	 * \brief pulls inputs in parallel according to policy, which is useful for expensive inputs.
+	 *
+	 * All sources connected to the inputs need to be safe to pull concurrently.
+	 * \pre out_container_t supports resize and operator[].
+	 */
+	void pull_in_parallel(actions::parallel_policy policy)
+	{
+		parallel = policy;
+		merge_function = [](dynamic_merger& self) { self.merge_parallel(); };
+	}
 
 private:
-	out_container_t merge_inputs()
+	const out_container_t& merged()
+	{
+		if (!memoize)
+		{
+			merge_function(*this);
+			return buffer;
+		}
+		return memo.get([this]() { merge_function(*this); return buffer; });
+	}
+
+	void merge_serial()
 	{
-		out_container_t out_buffer{};
+		buffer.clear();
+		detail::reserve_if_possible(buffer, in_ports.size());
 		for(auto& port : in_ports)
 		{
-			out_buffer.push_back(port->get());
+			buffer.push_back(port.get());
 		}
+	}
 
-		return out_buffer;
+	void merge_parallel()
+	{
+		buffer.resize(in_ports.size());
+		actions::detail::for_each_chunk(parallel, in_ports.size(),
+				[this](size_t, size_t b, size_t e)
+				{
+					for (size_t i = b; i != e; ++i)
+						buffer[i] = in_ports[i].get();
+				});
 	}
 
-	std::vector<std::unique_ptr<in_port_t>> in_ports;
+	std::deque<in_port_t> in_ports;
 	out_port_t out_port;
+	ref_port_t ref_port;
+	out_container_t buffer{};
+	actions::parallel_policy parallel{};
+	void (*merge_function)(dynamic_merger&) = [](dynamic_merger& self) { self.merge_serial(); };
+	bool memoize = false;
+	detail::tick_memo<out_container_t> memo;
 };
 
 /*****************************************************************************/
 /*                                   Caches                                  */
 /*****************************************************************************/
 
+/// version of a state, which increases whenever the state changes.
+using state_version_t = uint64_t;
+
+/**
+ * \brief Stores the last event received as state together with a version.
+ *
+ * Like hold_last, but the version port provides a counter,
+ * which is incremented with every event received.
+ * Caches connected to the version port only pull the state if the version changed.
+ * Every event also notifies the nodes depending on out, see change_notifier.
+ *
+ * \tparam data_t is type of token received as event and then stored.
+ */
+template<class data_t, class base_t>
+class versioned_state : public base_t
+{
+public:
+	static constexpr auto default_name = "versioned_state";
+
+	template<class... args_t>
+	explicit versioned_state(const data_t& initial_value, args_t&&... args)
+		: base_t(std::forward<args_t>(args)...)
+		, storage(initial_value)
+		, notifier(std::make_shared<change_notifier>())
+		, in_port{this, [this](data_t in)
+				{
+					storage = std::move(in);
+					++version;
+					notifier->notify();
+				}}
+		, out_port{notifier, this, [this]() -> const data_t& { return storage; }}
+		, version_port{this, [this](){ return version; }}
+	{
+	}
+
+	/// Event in Port expecting data_t, which increments the version.
+	auto& in() noexcept { return in_port; }
+	/// State out port lending the stored state.
+	auto& out() noexcept { return out_port; }
+	/// State out port supplying the version of the stored state.
+	auto& version_out() noexcept { return version_port; }
+private:
+	data_t storage;
+	state_version_t version = 0;
+	std::shared_ptr<change_notifier> notifier;
+	typename base_t::template event_sink<data_t> in_port;
+	reactive_state_source<typename base_t::template state_source<const data_t&>> out_port;
+	typename base_t::template state_source<state_version_t> version_port;
+};
+
+namespace detail
+{
+/**
+ * \brief tracks the version of a cached state.
+ *
+ * returns true from changed if the cache needs to pull a new state,
+ * which is always the case without a connected version port.
+ */
+template<class version_port_t>
+bool version_changed(const version_port_t& port, bool& has_version, state_version_t& last)
+{
+	if (!port.is_connected())
+		return true;
+	const auto current = port.get();
+	if (has_version && current == last)
+		return false;
+	has_version = true;
+	last = current;
+	return true;
+}
+} // namespace detail
+
 /**
  * \brief Pulls inputs on work tick and makes it available to state output.
  *
  * current_state keeps the cache for a single tick.
  * This makes is useful to limit calls the state call chains to once per tick.
+ * If the port version is connected, the input is only pulled if the version changed.
+ * If all sources of in notify of their changes, see change_notifier,
+ * the input is only pulled in ticks after a change.
  *
  * \tparam data_t the type of token stored in the cache.
  */
@@ -202,10 +450,21 @@ public:
 		: region_worker_node(
 			[this]()
 			{
-				stored_state = in_port.get();
+				if (notifier->notifies() && !notifier->changed())
+					return;
+				notifier->clear();
+				if (detail::version_changed(version_port, has_version, last_version))
+				{
+					stored_state = in_port.get();
+					notifier->notify_dependents();
+					checkpointed.mark_changed();
+				}
 			}, node),
-			in_port(this),
-			out_port(this, [this](){ return stored_state;}),
+			// changes are passed on once the state has been pulled.
+			notifier(std::make_shared<change_notifier>(false)),
+			in_port(notifier, this),
+			out_port(notifier, this, [this](){ return stored_state;}),
+			version_port(this),
 			stored_state(initial_value)
 	{
 	}
@@ -217,18 +476,45 @@ public:
 	auto& in() noexcept { return in_port; }
 	/// State Output Port of type data_t.
 	auto& out() noexcept { return out_port; }
+	/// Optional State Input Port of the version of in, see versioned_state.
+	auto& version() noexcept { return version_port; }
+
+	/**
+	 * \brief writes the cached state to the checkpoints of the region, see region_checkpoints.
+	 *
+	 * Restores the state from the checkpoint file right away, if it has one under key,
+	 * which out provides until the input is pulled.
+	 * Does nothing if the region has no checkpoints enabled.
+	 * \tparam archive_t archive serializing data_t, fixed_layout or a Cereal binary archive.
+	 * \param key of the state in the file, the full name of the node by default.
+	 */
+	template<class archive_t = fixed_layout>
+	void checkpoint(std::string key = {})
+	{
+		checkpointed = detail::checkpoint_node<archive_t>(*this, std::move(key), stored_state);
+	}
 
 private:
-	state_sink<data_t> in_port;
-	state_source<data_t> out_port;
+	std::shared_ptr<change_notifier> notifier;
+	reactive_state_sink<state_sink<data_t>> in_port;
+	reactive_state_source<state_source<data_t>> out_port;
+	state_sink<state_version_t> version_port;
 	data_t stored_state;
+	bool has_version = false;
+	state_version_t last_version = 0;
+	/// declared last, so it is removed before stored_state.
+	checkpoint_handle checkpointed;
 };
 
 /**
  * \brief Caches state and only pulls new state when cache is marked as dirty.
  *
- * event_sink update needs to be connected,
- * as events to this port mark the cache as dirty.
+ * Either event_sink update needs to be connected,
+ * as events to this port mark the cache as dirty,
+ * or state_sink version, in which case the cache is dirty if the version changed.
+ * Then a pull costs a comparison of versions, as long as the state does not change.
+ * The cache is also dirty once a source it depends on notifies of a change,
+ * see change_notifier, which makes chains of states notifying their changes free to pull.
  */
 template<class data_t, class base_t>
 class state_cache : public base_t
@@ -239,14 +525,22 @@ public:
 	base_t(std::forward<args_t>(args)...),
 		cache(std::make_unique<data_t>()),
 		load_new(true),
-		in_port(this),
-		out_port(this, [this]()
+		notifier(std::make_shared<change_notifier>()),
+		in_port(notifier, this),
+		out_port(notifier, this, [this]()
+		{
+			return current();
+		}),
+		ref_port(notifier, this, [this]() -> const data_t&
+		{
+			return current();
+		}),
+		update_port(this,  [this]()
 		{
-			if (load_new)
-				refresh_cache();
-			return *cache;
+			load_new = true;
+			notifier->notify_dependents();
 		}),
-		update_port(this,  [this](){ load_new = true; })
+		version_port(this)
 	{
 	}
 
@@ -256,10 +550,32 @@ public:
 	/// State Input Port of type data_t
 	auto& in() noexcept { return in_port; }
 
+	/// State Output Port lending the cached state instead of copying it.
+	auto& out_ref() noexcept { return ref_port; }
+
 	/// Events to this port mark the cache as dirty. Expects events of type void.
 	auto& update() noexcept { return update_port; }
 
+	/// Optional State Input Port of the version of in, see versioned_state.
+	auto& version() noexcept { return version_port; }
+
 private:
+	const data_t& current()
+	{
+		if (notifier->changed())
+		{
+			load_new = true;
+			notifier->clear();
+		}
+		if (version_port.is_connected())
+		{
+			if (detail::version_changed(version_port, has_version, last_version))
+				load_new = true;
+		}
+		if (load_new)
+			refresh_cache();
+		return *cache;
+	}
 	void refresh_cache()
 	{
 		*cache = in_port.get();
@@ -267,9 +583,50 @@ private:
 	}
 	std::unique_ptr<data_t> cache;
 	bool load_new;
-	typename base_t::template state_sink<data_t> in_port;
-	typename base_t::template state_source<data_t> out_port;
+	bool has_version = false;
+	state_version_t last_version = 0;
+	std::shared_ptr<change_notifier> notifier;
+	reactive_state_sink<typename base_t::template state_sink<data_t>> in_port;
+	reactive_state_source<typename base_t::template state_source<data_t>> out_port;
+	reactive_state_source<typename base_t::template state_source<const data_t&>> ref_port;
 	typename base_t::template event_sink<void> update_port;
+	typename base_t::template state_sink<state_version_t> version_port;
+};
+
+/**
+ * \brief Caches state for a single cycle, pulling it on the first request of the cycle.
+ *
+ * Unlike current_state, which pulls on every work tick of its region,
+ * tick_cache only pulls if its state is requested at all.
+ * Placed behind an expensive state source with several consumers,
+ * the source is evaluated once per cycle.
+ * Cycles are distinguished by the virtual clock, which is advanced by cycle_control.
+ */
+template<class data_t, class base_t>
+class tick_cache : public base_t
+{
+public:
+	static constexpr auto default_name = "tick_cache";
+
+	template<class... args_t>
+	explicit tick_cache(args_t&&... args)
+		: base_t(std::forward<args_t>(args)...)
+		, memo(detail::clock_of(*this, 0))
+		, in_port(this)
+		, out_port(this, [this]() -> const data_t&
+				{ return memo.get([this]() { return in_port.get(); }); })
+	{
+	}
+
+	/// State Input Port of type data_t
+	auto& in() noexcept { return in_port; }
+	/// State Output Port lending the state of the current cycle.
+	auto& out() noexcept { return out_port; }
+
+private:
+	detail::tick_memo<data_t> memo;
+	typename base_t::template state_sink<data_t> in_port;
+	typename base_t::template state_source<const data_t&> out_port;
 };
 
 /** @} doxygen group nodes */
@@ -10,14 +10,275 @@
 
 #include <flexcore/extended/base_node.hpp>
 
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 namespace fc
 {
 
+namespace detail
+{
+
+/**
+ * \brief port a terminal relays through, resolved past the terminals it is collapsed into.
+ *
+ * Terminals connected directly to each other within a region form a chain.
+ * Every link of the chain resolves to the same port, the external one at the end,
+ * so relaying through a chain of terminals costs as much as through a single one.
+ * Links are changed while connecting, which must not happen while tokens are relayed.
+ *
+ * \tparam port_t port of the terminal, which is relayed to or from.
+ */
+template<class port_t>
+class terminal_link
+{
+public:
+	explicit terminal_link(port_t& port) : own(&port), resolved_port(&port) {}
+	terminal_link(const terminal_link&) = delete;
+	terminal_link& operator=(const terminal_link&) = delete;
+
+	/// resets the links collapsed into this one to their own ports.
+	~terminal_link()
+	{
+		unlink();
+		for (auto* dependent : dependents)
+		{
+			dependent->through = nullptr;
+			dependent->update(*dependent->own);
+		}
+	}
+
+	/// resolves this link and all collapsed into it as other, unless that forms a cycle.
+	void collapse_into(terminal_link& other)
+	{
+		unlink();
+		for (auto* l = &other; l != nullptr; l = l->through)
+			if (l == this)
+				return;
+		through = &other;
+		other.dependents.push_back(this);
+		update(*other.resolved_port);
+	}
+
+	/// resolves this link and all collapsed into it to its own port again.
+	void unlink()
+	{
+		if (!through)
+			return;
+		auto& others = through->dependents;
+		others.erase(std::remove(others.begin(), others.end(), this), others.end());
+		through = nullptr;
+		update(*own);
+	}
+
+	/// port the terminal relays through.
+	port_t& resolved() const noexcept { return *resolved_port; }
+
+private:
+	void update(port_t& port)
+	{
+		resolved_port = &port;
+		for (auto* dependent : dependents)
+			dependent->update(port);
+	}
+
+	port_t* own;
+	port_t* resolved_port;
+	/// link this one is collapsed into, nullptr if it resolves to its own port.
+	terminal_link* through = nullptr;
+	std::vector<terminal_link*> dependents;
+};
+
+/// checks if the graph of port counts, profiles or tracks the ports bypassed by collapsing.
+template<class port_t>
+bool introspected(const port_t& port)
+{
+	const auto* g = port.graph;
+	return g && (g->port_counters_enabled() || g->node_profiling() || g->tracks_nodes());
+}
+
+/// checks if a connection between two ports of terminals may bypass them.
+template<class source_t, class sink_t>
+bool may_collapse(const source_t& source, const sink_t& sink, std::true_type /*node_aware*/)
+{
+	// a buffer between regions needs to stay in between.
+	return same_region(source, sink) && !introspected(source) && !introspected(sink);
+}
+
+template<class source_t, class sink_t>
+bool may_collapse(const source_t&, const sink_t&, std::false_type /*node_aware*/)
+{
+	return true;
+}
+
+template<class source_t, class sink_t>
+bool may_collapse(const source_t& source, const sink_t& sink)
+{
+	return may_collapse(source, sink, std::integral_constant<bool,
+			is_derived_from<node_aware, source_t>::value
+			&& is_derived_from<node_aware, sink_t>::value>{});
+}
+
+/// true if conn_t is the port of a terminal, which relays to or from relayed_t.
+template<class conn_t, class relayed_t, class enable = void>
+struct relays_terminal : std::false_type
+{
+};
+
+template<class conn_t, class relayed_t>
+struct relays_terminal<conn_t, relayed_t,
+		std::enable_if_t<std::is_same<
+				decltype(std::declval<std::decay_t<conn_t>&>().relayed_port()),
+				relayed_t&>{}>>
+	: std::true_type
+{
+};
+
+/**
+ * \brief input port of a state_terminal.
+ *
+ * Connected directly to the output of another state_terminal in the same region,
+ * the terminal pulls from the input of that terminal instead.
+ */
+template<class sink_base>
+class terminal_state_sink : public sink_base
+{
+public:
+	template<class... args>
+	explicit terminal_state_sink(args&&... base_args)
+		: sink_base(std::forward<args>(base_args)...), link(*this)
+	{
+	}
+
+	template<class conn_t>
+	void connect(conn_t&& conn) &
+	{
+		collapse(conn, relays_terminal<conn_t, terminal_state_sink>{});
+		sink_base::connect(std::forward<conn_t>(conn));
+	}
+
+	/// input port of the first terminal of the chain, which is pulled from.
+	sink_base& resolved() const noexcept { return link.resolved(); }
+
+private:
+	template<class conn_t>
+	void collapse(conn_t& source, std::true_type)
+	{
+		if (may_collapse(source, *this))
+			link.collapse_into(source.relayed_port().link);
+		else
+			link.unlink();
+	}
+
+	template<class conn_t>
+	void collapse(conn_t&, std::false_type)
+	{
+		link.unlink();
+	}
+
+	terminal_link<sink_base> link;
+};
+
+/// output port of a state_terminal, which knows the input it relays from.
+template<class source_base, class sink_t>
+class terminal_state_source : public source_base
+{
+public:
+	template<class... args>
+	explicit terminal_state_source(sink_t& in, args&&... base_args)
+		: source_base(std::forward<args>(base_args)...), in(in)
+	{
+	}
+
+	sink_t& relayed_port() const noexcept { return in; }
+
+private:
+	sink_t& in;
+};
+
+/**
+ * \brief output port of an event_terminal.
+ *
+ * Connected only and directly to the input of another event_terminal in the same region,
+ * the terminal fires the output of that terminal instead.
+ */
+template<class source_base>
+class terminal_event_source : public source_base
+{
+public:
+	template<class... args>
+	explicit terminal_event_source(args&&... base_args)
+		: source_base(std::forward<args>(base_args)...), link(*this)
+	{
+	}
+
+	template<class conn_t>
+	decltype(auto) connect(conn_t&& conn) &
+	{
+		++connections;
+		collapse(conn, relays_terminal<conn_t, terminal_event_source>{});
+		return source_base::connect(std::forward<conn_t>(conn));
+	}
+
+	/// output port of the last terminal of the chain, which fires the events.
+	source_base& resolved() const noexcept { return link.resolved(); }
+
+private:
+	template<class conn_t>
+	void collapse(conn_t& sink, std::true_type)
+	{
+		// with other connections the events need to go to all of them.
+		if (connections == 1 && may_collapse(*this, sink))
+			link.collapse_into(sink.relayed_port().link);
+		else
+			link.unlink();
+	}
+
+	template<class conn_t>
+	void collapse(conn_t&, std::false_type)
+	{
+		link.unlink();
+	}
+
+	size_t connections = 0;
+	terminal_link<source_base> link;
+};
+
+/// input port of an event_terminal, which knows the output it relays to.
+template<class sink_base, class source_t>
+class terminal_event_sink : public sink_base
+{
+public:
+	template<class... args>
+	explicit terminal_event_sink(source_t& out, args&&... base_args)
+		: sink_base(std::forward<args>(base_args)...), out(out)
+	{
+	}
+
+	source_t& relayed_port() const noexcept { return out; }
+
+private:
+	source_t& out;
+};
+
+} // namespace detail
+
+template<class T> struct is_active_sink<detail::terminal_state_sink<T>> : is_active_sink<T> {};
+template<class T> struct is_active_source<detail::terminal_event_source<T>>
+	: is_active_source<T> {};
+
 /**
  * \brief Node that relays state from input port to output port.
  *
  * A state_terminal is useful to form the border of external connections
  * and internal connections in a compound node which nests other nodes.
+ * Terminals connected directly to each other within a region are collapsed,
+ * a pull through nested terminals calls the external connection directly.
+ * The connections to the terminals are still part of the graph,
+ * terminals are not collapsed while the graph counts, profiles or tracks its ports.
  *
  * \tparam T type of data transmitted through terminal node.
  * \tparam base_node base_node to either include or exclude this node from forest.
@@ -37,7 +298,7 @@ public:
 	explicit state_terminal(base_args&&... args)
 		: base_node(std::forward<base_args>(args)...)
 		, in_state(this)
-		, out_state(this, [this](){ return in_state.get(); })
+		, out_state(in_state, this, [this](){ return in_state.resolved().get(); })
 	{
 	}
 
@@ -47,8 +308,10 @@ public:
 	auto& out() { return out_state; }
 
 private:
-	typename base_node::template state_sink<T> in_state;
-	typename base_node::template state_source<T> out_state;
+	using sink_t = detail::terminal_state_sink<typename base_node::template state_sink<T>>;
+	sink_t in_state;
+	detail::terminal_state_source<typename base_node::template state_source<T>, sink_t>
+			out_state;
 };
 
 /**
@@ -56,6 +319,10 @@ private:
  *
  * An event_terminal is useful to form the border of external connections
  * and internal connections in a compound node which nests other nodes.
+ * A terminal connected only to another terminal within its region is collapsed,
+ * events through nested terminals are fired to the external connections directly.
+ * The connections to the terminals are still part of the graph,
+ * terminals are not collapsed while the graph counts, profiles or tracks its ports.
  *
  * \tparam T type of data transmitted through terminal node.
  * \tparam base_node base_node to either include or exclude this node from forest.
@@ -74,10 +341,13 @@ public:
 	template<class... base_args>
 	explicit event_terminal(base_args&&... args)
 		: base_node(std::forward<base_args>(args)...)
-		, in_event(this,
-				//variadic lambda to also handle void events
-				[this](auto&&... in){ out_event.fire(std::forward<decltype(in)>(in)...);})
 		, out_event(this)
+		, in_event(out_event, this,
+				//variadic lambda to also handle void events
+				[this](auto&&... in)
+				{
+					out_event.resolved().fire(std::forward<decltype(in)>(in)...);
+				})
 	{
 	}
 
@@ -87,8 +357,9 @@ public:
 	auto& out() { return out_event; }
 
 private:
-	typename base_node::template event_sink<T> in_event;
-	typename base_node::template event_source<T> out_event;
+	using source_t = detail::terminal_event_source<typename base_node::template event_source<T>>;
+	source_t out_event;
+	detail::terminal_event_sink<typename base_node::template event_sink<T>, source_t> in_event;
 };
 
 }  // namespace fc
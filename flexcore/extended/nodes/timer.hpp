@@ -0,0 +1,64 @@
+#ifndef SRC_NODES_TIMER_HPP_
+#define SRC_NODES_TIMER_HPP_
+
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+#include <flexcore/scheduler/timer_service.hpp>
+
+namespace fc
+{
+
+/**
+ * \brief Node which sends an event once a delay on the virtual clock has passed.
+ *
+ * The delay is started by an event on start(), a new start restarts the timer.
+ * The event is sent through out() on the first work tick of the region at or after
+ * the delay, see parallel_region::timers. A running timer costs nothing per tick.
+ * \ingroup nodes
+ */
+class one_shot_timer : public tree_base_node
+{
+public:
+	static constexpr auto default_name = "one_shot_timer";
+
+	explicit one_shot_timer(const node_args& node)
+		: tree_base_node(node)
+		, service(region()->timers())
+		, start_port(this, [this](virtual_clock::steady::duration delay) { start(delay); })
+		, cancel_port(this, [this]() { cancel(); })
+		, out_port(this)
+	{
+	}
+
+	one_shot_timer(const one_shot_timer&) = delete;
+	~one_shot_timer() override { cancel(); }
+
+	/// Event in Port expecting the delay, after which out() fires.
+	auto& in_start() noexcept { return start_port; }
+	/// Event in Port stopping the timer, out() does not fire then.
+	auto& in_cancel() noexcept { return cancel_port; }
+	/// Event out Port firing once the delay has passed.
+	auto& out() noexcept { return out_port; }
+
+	/// returns true if the timer has been started and has neither fired nor been cancelled.
+	bool running() const noexcept { return service.is_scheduled(timer); }
+
+private:
+	void start(virtual_clock::steady::duration delay)
+	{
+		service.cancel(timer);
+		timer = service.schedule(delay, [this]() { out_port.fire(); });
+	}
+
+	void cancel() { service.cancel(timer); }
+
+	timer_service& service;
+	timer_service::timer_id timer;
+	event_sink<virtual_clock::steady::duration> start_port;
+	event_sink<void> cancel_port;
+	event_source<void> out_port;
+};
+
+} // namespace fc
+
+#endif /* SRC_NODES_TIMER_HPP_ */
@@ -0,0 +1,217 @@
+#ifndef SRC_NODES_WINDOW_AGGREGATES_HPP_
+#define SRC_NODES_WINDOW_AGGREGATES_HPP_
+
+#include <boost/circular_buffer.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+namespace fc
+{
+
+/**
+ * \brief Aggregates over a sliding window, which are updated incrementally.
+ *
+ * An aggregate is notified of every element entering the window by add
+ * and of the oldest element leaving it by remove, both need to be O(1).
+ * value returns the aggregate of the elements currently in the window.
+ */
+namespace aggregates
+{
+
+/// sum of the window, the value of an empty window is T{}.
+template<class T>
+struct sum
+{
+	using result_t = T;
+
+	explicit sum(size_t /*window_size*/) {}
+	void add(const T& in) { total += in; }
+	void remove(const T& out) { total -= out; }
+	result_t value(size_t /*nr_of_elements*/) const { return total; }
+
+	T total{};
+};
+
+/// arithmetic mean of the window, the value of an empty window is result_type{}.
+template<class T, class result_type = double>
+struct mean
+{
+	using result_t = result_type;
+
+	explicit mean(size_t window_size) : total(window_size) {}
+	void add(const T& in) { total.add(in); }
+	void remove(const T& out) { total.remove(out); }
+	result_t value(size_t nr_of_elements) const
+	{
+		if (nr_of_elements == 0)
+			return result_t{};
+		return static_cast<result_t>(total.value(nr_of_elements)) / nr_of_elements;
+	}
+
+	sum<T> total;
+};
+
+/**
+ * \brief population variance of the window, updated with Welford's algorithm.
+ *
+ * The value of an empty window is result_type{}.
+ */
+template<class T, class result_type = double>
+struct variance
+{
+	using result_t = result_type;
+
+	explicit variance(size_t /*window_size*/) {}
+	void add(const T& in)
+	{
+		++count;
+		const result_t x = static_cast<result_t>(in);
+		const result_t delta = x - mean;
+		mean += delta / count;
+		squared_distances += delta * (x - mean);
+	}
+	void remove(const T& out)
+	{
+		assert(count > 0);
+		--count;
+		if (count == 0)
+		{
+			mean = result_t{};
+			squared_distances = result_t{};
+			return;
+		}
+		const result_t x = static_cast<result_t>(out);
+		const result_t delta = x - mean;
+		mean -= delta / count;
+		squared_distances -= delta * (x - mean);
+	}
+	result_t value(size_t /*nr_of_elements*/) const
+	{
+		return count == 0 ? result_t{} : squared_distances / count;
+	}
+
+	size_t count = 0;
+	result_t mean{};
+	result_t squared_distances{};
+};
+
+/**
+ * \brief extremum of the window by compare, kept in a monotonic queue.
+ *
+ * The queue holds the elements which can still become the extremum,
+ * thus add and remove are amortized O(1). The value of an empty window is T{}.
+ * \tparam compare std::less for the minimum, std::greater for the maximum.
+ */
+template<class T, class compare>
+struct extremum
+{
+	using result_t = T;
+
+	explicit extremum(size_t window_size) : candidates(window_size) {}
+	void add(const T& in)
+	{
+		// elements which are worse than in can never be the extremum again.
+		while (!candidates.empty() && compare{}(in, candidates.back()))
+			candidates.pop_back();
+		candidates.push_back(in);
+	}
+	void remove(const T& out)
+	{
+		assert(!candidates.empty());
+		if (!compare{}(candidates.front(), out) && !compare{}(out, candidates.front()))
+			candidates.pop_front();
+	}
+	result_t value(size_t /*nr_of_elements*/) const
+	{
+		return candidates.empty() ? T{} : candidates.front();
+	}
+
+	boost::circular_buffer<T> candidates;
+};
+
+template<class T>
+using min = extremum<T, std::less<T>>;
+template<class T>
+using max = extremum<T, std::greater<T>>;
+
+} // namespace aggregates
+
+/**
+ * \brief Node which aggregates the last window_size events received.
+ *
+ * Like hold_n, events are stored in a circular buffer.
+ * Instead of the whole buffer, the aggregate of the buffer is provided as state,
+ * which is updated in O(1) per event, see namespace aggregates.
+ *
+ * \tparam data_t type of the events received.
+ * \tparam aggregate_t aggregate over the window, for example aggregates::mean<data_t>.
+ * \invariant window_size > 0
+ * \ingroup nodes
+ */
+template<class data_t, class aggregate_t, class base_t>
+class window_aggregate : public base_t
+{
+public:
+	static constexpr auto default_name = "window_aggregate";
+	using result_t = typename aggregate_t::result_t;
+
+	/**
+	 * \param window_size number of events the aggregate is computed of.
+	 * \pre window_size > 0
+	 */
+	template<class... args_t>
+	explicit window_aggregate(size_t window_size, args_t&&... args)
+		: base_t(std::forward<args_t>(args)...)
+		, window(window_size)
+		, aggregate(window_size)
+		, in_port(this, [this](const data_t& in){ push(in); })
+		, out_port(this, [this](){ return aggregate.value(window.size()); })
+	{
+		assert(window_size > 0);
+	}
+
+	/// Event in Port expecting data_t.
+	auto& in() noexcept { return in_port; }
+	/// State out port supplying the current aggregate.
+	auto& out() noexcept { return out_port; }
+
+private:
+	void push(const data_t& in)
+	{
+		if (window.full())
+		{
+			aggregate.remove(window.front());
+			window.pop_front();
+		}
+		window.push_back(in);
+		aggregate.add(in);
+	}
+
+	boost::circular_buffer<data_t> window;
+	aggregate_t aggregate;
+	typename base_t::template event_sink<data_t> in_port;
+	typename base_t::template state_source<result_t> out_port;
+};
+
+/// moving sum of the last window_size events, see window_aggregate.
+template<class data_t, class base_t>
+using moving_sum = window_aggregate<data_t, aggregates::sum<data_t>, base_t>;
+/// moving arithmetic mean of the last window_size events, see window_aggregate.
+template<class data_t, class base_t>
+using moving_mean = window_aggregate<data_t, aggregates::mean<data_t>, base_t>;
+/// moving population variance of the last window_size events, see window_aggregate.
+template<class data_t, class base_t>
+using moving_variance = window_aggregate<data_t, aggregates::variance<data_t>, base_t>;
+/// moving minimum of the last window_size events, see window_aggregate.
+template<class data_t, class base_t>
+using moving_min = window_aggregate<data_t, aggregates::min<data_t>, base_t>;
+/// moving maximum of the last window_size events, see window_aggregate.
+template<class data_t, class base_t>
+using moving_max = window_aggregate<data_t, aggregates::max<data_t>, base_t>;
+
+}  // namespace fc
+
+#endif /* SRC_NODES_WINDOW_AGGREGATES_HPP_ */
@@ -0,0 +1,131 @@
+#include <flexcore/extended/ports/change_notifier.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+namespace fc
+{
+
+namespace
+{
+/// distinguishes notifications, so every notifier passes each on once.
+uint64_t next_epoch()
+{
+	static std::atomic<uint64_t> epoch{0};
+	return epoch.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+template<class T>
+void erase_one(std::vector<T>& elements, const T& element)
+{
+	const auto it = std::find(elements.begin(), elements.end(), element);
+	assert(it != elements.end());
+	elements.erase(it);
+}
+} // namespace
+
+change_notifier::~change_notifier()
+{
+	for (auto& in : inputs)
+		if (in.upstream)
+			erase_one(in.upstream->dependents, this);
+	for (auto* dependent : dependents)
+		dependent->unlink(*this);
+}
+
+void change_notifier::notify()
+{
+	const auto epoch = next_epoch();
+	last_epoch = epoch;
+	changed_ = true;
+	pass_on(epoch);
+}
+
+void change_notifier::notify_dependents()
+{
+	const auto epoch = next_epoch();
+	last_epoch = epoch;
+	pass_on(epoch);
+}
+
+bool change_notifier::notifies() const
+{
+	if (complete == completeness::unknown)
+	{
+		// a cycle of states does not notify.
+		complete = completeness::incomplete;
+		const bool all = std::all_of(inputs.begin(), inputs.end(),
+				[](const input& in) { return in.upstream && in.upstream->notifies(); });
+		complete = all ? completeness::complete : completeness::incomplete;
+	}
+	return complete == completeness::complete;
+}
+
+void change_notifier::set_input(const void* port, change_notifier* upstream)
+{
+	assert(port);
+	assert(upstream != this);
+	auto it = std::find_if(inputs.begin(), inputs.end(),
+			[port](const input& in) { return in.port == port; });
+	if (it == inputs.end())
+		it = inputs.insert(inputs.end(), input{port, nullptr});
+	if (it->upstream)
+		erase_one(it->upstream->dependents, this);
+	it->upstream = upstream;
+	if (upstream)
+		upstream->dependents.push_back(this);
+	inputs_changed();
+	// the new source has a state neither this nor its dependents have seen.
+	notify();
+}
+
+void change_notifier::remove_input(const void* port)
+{
+	const auto it = std::find_if(inputs.begin(), inputs.end(),
+			[port](const input& in) { return in.port == port; });
+	if (it == inputs.end())
+		return;
+	if (it->upstream)
+		erase_one(it->upstream->dependents, this);
+	inputs.erase(it);
+	inputs_changed();
+	notify();
+}
+
+void change_notifier::propagate(uint64_t epoch)
+{
+	if (last_epoch == epoch)
+		return;
+	last_epoch = epoch;
+	changed_ = true;
+	if (forwards)
+		pass_on(epoch);
+}
+
+void change_notifier::pass_on(uint64_t epoch)
+{
+	for (auto* dependent : dependents)
+		dependent->propagate(epoch);
+}
+
+void change_notifier::unlink(change_notifier& upstream)
+{
+	for (auto& in : inputs)
+		if (in.upstream == &upstream)
+			in.upstream = nullptr;
+	inputs_changed();
+	notify();
+}
+
+void change_notifier::inputs_changed() const
+{
+	// dependents only know their completeness, if they know that of this.
+	if (complete == completeness::unknown)
+		return;
+	complete = completeness::unknown;
+	for (const auto* dependent : dependents)
+		dependent->inputs_changed();
+}
+
+} // namespace fc
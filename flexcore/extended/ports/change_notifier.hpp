@@ -0,0 +1,201 @@
+#ifndef SRC_PORTS_CHANGE_NOTIFIER_HPP_
+#define SRC_PORTS_CHANGE_NOTIFIER_HPP_
+
+#include <flexcore/core/traits.hpp>
+#include <flexcore/extended/ports/node_aware.hpp>
+#include <flexcore/pure/detail/port_traits.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fc
+{
+
+/**
+ * \brief Pushes notifications of changed states along connections of states.
+ *
+ * State pulls are on demand, a cache at the end of a chain of nodes cannot know
+ * if any state of the chain changed without pulling it.
+ * Nodes with a change_notifier connect it to the notifiers of the nodes
+ * they pull from, when their reactive_state_sinks are connected directly to them.
+ * A source calls notify when its state changed, which marks the nodes depending on it
+ * as changed, so caches only pull chains which changed.
+ * Each notification reaches every node once, even through diamond shaped graphs.
+ *
+ * Only connections within a region are followed, as notifications are not synchronised.
+ * Connections to other sources, through other connectables or across regions do not notify,
+ * nodes with such inputs see so from notifies and pull as before.
+ * Notifiers are changed while connecting, which must not happen while notifying.
+ */
+class change_notifier
+{
+public:
+	/**
+	 * \param forwards false if notifications are only passed on by notify_dependents,
+	 * for nodes which pull the changed state later, see current_state.
+	 */
+	explicit change_notifier(bool forwards = true) noexcept : forwards(forwards) {}
+	change_notifier(const change_notifier&) = delete;
+	change_notifier& operator=(const change_notifier&) = delete;
+	/// dependents no longer know when their input changes.
+	~change_notifier();
+
+	/// marks this and all nodes depending on it as changed.
+	void notify();
+	/// marks all nodes depending on this as changed, but not this.
+	void notify_dependents();
+
+	/// true if notified since the last clear, initially true.
+	bool changed() const noexcept { return changed_; }
+	void clear() noexcept { changed_ = false; }
+
+	/**
+	 * \brief true if every input notifies of its changes.
+	 *
+	 * Only then an unchanged node has the state it had when it last cleared.
+	 * Nodes without inputs, like sources, always notify.
+	 */
+	bool notifies() const;
+
+	/**
+	 * \brief sets the notifier of the source port is connected to.
+	 * \param port sink of the node, which identifies the input.
+	 * \param upstream notifier of the source, nullptr if the source does not notify.
+	 */
+	void set_input(const void* port, change_notifier* upstream);
+	/// removes the input of port, if there is one.
+	void remove_input(const void* port);
+
+private:
+	enum class completeness : uint8_t { unknown, complete, incomplete };
+	struct input
+	{
+		const void* port;
+		change_notifier* upstream;
+	};
+
+	void propagate(uint64_t epoch);
+	void pass_on(uint64_t epoch);
+	void unlink(change_notifier& upstream);
+	void inputs_changed() const;
+
+	std::vector<input> inputs;
+	std::vector<change_notifier*> dependents;
+	uint64_t last_epoch = 0;
+	bool forwards;
+	bool changed_ = true;
+	mutable completeness complete = completeness::unknown;
+};
+
+namespace detail
+{
+template<class T>
+auto notifier_of(T& source, int) -> decltype(source.changes(), (change_notifier*)nullptr)
+{
+	return &source.changes();
+}
+
+template<class T>
+change_notifier* notifier_of(T&, long)
+{
+	return nullptr;
+}
+
+template<class source_t, class sink_t>
+bool notifies_across(const source_t& source, const sink_t& sink, std::true_type /*node_aware*/)
+{
+	return same_region(source, sink);
+}
+
+template<class source_t, class sink_t>
+bool notifies_across(const source_t&, const sink_t&, std::false_type /*node_aware*/)
+{
+	return true;
+}
+
+/// notifier of source, if it notifies sink.
+template<class source_t, class sink_t>
+change_notifier* upstream_notifier(source_t& source, const sink_t& sink)
+{
+	const bool linked = notifies_across(source, sink, std::integral_constant<bool,
+			is_derived_from<node_aware, source_t>::value
+			&& is_derived_from<node_aware, sink_t>::value>{});
+	return linked ? notifier_of(source, 0) : nullptr;
+}
+
+/// connections through other connectables do not notify, these might change on their own.
+template<class conn_t, class sink_t>
+auto connected_notifier(conn_t& conn, const sink_t& sink)
+		-> std::enable_if_t<!has_source<conn_t>(0), change_notifier*>
+{
+	return upstream_notifier(conn, sink);
+}
+
+template<class conn_t, class sink_t>
+auto connected_notifier(conn_t&, const sink_t&)
+		-> std::enable_if_t<has_source<conn_t>(0), change_notifier*>
+{
+	return nullptr;
+}
+} // namespace detail
+
+/**
+ * \brief state sink, which connects the change_notifier of its node to the source.
+ * \tparam sink_base state sink of the node.
+ */
+template<class sink_base>
+class reactive_state_sink : public sink_base
+{
+public:
+	template<class... args>
+	explicit reactive_state_sink(std::shared_ptr<change_notifier> notifier, args&&... base_args)
+		: sink_base(std::forward<args>(base_args)...), notifier(std::move(notifier))
+	{
+	}
+	reactive_state_sink(reactive_state_sink&&) = default;
+	~reactive_state_sink()
+	{
+		if (notifier)
+			notifier->remove_input(this);
+	}
+
+	template<class conn_t>
+	void connect(conn_t&& conn) &
+	{
+		notifier->set_input(this, detail::connected_notifier(conn, *this));
+		sink_base::connect(std::forward<conn_t>(conn));
+	}
+
+private:
+	std::shared_ptr<change_notifier> notifier;
+};
+
+/**
+ * \brief state source, which provides the change_notifier of its node to the sinks.
+ * \tparam source_base state source of the node.
+ */
+template<class source_base>
+class reactive_state_source : public source_base
+{
+public:
+	template<class... args>
+	explicit reactive_state_source(std::shared_ptr<change_notifier> notifier,
+			args&&... base_args)
+		: source_base(std::forward<args>(base_args)...), notifier(std::move(notifier))
+	{
+	}
+
+	change_notifier& changes() noexcept { return *notifier; }
+
+private:
+	std::shared_ptr<change_notifier> notifier;
+};
+
+template<class T> struct is_active_sink<reactive_state_sink<T>> : is_active_sink<T> {};
+
+} // namespace fc
+
+#endif /* SRC_PORTS_CHANGE_NOTIFIER_HPP_ */
@@ -1,15 +1,30 @@
 #ifndef SRC_PORTS_CONNECTION_BUFFER_HPP_
 #define SRC_PORTS_CONNECTION_BUFFER_HPP_
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <flexcore/pure/pure_ports.hpp>
 #include <flexcore/extended/ports/token_tags.hpp>
+#include <flexcore/scheduler/memory_account.hpp>
+#include <flexcore/scheduler/timing.hpp>
 
 namespace fc
 {
 
+class switch_registry;
+
 //Note: Many asserts in this file might seem stupid (like checking empty after clear)
 //but this code is multi-threaded and race conditions might trigger them.
 
@@ -35,6 +50,8 @@ struct buffer_interface
 	virtual in_port_t& in() = 0;
 	///output port for events, sends event_t
 	virtual out_port_t& out() = 0;
+	/// delivers the events held by the buffer at once, before connections bypass it.
+	virtual void flush() {}
 
 	buffer_interface(const buffer_interface&) = delete;
 	buffer_interface& operator= (const buffer_interface &) = delete;
@@ -67,6 +84,47 @@ private:
 	pure::event_source<token_t> out_event_port;
 };
 
+/// selects which events a bounded event_buffer drops, if it is full.
+enum class overflow_policy
+{
+	/// removes the oldest events stored, the remaining events are moved.
+	drop_oldest,
+	/// discards the events which do not fit.
+	drop_newest,
+	/// discards the events which do not fit and throws std::overflow_error.
+	throw_exception
+};
+
+namespace detail
+{
+/**
+ * \brief sends events through port in the order fire sends them one by one.
+ *
+ * A single connection receives all events at once. Several connections receive
+ * each event before the next, as a batch would reach one connection after the other.
+ */
+template<class event_t, class port_t>
+void fire_in_order(port_t& port, span<event_t> events)
+{
+	if (port.nr_connected_handlers() <= 1)
+		port.fire_batch_move(events);
+	else
+		for (auto& event : events)
+			port.fire(std::move(event));
+}
+
+/// sends n void events through port in the order fire sends them, see fire_in_order.
+template<class port_t>
+void fire_count_in_order(port_t& port, size_t n)
+{
+	if (port.nr_connected_handlers() <= 1)
+		port.fire_count(n);
+	else
+		for (size_t i = 0; i != n; ++i)
+			port.fire();
+}
+} // namespace detail
+
 /**
  * \brief buffer for events using double buffering
  *
@@ -75,25 +133,59 @@ private:
  * This moves events from internal to external buffer.
  * New events are added to to the internal buffer.
  * Events from the external buffer are fired on receiving send tick.
+ *
+ * The number of events stored in each buffer can be limited by max_events.
+ * If a buffer is full, because the active side fires too many events or the
+ * passive side lags behind, events are dropped as selected by the overflow_policy.
+ * Dropped events are counted and signalled on the overflow port on the next switch tick.
+ *
+ * Optionally the buffer traces the latency of events, see trace_latency.
  */
 template<class event_t>
 class event_buffer final : public buffer_interface<event_t, event_tag>
 {
 public:
-	event_buffer()
+	/// no limit, event_buffer grows as needed.
+	static constexpr size_t unbounded = std::numeric_limits<size_t>::max();
+
+	/**
+	 * \param new_max_events maximum number of events stored in any of the buffers.
+	 * \param new_policy which events to drop, if more than max_events are stored.
+	 * \pre max_events > 0
+	 */
+	explicit event_buffer(size_t new_max_events = unbounded,
+			overflow_policy new_policy = overflow_policy::drop_oldest)
 		: switch_active_tick_([this] { switch_active_buffers(); })
 		, switch_passive_tick_([this] { switch_passive_buffers(); })
 		, switch_active_passive_tick_([this] { switch_active_passive_buffers(); })
 		, in_send_tick( [this](){ send_events(); } )
-		, in_event_port( [this](event_t in_event) { intern_buffer.push_back(in_event);})
+		, in_event_port( [this](event_t in_event)
+				{
+					intern_buffer.push_back(std::move(in_event));
+					if (latency)
+						sample(1);
+					limit_intern();
+				},
+				[this](span<const event_t> events)
+				{
+					intern_buffer.insert(end(intern_buffer), events.begin(), events.end());
+					if (latency)
+						sample(events.size());
+					limit_intern();
+				})
 		, intern_buffer()
 		, extern_buffer()
 		, read(false)
+		, max_events(new_max_events)
+		, current_max_events(new_max_events)
+		, policy(new_policy)
 	{
+		assert(max_events > 0);
 	}
 
 	using out_port_t = typename pure::out_port<event_t, event_tag>::type;
 	using in_port_t = typename pure::in_port<event_t, event_tag>::type;
+	using buffer_t = std::vector<event_t>;
 
 	/// event in port of type void, switches active-side buffers
 	auto& switch_active_tick() { return switch_active_tick_; }
@@ -103,11 +195,248 @@ public:
 	auto& switch_active_passive_tick() { return switch_active_passive_tick_; }
 	/// event in port of type void, fires outgoing buffer
 	auto& work_tick() { return in_send_tick; }
+	/// event out port of type size_t, fires the number of events dropped since the last switch.
+	auto& overflow() { return overflow_port; }
 
 	in_port_t& in() override { return in_event_port; }
 	out_port_t& out() override { return out_event_port; }
 
+	/// sends the events of both sides at once, while neither region works.
+	void flush() override
+	{
+		switch_active_passive_buffers();
+		send_events();
+	}
+
+	/**
+	 * \brief records the latency of every n-th event from receiving to sending it.
+	 *
+	 * The time an event is received is the time its source fired it,
+	 * as the buffer directly follows the source port. The latency is recorded when the
+	 * events are sent to the passive side, thus it contains all switch and work ticks
+	 * it waited for. Events of a single cycle are traced by the oldest sampled one.
+	 * Without tracing, receiving an event costs a single additional branch.
+	 * \param histogram histogram the latencies are recorded to, nullptr disables tracing.
+	 * \param sample_every n, the number of events per sample.
+	 * \pre no events have been received, the buffer is not used by other threads.
+	 * \pre sample_every > 0
+	 */
+	void trace_latency(std::shared_ptr<thread::duration_histogram> histogram,
+			size_t sample_every = 1)
+	{
+		assert(sample_every > 0);
+		latency = std::move(histogram);
+		events_per_sample = sample_every;
+		events_until_sample = 1;
+	}
+
+	/// returns the number of events dropped since construction, can be called from any thread.
+	size_t dropped_events() const { return dropped_total.load(std::memory_order_relaxed); }
+
+	/**
+	 * \brief returns the number of events switched towards the passive side, but not yet sent.
+	 *
+	 * Updated on switch and work ticks only, so it costs nothing per event.
+	 * Can be called from any thread, for example by metrics::publish_buffer.
+	 */
+	size_t queued_events() const { return queued.load(std::memory_order_relaxed); }
+
+	/**
+	 * \brief limits the events sent per work tick, the rest is carried over to the next ticks.
+	 *
+	 * After a stall the events of many cycles may be sent at once, which makes the
+	 * work tick after the stall take much longer than usual. With a drain limit
+	 * at most max_events are sent per work tick and sending stops once budget has passed,
+	 * which is checked after every drain_chunk events. Events carried over are sent
+	 * before newer ones and count as queued_events and backlog_events until then.
+	 * They are no longer limited by max_events of the constructor.
+	 * \param max_events maximum number of events per work tick, unbounded for no limit.
+	 * \param budget time after which no further chunk is sent in a work tick.
+	 * \pre max_events > 0, budget > 0
+	 * \pre the buffer is not used by other threads.
+	 */
+	void set_drain_limit(size_t max_events,
+			wall_clock::steady::duration budget = wall_clock::steady::duration::max())
+	{
+		assert(max_events > 0);
+		assert(budget > wall_clock::steady::duration::zero());
+		drain_max_events = max_events;
+		drain_budget = budget;
+	}
+
+	/// number of events sent between checks of the budget of set_drain_limit.
+	static constexpr size_t drain_chunk = 64;
+
+	/**
+	 * \brief returns the number of events carried over by the drain limit at the last work tick.
+	 * Can be called from any thread, for example by metrics::publish_buffer.
+	 */
+	size_t backlog_events() const { return backlog.load(std::memory_order_relaxed); }
+
+	/**
+	 * \brief charges the memory of the buffers to account, usually the one of the passive region.
+	 *
+	 * The capacity of the buffers is charged on switch ticks. While account is over its
+	 * soft limit, the buffers stop growing beyond the capacity they have reached:
+	 * further events are dropped as selected by the overflow_policy, like with max_events.
+	 * The limit is checked on the switch ticks of the active side.
+	 * \pre the buffer is not used by other threads.
+	 */
+	void account_memory(std::shared_ptr<thread::memory_account> account)
+	{
+		active_memory = thread::memory_charge{account};
+		passive_memory = thread::memory_charge{std::move(account)};
+		charge_active_memory();
+		charge_passive_memory();
+	}
+
+	/**
+	 * \brief allocates memory for events in all buffers upfront.
+	 * \pre no events have been received, the buffer is not used by other threads.
+	 */
+	void reserve(size_t nr_of_events)
+	{
+		intern_buffer.reserve(nr_of_events);
+		middle_buffer.reserve(nr_of_events);
+		extern_buffer.reserve(nr_of_events);
+		charge_active_memory();
+		charge_passive_memory();
+	}
+
+	/**
+	 * \brief returns the number of events which can be stored in each buffer without allocating.
+	 * \pre no switch ticks are sent concurrently.
+	 */
+	size_t capacity() const
+	{
+		return std::min({intern_buffer.capacity(), middle_buffer.capacity(),
+				extern_buffer.capacity()});
+	}
+
 private:
+	/// switch_registry calls the switches directly, instead of through the tick ports.
+	friend class switch_registry;
+
+	/**
+	 * \brief drops events from buffer as selected by policy, until at most max_events remain,
+	 * or fewer while the memory account is over its soft limit.
+	 * \throws std::overflow_error if events were dropped and policy is throw_exception.
+	 */
+	void limit(buffer_t& buffer)
+	{
+		if (buffer.size() <= current_max_events)
+			return;
+		const size_t excess = buffer.size() - current_max_events;
+		if (policy == overflow_policy::drop_oldest)
+			buffer.erase(begin(buffer), begin(buffer) + excess);
+		else
+			buffer.erase(end(buffer) - excess, end(buffer));
+		count_dropped(excess);
+	}
+
+	/**
+	 * \brief limits intern_buffer like limit, which is called for every event received.
+	 *
+	 * The oldest events are not erased right away, which would move all others each time.
+	 * They are skipped by intern_begin and removed at once, when as many events have been
+	 * dropped as are kept, or on the next switch tick. Thus every event moves at most once.
+	 */
+	void limit_intern()
+	{
+		const size_t stored = intern_buffer.size() - intern_begin;
+		if (stored <= current_max_events)
+			return;
+		const size_t excess = stored - current_max_events;
+		if (policy == overflow_policy::drop_oldest)
+		{
+			intern_begin += excess;
+			if (intern_begin >= current_max_events)
+				compact_intern();
+		}
+		else
+			intern_buffer.erase(end(intern_buffer) - excess, end(intern_buffer));
+		count_dropped(excess);
+	}
+
+	/// \throws std::overflow_error if policy is throw_exception.
+	void count_dropped(size_t nr_of_events)
+	{
+		dropped_in_cycle += nr_of_events;
+		dropped_total.fetch_add(nr_of_events, std::memory_order_relaxed);
+		if (policy == overflow_policy::throw_exception)
+			throw std::overflow_error{"event_buffer is full"};
+	}
+
+	/// removes the events of intern_buffer dropped by limit_intern.
+	void compact_intern()
+	{
+		intern_buffer.erase(begin(intern_buffer), begin(intern_buffer) + intern_begin);
+		intern_begin = 0;
+	}
+
+	/**
+	 * \brief grows the smaller of both buffers to the capacity of the larger.
+	 *
+	 * The buffers are swapped on switch ticks, without this the capacity of a buffer
+	 * which had to grow would end up wherever the swap leaves it and the next buffer
+	 * which receives as many events would allocate again.
+	 * This way each buffer grows only once to the peak number of events
+	 * and steady traffic does not allocate memory after that.
+	 * Only buffers of the side which sends the switch tick and the middle buffer are passed.
+	 */
+	static void match_capacity(buffer_t& lhs, buffer_t& rhs)
+	{
+		const auto capacity = std::max(lhs.capacity(), rhs.capacity());
+		lhs.reserve(capacity);
+		rhs.reserve(capacity);
+	}
+
+	/// caps the events at the capacity charged last, while the account is over its soft limit.
+	void apply_soft_limit()
+	{
+		const auto charged = active_memory.bytes() / sizeof(event_t);
+		current_max_events = active_memory.over_soft_limit()
+				? std::max(std::min(max_events, charged), size_t(1))
+				: max_events;
+	}
+
+	void charge_active_memory()
+	{
+		active_memory.update(intern_buffer.capacity() * sizeof(event_t));
+	}
+	void charge_passive_memory()
+	{
+		passive_memory.update((middle_buffer.capacity() + extern_buffer.capacity())
+				* sizeof(event_t));
+	}
+
+	using time_point = wall_clock::steady::time_point;
+	/// stamp of buffers without sampled events, larger than all others.
+	static constexpr time_point no_stamp() { return time_point::max(); }
+
+	/// stamps intern_buffer if one of the nr_of_events just received is sampled.
+	void sample(size_t nr_of_events)
+	{
+		if (events_until_sample > nr_of_events)
+		{
+			events_until_sample -= nr_of_events;
+			return;
+		}
+		events_until_sample = events_per_sample;
+		if (intern_stamp == no_stamp())
+			intern_stamp = wall_clock::steady::now();
+	}
+
+	/// fires the number of dropped events on the overflow port, if there were any.
+	void signal_overflow()
+	{
+		if (dropped_in_cycle == 0)
+			return;
+		const size_t dropped = dropped_in_cycle;
+		dropped_in_cycle = 0;
+		overflow_port.fire(dropped);
+	}
+
 	/**
 	 * \brief switches intern_buffer to middle_buffer
 	 * \post intern_buffer.empty()
@@ -115,6 +444,8 @@ private:
 	 */
 	void switch_active_buffers()
 	{
+		apply_soft_limit();
+		compact_intern();
 		// If middle buffer has been switched with outgoing_buffer, then we can swap the incoming
 		// buffers without data loss. If middle buffer has not been read then data needs to be
 		// appended.
@@ -122,10 +453,18 @@ private:
 			swap(intern_buffer, middle_buffer);
 		else
 			middle_buffer.insert(end(middle_buffer), begin(intern_buffer), end(intern_buffer));
+		// the oldest sample moves with the events, an unread middle_buffer has the older one.
+		middle_stamp = read ? intern_stamp : std::min(middle_stamp, intern_stamp);
+		intern_stamp = no_stamp();
 		read = false;
 		intern_buffer.clear();
 		assert(intern_buffer.empty());
 		assert(!read);
+		limit(middle_buffer);
+		match_capacity(intern_buffer, middle_buffer);
+		queued.store(middle_buffer.size(), std::memory_order_relaxed);
+		charge_active_memory();
+		signal_overflow();
 	}
 
 	/**
@@ -135,13 +474,29 @@ private:
 	 */
 	void switch_passive_buffers()
 	{
-		// Switching the outgoing buffers means the previous value in extern_buffer has already been
-		// processed. So a new value is unconditionally needed. Swap should do.
-		swap(middle_buffer, extern_buffer);
+		if (drain_limited() && !extern_buffer.empty())
+		{
+			// events carried over by the drain limit are sent before the new ones.
+			compact_extern();
+			extern_buffer.insert(end(extern_buffer), std::make_move_iterator(begin(middle_buffer)),
+					std::make_move_iterator(end(middle_buffer)));
+			extern_stamp = std::min(extern_stamp, middle_stamp);
+		}
+		else
+		{
+			// Switching the outgoing buffers means the previous value in extern_buffer has already
+			// been processed. So a new value is unconditionally needed. Swap should do.
+			swap(middle_buffer, extern_buffer);
+			extern_stamp = middle_stamp;
+		}
+		middle_stamp = no_stamp();
 		read = true;
 		middle_buffer.clear();
 		assert(middle_buffer.empty());
 		assert(read);
+		match_capacity(middle_buffer, extern_buffer);
+		queued.store(extern_buffer.size(), std::memory_order_relaxed);
+		charge_passive_memory();
 	}
 
 	/**
@@ -150,6 +505,9 @@ private:
 	 */
 	void switch_active_passive_buffers()
 	{
+		apply_soft_limit();
+		compact_intern();
+		compact_extern();
 		if(extern_buffer.empty())
 		{
 			swap(intern_buffer, extern_buffer);
@@ -160,21 +518,85 @@ private:
 			intern_buffer.clear();
 		}
 		assert(intern_buffer.empty());
+		extern_stamp = std::min(extern_stamp, intern_stamp);
+		intern_stamp = no_stamp();
+		limit(extern_buffer);
+		match_capacity(intern_buffer, extern_buffer);
+		match_capacity(middle_buffer, extern_buffer);
+		queued.store(extern_buffer.size(), std::memory_order_relaxed);
+		charge_active_memory();
+		charge_passive_memory();
+		signal_overflow();
 	}
 
 	/**
 	 * \brief sends all events stored in outgoing buffer to targets
+	 *
+	 * Events are moved out of the buffer, as they are cleared afterwards anyway.
+	 * A single sink, which receives batches, gets all events of the cycle at once.
+	 * Several connections receive the events in the order they were sent, see fire_in_order.
 	 * \post extern_buffer is empty
 	 */
 	void send_events()
 	{
-		for (event_t e : extern_buffer)
-			out_event_port.fire(e);
+		if (extern_stamp != no_stamp())
+		{
+			assert(latency);
+			latency->record(wall_clock::steady::now() - extern_stamp);
+			extern_stamp = no_stamp();
+		}
+		if (drain_limited())
+		{
+			drain();
+			return;
+		}
+		detail::fire_in_order<event_t>(out_event_port, extern_buffer);
 
 		// delete content of extern buffer, do not change capacity,
 		// since we want to avoid allocations in next cycle.
 		extern_buffer.clear();
 		assert(extern_buffer.empty());
+		queued.store(0, std::memory_order_relaxed);
+	}
+
+	bool drain_limited() const
+	{
+		return drain_max_events != unbounded
+				|| drain_budget != wall_clock::steady::duration::max();
+	}
+
+	/// sends events of extern_buffer within the limits of set_drain_limit.
+	void drain()
+	{
+		const bool timed = drain_budget != wall_clock::steady::duration::max();
+		const auto deadline = timed ? wall_clock::steady::now() + drain_budget : time_point::max();
+		const size_t last = extern_begin
+				+ std::min(extern_buffer.size() - extern_begin, drain_max_events);
+		while (extern_begin != last)
+		{
+			const size_t chunk = timed ? std::min(drain_chunk, last - extern_begin)
+					: last - extern_begin;
+			detail::fire_in_order(out_event_port,
+					span<event_t>{extern_buffer.data() + extern_begin, chunk});
+			extern_begin += chunk;
+			if (timed && wall_clock::steady::now() >= deadline)
+				break;
+		}
+		if (extern_begin == extern_buffer.size())
+		{
+			extern_buffer.clear();
+			extern_begin = 0;
+		}
+		const size_t remaining = extern_buffer.size() - extern_begin;
+		backlog.store(remaining, std::memory_order_relaxed);
+		queued.store(remaining, std::memory_order_relaxed);
+	}
+
+	/// removes the events of extern_buffer already sent by drain.
+	void compact_extern()
+	{
+		extern_buffer.erase(begin(extern_buffer), begin(extern_buffer) + extern_begin);
+		extern_begin = 0;
 	}
 
 	pure::event_sink<void> switch_active_tick_;
@@ -183,14 +605,49 @@ private:
 	pure::event_sink<void> in_send_tick;
 	in_port_t in_event_port;
 	out_port_t out_event_port;
+	pure::event_source<size_t> overflow_port;
 
-	using buffer_t = std::vector<event_t>;
 	buffer_t intern_buffer;
 	buffer_t extern_buffer;
 	buffer_t middle_buffer;
 	bool read;
+	const size_t max_events;
+	/// max_events or less under the soft limit, only accessed by the active side.
+	size_t current_max_events;
+	const overflow_policy policy;
+	/// events dropped since the last switch tick, only accessed by the active side.
+	size_t dropped_in_cycle = 0;
+	std::atomic<size_t> dropped_total{0};
+	std::atomic<size_t> queued{0};
+	/// limits of set_drain_limit, unlimited by default.
+	size_t drain_max_events = unbounded;
+	wall_clock::steady::duration drain_budget = wall_clock::steady::duration::max();
+	/// first event of extern_buffer not yet sent, only accessed by the passive side.
+	size_t extern_begin = 0;
+	/// first event of intern_buffer not dropped, only accessed by the active side.
+	size_t intern_begin = 0;
+	std::atomic<size_t> backlog{0};
+
+	std::shared_ptr<thread::duration_histogram> latency;
+	size_t events_per_sample = 1;
+	/// number of events received until the next sample, only accessed by the active side.
+	size_t events_until_sample = 1;
+	/// time the oldest sampled event of each buffer was received.
+	time_point intern_stamp = no_stamp();
+	time_point middle_stamp = no_stamp();
+	time_point extern_stamp = no_stamp();
+
+	/// capacity of intern_buffer, charged by the active side.
+	thread::memory_charge active_memory;
+	/// capacity of middle_buffer and extern_buffer, charged by the passive side.
+	thread::memory_charge passive_memory;
 };
 
+template<class event_t>
+constexpr size_t event_buffer<event_t>::unbounded;
+template<class event_t>
+constexpr size_t event_buffer<event_t>::drain_chunk;
+
 /**
  * \brief Template Specialization for events of type void
  *
@@ -205,7 +662,8 @@ public:
 		, switch_passive_tick_([this] { switch_passive_buffers(); })
 		, switch_active_passive_tick_([this] { switch_active_passive_buffers(); })
 		, in_send_tick( [this](){ send_events(); } )
-		, in_event_port( [this]() { intern_buffer++;})
+		, in_event_port([this]() { intern_buffer++; },
+				[this](size_t n) { intern_buffer += n; })
 		, intern_buffer(0)
 		, extern_buffer(0)
 		, middle_buffer(0)
@@ -222,13 +680,22 @@ public:
 	auto& switch_passive_tick() { return switch_passive_tick_; }
 	/// event in port of type void, directly switches active- and passive-side buffers
 	auto& switch_active_passive_tick() { return switch_active_passive_tick_; }
-	/// event in port of type void, fires out port once for each event stored.
+	/// event in port of type void, fires the number of events stored, see event_source::fire_count.
 	auto& work_tick() { return in_send_tick; }
 
 	in_port_t& in() override { return in_event_port; }
 	out_port_t& out() override { return out_event_port; }
 
+	/// sends the events of both sides at once, while neither region works.
+	void flush() override
+	{
+		switch_active_passive_buffers();
+		send_events();
+	}
+
 private:
+	friend class switch_registry;
+
 	void switch_active_buffers()
 	{
 		if (read)
@@ -261,9 +728,7 @@ private:
 	 */
 	void send_events()
 	{
-		for (size_t i = 0; i < extern_buffer; ++i)
-			out_event_port.fire();
-
+		detail::fire_count_in_order(out_event_port, extern_buffer);
 		extern_buffer = 0;
 	}
 
@@ -280,105 +745,1219 @@ private:
 	bool read;
 };
 
-/// Implementation of buffer_interface, which directly forwards state.
-template<class data_t>
-class state_no_buffer final : public buffer_interface<data_t, state_tag>
+/**
+ * \brief buffer for events using a bounded single producer single consumer ring buffer.
+ *
+ * Alternative to event_buffer for high rate event streams between regions.
+ * Events are constructed in place in a ring of fixed capacity,
+ * thus the buffer never allocates memory after construction and never appends copies
+ * of events if the passive side lags behind.
+ *
+ * The ticks have the same meaning as for event_buffer:
+ * The switch tick of the active region publishes all events received so far,
+ * the switch tick of the passive region makes the published events available,
+ * which are then sent on the work tick of the passive region.
+ * Events are only shared between the thread of the active and the passive region
+ * through the position of the last published and the last sent event.
+ *
+ * If the ring is full, events are dropped as selected by the overflow_policy.
+ * Only events not yet published can be dropped by the active side,
+ * drop_oldest drops the new event instead, if all stored events are published.
+ * Once events have been dropped, slots freed by the passive side are used
+ * from the next switch tick of the active side on.
+ * Dropped events are counted and signalled on the overflow port on that switch tick.
+ *
+ * \tparam event_t type of events, needs to be move constructible.
+ * \invariant read_pos <= readable_end <= published <= write_pos
+ * \invariant write_pos - read_pos <= capacity
+ */
+template<class event_t>
+class ring_event_buffer final : public buffer_interface<event_t, event_tag>
 {
 public:
-	state_no_buffer()
-	: 	out_port( [this]() { return in_port.get();})
+	/// default number of events which can be stored
+	static constexpr size_t default_capacity = 1024;
+
+	/**
+	 * \param min_capacity number of events that can be stored without being sent,
+	 * rounded up to the next power of two.
+	 * \param new_policy which events to drop, if the ring is full.
+	 * \pre min_capacity > 0
+	 */
+	explicit ring_event_buffer(size_t min_capacity = default_capacity,
+			overflow_policy new_policy = overflow_policy::drop_oldest)
+		: switch_active_tick_([this] { switch_active_buffers(); })
+		, switch_passive_tick_([this] { switch_passive_buffers(); })
+		, switch_active_passive_tick_([this] { switch_active_passive_buffers(); })
+		, in_send_tick([this]() { send_events(); })
+		, in_event_port([this](event_t in_event) { push(std::move(in_event)); })
+		, slots(round_up_to_power_of_two(min_capacity))
+		, mask(slots.size() - 1)
+		, policy(new_policy)
 	{
+		assert(min_capacity > 0);
 	}
 
-	pure::state_sink<data_t>& in() override
+	~ring_event_buffer() override
 	{
-		return in_port;
+		// destroy events which have been received but never sent.
+		for (auto i = read_pos.load(); i != write_pos; ++i)
+			slot(i).~event_t();
 	}
-	pure::state_source<data_t>& out() override
+
+	using out_port_t = typename pure::out_port<event_t, event_tag>::type;
+	using in_port_t = typename pure::in_port<event_t, event_tag>::type;
+
+	/// event in port of type void, publishes events to the passive side
+	auto& switch_active_tick() { return switch_active_tick_; }
+	/// event in port of type void, makes published events available for sending
+	auto& switch_passive_tick() { return switch_passive_tick_; }
+	/// event in port of type void, directly publishes events and makes them available
+	auto& switch_active_passive_tick() { return switch_active_passive_tick_; }
+	/// event in port of type void, fires available events
+	auto& work_tick() { return in_send_tick; }
+	/// event out port of type size_t, fires the number of events dropped since the last switch.
+	auto& overflow() { return overflow_port; }
+
+	in_port_t& in() override { return in_event_port; }
+	out_port_t& out() override { return out_event_port; }
+
+	/// sends the events of both sides at once, while neither region works.
+	void flush() override
 	{
-		return out_port;
+		switch_active_passive_buffers();
+		send_events();
 	}
 
+	/// returns the number of events that can be stored in the buffer.
+	size_t capacity() const { return slots.size(); }
+
+	/// returns the number of events dropped since construction, can be called from any thread.
+	size_t dropped_events() const { return dropped_total.load(std::memory_order_relaxed); }
+
 private:
-	pure::state_sink<data_t> in_port;
-	pure::state_source<data_t> out_port;
-};
+	friend class switch_registry;
 
-/** \brief buffer for states using double buffering
- *
- * \tparam data_t type of state stored in buffer. needs to be copy_constructable.
- */
-template<class data_t>
-class state_buffer final : public buffer_interface<data_t, state_tag>
-{
-public:
-	state_buffer();
+	using slot_t = std::aligned_storage_t<sizeof(event_t), alignof(event_t)>;
 
-	/// event in port of type void, switches incoming buffers
-	auto& switch_active_tick() { return switch_active_tick_; }
-	/// event in port of type void, switches outgoing buffers
-	auto& switch_passive_tick() { return switch_passive_tick_; }
-	/// event in port of type void, directly switches active- and passive-side buffers
-	auto& switch_active_passive_tick() { return switch_active_passive_tick_; }
-	/// event in port of type void, pulls data at in_port
-	auto& work_tick() { return in_work_tick; }
+	void switch_active_buffers() { publish(); }
+	void switch_passive_buffers() { acquire(); }
+	void switch_active_passive_buffers()
+	{
+		publish();
+		acquire();
+	}
 
-	pure::state_sink<data_t>& in() override
+	static size_t round_up_to_power_of_two(size_t n)
 	{
-		return in_port;
+		size_t result = 1;
+		while (result < n)
+			result <<= 1;
+		return result;
 	}
-	pure::state_source<data_t>& out() override
+
+	event_t& slot(uint64_t pos)
 	{
-		return out_port;
+		return *reinterpret_cast<event_t*>(&slots[pos & mask]);
 	}
 
-private:
-	void switch_passive_buffers()
+	/**
+	 * \brief stores event in the next free slot, called by the active side.
+	 * \throws std::overflow_error if the ring is full and policy is throw_exception.
+	 */
+	void push(event_t&& event)
 	{
-		middle_buffer = intern_buffer;
+		if (window != 0)
+			return replace_oldest(std::move(event));
+		if (write_pos - read_pos.load(std::memory_order_acquire) != capacity())
+		{
+			new (&slot(write_pos)) event_t(std::move(event));
+			++write_pos;
+			return;
+		}
+		const auto unpublished = write_pos - published.load(std::memory_order_relaxed);
+		if (policy == overflow_policy::drop_oldest && unpublished != 0)
+		{
+			window = unpublished;
+			return replace_oldest(std::move(event));
+		}
+		++dropped_in_cycle;
+		dropped_total.fetch_add(1, std::memory_order_relaxed);
+		if (policy == overflow_policy::throw_exception)
+			throw std::overflow_error{"ring_event_buffer is full"};
 	}
 
-	void switch_active_buffers()
+	/**
+	 * \brief drops the oldest unpublished event and stores event in its slot.
+	 *
+	 * The unpublished events then form a ring of their own, whose oldest event
+	 * is at rotation, which is turned back into order on publish.
+	 */
+	void replace_oldest(event_t&& event)
 	{
-		extern_buffer = middle_buffer;
+		auto& oldest = slot(published.load(std::memory_order_relaxed) + rotation);
+		oldest.~event_t();
+		new (&oldest) event_t(std::move(event));
+		rotation = (rotation + 1) % window;
+		++dropped_in_cycle;
+		dropped_total.fetch_add(1, std::memory_order_relaxed);
 	}
 
-	void switch_active_passive_buffers()
+	/// brings the unpublished events rotated by replace_oldest back in order.
+	void restore_order()
+	{
+		const auto first = published.load(std::memory_order_relaxed);
+		const auto reverse = [this, first](uint64_t begin, uint64_t end)
+		{
+			for (; begin + 1 < end; ++begin, --end)
+				swap_slots(first + begin, first + end - 1);
+		};
+		reverse(0, rotation);
+		reverse(rotation, window);
+		reverse(0, window);
+		window = 0;
+		rotation = 0;
+	}
+
+	/// swaps the events of two slots, which only requires event_t to be move constructible.
+	void swap_slots(uint64_t lhs, uint64_t rhs)
+	{
+		event_t tmp(std::move(slot(lhs)));
+		slot(lhs).~event_t();
+		new (&slot(lhs)) event_t(std::move(slot(rhs)));
+		slot(rhs).~event_t();
+		new (&slot(rhs)) event_t(std::move(tmp));
+	}
+
+	/// makes all events received so far visible to the passive side.
+	void publish()
+	{
+		if (window != 0)
+			restore_order();
+		published.store(write_pos, std::memory_order_release);
+		signal_overflow();
+	}
+
+	/// fires the number of dropped events on the overflow port, if there were any.
+	void signal_overflow()
+	{
+		if (dropped_in_cycle == 0)
+			return;
+		const size_t dropped = dropped_in_cycle;
+		dropped_in_cycle = 0;
+		overflow_port.fire(dropped);
+	}
+
+	/// takes all published events to be sent on the next work tick.
+	void acquire()
+	{
+		readable_end = published.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * \brief sends all available events to targets
+	 * \post read_pos == readable_end
+	 */
+	void send_events()
 	{
-		extern_buffer = intern_buffer;
+		for (auto pos = read_pos.load(std::memory_order_relaxed); pos != readable_end; ++pos)
+		{
+			event_t event(std::move(slot(pos)));
+			slot(pos).~event_t();
+			// slot is free for the active side, before the event is fired.
+			read_pos.store(pos + 1, std::memory_order_release);
+			out_event_port.fire(std::move(event));
+		}
+		assert(read_pos.load() == readable_end);
 	}
 
 	pure::event_sink<void> switch_active_tick_;
 	pure::event_sink<void> switch_passive_tick_;
 	pure::event_sink<void> switch_active_passive_tick_;
-	pure::event_sink<void> in_work_tick;
-	pure::state_sink<data_t> in_port;
-	pure::state_source<data_t> out_port;
+	pure::event_sink<void> in_send_tick;
+	in_port_t in_event_port;
+	out_port_t out_event_port;
+	pure::event_source<size_t> overflow_port;
 
-	data_t intern_buffer;
-	data_t extern_buffer;
-	data_t middle_buffer;
+	std::vector<slot_t> slots;
+	const uint64_t mask;
+	const overflow_policy policy;
+	/// number of unpublished events rotated by replace_oldest, zero if they are in order.
+	uint64_t window = 0;
+	/// offset of the oldest unpublished event, only accessed by the active side.
+	uint64_t rotation = 0;
+	/// events dropped since the last switch tick, only accessed by the active side.
+	size_t dropped_in_cycle = 0;
+	std::atomic<size_t> dropped_total{0};
+	/// position after the last received event, only accessed by the active side.
+	uint64_t write_pos = 0;
+	/// position after the last published event.
+	std::atomic<uint64_t> published{0};
+	/// position after the last event to be sent, only accessed by the passive side.
+	uint64_t readable_end = 0;
+	/// position of the next event to be sent.
+	std::atomic<uint64_t> read_pos{0};
 };
 
-namespace detail
-{
-template<class data_t, class tag>
-struct no_buffer {};
+template<class event_t>
+constexpr size_t ring_event_buffer<event_t>::default_capacity;
 
-template<class data_t>
-struct no_buffer<data_t, event_tag>
+/**
+ * \brief customization point to coalesce events per key in coalescing_event_buffer.
+ *
+ * By default there are no keys and only the latest event is kept.
+ * Specialize it with a static function key(const event_t&) returning an equality
+ * comparable key, to keep the latest event for each key instead.
+ * \code{cpp}
+ * template<> struct coalescing_key<setpoint>
+ * {
+ *     static int key(const setpoint& s) { return s.joint; }
+ * };
+ * \endcode
+ */
+template<class event_t>
+struct coalescing_key
 {
-	using type = event_no_buffer<data_t>;
 };
 
-template<class data_t>
-struct no_buffer<data_t, state_tag>
+namespace detail
 {
-	using type = state_no_buffer<data_t>;
-};
+/// checks if coalescing_key is specialized for event_t
+template<class event_t, class = void>
+struct has_coalescing_key : std::false_type {};
 
-template<class data_t, class tag>
-struct buffer {};
+template<class event_t>
+struct has_coalescing_key<event_t,
+		decltype(void(coalescing_key<event_t>::key(std::declval<const event_t&>())))>
+	: std::true_type {};
+
+/**
+ * \brief latest events received, at most one per key.
+ *
+ * Lookup of keys is linear in the number of keys,
+ * which is intended for streams with a few keys, like joints of a robot.
+ */
+template<class event_t, bool keyed = has_coalescing_key<event_t>{}>
+class latest_events
+{
+public:
+	/// replaces the stored event with the same key as event, otherwise adds event.
+	void put(event_t&& event)
+	{
+		const auto key = coalescing_key<event_t>::key(event);
+		for (auto& stored : events)
+			if (coalescing_key<event_t>::key(stored) == key)
+			{
+				stored = std::move(event);
+				return;
+			}
+		events.push_back(std::move(event));
+	}
+
+	/// adds all events of newer, replacing events with the same keys.
+	void merge(latest_events& newer)
+	{
+		for (auto& event : newer.events)
+			put(std::move(event));
+		newer.clear();
+	}
+
+	template<class port_t>
+	void send(port_t& port)
+	{
+		for (auto& event : events)
+			port.fire(std::move(event));
+		clear();
+	}
+
+	bool empty() const { return events.empty(); }
+	/// removes all events but keeps capacity, to avoid allocations in the next cycle.
+	void clear() { events.clear(); }
+	friend void swap(latest_events& lhs, latest_events& rhs) { swap(lhs.events, rhs.events); }
+
+private:
+	std::vector<event_t> events;
+};
+
+/// without keys only a single event is stored.
+template<class event_t>
+class latest_events<event_t, false>
+{
+public:
+	void put(event_t&& event)
+	{
+		if (latest)
+			*latest = std::move(event);
+		else
+			latest = std::make_unique<event_t>(std::move(event));
+		fresh = true;
+	}
+
+	void merge(latest_events& newer)
+	{
+		if (newer.fresh)
+			swap(*this, newer);
+		newer.clear();
+	}
+
+	template<class port_t>
+	void send(port_t& port)
+	{
+		if (fresh)
+			port.fire(std::move(*latest));
+		clear();
+	}
+
+	bool empty() const { return !fresh; }
+	/// keeps the storage of the event, moved from events are overwritten by the next put.
+	void clear() { fresh = false; }
+	friend void swap(latest_events& lhs, latest_events& rhs)
+	{
+		using std::swap;
+		swap(lhs.latest, rhs.latest);
+		swap(lhs.fresh, rhs.fresh);
+	}
+
+private:
+	std::unique_ptr<event_t> latest;
+	bool fresh = false;
+};
+}
+
+/**
+ * \brief buffer for events, which only keeps the latest event per cycle.
+ *
+ * Alternative to event_buffer for streams where only the latest value matters,
+ * like setpoints or poses. The ticks have the same meaning as for event_buffer,
+ * but instead of storing all events, each stage of the buffer keeps the latest event,
+ * or the latest event per key if coalescing_key is specialized for event_t.
+ * If the passive side lags behind, older events are overwritten instead of appended,
+ * thus memory per connection stays bounded and events are never sent which are
+ * already outdated.
+ *
+ * \tparam event_t type of events, needs to be move constructible and move assignable.
+ */
+template<class event_t>
+class coalescing_event_buffer final : public buffer_interface<event_t, event_tag>
+{
+public:
+	coalescing_event_buffer()
+		: switch_active_tick_([this] { switch_active_buffers(); })
+		, switch_passive_tick_([this] { switch_passive_buffers(); })
+		, switch_active_passive_tick_([this] { switch_active_passive_buffers(); })
+		, in_send_tick([this]() { extern_buffer.send(out_event_port); })
+		, in_event_port([this](event_t in_event) { intern_buffer.put(std::move(in_event)); })
+	{
+	}
+
+	using out_port_t = typename pure::out_port<event_t, event_tag>::type;
+	using in_port_t = typename pure::in_port<event_t, event_tag>::type;
+
+	/// event in port of type void, switches active-side buffers
+	auto& switch_active_tick() { return switch_active_tick_; }
+	/// event in port of type void, switches passive-side buffers
+	auto& switch_passive_tick() { return switch_passive_tick_; }
+	/// event in port of type void, directly switches active- and passive-side buffers
+	auto& switch_active_passive_tick() { return switch_active_passive_tick_; }
+	/// event in port of type void, fires the latest events
+	auto& work_tick() { return in_send_tick; }
+
+	in_port_t& in() override { return in_event_port; }
+	out_port_t& out() override { return out_event_port; }
+
+	/// sends the events of both sides at once, while neither region works.
+	void flush() override
+	{
+		switch_active_passive_buffers();
+		extern_buffer.send(out_event_port);
+	}
+
+private:
+	friend class switch_registry;
+
+	/// \post intern_buffer.empty()
+	void switch_active_buffers()
+	{
+		// events in middle_buffer which have not been read are outdated by newer ones.
+		if (read)
+			swap(intern_buffer, middle_buffer);
+		else
+			middle_buffer.merge(intern_buffer);
+		read = false;
+		intern_buffer.clear();
+	}
+
+	/// \post middle_buffer.empty()
+	void switch_passive_buffers()
+	{
+		swap(middle_buffer, extern_buffer);
+		read = true;
+		middle_buffer.clear();
+	}
+
+	/// \post intern_buffer.empty()
+	void switch_active_passive_buffers()
+	{
+		extern_buffer.merge(intern_buffer);
+	}
+
+	using buffer_t = detail::latest_events<event_t>;
+
+	pure::event_sink<void> switch_active_tick_;
+	pure::event_sink<void> switch_passive_tick_;
+	pure::event_sink<void> switch_active_passive_tick_;
+	pure::event_sink<void> in_send_tick;
+	in_port_t in_event_port;
+	out_port_t out_event_port;
+
+	buffer_t intern_buffer;
+	buffer_t extern_buffer;
+	buffer_t middle_buffer;
+	bool read = false;
+};
+
+/**
+ * \brief customization point to classify events for priority_event_buffer.
+ *
+ * By default all events are bulk events. Specialize it with a static function
+ * urgent(const event_t&) returning true for events, which must not wait behind bulk events.
+ * \code{cpp}
+ * template<> struct event_priority<message>
+ * {
+ *     static bool urgent(const message& m) { return m.kind == message::control; }
+ * };
+ * \endcode
+ */
+template<class event_t>
+struct event_priority
+{
+	static bool urgent(const event_t&) { return false; }
+};
+
+namespace detail
+{
+/// events of a single stage of priority_event_buffer, sorted into two lanes.
+template<class event_t>
+struct priority_lanes
+{
+	void put(event_t&& event)
+	{
+		auto& lane = event_priority<event_t>::urgent(event) ? urgent : bulk;
+		lane.push_back(std::move(event));
+	}
+
+	/// appends the events of newer to both lanes.
+	void append(priority_lanes& newer)
+	{
+		urgent.insert(end(urgent), std::make_move_iterator(begin(newer.urgent)),
+				std::make_move_iterator(end(newer.urgent)));
+		bulk.insert(end(bulk), std::make_move_iterator(begin(newer.bulk)),
+				std::make_move_iterator(end(newer.bulk)));
+		newer.clear();
+	}
+
+	size_t size() const { return urgent.size() + bulk.size(); }
+	/// removes all events but keeps capacity, to avoid allocations in the next cycle.
+	void clear()
+	{
+		urgent.clear();
+		bulk.clear();
+	}
+	friend void swap(priority_lanes& lhs, priority_lanes& rhs)
+	{
+		using std::swap;
+		swap(lhs.urgent, rhs.urgent);
+		swap(lhs.bulk, rhs.bulk);
+	}
+
+	std::vector<event_t> urgent;
+	std::vector<event_t> bulk;
+};
+}
+
+/**
+ * \brief buffer for events, which sends urgent events before bulk events.
+ *
+ * Alternative to event_buffer for connections carrying both control events and bursts
+ * of bulk events, like map updates. Events are sorted into an urgent and a bulk lane
+ * by event_priority. The ticks have the same meaning as for event_buffer, but on
+ * the work tick all urgent events are sent first and then at most max_bulk_per_tick bulk events.
+ * Bulk events over that limit wait in a backlog for the following work ticks,
+ * thus a burst of bulk events is spread over several cycles and does not delay
+ * urgent events of later cycles. Events of each lane keep their order.
+ *
+ * The backlog grows, as long as more than max_bulk_per_tick bulk events arrive per cycle.
+ *
+ * \tparam event_t type of events, needs to be move constructible.
+ */
+template<class event_t>
+class priority_event_buffer final : public buffer_interface<event_t, event_tag>
+{
+public:
+	/// no limit, all bulk events are sent in the cycle they are switched in.
+	static constexpr size_t unbounded = std::numeric_limits<size_t>::max();
+
+	/**
+	 * \param max_bulk_events number of bulk events sent per work tick at most.
+	 * \pre max_bulk_events > 0
+	 */
+	explicit priority_event_buffer(size_t max_bulk_events = unbounded)
+		: switch_active_tick_([this] { switch_active_buffers(); })
+		, switch_passive_tick_([this] { switch_passive_buffers(); })
+		, switch_active_passive_tick_([this] { switch_active_passive_buffers(); })
+		, in_send_tick([this]() { send_events(); })
+		, in_event_port([this](event_t in_event) { intern_buffer.put(std::move(in_event)); })
+		, max_bulk_per_tick(max_bulk_events)
+	{
+		assert(max_bulk_per_tick > 0);
+	}
+
+	using out_port_t = typename pure::out_port<event_t, event_tag>::type;
+	using in_port_t = typename pure::in_port<event_t, event_tag>::type;
+
+	/// event in port of type void, switches active-side buffers
+	auto& switch_active_tick() { return switch_active_tick_; }
+	/// event in port of type void, switches passive-side buffers
+	auto& switch_passive_tick() { return switch_passive_tick_; }
+	/// event in port of type void, directly switches active- and passive-side buffers
+	auto& switch_active_passive_tick() { return switch_active_passive_tick_; }
+	/// event in port of type void, fires urgent events and the next bulk events
+	auto& work_tick() { return in_send_tick; }
+
+	in_port_t& in() override { return in_event_port; }
+	out_port_t& out() override { return out_event_port; }
+
+	/// sends the events of both sides at once, while neither region works.
+	void flush() override
+	{
+		switch_active_passive_buffers();
+		send_events();
+	}
+
+	/**
+	 * \brief returns the number of bulk events waiting for later work ticks.
+	 *
+	 * Updated on work ticks only, can be called from any thread.
+	 */
+	size_t backlog_size() const { return backlog_events.load(std::memory_order_relaxed); }
+
+private:
+	friend class switch_registry;
+
+	/// \post intern_buffer.empty()
+	void switch_active_buffers()
+	{
+		if (read)
+			swap(intern_buffer, middle_buffer);
+		else
+			middle_buffer.append(intern_buffer);
+		read = false;
+		intern_buffer.clear();
+	}
+
+	/// \post middle_buffer.empty()
+	void switch_passive_buffers()
+	{
+		swap(middle_buffer, extern_buffer);
+		read = true;
+		middle_buffer.clear();
+	}
+
+	/// \post intern_buffer.empty()
+	void switch_active_passive_buffers()
+	{
+		extern_buffer.append(intern_buffer);
+	}
+
+	/// \post extern_buffer is empty
+	void send_events()
+	{
+		detail::fire_in_order<event_t>(out_event_port, extern_buffer.urgent);
+		auto& bulk = extern_buffer.bulk;
+		if (backlog.empty() && bulk.size() <= max_bulk_per_tick)
+		{
+			// without backlog the events are sent from where they are.
+			detail::fire_in_order<event_t>(out_event_port, bulk);
+		}
+		else
+		{
+			backlog.insert(end(backlog), std::make_move_iterator(begin(bulk)),
+					std::make_move_iterator(end(bulk)));
+			const size_t nr_of_events = std::min(backlog.size(), max_bulk_per_tick);
+			detail::fire_in_order(out_event_port, span<event_t>{backlog.data(), nr_of_events});
+			backlog.erase(begin(backlog), begin(backlog) + nr_of_events);
+		}
+		extern_buffer.clear();
+		backlog_events.store(backlog.size(), std::memory_order_relaxed);
+	}
+
+	using buffer_t = detail::priority_lanes<event_t>;
+
+	pure::event_sink<void> switch_active_tick_;
+	pure::event_sink<void> switch_passive_tick_;
+	pure::event_sink<void> switch_active_passive_tick_;
+	pure::event_sink<void> in_send_tick;
+	in_port_t in_event_port;
+	out_port_t out_event_port;
+
+	buffer_t intern_buffer;
+	buffer_t extern_buffer;
+	buffer_t middle_buffer;
+	bool read = false;
+	const size_t max_bulk_per_tick;
+	/// bulk events not yet sent, only accessed by the passive side.
+	std::vector<event_t> backlog;
+	std::atomic<size_t> backlog_events{0};
+};
+
+template<class event_t>
+constexpr size_t priority_event_buffer<event_t>::unbounded;
+
+/**
+ * \brief customization point to transport the changes of states instead of full copies.
+ *
+ * Specialize it for large states, of which only small parts change between cycles, like maps.
+ * A delta_state_buffer then only passes patches to the reading region.
+ * \code{cpp}
+ * template<> struct state_delta<grid_map>
+ * {
+ *     using patch_t = std::vector<cell_change>;
+ *     static patch_t diff(const grid_map& old, const grid_map& current);
+ *     static void patch(grid_map& state, const patch_t& changes);
+ * };
+ * \endcode
+ * patch(old, diff(old, current)) needs to make old equal to current.
+ */
+template<class state_t>
+struct state_delta
+{
+};
+
+namespace detail
+{
+/// checks if state_delta is specialized for state_t
+template<class state_t, class = void>
+struct has_state_delta : std::false_type {};
+
+template<class state_t>
+struct has_state_delta<state_t, decltype(void(state_delta<state_t>::diff(
+		std::declval<const state_t&>(), std::declval<const state_t&>())))>
+	: std::true_type {};
+
+/// number of patches a delta_state_buffer queues, before it sends a full copy instead.
+constexpr size_t default_max_patches = 64;
+
+/// changes of a state collected by one stage of delta_state_buffer.
+template<class state_t>
+struct state_changes
+{
+	using patch_t = typename state_delta<state_t>::patch_t;
+
+	/// appends the changes of newer, a snapshot in newer replaces all changes before it.
+	void append(state_changes& newer)
+	{
+		if (newer.snapshot)
+		{
+			patches.clear();
+			snapshot = std::move(newer.snapshot);
+		}
+		patches.insert(end(patches), std::make_move_iterator(begin(newer.patches)),
+				std::make_move_iterator(end(newer.patches)));
+		newer.clear();
+	}
+
+	/// applies all changes to state, which is empty before the first snapshot.
+	void apply_to(std::unique_ptr<state_t>& state)
+	{
+		if (snapshot)
+			state = std::move(snapshot);
+		assert(state || patches.empty());
+		for (const auto& p : patches)
+			state_delta<state_t>::patch(*state, p);
+		clear();
+	}
+
+	/// removes all changes, but keeps the memory of patches.
+	void clear()
+	{
+		snapshot.reset();
+		patches.clear();
+	}
+
+	friend void swap(state_changes& lhs, state_changes& rhs)
+	{
+		using std::swap;
+		swap(lhs.snapshot, rhs.snapshot);
+		swap(lhs.patches, rhs.patches);
+	}
+
+	/// full copy the patches apply to, empty if they apply to the previous state.
+	std::unique_ptr<state_t> snapshot;
+	std::vector<patch_t> patches;
+};
+}
+
+/**
+ * \brief selects the buffer used for connections between regions.
+ * \see node_aware::set_buffer_config
+ */
+struct buffer_config
+{
+	enum buffer_kind
+	{
+		/// event_buffer, which grows as needed.
+		vector_buffer,
+		/// ring_event_buffer of fixed capacity, events of type void always use event_buffer.
+		ring_buffer,
+		/// coalescing_event_buffer, events of type void always use event_buffer.
+		coalescing_buffer,
+		/// priority_event_buffer, events of type void always use event_buffer.
+		priority_buffer
+	};
+
+	buffer_kind kind = vector_buffer;
+	/// minimum capacity of a ring_buffer
+	size_t capacity = ring_event_buffer<int>::default_capacity;
+	/// maximum number of events stored by each stage of a vector_buffer
+	size_t max_events = event_buffer<int>::unbounded;
+	/// events dropped by a vector_buffer which reached max_events or a full ring_buffer
+	overflow_policy overflow = overflow_policy::drop_oldest;
+	/// called with the number of events dropped in a cycle, if not empty.
+	std::function<void(size_t)> overflow_handler{};
+	/// number of bulk events a priority_buffer sends per cycle at most
+	size_t max_bulk_events = priority_event_buffer<int>::unbounded;
+	/// events a vector_buffer sends per cycle at most, see event_buffer::set_drain_limit
+	size_t drain_max_events = event_buffer<int>::unbounded;
+	/// time a vector_buffer sends events per cycle at most, see event_buffer::set_drain_limit
+	wall_clock::steady::duration drain_budget = wall_clock::steady::duration::max();
+	/// number of events a vector_buffer allocates memory for upfront
+	size_t reserved_events = 0;
+	/**
+	 * \brief every n-th event of a vector_buffer is traced, 0 disables tracing.
+	 * \see event_buffer::trace_latency
+	 */
+	size_t latency_sampling = 0;
+	/**
+	 * \brief histogram the latencies are recorded to.
+	 * If empty, ports in a connection_graph record to the histogram of the connection's edge.
+	 */
+	std::shared_ptr<thread::duration_histogram> latency_histogram{};
+	enum state_buffer_kind
+	{
+		/// state_buffer, states stay the same during a cycle of the reading region.
+		snapshot_state,
+		/// latest_state_buffer, reads return the newest state without switch ticks.
+		latest_state,
+		/// delta_state_buffer, states without a state_delta always use state_buffer.
+		delta_state
+	};
+
+	/// buffer of state sinks reading from other regions
+	state_buffer_kind state_kind = snapshot_state;
+	/// number of patches a delta_state buffer queues, before it sends a full copy instead.
+	size_t max_pending_patches = detail::default_max_patches;
+};
+
+/// Implementation of buffer_interface, which directly forwards state.
+template<class data_t>
+class state_no_buffer final : public buffer_interface<data_t, state_tag>
+{
+public:
+	state_no_buffer()
+	: 	out_port( [this]() -> data_t { return in_port.get();})
+	{
+	}
+
+	pure::state_sink<data_t>& in() override
+	{
+		return in_port;
+	}
+	pure::state_source<data_t>& out() override
+	{
+		return out_port;
+	}
+
+private:
+	pure::state_sink<data_t> in_port;
+	pure::state_source<data_t> out_port;
+};
+
+/**
+ * \brief buffer for states using triple buffering
+ *
+ * States are stored in three slots, which are exchanged by swapping indices,
+ * thus a switch tick takes constant time independent of the size of data_t.
+ * The work tick of the passive region pulls a new state into the intern slot,
+ * its switch tick publishes the intern slot as middle slot, if it holds a new state.
+ * The switch tick of the active region takes a newly published middle slot as extern slot,
+ * from which states are read. Publishing and taking the middle slot is a single atomic
+ * exchange, so the switch ticks of both regions don't need to be ordered.
+ *
+ * Until a state has been received, the buffer returns a default constructed state if data_t
+ * is default constructible and throws std::runtime_error otherwise.
+ *
+ * \tparam data_t type of state stored in buffer. needs to be move_constructable.
+ * If data_t is a const reference, the buffer stores a copy of the referenced state
+ * and lends it to the active side until its next switch tick.
+ */
+template<class data_t>
+class state_buffer final : public buffer_interface<data_t, state_tag>
+{
+public:
+	state_buffer();
+
+	/// event in port of type void, switches incoming buffers
+	auto& switch_active_tick() { return switch_active_tick_; }
+	/// event in port of type void, switches outgoing buffers
+	auto& switch_passive_tick() { return switch_passive_tick_; }
+	/// event in port of type void, directly switches active- and passive-side buffers
+	auto& switch_active_passive_tick() { return switch_active_passive_tick_; }
+	/// event in port of type void, pulls data at in_port
+	auto& work_tick() { return in_work_tick; }
+
+	pure::state_sink<data_t>& in() override
+	{
+		return in_port;
+	}
+	pure::state_source<data_t>& out() override
+	{
+		return out_port;
+	}
+
+	/// type of the stored states
+	using value_t = std::decay_t<data_t>;
+
+	/**
+	 * \brief returns the state readable by the active side without copying it.
+	 * \returns nullptr if no state has been received yet.
+	 * The state is valid until the next switch tick of the active region.
+	 */
+	const value_t* current() const
+	{
+		return slots[extern_slot].get();
+	}
+
+private:
+	friend class switch_registry;
+
+	/// set in middle_slot if the slot holds a state the active side has not taken yet.
+	static constexpr uint8_t fresh = 4;
+	static constexpr uint8_t index_mask = 3;
+
+	void pull()
+	{
+		auto& slot = slots[intern_slot];
+		if (slot)
+			*slot = in_port.get();
+		else
+			slot = std::make_unique<value_t>(in_port.get());
+		intern_fresh = true;
+	}
+
+	void switch_passive_buffers()
+	{
+		// without a new state, the last published one stays in the middle slot.
+		if (!intern_fresh)
+			return;
+		intern_slot = middle_slot.exchange(intern_slot | fresh) & index_mask;
+		intern_fresh = false;
+	}
+
+	void switch_active_buffers()
+	{
+		if (!(middle_slot.load() & fresh))
+			return;
+		extern_slot = middle_slot.exchange(extern_slot) & index_mask;
+	}
+
+	void switch_active_passive_buffers()
+	{
+		switch_passive_buffers();
+		switch_active_buffers();
+	}
+
+	data_t read() const
+	{
+		if (const auto state = current())
+			return *state;
+		return initial_state(std::is_default_constructible<value_t>{});
+	}
+
+	static data_t initial_state(std::true_type)
+	{
+		// borrowed reads need an object to refer to.
+		static const value_t empty{};
+		return empty;
+	}
+	static data_t initial_state(std::false_type)
+	{
+		throw std::runtime_error{"state_buffer has not received a state yet"};
+	}
+
+	pure::event_sink<void> switch_active_tick_;
+	pure::event_sink<void> switch_passive_tick_;
+	pure::event_sink<void> switch_active_passive_tick_;
+	pure::event_sink<void> in_work_tick;
+	pure::state_sink<data_t> in_port;
+	pure::state_source<data_t> out_port;
+
+	/// empty until a state has been pulled into them.
+	std::unique_ptr<value_t> slots[3];
+	/// slot written by the work tick, only accessed by the passive side.
+	uint8_t intern_slot;
+	/// true if the intern slot holds a state not published yet.
+	bool intern_fresh;
+	/// slot exchanged between both sides, index and fresh flag.
+	std::atomic<uint8_t> middle_slot;
+	/// slot read from, only accessed by the active side.
+	uint8_t extern_slot;
+};
+
+/**
+ * \brief buffer for states, which hands the newest state to the reader without switch ticks.
+ *
+ * Lock-free triple buffer: the work tick of the passive region pulls a state into the write
+ * slot and publishes it right away by exchanging it with the middle slot. Every read takes
+ * a newly published middle slot first, thus always returns the latest complete state.
+ * Neither side waits for the other and the ticks of both regions need no fixed order,
+ * which lets regions exchange states independent of their tick rates and phases.
+ *
+ * Unlike state_buffer, consecutive reads within a cycle may return different states.
+ * Reads have to come from one thread at a time, as do the work ticks.
+ *
+ * \tparam data_t type of state stored in buffer. needs to be move_constructable.
+ * If data_t is a const reference, the returned reference stays valid until the next read.
+ */
+template<class data_t>
+class latest_state_buffer final : public buffer_interface<data_t, state_tag>
+{
+public:
+	latest_state_buffer();
+
+	/// event in port of type void, pulls data at in_port and publishes it
+	auto& work_tick() { return in_work_tick; }
+
+	pure::state_sink<data_t>& in() override
+	{
+		return in_port;
+	}
+	pure::state_source<data_t>& out() override
+	{
+		return out_port;
+	}
+
+	/// type of the stored states
+	using value_t = std::decay_t<data_t>;
+
+private:
+	/// set in middle_slot if the slot holds a state the reader has not taken yet.
+	static constexpr uint8_t fresh = 4;
+	static constexpr uint8_t index_mask = 3;
+
+	void publish()
+	{
+		auto& slot = slots[write_slot];
+		if (slot)
+			*slot = in_port.get();
+		else
+			slot = std::make_unique<value_t>(in_port.get());
+		// release makes the state visible to the reader, acquire waits until it has left the slot.
+		write_slot = middle_slot.exchange(write_slot | fresh, std::memory_order_acq_rel)
+				& index_mask;
+	}
+
+	data_t read()
+	{
+		if (middle_slot.load(std::memory_order_acquire) & fresh)
+			read_slot = middle_slot.exchange(read_slot, std::memory_order_acq_rel) & index_mask;
+		if (const auto& state = slots[read_slot])
+			return *state;
+		return initial_state(std::is_default_constructible<value_t>{});
+	}
+
+	static data_t initial_state(std::true_type)
+	{
+		static const value_t empty{};
+		return empty;
+	}
+	static data_t initial_state(std::false_type)
+	{
+		throw std::runtime_error{"latest_state_buffer has not received a state yet"};
+	}
+
+	pure::event_sink<void> in_work_tick;
+	pure::state_sink<data_t> in_port;
+	pure::state_source<data_t> out_port;
+
+	/// empty until a state has been pulled into them.
+	std::unique_ptr<value_t> slots[3];
+	/// slot written by the work tick, only accessed by the writer.
+	uint8_t write_slot;
+	/// slot exchanged between both sides, index and fresh flag.
+	std::atomic<uint8_t> middle_slot;
+	/// slot read from, only accessed by the reader.
+	uint8_t read_slot;
+};
+
+/**
+ * \brief buffer for states, which only passes the changes of states to the reading region.
+ *
+ * The work tick of the passive region pulls the state and computes a patch
+ * against the previous state with state_delta, the first state is sent as full copy.
+ * Switch ticks pass the patches on like event_buffer passes events and
+ * the switch tick of the active region applies them to its copy of the state.
+ * Thus copies per cycle scale with the changes instead of the size of the state.
+ * If the active region lags behind by more than max_patches pulls,
+ * the queued patches are replaced by a full copy.
+ *
+ * Like for event_buffer, the switch ticks of both regions must not overlap.
+ *
+ * \tparam data_t type of state, state_delta needs to be specialized for its decayed type.
+ * If data_t is a const reference, the buffer lends its copy to the active side
+ * until its next switch tick.
+ */
+template<class data_t>
+class delta_state_buffer final : public buffer_interface<data_t, state_tag>
+{
+public:
+	/// type of the stored states
+	using value_t = std::decay_t<data_t>;
+	static_assert(detail::has_state_delta<value_t>{},
+			"delta_state_buffer needs a specialization of state_delta.");
+
+	/// \param max_patches number of queued patches, before a full copy is sent instead.
+	explicit delta_state_buffer(size_t max_patches = detail::default_max_patches);
+
+	/// event in port of type void, switches incoming buffers
+	auto& switch_active_tick() { return switch_active_tick_; }
+	/// event in port of type void, switches outgoing buffers
+	auto& switch_passive_tick() { return switch_passive_tick_; }
+	/// event in port of type void, directly switches active- and passive-side buffers
+	auto& switch_active_passive_tick() { return switch_active_passive_tick_; }
+	/// event in port of type void, pulls data at in_port
+	auto& work_tick() { return in_work_tick; }
+
+	pure::state_sink<data_t>& in() override
+	{
+		return in_port;
+	}
+	pure::state_source<data_t>& out() override
+	{
+		return out_port;
+	}
+
+	/**
+	 * \brief returns the state readable by the active side without copying it.
+	 * \returns nullptr if no state has been received yet.
+	 * The state is valid until the next switch tick of the active region.
+	 */
+	const value_t* current() const
+	{
+		return materialised.get();
+	}
+
+private:
+	friend class switch_registry;
+
+	using changes_t = detail::state_changes<value_t>;
+
+	void pull()
+	{
+		const auto& state = in_port.get();
+		if (!sent)
+		{
+			sent = std::make_unique<value_t>(state);
+			intern.snapshot = std::make_unique<value_t>(state);
+			return;
+		}
+		auto patch = state_delta<value_t>::diff(*sent, state);
+		state_delta<value_t>::patch(*sent, patch);
+		intern.patches.push_back(std::move(patch));
+	}
+
+	void switch_passive_buffers()
+	{
+		if (taken)
+			swap(intern, middle);
+		else
+			middle.append(intern);
+		taken = false;
+		intern.clear();
+		// sent holds the result of all pulls, which replaces the patches of a lagging reader.
+		if (middle.patches.size() > max_patches)
+		{
+			middle.clear();
+			middle.snapshot = std::make_unique<value_t>(*sent);
+		}
+	}
+
+	void switch_active_buffers()
+	{
+		if (taken)
+			return;
+		middle.apply_to(materialised);
+		taken = true;
+	}
+
+	void switch_active_passive_buffers()
+	{
+		intern.apply_to(materialised);
+	}
+
+	data_t read() const
+	{
+		if (const auto state = current())
+			return *state;
+		return initial_state(std::is_default_constructible<value_t>{});
+	}
+
+	static data_t initial_state(std::true_type)
+	{
+		static const value_t empty{};
+		return empty;
+	}
+	static data_t initial_state(std::false_type)
+	{
+		throw std::runtime_error{"delta_state_buffer has not received a state yet"};
+	}
+
+	pure::event_sink<void> switch_active_tick_;
+	pure::event_sink<void> switch_passive_tick_;
+	pure::event_sink<void> switch_active_passive_tick_;
+	pure::event_sink<void> in_work_tick;
+	pure::state_sink<data_t> in_port;
+	pure::state_source<data_t> out_port;
+
+	const size_t max_patches;
+	/// result of all pulls so far, only accessed by the passive side.
+	std::unique_ptr<value_t> sent;
+	changes_t intern;
+	changes_t middle;
+	/// true if the active side has applied middle.
+	bool taken;
+	/// state with all patches applied, only accessed by the active side.
+	std::unique_ptr<value_t> materialised;
+};
+
+namespace detail
+{
+template<class data_t, class tag>
+struct no_buffer {};
+
+template<class data_t>
+struct no_buffer<data_t, event_tag>
+{
+	using type = event_no_buffer<data_t>;
+};
+
+template<class data_t>
+struct no_buffer<data_t, state_tag>
+{
+	using type = state_no_buffer<data_t>;
+};
+
+template<class data_t, class tag>
+struct buffer {};
 
 template<class data_t>
 struct buffer<data_t, event_tag>
@@ -391,6 +1970,105 @@ struct buffer<data_t, state_tag>
 {
 	using type = state_buffer<data_t>;
 };
+
+/// void events are only counted by event_buffer, there is nothing to gain from a ring.
+template<class data_t>
+struct ring_buffer
+{
+	using type = ring_event_buffer<data_t>;
+	static auto make(const buffer_config& config)
+	{
+		auto result = std::make_shared<type>(config.capacity, config.overflow);
+		if (config.overflow_handler)
+			result->overflow() >> config.overflow_handler;
+		return result;
+	}
+};
+
+template<>
+struct ring_buffer<void>
+{
+	using type = event_buffer<void>;
+	static auto make(const buffer_config&) { return std::make_shared<type>(); }
+};
+
+/// void events are only counted, there is no memory to limit.
+template<class data_t>
+struct bounded_buffer
+{
+	/// \param memory account the buffer charges, nullptr if it is not accounted.
+	static auto make(const buffer_config& config,
+			std::shared_ptr<thread::memory_account> memory = nullptr)
+	{
+		auto result = std::make_shared<event_buffer<data_t>>(config.max_events, config.overflow);
+		if (memory)
+			result->account_memory(std::move(memory));
+		result->reserve(config.reserved_events);
+		if (config.drain_max_events != event_buffer<data_t>::unbounded
+				|| config.drain_budget != wall_clock::steady::duration::max())
+			result->set_drain_limit(config.drain_max_events, config.drain_budget);
+		if (config.latency_sampling > 0 && config.latency_histogram)
+			result->trace_latency(config.latency_histogram, config.latency_sampling);
+		if (config.overflow_handler)
+			result->overflow() >> config.overflow_handler;
+		return result;
+	}
+};
+
+template<>
+struct bounded_buffer<void>
+{
+	/// counting void events takes no memory to account.
+	static auto make(const buffer_config&, std::shared_ptr<thread::memory_account> = nullptr)
+	{
+		return std::make_shared<event_buffer<void>>();
+	}
+};
+
+template<class data_t>
+struct coalescing_buffer
+{
+	using type = coalescing_event_buffer<data_t>;
+};
+
+/// there is no value to coalesce for void events.
+template<>
+struct coalescing_buffer<void>
+{
+	using type = event_buffer<void>;
+};
+
+template<class data_t>
+struct priority_buffer
+{
+	static auto make(size_t max_bulk_events)
+	{
+		return std::make_shared<priority_event_buffer<data_t>>(max_bulk_events);
+	}
+};
+
+/// creates a delta_state_buffer for states with state_delta, state_buffer otherwise.
+template<class data_t, bool = has_state_delta<std::decay_t<data_t>>{}>
+struct delta_buffer
+{
+	static auto make(size_t max_patches)
+	{
+		return std::make_shared<delta_state_buffer<data_t>>(max_patches);
+	}
+};
+
+template<class data_t>
+struct delta_buffer<data_t, false>
+{
+	static auto make(size_t) { return std::make_shared<state_buffer<data_t>>(); }
+};
+
+/// void events carry nothing to tell urgent from bulk events.
+template<>
+struct priority_buffer<void>
+{
+	static auto make(size_t) { return std::make_shared<event_buffer<void>>(); }
+};
 }
 
 } // namespace fc
@@ -401,12 +2079,53 @@ inline fc::state_buffer<T>::state_buffer() :
 		switch_active_tick_([this] { switch_active_buffers(); }),
 		switch_passive_tick_([this] { switch_passive_buffers(); }),
 		switch_active_passive_tick_([this] { switch_active_passive_buffers(); }),
-		in_work_tick([this]() { intern_buffer = in_port.get(); }),
+		in_work_tick([this]() { pull(); }),
+		in_port(),
+		out_port([this]() -> T { return read(); }),
+		slots(),
+		intern_slot(0),
+		intern_fresh(false),
+		middle_slot(1),
+		extern_slot(2)
+{
+}
+
+template<class T>
+constexpr uint8_t fc::state_buffer<T>::fresh;
+template<class T>
+constexpr uint8_t fc::state_buffer<T>::index_mask;
+
+template<class T>
+inline fc::latest_state_buffer<T>::latest_state_buffer() :
+		in_work_tick([this]() { publish(); }),
+		in_port(),
+		out_port([this]() -> T { return read(); }),
+		slots(),
+		write_slot(0),
+		middle_slot(1),
+		read_slot(2)
+{
+}
+
+template<class T>
+constexpr uint8_t fc::latest_state_buffer<T>::fresh;
+template<class T>
+constexpr uint8_t fc::latest_state_buffer<T>::index_mask;
+
+template<class T>
+inline fc::delta_state_buffer<T>::delta_state_buffer(size_t max_patches) :
+		switch_active_tick_([this] { switch_active_buffers(); }),
+		switch_passive_tick_([this] { switch_passive_buffers(); }),
+		switch_active_passive_tick_([this] { switch_active_passive_buffers(); }),
+		in_work_tick([this]() { pull(); }),
 		in_port(),
-		out_port([this](){ return extern_buffer; }),
-		intern_buffer(), //todo, forces T to be default constructible, we should lift that restriction.
-		extern_buffer(),
-		middle_buffer()
+		out_port([this]() -> T { return read(); }),
+		max_patches(max_patches),
+		sent(),
+		intern(),
+		middle(),
+		taken(true),
+		materialised()
 {
 }
 
@@ -38,36 +38,96 @@ template<class token_t>
 struct buffer_factory
 {
 	/**
-	 * \brief Creates buffer or no_buffer depending on regions of active and passive
-	 * \returns either buffer if the regions differ and no_buffer if they are from the same region.
-	 * \param active active port of the connection
-	 * \param passive passive port of the connection
+	 * \brief Creates buffer for events as selected by the buffer_config of active.
+	 * \returns no_buffer if active and passive are from the same region.
 	 */
-	template<class active_t, class passive_t, class tag>
+	template<class active_t, class passive_t>
 	static auto construct_buffer(const active_t& active,
-			const passive_t& passive, tag)
-			-> std::shared_ptr<buffer_interface<token_t, tag>>
+			const passive_t& passive, event_tag)
+			-> std::shared_ptr<buffer_interface<token_t, event_tag>>
 	{
-		if (!same_region(active, passive))
+		if (same_region(active, passive))
+			return std::make_shared<typename detail::no_buffer<token_t, event_tag>::type>();
+		if (active.get_buffer_config().kind == buffer_config::ring_buffer)
+			return connect_ticks(
+					detail::ring_buffer<token_t>::make(active.get_buffer_config()),
+					active, passive);
+		if (active.get_buffer_config().kind == buffer_config::coalescing_buffer)
+			return connect_ticks(
+					std::make_shared<typename detail::coalescing_buffer<token_t>::type>(),
+					active, passive);
+		if (active.get_buffer_config().kind == buffer_config::priority_buffer)
+			return connect_ticks(detail::priority_buffer<token_t>::make(
+					active.get_buffer_config().max_bulk_events), active, passive);
+		// the events wait for the passive region, which is charged for them.
+		return connect_ticks(detail::bounded_buffer<token_t>::make(active.get_buffer_config(),
+				passive.region().shared_memory_account()), active, passive);
+	}
+
+	/**
+	 * \brief Creates buffer for states as selected by the buffer_config of active.
+	 * \returns no_buffer if active and passive are from the same region.
+	 * \param active state sink of the connection
+	 * \param passive state source of the connection
+	 */
+	template<class active_t, class passive_t>
+	static auto construct_buffer(const active_t& active,
+			const passive_t& passive, state_tag)
+			-> std::shared_ptr<buffer_interface<token_t, state_tag>>
+	{
+		if (same_region(active, passive))
+			return std::make_shared<typename detail::no_buffer<token_t, state_tag>::type>();
+		if (active.get_buffer_config().state_kind == buffer_config::latest_state)
 		{
-			auto result_buffer =
-					std::make_shared<typename detail::buffer<token_t, tag>::type>();
-
-			if(same_tick_rate(active, passive))
-			{
-				active.region().switch_tick() >> result_buffer->switch_active_passive_tick();
-			}
-			else
-			{
-				active.region().switch_tick() >> result_buffer->switch_active_tick();
-				passive.region().switch_tick() >> result_buffer->switch_passive_tick();
-			}
+			// the buffer is independent of switch ticks.
+			auto result_buffer = std::make_shared<latest_state_buffer<token_t>>();
 			passive.region().work_tick() >> result_buffer->work_tick();
-
 			return result_buffer;
 		}
+		if (active.get_buffer_config().state_kind == buffer_config::delta_state)
+			return connect_ticks(detail::delta_buffer<token_t>::make(
+					active.get_buffer_config().max_pending_patches), active, passive);
+		return connect_ticks(
+				std::make_shared<typename detail::buffer<token_t, state_tag>::type>(),
+				active, passive);
+	}
+
+private:
+	/// keeps the switches of a buffer registered with its regions, as long as it is used.
+	template<class buffer_t>
+	struct registered_buffer
+	{
+		std::shared_ptr<buffer_t> buffer;
+		// declared after buffer, so the switches are removed before it is destroyed.
+		switch_handle active_switch;
+		switch_handle passive_switch;
+	};
+
+	/**
+	 * \brief adds the switches of buffer to the regions of active and passive
+	 * and connects the work tick of passive to it.
+	 * \returns buffer, sharing ownership with the handles of its switches.
+	 */
+	template<class buffer_t, class active_t, class passive_t>
+	static std::shared_ptr<buffer_t> connect_ticks(std::shared_ptr<buffer_t> result_buffer,
+			const active_t& active, const passive_t& passive)
+	{
+		using phase = switch_registry::phase;
+		auto registered = std::make_shared<registered_buffer<buffer_t>>();
+		registered->buffer = std::move(result_buffer);
+		auto& buffer = *registered->buffer;
+		if(same_tick_rate(active, passive))
+		{
+			registered->active_switch = active.region().add_switch(buffer, phase::active_passive);
+		}
 		else
-			return std::make_shared<typename detail::no_buffer<token_t, tag>::type>();
+		{
+			registered->active_switch = active.region().add_switch(buffer, phase::active);
+			registered->passive_switch = passive.region().add_switch(buffer, phase::passive);
+		}
+		passive.region().work_tick() >> buffer.work_tick();
+
+		return std::shared_ptr<buffer_t>(std::move(registered), &buffer);
 	}
 };
 
@@ -76,7 +136,8 @@ struct buffer_factory
  *
  * Connection that contains a buffer_interface (see buffer_factory).
  * This will be a buffer if source and sink are from different regions,
- * a no_buffer otherwise.
+ * a no_buffer otherwise. Buffers between regions, which never run at the same time,
+ * are bypassed while cycle_control elides them, see buffer_elision.
  *
  * \tparam base_connection connection type, the buffer is mixed into.
  * \invariant buffer != null_ptr
@@ -88,21 +149,58 @@ struct buffered_event_connection: base_connection
 
 	buffered_event_connection(std::shared_ptr<
 			buffer_interface<result_t, event_tag>> new_buffer,
+			std::shared_ptr<const buffer_elision> new_elision,
 			const base_connection& base) :
-			base_connection(base), buffer(new_buffer)
+			base_connection(base), buffer(new_buffer), elision(std::move(new_elision))
 	{
 		assert(buffer);
 	}
 
+	/// passes events to the buffer, or past it to the sink while the buffer is elided.
 	template<class... T>
 	void operator()(T&&... in)
 	{
 		assert(buffer);
-		buffer->in()(std::forward<T>(in)...);
+		if (elided())
+			buffer->out().fire(std::forward<T>(in)...);
+		else
+			buffer->in()(std::forward<T>(in)...);
+	}
+
+	/// passes a batch of events to the buffer at once.
+	template<class T = result_t>
+	void receive_batch(span<const std::enable_if_t<!std::is_void<T>{}, T>> events)
+	{
+		assert(buffer);
+		if (elided())
+			buffer->out().fire_batch(events);
+		else
+			buffer->in().receive_batch(events);
+	}
+
+	/// passes a number of void events to the buffer at once.
+	template<class T = result_t, class = std::enable_if_t<std::is_void<T>{}>>
+	void receive_count(size_t n)
+	{
+		assert(buffer);
+		if (elided())
+			buffer->out().fire_count(n);
+		else
+			buffer->in().receive_count(n);
+	}
+
+	bool accepts_batches() const
+	{
+		assert(buffer);
+		return buffer->in().accepts_batches();
 	}
 
 private:
+	bool elided() const { return elision && elision->elided.load(std::memory_order_relaxed); }
+
 	std::shared_ptr<buffer_interface<result_t, event_tag>> buffer;
+	/// nullptr for connections within a region.
+	std::shared_ptr<const buffer_elision> elision;
 };
 
 /**
@@ -117,19 +215,25 @@ struct buffered_state_connection: base_connection
 
 	buffered_state_connection(std::shared_ptr<
 			buffer_interface<result_t, state_tag>> new_buffer,
+			std::shared_ptr<const buffer_elision> new_elision,
 			const base_connection& base) :
-			base_connection(base), buffer(new_buffer)
+			base_connection(base), buffer(new_buffer), elision(std::move(new_elision))
 	{
 		assert(buffer);
 	}
 
+	/// pulls the buffered state, or the state of the source while the buffer is elided.
 	result_t operator()(void)
 	{
+		if (elision && elision->elided.load(std::memory_order_relaxed))
+			return buffer->in().get();
 		return buffer->out()();
 	}
 
 private:
 	std::shared_ptr<buffer_interface<result_t, state_tag>> buffer;
+	/// nullptr for connections within a region.
+	std::shared_ptr<const buffer_elision> elision;
 };
 
 ///node_aware ports inherit these properties from their base
@@ -145,6 +249,20 @@ struct result_of<node_aware<connection<source_t, sink_t>>>
 namespace detail
 {
 
+/**
+ * \brief registers a connection from the region of active to that of passive for elision.
+ * \returns nullptr if both are from the same region, which need no buffer anyway.
+ */
+template<class active_t, class passive_t>
+std::shared_ptr<buffer_elision> make_elision(const active_t& active, const passive_t& passive)
+{
+	if (same_region(active, passive))
+		return nullptr;
+	auto elision = std::make_shared<buffer_elision>(active.region().get_id());
+	passive.region().add_buffer_elision(elision);
+	return elision;
+}
+
 /**
  * \brief creates buffered_connection for events
  * \param buffer the buffer used for the connection
@@ -155,10 +273,18 @@ namespace detail
 template<class source_t, class sink_t, class buffer_t>
 auto make_buffered_connection(std::shared_ptr<
         buffer_interface<buffer_t, event_tag>> buffer,
+        std::shared_ptr<buffer_elision> elision,
         const source_t& /*source*/,  //only needed for type deduction
         sink_t&& sink)
 {
 	assert(buffer);
+	// events held from cycles with the buffer are sent before events which bypass it.
+	if (elision)
+		elision->flush = [held = std::weak_ptr<buffer_interface<buffer_t, event_tag>>(buffer)]
+		{
+			if (auto b = held.lock())
+				b->flush();
+		};
 	using base_connection_t = port_connection<
 			typename source_t::base_t,
 			sink_t,
@@ -168,7 +294,7 @@ auto make_buffered_connection(std::shared_ptr<
 	connect(buffer->out(), std::forward<sink_t>(sink));
 
 	return buffered_event_connection<base_connection_t>(std::move(buffer),
-			base_connection_t());
+			std::move(elision), base_connection_t());
 }
 
 /**
@@ -181,6 +307,7 @@ auto make_buffered_connection(std::shared_ptr<
 template<class source_t, class sink_t, class buffer_t>
 auto make_buffered_connection(std::shared_ptr<
 		buffer_interface<buffer_t, state_tag>> buffer,
+		std::shared_ptr<const buffer_elision> elision,
 		source_t&& source,
 		const sink_t&) /*sink*/  //only needed for type deduction
 {
@@ -190,7 +317,7 @@ auto make_buffered_connection(std::shared_ptr<
 	connect(std::forward<source_t>(source), buffer->in());
 
 	return buffered_state_connection<base_connection_t>(std::move(buffer),
-			base_connection_t());
+			std::move(elision), base_connection_t());
 }
 }  // namespace detail
 
@@ -232,6 +359,14 @@ struct node_aware: base
 	///returns reference to parallel_region this mixin is associated with.
 	parallel_region& region() const { return region_; }
 
+	/**
+	 * \brief selects the buffer of connections to other regions.
+	 * Only has an effect on event sources and state sinks and on connections made afterwards.
+	 */
+	void set_buffer_config(buffer_config config) { buffer_config_ = config; }
+	/// returns the buffer_config for new connections to other regions.
+	const buffer_config& get_buffer_config() const { return buffer_config_; }
+
 private:
 	// helper aliases to make method prototypes easier to read.
 	using connection_has_node_aware = std::true_type;
@@ -240,6 +375,7 @@ private:
 	using base_is_sink = std::false_type;
 
 	std::reference_wrapper<parallel_region> region_;
+	buffer_config buffer_config_{};
 
 	template <class conn_t>
 	auto connect_impl(conn_t&& conn, connection_has_node_aware)
@@ -263,7 +399,8 @@ private:
 				buffer_factory<result_t>::construct_buffer(
 						*this,  // event source is active, thus first
 						sink,  // event sink is passive thus second
-						event_tag()), *this, std::forward<conn_t>(conn));
+						event_tag()),
+				detail::make_elision(*this, sink), *this, std::forward<conn_t>(conn));
 	}
 
 	template <class conn_t>
@@ -275,7 +412,8 @@ private:
 				buffer_factory<result_t>::construct_buffer(
 						*this,  // state sink is active thus first
 						source,  // state source is passive thus second
-						state_tag()), std::forward<conn_t>(conn), *this);
+						state_tag()),
+				detail::make_elision(*this, source), std::forward<conn_t>(conn), *this);
 	}
 
 	template <class conn_t>
@@ -7,8 +7,11 @@
 #include <boost/algorithm/string/replace.hpp>
 
 #include <cassert>
+#include <chrono>
+#include <iomanip>
 #include <map>
 #include <ostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -37,12 +40,17 @@ struct visualization::impl
 	void print_ports(const std::vector<graph::graph_properties>& ports, unsigned long owner_hash,
 			std::ostream& stream);
 	static std::string escape_label(const std::string& label);
+	std::string rate_label(const graph::graph_edge& edge, graph::graph_port_properties::port_type type,
+			const std::map<graph::unique_id, graph::port_statistics>& statistics,
+			double seconds) const;
 
 	const graph::connection_graph& graph_;
 	const forest_t& forest_;
 	const std::set<graph::graph_properties>& ports_;
 	std::map<std::string, unsigned int> color_map_ {};
 	unsigned int current_color_index_ = 0U;
+	std::map<graph::unique_id, graph::port_statistics> last_statistics_ {};
+	std::chrono::steady_clock::time_point last_visualization_ = std::chrono::steady_clock::now();
 };
 
 graph::graph_port_properties::port_type visualization::impl::merge_property_types(
@@ -196,16 +204,48 @@ std::string visualization::impl::escape_label(const std::string& label)
 	return s;
 }
 
+std::string visualization::impl::rate_label(const graph::graph_edge& edge,
+		graph::graph_port_properties::port_type type,
+		const std::map<graph::unique_id, graph::port_statistics>& statistics,
+		double seconds) const
+{
+	using port_type = graph::graph_port_properties::port_type;
+	// events are counted by the source, states by the sink, which pulls them.
+	const auto& port = type == port_type::STATE ? edge.sink : edge.source;
+	const auto current = statistics.find(port.port_properties.id());
+	if (current == std::end(statistics) || seconds <= 0.0)
+	{
+		return "";
+	}
+
+	const auto last = last_statistics_.find(port.port_properties.id());
+	const graph::port_statistics previous =
+			last == std::end(last_statistics_) ? graph::port_statistics{} : last->second;
+	std::ostringstream label;
+	label << std::fixed << std::setprecision(1);
+	if (type == port_type::STATE)
+		label << (current->second.pulls - previous.pulls) / seconds << " pulls/s";
+	else
+		label << (current->second.events - previous.events) / seconds << " ev/s";
+	return label.str();
+}
+
 visualization::visualization(const graph::connection_graph& graph, const forest_t& forest)
 	: pimpl{std::make_unique<impl>(graph, forest, graph.ports())}
 {
 	assert(pimpl);
 }
 
-void visualization::visualize(std::ostream& stream)
+void visualization::visualize(std::ostream& stream, bool annotate_rates)
 {
 	pimpl->current_color_index_ = 0U;
 
+	const auto now = std::chrono::steady_clock::now();
+	const auto seconds =
+			std::chrono::duration<double>(now - pimpl->last_visualization_).count();
+	const auto statistics = annotate_rates ? pimpl->graph_.statistics()
+			: std::map<graph::unique_id, graph::port_statistics>{};
+
 	// nodes with their ports that are part of the forest
 	stream << "digraph G {\n";
 	stream << "rankdir=\"LR\"\n";
@@ -232,14 +272,29 @@ void visualization::visualize(std::ostream& stream)
 
 		// draw arrow differently based on whether it is an event or state
 		const auto merged_type = pimpl->merge_property_types(edge.source, edge.sink);
+		const auto rate = annotate_rates
+				? pimpl->rate_label(edge, merged_type, statistics, seconds) : std::string{};
 		if (merged_type == port_type::STATE)
 		{
-			stream << "[arrowhead=\"dot\"]";
+			stream << "[arrowhead=\"dot\"";
+			if (!rate.empty())
+				stream << ", label=\"" << rate << "\"";
+			stream << "]";
+		}
+		else if (!rate.empty())
+		{
+			stream << "[label=\"" << rate << "\"]";
 		}
 		stream << ";\n";
 	}
 
 	stream << "}\n";
+
+	if (annotate_rates)
+	{
+		pimpl->last_statistics_ = statistics;
+		pimpl->last_visualization_ = now;
+	}
 }
 
 visualization::~visualization() = default;
@@ -24,8 +24,15 @@ public:
 	visualization(const graph::connection_graph& graph, const forest_t& forest);
 	~visualization();
 
-	///Prints graphviz format to a given stream
-	void visualize(std::ostream& stream);
+	/**
+	 * \brief Prints graphviz format to a given stream
+	 * \param annotate_rates labels edges with their rates since the last call,
+	 * or since construction of the visualization on the first call.
+	 * Event edges are labeled with events per second of their source,
+	 * state edges with pulls per second of their sink.
+	 * Requires port counters to be enabled in the connection_graph.
+	 */
+	void visualize(std::ostream& stream, bool annotate_rates = false);
 private:
 	struct impl;
 	std::unique_ptr<impl> pimpl;
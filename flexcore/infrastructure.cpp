@@ -10,8 +10,9 @@ class scheduled_region : public fc::parallel_region
 {
 public:
 	scheduled_region(std::string name, virtual_clock::steady::duration tick_rate,
-			std::weak_ptr<region_factory> region_maker)
-		: parallel_region(std::move(name), tick_rate), region_maker(std::move(region_maker))
+			std::shared_ptr<clock_domain> clock, std::weak_ptr<region_factory> region_maker)
+		: parallel_region(std::move(name), tick_rate, std::move(clock))
+		, region_maker(std::move(region_maker))
 	{
 	}
 	std::shared_ptr<parallel_region>
@@ -51,7 +52,8 @@ std::shared_ptr<parallel_region>
 region_factory::new_region(const std::string& name,
                            const virtual_clock::steady::duration& tick_rate)
 {
-	auto region = std::make_shared<scheduled_region>(name, tick_rate, shared_from_this());
+	auto region = std::make_shared<scheduled_region>(
+			name, tick_rate, scheduler.clock(), shared_from_this());
 	auto tick_cycle = fc::thread::periodic_task(region);
 	scheduler.add_task(std::move(tick_cycle),tick_rate);
 	return region;
@@ -66,13 +68,40 @@ infrastructure::add_region(const std::string& name,
 }
 
 infrastructure::infrastructure()
-    : scheduler(std::make_unique<fc::thread::parallel_scheduler>())
+    : infrastructure(thread::thread_config{})
+{
+}
+
+infrastructure::infrastructure(thread::thread_config workers)
+    : scheduler(std::make_unique<fc::thread::parallel_scheduler>(std::move(workers)))
     , region_maker(std::make_shared<detail::region_factory>(scheduler))
     , graph()
     , forest_root(graph, "root", add_region("root_region", thread::cycle_control::medium_tick))
 {
 }
 
+namespace
+{
+/// sets the clock first, as setting it is no longer possible once regions are added.
+std::shared_ptr<detail::region_factory> make_region_factory(
+		thread::cycle_control& scheduler, std::shared_ptr<clock_domain> clock)
+{
+	scheduler.set_clock(std::move(clock));
+	return std::make_shared<detail::region_factory>(scheduler);
+}
+}
+
+infrastructure::infrastructure(std::unique_ptr<thread::scheduler> workers,
+		const std::shared_ptr<thread::main_loop>& loop,
+		std::shared_ptr<clock_domain> clock,
+		std::function<bool(thread::periodic_task&)> on_timeout)
+    : scheduler(std::move(workers), std::move(on_timeout), loop)
+    , region_maker(make_region_factory(scheduler, std::move(clock)))
+    , graph()
+    , forest_root(graph, "root", add_region("root_region", thread::cycle_control::medium_tick))
+{
+}
+
 infrastructure::~infrastructure()
 {
 	stop_scheduler();
@@ -88,6 +117,32 @@ void infrastructure::iterate_main_loop()
 	}
 }
 
+void infrastructure::run_cycles(size_t cycles)
+{
+	scheduler.run_cycles(cycles);
+	if (auto ex = scheduler.last_exception())
+		std::rethrow_exception(ex);
+}
+
+void infrastructure::order_regions_by_dataflow()
+{
+	for (const auto& edge : graph.edges())
+	{
+		const auto source = edge.source.node_properties.region();
+		const auto sink = edge.sink.node_properties.region();
+		if (!source || !sink || source == sink)
+			continue;
+		try
+		{
+			scheduler.add_dependency(*source, *sink);
+		}
+		catch (const std::invalid_argument&)
+		{
+			// connection closes a loop, leave it buffered.
+		}
+	}
+}
+
 void infrastructure::infinite_main_loop()
 {
 	while( true )
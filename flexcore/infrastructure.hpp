@@ -3,6 +3,10 @@
 
 #include <flexcore/extended/base_node.hpp>
 #include <flexcore/scheduler/cyclecontrol.hpp>
+#include <flexcore/scheduler/threadconfig.hpp>
+
+#include <functional>
+#include <memory>
 
 namespace fc
 {
@@ -14,6 +18,26 @@ class infrastructure
 {
 public:
 	infrastructure();
+	/**
+	 * \brief Constructs infrastructure with configured worker threads.
+	 * \param workers number, cpu affinity and priority of the scheduler's worker threads.
+	 * \throws std::system_error if the settings in workers cannot be applied.
+	 */
+	explicit infrastructure(thread::thread_config workers);
+	/**
+	 * \brief Constructs infrastructure for a simulation with a clock of its own.
+	 *
+	 * Used by batch_runner to run many graphs in one process.
+	 * \param workers scheduler executing the work of the regions, may share a pool.
+	 * \param loop main loop of the cycle_control, see thread::afap_main_loop.
+	 * \param clock clock of the simulation, used by all regions of the infrastructure.
+	 * \param on_timeout timeout handler of the cycle_control, see thread::cycle_control.
+	 * \pre workers, loop and clock are not nullptr.
+	 */
+	infrastructure(std::unique_ptr<thread::scheduler> workers,
+			const std::shared_ptr<thread::main_loop>& loop,
+			std::shared_ptr<clock_domain> clock,
+			std::function<bool(thread::periodic_task&)> on_timeout);
 	~infrastructure();
 
 	std::shared_ptr<parallel_region> add_region(const std::string& name,
@@ -26,6 +50,28 @@ public:
 	void start_scheduler() { scheduler.start(); }
 	void stop_scheduler() { scheduler.stop(); }
 	void iterate_main_loop();
+	/**
+	 * \brief runs cycles in the calling thread instead of the thread of the scheduler.
+	 * \throws the first exception stored by the scheduler while the cycles were run.
+	 * \see thread::cycle_control::run_cycles
+	 */
+	void run_cycles(size_t cycles);
+
+	/// clock of the simulation, advanced by the scheduler.
+	const clock_domain& clock() const { return *scheduler.clock(); }
+	/// timing of the regions and the main loop, see thread::cycle_control::timing.
+	thread::timing_report timing() const { return scheduler.timing(); }
+
+	/**
+	 * \brief orders regions with the same tick rate by the connections between them.
+	 *
+	 * Every connection from one region to another is declared as a dependency in the scheduler,
+	 * so with buffer elision data passed between regions is not delayed by a cycle.
+	 * Connections closing a loop between regions keep the delay of one cycle.
+	 * \see thread::cycle_control::add_dependency
+	 * \pre scheduler is not running
+	 */
+	void order_regions_by_dataflow();
 
 private:
 	thread::cycle_control scheduler;
@@ -5,11 +5,97 @@
 #include <flexcore/extended/ports/node_aware.hpp>
 #include <flexcore/extended/ports/token_tags.hpp>
 #include <flexcore/extended/graph/graph_connectable.hpp>
+#include <flexcore/extended/graph/node_profiler.hpp>
 #include <flexcore/pure/pure_ports.hpp>
+#include <flexcore/scheduler/realtime_checks.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
 
 namespace fc
 {
 
+namespace detail
+{
+/**
+ * \brief wraps actions of ports, so that the thread executing them knows their node.
+ *
+ * If the graph does not track nodes, the action is returned unchanged,
+ * see connection_graph::enable_node_tracking.
+ */
+template<class signature>
+struct tracked_action;
+
+template<class result_t, class... args_t>
+struct tracked_action<std::function<result_t(args_t...)>>
+{
+	using function_t = std::function<result_t(args_t...)>;
+
+	static function_t wrap(node& owner, function_t action)
+	{
+		if (!owner.get_graph().tracks_nodes())
+			return action;
+		// the full name is computed once, the scope only stores a pointer to it.
+		auto name = std::make_shared<const std::string>(owner.full_name());
+		return [name = std::move(name), wrapped = std::move(action)](
+				args_t... args) -> result_t
+		{
+			const thread::detail::node_scope scope{*name};
+			return wrapped(std::forward<args_t>(args)...);
+		};
+	}
+};
+
+/// action of a port, which is profiled and tracked if the graph of its node says so.
+template<class function_t>
+struct node_action
+{
+	template<class action_t>
+	static function_t wrap(node& owner, const graph::graph_node_properties& info,
+			action_t&& action)
+	{
+		return tracked_action<function_t>::wrap(owner,
+				graph::detail::profiled_action<function_t>::wrap(
+						owner.get_graph(), info, std::forward<action_t>(action)));
+	}
+};
+
+/**
+ * \brief actions given to ports at position index of their constructor, which are wrapped.
+ *
+ * Arguments of other ports are passed on unchanged.
+ */
+template<class port_t, size_t index>
+struct port_action
+{
+	template<class arg_t>
+	static arg_t&& wrap(node&, const graph::graph_node_properties&, arg_t&& arg)
+	{
+		return std::forward<arg_t>(arg);
+	}
+};
+
+template<class event_t>
+struct port_action<pure::event_sink<event_t>, 0>
+	: node_action<typename handle_type<event_t>::type>
+{
+};
+
+template<class event_t>
+struct port_action<pure::event_sink<event_t>, 1>
+	: node_action<typename batch_handle_type<event_t>::type>
+{
+};
+
+template<class data_t>
+struct port_action<pure::state_source<data_t>, 0>
+	: node_action<std::function<data_t()>>
+{
+};
+} // namespace detail
+
 /**
  * \brief mixin for ports, which makes them aware of parent node and available in graph.
  *
@@ -26,13 +112,28 @@ struct node_aware_mixin : graph::graph_connectable<node_aware<port_t>>
 	 * \param node_ptr pointer to node which owns this port
 	 * \pre node_ptr != nullptr
 	 * \param base_constructor_args constructor arguments to underlying port.
-	 * These are forwarded to base
+	 * These are forwarded to base, actions of event_sinks and state_sources
+	 * are profiled if the graph profiles its nodes, see connection_graph::enable_node_profiling,
+	 * and tracked if it tracks them, see connection_graph::enable_node_tracking.
 	 */
 	template <class ... args>
 	explicit node_aware_mixin(node* node_ptr, args&&... base_constructor_args)
-			: base(node_ptr->get_graph(), node_ptr->graph_info(),
-				*(node_ptr->region().get()),
+			: node_aware_mixin(profiled_ports{}, node_ptr, node_ptr->graph_info(),
+				std::index_sequence_for<args...>{},
 				std::forward<args>(base_constructor_args)...)
+	{
+	}
+
+private:
+	struct profiled_ports {};
+
+	template <class ... args, size_t... index>
+	node_aware_mixin(profiled_ports, node* node_ptr, const graph::graph_node_properties& info,
+			std::index_sequence<index...>, args&&... base_constructor_args)
+			: base(node_ptr->get_graph(), info,
+				*(node_ptr->region().get()),
+				detail::port_action<port_t, index>::wrap(*node_ptr, info,
+						std::forward<args>(base_constructor_args))...)
 	{
 		assert(node_ptr);
 	}
@@ -58,6 +159,20 @@ using event_sink = default_mixin<pure::event_sink<data_t>>;
 template<class data_t>
 using event_source = default_mixin<pure::event_source<data_t>>;
 
+/**
+ * \brief Default shared_event_source port
+ * \ingroup ports
+ */
+template<class data_t>
+using shared_event_source = default_mixin<pure::shared_event_source<data_t>>;
+
+/**
+ * \brief Default parallel_event_source port
+ * \ingroup ports
+ */
+template<class data_t>
+using parallel_event_source = default_mixin<pure::parallel_event_source<data_t>>;
+
 /**
  * \brief Default state_sink port
  * \ingroup ports
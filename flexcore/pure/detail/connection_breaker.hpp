@@ -0,0 +1,135 @@
+#ifndef SRC_PORTS_DETAIL_CONNECTION_BREAKER_HPP_
+#define SRC_PORTS_DETAIL_CONNECTION_BREAKER_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace fc
+{
+namespace detail
+{
+
+class breaker_registry;
+
+/**
+ * \brief Registration of an active port with the passive ports it is connected to.
+ *
+ * When a connected passive port is destroyed, it calls remove on the owner of the breaker,
+ * which deletes the connection to that port from the active port.
+ * When the active port is destroyed first, the breaker unregisters from all passive ports.
+ * Registrations are plain pointers in both directions,
+ * which are neither reference counted nor allocated per connection.
+ * Like ports themselves, breakers are not thread safe.
+ */
+class connection_breaker
+{
+public:
+	/// called with owner and the hash of the destroyed passive port.
+	using remove_fun = void (*)(void* owner, size_t hash);
+
+	connection_breaker(void* owner, remove_fun remove) noexcept
+		: owner(owner), remove(remove)
+	{
+		assert(owner);
+		assert(remove);
+	}
+	/// takes over the registrations of o, which now refer to new_owner.
+	inline connection_breaker(connection_breaker&& o, void* new_owner);
+	connection_breaker(const connection_breaker&) = delete;
+	connection_breaker& operator=(const connection_breaker&) = delete;
+	inline ~connection_breaker();
+
+	/// registers this with passive port, once for every connection.
+	inline void connect(breaker_registry& passive);
+
+private:
+	friend class breaker_registry;
+	/// called by passive, when it is destroyed.
+	void break_connection(breaker_registry& passive, size_t hash)
+	{
+		const auto found = std::find(passives.begin(), passives.end(), &passive);
+		assert(found != passives.end());
+		passives.erase(found);
+		remove(owner, hash);
+	}
+
+	void* owner;
+	remove_fun remove;
+	/// passive ports connected to, contains a port once for every connection.
+	std::vector<breaker_registry*> passives;
+};
+
+/**
+ * \brief Breakers of the active ports connected to a passive port.
+ *
+ * The passive port calls break_all in its destructor,
+ * which removes all connections to the port from the active ports.
+ */
+class breaker_registry
+{
+public:
+	breaker_registry() = default;
+	breaker_registry(const breaker_registry&) = delete;
+	breaker_registry& operator=(const breaker_registry&) = delete;
+	~breaker_registry() { assert(breakers.empty()); }
+
+	/// removes all connections to the passive port with the given hash.
+	void break_all(size_t hash)
+	{
+		while (!breakers.empty())
+		{
+			auto* breaker = breakers.back();
+			breakers.pop_back();
+			breaker->break_connection(*this, hash);
+		}
+	}
+
+	bool empty() const noexcept { return breakers.empty(); }
+
+private:
+	friend class connection_breaker;
+	void add(connection_breaker* breaker) { breakers.push_back(breaker); }
+	/// removes one registration of breaker.
+	void forget(connection_breaker* breaker)
+	{
+		const auto found = std::find(breakers.begin(), breakers.end(), breaker);
+		assert(found != breakers.end());
+		breakers.erase(found);
+	}
+	void replace(connection_breaker* old_breaker, connection_breaker* new_breaker)
+	{
+		std::replace(breakers.begin(), breakers.end(), old_breaker, new_breaker);
+	}
+
+	/// contains a breaker once for every connection.
+	std::vector<connection_breaker*> breakers;
+};
+
+connection_breaker::connection_breaker(connection_breaker&& o, void* new_owner)
+	: owner(new_owner), remove(o.remove), passives(std::move(o.passives))
+{
+	assert(owner);
+	o.passives.clear();
+	// replace changes all registrations of o, later calls for the same port do nothing.
+	for (auto* passive : passives)
+		passive->replace(&o, this);
+}
+
+connection_breaker::~connection_breaker()
+{
+	for (auto* passive : passives)
+		passive->forget(this);
+}
+
+void connection_breaker::connect(breaker_registry& passive)
+{
+	passive.add(this);
+	passives.push_back(&passive);
+}
+
+} // namespace detail
+} // namespace fc
+
+#endif /* SRC_PORTS_DETAIL_CONNECTION_BREAKER_HPP_ */
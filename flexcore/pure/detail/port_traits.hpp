@@ -8,8 +8,13 @@
 #ifndef SRC_PORTS_PORT_TRAITS_HPP_
 #define SRC_PORTS_PORT_TRAITS_HPP_
 
+#include <flexcore/core/span.hpp>
 #include <flexcore/core/traits.hpp>
 
+#include <functional>
+#include <type_traits>
+#include <utility>
+
 // A collection of port specific meta functions and traits.
 
 namespace fc
@@ -29,6 +34,45 @@ struct handle_type<void>
 	using type = std::function<void()>;
 };
 
+/// type of handlers receiving a batch of events at once.
+template<class event_t>
+struct batch_handle_type
+{
+	using type = std::function<void(span<const std::remove_reference_t<event_t>>)>;
+};
+
+/// void events are only counted, a batch of them is their number.
+template<>
+struct batch_handle_type<void>
+{
+	using type = std::function<void(size_t)>;
+};
+
+/**
+ * \brief checks if conn_t can receive a batch of events of type event_t with receive_batch.
+ * Batches are passed as views of const events, thus event_t needs to be copyable.
+ * accepts_batches tells at runtime, whether batches are handled better than single events.
+ */
+template<class conn_t, class event_t, class = void>
+struct has_receive_batch : std::false_type {};
+
+template<class conn_t, class event_t>
+struct has_receive_batch<conn_t, event_t, std::enable_if_t<
+		std::is_copy_constructible<event_t>{},
+		decltype(std::declval<conn_t&>().receive_batch(std::declval<span<const event_t>>()),
+				bool(std::declval<const conn_t&>().accepts_batches()), void())>>
+	: std::true_type {};
+
+/// checks if conn_t can receive a number of void events at once with receive_count.
+template<class conn_t, class = void>
+struct has_receive_count : std::false_type {};
+
+template<class conn_t>
+struct has_receive_count<conn_t,
+		decltype(std::declval<conn_t&>().receive_count(size_t()),
+				bool(std::declval<const conn_t&>().accepts_batches()), void())>
+	: std::true_type {};
+
 template <template <class...> class mixin_t, class port_t>
 class is_derived_from
 {
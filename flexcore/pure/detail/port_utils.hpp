@@ -7,10 +7,13 @@
 #ifndef SRC_PORTS_PORT_UTILS_HPP_
 #define SRC_PORTS_PORT_UTILS_HPP_
 
+#include <flexcore/pure/detail/connection_breaker.hpp>
+
 #include <algorithm>
 #include <cassert>
 #include <functional>
 #include <iterator>
+#include <unordered_map>
 #include <vector>
 
 namespace fc
@@ -72,7 +75,16 @@ public:
 	size_t handler_hash;
 };
 
-/// Policy class for circuit breaker when multiple handlers can be connected at once.
+/**
+ * \brief Policy class for circuit breaker when multiple handlers can be connected at once.
+ *
+ * Handlers are stored in a dense vector, which is iterated when events are fired.
+ * Removing a handler moves the last handler into its place,
+ * thus removal takes constant time, but changes the order of the remaining handlers.
+ *
+ * \invariant handlers.size() == handler_hashes.size() == positions.size()
+ * \invariant for every entry of positions, handler_hashes[entry.second] == entry.first
+ */
 template <class handler_t>
 struct multiple_handler_policy
 {
@@ -80,6 +92,7 @@ public:
 	/// \pre The handler corresponding to hash has been pushed_back to handlers.
 	void add_handler(const handler_t& handler, size_t hash)
 	{
+		positions.emplace(hash, handlers.size());
 		handlers.push_back(handler);
 		handler_hashes.push_back(hash);
 	}
@@ -88,15 +101,41 @@ public:
 		assert(!handler_hashes.empty());
 		assert(!handlers.empty());
 
-		auto handler_position = find(begin(handler_hashes), end(handler_hashes), hash);
-		assert(handler_position != end(handler_hashes));
-		auto idx = distance(begin(handler_hashes), handler_position);
-		handlers.erase(begin(handlers) + idx);
-		handler_hashes.erase(begin(handler_hashes) + idx);
+		const auto handler_position = positions.find(hash);
+		assert(handler_position != end(positions));
+		const size_t idx = handler_position->second;
+		positions.erase(handler_position);
+
+		const size_t last = handlers.size() - 1;
+		if (idx != last)
+		{
+			handlers[idx] = std::move(handlers[last]);
+			handler_hashes[idx] = handler_hashes[last];
+			// the same sink can be connected several times, find the entry of the moved handler.
+			const auto moved = equal_range_value(handler_hashes[idx], last);
+			assert(moved != end(positions));
+			moved->second = idx;
+		}
+		handlers.pop_back();
+		handler_hashes.pop_back();
 	}
 
 	std::vector<handler_t> handlers;
 	std::vector<size_t> handler_hashes;
+
+private:
+	using position_map = std::unordered_multimap<size_t, size_t>;
+
+	typename position_map::iterator equal_range_value(size_t hash, size_t idx)
+	{
+		const auto range = positions.equal_range(hash);
+		const auto it = std::find_if(range.first, range.second,
+				[idx](const auto& entry) { return entry.second == idx; });
+		return it == range.second ? end(positions) : it;
+	}
+
+	/// index of the handler in handlers for the hash of each connected sink.
+	position_map positions;
 };
 
 /** \brief Register callbacks with passive port.
@@ -104,28 +143,15 @@ public:
  * \tparam handler_t type of handler used by active port.
  * \tparam storage_policy policy class that handles the number of
  *         handlers used in active port.
- * \invariant callback != nullptr
- * \invariant *callback is always valid function object.
  */
 template <class handler_t, template <class> class storage_policy>
 struct active_port_base
 {
 public:
-	active_port_base()
-		: callback(std::make_shared<std::function<void(size_t)>>(
-				[this](size_t hash)
-				 {
-					 storage.remove_handler(hash);
-				 }))
-	{
-		assert(callback);
-		assert(*callback);
-	}
+	active_port_base() : breaker(this, &remove_handler_of) {}
 	active_port_base(active_port_base&& p)
-	    : storage(std::move(p.storage)), callback(std::move(p.callback))
+	    : storage(std::move(p.storage)), breaker(std::move(p.breaker), this)
 	{
-		assert(callback);
-		*callback = [this](size_t hash) { storage.remove_handler(hash); };
 	}
 
 	/** \brief Register a callback with sink, that breaks the connection to source.
@@ -138,7 +164,7 @@ public:
 	void add_handler(handler_t handler, sink_t& sink)
 	{
 		storage.add_handler(std::move(handler), std::hash<sink_t*>{}(&sink));
-		sink.register_callback(callback);
+		sink.register_callback(breaker);
 	}
 	/// Do-nothing when sink does not support registering callbacks.
 	template <class sink_t, std::enable_if_t<!fc::has_register_function<sink_t>(0), int> = 0>
@@ -149,8 +175,14 @@ public:
 
 	storage_policy<handler_t> storage;
 private:
-	/// Callback from connected passive port to *this that deletes the connection when invoked.
-	std::shared_ptr<std::function<void(size_t)>> callback;
+	static void remove_handler_of(void* port, size_t hash)
+	{
+		static_cast<active_port_base*>(port)->storage.remove_handler(hash);
+	}
+
+	/// Registration with connected passive ports, which deletes the connection when invoked.
+	/// Declared after storage, to unregister before handlers are destroyed.
+	connection_breaker breaker;
 };
 
 } //namespace detail
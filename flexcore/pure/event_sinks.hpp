@@ -7,6 +7,7 @@
 
 #include <flexcore/core/connection.hpp>
 #include <flexcore/core/traits.hpp>
+#include <flexcore/pure/detail/connection_breaker.hpp>
 #include <flexcore/pure/detail/port_traits.hpp>
 
 namespace fc
@@ -44,6 +45,29 @@ struct event_sink
 		assert(event_handler);
 	}
 
+	/**
+	 * \brief Construct event_sink with actions for single events and for batches of events.
+	 * \param action Action to execute with incoming events
+	 * \param batch_action Action to execute with all events of a batch at once.
+	 * \pre action must be function with signature void(event_t).
+	 * \pre batch_action must be function with signature void(span<const event_t>),
+	 * or void(size_t) receiving the number of events, if event_t is void.
+	 */
+	template<class action_t, class batch_action_t>
+	event_sink(action_t&& action, batch_action_t&& batch_action) :
+			event_handler(std::forward<action_t>(action)),
+			batch_handler(std::forward<batch_action_t>(batch_action))
+	{
+		static_assert(std::is_constructible<handler_t, action_t>(),
+				"action given to event_sink needs to have signature void(event_t)."
+				" Where event_t is type of token expected by event_sink.");
+		static_assert(std::is_constructible<batch_handler_t, batch_action_t>(),
+				"batch action given to event_sink needs to have signature"
+				" void(span<const event_t>), or void(size_t) for void events.");
+		assert(event_handler);
+		assert(batch_handler);
+	}
+
 	///event sinks are callable with event_t, which makes them connectables
 	template <class T>
 	auto operator()(T&& in_event) -> std::enable_if_t<std::is_convertible<T&&, event_t>{}>
@@ -59,6 +83,39 @@ struct event_sink
 		event_handler();
 	}
 
+	/**
+	 * \brief receives several events at once.
+	 * Calls the batch action if there is one and the action for every event otherwise.
+	 */
+	template <class T = event_t, typename = std::enable_if_t<!std::is_void<T>{}>>
+	void receive_batch(span<const std::remove_reference_t<T>> events)
+	{
+		assert(event_handler);
+		if (batch_handler)
+			batch_handler(events);
+		else
+			for (const auto& event : events)
+				event_handler(event);
+	}
+
+	/**
+	 * \brief receives n void events at once.
+	 * Calls the batch action with n if there is one and the action n times otherwise.
+	 */
+	template <class T = event_t, typename = std::enable_if_t<std::is_void<T>{}>>
+	void receive_count(size_t n)
+	{
+		assert(event_handler);
+		if (batch_handler)
+			batch_handler(n);
+		else
+			for (size_t i = 0; i != n; ++i)
+				event_handler();
+	}
+
+	/// returns true if the sink has an action for batches of events.
+	bool accepts_batches() const { return static_cast<bool>(batch_handler); }
+
 	event_sink(const event_sink&) = delete;
 	event_sink(event_sink&& o)
 	{
@@ -67,6 +124,7 @@ struct event_sink
 		// NDEBUG is defined) the moved-from-object can still disconnect
 		// itself.
 		swap(o.event_handler, event_handler);
+		swap(o.batch_handler, batch_handler);
 		assert(event_handler);
 	}
 
@@ -74,33 +132,29 @@ struct event_sink
 	{
 		assert(o.connection_breakers.empty());
 		swap(o.event_handler, event_handler);
+		swap(o.batch_handler, batch_handler);
 		assert(event_handler);
 		return *this;
 	}
 
 	~event_sink()
 	{
-		const auto self = std::hash<decltype(this)>{}(this);
-		for (auto& breaker_ptr : connection_breakers)
-		{
-			auto breaker = breaker_ptr.lock();
-			if (breaker)
-				(*breaker)(self);
-		}
+		connection_breakers.break_all(std::hash<decltype(this)>{}(this));
 	}
 
 	///registers a callback to be called, when this port is deconnected.
-	void register_callback(std::shared_ptr<std::function<void(size_t)>>& visit_fun)
+	void register_callback(detail::connection_breaker& breaker)
 	{
-		assert(visit_fun);
-		assert(*visit_fun);
-		connection_breakers.emplace_back(visit_fun);
+		breaker.connect(connection_breakers);
 	}
 
 private:
 	using handler_t = typename detail::handle_type<event_t>::type;
+	using batch_handler_t = typename detail::batch_handle_type<event_t>::type;
 	handler_t event_handler;
-	std::vector<std::weak_ptr<std::function<void(size_t)>>> connection_breakers;
+	/// empty if batches are received one event at a time.
+	batch_handler_t batch_handler;
+	detail::breaker_registry connection_breakers;
 };
 
 } // namespace pure
@@ -7,13 +7,37 @@
 #include <flexcore/pure/detail/port_traits.hpp>
 #include <flexcore/pure/detail/port_utils.hpp>
 #include <flexcore/pure/port_connection.hpp>
+#include <flexcore/core/span.hpp>
 
 #include <cassert>
+#include <iterator>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace fc
 {
+namespace detail
+{
+/**
+ * \brief handler stored by event_source.
+ *
+ * Holds the connection for single events and, if the connection can receive them,
+ * a handler for batches of events, see event_source::fire_batch and fire_count.
+ */
+template<class event_t>
+struct event_handler
+{
+	template<class... T>
+	void operator()(T&&... event) { single(std::forward<T>(event)...); }
+	explicit operator bool() const { return static_cast<bool>(single); }
+
+	typename handle_type<event_t>::type single;
+	/// empty if the connection only receives single events.
+	typename batch_handle_type<event_t>::type batch;
+};
+}
+
 namespace pure
 {
 
@@ -40,6 +64,10 @@ struct event_source
 
 	/**
 	 * \brief Sends parameter as event to all connected conntables and event_sinks.
+	 *
+	 * All connections but the last receive a copy of event.
+	 * The last connection receives event as it was passed to fire,
+	 * thus an rvalue is moved to it instead of copied.
 	 * \param event token to be sent through this port.
 	 */
 	template<class... T>
@@ -53,10 +81,64 @@ struct event_source
 				"tried to call fire with a type, not implicitly convertible to type of port."
 				"If conversion is required, do the cast before calling fire.");
 
+		auto& handlers = base.storage.handlers;
+		if (handlers.empty())
+			return;
+		const auto last = std::prev(handlers.end());
+		for (auto it = handlers.begin(); it != last; ++it)
+		{
+			assert(*it);
+			(*it)(static_cast<event_t>(event)...);
+		}
+		assert(*last);
+		(*last)(static_cast<event_t>(std::forward<T>(event))...);
+	}
+
+	/**
+	 * \brief Sends a batch of events to all connected connectables and event_sinks.
+	 *
+	 * Connections which can receive batches, like event_sinks, receive all events at once.
+	 * All other connections receive the events one after the other.
+	 * Unlike fire, each connection receives the whole batch before the next connection.
+	 * \param events events to be sent through this port, copied if necessary.
+	 */
+	template<class T = result_t>
+	void fire_batch(span<const std::enable_if_t<!std::is_void<T>{}, T>> events)
+	{
+		send_batch(events);
+	}
+
+	/**
+	 * \brief Sends a batch of events like fire_batch, but moves events if possible.
+	 *
+	 * The last connection receives the events as rvalues, if it is no batch receiver.
+	 * \post events are in moved from state
+	 */
+	template<class T = result_t>
+	void fire_batch_move(span<std::enable_if_t<!std::is_void<T>{}, T>> events)
+	{
+		send_batch(events);
+	}
+
+	/**
+	 * \brief Sends n void events to all connected connectables and event_sinks.
+	 *
+	 * Connections which can receive counts, like event_sinks with a count action,
+	 * receive n with a single call, all other connections receive n single events.
+	 */
+	template<class T = result_t>
+	void fire_count(std::enable_if_t<std::is_void<T>{}, size_t> n)
+	{
+		if (n == 0)
+			return;
 		for (auto& target : base.storage.handlers)
 		{
 			assert(target);
-			target(static_cast<event_t>(event)...);
+			if (target.batch)
+				target.batch(n);
+			else
+				for (size_t i = 0; i != n; ++i)
+					target();
 		}
 	}
 
@@ -82,7 +164,8 @@ struct event_source
 			"The type returned by this source is not compatible with the connection you "
 			"are trying to establish.");
 
-		base.add_handler(detail::handler_wrapper(std::forward<conn_t>(c)), get_sink(c));
+		base.add_handler(make_handler(std::forward<conn_t>(c), std::is_void<result_t>{}),
+				get_sink(c));
 
 		assert(!base.storage.handlers.empty());
 		return port_connection<decltype(*this), conn_t, result_t>();
@@ -96,17 +179,145 @@ struct event_source
 				"Illegally tried to connect a temporary event_source object.");
 	}
 
+protected:
+	/// handlers of all connections, for ports which send events to them differently.
+	auto& connected_handlers() noexcept { return base.storage.handlers; }
+
 private:
-	using handler_t = typename detail::handle_type<result_t>::type;
+	using handler_t = detail::event_handler<result_t>;
+	using is_void_event = std::true_type;
+	using is_value_event = std::false_type;
+
+	template<class conn_t>
+	static handler_t make_handler(conn_t&& c, is_void_event)
+	{
+		handler_t handler{};
+		handler.batch = make_count_handler(c, std::is_lvalue_reference<conn_t>{},
+				detail::has_receive_count<std::remove_reference_t<conn_t>>{});
+		handler.single = detail::handler_wrapper(std::forward<conn_t>(c));
+		return handler;
+	}
+
+	template<class conn_t>
+	static handler_t make_handler(conn_t&& c, is_value_event)
+	{
+		handler_t handler{};
+		handler.batch = make_batch_handler(c, std::is_lvalue_reference<conn_t>{},
+				detail::has_receive_batch<std::remove_reference_t<conn_t>, result_t>{});
+		handler.single = detail::handler_wrapper(std::forward<conn_t>(c));
+		return handler;
+	}
+
+	using batch_handler_t = typename detail::batch_handle_type<result_t>::type;
+
+	/// connections given as lvalue are stored as reference, the batch handler does the same.
+	template<class conn_t>
+	static batch_handler_t make_batch_handler(conn_t& c, std::true_type, std::true_type)
+	{
+		if (!c.accepts_batches())
+			return nullptr;
+		return [&c](span<const result_t> events) { c.receive_batch(events); };
+	}
+	/// temporary connections are stored by value, the batch handler needs its own copy.
+	template<class conn_t>
+	static batch_handler_t make_batch_handler(conn_t& c, std::false_type, std::true_type)
+	{
+		if (!c.accepts_batches())
+			return nullptr;
+		return [c](span<const result_t> events) mutable { c.receive_batch(events); };
+	}
+	template<class conn_t, class is_lvalue>
+	static batch_handler_t make_batch_handler(conn_t&, is_lvalue, std::false_type)
+	{
+		return nullptr;
+	}
+
+	template<class conn_t>
+	static batch_handler_t make_count_handler(conn_t& c, std::true_type, std::true_type)
+	{
+		if (!c.accepts_batches())
+			return nullptr;
+		return [&c](size_t n) { c.receive_count(n); };
+	}
+	template<class conn_t>
+	static batch_handler_t make_count_handler(conn_t& c, std::false_type, std::true_type)
+	{
+		if (!c.accepts_batches())
+			return nullptr;
+		return [c](size_t n) mutable { c.receive_count(n); };
+	}
+	template<class conn_t, class is_lvalue>
+	static batch_handler_t make_count_handler(conn_t&, is_lvalue, std::false_type)
+	{
+		return nullptr;
+	}
+
+	template<class T>
+	void send_batch(span<T> events)
+	{
+		// reference events are passed on as they are, values are moved to the last handler.
+		using moved_t = std::conditional_t<std::is_reference<event_t>{}, T&, T&&>;
+		auto& handlers = base.storage.handlers;
+		for (size_t i = 0; i != handlers.size(); ++i)
+		{
+			auto& target = handlers[i];
+			assert(target);
+			if (target.batch)
+				target.batch(events);
+			else if (i + 1 == handlers.size())
+				for (auto& event : events)
+					target(static_cast<event_t>(static_cast<moved_t>(event)));
+			else
+				for (auto& event : events)
+					target(static_cast<event_t>(event));
+		}
+	}
+
 	// Stores event_handlers in a vector, the node needs to send
 	// to all connected event_handlers when an event is fired.
 	detail::active_port_base<handler_t, detail::multiple_handler_policy> base;
 };
 
+/**
+ * \brief Output port for events, where all connections share a single immutable payload.
+ *
+ * Events are wrapped once in a std::shared_ptr<const event_t> when they are fired,
+ * every connected sink, including buffers to other regions, receives the same instance.
+ * Use it for large events with many connections, where copying the event for every
+ * connection dominates. Sinks need to accept payload_t.
+ *
+ * \tparam event_t type of event, needs to be move_constructable.
+ * \ingroup ports
+ */
+template<class event_t>
+struct shared_event_source : event_source<std::shared_ptr<const event_t>>
+{
+	static_assert(!std::is_void<event_t>{}, "void events have no payload to share");
+	static_assert(!std::is_reference<event_t>{}, "event_t has to be a value type");
+
+	using payload_t = std::shared_ptr<const event_t>;
+	using base_t = event_source<payload_t>;
+
+	shared_event_source() = default;
+
+	/// Wraps event in a shared payload and sends it to all connected connectables.
+	void fire(event_t event)
+	{
+		base_t::fire(std::make_shared<const event_t>(std::move(event)));
+	}
+
+	/// Sends an already shared payload without wrapping it again.
+	void fire(payload_t payload)
+	{
+		base_t::fire(std::move(payload));
+	}
+};
+
 } // namespace pure
 
 /// event_source is the essential active_source
 template<class T> struct is_active_source<pure::event_source<T>> : std::true_type {};
+template<class T> struct is_active_source<pure::shared_event_source<T>> : std::true_type {};
 
 } // namespace fc
 
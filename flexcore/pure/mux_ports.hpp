@@ -1,8 +1,16 @@
 #ifndef SRC_PORTS_MUX_PORTS_HPP_
 #define SRC_PORTS_MUX_PORTS_HPP_
 
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
 #include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
 #include <flexcore/core/detail/function_traits.hpp>
 #include <flexcore/core/traits.hpp>
 #include <flexcore/core/tuple_meta.hpp>
@@ -15,12 +23,17 @@ template <class op>
 struct unloaded_merge_port;
 template <class op, class... ports>
 struct loaded_merge_port;
+template <class data_t, class op>
+struct unloaded_array_merge_port;
+template <class data_t, class op>
+struct array_merge_port;
 
 
 namespace detail
 {
 struct default_tag {};
 struct merge_tag {};
+struct array_merge_tag {};
 struct mux_tag {};
 
 /// Traits used to determine whether a muxed port is connecting to a muxed
@@ -42,6 +55,12 @@ struct port_traits<unloaded_merge_port<op>>
 {
 	using mux_category = merge_tag;
 };
+
+template <class data_t, class op>
+struct port_traits<unloaded_array_merge_port<data_t, op>>
+{
+	using mux_category = array_merge_tag;
+};
 /// Helper: check if any of the passed bools are true.
 template <bool... vals>
 constexpr bool any()
@@ -149,6 +168,30 @@ private:
 		return loaded_merge_port<decltype(t.merge), port_ts...>{t.merge, std::move(ports)};
 	}
 
+	/** \brief Overload for connecting to an unloaded_array_merge_port
+	 *
+	 * T is expected to be an instantiation of unloaded_array_merge_port.
+	 * Ports held by reference stay referenced, all others are moved into the result.
+	 *
+	 * \returns array_merge_port with the reduction of t, pulling the ports held by *this.
+	 */
+	template <class T>
+	auto connect(T t, detail::array_merge_tag)
+	{
+		static_assert(!detail::any<detail::is_derived_from<node_aware, port_ts>::value...>(),
+		              "Merge port can not be used with node aware ports. See merge_node.");
+		using port_t = array_merge_port<typename T::data_t, typename T::reduction_t>;
+		port_t merged{t.reduction};
+		merged.reserve(sizeof...(port_ts));
+		auto add_all = [&merged](auto&&... src)
+		{
+			(void)std::initializer_list<int>{
+				(merged.add(std::forward<decltype(src)>(src)), 0)...};
+		};
+		tuple::invoke_function(add_all, std::move(ports));
+		return merged;
+	}
+
 	/** \brief Overload for connecting to another muxed port.
 	 *
 	 * other_mux is expected to be an instantiation of mux_port, the ports
@@ -343,6 +386,245 @@ auto merge(merge_op op)
 {
 	return unloaded_merge_port<merge_op>{op};
 }
+
+/**
+ * \brief Reductions for array_merge_port.
+ *
+ * A reduction is called with the range [first, last) of the pulled values.
+ * Reductions besides any are written as plain loops over contiguous memory,
+ * which the compiler vectorises for arithmetic types. Floating point sums
+ * are only vectorised if reassociation is allowed, i.e. with -ffast-math.
+ *
+ * A reduction may define stops(value), array_merge_port then stops pulling
+ * at the first value for which it returns true and reduces the values pulled so far.
+ */
+namespace reductions
+{
+/// adds all values, the sum of no values is a value initialized data_t.
+struct sum
+{
+	template <class data_t>
+	data_t operator()(const data_t* first, const data_t* last) const
+	{
+		data_t result{};
+		for (; first != last; ++first)
+			result += *first;
+		return result;
+	}
+};
+
+/// returns the smallest value, needs at least one value.
+struct min
+{
+	template <class data_t>
+	data_t operator()(const data_t* first, const data_t* last) const
+	{
+		assert(first != last);
+		data_t result = *first;
+		for (++first; first != last; ++first)
+			result = *first < result ? *first : result;
+		return result;
+	}
+};
+
+/// returns the largest value, needs at least one value.
+struct max
+{
+	template <class data_t>
+	data_t operator()(const data_t* first, const data_t* last) const
+	{
+		assert(first != last);
+		data_t result = *first;
+		for (++first; first != last; ++first)
+			result = result < *first ? *first : result;
+		return result;
+	}
+};
+
+/// returns true if any value is true, stops pulling at the first true value.
+struct any
+{
+	template <class data_t>
+	bool stops(const data_t& value) const
+	{
+		return static_cast<bool>(value);
+	}
+	template <class data_t>
+	bool operator()(const data_t* first, const data_t* last) const
+	{
+		for (; first != last; ++first)
+			if (*first)
+				return true;
+		return false;
+	}
+};
+} // namespace reductions
+
+namespace detail
+{
+template <class reduction, class data_t>
+constexpr auto has_stops(int)
+		-> decltype(std::declval<const reduction&>().stops(std::declval<const data_t&>()), true)
+{
+	return true;
+}
+template <class reduction, class data_t>
+constexpr bool has_stops(...)
+{
+	return false;
+}
+
+/// contiguous array of data_t, unlike std::vector<bool> also for bool.
+template <class data_t>
+class value_buffer
+{
+public:
+	value_buffer() = default;
+	value_buffer(const value_buffer& other)
+		: values(other.count ? std::make_unique<data_t[]>(other.count) : nullptr)
+		, count(other.count)
+	{
+		std::copy(other.data(), other.data() + count, data());
+	}
+	value_buffer(value_buffer&&) = default;
+	value_buffer& operator=(value_buffer other)
+	{
+		std::swap(values, other.values);
+		std::swap(count, other.count);
+		return *this;
+	}
+
+	/// sets the number of values, keeps none of them.
+	void resize(size_t size)
+	{
+		if (size > count)
+			values = std::make_unique<data_t[]>(size);
+		count = size;
+	}
+	size_t size() const noexcept { return count; }
+	data_t* data() noexcept { return values.get(); }
+	const data_t* data() const noexcept { return values.get(); }
+
+private:
+	std::unique_ptr<data_t[]> values;
+	size_t count = 0;
+};
+} // namespace detail
+
+/// An array_merge_port that is not connected to a mux_port yet, see array_merge.
+template <class data, class reduction_op>
+struct unloaded_array_merge_port
+{
+	using data_t = data;
+	using reduction_t = reduction_op;
+	reduction_t reduction;
+};
+
+/** \brief A merge port for any number of sources of the same type data_t.
+ *
+ * In contrast to loaded_merge_port the sources are held in an array,
+ * so neither the size of the type nor the code grows with the number of sources.
+ * Every pull calls the sources in the order they were added and stores their
+ * values in a contiguous buffer, which is passed to the reduction.
+ * The buffer is allocated by the first pull after sources were added.
+ *
+ * Like all merge ports, array_merge_port does not take into account region information.
+ */
+template <class data_t, class reduction>
+struct array_merge_port
+{
+	static_assert(std::is_default_constructible<data_t>{} && std::is_copy_assignable<data_t>{},
+			"array_merge_port stores the values of its sources in a buffer.");
+
+	explicit array_merge_port(reduction op = reduction{})
+		: op(std::move(op))
+	{
+	}
+
+	/**
+	 * \brief adds src as the last source.
+	 * \param src state source or connection, which is referenced if passed as lvalue.
+	 */
+	template <class src_t>
+	void add(src_t&& src)
+	{
+		static_assert(std::is_convertible<decltype(src()), data_t>{},
+				"sources of array_merge_port need to provide data_t.");
+		sources.push_back(make_pull(std::forward<src_t>(src)));
+	}
+
+	/// reserves memory for size sources.
+	void reserve(size_t size) { sources.reserve(size); }
+
+	size_t size() const noexcept { return sources.size(); }
+
+	/// pulls all sources and returns the reduction of their values.
+	auto operator()()
+	{
+		if (values.size() != sources.size())
+			values.resize(sources.size());
+		auto out = values.data();
+		for (auto& source : sources)
+		{
+			*out = source();
+			if (stops(*out++, std::integral_constant<bool,
+					detail::has_stops<reduction, data_t>(0)>{}))
+				break;
+		}
+		return op(static_cast<const data_t*>(values.data()), static_cast<const data_t*>(out));
+	}
+
+private:
+	template <class src_t>
+	static std::function<data_t()> make_pull(src_t& src)
+	{
+		return [&src]() -> data_t { return src(); };
+	}
+	template <class src_t>
+	static std::function<data_t()> make_pull(src_t&& src)
+	{
+		return std::move(src);
+	}
+
+	bool stops(const data_t& value, std::true_type) const { return op.stops(value); }
+	bool stops(const data_t&, std::false_type) const { return false; }
+
+	reduction op;
+	std::vector<std::function<data_t()>> sources;
+	detail::value_buffer<data_t> values;
+};
+
+/** \brief Create a proxy of an array_merge_port, to be connected to a mux port.
+ *
+ *     mux(a,b,c) >> array_merge<int>(reductions::sum{}) >> state_sink
+ *
+ * Use array_merge_port for wide fan-in of sources of the same type,
+ * the ports of the mux are converted to data_t.
+ * For sources which are a range rather than a mux, see merge_range.
+ */
+template <class data_t, class reduction>
+auto array_merge(reduction op)
+{
+	return unloaded_array_merge_port<data_t, reduction>{op};
+}
+
+/**
+ * \brief Create an array_merge_port referencing every element of the range sources.
+ *
+ *     std::vector<pure::state_source<int>> sources(128);
+ *     merge_range<int>(sources, reductions::max{}) >> state_sink;
+ *
+ * The elements need to outlive the merge port.
+ */
+template <class data_t, class reduction, class range_t>
+auto merge_range(range_t& sources, reduction op)
+{
+	array_merge_port<data_t, reduction> merged{op};
+	merged.reserve(std::distance(std::begin(sources), std::end(sources)));
+	for (auto& source : sources)
+		merged.add(source);
+	return merged;
+}
 } // namespace fc
 #endif // SRC_PORTS_MUX_PORTS_HPP_
 
@@ -0,0 +1,113 @@
+#ifndef SRC_PORTS_PARALLEL_EVENT_SOURCE_HPP_
+#define SRC_PORTS_PARALLEL_EVENT_SOURCE_HPP_
+
+#include <flexcore/pure/event_sources.hpp>
+#include <flexcore/range/parallel_actions.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <utility>
+
+namespace fc
+{
+namespace pure
+{
+
+/**
+ * \brief Output port for events, which sends to its connections in parallel.
+ *
+ * With a pool set, fire splits the connections into chunks, which are run as tasks
+ * on the pool, usually cycle_control::task_scheduler(). The firing thread works
+ * on the chunks as well and returns once all connections received the event,
+ * thus all handlers are done before the tick of the region completes.
+ * Like the parallel range actions the firing thread only waits for chunks already started,
+ * so this does not deadlock when fired from a task of the same pool.
+ *
+ * Use it for several expensive and independent sinks of one event.
+ * Connections need to be callable concurrently with each other,
+ * they all receive a copy of the event, none receives it moved.
+ * If a connection throws, the first exception is rethrown by fire,
+ * after the chunks already started have finished.
+ * Without a pool, or with a single connection, it behaves like event_source.
+ *
+ * \tparam event_t type of event, needs to be copy_constructable.
+ * \ingroup ports
+ */
+template<class event_t>
+struct parallel_event_source : event_source<event_t>
+{
+	using base_t = event_source<event_t>;
+	using result_t = typename base_t::result_t;
+
+	parallel_event_source() = default;
+	/// \param pool scheduler the connections are sent to in parallel.
+	explicit parallel_event_source(thread::scheduler& pool) : pool(&pool) {}
+
+	/// sets the scheduler to send connections in parallel on, nullptr sends serially.
+	void set_pool(thread::scheduler* new_pool) noexcept { pool = new_pool; }
+
+	/// Sends event to all connections, in parallel if there is a pool.
+	template<class... T>
+	void fire(T&&... event)
+	{
+		auto& handlers = this->connected_handlers();
+		if (!pool || handlers.size() < 2)
+			return base_t::fire(std::forward<T>(event)...);
+		for_each_handler([&event...](auto& handler)
+		{
+			assert(handler);
+			handler(static_cast<event_t>(event)...);
+		});
+	}
+
+	/// Sends a batch of events to all connections, in parallel if there is a pool.
+	template<class T = result_t>
+	void fire_batch(span<const std::enable_if_t<!std::is_void<T>{}, T>> events)
+	{
+		if (!pool || this->connected_handlers().size() < 2)
+			return base_t::fire_batch(events);
+		for_each_handler([events](auto& handler)
+		{
+			assert(handler);
+			if (handler.batch)
+				handler.batch(events);
+			else
+				for (const auto& e : events)
+					handler(static_cast<event_t>(e));
+		});
+	}
+
+	/// Sends a batch like fire_batch, events are only moved if sent serially.
+	template<class T = result_t>
+	void fire_batch_move(span<std::enable_if_t<!std::is_void<T>{}, T>> events)
+	{
+		if (!pool || this->connected_handlers().size() < 2)
+			return base_t::fire_batch_move(events);
+		fire_batch(span<const T>{events.data(), events.size()});
+	}
+
+private:
+	template<class send_t>
+	void for_each_handler(const send_t& send)
+	{
+		auto& handlers = this->connected_handlers();
+		// every connection is worth a task, unlike single elements of a range.
+		const actions::parallel_policy policy{pool, 2, 1};
+		actions::detail::for_each_chunk(policy, handlers.size(),
+				[&handlers, &send](size_t, size_t begin, size_t end)
+				{
+					for (size_t i = begin; i != end; ++i)
+						send(handlers[i]);
+				});
+	}
+
+	thread::scheduler* pool = nullptr;
+};
+
+} // namespace pure
+
+template<class T> struct is_active_source<pure::parallel_event_source<T>> : std::true_type {};
+
+} // namespace fc
+
+#endif /* SRC_PORTS_PARALLEL_EVENT_SOURCE_HPP_ */
@@ -3,7 +3,10 @@
 
 #include <flexcore/pure/event_sources.hpp>
 #include <flexcore/pure/event_sinks.hpp>
+#include <flexcore/pure/parallel_event_source.hpp>
+#include <flexcore/pure/static_event_source.hpp>
 #include <flexcore/pure/state_sink.hpp>
+#include <flexcore/pure/static_state_sink.hpp>
 #include <flexcore/pure/state_sources.hpp>
 
 /**
@@ -0,0 +1,124 @@
+#ifndef SRC_PORTS_STATES_STATE_FUTURE_HPP_
+#define SRC_PORTS_STATES_STATE_FUTURE_HPP_
+
+#include <flexcore/scheduler/scheduler.hpp>
+
+#include <boost/optional.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace fc
+{
+namespace pure
+{
+
+/**
+ * \brief state pulled on a scheduler, returned by state_sink::async_get.
+ *
+ * The pull is added as task to the scheduler. If no worker has started it
+ * when get is called, the calling thread pulls the state itself,
+ * thus get only waits for pulls already running and never deadlocks,
+ * even if called from a task of the same scheduler.
+ *
+ * \tparam data_t type of the state, like the state_sink, which started the pull.
+ */
+template<class data_t>
+class state_future
+{
+public:
+	/// constructs future without a state, valid() is false.
+	state_future() = default;
+
+	/**
+	 * \brief adds pulling state to pool.
+	 * \param pull connection to pull, needs to outlive the future and the task on pool.
+	 */
+	state_future(const std::function<data_t()>& pull, thread::scheduler& pool)
+		: state(std::make_shared<shared_state>(pull))
+	{
+		pool.add_task([s = state]() { s->run(); });
+	}
+
+	/// returns true if get can be called.
+	bool valid() const noexcept { return static_cast<bool>(state); }
+	/// returns true if the state has been pulled, get does not block then.
+	bool is_ready() const noexcept
+	{
+		assert(valid());
+		return state->phase.load(std::memory_order_acquire) == done;
+	}
+
+	/**
+	 * \brief returns the pulled state, rethrows exceptions thrown while pulling it.
+	 * \pre valid()
+	 * \post !valid()
+	 */
+	data_t get()
+	{
+		assert(valid());
+		const auto s = std::move(state);
+		if (!s->run())
+			s->wait();
+		if (s->error)
+			std::rethrow_exception(s->error);
+		return std::forward<data_t>(*s->value);
+	}
+
+private:
+	enum phase_t { waiting, running, done };
+
+	struct shared_state
+	{
+		explicit shared_state(const std::function<data_t()>& pull) : pull(pull) {}
+
+		/// pulls the state unless another thread already has, returns false in that case.
+		bool run()
+		{
+			int expected = waiting;
+			if (!phase.compare_exchange_strong(expected, running, std::memory_order_acq_rel))
+				return false;
+			try
+			{
+				value = pull();
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				phase.store(done, std::memory_order_release);
+			}
+			finished.notify_all();
+			return true;
+		}
+
+		void wait()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			finished.wait(lock,
+					[this]() { return phase.load(std::memory_order_acquire) == done; });
+		}
+
+		const std::function<data_t()>& pull;
+		std::atomic<int> phase{waiting};
+		boost::optional<data_t> value;
+		std::exception_ptr error;
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+
+	std::shared_ptr<shared_state> state;
+};
+
+} // namespace pure
+} // namespace fc
+
+#endif /* SRC_PORTS_STATES_STATE_FUTURE_HPP_ */
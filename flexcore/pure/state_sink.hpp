@@ -6,6 +6,7 @@
 #include <flexcore/pure/detail/port_traits.hpp>
 #include <flexcore/pure/detail/port_utils.hpp>
 #include <flexcore/pure/detail/active_connection_proxy.hpp>
+#include <flexcore/pure/state_future.hpp>
 
 #include <functional>
 #include <memory>
@@ -22,7 +23,11 @@ namespace pure
  * state_sink Fulfills active_sink.
  *
  * \tparam data_t data type flowing through this port.
- * Needs to fulfill copy_constructable
+ * Needs to fulfill copy_constructable.
+ * If data_t is a const reference, states are borrowed instead of copied,
+ * the reference is valid for the current work tick of the region of the sink.
+ * Everything connected to such a sink then needs to provide a reference,
+ * buffers between regions hold the state in between.
  * \ingroup ports
  */
 template<class data_t>
@@ -46,6 +51,24 @@ public:
 		return base.storage.handlers();
 	}
 
+	/**
+	 * \brief pulls state from connection on pool, see state_future.
+	 *
+	 * Allows to pull several expensive states at once, the connection needs to be
+	 * safe to pull concurrently with those. The sink needs to outlive the returned future.
+	 * \throws no_connected exception if called with an unconnected state sink.
+	 */
+	state_future<data_t> async_get(thread::scheduler& pool) const
+	{
+		if (!base.storage.handlers)
+			throw not_connected(
+					"tried to pull data through a state_sink"
+					" which is not connected");
+		return state_future<data_t>{base.storage.handlers, pool};
+	}
+	/// returns true if a connection has been added to this sink.
+	bool is_connected() const noexcept { return static_cast<bool>(base.storage.handlers); }
+
 	/**
 	 * \brief Connects state source to state_sink.
 	 *
@@ -64,6 +87,10 @@ public:
 
 		static_assert(std::is_convertible<decltype(std::declval<con_t>()()), data_t>{},
 				"The type returned by this connection is incompatible with this sink.");
+		static_assert(!std::is_reference<data_t>{} ||
+				std::is_reference<decltype(std::declval<con_t>()())>{},
+				"A state_sink borrowing states can only be connected to connections"
+				" returning references, a temporary would be dangling.");
 
 		base.add_handler(detail::handler_wrapper(std::forward<con_t>(c)), get_source(c));
 	}
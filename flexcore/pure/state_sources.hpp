@@ -3,10 +3,12 @@
 
 #include <flexcore/core/connection.hpp>
 #include <flexcore/core/traits.hpp>
+#include <flexcore/pure/detail/connection_breaker.hpp>
 
 #include <cassert>
 #include <functional>
 #include <memory>
+#include <type_traits>
 #include <utility>
 
 namespace fc
@@ -19,6 +21,7 @@ namespace pure
  *
  * state_source fulfills passive_source.
  * \tparam data_t type of token provided by this port.
+ * A const reference lends the state to the connected sinks instead of copying it.
  * \ingroup ports
  */
 template<class data_t>
@@ -39,6 +42,9 @@ public:
 		static_assert(std::is_constructible<std::function<data_t()>, provide_action>(),
 				"action given to state_source needs to have signature data_t()."
 				" Where data_t is type of token provided by state_source.");
+		static_assert(!std::is_reference<data_t>{} ||
+				std::is_reference<std::result_of_t<provide_action&()>>{},
+				"action given to a state_source lending states needs to return a reference.");
 		assert(call);
 	}
 
@@ -64,24 +70,16 @@ public:
 	/// Destructor disconnects existing connection and then deletes object.
 	~state_source()
 	{
-		auto self = std::hash<decltype(this)>{}(this);
-		for (auto& breaker_ptr : connection_breakers)
-		{
-			auto breaker = breaker_ptr.lock();
-			if (breaker)
-				(*breaker)(self);
-		}
+		connection_breakers.break_all(std::hash<decltype(this)>{}(this));
 	}
 
 	/// Provides token
 	data_t operator()() { return call(); }
 
 	/// Registers callback to disconnect port
-	void register_callback(std::shared_ptr<std::function<void(size_t)>>& visit_fun)
+	void register_callback(detail::connection_breaker& breaker)
 	{
-		assert(visit_fun);
-		assert(*visit_fun);
-		connection_breakers.emplace_back(visit_fun);
+		breaker.connect(connection_breakers);
 	}
 
 	using result_t = data_t;
@@ -89,7 +87,7 @@ public:
 
 private:
 	std::function<data_t()> call;
-	std::vector<std::weak_ptr<std::function<void(size_t)>>> connection_breakers;
+	detail::breaker_registry connection_breakers;
 };
 
 } // namespace pure
@@ -0,0 +1,104 @@
+#ifndef SRC_PORTS_EVENT_SOURCES_STATIC_EVENT_SOURCE_HPP_
+#define SRC_PORTS_EVENT_SOURCES_STATIC_EVENT_SOURCE_HPP_
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace fc
+{
+namespace pure
+{
+
+/**
+ * \brief Output port for events with a fixed set of handlers known at compile time.
+ *
+ * Alternative to event_source for hot paths with several connections.
+ * The handlers are stored by value next to each other inside the port,
+ * they are not type erased and calls to them can be inlined.
+ * In exchange the handlers are fixed on construction,
+ * the port cannot be connected or disconnected later.
+ * Handlers can be lambdas, connections or std::ref of event_sinks.
+ *
+ * Like event_source, all handlers but the last receive a copy of the event,
+ * the last receives it as it was passed to fire.
+ *
+ * \tparam event_t type of event sent
+ * \tparam handler_t types of handlers, called in the order given.
+ * \ingroup ports
+ */
+template<class event_t, class... handler_t>
+class static_event_source
+{
+public:
+	static_assert(sizeof...(handler_t) > 0, "static_event_source needs at least one handler");
+
+	using result_t = std::remove_reference_t<event_t>;
+	using token_t = event_t;
+
+	explicit static_event_source(handler_t... new_handlers)
+		: handlers(std::move(new_handlers)...)
+	{
+	}
+
+	/**
+	 * \brief Sends parameter as event to all handlers.
+	 * \param event token to be sent through this port.
+	 */
+	template<class... T>
+	void fire(T&&... event)
+	{
+		static_assert(sizeof...(T) == 0 || sizeof...(T) == 1,
+				"we only allow single events, or void events atm");
+
+		static_assert(std::is_void<event_t>{} ||
+				std::is_constructible<event_t, T...>{},
+				"tried to call fire with a type, not implicitly convertible to type of port."
+				"If conversion is required, do the cast before calling fire.");
+
+		call_handlers<0>(std::forward<T>(event)...);
+	}
+
+	/// Gives the number of handlers of this port.
+	static constexpr size_t nr_connected_handlers() { return sizeof...(handler_t); }
+
+private:
+	static constexpr size_t last = sizeof...(handler_t) - 1;
+
+	template<size_t index, class... T>
+	std::enable_if_t<index != last> call_handlers(T&&... event)
+	{
+		std::get<index>(handlers)(static_cast<event_t>(event)...);
+		call_handlers<index + 1>(std::forward<T>(event)...);
+	}
+
+	template<size_t index, class... T>
+	std::enable_if_t<index == last> call_handlers(T&&... event)
+	{
+		std::get<index>(handlers)(static_cast<event_t>(std::forward<T>(event))...);
+	}
+
+	std::tuple<handler_t...> handlers;
+};
+
+/**
+ * \brief creates static_event_source sending events of type event_t to handlers.
+ *
+ * \code{cpp}
+ * auto source = make_static_event_source<int>(
+ *         [](int i){ ... },
+ *         std::ref(some_event_sink));
+ * \endcode
+ */
+template<class event_t, class... handler_t>
+auto make_static_event_source(handler_t&&... handlers)
+{
+	return static_event_source<event_t, std::decay_t<handler_t>...>(
+			std::forward<handler_t>(handlers)...);
+}
+
+} // namespace pure
+} // namespace fc
+
+#endif /* SRC_PORTS_EVENT_SOURCES_STATIC_EVENT_SOURCE_HPP_ */
@@ -0,0 +1,88 @@
+#ifndef SRC_PORTS_STATES_STATIC_STATE_SINK_HPP_
+#define SRC_PORTS_STATES_STATIC_STATE_SINK_HPP_
+
+#include <flexcore/core/traits.hpp>
+
+#include <type_traits>
+#include <utility>
+
+namespace fc
+{
+namespace pure
+{
+
+/**
+ * \brief Input port for states with a connection fixed at compile time.
+ *
+ * Alternative to state_sink for hot paths, like static_event_source for events.
+ * The connection is stored by value inside the port, it is not type erased
+ * and the whole chain of connectables can be inlined into get.
+ * In exchange the connection is fixed on construction,
+ * the port cannot be connected to a different source later.
+ *
+ * \tparam data_t data type returned by get,
+ * can be a const reference to borrow states like state_sink.
+ * \tparam connection_t type of the connection, a passive source.
+ * \ingroup ports
+ */
+template<class data_t, class connection_t>
+class static_state_sink
+{
+public:
+	static_assert(is_passive_source<connection_t>{},
+			"only passive sources can be connected to a static_state_sink");
+	static_assert(std::is_convertible<decltype(std::declval<connection_t&>()()), data_t>{},
+			"The type returned by this connection is incompatible with this sink.");
+	static_assert(!std::is_reference<data_t>{} ||
+			std::is_reference<decltype(std::declval<connection_t&>()())>{},
+			"A static_state_sink borrowing states can only be connected to connections"
+			" returning references, a temporary would be dangling.");
+
+	using result_t = void;
+	using token_t = data_t;
+
+	explicit static_state_sink(connection_t new_connection)
+		: connection(std::move(new_connection))
+	{
+	}
+
+	/// pulls state from the connection.
+	data_t get() { return connection(); }
+
+	/// static_state_sink is always connected.
+	static constexpr bool is_connected() noexcept { return true; }
+
+private:
+	connection_t connection;
+};
+
+/**
+ * \brief creates static_state_sink pulling from connection.
+ *
+ * The type of the state is the type returned by connection, without references.
+ * \code{cpp}
+ * auto sink = make_static_state_sink(
+ *         [&x](){ return x; } >> [](float in){ return in * 2; });
+ * float y = sink.get();
+ * \endcode
+ */
+template<class connection_t>
+auto make_static_state_sink(connection_t&& connection)
+{
+	using data_t = std::decay_t<decltype(connection())>;
+	return static_state_sink<data_t, std::decay_t<connection_t>>(
+			std::forward<connection_t>(connection));
+}
+
+/// creates static_state_sink of states of type data_t pulling from connection.
+template<class data_t, class connection_t>
+auto make_static_state_sink(connection_t&& connection)
+{
+	return static_state_sink<data_t, std::decay_t<connection_t>>(
+			std::forward<connection_t>(connection));
+}
+
+} // namespace pure
+} // namespace fc
+
+#endif /* SRC_PORTS_STATES_STATIC_STATE_SINK_HPP_ */
@@ -1,9 +1,14 @@
 #ifndef SRC_RANGE_ACTIONS_HPP_
 #define SRC_RANGE_ACTIONS_HPP_
 
+#include <flexcore/core/connection.hpp>
+
 #include <numeric>
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <iterator>
+#include <type_traits>
 
 namespace fc
 {
@@ -41,7 +46,11 @@ struct map_action
 	target_range target;
 };
 
-/// Specialization for map_action where type of output range is the same as input range.
+/**
+ * \brief Specialization for map_action where type of output range is the same as input range.
+ * \note rvalue ranges are moved in and modified in place, lvalue ranges are copied first.
+ * map_into_action avoids the copy.
+ */
 template<class operation>
 struct map_action<operation, void>
 {
@@ -56,6 +65,32 @@ struct map_action<operation, void>
 	operation op;
 };
 
+namespace detail
+{
+/// operation applying first and then second, the result of fusing two maps.
+template<class first_op, class second_op>
+struct composed_operation
+{
+	template<class T>
+	decltype(auto) operator()(T&& in)
+	{
+		return second(first(std::forward<T>(in)));
+	}
+	first_op first;
+	second_op second;
+};
+
+template<class T>
+struct is_inplace_map : std::false_type {};
+template<class operation>
+struct is_inplace_map<map_action<operation, void>> : std::true_type {};
+
+template<class T>
+struct ends_in_inplace_map : std::false_type {};
+template<class source_t, class operation>
+struct ends_in_inplace_map<connection<source_t, map_action<operation, void>>> : std::true_type {};
+} // namespace detail
+
 /**
  * \brief Create connectable which performs higher order function map
  * \param op operation to execute on each element in range
@@ -78,6 +113,44 @@ auto map(operation op, target_range t = target_range{} )
 	return map_action<operation, target_range> { op, t };
 }
 
+/**
+ * \brief Eager map into a buffer owned by the action, which is reused every call.
+ *
+ * Unlike map_action, the input is not copied and the result is not returned by value.
+ * The buffer keeps its capacity, thus once it has grown to the largest input,
+ * calls do not allocate. Chains of map_into and filter_into pass buffers by reference.
+ *
+ * \tparam operation operation to apply to each element of range.
+ * \tparam target_range type of the buffer, needs resize.
+ * \note the returned reference is valid until the next call.
+ */
+template<class operation, class target_range>
+struct map_into_action
+{
+	template<class in_range>
+	const target_range& operator()(const in_range& input)
+	{
+		using std::begin;
+		using std::end;
+		target.resize(input.size());
+		std::transform(begin(input), end(input), begin(target), op);
+		return target;
+	}
+	operation op;
+	target_range target;
+};
+
+/**
+ * \brief Create connectable which performs map into a reused buffer.
+ * \param op operation to execute on each element in range
+ * \param t buffer, which keeps its capacity between calls.
+ */
+template<class operation, class target_range>
+auto map_into(operation op, target_range t)
+{
+	return map_into_action<operation, target_range> { op, std::move(t) };
+}
+
 /**
  * \brief Eager Version of Higher order function filter as a connectable.
  *
@@ -85,6 +158,9 @@ auto map(operation op, target_range t = target_range{} )
  * needs to be function taking object convertible from elements of range
  * and return boolean.
  *
+ * \note rvalue ranges are moved in and filtered in place, lvalue ranges are copied first.
+ * filter_into_action avoids the copy.
+ *
  * \see https://en.wikipedia.org/wiki/Filter_%28higher-order_function%29
  */
 template<class predicate>
@@ -116,6 +192,41 @@ auto filter(predicate pred)
 	return filter_action<predicate> { pred };
 }
 
+/**
+ * \brief Eager filter into a buffer owned by the action, which is reused every call.
+ *
+ * Elements passing pred are copied into the buffer, which is cleared before,
+ * but keeps its capacity. Thus calls do not allocate in a steady state.
+ * \see map_into_action
+ * \note the returned reference is valid until the next call.
+ */
+template<class predicate, class target_range>
+struct filter_into_action
+{
+	template<class in_range>
+	const target_range& operator()(const in_range& input)
+	{
+		using std::begin;
+		using std::end;
+		target.clear();
+		std::copy_if(begin(input), end(input), std::back_inserter(target), pred);
+		return target;
+	}
+	predicate pred;
+	target_range target;
+};
+
+/**
+ * \brief Create connectable which performs filter into a reused buffer.
+ * \param pred predicate elements need to fulfill to be kept.
+ * \param t buffer, which keeps its capacity between calls.
+ */
+template<class predicate, class target_range>
+auto filter_into(predicate pred, target_range t)
+{
+	return filter_into_action<predicate, target_range> { pred, std::move(t) };
+}
+
 /**
  * \brief Eager Version of Zip Higher Order Function.
  *
@@ -159,6 +270,50 @@ auto zip(binop op, param_range param)
 
 }  // namespace actions
 
+namespace detail
+{
+
+/**
+ * \brief Fuses map >> map into a single map.
+ *
+ * The range is traversed once with both operations applied to each element,
+ * instead of twice, which keeps the loop a candidate for vectorization.
+ */
+template<class source_t, class sink_t>
+struct connect_impl<source_t, sink_t, std::enable_if_t<
+		actions::detail::is_inplace_map<std::decay_t<source_t>>{}
+		&& actions::detail::is_inplace_map<std::decay_t<sink_t>>{}>>
+{
+	auto operator()(source_t&& source, sink_t&& sink) const
+	{
+		using fused_t = actions::detail::composed_operation<
+				decltype(std::decay_t<source_t>::op), decltype(std::decay_t<sink_t>::op)>;
+		return actions::map_action<fused_t, void>{
+				fused_t{std::forward<source_t>(source).op, std::forward<sink_t>(sink).op}};
+	}
+};
+
+/// Fuses a map at the end of a chain with a following map, see above.
+template<class source_t, class sink_t>
+struct connect_impl<source_t, sink_t, std::enable_if_t<
+		actions::detail::ends_in_inplace_map<std::decay_t<source_t>>{}
+		&& actions::detail::is_inplace_map<std::decay_t<sink_t>>{}>>
+{
+	auto operator()(source_t&& source, sink_t&& sink) const
+	{
+		using head_t = decltype(source.source);
+		using fused_t = actions::detail::composed_operation<
+				decltype(source.sink.op), decltype(std::decay_t<sink_t>::op)>;
+		return connection<head_t, actions::map_action<fused_t, void>>{
+				std::forward<source_t>(source).source,
+				actions::map_action<fused_t, void>{
+						fused_t{std::forward<source_t>(source).sink.op,
+								std::forward<sink_t>(sink).op}}};
+	}
+};
+
+} // namespace detail
+
 /**
  * \brief Higher order function reduce aka fold as a connectable.
  *
@@ -199,6 +354,70 @@ auto sum(T initial_value = T())
 	return reduce(std::plus<>(), initial_value);
 }
 
+/**
+ * \brief reduce with independent partial results per lane.
+ *
+ * Elements are reduced into lanes partial results, which are combined at the end.
+ * Unlike reduce_view, the loop has no dependency from each element to the one before,
+ * which allows it to be vectorized, even for floating point types.
+ *
+ * \tparam binop binary operation, needs to be associative and commutative.
+ * For floating point values the result may differ from reduce by rounding.
+ * \tparam lanes number of partial results.
+ * \pre input range is random access.
+ */
+template<class binop, class T, size_t lanes = 8>
+struct lanewise_reduce_view
+{
+	static_assert(lanes > 0, "lanewise_reduce needs at least one lane.");
+
+	explicit lanewise_reduce_view(const binop& op = binop(), const T&  init_value = T())
+		: op(op), init_value(init_value)
+	{
+	}
+
+	template<class in_range>
+	auto operator()(in_range&& input)
+	{
+		using std::begin;
+		using std::end;
+		const auto first = begin(input);
+		static_assert(std::is_base_of<std::random_access_iterator_tag,
+				typename std::iterator_traits<decltype(first)>::iterator_category>{},
+				"lanewise_reduce requires random access ranges.");
+		const size_t size = std::distance(first, end(input));
+		if (size < lanes)
+			return std::accumulate(first, end(input), init_value, op);
+
+		std::array<T, lanes> partial;
+		for (size_t lane = 0; lane != lanes; ++lane)
+			partial[lane] = first[lane];
+		const size_t blocks_end = size - size % lanes;
+		for (size_t block = lanes; block != blocks_end; block += lanes)
+			for (size_t lane = 0; lane != lanes; ++lane)
+				partial[lane] = op(partial[lane], first[block + lane]);
+
+		auto result = std::accumulate(begin(partial), end(partial), init_value, op);
+		return std::accumulate(first + blocks_end, end(input), result, op);
+	}
+	binop op;
+	T init_value;
+};
+
+/// Create connectable which performs reduce with independent lanes.
+template<class binop, class T>
+auto lanewise_reduce(binop op, T initial_value)
+{
+	return lanewise_reduce_view<binop, T> { op, initial_value };
+}
+
+/// alias of lanewise_reduce to sum all elements, see lanewise_reduce_view.
+template<class T>
+auto lanewise_sum(T initial_value = T())
+{
+	return lanewise_reduce(std::plus<>(), initial_value);
+}
+
 }  // namespace fc
 
 #endif /* SRC_RANGE_ACTIONS_HPP_ */
@@ -0,0 +1,339 @@
+#ifndef SRC_RANGE_OFFLOAD_HPP_
+#define SRC_RANGE_OFFLOAD_HPP_
+
+#include <flexcore/core/connection.hpp>
+#include <flexcore/range/parallel_actions.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fc
+{
+
+/**
+ * \brief Range actions on vectors resident in the memory of an offload backend.
+ *
+ * A chain of stages starts with to_device, which uploads a vector once,
+ * and ends with to_host or reduce. In between, device_vector flows through ports
+ * and connections without copies to host memory. Consecutive map and zip stages
+ * are fused into a single kernel, which traverses the vector once.
+ *
+ *     input >> offload::to_device(backend)
+ *           >> offload::map([](float x){ return x * 2; })
+ *           >> offload::zip(std::plus<>(), weights)
+ *           >> offload::sum(0.0f) >> sink;
+ *
+ * The backend is a template parameter, which executes the fused kernels.
+ * host_backend splits them into chunks processed by a scheduler, see parallel_policy.
+ * Backends for accelerators provide the same members, see host_backend, and need
+ * operations which can be compiled for the device, like lambdas marked __device__.
+ */
+namespace offload
+{
+
+/**
+ * \brief offload backend running kernels on the threads of the host.
+ *
+ * Describes the interface of backends: buffers hold the memory on the device,
+ * upload and download copy between host and device, copy clones a buffer
+ * on the device, for_each calls kernel(i) for all i in [0, size)
+ * and reduce folds a buffer with an associative operation.
+ */
+struct host_backend
+{
+	template<class T>
+	using buffer = std::vector<T>;
+
+	template<class T>
+	static T* data(buffer<T>& b) noexcept { return b.data(); }
+	template<class T>
+	static const T* data(const buffer<T>& b) noexcept { return b.data(); }
+	template<class T>
+	static size_t size(const buffer<T>& b) noexcept { return b.size(); }
+
+	template<class T>
+	buffer<T> upload(const std::vector<T>& host) const { return host; }
+	template<class T>
+	std::vector<T> download(const buffer<T>& device) const { return device; }
+	template<class T>
+	buffer<T> copy(const buffer<T>& device) const { return device; }
+
+	template<class kernel_t>
+	void for_each(size_t size, const kernel_t& kernel) const
+	{
+		actions::detail::for_each_chunk(policy, size,
+				[&kernel](size_t, size_t b, size_t e)
+				{
+					for (size_t i = b; i != e; ++i)
+						kernel(i);
+				});
+	}
+
+	template<class T, class U, class binop>
+	T reduce(const buffer<U>& device, binop op, T init) const
+	{
+		return parallel_reduce(op, init, policy)(device);
+	}
+
+	/// serial without a scheduler.
+	actions::parallel_policy policy;
+};
+
+/**
+ * \brief vector in the memory of an offload backend, passed through ports by reference.
+ *
+ * Like cow, copies share the buffer, which is cloned on the device before it is
+ * written while shared. A default constructed device_vector has neither buffer nor backend.
+ */
+template<class T, class backend_t = host_backend>
+class device_vector
+{
+public:
+	using value_type = T;
+	using buffer_t = typename backend_t::template buffer<T>;
+
+	device_vector() = default;
+	device_vector(std::shared_ptr<const backend_t> backend, buffer_t buffer)
+		: backend_(std::move(backend))
+		, buffer_(std::make_shared<buffer_t>(std::move(buffer)))
+	{
+		assert(backend_);
+	}
+
+	size_t size() const noexcept { return buffer_ ? backend_t::size(*buffer_) : 0; }
+	const backend_t& backend() const noexcept { return *backend_; }
+	const std::shared_ptr<const backend_t>& shared_backend() const noexcept { return backend_; }
+
+	/// returns the device address of the elements, which kernels access.
+	const T* data() const noexcept
+	{
+		assert(buffer_);
+		return backend_t::data(*buffer_);
+	}
+	const buffer_t& buffer() const noexcept
+	{
+		assert(buffer_);
+		return *buffer_;
+	}
+
+	/// returns the device address of the elements for modification, cloning a shared buffer.
+	T* write()
+	{
+		assert(buffer_);
+		if (buffer_.use_count() != 1)
+			buffer_ = std::make_shared<buffer_t>(backend_->copy(*buffer_));
+		return backend_t::data(*buffer_);
+	}
+
+	/// returns true if both share the same buffer.
+	bool shares(const device_vector& other) const noexcept { return buffer_ == other.buffer_; }
+
+private:
+	std::shared_ptr<const backend_t> backend_;
+	std::shared_ptr<buffer_t> buffer_;
+};
+
+/// uploads vectors into device_vectors of backend, see to_device.
+template<class backend_t>
+struct upload_stage
+{
+	template<class T>
+	device_vector<T, backend_t> operator()(const std::vector<T>& host) const
+	{
+		return device_vector<T, backend_t>{backend, backend->upload(host)};
+	}
+	std::shared_ptr<const backend_t> backend;
+};
+
+/// Create connectable which starts an offloaded chain by uploading its input to backend.
+template<class backend_t>
+auto to_device(std::shared_ptr<const backend_t> backend)
+{
+	assert(backend);
+	return upload_stage<backend_t>{std::move(backend)};
+}
+
+/// downloads device_vectors into vectors, see to_host.
+struct download_stage
+{
+	template<class T, class backend_t>
+	std::vector<T> operator()(const device_vector<T, backend_t>& device) const
+	{
+		return device.backend().download(device.buffer());
+	}
+};
+
+/// Create connectable which ends an offloaded chain by copying the vector to the host.
+inline download_stage to_host()
+{
+	return download_stage{};
+}
+
+/**
+ * \brief stage applying op(x, i) to every element x at index i of a device_vector.
+ *
+ * The result of map and zip, stages following each other are fused,
+ * see connect_impl below. The vector is written in place, unless it is shared.
+ */
+template<class element_op>
+struct elementwise_stage
+{
+	template<class T, class backend_t>
+	device_vector<T, backend_t> operator()(device_vector<T, backend_t> input) const
+	{
+		const auto size = input.size();
+		const auto values = input.write();
+		const auto& kernel_op = op;
+		input.backend().for_each(size,
+				[values, kernel_op](size_t i) { values[i] = kernel_op(values[i], i); });
+		return input;
+	}
+	element_op op;
+};
+
+namespace detail
+{
+template<class operation>
+struct map_op
+{
+	template<class T>
+	auto operator()(const T& x, size_t) const { return op(x); }
+	operation op;
+};
+
+template<class binop, class param_t>
+struct zip_op
+{
+	template<class T>
+	auto operator()(const T& x, size_t i) const { return op(x, param_data[i]); }
+	binop op;
+	/// keeps the parameter alive, kernels only access param_data.
+	param_t param;
+	const typename param_t::value_type* param_data;
+};
+
+/// element operation of two fused stages, applying first and then second.
+template<class first_op, class second_op>
+struct fused_op
+{
+	template<class T>
+	auto operator()(const T& x, size_t i) const { return second(first(x, i), i); }
+	first_op first;
+	second_op second;
+};
+
+template<class T>
+struct is_elementwise : std::false_type {};
+template<class element_op>
+struct is_elementwise<elementwise_stage<element_op>> : std::true_type {};
+
+template<class T>
+struct ends_in_elementwise : std::false_type {};
+template<class source_t, class element_op>
+struct ends_in_elementwise<connection<source_t, elementwise_stage<element_op>>>
+		: std::true_type {};
+} // namespace detail
+
+/// Create connectable which applies op to every element on the device.
+template<class operation>
+auto map(operation op)
+{
+	return elementwise_stage<detail::map_op<operation>>{{op}};
+}
+
+/**
+ * \brief Create connectable which combines every element with the element of param on the device.
+ * \param param device_vector with at least as many elements as the input.
+ */
+template<class binop, class T, class backend_t>
+auto zip(binop op, device_vector<T, backend_t> param)
+{
+	const auto param_data = param.data();
+	using zip_t = detail::zip_op<binop, device_vector<T, backend_t>>;
+	return elementwise_stage<zip_t>{zip_t{op, std::move(param), param_data}};
+}
+
+/// folds device_vectors on the device, see reduce.
+template<class binop, class T>
+struct reduce_stage
+{
+	template<class U, class backend_t>
+	T operator()(const device_vector<U, backend_t>& device) const
+	{
+		return device.backend().reduce(device.buffer(), op, init_value);
+	}
+	binop op;
+	T init_value;
+};
+
+/**
+ * \brief Create connectable which ends an offloaded chain by folding it on the device.
+ * \param op associative binary operation, the order of folding depends on the backend.
+ */
+template<class binop, class T>
+auto reduce(binop op, T initial_value)
+{
+	return reduce_stage<binop, T>{op, initial_value};
+}
+
+/// alias of reduce to sum all elements.
+template<class T>
+auto sum(T initial_value = T())
+{
+	return reduce(std::plus<>(), initial_value);
+}
+
+} // namespace offload
+
+namespace detail
+{
+
+/**
+ * \brief Fuses offloaded map and zip stages into a single kernel.
+ *
+ * The fused kernel reads and writes each element once, instead of once per stage,
+ * which is what limits element-wise kernels on large vectors.
+ */
+template<class source_t, class sink_t>
+struct connect_impl<source_t, sink_t, std::enable_if_t<
+		offload::detail::is_elementwise<std::decay_t<source_t>>{}
+		&& offload::detail::is_elementwise<std::decay_t<sink_t>>{}>>
+{
+	auto operator()(source_t&& source, sink_t&& sink) const
+	{
+		using fused_t = offload::detail::fused_op<
+				decltype(std::decay_t<source_t>::op), decltype(std::decay_t<sink_t>::op)>;
+		return offload::elementwise_stage<fused_t>{
+				fused_t{std::forward<source_t>(source).op, std::forward<sink_t>(sink).op}};
+	}
+};
+
+/// Fuses an offloaded stage at the end of a chain with a following one, see above.
+template<class source_t, class sink_t>
+struct connect_impl<source_t, sink_t, std::enable_if_t<
+		offload::detail::ends_in_elementwise<std::decay_t<source_t>>{}
+		&& offload::detail::is_elementwise<std::decay_t<sink_t>>{}>>
+{
+	auto operator()(source_t&& source, sink_t&& sink) const
+	{
+		using head_t = decltype(source.source);
+		using fused_t = offload::detail::fused_op<
+				decltype(source.sink.op), decltype(std::decay_t<sink_t>::op)>;
+		return connection<head_t, offload::elementwise_stage<fused_t>>{
+				std::forward<source_t>(source).source,
+				offload::elementwise_stage<fused_t>{
+						fused_t{std::forward<source_t>(source).sink.op,
+								std::forward<sink_t>(sink).op}}};
+	}
+};
+
+} // namespace detail
+} // namespace fc
+
+#endif /* SRC_RANGE_OFFLOAD_HPP_ */
@@ -0,0 +1,138 @@
+#include <flexcore/range/parallel_actions.hpp>
+#include <flexcore/scheduler/scheduler.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace fc
+{
+namespace actions
+{
+
+constexpr size_t parallel_policy::default_threshold;
+constexpr size_t parallel_policy::default_min_chunk;
+
+namespace
+{
+/// chunks per thread of the pool, more chunks balance the load better.
+constexpr size_t chunks_per_thread = 4;
+
+/**
+ * \brief shared by the calling thread and all helping tasks.
+ *
+ * Helping tasks may start after all chunks are done and the caller has returned,
+ * they only touch the state, which they own a share of, and find no chunk left.
+ */
+struct chunk_state
+{
+	chunk_state(const std::function<void(size_t, size_t, size_t)>& body,
+			size_t size, size_t nr_of_chunks, size_t chunk_size)
+		: body(body)
+		, size(size)
+		, nr_of_chunks(nr_of_chunks)
+		, chunk_size(chunk_size)
+	{
+		assert((nr_of_chunks - 1) * chunk_size < size);
+	}
+
+	/// processes chunks until none are left.
+	void work()
+	{
+		for (size_t chunk = next.fetch_add(1); chunk < nr_of_chunks; chunk = next.fetch_add(1))
+		{
+			if (!failed.load(std::memory_order_relaxed))
+			{
+				try
+				{
+					const auto b = chunk * chunk_size;
+					body(chunk, b, std::min(b + chunk_size, size));
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if (!error)
+						error = std::current_exception();
+					failed.store(true, std::memory_order_relaxed);
+				}
+			}
+			if (done.fetch_add(1) + 1 == nr_of_chunks)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				finished.notify_all();
+			}
+		}
+	}
+
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [this] { return done.load() == nr_of_chunks; });
+	}
+
+	std::function<void(size_t, size_t, size_t)> body;
+	const size_t size;
+	const size_t nr_of_chunks;
+	const size_t chunk_size;
+	std::atomic<size_t> next{0};
+	std::atomic<size_t> done{0};
+	std::atomic<bool> failed{false};
+	std::mutex mutex;
+	std::condition_variable finished;
+	std::exception_ptr error;
+};
+}
+
+size_t parallel_policy::chunk_size(size_t size) const
+{
+	if (!pool || size < threshold)
+		return size;
+	const auto max_chunks = chunks_per_thread * std::max<size_t>(pool->nr_of_threads(), 1);
+	const auto wanted = std::max<size_t>(1,
+			std::min(size / std::max<size_t>(min_chunk, 1), max_chunks));
+	return (size + wanted - 1) / wanted;
+}
+
+size_t parallel_policy::nr_of_chunks(size_t size) const
+{
+	if (size == 0)
+		return 0;
+	// rounded up chunks may cover the range with less chunks than wanted,
+	// counting them from the chunk size leaves no chunk empty.
+	const auto chunk = chunk_size(size);
+	return (size + chunk - 1) / chunk;
+}
+
+size_t detail::for_each_chunk(const parallel_policy& policy, size_t size,
+		const std::function<void(size_t chunk, size_t begin, size_t end)>& body)
+{
+	const auto nr_of_chunks = policy.nr_of_chunks(size);
+	if (nr_of_chunks <= 1)
+	{
+		if (nr_of_chunks == 1)
+			body(0, 0, size);
+		return nr_of_chunks;
+	}
+
+	assert(policy.pool);
+	auto state = std::make_shared<chunk_state>(body, size, nr_of_chunks,
+			policy.chunk_size(size));
+	const auto nr_of_helpers = std::min(policy.pool->nr_of_threads(), nr_of_chunks - 1);
+	std::vector<thread::scheduler::affine_task> helpers;
+	helpers.reserve(nr_of_helpers);
+	for (size_t i = 0; i != nr_of_helpers; ++i)
+		helpers.push_back({[state] { state->work(); }, thread::scheduler::any_worker});
+	policy.pool->add_tasks(helpers);
+
+	// the calling thread works as well, so it only waits for chunks already started.
+	state->work();
+	state->wait();
+	if (state->error)
+		std::rethrow_exception(state->error);
+	return nr_of_chunks;
+}
+
+} // namespace actions
+} // namespace fc
@@ -0,0 +1,248 @@
+#ifndef SRC_RANGE_PARALLEL_ACTIONS_HPP_
+#define SRC_RANGE_PARALLEL_ACTIONS_HPP_
+
+#include <flexcore/range/actions.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+namespace fc
+{
+namespace thread { class scheduler; }
+
+namespace actions
+{
+
+/**
+ * \brief Determines if and on which scheduler parallel range actions split up their work.
+ *
+ * Ranges smaller than threshold are processed serially by the calling thread,
+ * as are all ranges if there is no scheduler.
+ * Larger ranges are split into chunks, which are processed by the calling thread
+ * together with tasks added to the scheduler. The calling thread never waits
+ * for a task which has not started yet, therefore parallel actions can be used
+ * from tasks running on the same scheduler, for example cycle_control::task_scheduler().
+ */
+struct parallel_policy
+{
+	static constexpr size_t default_threshold = 1 << 16;
+	static constexpr size_t default_min_chunk = 1 << 12;
+
+	/// scheduler to add helping tasks to, nullptr to process all ranges serially.
+	thread::scheduler* pool = nullptr;
+	/// ranges with less elements are processed serially.
+	size_t threshold = default_threshold;
+	/// ranges are not split into chunks smaller than this.
+	size_t min_chunk = default_min_chunk;
+
+	/// returns the number of chunks a range of size elements is split into, none of them empty.
+	size_t nr_of_chunks(size_t size) const;
+	/// returns the number of elements of all chunks but the last of a range of size elements.
+	size_t chunk_size(size_t size) const;
+};
+
+/// Creates parallel_policy, which splits ranges from threshold elements on.
+inline parallel_policy parallel(thread::scheduler& pool,
+		size_t threshold = parallel_policy::default_threshold)
+{
+	return parallel_policy{&pool, threshold, parallel_policy::default_min_chunk};
+}
+
+namespace detail
+{
+/**
+ * \brief calls body for all chunks [begin, end) of the range [0, size).
+ *
+ * Chunks are of equal size, except for the last one, which may be smaller but not empty.
+ * If body throws, remaining chunks are skipped and the first exception is rethrown,
+ * after all started chunks have finished.
+ * \returns the number of chunks.
+ */
+size_t for_each_chunk(const parallel_policy& policy, size_t size,
+		const std::function<void(size_t chunk, size_t begin, size_t end)>& body);
+
+template<class iter>
+void check_random_access()
+{
+	static_assert(std::is_base_of<std::random_access_iterator_tag,
+			typename std::iterator_traits<iter>::iterator_category>{},
+			"parallel range actions require random access ranges.");
+}
+} // namespace detail
+
+/**
+ * \brief Eager map in place, which splits large ranges into chunks processed in parallel.
+ * \tparam operation operation to apply to each element of the range,
+ * needs to be callable concurrently.
+ */
+template<class operation>
+struct parallel_map_action
+{
+	template<class in_range>
+	auto operator()(in_range input)
+	{
+		using std::begin;
+		const auto first = begin(input);
+		detail::check_random_access<decltype(first)>();
+		detail::for_each_chunk(policy, input.size(),
+				[this, first](size_t, size_t b, size_t e)
+				{ std::transform(first + b, first + e, first + b, op); });
+		return input;
+	}
+	operation op;
+	parallel_policy policy;
+};
+
+/// Create connectable which performs map in parallel according to policy.
+template<class operation>
+auto parallel_map(operation op, parallel_policy policy)
+{
+	return parallel_map_action<operation>{ op, policy };
+}
+
+/**
+ * \brief Eager zip, which splits large ranges into chunks processed in parallel.
+ * \see zip_action
+ */
+template<class binop, class param_range>
+struct parallel_zip_action
+{
+	template<class in_range>
+	auto operator()(in_range input)
+	{
+		assert(static_cast<size_t>(input.size()) ==
+				static_cast<size_t>(zip_with.size()));
+
+		using std::begin;
+		const auto first = begin(input);
+		const auto param = begin(zip_with);
+		detail::check_random_access<decltype(first)>();
+		detail::check_random_access<decltype(param)>();
+		detail::for_each_chunk(policy, input.size(),
+				[this, first, param](size_t, size_t b, size_t e)
+				{ std::transform(first + b, first + e, param + b, first + b, op); });
+		return input;
+	}
+
+	binop op;
+	param_range zip_with;
+	parallel_policy policy;
+};
+
+/// Create connectable which performs zip in parallel according to policy.
+template<class binop, class param_range>
+auto parallel_zip(binop op, param_range param, parallel_policy policy)
+{
+	return parallel_zip_action<binop, param_range>{op, param, policy};
+}
+
+/**
+ * \brief Eager filter, which splits large ranges into chunks processed in parallel.
+ *
+ * The order of the remaining elements is kept.
+ * Each chunk is filtered in parallel, afterwards the remaining elements
+ * of all chunks are moved together by the calling thread.
+ * \see filter_action
+ */
+template<class predicate>
+struct parallel_filter_action
+{
+	template<class in_range>
+	auto operator()(in_range data)
+	{
+		using std::begin;
+		using std::end;
+		const auto first = begin(data);
+		detail::check_random_access<decltype(first)>();
+
+		// [begin of chunk, end of remaining elements of chunk)
+		std::vector<std::pair<size_t, size_t>> kept(policy.nr_of_chunks(data.size()));
+		const auto chunks = detail::for_each_chunk(policy, data.size(),
+				[this, first, &kept](size_t chunk, size_t b, size_t e)
+				{
+					const auto mid = std::remove_if(first + b, first + e,
+							[this](const auto& in){ return !pred(in); });
+					kept[chunk] = {b, static_cast<size_t>(mid - first)};
+				});
+		assert(chunks <= kept.size());
+
+		auto out = first;
+		for (size_t chunk = 0; chunk != chunks; ++chunk)
+			out = std::move(first + kept[chunk].first, first + kept[chunk].second, out);
+		data.erase(out, end(data));
+		return data;
+	}
+	predicate pred;
+	parallel_policy policy;
+};
+
+/// Create connectable which performs filter in parallel according to policy.
+template<class predicate>
+auto parallel_filter(predicate pred, parallel_policy policy)
+{
+	return parallel_filter_action<predicate>{ pred, policy };
+}
+
+}  // namespace actions
+
+/**
+ * \brief reduce, which splits large ranges into chunks reduced in parallel.
+ *
+ * The results of the chunks are combined in the order of the chunks,
+ * thus the result does not depend on the timing of the threads.
+ * \tparam binop binary operation, needs to be associative and callable concurrently.
+ * For floating point values the result may differ from reduce by rounding.
+ */
+template<class binop, class T>
+struct parallel_reduce_view
+{
+	parallel_reduce_view(const binop& op, const T& init_value, actions::parallel_policy policy)
+		: op(op), init_value(init_value), policy(policy)
+	{
+	}
+
+	template<class in_range>
+	auto operator()(in_range&& input)
+	{
+		using std::begin;
+		const auto first = begin(input);
+		actions::detail::check_random_access<decltype(first)>();
+
+		// chunks are not empty, so each starts from its first element instead of init_value.
+		std::vector<T> partial(policy.nr_of_chunks(input.size()), init_value);
+		const auto chunks = actions::detail::for_each_chunk(policy, input.size(),
+				[this, first, &partial](size_t chunk, size_t b, size_t e)
+				{
+					partial[chunk] = std::accumulate(first + b + 1, first + e,
+							static_cast<T>(first[b]), op);
+				});
+		return std::accumulate(begin(partial), begin(partial) + chunks, init_value, op);
+	}
+	binop op;
+	T init_value;
+	actions::parallel_policy policy;
+};
+
+/// Create connectable which performs reduce in parallel according to policy.
+template<class binop, class T>
+auto parallel_reduce(binop op, T initial_value, actions::parallel_policy policy)
+{
+	return parallel_reduce_view<binop, T> { op, initial_value, policy };
+}
+
+/// alias of parallel_reduce to sum all elements.
+template<class T>
+auto parallel_sum(actions::parallel_policy policy, T initial_value = T())
+{
+	return parallel_reduce(std::plus<>(), initial_value, policy);
+}
+
+}  // namespace fc
+
+#endif /* SRC_RANGE_PARALLEL_ACTIONS_HPP_ */
@@ -0,0 +1,270 @@
+#ifndef SRC_RANGE_SOA_VECTOR_HPP_
+#define SRC_RANGE_SOA_VECTOR_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fc
+{
+
+/**
+ * \brief Container storing rows of T... as structure of arrays, with one vector per column.
+ *
+ * Algorithms working on a single column only touch the memory of that column,
+ * see actions::map_column and filter_column.
+ * Rows are accessed as std::tuple<T...> by value, thus soa_vector is a range of tuples,
+ * which can be received by collector ports of tuples and passed through buffers.
+ *
+ * soa_vector is cheap to move, moving a soa_vector moves all columns.
+ *
+ * \tparam T types of the columns, need to be default constructible.
+ */
+template<class... T>
+class soa_vector
+{
+public:
+	using value_type = std::tuple<T...>;
+	using size_type = size_t;
+	template<size_t column_index>
+	using column_t = std::vector<std::tuple_element_t<column_index, value_type>>;
+
+	/// iterator over rows, which are copied to a tuple on access.
+	class const_iterator
+	{
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = std::tuple<T...>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = value_type;
+
+		const_iterator() = default;
+		const_iterator(const soa_vector* owner, size_t row) : owner(owner), row(row) {}
+
+		reference operator*() const { return (*owner)[row]; }
+		reference operator[](difference_type n) const { return (*owner)[row + n]; }
+		const_iterator& operator++() { ++row; return *this; }
+		const_iterator operator++(int) { auto tmp = *this; ++row; return tmp; }
+		const_iterator& operator--() { --row; return *this; }
+		const_iterator operator--(int) { auto tmp = *this; --row; return tmp; }
+		const_iterator& operator+=(difference_type n) { row += n; return *this; }
+		const_iterator& operator-=(difference_type n) { row -= n; return *this; }
+		const_iterator operator+(difference_type n) const { return {owner, row + n}; }
+		const_iterator operator-(difference_type n) const { return {owner, row - n}; }
+		difference_type operator-(const const_iterator& o) const
+		{
+			return static_cast<difference_type>(row) - static_cast<difference_type>(o.row);
+		}
+		bool operator==(const const_iterator& o) const { return row == o.row; }
+		bool operator!=(const const_iterator& o) const { return row != o.row; }
+		bool operator<(const const_iterator& o) const { return row < o.row; }
+		bool operator>(const const_iterator& o) const { return row > o.row; }
+		bool operator<=(const const_iterator& o) const { return row <= o.row; }
+		bool operator>=(const const_iterator& o) const { return row >= o.row; }
+
+	private:
+		const soa_vector* owner = nullptr;
+		size_t row = 0;
+	};
+	using iterator = const_iterator;
+
+	soa_vector() = default;
+	/// constructs from a range of rows, for example a std::vector<std::tuple<T...>>.
+	template<class in_range, class = std::enable_if_t<
+			!std::is_same<std::decay_t<in_range>, soa_vector>{}>>
+	explicit soa_vector(const in_range& rows)
+	{
+		using std::begin;
+		using std::end;
+		insert(this->end(), begin(rows), end(rows));
+	}
+
+	size_t size() const { return std::get<0>(columns).size(); }
+	bool empty() const { return size() == 0; }
+
+	void resize(size_t new_size) { for_each_column([new_size](auto& c){ c.resize(new_size); }); }
+	void reserve(size_t new_capacity)
+	{
+		for_each_column([new_capacity](auto& c){ c.reserve(new_capacity); });
+	}
+	/// removes all rows, columns keep their capacity.
+	void clear() { for_each_column([](auto& c){ c.clear(); }); }
+
+	void push_back(const value_type& row) { push_back(row, std::index_sequence_for<T...>{}); }
+
+	/// appends rows [first, last) at the end.
+	/// \pre pos == end(), rows can only be inserted at the end.
+	template<class iter>
+	void insert(const_iterator pos, iter first, iter last)
+	{
+		assert(pos == end());
+		(void)pos;
+		for (; first != last; ++first)
+			push_back(*first);
+	}
+	/// appends row at the end.
+	/// \pre pos == end(), rows can only be inserted at the end.
+	void insert(const_iterator pos, const value_type& row)
+	{
+		assert(pos == end());
+		(void)pos;
+		push_back(row);
+	}
+
+	/// returns a copy of row as tuple.
+	value_type operator[](size_t row) const
+	{
+		assert(row < size());
+		return get_row(row, std::index_sequence_for<T...>{});
+	}
+
+	/// access to a single column, its size must not be changed.
+	template<size_t column_index>
+	column_t<column_index>& column() { return std::get<column_index>(columns); }
+	template<size_t column_index>
+	const column_t<column_index>& column() const { return std::get<column_index>(columns); }
+
+	const_iterator begin() const { return {this, 0}; }
+	const_iterator end() const { return {this, size()}; }
+
+	/// removes all rows for which the keep flag is false, keeping the order.
+	/// \pre keep.size() == size()
+	void compact(const std::vector<bool>& keep)
+	{
+		assert(keep.size() == size());
+		for_each_column([&keep](auto& c)
+		{
+			size_t out = 0;
+			for (size_t row = 0; row != c.size(); ++row)
+				if (keep[row])
+					c[out++] = std::move(c[row]);
+			c.resize(out);
+		});
+	}
+
+	bool operator==(const soa_vector& o) const { return columns == o.columns; }
+	bool operator!=(const soa_vector& o) const { return !(*this == o); }
+
+private:
+	template<class op_t>
+	void for_each_column(op_t&& op)
+	{
+		for_each_column(op, std::index_sequence_for<T...>{});
+	}
+	template<class op_t, size_t... I>
+	void for_each_column(op_t& op, std::index_sequence<I...>)
+	{
+		// expands to a call of op for every column.
+		(void)std::initializer_list<int>{(op(std::get<I>(columns)), 0)...};
+	}
+	template<size_t... I>
+	void push_back(const value_type& row, std::index_sequence<I...>)
+	{
+		(void)std::initializer_list<int>{(std::get<I>(columns).push_back(std::get<I>(row)), 0)...};
+	}
+	template<size_t... I>
+	value_type get_row(size_t row, std::index_sequence<I...>) const
+	{
+		return value_type{std::get<I>(columns)[row]...};
+	}
+
+	std::tuple<std::vector<T>...> columns;
+};
+
+namespace actions
+{
+
+/**
+ * \brief Eager map on a single column of a soa_vector, in place.
+ * \tparam column_index index of the column op is applied to.
+ */
+template<size_t column_index, class operation>
+struct map_column_action
+{
+	template<class soa_t>
+	auto operator()(soa_t input)
+	{
+		auto& c = input.template column<column_index>();
+		std::transform(c.begin(), c.end(), c.begin(), op);
+		return input;
+	}
+	operation op;
+};
+
+/// Create connectable which maps column column_index of a soa_vector with op.
+template<size_t column_index, class operation>
+auto map_column(operation op)
+{
+	return map_column_action<column_index, operation>{ op };
+}
+
+/**
+ * \brief Eager filter of rows of a soa_vector by a predicate on a single column.
+ *
+ * The predicate only reads the column column_index,
+ * the other columns are only touched to remove filtered rows.
+ */
+template<size_t column_index, class predicate>
+struct filter_column_action
+{
+	template<class soa_t>
+	auto operator()(soa_t data)
+	{
+		const auto& c = data.template column<column_index>();
+		keep.resize(c.size());
+		std::transform(c.begin(), c.end(), keep.begin(),
+				[this](const auto& in) -> bool { return pred(in); });
+		data.compact(keep);
+		return data;
+	}
+	predicate pred;
+	std::vector<bool> keep{}; ///< reused between calls to avoid allocations.
+};
+
+/// Create connectable which keeps rows of a soa_vector, whose column column_index fulfills pred.
+template<size_t column_index, class predicate>
+auto filter_column(predicate pred)
+{
+	return filter_column_action<column_index, predicate>{ pred };
+}
+
+/**
+ * \brief Eager zip of two columns of a soa_vector into a target column.
+ *
+ * target[i] = op(lhs[i], rhs[i]) for every row i.
+ * \tparam lhs_index, rhs_index columns which are parameters of op.
+ * \tparam target_index column the result is stored in, can be one of the parameters.
+ */
+template<size_t lhs_index, size_t rhs_index, size_t target_index, class binop>
+struct zip_columns_action
+{
+	template<class soa_t>
+	auto operator()(soa_t input)
+	{
+		const auto& lhs = input.template column<lhs_index>();
+		const auto& rhs = input.template column<rhs_index>();
+		auto& target = input.template column<target_index>();
+		std::transform(lhs.begin(), lhs.end(), rhs.begin(), target.begin(), op);
+		return input;
+	}
+	binop op;
+};
+
+/// Create connectable which zips columns lhs_index and rhs_index into target_index.
+template<size_t lhs_index, size_t rhs_index, size_t target_index, class binop>
+auto zip_columns(binop op)
+{
+	return zip_columns_action<lhs_index, rhs_index, target_index, binop>{ op };
+}
+
+} // namespace actions
+
+} // namespace fc
+
+#endif /* SRC_RANGE_SOA_VECTOR_HPP_ */
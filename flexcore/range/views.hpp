@@ -0,0 +1,277 @@
+#ifndef SRC_RANGE_VIEWS_HPP_
+#define SRC_RANGE_VIEWS_HPP_
+
+#include <flexcore/core/connection.hpp>
+#include <flexcore/range/actions.hpp>
+
+#include <cassert>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fc
+{
+
+/**
+ * \brief Range Views are lazy versions of range actions.
+ *
+ * A chain of views connected with >> is a single pipeline,
+ * which passes each element through all stages in a single loop.
+ * Only the end of the pipeline creates a container,
+ * or no container at all if the pipeline ends in a reduce.
+ */
+namespace views
+{
+
+/// stage of a pipeline, which applies op to each element.
+template<class operation>
+struct map_stage
+{
+	template<class T>
+	using result_t = std::decay_t<std::result_of_t<operation&(T)>>;
+
+	void reset() {}
+	template<class T, class next_t>
+	void push(T&& in, next_t&& next)
+	{
+		next(op(std::forward<T>(in)));
+	}
+	operation op;
+};
+
+/// stage of a pipeline, which only passes on elements fulfilling pred.
+template<class predicate>
+struct filter_stage
+{
+	template<class T>
+	using result_t = std::decay_t<T>;
+
+	void reset() {}
+	template<class T, class next_t>
+	void push(T&& in, next_t&& next)
+	{
+		if (pred(static_cast<const T&>(in)))
+			next(std::forward<T>(in));
+	}
+	predicate pred;
+};
+
+/**
+ * \brief stage of a pipeline, which combines elements with elements of zip_with.
+ *
+ * Elements are paired by their position in the stage,
+ * like in actions::zip connected at the same position of a chain.
+ */
+template<class binop, class param_range>
+struct zip_stage
+{
+	template<class T>
+	using result_t = std::decay_t<std::result_of_t<
+			binop&(T, const typename param_range::value_type&)>>;
+
+	void reset() { position = 0; }
+	template<class T, class next_t>
+	void push(T&& in, next_t&& next)
+	{
+		assert(position < static_cast<size_t>(zip_with.size()));
+		next(op(std::forward<T>(in), zip_with[position++]));
+	}
+	binop op;
+	param_range zip_with;
+	size_t position = 0;
+};
+
+namespace detail
+{
+template<class T, class... stages>
+struct pipeline_result;
+
+template<class T>
+struct pipeline_result<T>
+{
+	using type = std::decay_t<T>;
+};
+
+template<class T, class stage, class... stages>
+struct pipeline_result<T, stage, stages...>
+{
+	using type = typename pipeline_result<
+			typename stage::template result_t<T>, stages...>::type;
+};
+} // namespace detail
+
+/**
+ * \brief Sequence of stages applied to a range in a single loop.
+ *
+ * Calling the pipeline with a range returns a std::vector of the results.
+ *
+ * \tparam stages map_stage, filter_stage or zip_stage
+ */
+template<class... stages>
+struct pipeline
+{
+	template<class in_range>
+	using result_value_t = typename detail::pipeline_result<
+			decltype(*std::begin(std::declval<in_range&>())), stages...>::type;
+
+	template<class in_range>
+	auto operator()(const in_range& input)
+	{
+		std::vector<result_value_t<const in_range>> result;
+		result.reserve(input.size());
+		for_each(input, [&result](auto&& out)
+				{ result.push_back(std::forward<decltype(out)>(out)); });
+		return result;
+	}
+
+	/// passes all elements of input through the pipeline and calls sink with the results.
+	template<class in_range, class sink_t>
+	void for_each(const in_range& input, sink_t&& sink)
+	{
+		reset(std::index_sequence_for<stages...>{});
+		for (const auto& in : input)
+			push(in, sink, std::integral_constant<size_t, 0>{});
+	}
+
+	std::tuple<stages...> stage_list;
+
+private:
+	template<size_t... I>
+	void reset(std::index_sequence<I...>)
+	{
+		// expands to a call of reset on every stage.
+		(void)std::initializer_list<int>{(std::get<I>(stage_list).reset(), 0)...};
+	}
+
+	template<class T, class sink_t>
+	void push(T&& in, sink_t& sink, std::integral_constant<size_t, sizeof...(stages)>)
+	{
+		sink(std::forward<T>(in));
+	}
+
+	template<class T, class sink_t, size_t I>
+	void push(T&& in, sink_t& sink, std::integral_constant<size_t, I>)
+	{
+		std::get<I>(stage_list).push(std::forward<T>(in), [this, &sink](auto&& next)
+		{
+			this->push(std::forward<decltype(next)>(next), sink,
+					std::integral_constant<size_t, I + 1>{});
+		});
+	}
+};
+
+/**
+ * \brief Pipeline ending in a reduce, which never creates a container.
+ *
+ * This is the result of connecting a pipeline to a reduce_view or lanewise_reduce_view.
+ * Lanes of a lanewise_reduce_view are not used, since a reduction with a single
+ * accumulator can not be vectorized across the stages of the pipeline anyway.
+ */
+template<class pipeline_t, class binop, class T>
+struct reducing_pipeline
+{
+	template<class in_range>
+	T operator()(const in_range& input)
+	{
+		T result = init_value;
+		elements.for_each(input, [this, &result](auto&& out)
+				{ result = op(result, std::forward<decltype(out)>(out)); });
+		return result;
+	}
+
+	pipeline_t elements;
+	binop op;
+	T init_value;
+};
+
+/// Create lazy pipeline which performs higher order function map.
+template<class operation>
+auto map(operation op)
+{
+	return pipeline<map_stage<operation>>{ std::make_tuple(map_stage<operation>{op}) };
+}
+
+/// Create lazy pipeline which performs higher order function filter.
+template<class predicate>
+auto filter(predicate pred)
+{
+	return pipeline<filter_stage<predicate>>{
+			std::make_tuple(filter_stage<predicate>{pred}) };
+}
+
+/**
+ * \brief Create lazy pipeline which zips elements with param.
+ * \param op Binary Operator which is applied pairwise to elements of param and input.
+ * \param param Second Range of Zip. Elements of this are the rhs of op.
+ */
+template<class binop, class param_range>
+auto zip(binop op, param_range param)
+{
+	using stage_t = zip_stage<binop, param_range>;
+	return pipeline<stage_t>{ std::make_tuple(stage_t{op, param}) };
+}
+
+namespace detail
+{
+template<class T>
+struct is_pipeline : std::false_type {};
+template<class... stages>
+struct is_pipeline<pipeline<stages...>> : std::true_type {};
+
+template<class T>
+struct is_reduce : std::false_type {};
+template<class binop, class T>
+struct is_reduce<reduce_view<binop, T>> : std::true_type {};
+template<class binop, class T, size_t lanes>
+struct is_reduce<lanewise_reduce_view<binop, T, lanes>> : std::true_type {};
+} // namespace detail
+
+} // namespace views
+
+namespace detail
+{
+
+/// Connecting two pipelines appends the stages of the sink to the source.
+template<class source_t, class sink_t>
+struct connect_impl<source_t, sink_t, std::enable_if_t<
+		views::detail::is_pipeline<std::decay_t<source_t>>{}
+		&& views::detail::is_pipeline<std::decay_t<sink_t>>{}>>
+{
+	auto operator()(source_t&& source, sink_t&& sink) const
+	{
+		auto stages = std::tuple_cat(std::forward<source_t>(source).stage_list,
+				std::forward<sink_t>(sink).stage_list);
+		return make_pipeline(std::move(stages));
+	}
+
+private:
+	template<class... stages>
+	static auto make_pipeline(std::tuple<stages...>&& stage_list)
+	{
+		return views::pipeline<stages...>{ std::move(stage_list) };
+	}
+};
+
+/// Connecting a pipeline to a reduce folds the results without storing them.
+template<class source_t, class sink_t>
+struct connect_impl<source_t, sink_t, std::enable_if_t<
+		views::detail::is_pipeline<std::decay_t<source_t>>{}
+		&& views::detail::is_reduce<std::decay_t<sink_t>>{}>>
+{
+	auto operator()(source_t&& source, sink_t&& sink) const
+	{
+		using reduce_t = std::decay_t<sink_t>;
+		return views::reducing_pipeline<std::decay_t<source_t>,
+				decltype(reduce_t::op), decltype(reduce_t::init_value)>{
+						std::forward<source_t>(source),
+						std::forward<sink_t>(sink).op,
+						std::forward<sink_t>(sink).init_value};
+	}
+};
+
+} // namespace detail
+
+}  // namespace fc
+
+#endif /* SRC_RANGE_VIEWS_HPP_ */
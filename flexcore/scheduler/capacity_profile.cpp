@@ -0,0 +1,78 @@
+#include <flexcore/scheduler/capacity_profile.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+
+namespace fc
+{
+namespace thread
+{
+
+void capacity_profile::track(const std::string& name, std::function<size_t()> capacity,
+		std::function<void(size_t)> reserve)
+{
+	assert(capacity);
+	assert(reserve);
+	buffers[name] = tracked_buffer{std::move(capacity), std::move(reserve)};
+}
+
+void capacity_profile::untrack(const std::string& name)
+{
+	buffers.erase(name);
+}
+
+void capacity_profile::record()
+{
+	for (const auto& buffer : buffers)
+	{
+		auto& capacity = capacities[buffer.first];
+		capacity = std::max(capacity, buffer.second.capacity());
+	}
+}
+
+void capacity_profile::apply() const
+{
+	for (const auto& buffer : buffers)
+	{
+		const auto capacity = capacities.find(buffer.first);
+		if (capacity != capacities.end() && capacity->second != 0)
+			buffer.second.reserve(capacity->second);
+	}
+}
+
+size_t capacity_profile::recorded(const std::string& name) const
+{
+	const auto capacity = capacities.find(name);
+	return capacity == capacities.end() ? 0 : capacity->second;
+}
+
+void capacity_profile::write(std::ostream& stream) const
+{
+	for (const auto& capacity : capacities)
+		stream << capacity.first << ' ' << capacity.second << '\n';
+}
+
+void capacity_profile::read(std::istream& stream)
+{
+	std::string line;
+	while (std::getline(stream, line))
+	{
+		if (line.empty())
+			continue;
+		// names may contain spaces, the capacity is the last word of the line.
+		const auto separator = line.find_last_of(' ');
+		const auto number = line.substr(separator == std::string::npos ? 0 : separator + 1);
+		if (separator == std::string::npos || number.empty()
+				|| number.find_first_not_of("0123456789") != std::string::npos)
+			throw std::runtime_error("invalid line in capacity profile: " + line);
+		auto& capacity = capacities[line.substr(0, separator)];
+		capacity = std::max(capacity, static_cast<size_t>(std::stoull(number)));
+	}
+}
+
+} // namespace thread
+} // namespace fc
@@ -0,0 +1,72 @@
+#ifndef SRC_SCHEDULER_CAPACITY_PROFILE_HPP_
+#define SRC_SCHEDULER_CAPACITY_PROFILE_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fc
+{
+namespace thread
+{
+
+/**
+ * \brief capacities of buffers recorded in one run and reserved at the start of the next.
+ *
+ * Buffers are tracked by name, any object with capacity() and reserve(size_t) can be tracked,
+ * like event_buffer and list_collector.
+ * record stores the largest capacity seen so far, usually after the application has run
+ * for a while or before it shuts down. The profile is written to a file with write
+ * and read in the next run, apply then reserves the recorded capacities
+ * before cycle_control::warm_up or start, so buffers do not grow in the first cycles.
+ *
+ * Not thread safe, record and apply are called while the buffers are not in use.
+ */
+class capacity_profile
+{
+public:
+	/// tracks a buffer by name. \pre buffer outlives the profile or is untracked before.
+	template<class buffer_t>
+	void track(const std::string& name, buffer_t& buffer)
+	{
+		track(name, [&buffer]() { return buffer.capacity(); },
+				[&buffer](size_t capacity) { buffer.reserve(capacity); });
+	}
+	/// tracks a buffer by the functions to read its capacity and to reserve it.
+	void track(const std::string& name, std::function<size_t()> capacity,
+			std::function<void(size_t)> reserve);
+	/// stops tracking the buffer of name, its recorded capacity is kept.
+	void untrack(const std::string& name);
+
+	/// stores the capacity of every tracked buffer, if larger than the one recorded.
+	void record();
+	/// reserves the recorded capacities of all tracked buffers.
+	void apply() const;
+	/// returns the capacity recorded for name, zero if none is.
+	size_t recorded(const std::string& name) const;
+
+	/// writes the recorded capacities as lines of name and capacity.
+	void write(std::ostream& stream) const;
+	/**
+	 * \brief reads capacities written by write, keeping the larger one for known names.
+	 * \throws std::runtime_error if a line does not end with a capacity.
+	 */
+	void read(std::istream& stream);
+
+private:
+	struct tracked_buffer
+	{
+		std::function<size_t()> capacity;
+		std::function<void(size_t)> reserve;
+	};
+	std::map<std::string, tracked_buffer> buffers;
+	std::map<std::string, size_t> capacities;
+};
+
+} // namespace thread
+} // namespace fc
+
+#endif /* SRC_SCHEDULER_CAPACITY_PROFILE_HPP_ */
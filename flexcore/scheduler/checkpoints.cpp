@@ -0,0 +1,85 @@
+#include <flexcore/scheduler/checkpoints.hpp>
+
+#include <cassert>
+
+namespace fc
+{
+
+void checkpoint_handle::mark_changed() noexcept
+{
+	if (checkpoints)
+		checkpoints->mark_changed(id);
+}
+
+void checkpoint_handle::reset()
+{
+	if (checkpoints)
+		checkpoints->remove(id);
+	checkpoints.reset();
+}
+
+region_checkpoints::region_checkpoints(std::shared_ptr<checkpoint_file> file)
+	: file_(std::move(file))
+{
+	assert(file_);
+}
+
+checkpoint_handle region_checkpoints::add(std::string key, serialize_t serialize, restore_t restore)
+{
+	assert(serialize);
+	assert(restore);
+	const auto entry = file_->find(key);
+	if (entry != checkpoint_file::npos)
+	{
+		const auto bytes = file_->read(entry);
+		if (!bytes.empty())
+			restore(bytes);
+	}
+
+	size_t id = states.size();
+	if (!free_ids.empty())
+	{
+		id = free_ids.back();
+		free_ids.pop_back();
+	}
+	else
+	{
+		states.emplace_back();
+		changed.push_back(false);
+	}
+	states[id] = state{std::move(key), std::move(serialize), entry};
+	++nr_of_states;
+	dirty.reserve(states.size());
+	auto handle = checkpoint_handle{shared_from_this(), id};
+	// a state which is not in the file yet is written with the next checkpoint.
+	if (entry == checkpoint_file::npos)
+		mark_changed(id);
+	return handle;
+}
+
+void region_checkpoints::operator()()
+{
+	for (const auto id : dirty)
+	{
+		changed[id] = false;
+		auto& s = states[id];
+		if (!s.serialize)
+			continue;
+		const auto bytes = s.serialize();
+		if (s.entry == checkpoint_file::npos)
+			s.entry = file_->entry(s.key, 2 * bytes.size);
+		s.entry = file_->write(s.entry, bytes);
+	}
+	dirty.clear();
+}
+
+void region_checkpoints::remove(size_t id)
+{
+	assert(id < states.size() && states[id].serialize);
+	// a pending write of the state is skipped, as it has no serialize.
+	states[id] = state{};
+	free_ids.push_back(id);
+	--nr_of_states;
+}
+
+} // namespace fc
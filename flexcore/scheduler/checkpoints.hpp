@@ -0,0 +1,206 @@
+#ifndef SRC_SCHEDULER_CHECKPOINTS_HPP_
+#define SRC_SCHEDULER_CHECKPOINTS_HPP_
+
+#include <flexcore/utils/serialisation/byte_span.hpp>
+#include <flexcore/utils/serialisation/checkpoint_file.hpp>
+#include <flexcore/utils/serialisation/deserializer.hpp>
+#include <flexcore/utils/serialisation/serializer.hpp>
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace fc
+{
+
+class region_checkpoints;
+
+/// marks its state as changed, removes it from region_checkpoints on destruction.
+class checkpoint_handle
+{
+public:
+	checkpoint_handle() = default;
+	checkpoint_handle(std::shared_ptr<region_checkpoints> checkpoints, size_t id)
+		: checkpoints(std::move(checkpoints)), id(id)
+	{
+	}
+	checkpoint_handle(checkpoint_handle&& other) noexcept { swap(other); }
+	checkpoint_handle& operator=(checkpoint_handle&& other) noexcept
+	{
+		reset();
+		swap(other);
+		return *this;
+	}
+	~checkpoint_handle() { reset(); }
+
+	/// lets the state be written with the next checkpoint, does nothing for empty handles.
+	void mark_changed() noexcept;
+	/// removes the state now, the checkpoint file keeps what has been written.
+	void reset();
+
+private:
+	void swap(checkpoint_handle& other) noexcept
+	{
+		std::swap(checkpoints, other.checkpoints);
+		std::swap(id, other.id);
+	}
+
+	std::shared_ptr<region_checkpoints> checkpoints;
+	size_t id = 0;
+};
+
+/**
+ * \brief States of the nodes of a parallel_region, which are written to a checkpoint_file.
+ *
+ * Nodes add their state with functions to serialize and to restore it
+ * and mark it as changed when it changes.
+ * On the switch tick of the region only the changed states are serialized and written,
+ * while the nodes of the region do not run. The file keeps the last state of every node
+ * written, a state added under a key already in the file is restored from it right away.
+ * Thus a restarted process continues with the states of the last cycle before it stopped.
+ *
+ * States are written one by one, after a crash during a switch tick
+ * some states may be from the cycle before the others.
+ * States must not be added or removed while the region runs, see parallel_region::checkpoints.
+ */
+class region_checkpoints : public std::enable_shared_from_this<region_checkpoints>
+{
+public:
+	/// returns the bytes of the state, which need to be valid until the next call.
+	using serialize_t = std::function<const_byte_span()>;
+	/// sets the state from bytes written by serialize_t.
+	using restore_t = std::function<void(const_byte_span)>;
+
+	/// \pre file != nullptr
+	explicit region_checkpoints(std::shared_ptr<checkpoint_file> file);
+
+	/**
+	 * \brief adds the state of key, restores it from the file, if the file has it.
+	 * \returns handle, which marks the state as changed and removes it on destruction.
+	 * \throws what restore throws for bytes it cannot restore from.
+	 */
+	checkpoint_handle add(std::string key, serialize_t serialize, restore_t restore);
+
+	/// writes the states changed since the last call, connected to the switch tick.
+	void operator()();
+
+	/// number of states added.
+	size_t size() const noexcept { return nr_of_states; }
+	checkpoint_file& file() const noexcept { return *file_; }
+
+private:
+	friend class checkpoint_handle;
+	void mark_changed(size_t id) noexcept
+	{
+		if (changed[id])
+			return;
+		changed[id] = true;
+		// capacity has been reserved for every state, thus this does not allocate.
+		dirty.push_back(id);
+	}
+	void remove(size_t id);
+
+	struct state
+	{
+		std::string key;
+		serialize_t serialize;
+		size_t entry = checkpoint_file::npos;
+	};
+
+	std::shared_ptr<checkpoint_file> file_;
+	/// states by id, removed states have no serialize.
+	std::vector<state> states;
+	std::vector<char> changed;
+	std::vector<size_t> dirty;
+	std::vector<size_t> free_ids;
+	size_t nr_of_states = 0;
+};
+
+namespace detail
+{
+/**
+ * \brief serializes states for region_checkpoints with archive_t.
+ *
+ * Uses buffered_serializer and span_deserializer,
+ * vectors of trivially copyable elements are copied bytewise with fixed_layout.
+ */
+template<class data_t, class archive_t>
+struct checkpoint_codec
+{
+	const_byte_span serialize(const data_t& state) { return serializer(state); }
+	data_t restore(const_byte_span bytes) { return span_deserializer<data_t, archive_t>{}(bytes); }
+
+	buffered_serializer<data_t, archive_t> serializer;
+};
+
+template<class T>
+struct checkpoint_codec<std::vector<T>, fixed_layout>
+{
+	static_assert(std::is_trivially_copyable<T>{},
+			"fixed_layout serialization copies objects bytewise.");
+
+	const_byte_span serialize(const std::vector<T>& state) noexcept
+	{
+		return const_byte_span{reinterpret_cast<const char*>(state.data()),
+				state.size() * sizeof(T)};
+	}
+
+	/// \throws std::invalid_argument if bytes are no multiple of the size of T.
+	std::vector<T> restore(const_byte_span bytes)
+	{
+		if (bytes.size % sizeof(T) != 0)
+			throw std::invalid_argument("size of serialized object does not match its type");
+		std::vector<T> result(bytes.size / sizeof(T));
+		std::memcpy(result.data(), bytes.data, bytes.size);
+		return result;
+	}
+};
+} // namespace detail
+
+/**
+ * \brief adds state to checkpoints under key, serialized by archive_t.
+ *
+ * state needs to outlive the returned handle. The handle needs to be marked,
+ * whenever state has changed.
+ * \tparam archive_t archive serializing data_t, fixed_layout or a Cereal binary archive.
+ */
+template<class archive_t, class data_t>
+checkpoint_handle add_checkpoint(region_checkpoints& checkpoints, std::string key, data_t& state)
+{
+	auto codec = std::make_shared<detail::checkpoint_codec<data_t, archive_t>>();
+	return checkpoints.add(std::move(key),
+			[codec, &state]() { return codec->serialize(state); },
+			[codec, &state](const_byte_span bytes) { state = codec->restore(bytes); });
+}
+
+namespace detail
+{
+/// adds the state of node to the checkpoints of its region, under the full name of node by default.
+template<class node_t>
+checkpoint_handle checkpoint_node(node_t& node, std::string key,
+		region_checkpoints::serialize_t serialize, region_checkpoints::restore_t restore)
+{
+	auto* checkpoints = node.region()->checkpoints();
+	if (!checkpoints)
+		return {};
+	return checkpoints->add(key.empty() ? node.full_name() : std::move(key),
+			std::move(serialize), std::move(restore));
+}
+
+template<class archive_t, class node_t, class data_t>
+checkpoint_handle checkpoint_node(node_t& node, std::string key, data_t& state)
+{
+	auto* checkpoints = node.region()->checkpoints();
+	if (!checkpoints)
+		return {};
+	return add_checkpoint<archive_t>(*checkpoints,
+			key.empty() ? node.full_name() : std::move(key), state);
+}
+} // namespace detail
+
+} // namespace fc
+
+#endif /* SRC_SCHEDULER_CHECKPOINTS_HPP_ */
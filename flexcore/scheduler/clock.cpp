@@ -12,18 +12,15 @@ namespace fc
 
 namespace chr = std::chrono;
 
-std::atomic<virtual_clock::system::time_point>
-		virtual_clock::system::current_time{(
-				virtual_clock::system::time_point(
-						virtual_clock::system::duration::zero()))};
-std::atomic<virtual_clock::steady::time_point>
-		virtual_clock::steady::current_time{(
-				virtual_clock::steady::time_point(
-						virtual_clock::steady::duration::zero()))};
+const std::shared_ptr<clock_domain>& clock_domain::global()
+{
+	static const std::shared_ptr<clock_domain> domain = std::make_shared<clock_domain>();
+	return domain;
+}
 
 virtual_clock::system::time_point virtual_clock::system::now() noexcept
 {
-	return current_time.load();
+	return clock_domain::global()->system_now();
 }
 
 std::time_t virtual_clock::system::to_time_t(const time_point& t)
@@ -41,26 +38,9 @@ virtual_clock::system::time_point virtual_clock::system::from_time_t(std::time_t
 	return chr::time_point_cast<virtual_clock::duration>(tmp);
 }
 
-void virtual_clock::system::advance(duration d) noexcept
-{
-	const auto tmp = current_time.load();
-	current_time.store(tmp + d);
-}
-
-void virtual_clock::system::set_time(time_point r) noexcept
-{
-	current_time.store(r);
-}
-
 virtual_clock::steady::time_point virtual_clock::steady::now() noexcept
 {
-	return current_time.load();
-}
-
-void virtual_clock::steady::advance(duration d) noexcept
-{
-	const auto tmp = current_time.load();
-	current_time.store(tmp + d);
+	return clock_domain::global()->steady_now();
 }
 
 }  //namespace fc
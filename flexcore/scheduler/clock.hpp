@@ -10,13 +10,11 @@
 
 #include <atomic>
 #include <chrono>
+#include <memory>
 
 namespace fc
 {
 
-//forward declaration for friend declartations in virtual_clock
-template<class T> class master_clock;
-
 /**
  * \brief  Wall clock for measurements of system time.
  * Timings in Solutions should pretty much always use virtual clock.
@@ -72,15 +70,6 @@ struct virtual_clock
 		static time_point now() noexcept;
 		static std::time_t to_time_t( const time_point& t );
 		static time_point from_time_t( std::time_t t );
-
-		template<class T>
-		friend class master_clock;
-	private:
-
-		static void advance(duration d) noexcept;
-		static void set_time(time_point r) noexcept;
-
-		static std::atomic<time_point> current_time;
 	};
 
 	/**
@@ -101,17 +90,70 @@ struct virtual_clock
 		 * \brief returns current relative simulation time
 		 * \return A time point representing the current virtual time.
 		 * \post if now is called twice with results t1 and t2, t2 >= t1 holds.
+		 *
+		 * Cheap to call, but all threads read the same atomic.
+		 * Code running in a region can use parallel_region::cycle_time instead.
+		 * Returns the time of the global clock_domain.
 		 */
 		static time_point now() noexcept;
+	};
+};
 
-	private:
-		template<class T>
-		friend class master_clock;
+/**
+ * \brief time of a single simulation, read through virtual_clock or the region of a node.
+ *
+ * virtual_clock and master_clock use the global domain. A cycle_control given its
+ * own domain advances that instead, so several simulations run in one process
+ * independently, each at its own speed. Nodes reach the domain of their region
+ * through parallel_region::clock.
+ *
+ * Only a single thread, usually the main loop of cycle_control, advances a domain,
+ * any thread can read it.
+ */
+class clock_domain
+{
+public:
+	clock_domain() = default;
+	clock_domain(const clock_domain&) = delete;
+	clock_domain& operator=(const clock_domain&) = delete;
 
-		static void advance(duration d) noexcept;
+	/// current relative simulation time, see virtual_clock::steady::now
+	virtual_clock::steady::time_point steady_now() const noexcept
+	{
+		return steady_time.load(std::memory_order_acquire);
+	}
+	/// current absolute simulation time, see virtual_clock::system::now
+	virtual_clock::system::time_point system_now() const noexcept
+	{
+		return system_time.load(std::memory_order_acquire);
+	}
 
-		static std::atomic<time_point> current_time;
-	};
+	/**
+	 * \brief advances both clocks of the domain by d.
+	 * \pre d >= 0
+	 */
+	void advance(virtual_clock::duration d) noexcept
+	{
+		// there is a single writer, so there is no need for a read-modify-write.
+		steady_time.store(steady_time.load(std::memory_order_relaxed) + d,
+				std::memory_order_release);
+		system_time.store(system_time.load(std::memory_order_relaxed) + d,
+				std::memory_order_release);
+	}
+	/// sets the absolute time, the steady clock is left alone, as it has only relative timings.
+	void set_time(virtual_clock::system::time_point r) noexcept
+	{
+		system_time.store(r, std::memory_order_release);
+	}
+
+	/// domain of virtual_clock, used by everything not given a domain of its own.
+	static const std::shared_ptr<clock_domain>& global();
+
+private:
+	std::atomic<virtual_clock::steady::time_point> steady_time{
+			virtual_clock::steady::time_point(virtual_clock::duration::zero())};
+	std::atomic<virtual_clock::system::time_point> system_time{
+			virtual_clock::system::time_point(virtual_clock::duration::zero())};
 };
 
 /**
@@ -135,22 +177,22 @@ public:
 	 */
 	static void advance() noexcept
 	{
-		steady_clock.advance(
-				std::chrono::duration_cast<virtual_clock::steady::duration>
-				(duration(1)));
-		system_clock.advance(
-				std::chrono::duration_cast<virtual_clock::system::duration>
-				(duration(1)));
+		advance(std::chrono::duration_cast<virtual_clock::steady::duration>(duration(1)));
+	}
+	/**
+	 * \brief advances clock by an arbitrary duration
+	 *
+	 * Used by schedulers with a tick length different to a single period of the clock.
+	 * \pre d >= 0
+	 */
+	static void advance(virtual_clock::steady::duration d) noexcept
+	{
+		clock_domain::global()->advance(d);
 	}
 	static void set_time(virtual_clock::system::time_point r) noexcept
 	{
-		system_clock.set_time(r);
-		//do not set time of steady clock, as it has only relative timings.
+		clock_domain::global()->set_time(r);
 	}
-
-private:
-	static virtual_clock::steady steady_clock;
-	static virtual_clock::system system_clock;
 };
 
 }  //namespace fc
@@ -1,14 +1,48 @@
 #include <flexcore/scheduler/cyclecontrol.hpp>
+#include <flexcore/utils/logging/logger.hpp>
 
 #include <algorithm>
+#include <cerrno>
+#include <future>
+#include <iterator>
+#include <limits>
 #include <stdexcept>
 
+#include <time.h>
+
 namespace fc
 {
 namespace thread
 {
 
-using clock = master_clock<std::centi>;
+
+namespace
+{
+/**
+ * \brief sorts tasks by descending priority, keeps the order of tasks with equal priority.
+ *
+ * Insertion sort, as batches are small, mostly sorted and std::stable_sort allocates memory.
+ */
+void sort_by_priority(std::vector<scheduler::affine_task>& tasks)
+{
+	for (size_t i = 1; i < tasks.size(); ++i)
+	{
+		if (tasks[i - 1].priority >= tasks[i].priority)
+			continue;
+		auto current = std::move(tasks[i]);
+		size_t j = i;
+		for (; j != 0 && tasks[j - 1].priority < current.priority; --j)
+			tasks[j] = std::move(tasks[j - 1]);
+		tasks[j] = std::move(current);
+	}
+}
+
+template<class bucket_t>
+bool is_idle(const bucket_t& bucket)
+{
+	return bucket.completion->busy.load() == 0;
+}
+}
 constexpr wall_clock::steady::duration cycle_control::min_tick_length;
 constexpr virtual_clock::steady::duration cycle_control::fast_tick;
 constexpr virtual_clock::steady::duration cycle_control::medium_tick;
@@ -23,22 +57,103 @@ cycle_control::cycle_control(std::unique_ptr<scheduler> scheduler,
 			loop
 	)
 {
+	default_timeout_handler = true;
 }
 
 void cycle_control::start()
 {
 	assert(!running);
+	// which tasks may fall behind is needed before the first cycle.
+	// buffers connected since the tasks were added tie their regions as well.
+	resolve_dependencies();
+	update_buffer_elision();
+	if (main_config.lock_memory)
+		lock_process_memory();
 	keep_working.store(true);
 	running = true;
+	// the main loop runs in a thread of its own from now on.
+	trace_thread_named = false;
 	//set the start time of the cycle to now.
 	// give the main thread some actual work to do (execute infinite main loop)
+	std::promise<void> configured;
 	main_loop_thread = std::thread{
-		[&, this](){
+		[&, this, ready = configured.get_future()]() mutable {
+			// the first cycle already runs pinned and with its priority.
+			try
+			{
+				ready.get();
+			}
+			catch (...)
+			{
+				return;
+			}
+			prefault_stack(main_config.prefault_stack);
 			main_loop_->arm();
 			while(keep_working.load())
 				main_loop_->loop_body([this](){ work(); });
 		}
 	};
+	try
+	{
+		apply_thread_config(main_loop_thread, main_config, 0);
+	}
+	catch (...)
+	{
+		// the thread returns without running a cycle.
+		configured.set_exception(std::current_exception());
+		stop();
+		throw;
+	}
+	configured.set_value();
+}
+
+void cycle_control::run_cycles(size_t cycles)
+{
+	assert(!running);
+	resolve_dependencies();
+	update_buffer_elision();
+	keep_working.store(true);
+	{
+		std::lock_guard<std::mutex> lock(changes_mutex);
+		running = true;
+	}
+	trace_thread_named = false;
+	main_loop_->arm();
+	for (size_t i = 0; i != cycles && keep_working.load(); ++i)
+		main_loop_->loop_body([this](){ work(); });
+	stop();
+}
+
+void cycle_control::warm_up(size_t cycles)
+{
+	if (running)
+		throw std::runtime_error{"Worker threads are already running"};
+	resolve_dependencies();
+	update_buffer_elision();
+	{
+		std::lock_guard<std::mutex> lock(changes_mutex);
+		running = true;
+	}
+	trace_thread_named = false;
+	// waiting for all tasks before every cycle leaves no task behind its deadline.
+	for (size_t i = 0; i != cycles; ++i)
+	{
+		wait_for_all_tasks();
+		work();
+	}
+	wait_for_all_tasks();
+	{
+		std::lock_guard<std::mutex> lock(changes_mutex);
+		running = false;
+	}
+	if (changes_pending.load())
+		apply_task_changes(true);
+
+	std::lock_guard<std::mutex> lock(tasks_mutex);
+	for (auto& task_vector : tasks_by_rate)
+		for (auto& task : task_vector.tasks)
+			task.reset_statistics();
+	main_loop_->overrun.reset();
 }
 
 void cycle_control::stop()
@@ -47,24 +162,33 @@ void cycle_control::stop()
 	if (main_loop_thread.joinable())
 		main_loop_thread.join();
 	// wait for scheduled tasks to finish
-	auto wait_or_throw = [this](auto& task_vector)
+	for (auto& task_vector : tasks_by_rate)
 	{
+		const auto timeout = std::max(task_vector.tick, slow_tick);
 		for (auto& t : task_vector.tasks)
-			if (!t.wait_until_done(slow_tick))
+			if (!t.wait_until_done(timeout))
 				timeout_callback(t);
-	};
-	wait_or_throw(tasks_fast);
-	wait_or_throw(tasks_medium);
-	wait_or_throw(tasks_slow);
-	running = false;
+	}
+	{
+		std::lock_guard<std::mutex> lock(changes_mutex);
+		running = false;
+	}
+	// changes made after the last cycle are applied right away.
+	if (changes_pending.load())
+		apply_task_changes(true);
 	//check post condition
 	assert(!keep_working.load());
 	assert(!running);
 }
 
-bool cycle_control::store_exception(periodic_task&)
+bool cycle_control::store_exception(periodic_task& task)
 {
-	const auto ep = std::make_exception_ptr(out_of_time_exception());
+	const auto report = report_overrun(task);
+	log_client{"cycle_control"}.write([&report]{ return to_string(report); }, level::error);
+	const auto ep = std::make_exception_ptr(out_of_time_exception(
+			"\"" + report.task.name + "\" late by " + std::to_string(
+					std::chrono::duration_cast<std::chrono::microseconds>(
+							report.task.late_by).count()) + "us"));
 	std::lock_guard<std::mutex> lock(task_exception_mutex);
 	task_exceptions.push_back(ep);
 	return false;
@@ -72,42 +196,108 @@ bool cycle_control::store_exception(periodic_task&)
 
 void cycle_control::work()
 {
-	auto now = virtual_clock::steady::now().time_since_epoch();
-	auto run_if_due = [this, now](auto& task_vector)
+	if (trace)
 	{
-		if (now % task_vector.tick == virtual_clock::duration::zero())
-			if (!run_periodic_tasks(task_vector))
-				return false;
-		return true;
-	};
-	clock::advance();
-	if (!run_if_due(tasks_fast)) return;
-	if (!run_if_due(tasks_medium)) return;
-	if (!run_if_due(tasks_slow)) return;
+		if (!trace_thread_named)
+		{
+			trace->name_this_thread("main loop");
+			trace_thread_named = true;
+		}
+		trace->begin(trace_cycle);
+	}
+	// busy buckets are changed in a later cycle, the main loop never waits for them.
+	if (changes_pending.load())
+		apply_task_changes(false);
+	if (next_step != pending_step::none && try_step(next_step == pending_step::down))
+	{
+		next_step = pending_step::none;
+		overrun_streak = 0;
+		headroom_streak = 0;
+	}
+	if (dependencies_changed)
+		resolve_dependencies();
+	const auto cycle = current_cycle();
+	clock_->advance(tick_length);
+	// tasks of all rates are collected in batch, fastest rate first,
+	// which is the order of their deadlines.
+	assert(batch.empty());
+	cycle_overran = false;
+	for (auto& task_vector : tasks_by_rate)
+	{
+		if (cycle % task_vector.cycles == 0 && !run_periodic_tasks(task_vector))
+			break;
+	}
+	if (throttling)
+		update_throttling(cycle_overran);
+	sort_by_priority(batch);
+	scheduler_->add_tasks(batch);
+	if (trace)
+		trace->end(trace_cycle);
 }
 
 void cycle_control::wait_for_current_tasks()
 {
-	auto now = virtual_clock::steady::now().time_since_epoch();
-	auto wait_for_tasks = [this, now](auto& task_vector)
+	if (trace)
+		trace->begin(trace_wait);
+	wait_for_tasks_of_cycle();
+	if (trace)
+		trace->end(trace_wait);
+}
+
+void cycle_control::wait_for_tasks_of_cycle()
+{
+	const auto cycle = current_cycle();
+	const size_t cycles_ahead = main_loop_->max_cycles_ahead();
+	// slowest tasks first, as they are the most likely to be still running.
+	for (auto it = tasks_by_rate.rbegin(); it != tasks_by_rate.rend(); ++it)
 	{
-		if (now % task_vector.tick == virtual_clock::duration::zero())
+		if (cycle % it->cycles != 0)
+			continue;
+		// usually all tasks are done in time, a single wait then wakes the main loop once.
+		// tasks which ran before the cycle or may fall behind are waited for one by one.
+		if (it->single_wait && it->completion->wait_until_done(it->started + it->tick))
+			continue;
+		for (size_t i = 0; i != it->tasks.size(); ++i)
 		{
-			for (auto& task : task_vector.tasks)
-				if (!task.wait_until_done(task_vector.tick))
+			auto& task = it->tasks[i];
+			if (cycles_ahead != 0 && it->independent[i])
+			{
+				// falling behind is expected, only the limit needs to be enforced.
+				while (!task.wait_until_cycles_to_do(cycles_ahead, it->tick))
+					if (!keep_working.load())
+						return;
+				continue;
+			}
+			if (!task.wait_until_done(it->tick) && !task.skips_on_overrun())
+			{
+				if (!timeout_callback(task))
 				{
-					if (!timeout_callback(task))
-					{
-						keep_working.store(false);
-						return false;
-					}
+					keep_working.store(false);
+					return;
 				}
+			}
 		}
-		return true;
-	};
-	if (!wait_for_tasks(tasks_slow)) return;
-	if (!wait_for_tasks(tasks_medium)) return;
-	if (!wait_for_tasks(tasks_fast)) return;
+	}
+}
+
+void cycle_control::wait_for_all_tasks()
+{
+	for (auto& task_vector : tasks_by_rate)
+		wait_until_idle(task_vector);
+}
+
+void cycle_control::skip_idle_cycles()
+{
+	if (tasks_by_rate.empty())
+		return;
+	const auto cycle = current_cycle();
+	size_t idle_cycles = std::numeric_limits<size_t>::max();
+	for (const auto& task_vector : tasks_by_rate)
+	{
+		const size_t remainder = cycle % task_vector.cycles;
+		idle_cycles = std::min(idle_cycles, remainder == 0 ? 0 : task_vector.cycles - remainder);
+	}
+	clock_->advance(tick_length * static_cast<wall_clock::steady::duration::rep>(idle_cycles));
 }
 
 cycle_control::~cycle_control()
@@ -119,50 +309,703 @@ cycle_control::~cycle_control()
 bool cycle_control::run_periodic_tasks(tick_task_pair& tasks)
 {
 	assert(tasks.done_tasks.empty());
-	for (auto& task : tasks.tasks)
+	const bool pipelined = main_loop_->max_cycles_ahead() != 0;
+	// usually all tasks are done, then their state is not looked at.
+	const bool all_done = tasks.completion->busy.load() == 0;
+	bool suspension_changed = false;
+	for (size_t i = 0; i != tasks.tasks.size(); ++i)
 	{
-		if (!task.done())
+		auto& task = tasks.tasks[i];
+		// tasks running ahead are left out of done_tasks, a task graph sees them as skipped,
+		// which doesn't matter as they have neither predecessors nor successors.
+		if (pipelined && tasks.independent[i])
 		{
+			if (!task.done() || !task.update_suspension())
+				run_ahead(task);
+			continue;
+		}
+		if (!all_done && !task.done())
+		{
+			if (task.skips_on_overrun())
+			{
+				task.skip_cycle();
+				continue;
+			}
+			// best effort tasks above may overrun, the others mean the system is overloaded.
+			if (throttling_absorbs_overrun())
+			{
+				cycle_overran = true;
+				task.skip_cycle();
+				continue;
+			}
 			if (!timeout_callback(task))
 			{
 				keep_working.store(false);
+				tasks.done_tasks.clear();
 				return false;
 			}
 			if (!task.done())
 				continue;
 		}
-		tasks.done_tasks.emplace_back(task);
+		// suspended tasks get neither switch nor work tick, so their buffers stay untouched.
+		const bool was_suspended = task.suspended();
+		const bool suspended = task.update_suspension();
+		suspension_changed = suspension_changed || suspended != was_suspended;
+		if (suspended)
+			continue;
+		tasks.done_tasks.push_back(i);
 	}
 
-	for (auto& task_ref : tasks.done_tasks)
+	// elided regions are never running here, so their connections can change in between cycles.
+	if (suspension_changed && elide_buffers)
+		update_buffer_elision(tasks);
+
+	for (auto i : tasks.done_tasks)
 	{
-		periodic_task& task = task_ref.get();
+		periodic_task& task = tasks.tasks[i];
 		assert(task.done());
 		task.set_work_to_do(true);
-		task.send_switch_tick();
 	}
-	for (auto& task_ref : tasks.done_tasks)
+	tasks.started = wall_clock::steady::now();
+	// completion counts all tasks of the bucket, tasks running ahead, still running
+	// from earlier cycles or suspended are waited for one by one instead.
+	tasks.single_wait = tasks.done_tasks.size() == tasks.tasks.size();
+	if (tasks.graph)
+	{
+		run_task_graph(tasks);
+		tasks.done_tasks.clear();
+		return true;
+	}
+
+	for (auto i : tasks.done_tasks)
+		tasks.tasks[i].send_switch_tick();
+	for (auto i : tasks.done_tasks)
 	{
-		periodic_task& task = task_ref.get();
-		scheduler_->add_task([&task] { task(); });
+		periodic_task& task = tasks.tasks[i];
+		batch.push_back({[&task] { task(); }, task.worker_affinity(), task.priority()});
 	}
 	tasks.done_tasks.clear();
 	return true;
 }
 
-void cycle_control::add_task(periodic_task task, virtual_clock::duration tick_rate)
+void cycle_control::run_ahead(periodic_task& task)
+{
+	if (!task.add_cycle())
+		return;
+	task.send_switch_tick();
+	batch.push_back({[&task]
+			{
+				do
+					task.run();
+				while (task.finish_cycle());
+			},
+			task.worker_affinity(), task.priority()});
+}
+
+void cycle_control::run_task_graph(tick_task_pair& tasks)
+{
+	auto& graph = *tasks.graph;
+	const uint32_t generation = ++graph.generation;
+	const auto reset = [&graph, generation](size_t i)
+	{
+		graph.pending_predecessors[i].store(
+				(uint64_t{generation} << 32) | graph.nr_of_predecessors[i]);
+	};
+	// tasks not done are still waiting or running from an earlier cycle and stay untouched.
+	// Tasks of done_tasks are not done either, as they already have work to do.
+	for (size_t i = 0; i != tasks.tasks.size(); ++i)
+		if (tasks.tasks[i].done())
+			reset(i);
+	for (auto i : tasks.done_tasks)
+	{
+		reset(i);
+		graph.scheduled[i].store(generation);
+	}
+
+	// the buffers of all regions are switched before any region works, as without graph.
+	// Switching them later would race with regions working on the other side of a buffer.
+	for (auto i : tasks.done_tasks)
+		tasks.tasks[i].send_switch_tick();
+
+	// tasks skipped this cycle must not hold back their successors.
+	for (size_t i = 0; i != tasks.tasks.size(); ++i)
+		if (graph.scheduled[i].load() != generation)
+			release_successors(tasks, i, generation);
+
+	for (auto i : tasks.done_tasks)
+	{
+		if (graph.nr_of_predecessors[i] != 0)
+			continue;
+		periodic_task& task = tasks.tasks[i];
+		batch.push_back({graph_job(tasks, i, generation), task.worker_affinity(),
+				task.priority()});
+	}
+}
+
+void cycle_control::dispatch(tick_task_pair& tasks, size_t index, uint32_t generation)
+{
+	periodic_task& task = tasks.tasks[index];
+	scheduler_->add_affine_task(graph_job(tasks, index, generation), task.worker_affinity());
+}
+
+scheduler::task_t cycle_control::graph_job(tick_task_pair& tasks, size_t index, uint32_t generation)
+{
+	// successors are released before the task is marked done,
+	// so the task is never seen as done while it still accesses the graph.
+	return [this, &tasks, index, generation]
+	{
+		tasks.tasks[index].run();
+		release_successors(tasks, index, generation);
+		tasks.tasks[index].set_work_to_do(false);
+	};
+}
+
+void cycle_control::release_successors(tick_task_pair& tasks, size_t index, uint32_t generation)
+{
+	auto& graph = *tasks.graph;
+	for (auto successor : graph.successors[index])
+	{
+		auto& pending = graph.pending_predecessors[successor];
+		auto expected = pending.load();
+		// only count down if the counter belongs to the same cycle as the finished task.
+		bool same_cycle = true;
+		do
+		{
+			same_cycle = (expected >> 32) == generation;
+			if (!same_cycle)
+				break;
+			assert((expected & 0xFFFFFFFF) != 0);
+		} while (!pending.compare_exchange_weak(expected, expected - 1));
+
+		if (same_cycle && (expected & 0xFFFFFFFF) == 1
+				&& graph.scheduled[successor].load() == generation)
+			dispatch(tasks, successor, generation);
+	}
+}
+
+void cycle_control::add_dependency(
+		const parallel_region& predecessor, const parallel_region& successor)
 {
 	if (running)
 		throw std::runtime_error{"Worker threads are already running"};
+	if (&predecessor == &successor)
+		throw std::invalid_argument{"Region cannot depend on itself"};
 
-	if (tick_rate == slow_tick)
-		tasks_slow.tasks.emplace_back(std::move(task));
-	else if (tick_rate == medium_tick)
-		tasks_medium.tasks.emplace_back(std::move(task));
-	else if (tick_rate == fast_tick)
-		tasks_fast.tasks.emplace_back(std::move(task));
+	// depth first search for a path from successor back to predecessor.
+	std::vector<const parallel_region*> to_visit{&successor};
+	std::vector<const parallel_region*> visited;
+	while (!to_visit.empty())
+	{
+		const auto current = to_visit.back();
+		to_visit.pop_back();
+		if (current == &predecessor)
+			throw std::invalid_argument{"Dependency between regions would create a cycle"};
+		if (std::find(visited.begin(), visited.end(), current) != visited.end())
+			continue;
+		visited.push_back(current);
+		for (const auto& dependency : dependencies)
+			if (dependency.first == current)
+				to_visit.push_back(dependency.second);
+	}
+
+	const auto dependency = std::make_pair(&predecessor, &successor);
+	if (std::find(dependencies.begin(), dependencies.end(), dependency) == dependencies.end())
+		dependencies.push_back(dependency);
+	dependencies_changed = true;
+}
+
+void cycle_control::resolve_dependencies()
+{
+	for (auto& bucket : tasks_by_rate)
+		resolve_dependencies(bucket);
+	dependencies_changed = false;
+}
+
+void cycle_control::resolve_dependencies(tick_task_pair& bucket)
+{
+	auto index_of = [&bucket](const parallel_region* region)
+	{
+		const auto it = std::find_if(bucket.tasks.begin(), bucket.tasks.end(),
+				[region](const periodic_task& t) { return t.get_region() == region; });
+		return static_cast<size_t>(it - bucket.tasks.begin());
+	};
+
+	const size_t nr_of_tasks = bucket.tasks.size();
+	auto graph = std::make_unique<task_graph>();
+	graph->successors.resize(nr_of_tasks);
+	graph->nr_of_predecessors.resize(nr_of_tasks, 0);
+	bool has_edges = false;
+	for (const auto& dependency : dependencies)
+	{
+		const size_t before = index_of(dependency.first);
+		const size_t after = index_of(dependency.second);
+		// dependencies between tick rates don't affect the order within a cycle.
+		if (before == nr_of_tasks || after == nr_of_tasks)
+			continue;
+		graph->successors[before].push_back(after);
+		++graph->nr_of_predecessors[after];
+		has_edges = true;
+	}
+
+	bucket.independent.assign(nr_of_tasks, 1);
+	for (size_t i = 0; i != nr_of_tasks; ++i)
+	{
+		const auto* region = bucket.tasks[i].get_region();
+		// buffers are switched with the work of both regions, running ahead would
+		// switch them while the other region still reads or writes them.
+		// the active region owns the switches, the passive one knows the elision.
+		if (region && (region->buffer_switches().size() != 0
+				|| !region->buffer_elisions().empty()))
+			bucket.independent[i] = 0;
+		for (const auto& dependency : dependencies)
+			if (dependency.first == region || dependency.second == region)
+				bucket.independent[i] = 0;
+	}
+
+	if (has_edges)
+	{
+		graph->pending_predecessors = std::make_unique<std::atomic<uint64_t>[]>(nr_of_tasks);
+		graph->scheduled = std::make_unique<std::atomic<uint32_t>[]>(nr_of_tasks);
+		bucket.graph = std::move(graph);
+	}
 	else
+		bucket.graph.reset();
+}
+
+void cycle_control::add_task(periodic_task task, virtual_clock::duration tick_rate)
+{
+	// the tick length cannot change while running, so this can be checked right away.
+	if (tick_rate <= virtual_clock::duration::zero() || tick_rate % tick_length != tick_rate.zero())
 		throw std::invalid_argument{"Unsupported tick_rate"};
+	const auto* region = task.get_region();
+	if (region && region->shared_clock() != clock_)
+		throw std::invalid_argument{"region \"" + region->get_id().key
+				+ "\" uses a different clock than cycle_control"};
+
+	{
+		std::lock_guard<std::mutex> lock(changes_mutex);
+		if (running)
+		{
+			added_tasks.emplace_back(std::move(task), tick_rate);
+			changes_pending.store(true);
+			return;
+		}
+	}
+	// not running, so waiting for tasks left over by stop only delays the caller.
+	const auto bucket = std::find_if(tasks_by_rate.begin(), tasks_by_rate.end(),
+			[tick_rate](const tick_task_pair& b) { return b.tick == tick_rate; });
+	if (bucket != tasks_by_rate.end())
+		wait_until_idle(*bucket);
+	insert_task(std::move(task), tick_rate);
+	dependencies_changed = true;
+}
+
+void cycle_control::remove_tasks(const parallel_region& region)
+{
+	{
+		std::lock_guard<std::mutex> lock(changes_mutex);
+		removed_regions.push_back(&region);
+		changes_pending.store(true);
+		if (running)
+			return;
+	}
+	apply_task_changes(true);
+}
+
+cycle_control::tick_task_pair& cycle_control::insert_task(
+		periodic_task task, virtual_clock::duration tick_rate)
+{
+	if (task.worker_affinity() == scheduler::any_worker)
+	{
+		const int numa_node = task.numa_node();
+		task.set_worker_affinity(numa_node == any_numa_node
+				? next_affinity : scheduler_->worker_on_numa_node(numa_node, next_affinity));
+		++next_affinity;
+	}
+
+	auto bucket = std::lower_bound(tasks_by_rate.begin(), tasks_by_rate.end(), tick_rate,
+			[](const tick_task_pair& tasks, virtual_clock::duration tick)
+			{
+				return tasks.tick < tick;
+			});
+	if (bucket == tasks_by_rate.end() || bucket->tick != tick_rate)
+	{
+		const size_t cycles = tick_rate / tick_length;
+		bucket = tasks_by_rate.insert(bucket, tick_task_pair{tick_rate, cycles});
+	}
+	// running tasks refer to the vector of their bucket.
+	assert(is_idle(*bucket));
+	task.set_trace(trace.get());
+	task.set_realtime_checks(checks.get());
+	task.set_completion_counter(bucket->completion.get());
+	std::lock_guard<std::mutex> lock(tasks_mutex);
+	bucket->tasks.emplace_back(std::move(task));
+	// so collecting the tasks of a cycle never allocates.
+	bucket->done_tasks.reserve(bucket->tasks.size());
+	return *bucket;
+}
+
+void cycle_control::apply_task_changes(bool wait)
+{
+	std::vector<std::pair<periodic_task, virtual_clock::duration>> added;
+	std::vector<const parallel_region*> removed;
+	{
+		std::lock_guard<std::mutex> lock(changes_mutex);
+		added.swap(added_tasks);
+		removed.swap(removed_regions);
+		changes_pending.store(false);
+	}
+
+	const auto ready = [this, wait](tick_task_pair& bucket)
+	{
+		if (wait)
+			wait_until_idle(bucket);
+		return is_idle(bucket);
+	};
+	std::vector<tick_task_pair*> changed;
+	const auto mark_changed = [&changed](tick_task_pair& bucket)
+	{
+		if (std::find(changed.begin(), changed.end(), &bucket) == changed.end())
+			changed.push_back(&bucket);
+	};
+	std::vector<const parallel_region*> deferred_removed;
+	for (const auto* region : removed)
+	{
+		const auto has_region = [region](const periodic_task& t) { return t.get_region() == region; };
+		bool deferred = false;
+		for (auto& bucket : tasks_by_rate)
+		{
+			if (std::none_of(bucket.tasks.begin(), bucket.tasks.end(), has_region))
+				continue;
+			if (!ready(bucket))
+			{
+				deferred = true;
+				continue;
+			}
+			std::lock_guard<std::mutex> lock(tasks_mutex);
+			// workers finishing the removed tasks share their state, see periodic_task.
+			bucket.tasks.erase(std::stable_partition(
+					bucket.tasks.begin(), bucket.tasks.end(),
+					[&has_region](const periodic_task& t) { return !has_region(t); }),
+					bucket.tasks.end());
+			mark_changed(bucket);
+		}
+		if (deferred)
+		{
+			deferred_removed.push_back(region);
+			continue;
+		}
+		throttled.erase(std::remove_if(throttled.begin(), throttled.end(),
+				[region](const std::pair<const parallel_region*, virtual_clock::duration>& t)
+				{
+					return t.first == region;
+				}),
+				throttled.end());
+		dependencies.erase(std::remove_if(dependencies.begin(), dependencies.end(),
+				[region](const std::pair<const parallel_region*, const parallel_region*>& d)
+				{
+					return d.first == region || d.second == region;
+				}),
+				dependencies.end());
+	}
+
+	std::vector<std::pair<periodic_task, virtual_clock::duration>> deferred_added;
+	for (auto& task : added)
+	{
+		const auto bucket = std::find_if(tasks_by_rate.begin(), tasks_by_rate.end(),
+				[&task](const tick_task_pair& b) { return b.tick == task.second; });
+		// tasks of a region still to be removed wait for the removal, to keep the order.
+		const bool region_pending = task.first.get_region() && std::find(
+				deferred_removed.begin(), deferred_removed.end(), task.first.get_region())
+				!= deferred_removed.end();
+		if (region_pending || (bucket != tasks_by_rate.end() && !ready(*bucket)))
+			deferred_added.push_back(std::move(task));
+		else
+			mark_changed(insert_task(std::move(task.first), task.second));
+	}
+
+	if (!deferred_removed.empty() || !deferred_added.empty())
+	{
+		std::lock_guard<std::mutex> lock(changes_mutex);
+		// changes made meanwhile follow the deferred ones.
+		removed_regions.insert(removed_regions.begin(),
+				deferred_removed.begin(), deferred_removed.end());
+		added_tasks.insert(added_tasks.begin(),
+				std::make_move_iterator(deferred_added.begin()),
+				std::make_move_iterator(deferred_added.end()));
+		changes_pending.store(true);
+	}
+
+	// only the changed buckets are idle, the task graphs of other buckets may be in use.
+	for (auto* bucket : changed)
+		resolve_dependencies(*bucket);
+}
+
+void cycle_control::wait_until_idle(tick_task_pair& bucket)
+{
+	while (!bucket.completion->wait_until_done(wall_clock::steady::now() + bucket.tick))
+		;
+}
+
+void cycle_control::enable_throttling(const throttling_policy& policy)
+{
+	if (running)
+		throw std::runtime_error{"Worker threads are already running"};
+	throttle_policy = policy;
+	throttling = true;
+}
+
+void cycle_control::enable_buffer_elision(bool enable)
+{
+	if (running)
+		throw std::runtime_error{"Worker threads are already running"};
+	elide_buffers = enable;
+}
+
+namespace
+{
+/// returns true if task to can only start once task from is done.
+bool reaches(const std::vector<std::vector<size_t>>& successors, size_t from, size_t to)
+{
+	std::vector<char> visited(successors.size(), 0);
+	std::vector<size_t> open{from};
+	while (!open.empty())
+	{
+		const size_t current = open.back();
+		open.pop_back();
+		for (auto next : successors[current])
+		{
+			if (next == to)
+				return true;
+			if (!visited[next])
+			{
+				visited[next] = 1;
+				open.push_back(next);
+			}
+		}
+	}
+	return false;
+}
+}
+
+void cycle_control::update_buffer_elision()
+{
+	for (auto& bucket : tasks_by_rate)
+		update_buffer_elision(bucket);
+}
+
+void cycle_control::update_buffer_elision(tick_task_pair& bucket)
+{
+	// throttling and timeout handlers of the user may start a cycle while a task overruns.
+	const bool ordered = elide_buffers && bucket.graph && !throttling && default_timeout_handler;
+	const auto may_elide = [](const periodic_task& task)
+	{
+		return task.get_region() && !task.skips_on_overrun() && !task.suspended();
+	};
+	for (size_t passive = 0; passive != bucket.tasks.size(); ++passive)
+	{
+		const auto* region = bucket.tasks[passive].get_region();
+		if (!region)
+			continue;
+		for (const auto& elision : region->buffer_elisions())
+		{
+			const auto active = std::find_if(bucket.tasks.begin(), bucket.tasks.end(),
+					[&elision](const periodic_task& t)
+					{
+						return t.get_region() && t.get_region()->get_id() == elision->active;
+					});
+			const size_t a = active - bucket.tasks.begin();
+			const bool elided = ordered && active != bucket.tasks.end()
+					&& may_elide(*active) && may_elide(bucket.tasks[passive])
+					&& (reaches(bucket.graph->successors, a, passive)
+							|| reaches(bucket.graph->successors, passive, a));
+			if (elided && !elision->elided.load() && elision->flush)
+				elision->flush();
+			elision->elided.store(elided);
+		}
+	}
+}
+
+void cycle_control::set_trace(std::shared_ptr<trace_recorder> new_trace)
+{
+	if (running)
+		throw std::runtime_error{"Worker threads are already running"};
+	for (auto& bucket : tasks_by_rate)
+		for (auto& task : bucket.tasks)
+			task.set_trace(new_trace.get());
+	scheduler_->set_trace(new_trace);
+	trace = std::move(new_trace);
+	trace_thread_named = false;
+	if (!trace)
+		return;
+	trace_cycle = trace->add_name("main loop cycle");
+	trace_wait = trace->add_name("wait for tasks");
+}
+
+void cycle_control::enable_realtime_checks(std::shared_ptr<realtime_checks> new_checks)
+{
+	if (running)
+		throw std::runtime_error{"Worker threads are already running"};
+	for (auto& bucket : tasks_by_rate)
+		for (auto& task : bucket.tasks)
+			task.set_realtime_checks(new_checks.get());
+	checks = std::move(new_checks);
+}
+
+namespace
+{
+/// returns the next acceptable rate of region slower than current, zero if there is none.
+virtual_clock::duration next_slower_rate(const parallel_region& region,
+		virtual_clock::duration current, wall_clock::steady::duration tick_length)
+{
+	auto next = virtual_clock::duration::zero();
+	for (const auto rate : region.acceptable_rates())
+	{
+		if (rate <= current || rate % tick_length != rate.zero())
+			continue;
+		if (next == next.zero() || rate < next)
+			next = rate;
+	}
+	return next;
+}
+
+}
+
+bool cycle_control::throttling_absorbs_overrun()
+{
+	if (!throttling)
+		return false;
+	for (const auto& bucket : tasks_by_rate)
+		for (const auto& task : bucket.tasks)
+			if (task.get_region() &&
+					next_slower_rate(*task.get_region(), bucket.tick, tick_length) != bucket.tick.zero())
+				return true;
+	return false;
+}
+
+void cycle_control::update_throttling(bool overran)
+{
+	if (overran)
+	{
+		headroom_streak = 0;
+		if (++overrun_streak >= throttle_policy.overrun_cycles)
+			next_step = pending_step::down;
+		return;
+	}
+	overrun_streak = 0;
+	if (next_step == pending_step::down)
+		next_step = pending_step::none;
+	if (!throttled.empty() && ++headroom_streak >= throttle_policy.headroom_cycles)
+		next_step = pending_step::up;
+}
+
+bool cycle_control::try_step(bool down)
+{
+	if (!down)
+	{
+		if (throttled.empty())
+			return true;
+		if (!move_task(*throttled.back().first, throttled.back().second))
+			return false;
+		throttled.pop_back();
+		return true;
+	}
+
+	const parallel_region* candidate = nullptr;
+	auto from = virtual_clock::duration::zero();
+	auto to = virtual_clock::duration::zero();
+	for (const auto& bucket : tasks_by_rate)
+	{
+		for (const auto& task : bucket.tasks)
+		{
+			const auto* region = task.get_region();
+			if (!region || (candidate && region->priority() >= candidate->priority()))
+				continue;
+			const auto next = next_slower_rate(*region, bucket.tick, tick_length);
+			if (next == next.zero())
+				continue;
+			candidate = region;
+			from = bucket.tick;
+			to = next;
+		}
+	}
+	if (!candidate)
+		return true;
+	if (!move_task(*candidate, to))
+		return false;
+	throttled.emplace_back(candidate, from);
+	return true;
+}
+
+bool cycle_control::move_task(const parallel_region& region, virtual_clock::duration tick_rate)
+{
+	const auto has_region = [&region](const periodic_task& t) { return t.get_region() == &region; };
+	const auto source = std::find_if(tasks_by_rate.begin(), tasks_by_rate.end(),
+			[&has_region](const tick_task_pair& bucket)
+			{
+				return std::any_of(bucket.tasks.begin(), bucket.tasks.end(), has_region);
+			});
+	if (source == tasks_by_rate.end())
+		return true;
+	const auto target = std::find_if(tasks_by_rate.begin(), tasks_by_rate.end(),
+			[tick_rate](const tick_task_pair& bucket) { return bucket.tick == tick_rate; });
+	// moving a task into a running bucket would invalidate the references of its tasks.
+	if (!is_idle(*source) || (target != tasks_by_rate.end() && !is_idle(*target)))
+		return false;
+
+	// the region may run alongside its former partners at the new rate.
+	for (const auto& elision : region.buffer_elisions())
+		elision->elided.store(false);
+	for (const auto& t : source->tasks)
+		if (t.get_region())
+			for (const auto& elision : t.get_region()->buffer_elisions())
+				if (elision->active == region.get_id())
+					elision->elided.store(false);
+
+	auto task = [&]
+	{
+		std::lock_guard<std::mutex> lock(tasks_mutex);
+		const auto it = std::find_if(source->tasks.begin(), source->tasks.end(), has_region);
+		auto moved = std::move(*it);
+		source->tasks.erase(it);
+		return moved;
+	}();
+	resolve_dependencies(*source);
+	resolve_dependencies(insert_task(std::move(task), tick_rate));
+	return true;
+}
+
+void cycle_control::set_main_loop_config(const thread_config& config)
+{
+	if (running)
+		throw std::runtime_error{"Worker threads are already running"};
+	main_config = config;
+}
+
+void cycle_control::set_clock(std::shared_ptr<clock_domain> clock)
+{
+	assert(clock);
+	if (running)
+		throw std::runtime_error{"Worker threads are already running"};
+	if (!tasks_by_rate.empty())
+		throw std::runtime_error{"clock cannot change once tasks are added"};
+	clock_ = std::move(clock);
+}
+
+void cycle_control::set_min_tick(wall_clock::steady::duration length)
+{
+	if (running)
+		throw std::runtime_error{"Worker threads are already running"};
+	if (length <= wall_clock::steady::duration::zero())
+		throw std::invalid_argument{"min tick needs to be positive"};
+	for (const auto& tasks : tasks_by_rate)
+		if (tasks.tick % length != tasks.tick.zero())
+			throw std::invalid_argument{"tick rate of existing task is no multiple of min tick"};
+
+	tick_length = length;
+	for (auto& tasks : tasks_by_rate)
+		tasks.cycles = tasks.tick / tick_length;
+	main_loop_->tick_length = tick_length;
 }
 
 std::exception_ptr cycle_control::last_exception()
@@ -176,21 +1019,137 @@ std::exception_ptr cycle_control::last_exception()
 	return except;
 }
 
+overrun_report cycle_control::report_overrun(const periodic_task& task) const
+{
+	const auto now = wall_clock::steady::now();
+	const auto describe = [now](const periodic_task& t, virtual_clock::duration tick)
+	{
+		const auto region = t.get_region();
+		const auto added = t.work_added();
+		const auto start = t.work_start();
+		return task_overrun{
+				region ? region->get_id().key : std::string{},
+				tick,
+				std::max(now - (added + tick), wall_clock::steady::duration::zero()),
+				start >= added ? now - start : wall_clock::steady::duration::zero()};
+	};
+
+	overrun_report report{};
+	std::lock_guard<std::mutex> lock(tasks_mutex);
+	for (const auto& bucket : tasks_by_rate)
+	{
+		for (const auto& t : bucket.tasks)
+		{
+			if (&t == &task)
+				report.task = describe(t, bucket.tick);
+			else if (!t.done())
+				report.busy_tasks.push_back(describe(t, bucket.tick));
+		}
+	}
+	if (const auto region = task.get_region())
+		report.workers = region->workers().last_profile();
+	return report;
+}
+
+timing_report cycle_control::timing() const
+{
+	std::lock_guard<std::mutex> lock(tasks_mutex);
+	timing_report report;
+	for (const auto& task_vector : tasks_by_rate)
+		for (const auto& task : task_vector.tasks)
+		{
+			const auto region = task.get_region();
+			report.tasks.push_back(task_timing{
+					region ? region->get_id().key : std::string{},
+					task_vector.tick,
+					task.execution_time(),
+					task.queueing_delay(),
+					task.skipped_cycles()});
+		}
+	report.main_loop_overrun = main_loop_->overrun.snapshot();
+	return report;
+}
+
 void cycle_control::set_main_loop(const std::shared_ptr<main_loop>& loop)
 {
 	assert(!running);
 	assert(loop);
 	main_loop_ = loop;
+	attach_main_loop();
+}
+
+void cycle_control::attach_main_loop()
+{
 	main_loop_->wait_for_current_tasks = [this](){ wait_for_current_tasks(); };
+	main_loop_->wait_for_all_tasks = [this](){ wait_for_all_tasks(); };
+	main_loop_->skip_idle_cycles = [this](){ skip_idle_cycles(); };
+	main_loop_->tick_length = tick_length;
 }
 
 void realtime_main_loop::loop_body(const std::function<void(void)>& work)
 {
-	epoch += cycle_control::min_tick_length;
+	epoch += tick_length;
 	work();
+	overrun.record(wall_clock::steady::now() - epoch);
 	std::this_thread::sleep_until(epoch);
 }
 
+precise_realtime_main_loop::precise_realtime_main_loop(wall_clock::steady::duration spin_duration)
+	: spin(spin_duration)
+{
+	assert(spin >= wall_clock::steady::duration::zero());
+}
+
+void precise_realtime_main_loop::arm()
+{
+	epoch = wall_clock::steady::now();
+	last_error.store(0);
+	max_error.store(0);
+}
+
+void precise_realtime_main_loop::loop_body(const std::function<void(void)>& work)
+{
+	epoch += tick_length;
+	work();
+	overrun.record(wall_clock::steady::now() - epoch);
+	wait_until(epoch);
+
+	const auto error = (wall_clock::steady::now() - epoch).count();
+	last_error.store(error);
+	if (error > max_error.load())
+		max_error.store(error);
+}
+
+void precise_realtime_main_loop::wait_until(wall_clock::steady::time_point deadline) const
+{
+	const auto wake_up = deadline - spin;
+	if (wall_clock::steady::now() < wake_up)
+	{
+		// steady_clock is based on CLOCK_MONOTONIC on linux,
+		// thus its time points can be passed to clock_nanosleep directly.
+		const auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				wake_up.time_since_epoch());
+		timespec wake_up_time{};
+		wake_up_time.tv_sec = since_epoch.count() / 1000000000;
+		wake_up_time.tv_nsec = since_epoch.count() % 1000000000;
+		// restart if interrupted by a signal.
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake_up_time, nullptr) == EINTR)
+			;
+	}
+	while (wall_clock::steady::now() < deadline)
+		; // spin
+}
+
+wall_clock::steady::duration precise_realtime_main_loop::last_wakeup_error() const
+{
+	return wall_clock::steady::duration(last_error.load());
+}
+
+wall_clock::steady::duration precise_realtime_main_loop::max_wakeup_error() const
+{
+	return wall_clock::steady::duration(max_error.load());
+}
+
 void timewarp_main_loop::loop_body(const std::function<void(void)>& work)
 {
 	wait_for_current_tasks();
@@ -199,12 +1158,12 @@ void timewarp_main_loop::loop_body(const std::function<void(void)>& work)
 	std::unique_lock<std::mutex> lock(warp_mutex);
 	assert(warp_factor >= 0.0);
 	warp_signal.wait_until(lock,
-			epoch + cycle_control::min_tick_length * warp_factor,
+			epoch + tick_length * warp_factor,
 			[this]()
 			{
-				return wall_clock::steady::now() >= epoch + cycle_control::min_tick_length * warp_factor;
+				return wall_clock::steady::now() >= epoch + tick_length * warp_factor;
 			});
-	epoch += std::chrono::duration_cast<decltype(epoch)::duration>(cycle_control::min_tick_length * warp_factor);
+	epoch += std::chrono::duration_cast<decltype(epoch)::duration>(tick_length * warp_factor);
 }
 
 void timewarp_main_loop::set_warp_factor(double factor)
@@ -215,6 +1174,14 @@ void timewarp_main_loop::set_warp_factor(double factor)
 	warp_signal.notify_all();
 }
 
+void replay_main_loop::loop_body(const std::function<void(void)>& work)
+{
+	wait_for_all_tasks();
+	skip_idle_cycles();
+	work();
+	++cycles;
+}
+
 void afap_main_loop::loop_body(const std::function<void(void)>& work)
 {
 	wait_for_current_tasks();
@@ -4,14 +4,24 @@
 #include <flexcore/scheduler/clock.hpp>
 #include <flexcore/scheduler/scheduler.hpp>
 #include <flexcore/scheduler/parallelregion.hpp>
+#include <flexcore/scheduler/realtime_checks.hpp>
+#include <flexcore/scheduler/threadconfig.hpp>
+#include <flexcore/scheduler/timing.hpp>
+#include <flexcore/scheduler/trace.hpp>
 #include <flexcore/pure/event_sources.hpp>
 
+#include <atomic>
 #include <cassert>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
+#include <functional>
+#include <list>
 #include <mutex>
 #include <memory>
+#include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 namespace fc
@@ -22,8 +32,95 @@ namespace thread
 {
 namespace detail
 {
-struct condition_pair
+/**
+ * \brief number of tasks of a tick rate, which are not done, on a cache line of its own.
+ *
+ * Decremented by the worker finishing a task after the task is marked done,
+ * so the main loop seeing zero knows all tasks are done without looking at each of them.
+ * Also a latch, the main loop waits once for all tasks of a cycle to be done.
+ */
+struct completion_counter
+{
+	static constexpr size_t cache_line = 64;
+	char padding_before_busy[cache_line];
+	std::atomic<size_t> busy{0};
+	/// number of threads blocked in wait_until_done.
+	std::atomic<int> waiters{0};
+	char padding_after_busy[cache_line];
+	std::mutex mtx;
+	std::condition_variable cv;
+
+	void add() noexcept { busy.fetch_add(1); }
+	/// counts a task as done, wakes the waiters if it was the last one.
+	void finish()
+	{
+		// as in periodic_task, either the waiter sees the counter or we see the waiter.
+		if (busy.fetch_sub(1) != 1 || waiters.load() == 0)
+			return;
+		std::lock_guard<std::mutex> lock(mtx);
+		cv.notify_all();
+	}
+
+	/**
+	 * \brief waits until all counted tasks are done, but only until deadline.
+	 * Spins shortly like periodic_task::wait_until_done before it blocks.
+	 * \return true if all tasks are done.
+	 */
+	bool wait_until_done(wall_clock::steady::time_point deadline)
+	{
+		constexpr int spin_count = 64;
+		for (int i = 0; i != spin_count; ++i)
+			if (busy.load() == 0)
+				return true;
+
+		++waiters;
+		bool result = false;
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			result = cv.wait_until(lock, deadline, [this]() { return busy.load() == 0; });
+		}
+		--waiters;
+		return result;
+	}
+};
+
+/**
+ * \brief shared state of a periodic_task and the threads waiting for it.
+ *
+ * The counter is atomic so the common case of polling and setting it needs no lock.
+ * The mutex and condition variable are only used if somebody actually blocks.
+ */
+struct task_state
 {
+	static constexpr size_t cache_line = 64;
+	/// keeps the counters polled by the main loop off the lines of other allocations.
+	char padding_before_counters[cache_line];
+	/// number of cycles added, whose work has not been executed yet.
+	std::atomic<size_t> cycles_to_do{0};
+	/// number of threads blocked in wait_until_done or wait_until_cycles_to_do.
+	std::atomic<int> waiters{0};
+	/// counter of the tasks of a tick rate, which are not done. nullptr if not counted.
+	completion_counter* completion = nullptr;
+	/// keeps the timing written by the worker off the line of the counters.
+	char padding_after_counters[cache_line];
+	/// start time of most recent work cycle
+	std::atomic<wall_clock::steady::time_point> work_start{wall_clock::steady::now()};
+	/// time the task was last marked as having work to do.
+	std::atomic<wall_clock::steady::time_point> work_added{wall_clock::steady::now()};
+	/// number of cycles skipped, since the task was not done in time.
+	std::atomic<size_t> skipped{0};
+	/// true while cycle_control leaves out the task, as its region is suspended.
+	bool suspended = false;
+	/// recorder of the work and switch ticks of the task, nullptr if not traced.
+	trace_recorder* trace = nullptr;
+	uint32_t trace_work = 0;
+	uint32_t trace_switch = 0;
+	/// checks of the work of the task if it is realtime, nullptr if not checked.
+	realtime_checks* checks = nullptr;
+	/// name the task reports violations with.
+	std::string name;
+	duration_histogram execution;
+	duration_histogram queueing;
 	std::mutex mtx;
 	std::condition_variable cv;
 };
@@ -41,20 +138,16 @@ struct periodic_task final
 	 * \pre job must not be empty
 	 */
 	explicit periodic_task(std::function<void(void)> job)
-		: work_to_do(false)
-		, sync(std::make_unique<detail::condition_pair>())
+		: state(std::make_shared<detail::task_state>())
 		, work(std::move(job))
-		, work_start(wall_clock::steady::now())
 		, region(nullptr)
 	{
 		assert(work);
 	}
 	/// Construct a periodic task executes work within a region
 	explicit periodic_task(const std::shared_ptr<parallel_region>& r) :
-				work_to_do(false),
-				sync(std::make_unique<detail::condition_pair>()),
+				state(std::make_shared<detail::task_state>()),
 				work(r->ticks.in_work()),
-				work_start(wall_clock::steady::now()),
 				region(r)
 	{
 		assert(r != nullptr);
@@ -62,60 +155,297 @@ struct periodic_task final
 	}
 
 	///returns true if all work in task is complete
-	bool done()
+	bool done() const
 	{
-		std::lock_guard<std::mutex> lock(sync->mtx);
-		return !work_to_do;
+		return cycles_to_do() == 0;
 	}
 
+	/// returns the number of cycles the task has been given work for, but not executed yet.
+	size_t cycles_to_do() const { return state->cycles_to_do.load(); }
+
 	///notify task if more work is to be done
 	void set_work_to_do(bool todo)
 	{
+		// the task may be moved or removed by cycle_control as soon as it is done,
+		// the copy keeps its state alive until the waiters are notified.
+		const auto keep = state;
+		auto& s = *keep;
+		// read before the task is done, moving it to another tick rate changes the counter.
+		auto* completion = s.completion;
+		if (todo)
 		{
-			std::lock_guard<std::mutex> lock(sync->mtx);
-			work_to_do = todo;
+			s.work_added.store(wall_clock::steady::now());
+			if (s.cycles_to_do.exchange(1) == 0 && completion)
+				completion->add();
+			return;
 		}
-		// if we're done then notify all waiters
-		if (todo == false)
-			sync->cv.notify_all();
+		if (s.cycles_to_do.exchange(0) != 0 && completion)
+			completion->finish();
+		notify_waiters(s);
+	}
+
+	/**
+	 * \brief adds the work of another cycle, even if the work of earlier cycles is not done.
+	 * \return true if the task was done before, the caller then needs to execute it,
+	 * otherwise the cycle is executed by finish_cycle of the running task.
+	 */
+	bool add_cycle()
+	{
+		if (state->cycles_to_do.fetch_add(1) != 0)
+			return false;
+		if (state->completion)
+			state->completion->add();
+		state->work_added.store(wall_clock::steady::now());
+		return true;
+	}
+
+	/**
+	 * \brief marks the work of a single cycle as done.
+	 * \return true if further cycles have been added in the meantime,
+	 * the switch tick for the next of them has then been sent and the task needs to run again.
+	 */
+	bool finish_cycle()
+	{
+		// like set_work_to_do, the task may be removed once its last cycle is done.
+		const auto keep = state;
+		auto& s = *keep;
+		auto* completion = s.completion;
+		const bool more_cycles = s.cycles_to_do.fetch_sub(1) != 1;
+		if (!more_cycles && completion)
+			completion->finish();
+		notify_waiters(s);
+		if (!more_cycles)
+			return false;
+		s.work_added.store(wall_clock::steady::now());
+		send_switch_tick();
+		return true;
 	}
 
 	/** \brief waits for this task to be done, but only until the provided timeout.
+	 *
+	 * Spins shortly, as most tasks are done or about to be done when they are waited for,
+	 * and only blocks if that is not the case.
 	 * \return true if the task is done.
 	 */
 	bool wait_until_done(virtual_clock::steady::duration timeout)
 	{
-		std::unique_lock<std::mutex> lock(sync->mtx);
-		return sync->cv.wait_until(
-				lock,
-				work_start + timeout,
-				[this](){ return !this->work_to_do; }
-		);
+		return wait_until_cycles_to_do(0, timeout);
+	}
+
+	/**
+	 * \brief waits until at most max_cycles cycles of the task are left to do,
+	 * but only until the provided timeout.
+	 * \return true if no more than max_cycles are left.
+	 */
+	bool wait_until_cycles_to_do(size_t max_cycles, virtual_clock::steady::duration timeout)
+	{
+		constexpr int spin_count = 64;
+		for (int i = 0; i != spin_count; ++i)
+			if (cycles_to_do() <= max_cycles)
+				return true;
+
+		++state->waiters;
+		bool result = false;
+		{
+			std::unique_lock<std::mutex> lock(state->mtx);
+			result = state->cv.wait_until(
+					lock,
+					state->work_start.load() + timeout,
+					[this, max_cycles](){ return this->cycles_to_do() <= max_cycles; }
+			);
+		}
+		--state->waiters;
+		return result;
+	}
+
+	/// sets the worker the task should be executed by, see scheduler::add_affine_task.
+	void set_worker_affinity(size_t worker) { affinity = worker; }
+	/**
+	 * \brief returns the worker the task should be executed by.
+	 * The affinity of the associated parallel_region takes precedence if it has one.
+	 */
+	size_t worker_affinity() const
+	{
+		if (region && region->worker_affinity() != scheduler::any_worker)
+			return region->worker_affinity();
+		return affinity;
+	}
+
+	/// returns the numa node of the region of the task, any_numa_node if there is none.
+	int numa_node() const { return region ? region->numa_node() : any_numa_node; }
+
+	/// sets the priority of the task, see parallel_region::set_priority.
+	void set_priority(int new_priority) { priority_ = new_priority; }
+	/// returns the priority of the task, which is that of its region if it has one.
+	int priority() const { return region ? region->priority() : priority_; }
+
+	/// lets the task skip cycles it overruns, see parallel_region::set_skip_on_overrun.
+	void set_skip_on_overrun(bool skip) { skip_on_overrun_ = skip; }
+	/// returns true if the task or its region skip cycles they overrun.
+	bool skips_on_overrun() const
+	{
+		return region ? region->skips_on_overrun() : skip_on_overrun_;
 	}
+	/// marks the work of the task as realtime critical, see parallel_region::set_realtime.
+	void set_realtime(bool realtime) { realtime_ = realtime; }
+	/// returns true if the task or its region are realtime critical.
+	bool is_realtime() const { return region ? region->realtime() : realtime_; }
+
+	/// returns the number of cycles skipped, since the task was not done in time.
+	size_t skipped_cycles() const { return state->skipped.load(); }
+	/// counts a skipped cycle, called by cycle_control.
+	void skip_cycle() { ++state->skipped; }
+	/// forgets the timing and skipped cycles recorded so far. \pre done()
+	void reset_statistics()
+	{
+		assert(done());
+		state->skipped.store(0);
+		state->execution.reset();
+		state->queueing.reset();
+	}
+
+	/**
+	 * \brief follows suspend and resume of the region of the task, called by cycle_control.
+	 *
+	 * Sends the suspend_tick or resume_tick of the region, if its state changed.
+	 * \pre done()
+	 * \return true if the task is to be left out of the current cycle.
+	 */
+	bool update_suspension()
+	{
+		assert(done());
+		if (!region)
+			return false;
+		const bool suspend = region->suspended();
+		if (suspend != state->suspended)
+		{
+			state->suspended = suspend;
+			if (suspend)
+				region->suspend_tick().fire();
+			else
+				region->resume_tick().fire();
+		}
+		return suspend;
+	}
+	/// returns true if cycle_control currently leaves out the task.
+	bool suspended() const { return state->suspended; }
 
 	///trigger switch tick of associated parallel_region if it is registered.
 	void send_switch_tick()
 	{
+		if (state->trace)
+			state->trace->instant(state->trace_switch);
 		if (region)
+		{
+			region->publish_cycle_time(region->clock().steady_now());
 			region->ticks.switch_buffers();
+		}
+	}
+
+	/**
+	 * \brief records the work and switch ticks of the task to trace, called by cycle_control.
+	 * Events are named by the region of the task. nullptr stops recording.
+	 * \pre done()
+	 */
+	void set_trace(trace_recorder* trace)
+	{
+		state->trace = trace;
+		if (!trace)
+			return;
+		const std::string name = region ? region->get_id().key : std::string{"task"};
+		state->trace_work = trace->add_name(name);
+		state->trace_switch = trace->add_name("switch tick " + name);
+	}
+
+	/**
+	 * \brief counts the task in completion while it is not done, called by cycle_control.
+	 * nullptr stops counting.
+	 * \pre done()
+	 */
+	void set_completion_counter(detail::completion_counter* completion)
+	{
+		assert(done());
+		state->completion = completion;
+	}
+
+	/**
+	 * \brief checks the work of the task, if it is realtime, called by cycle_control.
+	 * Violations are named by the region of the task. nullptr stops checking.
+	 * \pre done()
+	 */
+	void set_realtime_checks(realtime_checks* checks)
+	{
+		state->checks = checks;
+		state->name = region ? region->get_id().key : std::string{"task"};
 	}
 
 	void operator()()
 	{
-		work_start = wall_clock::steady::now();
-		work();
+		run();
 		set_work_to_do(false);
 	}
+
+	/// executes the work of the task without marking it as done.
+	void run()
+	{
+		auto* trace = state->trace;
+		if (trace)
+			trace->begin(state->trace_work);
+		const auto start = wall_clock::steady::now();
+		state->work_start.store(start);
+		state->queueing.record(start - state->work_added.load());
+		if (state->checks && is_realtime())
+		{
+			const detail::realtime_scope scope{*state->checks, state->name};
+			work();
+		}
+		else
+			work();
+		state->execution.record(wall_clock::steady::now() - start);
+		if (trace)
+			trace->end(state->trace_work);
+	}
+
+	/// returns the time the task was last given work to do.
+	wall_clock::steady::time_point work_added() const { return state->work_added.load(); }
+	/// returns the time the most recent execution of the task started.
+	wall_clock::steady::time_point work_start() const { return state->work_start.load(); }
+
+	/// returns the durations of the executions of the task so far.
+	histogram_snapshot execution_time() const { return state->execution.snapshot(); }
+	/// returns the durations between work being added and the start of the execution.
+	histogram_snapshot queueing_delay() const { return state->queueing.snapshot(); }
+
+	/// returns the region the task executes work in, nullptr if there is none.
+	const parallel_region* get_region() const { return region.get(); }
 private:
-	/// flag to check if work has already been executed this cycle.
-	bool work_to_do;
-	std::unique_ptr<detail::condition_pair> sync;
+	static void notify_waiters(detail::task_state& s)
+	{
+		// waiters is incremented before the counter is checked by the waiting thread,
+		// thus either the waiter sees the counter or we see the waiter.
+		if (s.waiters.load() != 0)
+		{
+			// lock is necessary, to not notify between check and wait of a waiter.
+			std::lock_guard<std::mutex> lock(s.mtx);
+			s.cv.notify_all();
+		}
+	}
+
+	/**
+	 * on the heap, so the task can be moved while the state is shared with waiting threads.
+	 * Shared with the worker finishing the task, which still notifies the waiters
+	 * after cycle_control has seen the task as done.
+	 */
+	std::shared_ptr<detail::task_state> state;
 	/// work to be done every cycle
 	std::function<void(void)> work;
-	/// start time of most recent work cycle
-	wall_clock::steady::time_point work_start;
 
 	std::shared_ptr<parallel_region> region;
+	/// preferred worker of this task.
+	size_t affinity = scheduler::any_worker;
+	int priority_ = 0;
+	bool skip_on_overrun_ = false;
+	bool realtime_ = false;
 };
 
 ///Abstract Base class for all main lopp classes.
@@ -127,18 +457,76 @@ public:
 
 	virtual void arm() = 0;
 
+	/**
+	 * \brief number of cycles tasks without dependencies may fall behind the main loop.
+	 * Zero for all loops except a pipelined afap_main_loop.
+	 */
+	virtual size_t max_cycles_ahead() const { return 0; }
+
 	std::function<void(void)> wait_for_current_tasks{};
+	/// waits without timeout until no task is running anymore, set by cycle_control.
+	std::function<void(void)> wait_for_all_tasks{};
+	/// advances the clock to the next cycle in which tasks are due, set by cycle_control.
+	std::function<void(void)> skip_idle_cycles{};
+	/// duration of a single cycle of the loop, set by cycle_control.
+	wall_clock::steady::duration tick_length{parallel_region::min_tick_length};
+	/// time by which cycles took longer than tick_length, recorded by realtime loops.
+	duration_histogram overrun{};
 };
 
 /**
  * \brief Main Loop which runs as fast as possible
+ *
+ * By default every cycle starts once the tasks due in it have finished the previous one.
+ * With max_cycles_ahead > 0 the loop is pipelined: The main loop may run up to
+ * max_cycles_ahead cycles ahead of slow tasks, which then catch up by executing
+ * the cycles they missed back to back, including their switch ticks.
+ * Thus no cycle is skipped and independent regions don't wait on each other.
+ * Only tasks of regions without any dependency, see cycle_control::add_dependency,
+ * and without buffered connections to other regions fall behind.
+ * Regions with either still wait for each other every cycle,
+ * as they switch the buffers of their connections.
+ * Connections are taken into account as made before start, run_cycles or warm_up.
+ * Regions running behind see the virtual clock of the main loop.
  */
 class afap_main_loop final : public main_loop
 {
 public:
+	afap_main_loop() = default;
+	/// \param max_cycles maximum number of cycles tasks may fall behind.
+	explicit afap_main_loop(size_t max_cycles) : cycles_ahead(max_cycles) {}
+
 	void loop_body(const std::function<void(void)>& work) override;
 
 	void arm() override {};
+
+	size_t max_cycles_ahead() const override { return cycles_ahead; }
+
+private:
+	size_t cycles_ahead = 0;
+};
+
+/**
+ * \brief Main Loop for reproducible replays of recorded data as fast as possible.
+ *
+ * Regions still run in parallel, but every cycle starts only after all tasks,
+ * including those of slower tick rates, are done. Thus the buffers of all regions are
+ * switched at the same point of the computation in every run and there are no timeouts.
+ * Cycles in which no task is due are skipped, the virtual clock jumps directly
+ * to the next cycle with work.
+ */
+class replay_main_loop final : public main_loop
+{
+public:
+	void loop_body(const std::function<void(void)>& work) override;
+
+	void arm() override { cycles.store(0); }
+
+	/// returns the number of cycles actually executed since the loop was armed.
+	size_t cycles_executed() const { return cycles.load(); }
+
+private:
+	std::atomic<size_t> cycles{0};
 };
 
 /**
@@ -155,6 +543,40 @@ private:
 	wall_clock::steady::time_point epoch{wall_clock::steady::now()};
 };
 
+/**
+ * \brief Main Loop which runs in realtime with low jitter.
+ *
+ * Sleeps with an absolute timeout until shortly before the start of the next cycle,
+ * then spins until the cycle starts. This avoids the overshoot of sleep_until
+ * at the cost of keeping the main loop thread busy for spin_duration every cycle.
+ * The error between the intended and the actual start of each cycle is recorded.
+ */
+class precise_realtime_main_loop final : public main_loop
+{
+public:
+	/// \param spin_duration time spent spinning before the start of each cycle.
+	explicit precise_realtime_main_loop(
+			wall_clock::steady::duration spin_duration = std::chrono::microseconds(200));
+
+	void loop_body(const std::function<void(void)>& work) override;
+
+	void arm() override;
+
+	/// returns how late the most recent cycle started.
+	wall_clock::steady::duration last_wakeup_error() const;
+	/// returns the largest delay of the start of a cycle since the loop was armed.
+	wall_clock::steady::duration max_wakeup_error() const;
+
+private:
+	/// sleeps until the time point deadline - spin, then spins until deadline.
+	void wait_until(wall_clock::steady::time_point deadline) const;
+
+	const wall_clock::steady::duration spin;
+	wall_clock::steady::time_point epoch{wall_clock::steady::now()};
+	std::atomic<wall_clock::steady::duration::rep> last_error{0};
+	std::atomic<wall_clock::steady::duration::rep> max_error{0};
+};
+
 /**
  * \brief Main Loop which runs variable speed.
  */
@@ -174,10 +596,26 @@ private:
 	wall_clock::steady::time_point epoch{wall_clock::steady::now()};
 };
 
+/// when cycle_control steps regions down to slower rates and back, see enable_throttling.
+struct throttling_policy
+{
+	/// number of consecutive cycles with overruns, after which a region is stepped down.
+	size_t overrun_cycles = 3;
+	/// number of consecutive cycles without overruns, after which a region is stepped up.
+	size_t headroom_cycles = 100;
+};
+
 /**
  * \brief Controls timing and the execution of cyclic tasks in the scheduler.
+ *
+ * Each cycle takes min_tick() and advances the virtual clock by that amount,
+ * the global one unless set_clock gives the cycle_control a clock_domain of its own.
+ * Tasks can run at any multiple of min_tick(),
+ * they are grouped by their tick rate so every cycle only visits one bucket per rate.
+ * Due tasks are handed to the scheduler sorted by priority and earliest deadline,
+ * which is the end of their tick. Tasks which skip on overrun are not reported to
+ * the timeout handler, they just miss the cycle.
  * Todo: allow to set virtual clock as control clock for replay as template parameter
- * todo: allow to set min_tick_length
  */
 class cycle_control
 {
@@ -216,7 +654,12 @@ public:
 
 	~cycle_control();
 
-	/// starts the main loop
+	/**
+	 * \brief starts the main loop in a thread of its own, see set_main_loop_config.
+	 * The settings are applied before the first cycle.
+	 * \throws std::system_error if the settings of the thread cannot be applied,
+	 * the main loop is stopped again then without having run a cycle.
+	 */
 	void start();
 	/// halts the main loop without joining worker threads
 	void stop();
@@ -224,22 +667,182 @@ public:
 	/// advances the clock by a single tick and executes all tasks for the cycle.
 	void work();
 
+	/**
+	 * \brief runs the main loop for a number of cycles in the calling thread.
+	 *
+	 * Instead of start and stop, for callers driving many cycle_control themselves,
+	 * like batch_runner. Returns once the tasks of the last cycle are done,
+	 * or earlier if the timeout handler stops the loop.
+	 * \pre cycle_control is not running.
+	 */
+	void run_cycles(size_t cycles);
+	/**
+	 * \brief runs cycles before the start of the realtime loop, to reach steady state.
+	 *
+	 * The first cycles of an application grow the vectors of buffers, allocate in
+	 * std::function and touch fresh pages. warm_up runs them in the calling thread
+	 * as fast as possible without deadlines: every cycle waits for all tasks,
+	 * no task skips a cycle and the timeout handler is not called.
+	 * Afterwards the timing of all tasks and of the main loop is reset,
+	 * so timing() and metrics only show the cycles after start.
+	 * Capacities recorded in an earlier run can be reserved before,
+	 * see capacity_profile, to need fewer cycles.
+	 * \pre cycle_control is not running, throws std::runtime_error otherwise.
+	 */
+	void warm_up(size_t cycles);
+
 	/**
 	 * \brief adds a new cyclic task with the given tick_rate.
-	 * Tasks can only be added as long as the cycle_control has not been started. A
-	 * std::runtime_error exception will be thrown if an attempt is made to add a task to a running
-	 * cycle_control.
 	 *
-	 * \pre cycle_control is not running
-	 * \post list of tasks for given tick_rate is not empty
+	 * Can be called from any thread, also while cycle_control is running.
+	 * Tasks added to a running cycle_control are taken over by the main loop at the start
+	 * of the first cycle, in which the tasks with the same tick rate are done.
+	 * The main loop does not wait for them, other tick rates keep running meanwhile.
+	 * The task then runs from the next cycle it is due in on.
+	 *
+	 * Tasks without an affinity to a worker get one assigned round robin.
+	 * Thus a task sticks to the same worker every cycle,
+	 * unless the scheduler moves it to balance the load.
+	 *
+	 * \pre tick_rate is a positive multiple of min_tick(),
+	 * throws std::invalid_argument otherwise.
+	 * \pre the region of task uses clock(), throws std::invalid_argument otherwise.
+	 * \post list of tasks for given tick_rate is not empty, once the task has been taken over.
 	 */
 	void add_task(periodic_task task, virtual_clock::duration tick_rate);
+
+	/**
+	 * \brief removes the tasks of region, which then gets no more switch and work ticks.
+	 *
+	 * Can be called from any thread. Like added tasks, the tasks are removed between two cycles
+	 * once the tasks with the same tick rate are done, the last work of the region may
+	 * thus still run after the call returns.
+	 * Dependencies declared for region are removed as well.
+	 */
+	void remove_tasks(const parallel_region& region);
+
+	/**
+	 * \brief lets cycle_control slow down regions of low priority, instead of failing on overload.
+	 *
+	 * If tasks overrun their cycle for policy.overrun_cycles cycles in a row, the region
+	 * with the lowest priority, which has an acceptable rate slower than its current one,
+	 * is moved to the next slower of its parallel_region::acceptable_rates.
+	 * After policy.headroom_cycles cycles without overrun, the region stepped down last
+	 * is moved back one step. Regions are only moved in a cycle in which neither their
+	 * current nor their new rate has tasks running, dependencies between regions then
+	 * ordered in the same cycle are only kept while both run at the same rate.
+	 *
+	 * As long as there is a region left to step down, overruns are not reported
+	 * to the timeout handler, the overrunning task skips the cycle instead.
+	 * timing() shows the rates the regions currently run at.
+	 * \pre cycle_control is not running, throws std::runtime_error otherwise.
+	 */
+	void enable_throttling(const throttling_policy& policy);
+
+	/**
+	 * \brief lets connections between regions, which never run at the same time, skip their buffers.
+	 *
+	 * Regions with the same tick rate, which are ordered by dependencies, see add_dependency,
+	 * are never executed concurrently. Connections between them then deliver events
+	 * directly and pull states from their source, see buffer_elision, which removes
+	 * the copy of the buffer and the delay of a cycle. Regions which skip cycles they overrun
+	 * keep their buffers, as they may run alongside their successors. For the same reason
+	 * no buffers are elided with throttling enabled or with a timeout handler of the user,
+	 * which may let a cycle start while a task overruns.
+	 *
+	 * Decided at start, warm_up and run_cycles for the tasks added so far.
+	 * Connections of suspended regions keep their buffers, so events sent to a suspended
+	 * region are frozen like in other buffers. Events held by a buffer are delivered
+	 * by the main loop, before the buffer is bypassed again.
+	 * \pre cycle_control is not running, throws std::runtime_error otherwise.
+	 */
+	void enable_buffer_elision(bool enable = true);
+
+	/**
+	 * \brief records the timeline of the main loop, the tasks and the scheduler to trace.
+	 *
+	 * The main loop records its cycles and the time it waits for tasks,
+	 * tasks record their work named by their region and their switch ticks,
+	 * and the workers of the scheduler the tasks they run, see scheduler::set_trace.
+	 * Tasks added later are recorded as well. nullptr stops recording.
+	 * \pre cycle_control is not running, throws std::runtime_error otherwise.
+	 */
+	void set_trace(std::shared_ptr<trace_recorder> trace);
+
+	/**
+	 * \brief reports allocations and locks in the work of realtime tasks to checks.
+	 *
+	 * A debug and staging mode, see realtime_checks for which hooks it needs.
+	 * Only tasks marked realtime are checked, see parallel_region::set_realtime.
+	 * Tasks added later are checked as well. nullptr stops checking.
+	 * \pre cycle_control is not running, throws std::runtime_error otherwise.
+	 */
+	void enable_realtime_checks(std::shared_ptr<realtime_checks> checks);
+	/// returns the checks of realtime tasks, nullptr if they are not checked.
+	std::shared_ptr<realtime_checks> get_realtime_checks() const { return checks; }
+
+	/**
+	 * \brief sets scheduling, affinity and memory settings of the thread of the main loop.
+	 *
+	 * Applied by start, which throws std::system_error if the operating system
+	 * rejects them. The main loop is pinned to config.cpu_cores[0], if given.
+	 * Give it a higher realtime_priority than the workers of the scheduler,
+	 * so it wakes up in time for the next tick while they are busy.
+	 * nr_of_threads, worker_name and idle_spin are ignored.
+	 * run_cycles and warm_up run in the calling thread, which is not configured.
+	 * \pre cycle_control is not running, throws std::runtime_error otherwise.
+	 */
+	void set_main_loop_config(const thread_config& config);
+	/// returns the settings of the thread of the main loop, default scheduling by default.
+	const thread_config& main_loop_config() const { return main_config; }
+
+	/**
+	 * \brief sets the duration of a single cycle, which is min_tick_length by default.
+	 *
+	 * \pre cycle_control is not running, throws std::runtime_error otherwise.
+	 * \pre length > 0 and the tick rates of all tasks already added are multiples of length,
+	 * throws std::invalid_argument otherwise.
+	 */
+	void set_min_tick(wall_clock::steady::duration length);
+	/// returns the duration of a single cycle
+	wall_clock::steady::duration min_tick() const { return tick_length; }
+
+	/**
+	 * \brief sets the clock advanced by this cycle_control, which is the global one by default.
+	 *
+	 * Several cycle_control with clocks of their own run independent simulations
+	 * in one process, each at its own speed. Regions are given the clock on construction.
+	 * \pre cycle_control is not running and has no tasks yet, throws std::runtime_error otherwise.
+	 * \pre clock != nullptr
+	 */
+	void set_clock(std::shared_ptr<clock_domain> clock);
+	/// returns the clock advanced by this cycle_control.
+	const std::shared_ptr<clock_domain>& clock() const noexcept { return clock_; }
 	/// returns the number of currently scheduled tasks
 	size_t nr_of_tasks() const { return scheduler_->nr_of_waiting_tasks(); }
+	/// returns the scheduler executing the tasks, tasks can use it to split up their work.
+	scheduler& task_scheduler() { return *scheduler_; }
 
 	/// Get last exception thrown by timeout. Returns nullptr if no exception was thrown
 	std::exception_ptr last_exception();
 
+	/**
+	 * \brief describes why task, which is not done at the end of its cycle, overran.
+	 *
+	 * Contains how late the task is, the times of the workers of its region
+	 * in their last profiled cycle, see work_groups::enable_profiling,
+	 * and the other tasks which were not done either.
+	 * The default timeout handler logs this report to channel "cycle_control".
+	 * \pre task is a task of this cycle_control.
+	 */
+	overrun_report report_overrun(const periodic_task& task) const;
+
+	/**
+	 * \brief returns execution time and queueing delay of all tasks and overruns of the main loop.
+	 * Can be called from any thread while cycle_control is running.
+	 */
+	timing_report timing() const;
+
 	/**
 	 * \brief set a new main_loop to run.
 	 * \pre loop != nullptr
@@ -248,26 +851,170 @@ public:
 	 */
 	void set_main_loop(const std::shared_ptr<main_loop>& loop);
 
+	/**
+	 * \brief declares that the work of successor needs the results of predecessor.
+	 *
+	 * If both regions are due in the same cycle, the work tick of successor is only sent
+	 * once the work of predecessor is done. The switch ticks of all regions are still sent
+	 * by the main loop before any region works, so buffers are never switched while a region
+	 * works on them. With enable_buffer_elision, connections from predecessor to successor
+	 * then pass data of the current cycle instead of the last one.
+	 * The order between regions with different tick rates is not affected.
+	 * \see infrastructure::order_regions_by_dataflow
+	 *
+	 * \pre cycle_control is not running, throws std::runtime_error otherwise.
+	 * \pre the dependency creates no cycle, throws std::invalid_argument otherwise.
+	 */
+	void add_dependency(const parallel_region& predecessor, const parallel_region& successor);
+
 private:
+	/**
+	 * \brief dependencies between the tasks of a single tick rate.
+	 *
+	 * The remaining number of predecessors of a task carries the cycle it was set in
+	 * in its upper half, so tasks which overran their cycle cannot release tasks of the next.
+	 * Tasks still waiting or running from an earlier cycle keep their counter,
+	 * so the overrunning predecessors of that cycle still release them.
+	 */
+	struct task_graph
+	{
+		/// indices of the tasks depending on the task with the same index.
+		std::vector<std::vector<size_t>> successors;
+		std::vector<uint32_t> nr_of_predecessors;
+		std::unique_ptr<std::atomic<uint64_t>[]> pending_predecessors;
+		/// the cycle each task was last executed in.
+		std::unique_ptr<std::atomic<uint32_t>[]> scheduled;
+		/// counts the cycles of the tick rate, only changed by the main loop.
+		uint32_t generation = 0;
+	};
+
 	struct tick_task_pair
 	{
 		virtual_clock::steady::duration tick;
+		/// number of cycles per tick
+		size_t cycles;
 		std::vector<periodic_task> tasks{};
-		std::vector<std::reference_wrapper<periodic_task>> done_tasks{};
+		/// indices of tasks to be executed this cycle, reserved for all tasks.
+		std::vector<size_t> done_tasks{};
+		/// counts the tasks which are not done, on the heap so buckets can be moved.
+		std::unique_ptr<detail::completion_counter> completion
+				= std::make_unique<detail::completion_counter>();
+		/// time the tasks of the most recent cycle were started.
+		wall_clock::steady::time_point started{};
+		/**
+		 * \brief true if all tasks registered with completion were started in the most
+		 * recent cycle, the main loop then waits for them at once instead of task by task.
+		 */
+		bool single_wait = false;
+		/// nullptr if there are no dependencies between tasks.
+		std::unique_ptr<task_graph> graph{};
+		/// true for tasks whose region has no dependencies, these may fall behind.
+		std::vector<char> independent{};
 	};
 
-	/// runs the tasks in this vector; returns false if any task is not done, true otherwise
+	/// adds the tasks in this vector to batch; returns false if any task is not done, true otherwise
 	bool run_periodic_tasks(tick_task_pair& tasks);
+	/// adds another cycle to task, which is added to batch if it is not running already.
+	void run_ahead(periodic_task& task);
+	/// adds the tasks without predecessors to batch, they start their successors when done.
+	void run_task_graph(tick_task_pair& tasks);
+	/// starts task index of tasks within cycle generation, its switch tick was sent already.
+	void dispatch(tick_task_pair& tasks, size_t index, uint32_t generation);
+	/// work of task index in a task graph, which also releases its successors.
+	scheduler::task_t graph_job(tick_task_pair& tasks, size_t index, uint32_t generation);
+	/// marks task index as done for its successors and starts those that are ready.
+	void release_successors(tick_task_pair& tasks, size_t index, uint32_t generation);
+	/// builds the task_graph of every tick rate from the declared dependencies.
+	void resolve_dependencies();
+	/// builds the task_graph of the tasks in bucket from the declared dependencies.
+	void resolve_dependencies(tick_task_pair& bucket);
+	/// adds task to the bucket of tick_rate and returns that bucket.
+	tick_task_pair& insert_task(periodic_task task, virtual_clock::duration tick_rate);
+	/**
+	 * \brief takes over the tasks added and removed while running.
+	 *
+	 * Changes of buckets, whose tasks are still running, are kept for the next call,
+	 * unless wait is true, which waits for the buckets instead.
+	 */
+	void apply_task_changes(bool wait);
+	/// waits without timeout until no task of bucket is running anymore.
+	void wait_until_idle(tick_task_pair& bucket);
+	/// returns true if an overrun is to be absorbed by stepping down a region.
+	bool throttling_absorbs_overrun();
+	/// counts cycles with and without overrun and decides to step regions down or up.
+	void update_throttling(bool overran);
+	/// moves a region to a slower or back to its previous rate, if the buckets are idle.
+	bool try_step(bool down);
+	/// moves the task of region to tick_rate, returns false if the buckets are busy.
+	bool move_task(const parallel_region& region, virtual_clock::duration tick_rate);
+	/// elides the buffers between regions which never run concurrently, see enable_buffer_elision.
+	void update_buffer_elision();
+	/// decides the elision of the buffers between the regions of bucket.
+	void update_buffer_elision(tick_task_pair& bucket);
+	/// number of cycles of length min_tick() since the start of the virtual clock.
+	size_t current_cycle() const
+	{
+		return clock_->steady_now().time_since_epoch() / tick_length;
+	}
 	void wait_for_current_tasks();
+	/// waits for the tasks due in the current cycle, part of wait_for_current_tasks.
+	void wait_for_tasks_of_cycle();
+	void wait_for_all_tasks();
+	void skip_idle_cycles();
+	/// connects main_loop_ to this cycle_control.
+	void attach_main_loop();
 
-	tick_task_pair tasks_slow{slow_tick};
-	tick_task_pair tasks_medium{medium_tick};
-	tick_task_pair tasks_fast{fast_tick};
+	/**
+	 * tasks grouped by tick rate, sorted from fastest to slowest rate.
+	 * A list, as running tasks refer to their bucket while buckets of other rates are added.
+	 */
+	std::list<tick_task_pair> tasks_by_rate;
+	/// locked while tasks are changed by the main loop, so timing() can read them.
+	mutable std::mutex tasks_mutex;
+	/// tasks and regions to be added and removed by the main loop before the next cycle.
+	std::vector<std::pair<periodic_task, virtual_clock::duration>> added_tasks;
+	std::vector<const parallel_region*> removed_regions;
+	std::mutex changes_mutex;
+	std::atomic<bool> changes_pending{false};
+
+	std::shared_ptr<trace_recorder> trace;
+	std::shared_ptr<realtime_checks> checks;
+	uint32_t trace_cycle = 0;
+	uint32_t trace_wait = 0;
+	/// true once the thread of the main loop is named in trace.
+	bool trace_thread_named = false;
+
+	bool throttling = false;
+	bool elide_buffers = false;
+	/// false if the user gave a timeout handler, which may let overrunning tasks continue.
+	bool default_timeout_handler = false;
+	throttling_policy throttle_policy{};
+	/// consecutive cycles with and without overrun.
+	size_t overrun_streak = 0;
+	size_t headroom_streak = 0;
+	/// true if a task overran its cycle in the current cycle.
+	bool cycle_overran = false;
+	/// regions stepped down, with their previous rate, in the order they were stepped down.
+	std::vector<std::pair<const parallel_region*, virtual_clock::duration>> throttled;
+	enum class pending_step { none, down, up };
+	pending_step next_step = pending_step::none;
+	wall_clock::steady::duration tick_length{min_tick_length};
+	std::shared_ptr<clock_domain> clock_ = clock_domain::global();
 	std::unique_ptr<scheduler> scheduler_;
+	/// tasks of the current cycle, kept as member to reuse its memory every cycle.
+	std::vector<scheduler::affine_task> batch;
+	/// affinity given to the next task without one.
+	size_t next_affinity = 0;
+	/// pairs of predecessor and successor
+	std::vector<std::pair<const parallel_region*, const parallel_region*>> dependencies;
+	/// task graphs need to be rebuilt before the next cycle.
+	bool dependencies_changed = false;
 	std::atomic<bool> keep_working{false};
-	bool running = false;
+	/// changed under changes_mutex, so tasks are not added after the last changes are applied.
+	std::atomic<bool> running{false};
 
 	std::shared_ptr<main_loop> main_loop_;
+	thread_config main_config{};
 	std::thread main_loop_thread;
 
 	//Thread exception handling
@@ -291,7 +1038,7 @@ inline cycle_control::cycle_control(std::unique_ptr<scheduler> scheduler,
 	assert(scheduler_);
 	assert(main_loop_);
 	assert(timeout_callback);
-	main_loop_->wait_for_current_tasks = [this](){ wait_for_current_tasks(); };
+	attach_main_loop();
 }
 
 } /* namespace thread */
@@ -302,6 +1049,11 @@ struct out_of_time_exception: std::runtime_error
 			std::runtime_error("cyclic task has not finished in time")
 	{
 	}
+	/// \param details description of the overrun, appended to the message.
+	explicit out_of_time_exception(const std::string& details) :
+			std::runtime_error("cyclic task has not finished in time: " + details)
+	{
+	}
 };
 
 } /* namespace fc */
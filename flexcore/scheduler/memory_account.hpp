@@ -0,0 +1,120 @@
+#ifndef SRC_SCHEDULER_MEMORY_ACCOUNT_HPP_
+#define SRC_SCHEDULER_MEMORY_ACCOUNT_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace fc
+{
+namespace thread
+{
+
+/**
+ * \brief bytes held by the nodes and buffers of a parallel_region.
+ *
+ * Owners of memory report what they hold through a memory_charge,
+ * usually when they grow or shrink on switch ticks, so accounting costs nothing per event.
+ * The account itself does not allocate anything.
+ *
+ * Once used() exceeds the soft limit, buffers stop growing and drop events
+ * as selected by their policy instead, see event_buffer::account_memory.
+ * All methods can be called from any thread.
+ */
+class memory_account
+{
+public:
+	static constexpr size_t unlimited = std::numeric_limits<size_t>::max();
+
+	explicit memory_account(size_t soft_limit = unlimited) noexcept : limit(soft_limit) {}
+	memory_account(const memory_account&) = delete;
+	memory_account& operator=(const memory_account&) = delete;
+
+	void add(size_t bytes) noexcept
+	{
+		const auto now = used_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		auto old_peak = peak_bytes.load(std::memory_order_relaxed);
+		while (now > old_peak
+				&& !peak_bytes.compare_exchange_weak(old_peak, now, std::memory_order_relaxed))
+		{
+		}
+	}
+	void release(size_t bytes) noexcept
+	{
+		used_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+	}
+
+	/// returns the bytes currently charged to the account.
+	size_t used() const noexcept { return used_bytes.load(std::memory_order_relaxed); }
+	/// returns the maximum of used() so far.
+	size_t peak() const noexcept { return peak_bytes.load(std::memory_order_relaxed); }
+
+	/// sets the bytes, above which buffers stop growing, unlimited disables the limit.
+	void set_soft_limit(size_t bytes) noexcept { limit.store(bytes, std::memory_order_relaxed); }
+	size_t soft_limit() const noexcept { return limit.load(std::memory_order_relaxed); }
+	bool over_soft_limit() const noexcept { return used() > soft_limit(); }
+
+private:
+	std::atomic<size_t> used_bytes{0};
+	std::atomic<size_t> peak_bytes{0};
+	std::atomic<size_t> limit;
+};
+
+/**
+ * \brief bytes a single owner has charged to a memory_account.
+ *
+ * update sets the bytes held by the owner, the difference to the last update is
+ * added to or released from the account. The destructor releases all bytes.
+ * A charge without account does nothing. A charge is used by a single thread at a time.
+ */
+class memory_charge
+{
+public:
+	memory_charge() = default;
+	explicit memory_charge(std::shared_ptr<memory_account> account, size_t bytes = 0)
+		: account_(std::move(account))
+	{
+		update(bytes);
+	}
+	memory_charge(memory_charge&& other) noexcept
+		: account_(std::move(other.account_)), bytes_(other.bytes_)
+	{
+		other.bytes_ = 0;
+	}
+	memory_charge& operator=(memory_charge&& other) noexcept
+	{
+		update(0);
+		account_ = std::move(other.account_);
+		bytes_ = other.bytes_;
+		other.bytes_ = 0;
+		return *this;
+	}
+	~memory_charge() { update(0); }
+
+	/// sets the bytes held by the owner.
+	void update(size_t bytes) noexcept
+	{
+		if (!account_ || bytes == bytes_)
+			return;
+		if (bytes > bytes_)
+			account_->add(bytes - bytes_);
+		else
+			account_->release(bytes_ - bytes);
+		bytes_ = bytes;
+	}
+
+	size_t bytes() const noexcept { return bytes_; }
+	/// returns true if the account is over its soft limit, false without account.
+	bool over_soft_limit() const noexcept { return account_ && account_->over_soft_limit(); }
+
+private:
+	std::shared_ptr<memory_account> account_;
+	size_t bytes_ = 0;
+};
+
+} // namespace thread
+} // namespace fc
+
+#endif /* SRC_SCHEDULER_MEMORY_ACCOUNT_HPP_ */
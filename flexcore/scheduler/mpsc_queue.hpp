@@ -0,0 +1,129 @@
+#ifndef SRC_THREADING_MPSC_QUEUE_HPP_
+#define SRC_THREADING_MPSC_QUEUE_HPP_
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace fc
+{
+namespace thread
+{
+
+/**
+ * \brief bounded lock-free queue with multiple producers and a single consumer.
+ *
+ * Every slot carries a sequence number, which tells producers and the consumer
+ * whether the slot is free or holds an element of the current round.
+ * Producers claim slots with a compare and swap on the tail,
+ * the consumer owns the head alone. Neither push nor pop allocates.
+ *
+ * \tparam T type of elements, needs to be default constructible and move assignable.
+ * \invariant capacity is a power of two.
+ */
+template<class T>
+class mpsc_queue
+{
+public:
+	/**
+	 * \param min_capacity capacity of the queue is min_capacity rounded up to a power of two.
+	 * \pre min_capacity > 0, throws std::invalid_argument otherwise.
+	 */
+	explicit mpsc_queue(size_t min_capacity)
+		: mask(round_up(min_capacity) - 1)
+		, slots(std::make_unique<slot[]>(mask + 1))
+	{
+		for (size_t i = 0; i <= mask; ++i)
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	mpsc_queue(const mpsc_queue&) = delete;
+	mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+	/**
+	 * \brief appends value, can be called from any thread.
+	 * \returns false if the queue is full, value is not moved from in that case.
+	 */
+	bool push(T& value)
+	{
+		auto position = tail.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			auto& s = slots[position & mask];
+			const auto sequence = s.sequence.load(std::memory_order_acquire);
+			const auto difference =
+					static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+			if (difference == 0)
+			{
+				if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					s.value = std::move(value);
+					s.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				return false; // slot still holds an element of the last round.
+			}
+			else
+			{
+				position = tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/**
+	 * \brief removes the oldest element, must only be called by the consumer.
+	 * \returns false if the queue is empty.
+	 */
+	bool pop(T& value)
+	{
+		auto& s = slots[head & mask];
+		const auto sequence = s.sequence.load(std::memory_order_acquire);
+		if (sequence != head + 1)
+			return false;
+		value = std::move(s.value);
+		s.sequence.store(head + mask + 1, std::memory_order_release);
+		++head;
+		return true;
+	}
+
+	size_t capacity() const noexcept { return mask + 1; }
+
+private:
+	static size_t round_up(size_t min_capacity)
+	{
+		if (min_capacity == 0)
+			throw std::invalid_argument("capacity of mpsc_queue needs to be positive");
+		size_t result = 1;
+		while (result < min_capacity)
+			result *= 2;
+		return result;
+	}
+
+	struct slot
+	{
+		std::atomic<size_t> sequence{0};
+		T value{};
+	};
+
+	const size_t mask;
+	std::unique_ptr<slot[]> slots;
+	// padding keeps producers and the consumer on different cache lines.
+	static constexpr size_t cache_line = 64;
+	char padding_before_tail[cache_line];
+	/// next position to push to, shared by all producers.
+	std::atomic<size_t> tail{0};
+	char padding_before_head[cache_line];
+	/// next position to pop from, only accessed by the consumer.
+	size_t head = 0;
+};
+
+} // namespace thread
+} // namespace fc
+
+#endif /* SRC_THREADING_MPSC_QUEUE_HPP_ */
@@ -0,0 +1,162 @@
+#include <flexcore/scheduler/numa.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace fc
+{
+namespace thread
+{
+
+namespace
+{
+/// MPOL_PREFERRED of linux/mempolicy.h, which is not installed everywhere.
+constexpr int preferred_policy = 1;
+
+int parse_number(const std::string& list, size_t& pos)
+{
+	if (pos == list.size() || !std::isdigit(static_cast<unsigned char>(list[pos])))
+		throw std::invalid_argument("malformed cpu list: " + list);
+	int result = 0;
+	while (pos != list.size() && std::isdigit(static_cast<unsigned char>(list[pos])))
+		result = result * 10 + (list[pos++] - '0');
+	return result;
+}
+
+std::vector<numa_topology::node> read_nodes(const std::string& sysfs_root)
+{
+	std::vector<numa_topology::node> result;
+	DIR* dir = opendir(sysfs_root.c_str());
+	if (!dir)
+		return result;
+	while (const dirent* entry = readdir(dir))
+	{
+		const std::string name = entry->d_name;
+		if (name.size() <= 4 || name.compare(0, 4, "node") != 0
+				|| !std::all_of(name.begin() + 4, name.end(),
+						[](char c) { return std::isdigit(static_cast<unsigned char>(c)); }))
+			continue;
+		std::ifstream cpulist(sysfs_root + "/" + name + "/cpulist");
+		std::string list;
+		if (!std::getline(cpulist, list))
+			continue;
+		try
+		{
+			auto cpus = parse_cpu_list(list);
+			if (!cpus.empty())
+				result.push_back(numa_topology::node{std::stoi(name.substr(4)), std::move(cpus)});
+		}
+		catch (const std::exception&)
+		{
+			// nodes the kernel reports in an unknown format are left out.
+		}
+	}
+	closedir(dir);
+	std::sort(result.begin(), result.end(),
+			[](const numa_topology::node& l, const numa_topology::node& r) { return l.id < r.id; });
+	return result;
+}
+}
+
+numa_topology numa_topology::detect(const std::string& sysfs_root)
+{
+	numa_topology result{read_nodes(sysfs_root)};
+	if (result.nodes.empty())
+	{
+		node all{0, {}};
+		const int cpus = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+		for (int cpu = 0; cpu != cpus; ++cpu)
+			all.cpus.push_back(cpu);
+		result.nodes.push_back(std::move(all));
+	}
+	return result;
+}
+
+int numa_topology::node_of_cpu(int cpu) const
+{
+	for (const auto& n : nodes)
+		if (std::binary_search(n.cpus.begin(), n.cpus.end(), cpu))
+			return n.id;
+	return any_numa_node;
+}
+
+std::vector<int> parse_cpu_list(const std::string& list)
+{
+	std::vector<int> result;
+	size_t pos = 0;
+	// the kernel terminates the list with a newline, which getline already removed.
+	const auto end = list.find_last_not_of(" \n") + 1;
+	while (pos < end)
+	{
+		const int first = parse_number(list, pos);
+		int last = first;
+		if (pos != end && list[pos] == '-')
+			last = parse_number(list, ++pos);
+		if (last < first)
+			throw std::invalid_argument("malformed cpu list: " + list);
+		for (int cpu = first; cpu <= last; ++cpu)
+			result.push_back(cpu);
+		if (pos != end && list[pos++] != ',')
+			throw std::invalid_argument("malformed cpu list: " + list);
+	}
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+	return result;
+}
+
+thread_config numa_thread_config(const numa_topology& topology, int numa_node,
+		thread_config base)
+{
+	const auto node = std::find_if(topology.nodes.begin(), topology.nodes.end(),
+			[numa_node](const numa_topology::node& n) { return n.id == numa_node; });
+	if (node == topology.nodes.end())
+		throw std::invalid_argument("numa node " + std::to_string(numa_node) + " does not exist");
+	base.cpu_cores = node->cpus;
+	if (base.nr_of_threads == 0)
+		base.nr_of_threads = static_cast<int>(node->cpus.size());
+	base.worker_name = "node " + std::to_string(numa_node) + " worker";
+	return base;
+}
+
+void numa_memory_deleter::operator()(char* memory) const noexcept
+{
+	if (memory)
+		munmap(memory, size);
+}
+
+numa_memory allocate_on_numa_node(size_t size, int numa_node)
+{
+	size = std::max<size_t>(size, 1);
+	void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+		throw std::bad_alloc();
+	numa_memory result{static_cast<char*>(memory), numa_memory_deleter{size}};
+#ifdef SYS_mbind
+	constexpr int bits_per_word = sizeof(unsigned long) * CHAR_BIT;
+	if (numa_node >= 0 && numa_node < 16 * bits_per_word)
+	{
+		// pages are not touched yet, so the policy applies to all of them.
+		unsigned long mask[16] = {};
+		mask[numa_node / bits_per_word] = 1ul << (numa_node % bits_per_word);
+		// failure leaves the default policy, the preference is only a hint.
+		syscall(SYS_mbind, memory, size, preferred_policy, mask, 16 * bits_per_word + 1, 0);
+	}
+#else
+	(void)numa_node;
+#endif
+	return result;
+}
+
+} /* namespace thread */
+} /* namespace fc */
@@ -0,0 +1,82 @@
+#ifndef SRC_SCHEDULER_NUMA_HPP_
+#define SRC_SCHEDULER_NUMA_HPP_
+
+#include <flexcore/scheduler/threadconfig.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fc
+{
+namespace thread
+{
+
+/// numa node of regions and memory without a preferred node.
+constexpr int any_numa_node = -1;
+
+/**
+ * \brief cpus and memory nodes of the machine, as reported by the linux kernel.
+ *
+ * Machines without numa, or systems which do not report it in sysfs,
+ * are described by a single node 0 holding all hardware threads.
+ */
+struct numa_topology
+{
+	struct node
+	{
+		/// number of the node as used by the operating system.
+		int id;
+		/// cpus of the node, ascending.
+		std::vector<int> cpus;
+	};
+	/// nodes having at least one cpu, ascending by id.
+	std::vector<node> nodes;
+
+	/// reads the topology from sysfs_root, usually /sys/devices/system/node.
+	static numa_topology detect(const std::string& sysfs_root = "/sys/devices/system/node");
+
+	/// returns the node of cpu, any_numa_node if cpu is unknown.
+	int node_of_cpu(int cpu) const;
+};
+
+/**
+ * \brief parses a list of cpus in the kernel format, for example "0-3,8,10-11".
+ * \throws std::invalid_argument if list is malformed.
+ */
+std::vector<int> parse_cpu_list(const std::string& list);
+
+/**
+ * \brief returns base with its workers pinned to the cpus of numa_node.
+ *
+ * If base.nr_of_threads is 0, one worker per cpu of the node is started.
+ * Workers are named "node <id> worker <index>" in traces.
+ * \throws std::invalid_argument if topology has no node numa_node.
+ */
+thread_config numa_thread_config(const numa_topology& topology, int numa_node,
+		thread_config base = thread_config{});
+
+/// releases memory of allocate_on_numa_node.
+struct numa_memory_deleter
+{
+	size_t size = 0;
+	void operator()(char* memory) const noexcept;
+};
+using numa_memory = std::unique_ptr<char[], numa_memory_deleter>;
+
+/**
+ * \brief allocates size bytes of zeroed memory, whose pages prefer numa_node.
+ *
+ * The preference is a hint: if the kernel does not support memory policies,
+ * or the node has no memory left, pages are placed wherever the kernel sees fit.
+ * any_numa_node allocates with the default policy of the process.
+ * The memory is aligned to the size of a page.
+ * \throws std::bad_alloc if no memory can be mapped.
+ */
+numa_memory allocate_on_numa_node(size_t size, int numa_node);
+
+} /* namespace thread */
+} /* namespace fc */
+
+#endif /* SRC_SCHEDULER_NUMA_HPP_ */
@@ -0,0 +1,95 @@
+#include <flexcore/scheduler/numascheduler.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace fc
+{
+namespace thread
+{
+
+numa_scheduler::numa_scheduler(const numa_topology& topology, thread_config base)
+{
+	for (const auto& node : topology.nodes)
+	{
+		auto workers = std::make_unique<parallel_scheduler>(
+				numa_thread_config(topology, node.id, base));
+		const size_t size = workers->nr_of_threads();
+		pools.push_back(pool{node.id, nr_of_workers, std::move(workers), {}});
+		nr_of_workers += size;
+	}
+	assert(!pools.empty());
+}
+
+void numa_scheduler::add_task(task_t new_task)
+{
+	pools[next_pool++ % pools.size()].workers->add_task(std::move(new_task));
+}
+
+void numa_scheduler::add_affine_task(task_t new_task, size_t worker_hint)
+{
+	if (worker_hint == any_worker)
+		return add_task(std::move(new_task));
+	pools[pool_of_worker(worker_hint)].workers->add_task(std::move(new_task));
+}
+
+void numa_scheduler::add_tasks(std::vector<affine_task>& batch)
+{
+	std::lock_guard<std::mutex> lock(batch_mutex);
+	for (auto& t : batch)
+	{
+		auto& target = t.worker_hint == any_worker
+				? pools[next_pool++ % pools.size()] : pools[pool_of_worker(t.worker_hint)];
+		target.batch.push_back(std::move(t));
+	}
+	batch.clear();
+	for (auto& p : pools)
+		p.workers->add_tasks(p.batch);
+}
+
+void numa_scheduler::stop() noexcept
+{
+	for (auto& p : pools)
+		p.workers->stop();
+}
+
+size_t numa_scheduler::nr_of_waiting_tasks() const
+{
+	size_t result = 0;
+	for (const auto& p : pools)
+		result += p.workers->nr_of_waiting_tasks();
+	return result;
+}
+
+size_t numa_scheduler::worker_on_numa_node(int numa_node, size_t n) const
+{
+	for (const auto& p : pools)
+		if (p.numa_node == numa_node)
+			return p.first_worker + n % p.workers->nr_of_threads();
+	return n;
+}
+
+void numa_scheduler::set_trace(std::shared_ptr<trace_recorder> trace)
+{
+	for (auto& p : pools)
+		p.workers->set_trace(trace);
+}
+
+int numa_scheduler::numa_node_of_worker(size_t worker) const
+{
+	return pools[pool_of_worker(worker)].numa_node;
+}
+
+size_t numa_scheduler::pool_of_worker(size_t worker) const
+{
+	worker %= nr_of_workers;
+	// pools are sorted by their first worker, there are only a few of them.
+	const auto it = std::find_if(pools.rbegin(), pools.rend(),
+			[worker](const pool& p) { return p.first_worker <= worker; });
+	assert(it != pools.rend());
+	return static_cast<size_t>(pools.rend() - it) - 1;
+}
+
+} /* namespace thread */
+} /* namespace fc */
@@ -0,0 +1,78 @@
+#ifndef SRC_SCHEDULER_NUMASCHEDULER_HPP_
+#define SRC_SCHEDULER_NUMASCHEDULER_HPP_
+
+#include <flexcore/scheduler/numa.hpp>
+#include <flexcore/scheduler/parallelscheduler.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace fc
+{
+namespace thread
+{
+
+/**
+ * \brief scheduler with a pool of workers per numa node.
+ *
+ * Every node of the topology gets a parallel_scheduler of its own,
+ * whose workers are pinned to the cpus of the node, see numa_thread_config.
+ * Thus tasks never migrate between sockets and memory they touch first stays local.
+ *
+ * Workers are numbered consecutively across the pools, node by node.
+ * Tasks with a worker hint run in the pool of that worker, any worker of the pool may take them.
+ * Tasks without hint are spread round robin across the pools.
+ * cycle_control selects hints of the numa node of a region, see parallel_region::set_numa_node.
+ */
+class numa_scheduler : public scheduler
+{
+public:
+	/**
+	 * \brief starts a pool per node of topology.
+	 * \param base settings of every pool, nr_of_threads is per node,
+	 * 0 starts a worker per cpu of the node. cpu_cores are replaced by those of each node.
+	 * \throws std::system_error if the workers cannot be pinned.
+	 */
+	explicit numa_scheduler(const numa_topology& topology = numa_topology::detect(),
+			thread_config base = thread_config{});
+	numa_scheduler(const numa_scheduler&) = delete;
+
+	void add_task(task_t new_task) override;
+	void add_affine_task(task_t new_task, size_t worker_hint) override;
+	/// splits the batch by pool and adds every part with a single lock.
+	void add_tasks(std::vector<affine_task>& batch) override;
+	void stop() noexcept override;
+	size_t nr_of_waiting_tasks() const override;
+	size_t nr_of_threads() const override { return nr_of_workers; }
+	/// returns the n-th worker of the pool of numa_node, n if there is no such node.
+	size_t worker_on_numa_node(int numa_node, size_t n) const override;
+	void set_trace(std::shared_ptr<trace_recorder> trace) override;
+
+	/// returns the numa node the worker is pinned to.
+	int numa_node_of_worker(size_t worker) const;
+
+private:
+	struct pool
+	{
+		int numa_node;
+		/// index of the first worker of the pool.
+		size_t first_worker;
+		std::unique_ptr<parallel_scheduler> workers;
+		/// part of the batch of add_tasks, guarded by batch_mutex.
+		std::vector<affine_task> batch;
+	};
+	/// returns the index of the pool of worker, taken modulo the number of workers.
+	size_t pool_of_worker(size_t worker) const;
+
+	std::vector<pool> pools;
+	size_t nr_of_workers = 0;
+	std::atomic<size_t> next_pool{0};
+	std::mutex batch_mutex;
+};
+
+} /* namespace thread */
+} /* namespace fc */
+
+#endif /* SRC_SCHEDULER_NUMASCHEDULER_HPP_ */
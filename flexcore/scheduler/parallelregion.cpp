@@ -8,6 +8,9 @@
 #include <flexcore/scheduler/parallelregion.hpp>
 #include <flexcore/scheduler/cyclecontrol.hpp>
 
+#include <algorithm>
+#include <cassert>
+
 namespace fc
 {
 
@@ -26,19 +29,63 @@ virtual_clock::steady::duration parallel_region::get_duration() const
 	return tick_duration;
 }
 
-parallel_region::parallel_region(std::string id_, virtual_clock::steady::duration tick_rate) :
+parallel_region::parallel_region(std::string id_, virtual_clock::steady::duration tick_rate,
+		std::shared_ptr<clock_domain> clock) :
 		ticks(),
 		id({std::move(id_)}),
-		tick_duration(tick_rate)
+		tick_duration(tick_rate),
+		clock_(std::move(clock))
 {
+	assert(clock_);
 	static_assert(thread::cycle_control::slow_tick == std::chrono::seconds(1),
 			"Slow tick is not 1s, the default constructor parameter of parallel_region needs adaption");
 }
 
+timer_service& parallel_region::timers()
+{
+	if (!timers_)
+	{
+		timers_ = std::make_shared<timer_service>(tick_duration, clock_);
+		ticks.work_tick() >> [t = timers_]() { t->advance_to(t->clock().steady_now()); };
+	}
+	return *timers_;
+}
+
+region_checkpoints& parallel_region::enable_checkpoints(std::shared_ptr<checkpoint_file> file)
+{
+	assert(file);
+	assert(!checkpoints_);
+	checkpoints_ = std::make_shared<region_checkpoints>(std::move(file));
+	ticks.switch_tick() >> [c = checkpoints_]() { (*c)(); };
+	return *checkpoints_;
+}
+
+void parallel_region::add_buffer_elision(std::shared_ptr<buffer_elision> elision)
+{
+	assert(elision);
+	std::lock_guard<std::mutex> lock(elisions_->mutex);
+	auto& elisions = elisions_->elisions;
+	// forgets connections which are gone, so the list does not grow with reconnects.
+	elisions.erase(std::remove_if(elisions.begin(), elisions.end(),
+			[](const std::weak_ptr<buffer_elision>& e) { return e.expired(); }),
+			elisions.end());
+	elisions.push_back(std::move(elision));
+}
+
+std::vector<std::shared_ptr<buffer_elision>> parallel_region::buffer_elisions() const
+{
+	std::lock_guard<std::mutex> lock(elisions_->mutex);
+	std::vector<std::shared_ptr<buffer_elision>> result;
+	for (const auto& elision : elisions_->elisions)
+		if (auto alive = elision.lock())
+			result.push_back(std::move(alive));
+	return result;
+}
+
 std::shared_ptr<parallel_region>
 parallel_region::new_region(std::string name, virtual_clock::steady::duration tick_rate) const
 {
-	return std::make_shared<parallel_region>(std::move(name), tick_rate);
+	return std::make_shared<parallel_region>(std::move(name), tick_rate, clock_);
 }
 
 pure::event_source<void>& parallel_region::switch_tick()
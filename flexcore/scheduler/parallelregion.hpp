@@ -8,10 +8,23 @@
 #ifndef SRC_SCHEDULER_PARALLELREGION_HPP_
 #define SRC_SCHEDULER_PARALLELREGION_HPP_
 
+#include <flexcore/core/connection.hpp>
 #include <flexcore/pure/event_sources.hpp>
+#include <flexcore/scheduler/checkpoints.hpp>
 #include <flexcore/scheduler/clock.hpp>
+#include <flexcore/scheduler/memory_account.hpp>
+#include <flexcore/scheduler/numa.hpp>
+#include <flexcore/scheduler/scheduler.hpp>
+#include <flexcore/scheduler/switch_registry.hpp>
+#include <flexcore/scheduler/timer_service.hpp>
+#include <flexcore/scheduler/work_groups.hpp>
+#include <atomic>
+#include <functional>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace fc
 {
@@ -25,6 +38,27 @@ struct region_id
 
 bool operator==(const region_id& lhs, const region_id& rhs);
 
+/**
+ * \brief lets a connection between two regions bypass its buffer.
+ *
+ * Every buffered connection between regions registers one with its passive region.
+ * If the regions never run at the same time and share a tick rate, cycle_control elides
+ * the buffer: events are delivered directly and states pulled from their source,
+ * which saves the copy and the delay of a cycle.
+ * See thread::cycle_control::enable_buffer_elision.
+ */
+struct buffer_elision
+{
+	explicit buffer_elision(region_id active_region) : active(std::move(active_region)) {}
+
+	/// region of the active side of the connection, the event source or state sink.
+	const region_id active;
+	/// true while the buffer is bypassed, only changed while neither region runs.
+	std::atomic<bool> elided{false};
+	/// delivers the events still held by the buffer before it is bypassed, empty for states.
+	std::function<void()> flush;
+};
+
 /**
  * \brief class providing the interface to cyclic ticks for nodes.
  */
@@ -73,8 +107,16 @@ public:
 	static constexpr virtual_clock::steady::duration medium_tick = min_tick_length * 10;
 	static constexpr virtual_clock::steady::duration slow_tick = min_tick_length * 100;
 
+	/**
+	 * \param id name of the region.
+	 * \param duration tick of the region.
+	 * \param clock time of the simulation the region is part of,
+	 * needs to be the clock of the cycle_control which runs the region.
+	 * \pre clock != nullptr
+	 */
 	explicit parallel_region(std::string id,
-			virtual_clock::steady::duration duration);
+			virtual_clock::steady::duration duration,
+			std::shared_ptr<clock_domain> clock = clock_domain::global());
 
 	parallel_region(const parallel_region&) = delete;
 	parallel_region(parallel_region&&) = default;
@@ -84,13 +126,250 @@ public:
 	virtual_clock::steady::duration get_duration() const;
 	pure::event_source<void>& switch_tick();
 	pure::event_source<void>& work_tick();
-	/// Create new region from existing one.
+
+	/**
+	 * \brief adds action to the worker groups of the region, which run on its work tick.
+	 *
+	 * Unlike connecting to work_tick(), actions of the same type are stored together
+	 * and run in one loop, see work_groups.
+	 * \param owner identifies the worker for work_groups::set_components.
+	 * \param name name of the owner in profiles of the worker groups.
+	 * \returns handle which removes the worker, when it is destroyed.
+	 */
+	template<class action_t>
+	worker_handle add_worker(action_t&& action, const void* owner = nullptr, std::string name = {})
+	{
+		if (!workers_connected)
+		{
+			// the groups are shared, so moving the region does not invalidate the connection.
+			ticks.work_tick() >> [w = workers_](){ (*w)(); };
+			workers_connected = true;
+		}
+		return workers_->add(std::forward<action_t>(action), owner, std::move(name));
+	}
+	/// worker groups of the region, set a parallel policy to split them across threads.
+	work_groups& workers() { return *workers_; }
+	const work_groups& workers() const { return *workers_; }
+
+	/**
+	 * \brief adds the switch of buffer to the registry of the region, run on its switch tick.
+	 *
+	 * Unlike connecting to switch_tick(), the switches of all buffers are stored together
+	 * and run in one loop, see switch_registry. buffer_factory adds the buffers
+	 * of connections between regions.
+	 * \returns handle which removes the switch, when it is destroyed.
+	 */
+	template<class buffer_t>
+	switch_handle add_switch(buffer_t& buffer, switch_registry::phase phase)
+	{
+		if (!switches_connected)
+		{
+			// shared like the workers, so moving the region does not invalidate the connection.
+			ticks.switch_tick() >> [s = switches_](){ (*s)(); };
+			switches_connected = true;
+		}
+		return switches_->add(buffer, phase);
+	}
+	/// switches of the buffers registered with the region.
+	const switch_registry& buffer_switches() const { return *switches_; }
+
+	/**
+	 * \brief one-shot timers of the region, which fire on its work tick.
+	 *
+	 * The service is created on first use, with the tick of the region as resolution.
+	 * Timers fire before the work tick reaches connections made after that first use.
+	 * \see one_shot_timer for a node with ports.
+	 */
+	timer_service& timers();
+
+	/**
+	 * \brief lets nodes of the region write their state to file on its switch tick.
+	 *
+	 * Nodes add their state with checkpoint(), see region_checkpoints.
+	 * Several regions may share a file, as long as their keys differ.
+	 * \pre file != nullptr, checkpoints are not enabled yet.
+	 * \returns the checkpoints of the region.
+	 */
+	region_checkpoints& enable_checkpoints(std::shared_ptr<checkpoint_file> file);
+	/// checkpoints of the region, nullptr if they are not enabled.
+	region_checkpoints* checkpoints() const noexcept { return checkpoints_.get(); }
+
+	/// time of the simulation the region is part of, nodes read the virtual clock from here.
+	const clock_domain& clock() const noexcept { return *clock_; }
+	const std::shared_ptr<clock_domain>& shared_clock() const noexcept { return clock_; }
+
+	/**
+	 * \brief virtual time at the start of the current cycle of the region.
+	 *
+	 * Published by cycle_control with the switch tick, thus constant during the work tick.
+	 * Unlike clock().steady_now() nodes of different regions
+	 * do not share the cache line of the clock reading it.
+	 * Regions ticked without cycle_control need to call publish_cycle_time themselves.
+	 */
+	virtual_clock::steady::time_point cycle_time() const noexcept
+	{
+		return cycle_time_->load(std::memory_order_relaxed);
+	}
+	/// sets cycle_time, called by cycle_control before the switch tick of the region.
+	void publish_cycle_time(virtual_clock::steady::time_point now) noexcept
+	{
+		cycle_time_->store(now, std::memory_order_relaxed);
+	}
+
+	/**
+	 * \brief memory held by the nodes of the region and the buffers of connections into it.
+	 *
+	 * Nodes created by make_child and event_buffers charge it, other nodes can charge
+	 * their own storage with a thread::memory_charge of shared_memory_account.
+	 * Set a soft limit to let buffers drop events before the process runs out of memory.
+	 */
+	thread::memory_account& memory() const noexcept { return *memory_; }
+	const std::shared_ptr<thread::memory_account>& shared_memory_account() const noexcept
+	{
+		return memory_;
+	}
+
+	/// Create new region from existing one, with the same clock.
 	virtual std::shared_ptr<parallel_region> new_region(std::string name,
 	                                                    virtual_clock::steady::duration) const;
 
+	/**
+	 * \brief Pins the work of the region to a single worker of the scheduler.
+	 *
+	 * The work tick then runs on the same worker every cycle, as long as the worker is not busy.
+	 * \param worker index of the worker or thread::scheduler::any_worker,
+	 * if cycle_control is to choose one.
+	 */
+	void set_worker_affinity(size_t worker) { affinity = worker; }
+	/// worker the region prefers, thread::scheduler::any_worker if cycle_control chooses.
+	size_t worker_affinity() const { return affinity; }
+
+	/**
+	 * \brief assigns the region to a numa node.
+	 *
+	 * cycle_control then runs the work of the region on a worker of that node,
+	 * if its scheduler places workers on numa nodes, see thread::numa_scheduler.
+	 * Nodes created in the region by forest_owner are allocated on the node,
+	 * if the forest uses a node_arena.
+	 * An explicit worker affinity takes precedence.
+	 * \param node id of the numa node or thread::any_numa_node.
+	 */
+	void set_numa_node(int node) { numa_node_ = node; }
+	/// numa node of the region, thread::any_numa_node if it has none.
+	int numa_node() const { return numa_node_; }
+
+	/**
+	 * \brief sets the priority of the region, which is 0 by default.
+	 *
+	 * If not all regions can run at once, regions with higher priority are started first.
+	 * Regions with equal priority are started earliest deadline first.
+	 */
+	void set_priority(int new_priority) { priority_ = new_priority; }
+	int priority() const { return priority_; }
+
+	/**
+	 * \brief lets the region skip a cycle, if its work is not done when the next cycle is due.
+	 *
+	 * By default an overrun is reported to the timeout handler of cycle_control,
+	 * which stops the system. Best effort regions can set this to stay out of the way
+	 * of more important regions instead.
+	 */
+	void set_skip_on_overrun(bool skip) { skip_on_overrun_ = skip; }
+	bool skips_on_overrun() const { return skip_on_overrun_; }
+
+	/**
+	 * \brief marks the work of the region as realtime critical.
+	 *
+	 * While cycle_control checks realtime tasks, allocations and locks in the work tick
+	 * of the region are reported, see thread::cycle_control::enable_realtime_checks.
+	 * Switch ticks are not checked, buffers may grow and lock there.
+	 */
+	void set_realtime(bool realtime) { realtime_ = realtime; }
+	bool realtime() const { return realtime_; }
+
+	/**
+	 * \brief sets slower tick rates the region may run at, while cycle_control is overloaded.
+	 *
+	 * Rates faster than tick_duration or no multiple of the min tick of cycle_control
+	 * are ignored. Without acceptable rates the region always runs at its own rate.
+	 * \see thread::cycle_control::enable_throttling
+	 * \pre the region is not yet run by a cycle_control with throttling enabled.
+	 */
+	void set_acceptable_rates(std::vector<virtual_clock::steady::duration> rates)
+	{
+		acceptable_rates_ = std::move(rates);
+	}
+	const std::vector<virtual_clock::steady::duration>& acceptable_rates() const
+	{
+		return acceptable_rates_;
+	}
+
+	/**
+	 * \brief pauses the region from the next cycle on, can be called from any thread.
+	 *
+	 * cycle_control no longer sends switch or work ticks to a suspended region,
+	 * instead of gates on each port this costs nothing per event.
+	 * Buffers of connections into the region are frozen, events sent to it meanwhile are
+	 * kept as far as max_events and the overflow_policy of the buffers allow,
+	 * and delivered in the first cycle after resume. States stay at the last switched value.
+	 * A cycle which is running when suspend is called is finished first.
+	 */
+	void suspend() { suspended_->store(true); }
+	/// lets the region run again from the next cycle on, can be called from any thread.
+	void resume() { suspended_->store(false); }
+	/// returns true if the region is suspended or about to be.
+	bool suspended() const { return suspended_->load(); }
+
+	/**
+	 * \brief sends void event when cycle_control suspends the region.
+	 *
+	 * Sent from the thread of cycle_control once the last cycle before the suspension is done,
+	 * work of the region is not running at that time.
+	 */
+	pure::event_source<void>& suspend_tick() { return suspend_tick_; }
+	/// sends void event when cycle_control resumes the region, before its next switch tick.
+	pure::event_source<void>& resume_tick() { return resume_tick_; }
+
+	/// registers a buffered connection from another region into this one.
+	void add_buffer_elision(std::shared_ptr<buffer_elision> elision);
+	/// returns the buffered connections into the region, which still exist.
+	std::vector<std::shared_ptr<buffer_elision>> buffer_elisions() const;
+
 	tick_controller ticks;
 	region_id id;
 	const virtual_clock::steady::duration tick_duration;
+private:
+	std::shared_ptr<clock_domain> clock_;
+	size_t affinity = thread::scheduler::any_worker;
+	int numa_node_ = thread::any_numa_node;
+	int priority_ = 0;
+	bool skip_on_overrun_ = false;
+	bool realtime_ = false;
+	std::vector<virtual_clock::steady::duration> acceptable_rates_;
+	std::shared_ptr<work_groups> workers_ = std::make_shared<work_groups>();
+	bool workers_connected = false;
+	std::shared_ptr<switch_registry> switches_ = std::make_shared<switch_registry>();
+	bool switches_connected = false;
+	/// shared like the workers, so moving the region does not invalidate the connection.
+	std::shared_ptr<timer_service> timers_;
+	/// shared with the handles of the nodes, which may outlive the region.
+	std::shared_ptr<region_checkpoints> checkpoints_;
+	/// shared with the buffers and nodes charging it, which may outlive the region.
+	std::shared_ptr<thread::memory_account> memory_ = std::make_shared<thread::memory_account>();
+	/// on the heap, so the region stays movable.
+	std::unique_ptr<std::atomic<bool>> suspended_ = std::make_unique<std::atomic<bool>>(false);
+	std::unique_ptr<std::atomic<virtual_clock::steady::time_point>> cycle_time_ =
+			std::make_unique<std::atomic<virtual_clock::steady::time_point>>(
+					clock_->steady_now());
+	struct elision_list
+	{
+		std::mutex mutex;
+		std::vector<std::weak_ptr<buffer_elision>> elisions;
+	};
+	/// on the heap, so the region stays movable.
+	std::unique_ptr<elision_list> elisions_ = std::make_unique<elision_list>();
+	pure::event_source<void> suspend_tick_;
+	pure::event_source<void> resume_tick_;
 };
 
 } /* namespace fc */
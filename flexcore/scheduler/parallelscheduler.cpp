@@ -1,21 +1,37 @@
 #include <flexcore/scheduler/parallelscheduler.hpp>
+#include <flexcore/scheduler/trace.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <iterator>
+#include <limits>
+#include <string>
 #include <utility>
 
 namespace fc
 {
 namespace thread
 {
+namespace
+{
+/// tells the core the thread is spinning, which saves power and the sibling hyperthread.
+inline void cpu_relax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+}
+
 int parallel_scheduler::num_threads()
 {
-	const int nr = static_cast<int>(
-			std::max(1u ,std::thread::hardware_concurrency()));
+	const int nr = thread_config{}.resolved_nr_of_threads();
 	assert( nr >= 1);
 	return nr;
 }
 
-parallel_scheduler::parallel_scheduler() :
+parallel_scheduler::parallel_scheduler(thread_config conf) :
+		config(std::move(conf)),
 		thread_pool(),
 		do_work(false),
 		task_queue()
@@ -24,22 +40,30 @@ parallel_scheduler::parallel_scheduler() :
 }
 
 
-void parallel_scheduler::start() noexcept
+void parallel_scheduler::start()
 {
 	do_work = true;
 
 	//fill thread_pool in body of constructor,
 	//since otherwise threads would need to be copied
-	for (int i = 0, e = num_threads(); i != e; ++i)
+	if (config.lock_memory)
+		lock_process_memory();
+	const int nr_of_workers = config.resolved_nr_of_threads();
+	for (int i = 0; i != nr_of_workers; ++i)
 	{
 		thread_pool.push_back(std::thread(
 				//infinite task loop for every thread,
 				//looks for tasks in task_queue and executes them
-				[this] ()
+				[this, nr_of_workers, i] ()
 				{
+					prefault_stack(config.prefault_stack);
+					std::vector<queued_task> claimed_tasks;
+					// recorder this worker has named itself in.
+					trace_recorder* named_in = nullptr;
 					while (true)
 					{
-						task_t task;
+						++nr_of_idle;
+						spin_while_idle();
 						{
 							queue_lock lock(task_queue_mutex);
 							// Wait while task_queue is empty and do_work is true.
@@ -47,6 +71,7 @@ void parallel_scheduler::start() noexcept
 							// Still need to check which condition is true after the while loop.
 							while (task_queue.empty() && do_work)
 								thread_control.wait(lock);
+							--nr_of_idle;
 
 							if (!do_work)
 								return;
@@ -56,17 +81,80 @@ void parallel_scheduler::start() noexcept
 							assert(do_work);
 							assert(!task_queue.empty());
 
-							task = task_queue.front();
-							task_queue.pop();
+							// claim a fair share of the queued tasks at once,
+							// the other workers take care of the rest.
+							const size_t chunk = std::max<size_t>(
+									1, task_queue.size() / nr_of_workers);
+							for (size_t j = 0; j != chunk; ++j)
+							{
+								claimed_tasks.push_back(std::move(task_queue.front()));
+								task_queue.pop_front();
+							}
+							nr_of_claimed += chunk;
+							queue_changed();
+						}
+						auto* trace = current_trace.load(std::memory_order_acquire);
+						if (trace)
+						{
+							if (named_in != trace)
+							{
+								trace->name_this_thread(
+										config.worker_name + " " + std::to_string(i));
+								named_in = trace;
+							}
+							trace->begin(trace_run);
+						}
+						for (size_t j = 0; j != claimed_tasks.size(); ++j)
+						{
+							if (j != 0 && should_release(claimed_tasks[j].priority))
+							{
+								release(claimed_tasks, j);
+								break;
+							}
+							--nr_of_claimed;
+							if (claimed_tasks[j].task)
+								claimed_tasks[j].task();
 						}
-						if (task)
-							task();
+						claimed_tasks.clear();
+						if (trace)
+							trace->end(trace_run);
 					}
 				}));
+		try
+		{
+			apply_thread_config(thread_pool.back(), config, i);
+		}
+		catch (...)
+		{
+			//threads need to be joined before they are destroyed
+			stop();
+			throw;
+		}
 	}
 	assert(!thread_pool.empty()); //check invariant
 }
 
+void parallel_scheduler::spin_while_idle() const
+{
+	if (config.idle_spin.count() <= 0)
+		return;
+	const auto until = std::chrono::steady_clock::now() + config.idle_spin;
+	// the clock is read only every few spins, as reading it takes longer than a pause.
+	constexpr int spins_per_check = 64;
+	while (true)
+	{
+		for (int i = 0; i != spins_per_check; ++i)
+		{
+			if (nr_of_queued.load(std::memory_order_relaxed) != 0
+					|| !do_work.load(std::memory_order_relaxed))
+				return;
+			cpu_relax();
+		}
+		if (std::chrono::steady_clock::now() >= until)
+			return;
+	}
+}
+
 void parallel_scheduler::stop() noexcept
 {
 	//first stop the infinite loop in all threads
@@ -93,22 +181,88 @@ parallel_scheduler::~parallel_scheduler()
 	stop();
 }
 
+void parallel_scheduler::set_trace(std::shared_ptr<trace_recorder> new_trace)
+{
+	if (new_trace)
+		trace_run = new_trace->add_name("run tasks");
+	current_trace.store(new_trace.get(), std::memory_order_release);
+	trace = std::move(new_trace);
+}
+
 size_t parallel_scheduler::nr_of_waiting_tasks() const
 {
 	queue_lock lock(task_queue_mutex);
-	return task_queue.size();
+	return task_queue.size() + nr_of_claimed.load();
 }
 
 void parallel_scheduler::add_task(task_t new_task)
 {
 	{
 		queue_lock lock(task_queue_mutex);
-		task_queue.push(std::move(new_task));
+		enqueue(std::move(new_task), 0);
 	}
 	thread_control.notify_one();
 	assert(!thread_pool.empty()); //check invariant
 }
 
+void parallel_scheduler::add_tasks(std::vector<affine_task>& batch)
+{
+	{
+		queue_lock lock(task_queue_mutex);
+		for (auto& t : batch)
+			enqueue(std::move(t.task), t.priority);
+	}
+	if (batch.size() == 1)
+		thread_control.notify_one();
+	else if (!batch.empty())
+		thread_control.notify_all();
+	batch.clear();
+	assert(!thread_pool.empty()); //check invariant
+}
+
+void parallel_scheduler::enqueue(task_t new_task, int priority)
+{
+	// search from the back, as most tasks share the same priority.
+	auto pos = task_queue.end();
+	while (pos != task_queue.begin() && std::prev(pos)->priority < priority)
+		--pos;
+	task_queue.insert(pos, queued_task{std::move(new_task), priority});
+	queue_changed();
+}
+
+void parallel_scheduler::queue_changed() noexcept
+{
+	nr_of_queued.store(task_queue.size(), std::memory_order_relaxed);
+	highest_queued_priority.store(task_queue.empty()
+			? std::numeric_limits<int>::min() : task_queue.front().priority,
+			std::memory_order_relaxed);
+}
+
+bool parallel_scheduler::should_release(int priority) const noexcept
+{
+	if (nr_of_queued.load(std::memory_order_relaxed) != 0)
+		return highest_queued_priority.load(std::memory_order_relaxed) > priority;
+	return nr_of_idle.load(std::memory_order_relaxed) != 0;
+}
+
+void parallel_scheduler::release(std::vector<queued_task>& claimed, size_t first)
+{
+	{
+		queue_lock lock(task_queue_mutex);
+		// claimed tasks were queued before all waiting tasks of the same priority,
+		// thus they are put back in front of those, the last one first.
+		for (size_t j = claimed.size(); j != first; --j)
+		{
+			auto& t = claimed[j - 1];
+			const auto pos = std::find_if(task_queue.begin(), task_queue.end(),
+					[&t](const queued_task& q) { return q.priority <= t.priority; });
+			task_queue.insert(pos, std::move(t));
+		}
+		nr_of_claimed -= claimed.size() - first;
+		queue_changed();
+	}
+	thread_control.notify_all();
+}
 
 } /* namespace thread */
 } /* namespace fc */
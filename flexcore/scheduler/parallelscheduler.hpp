@@ -2,10 +2,14 @@
 #define SRC_SCHEDULER_PARALLELSCHEDULER_HPP_
 
 #include <flexcore/scheduler/scheduler.hpp>
+#include <flexcore/scheduler/threadconfig.hpp>
 
+#include <atomic>
+#include <limits>
+#include <memory>
 #include <thread>
 #include <vector>
-#include <queue>
+#include <deque>
 #include <condition_variable>
 #include <mutex>
 
@@ -18,34 +22,89 @@ namespace thread
  * \brief simple scheduler based on a threadpool
  *
  * Adds tasks a task queue. These tasks are then assigned to worker threads in a pool
+ * Workers take tasks in chunks of an equal share of the queued tasks,
+ * so a large batch does not require a lock per task.
+ * Claimed tasks, which have not started yet, count as waiting.
+ * They are put back into the queue, if a task of higher priority is queued
+ * or if other workers are idle while the queue is empty.
+ * The number of worker threads, their cpu affinity and priority are set by a thread_config,
+ * as well as how long idle workers spin for new tasks before they sleep.
  *
  * \invariant thread_pool.size() > 0
  */
 class parallel_scheduler : public scheduler
 {
 public:
+	/// returns the default number of worker threads, which is the number of hardware threads.
 	static int num_threads();
 
-	parallel_scheduler();
+	/**
+	 * \brief starts worker threads according to config.
+	 * \throws std::system_error if affinity or priority of config cannot be applied.
+	 */
+	explicit parallel_scheduler(thread_config config = thread_config{});
 	parallel_scheduler(const parallel_scheduler&) = delete;
 	~parallel_scheduler() override;
 
 	///adds a new task and notifies waiting threads.
 	void add_task(task_t new_task) override;
+	/**
+	 * \brief adds all tasks with a single lock and wakes all workers, worker hints are ignored.
+	 * Tasks are queued before all waiting tasks with lower priority.
+	 */
+	void add_tasks(std::vector<affine_task>& batch) override;
 	/// stops the work loop of all threads
 	void stop() noexcept override;
 	size_t nr_of_waiting_tasks() const override;
+	/// returns the number of worker threads in the pool.
+	size_t nr_of_threads() const override { return thread_pool.size(); }
+	/// workers record the chunks of tasks they run, named by thread_config::worker_name in the trace.
+	void set_trace(std::shared_ptr<trace_recorder> trace) override;
 
 private:
 	/// startes the work loop of all threads
-	void start() noexcept;
+	void start();
+	/// inserts task behind the last task with at least the same priority.
+	/// \pre task_queue_mutex is locked
+	void enqueue(task_t new_task, int priority);
+	/// spins until tasks are queued, the scheduler stops or the idle_spin of config is over.
+	void spin_while_idle() const;
+
+	struct queued_task
+	{
+		task_t task;
+		int priority;
+	};
+	/// updates the copies of queue state read without the lock.
+	/// \pre task_queue_mutex is locked
+	void queue_changed() noexcept;
+	/// true if claimed tasks of priority should be left to other workers.
+	bool should_release(int priority) const noexcept;
+	/// puts the claimed tasks from index first on back into the queue and wakes the workers.
+	void release(std::vector<queued_task>& claimed, size_t first);
+
+	thread_config config;
+
+	/// owns the recorder, workers read it through current_trace.
+	std::shared_ptr<trace_recorder> trace;
+	std::atomic<trace_recorder*> current_trace{nullptr};
+	uint32_t trace_run = 0;
 
 	std::vector<std::thread> thread_pool;
-	bool do_work; ///< flag indicates threads to keep working.
+	std::atomic<bool> do_work; ///< flag indicates threads to keep working.
 
 	// current implementation is simple and based on locking the task_queue,
 	//might be worthwhile exchanging it for a lockfree one.
-	std::queue<task_t> task_queue;
+	/// sorted by priority, tasks with equal priority in the order they were added.
+	std::deque<queued_task> task_queue;
+	/// size of task_queue, read by spinning workers without the lock.
+	std::atomic<size_t> nr_of_queued{0};
+	/// priority of the first task in task_queue, read by working workers without the lock.
+	std::atomic<int> highest_queued_priority{std::numeric_limits<int>::min()};
+	/// tasks claimed by workers, which have not started yet.
+	std::atomic<size_t> nr_of_claimed{0};
+	/// workers which look for or wait for tasks.
+	std::atomic<size_t> nr_of_idle{0};
 	mutable std::mutex task_queue_mutex;
 	using queue_lock = std::unique_lock<std::mutex>;
 	///used to notify worker threads if new tasks are available
@@ -0,0 +1,144 @@
+#include <flexcore/scheduler/realtime_checks.hpp>
+#include <flexcore/utils/logging/logger.hpp>
+
+#include <cassert>
+#include <utility>
+
+namespace fc
+{
+namespace thread
+{
+
+constexpr size_t realtime_checks::max_kept;
+
+namespace
+{
+/**
+ * \brief what the current thread executes, read by the hooks on every allocation.
+ * Plain pointers with constant initialization, so access needs neither allocation nor guard.
+ */
+struct thread_state
+{
+	realtime_checks* checks;
+	const std::string* task;
+	const std::string* node;
+	/// true while a violation is reported, suspends the checks of the thread.
+	bool reporting;
+};
+thread_local thread_state current{nullptr, nullptr, nullptr, false};
+
+std::atomic<bool> hooks{false};
+
+void report(realtime_violation::kind what, size_t bytes) noexcept
+{
+	if (!current.checks || current.reporting)
+		return;
+	current.reporting = true;
+	try
+	{
+		current.checks->report(realtime_violation{what, *current.task,
+				current.node ? *current.node : std::string{}, bytes});
+	}
+	catch (...)
+	{
+		// a violation which cannot be reported is still counted by the checks.
+	}
+	current.reporting = false;
+}
+} // namespace
+
+std::string to_string(const realtime_violation& violation)
+{
+	std::string result = violation.what == realtime_violation::kind::allocation
+			? "allocation of " + std::to_string(violation.bytes) + " bytes"
+			: std::string{"blocking lock"};
+	result += " in realtime task \"" + violation.task + "\"";
+	if (!violation.node.empty())
+		result += " by node \"" + violation.node + "\"";
+	return result;
+}
+
+realtime_checks::realtime_checks(handler_t new_handler)
+	: handler(std::move(new_handler))
+{
+	if (!handler)
+		handler = [](const realtime_violation& violation)
+		{
+			log_client{"realtime"}.write(to_string(violation), level::warning);
+		};
+}
+
+bool realtime_checks::hooks_installed() noexcept
+{
+	return hooks.load(std::memory_order_relaxed);
+}
+
+std::vector<realtime_violation> realtime_checks::violations() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return kept;
+}
+
+void realtime_checks::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	kept.clear();
+	total.store(0, std::memory_order_relaxed);
+}
+
+void realtime_checks::report(const realtime_violation& violation)
+{
+	total.fetch_add(1, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (kept.size() < max_kept)
+			kept.push_back(violation);
+	}
+	handler(violation);
+}
+
+namespace detail
+{
+
+realtime_scope::realtime_scope(realtime_checks& checks, const std::string& task) noexcept
+{
+	assert(!current.checks);
+	current.task = &task;
+	current.checks = &checks;
+}
+
+realtime_scope::~realtime_scope()
+{
+	current.checks = nullptr;
+	current.task = nullptr;
+}
+
+node_scope::node_scope(const std::string& full_name) noexcept
+	: previous(current.node)
+{
+	current.node = &full_name;
+}
+
+node_scope::~node_scope()
+{
+	current.node = previous;
+}
+
+void on_allocation(size_t bytes) noexcept
+{
+	report(realtime_violation::kind::allocation, bytes);
+}
+
+void on_lock() noexcept
+{
+	report(realtime_violation::kind::lock, 0);
+}
+
+void set_hooks_installed() noexcept
+{
+	hooks.store(true, std::memory_order_relaxed);
+}
+
+} // namespace detail
+} // namespace thread
+} // namespace fc
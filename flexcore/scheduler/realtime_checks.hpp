@@ -0,0 +1,125 @@
+#ifndef SRC_SCHEDULER_REALTIME_CHECKS_HPP_
+#define SRC_SCHEDULER_REALTIME_CHECKS_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace fc
+{
+namespace thread
+{
+
+/// heap allocation or blocking lock within the work of a realtime task.
+struct realtime_violation
+{
+	enum class kind
+	{
+		allocation,
+		lock
+	};
+	kind what;
+	/// name of the region of the task, empty for tasks without region.
+	std::string task;
+	/// full name of the node being executed, empty if the node is not known.
+	std::string node;
+	/// bytes requested by an allocation, zero for locks.
+	size_t bytes;
+};
+
+/// returns a line describing violation, as logged by the default handler.
+std::string to_string(const realtime_violation& violation);
+
+/**
+ * \brief detects heap allocations and blocking locks in the work of realtime tasks.
+ *
+ * A debug and staging mode, see cycle_control::enable_realtime_checks.
+ * While a task marked realtime executes its work, see parallel_region::set_realtime,
+ * every call of malloc, calloc, realloc, operator new and pthread_mutex_lock
+ * on the executing thread is a violation. Switch ticks are not checked.
+ * Violations name the node executing, if the graph tracks nodes,
+ * see connection_graph::enable_node_tracking, which usually is the node which allocates.
+ *
+ * The calls are only intercepted if the application links flexcore_realtime_hooks,
+ * which replaces the allocation functions and pthread_mutex_lock of the process
+ * by versions reporting here. Without the hooks nothing is detected, hooks_installed says so.
+ * Production builds leave out the hooks and with them all overhead.
+ *
+ * The handler is called on the thread of the violation, while checks are suspended,
+ * so it may allocate and lock. All methods can be called from any thread.
+ */
+class realtime_checks
+{
+public:
+	using handler_t = std::function<void(const realtime_violation&)>;
+
+	/// \param handler called on every violation, logs to channel "realtime" by default.
+	explicit realtime_checks(handler_t handler = {});
+
+	/// returns true if the process links flexcore_realtime_hooks.
+	static bool hooks_installed() noexcept;
+
+	/// returns the violations detected so far, at most max_kept of them.
+	std::vector<realtime_violation> violations() const;
+	/// returns the total number of violations, including those not kept.
+	size_t nr_of_violations() const noexcept { return total.load(std::memory_order_relaxed); }
+	/// forgets the violations detected so far.
+	void clear();
+
+	/// number of violations kept by violations(), later ones are only counted.
+	static constexpr size_t max_kept = 1024;
+
+	/// records violation and calls the handler, called by the hooks.
+	void report(const realtime_violation& violation);
+
+private:
+	handler_t handler;
+	mutable std::mutex mutex;
+	std::vector<realtime_violation> kept;
+	std::atomic<size_t> total{0};
+};
+
+namespace detail
+{
+/**
+ * \brief marks the work of a realtime task on the current thread, called by periodic_task.
+ * Nested scopes are not supported, the work of a task does not run other tasks.
+ */
+class realtime_scope
+{
+public:
+	realtime_scope(realtime_checks& checks, const std::string& task) noexcept;
+	realtime_scope(const realtime_scope&) = delete;
+	realtime_scope& operator=(const realtime_scope&) = delete;
+	~realtime_scope();
+};
+
+/// sets the node executed by the current thread for the lifetime of the scope.
+class node_scope
+{
+public:
+	explicit node_scope(const std::string& full_name) noexcept;
+	node_scope(const node_scope&) = delete;
+	node_scope& operator=(const node_scope&) = delete;
+	~node_scope();
+
+private:
+	const std::string* previous;
+};
+
+/// called by flexcore_realtime_hooks on every allocation, does nothing outside of scopes.
+void on_allocation(size_t bytes) noexcept;
+/// called by flexcore_realtime_hooks on every blocking lock.
+void on_lock() noexcept;
+/// called once by flexcore_realtime_hooks when the process starts.
+void set_hooks_installed() noexcept;
+} // namespace detail
+
+} // namespace thread
+} // namespace fc
+
+#endif /* SRC_SCHEDULER_REALTIME_CHECKS_HPP_ */
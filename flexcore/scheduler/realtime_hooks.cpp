@@ -0,0 +1,71 @@
+/**
+ * \file realtime_hooks.cpp
+ * \brief interposes allocation and locking of the process for thread::realtime_checks.
+ *
+ * Built as object library flexcore_realtime_hooks, only debug and staging builds add
+ * $<TARGET_OBJECTS:flexcore_realtime_hooks> to the sources of their executable.
+ * The functions forward to glibc and report to realtime_checks first,
+ * which does nothing on threads not executing a realtime task.
+ * operator new of libstdc++ allocates through malloc, so it needs no hook of its own.
+ */
+#include <flexcore/scheduler/realtime_checks.hpp>
+
+#include <dlfcn.h>
+#include <pthread.h>
+
+#include <atomic>
+#include <cstddef>
+
+namespace
+{
+using lock_t = int (*)(pthread_mutex_t*);
+/// pthread_mutex_lock of glibc, looked up on first use.
+std::atomic<lock_t> next_lock{nullptr};
+}
+
+extern "C"
+{
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size)
+{
+	fc::thread::detail::on_allocation(size);
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+	fc::thread::detail::on_allocation(count * size);
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+	fc::thread::detail::on_allocation(size);
+	return __libc_realloc(ptr, size);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+	// even uncontended locks are reported, as they may block once the load changes.
+	fc::thread::detail::on_lock();
+	auto next = next_lock.load(std::memory_order_relaxed);
+	if (!next)
+	{
+		// dlsym locks internally without pthread_mutex_lock, racing threads find the same.
+		next = reinterpret_cast<lock_t>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+		next_lock.store(next, std::memory_order_relaxed);
+	}
+	return next(mutex);
+}
+}
+
+namespace
+{
+struct install_hooks
+{
+	install_hooks() { fc::thread::detail::set_hooks_installed(); }
+} installed;
+}
@@ -1,19 +1,82 @@
 #ifndef SRC_THREADING_SCHEDULER_HPP_
 #define SRC_THREADING_SCHEDULER_HPP_
 
-#include <functional>
+#include <flexcore/scheduler/task.hpp>
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
 
 namespace fc
 {
 namespace thread
 {
+class trace_recorder;
+
 class scheduler
 {
 public:
-	using task_t = std::function<void(void)>;
+	/// move-only and allocation free, see unique_task.
+	using task_t = unique_task;
+	/// worker hint of tasks which can be executed by any worker.
+	static constexpr size_t any_worker = std::numeric_limits<size_t>::max();
+
 	virtual void add_task(task_t new_task) = 0;
+	/**
+	 * \brief adds a task which should preferably be executed by the worker worker_hint.
+	 *
+	 * Schedulers without a notion of individual workers ignore the hint,
+	 * which is the default implementation.
+	 * \param worker_hint index of preferred worker, taken modulo the number of workers.
+	 * any_worker if there is no preference.
+	 */
+	virtual void add_affine_task(task_t new_task, size_t /*worker_hint*/)
+	{
+		add_task(std::move(new_task));
+	}
+
+	/// a task together with the worker it should preferably be executed by.
+	struct affine_task
+	{
+		task_t task;
+		size_t worker_hint;
+		/// tasks with higher priority are executed first, if not all tasks can run at once.
+		int priority = 0;
+	};
+	/**
+	 * \brief adds a whole batch of tasks at once.
+	 *
+	 * Allows schedulers to publish all tasks with a single lock and wakeup.
+	 * Tasks are expected to be started in the order of the batch,
+	 * unless the scheduler orders them by priority itself.
+	 * The default implementation adds them one by one with add_affine_task.
+	 * \post batch is empty, its capacity may be reused by the caller for the next batch.
+	 */
+	virtual void add_tasks(std::vector<affine_task>& batch)
+	{
+		for (auto& t : batch)
+			add_affine_task(std::move(t.task), t.worker_hint);
+		batch.clear();
+	}
 	virtual void stop() = 0;
 	virtual size_t nr_of_waiting_tasks() const = 0;
+	/// returns the number of threads executing tasks, 1 for schedulers without a pool.
+	virtual size_t nr_of_threads() const { return 1; }
+	/**
+	 * \brief returns the n-th worker running on numa_node, as hint for add_affine_task.
+	 *
+	 * Schedulers which do not place their workers on numa nodes return n,
+	 * which is the default implementation.
+	 */
+	virtual size_t worker_on_numa_node(int /*numa_node*/, size_t n) const { return n; }
+	/**
+	 * \brief lets the workers record when they execute tasks to trace, nullptr stops it.
+	 * Ignored by schedulers without workers of their own, which is the default.
+	 * \pre no task is running.
+	 */
+	virtual void set_trace(std::shared_ptr<trace_recorder> /*trace*/) {}
 	virtual ~scheduler() = default;
 };
 } /* namespace thread */
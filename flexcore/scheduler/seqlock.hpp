@@ -0,0 +1,137 @@
+#ifndef SRC_THREADING_SEQLOCK_HPP_
+#define SRC_THREADING_SEQLOCK_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace fc
+{
+namespace thread
+{
+
+/**
+ * \brief value protected by a sequence lock, writers never block readers.
+ *
+ * The sequence is odd while a write is in progress and increased by two with each write.
+ * Readers copy the value and retry if the sequence changed meanwhile,
+ * which only happens if they overlap with a write.
+ * Writers are serialized among themselves by the sequence.
+ * The value is stored in atomic words, so concurrent copies are not a data race.
+ *
+ * \tparam T type of the value, needs to be trivially copyable.
+ */
+template<class T>
+class seqlock
+{
+	static_assert(std::is_trivially_copyable<T>{},
+			"seqlock copies values bytewise, thus needs trivially copyable types.");
+	static_assert(std::is_default_constructible<T>{},
+			"seqlock needs default constructible types.");
+
+public:
+	explicit seqlock(const T& initial_value = T{}) noexcept
+	{
+		store_words(initial_value);
+	}
+
+	seqlock(const seqlock&) = delete;
+	seqlock& operator=(const seqlock&) = delete;
+
+	/// replaces the value, can be called from any thread.
+	void store(const T& value) noexcept
+	{
+		auto current = sequence.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			// wait for other writers, odd sequences mark a write in progress.
+			if ((current & 1) == 0 && sequence.compare_exchange_weak(
+					current, current + 1, std::memory_order_acquire, std::memory_order_relaxed))
+				break;
+			current = sequence.load(std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+		store_words(value);
+		sequence.store(current + 2, std::memory_order_release);
+	}
+
+	/// returns a consistent copy of the value, can be called from any thread.
+	T load() const noexcept
+	{
+		uint64_t version_of_value = 0;
+		return load(version_of_value);
+	}
+
+	/// returns a consistent copy of the value and stores its version in version_of_value.
+	T load(uint64_t& version_of_value) const noexcept
+	{
+		T result;
+		version_of_value = load_into(result);
+		return result;
+	}
+
+	/**
+	 * \brief copies a consistent value into out and returns its version.
+	 * Copies directly into out, thus large values are not copied on the stack.
+	 */
+	uint64_t load_into(T& out) const noexcept
+	{
+		for (;;)
+		{
+			const auto before = sequence.load(std::memory_order_acquire);
+			if (before & 1)
+				continue;
+			// out might receive a torn value, which is overwritten by the next try.
+			load_words(out);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (sequence.load(std::memory_order_relaxed) == before)
+				return before / 2;
+		}
+	}
+
+	/// returns the number of values stored since construction.
+	uint64_t version() const noexcept
+	{
+		return sequence.load(std::memory_order_acquire) / 2;
+	}
+
+private:
+	using word_t = uint64_t;
+	static constexpr size_t nr_of_words = (sizeof(T) + sizeof(word_t) - 1) / sizeof(word_t);
+
+	void store_words(const T& value) noexcept
+	{
+		const auto* in = reinterpret_cast<const char*>(&value);
+		for (size_t i = 0; i != nr_of_words; ++i)
+		{
+			word_t word = 0;
+			std::memcpy(&word, in + i * sizeof(word_t), bytes_in_word(i));
+			words[i].store(word, std::memory_order_relaxed);
+		}
+	}
+
+	void load_words(T& out) const noexcept
+	{
+		auto* dest = reinterpret_cast<char*>(&out);
+		for (size_t i = 0; i != nr_of_words; ++i)
+		{
+			const word_t word = words[i].load(std::memory_order_relaxed);
+			std::memcpy(dest + i * sizeof(word_t), &word, bytes_in_word(i));
+		}
+	}
+
+	/// number of bytes of the value stored in word i, only the last word can be partial.
+	static constexpr size_t bytes_in_word(size_t i) noexcept
+	{
+		return i + 1 == nr_of_words ? sizeof(T) - i * sizeof(word_t) : sizeof(word_t);
+	}
+
+	std::atomic<uint64_t> sequence{0};
+	std::atomic<word_t> words[nr_of_words];
+};
+
+} // namespace thread
+} // namespace fc
+
+#endif /* SRC_THREADING_SEQLOCK_HPP_ */
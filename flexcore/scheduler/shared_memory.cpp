@@ -0,0 +1,93 @@
+#include <flexcore/scheduler/shared_memory.hpp>
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fc
+{
+namespace thread
+{
+
+namespace
+{
+[[noreturn]] void throw_errno(int error, const char* what)
+{
+	throw std::system_error(error, std::generic_category(), what);
+}
+}
+
+shared_segment::shared_segment(const std::string& name_, size_t size)
+	: name(name_), mapping_size(size), owner(true)
+{
+	// a segment left over from a crashed process is replaced.
+	::shm_unlink(name.c_str());
+	const int file = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (file < 0)
+		throw_errno(errno, "shared_segment could not create segment");
+	if (::ftruncate(file, static_cast<off_t>(size)) != 0)
+	{
+		const auto error = errno;
+		::close(file);
+		::shm_unlink(name.c_str());
+		throw_errno(error, "shared_segment could not resize segment");
+	}
+	map(file, "shared_segment could not map segment");
+}
+
+shared_segment::shared_segment(const std::string& name_)
+	: name(name_)
+{
+	const int file = ::shm_open(name.c_str(), O_RDWR, 0600);
+	if (file < 0)
+		throw_errno(errno, "shared_segment could not open segment");
+	struct stat info{};
+	if (::fstat(file, &info) != 0)
+	{
+		const auto error = errno;
+		::close(file);
+		throw_errno(error, "shared_segment could not read size of segment");
+	}
+	mapping_size = static_cast<size_t>(info.st_size);
+	map(file, "shared_segment could not map segment");
+}
+
+void shared_segment::map(int file, const char* what)
+{
+	void* mapped = ::mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	const auto error = errno;
+	::close(file);
+	if (mapped == MAP_FAILED)
+	{
+		if (owner)
+			::shm_unlink(name.c_str());
+		throw_errno(error, what);
+	}
+	mapping = mapped;
+}
+
+shared_segment::shared_segment(shared_segment&& other) noexcept
+	: name(std::move(other.name))
+	, mapping(other.mapping)
+	, mapping_size(other.mapping_size)
+	, owner(other.owner)
+{
+	other.mapping = nullptr;
+	other.owner = false;
+}
+
+shared_segment::~shared_segment()
+{
+	if (mapping)
+		::munmap(mapping, mapping_size);
+	if (owner)
+		::shm_unlink(name.c_str());
+}
+
+} // namespace thread
+} // namespace fc
@@ -0,0 +1,138 @@
+#ifndef SRC_THREADING_SHARED_MEMORY_HPP_
+#define SRC_THREADING_SHARED_MEMORY_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <type_traits>
+
+namespace fc
+{
+namespace thread
+{
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+		"data in shared memory is synchronized by lock-free, thus address-free, atomics.");
+
+/**
+ * \brief posix shared memory object mapped into the address space of the process.
+ *
+ * The creating process owns the name of the segment and removes it on destruction,
+ * processes which opened the segment keep their mapping until they destroy it.
+ */
+class shared_segment
+{
+public:
+	/**
+	 * \brief creates the segment name with size bytes, which are zero.
+	 * An existing segment of the same name is replaced.
+	 * \param name name of the segment, see man 3 shm_open, needs to start with a slash.
+	 * \throws std::system_error if the segment cannot be created or mapped.
+	 */
+	shared_segment(const std::string& name, size_t size);
+	/// opens the existing segment name. \throws std::system_error if it does not exist.
+	explicit shared_segment(const std::string& name);
+
+	shared_segment(shared_segment&& other) noexcept;
+	shared_segment(const shared_segment&) = delete;
+	shared_segment& operator=(const shared_segment&) = delete;
+	~shared_segment();
+
+	void* data() const noexcept { return mapping; }
+	size_t size() const noexcept { return mapping_size; }
+
+private:
+	void map(int file, const char* what);
+
+	std::string name;
+	void* mapping = nullptr;
+	size_t mapping_size = 0;
+	bool owner = false;
+};
+
+/**
+ * \brief bounded lock-free queue with a single producer and a single consumer,
+ * which lives in memory shared between processes.
+ *
+ * Only the two positions and the slots are stored, so the queue is constructed
+ * in place by placement new at the start of bytes_needed(capacity) bytes.
+ *
+ * \tparam T type of elements, needs to be trivially copyable.
+ * \invariant capacity is a power of two.
+ */
+template<class T>
+class spsc_ring
+{
+	static_assert(std::is_trivially_copyable<T>{},
+			"elements of spsc_ring are copied bytewise between processes.");
+public:
+	/// \pre capacity is a power of two.
+	explicit spsc_ring(size_t capacity) noexcept : mask(capacity - 1) {}
+
+	spsc_ring(const spsc_ring&) = delete;
+	spsc_ring& operator=(const spsc_ring&) = delete;
+
+	/// returns the size of the memory needed for a ring holding capacity elements.
+	static constexpr size_t bytes_needed(size_t capacity) noexcept
+	{
+		return slots_offset() + capacity * sizeof(T);
+	}
+
+	/// appends value, \returns false if the queue is full. Must only be called by the producer.
+	bool push(const T& value) noexcept
+	{
+		const auto t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) > mask)
+			return false;
+		std::memcpy(slots() + (t & mask), &value, sizeof(T));
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// removes the oldest element, \returns false if the queue is empty. Only for the consumer.
+	bool pop(T& value) noexcept
+	{
+		const auto h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire))
+			return false;
+		std::memcpy(&value, slots() + (h & mask), sizeof(T));
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t capacity() const noexcept { return mask + 1; }
+
+private:
+	static constexpr size_t cache_line = 64;
+	static constexpr size_t slots_offset() noexcept
+	{
+		return (sizeof(spsc_ring) + alignof(T) - 1) / alignof(T) * alignof(T);
+	}
+	T* slots() noexcept
+	{
+		return reinterpret_cast<T*>(reinterpret_cast<char*>(this) + slots_offset());
+	}
+
+	/// next position to push to, only written by the producer.
+	alignas(cache_line) std::atomic<uint64_t> tail{0};
+	/// next position to pop from, only written by the consumer.
+	alignas(cache_line) std::atomic<uint64_t> head{0};
+	alignas(cache_line) const uint64_t mask;
+};
+
+/// rounds capacity up to the next power of two, at least one.
+inline size_t round_up_to_power_of_two(size_t capacity) noexcept
+{
+	size_t result = 1;
+	while (result < capacity)
+		result *= 2;
+	return result;
+}
+
+} // namespace thread
+} // namespace fc
+
+#endif /* SRC_THREADING_SHARED_MEMORY_HPP_ */
@@ -0,0 +1,56 @@
+#ifndef SRC_SCHEDULER_SHARED_SCHEDULER_HPP_
+#define SRC_SCHEDULER_SHARED_SCHEDULER_HPP_
+
+#include <flexcore/scheduler/scheduler.hpp>
+
+#include <cassert>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace fc
+{
+namespace thread
+{
+
+/**
+ * \brief scheduler handing its tasks to a pool shared with other schedulers.
+ *
+ * Lets several cycle_control, which each own their scheduler, run on the same workers.
+ * With a work_stealing_scheduler as pool idle workers steal the tasks of every user.
+ * The pool does not belong to the shared_scheduler, stop leaves it running.
+ *
+ * \invariant pool != nullptr
+ */
+class shared_scheduler : public scheduler
+{
+public:
+	/// \pre pool != nullptr
+	explicit shared_scheduler(std::shared_ptr<scheduler> pool) : pool(std::move(pool))
+	{
+		assert(this->pool);
+	}
+
+	void add_task(task_t new_task) override { pool->add_task(std::move(new_task)); }
+	void add_affine_task(task_t new_task, size_t worker_hint) override
+	{
+		pool->add_affine_task(std::move(new_task), worker_hint);
+	}
+	void add_tasks(std::vector<affine_task>& batch) override { pool->add_tasks(batch); }
+	/// does nothing, the pool keeps running for its other users.
+	void stop() override {}
+	size_t nr_of_waiting_tasks() const override { return pool->nr_of_waiting_tasks(); }
+	size_t nr_of_threads() const override { return pool->nr_of_threads(); }
+	size_t worker_on_numa_node(int numa_node, size_t n) const override
+	{
+		return pool->worker_on_numa_node(numa_node, n);
+	}
+
+private:
+	std::shared_ptr<scheduler> pool;
+};
+
+} /* namespace thread */
+} /* namespace fc */
+
+#endif /* SRC_SCHEDULER_SHARED_SCHEDULER_HPP_ */
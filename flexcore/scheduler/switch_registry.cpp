@@ -0,0 +1,67 @@
+#include <flexcore/scheduler/switch_registry.hpp>
+
+#include <algorithm>
+#include <functional>
+
+namespace fc
+{
+
+void switch_handle::reset()
+{
+	// the registry is gone with its region, the switch went with it.
+	if (auto r = registry.lock())
+		r->remove(id);
+	registry.reset();
+}
+
+switch_handle switch_registry::add_entry(void* buffer, switch_fn switch_buffer)
+{
+	assert(buffer);
+	size_t id = positions.size();
+	if (!free_ids.empty())
+	{
+		id = free_ids.back();
+		free_ids.pop_back();
+	}
+	else
+	{
+		positions.push_back(0);
+	}
+	positions[id] = entries.size();
+	if (!entries.empty() && entries.back().switch_buffer != switch_buffer)
+		sorted = false;
+	entries.push_back(entry{buffer, switch_buffer, id});
+	return switch_handle{shared_from_this(), id};
+}
+
+void switch_registry::remove(size_t id)
+{
+	assert(id < positions.size());
+	const auto position = positions[id];
+	assert(position < entries.size() && entries[position].id == id);
+	// the last entry takes the place of the removed one, which may unsort them.
+	if (position + 1 != entries.size())
+	{
+		entries[position] = entries.back();
+		positions[entries[position].id] = position;
+		sorted = false;
+	}
+	entries.pop_back();
+	free_ids.push_back(id);
+}
+
+void switch_registry::sort_entries()
+{
+	// by buffer within a kind of switch, so buffers allocated together are visited in order.
+	std::sort(entries.begin(), entries.end(), [](const entry& lhs, const entry& rhs)
+			{
+				if (lhs.switch_buffer != rhs.switch_buffer)
+					return std::less<switch_fn>{}(lhs.switch_buffer, rhs.switch_buffer);
+				return std::less<void*>{}(lhs.buffer, rhs.buffer);
+			});
+	for (size_t i = 0; i != entries.size(); ++i)
+		positions[entries[i].id] = i;
+	sorted = true;
+}
+
+} // namespace fc
@@ -0,0 +1,138 @@
+#ifndef SRC_SCHEDULER_SWITCH_REGISTRY_HPP_
+#define SRC_SCHEDULER_SWITCH_REGISTRY_HPP_
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace fc
+{
+
+class switch_registry;
+
+/// removes its buffer from the switch_registry on destruction.
+class switch_handle
+{
+public:
+	switch_handle() = default;
+	switch_handle(std::weak_ptr<switch_registry> registry, size_t id)
+		: registry(std::move(registry)), id(id)
+	{
+	}
+	switch_handle(switch_handle&& other) noexcept { swap(other); }
+	switch_handle& operator=(switch_handle&& other) noexcept
+	{
+		reset();
+		swap(other);
+		return *this;
+	}
+	~switch_handle() { reset(); }
+
+	/// removes the buffer now, if it has not been removed yet.
+	void reset();
+
+private:
+	void swap(switch_handle& other) noexcept
+	{
+		std::swap(registry, other.registry);
+		std::swap(id, other.id);
+	}
+
+	std::weak_ptr<switch_registry> registry;
+	size_t id = 0;
+};
+
+/**
+ * \brief Switches of the buffers of a parallel_region, stored contiguously.
+ *
+ * A region with thousands of buffered connections would otherwise call thousands of
+ * std::function handlers connected to its switch tick one by one.
+ * The registry stores a pointer to each buffer and a plain function pointer
+ * to its switch in one vector and calls them in a loop.
+ * Entries are kept sorted by the kind of switch, so buffers of the same type
+ * follow each other and the calls are predicted.
+ * Buffers are thus not switched in the order they were added.
+ *
+ * Buffers provide switch_active_buffers, switch_passive_buffers
+ * and switch_active_passive_buffers, see event_buffer.
+ * Buffers must not be added or removed while the registry runs.
+ */
+class switch_registry : public std::enable_shared_from_this<switch_registry>
+{
+public:
+	/// which side of its connection a buffer switches on the tick of the region.
+	enum class phase
+	{
+		/// the region is the active side, the buffer switches its active-side buffers.
+		active,
+		/// the region is the passive side, the buffer switches its passive-side buffers.
+		passive,
+		/// both sides run at the tick of the region, the buffer switches all buffers at once.
+		active_passive
+	};
+
+	/**
+	 * \brief adds the switch of buffer for phase.
+	 * \returns handle which removes the buffer, when it is destroyed.
+	 * \pre buffer outlives the handle.
+	 */
+	template<class buffer_t>
+	switch_handle add(buffer_t& buffer, phase p)
+	{
+		switch_fn switch_buffer = nullptr;
+		switch (p)
+		{
+		case phase::active:
+			switch_buffer = [](void* b) { static_cast<buffer_t*>(b)->switch_active_buffers(); };
+			break;
+		case phase::passive:
+			switch_buffer = [](void* b) { static_cast<buffer_t*>(b)->switch_passive_buffers(); };
+			break;
+		case phase::active_passive:
+			switch_buffer = [](void* b)
+					{ static_cast<buffer_t*>(b)->switch_active_passive_buffers(); };
+			break;
+		}
+		assert(switch_buffer);
+		return add_entry(&buffer, switch_buffer);
+	}
+
+	/// Switches all buffers, connected to the switch tick by parallel_region.
+	void operator()()
+	{
+		if (!sorted)
+			sort_entries();
+		for (const auto& e : entries)
+			e.switch_buffer(e.buffer);
+	}
+
+	/// number of buffer switches registered.
+	size_t size() const noexcept { return entries.size(); }
+
+private:
+	friend class switch_handle;
+	using switch_fn = void (*)(void*);
+
+	switch_handle add_entry(void* buffer, switch_fn switch_buffer);
+	void remove(size_t id);
+	void sort_entries();
+
+	struct entry
+	{
+		void* buffer;
+		switch_fn switch_buffer;
+		size_t id;
+	};
+	std::vector<entry> entries;
+	/// index in entries by id of the entry.
+	std::vector<size_t> positions;
+	/// ids of removed entries, which are reused.
+	std::vector<size_t> free_ids;
+	bool sorted = true;
+};
+
+} // namespace fc
+
+#endif /* SRC_SCHEDULER_SWITCH_REGISTRY_HPP_ */
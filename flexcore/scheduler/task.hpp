@@ -0,0 +1,140 @@
+#ifndef SRC_SCHEDULER_TASK_HPP_
+#define SRC_SCHEDULER_TASK_HPP_
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace fc
+{
+namespace thread
+{
+
+/**
+ * \brief move-only callable without parameters and return value with inline storage.
+ *
+ * Replacement of std::function<void()> for tasks passed to schedulers.
+ * The callable is always stored inside the object, thus creating, moving and calling
+ * a unique_task never allocates memory.
+ * Callables larger than inline_capacity are rejected at compile time,
+ * lambdas capturing a few references or pointers fit easily.
+ *
+ * \invariant ops == nullptr if the task is empty.
+ */
+class unique_task
+{
+public:
+	/// maximum size of callables stored in a unique_task.
+	static constexpr size_t inline_capacity = 6 * sizeof(void*);
+
+	unique_task() noexcept = default;
+	unique_task(std::nullptr_t) noexcept {}
+
+	/**
+	 * \brief stores callable f inside the task.
+	 * \pre f is callable without parameters
+	 * \pre f fits into inline_capacity and can be moved without throwing.
+	 */
+	template<class F, class = std::enable_if_t<
+			!std::is_same<std::decay_t<F>, unique_task>{} &&
+			!std::is_same<std::decay_t<F>, std::nullptr_t>{}>>
+	unique_task(F&& f) // NOLINT implicit conversion from callables like std::function
+	{
+		using fun_t = std::decay_t<F>;
+		static_assert(sizeof(fun_t) <= inline_capacity,
+				"Callable is too large to be stored inline in unique_task");
+		static_assert(alignof(fun_t) <= alignof(storage_t),
+				"Callable needs stronger alignment than provided by unique_task");
+		static_assert(std::is_nothrow_move_constructible<fun_t>{},
+				"Callables stored in a unique_task need a nothrow move constructor");
+		new (&storage) fun_t(std::forward<F>(f));
+		ops = &operations<fun_t>::table;
+	}
+
+	unique_task(unique_task&& other) noexcept
+	{
+		move_from(other);
+	}
+
+	unique_task& operator=(unique_task&& other) noexcept
+	{
+		if (this != &other)
+		{
+			reset();
+			move_from(other);
+		}
+		return *this;
+	}
+
+	unique_task(const unique_task&) = delete;
+	unique_task& operator=(const unique_task&) = delete;
+
+	~unique_task() { reset(); }
+
+	/// returns true if the task holds a callable.
+	explicit operator bool() const noexcept { return ops != nullptr; }
+
+	/// \pre task is not empty
+	void operator()()
+	{
+		assert(ops);
+		ops->invoke(&storage);
+	}
+
+private:
+	using storage_t = std::aligned_storage_t<inline_capacity, alignof(std::max_align_t)>;
+
+	/// manual vtable, replaces virtual functions of the stored callable.
+	struct operation_table
+	{
+		void (*invoke)(void*);
+		void (*move)(void* from, void* to) noexcept;
+		void (*destroy)(void*) noexcept;
+	};
+
+	template<class fun_t>
+	struct operations
+	{
+		static void invoke(void* f) { (*static_cast<fun_t*>(f))(); }
+		static void move(void* from, void* to) noexcept
+		{
+			new (to) fun_t(std::move(*static_cast<fun_t*>(from)));
+		}
+		static void destroy(void* f) noexcept { static_cast<fun_t*>(f)->~fun_t(); }
+
+		static constexpr operation_table table{&invoke, &move, &destroy};
+	};
+
+	void reset() noexcept
+	{
+		if (ops)
+			ops->destroy(&storage);
+		ops = nullptr;
+	}
+
+	/// \pre this is empty \post other is empty
+	void move_from(unique_task& other) noexcept
+	{
+		assert(!ops);
+		if (other.ops)
+		{
+			other.ops->move(&other.storage, &storage);
+			other.ops->destroy(&other.storage);
+			ops = other.ops;
+			other.ops = nullptr;
+		}
+	}
+
+	storage_t storage;
+	const operation_table* ops = nullptr;
+};
+
+template<class fun_t>
+constexpr unique_task::operation_table unique_task::operations<fun_t>::table;
+
+} /* namespace thread */
+} /* namespace fc */
+
+#endif /* SRC_SCHEDULER_TASK_HPP_ */
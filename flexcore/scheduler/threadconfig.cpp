@@ -0,0 +1,79 @@
+#include <flexcore/scheduler/threadconfig.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <system_error>
+
+#include <alloca.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace fc
+{
+namespace thread
+{
+
+int thread_config::resolved_nr_of_threads() const
+{
+	if (nr_of_threads > 0)
+		return nr_of_threads;
+	return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+void apply_thread_config(std::thread& t, const thread_config& config, size_t worker_index)
+{
+	assert(t.joinable());
+	const auto handle = t.native_handle();
+
+	if (!config.cpu_cores.empty())
+	{
+		const int core = config.cpu_cores[worker_index % config.cpu_cores.size()];
+		if (core < 0 || core >= CPU_SETSIZE)
+			throw std::system_error(EINVAL, std::system_category(),
+					"cpu core of worker thread out of range");
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(core, &cpus);
+		const int err = pthread_setaffinity_np(handle, sizeof(cpus), &cpus);
+		if (err != 0)
+			throw std::system_error(err, std::system_category(),
+					"could not set cpu affinity of worker thread");
+	}
+
+	if (config.realtime_priority > 0)
+	{
+		sched_param param{};
+		param.sched_priority = config.realtime_priority;
+		const int policy =
+				config.policy == realtime_policy::round_robin ? SCHED_RR : SCHED_FIFO;
+		const int err = pthread_setschedparam(handle, policy, &param);
+		if (err != 0)
+			throw std::system_error(err, std::system_category(),
+					"could not set realtime priority of worker thread");
+	}
+}
+
+void lock_process_memory()
+{
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+		throw std::system_error(errno, std::system_category(),
+				"could not lock memory of process");
+}
+
+void prefault_stack(size_t bytes)
+{
+	if (bytes == 0)
+		return;
+	// released on return, the pages stay mapped to the thread.
+	volatile char* stack = static_cast<char*>(alloca(bytes));
+	const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	for (size_t i = 0; i < bytes; i += page)
+		stack[i] = 0;
+	stack[bytes - 1] = 0;
+}
+
+} /* namespace thread */
+} /* namespace fc */
@@ -0,0 +1,100 @@
+#ifndef SRC_SCHEDULER_THREADCONFIG_HPP_
+#define SRC_SCHEDULER_THREADCONFIG_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fc
+{
+namespace thread
+{
+
+/// scheduling class of threads with a realtime priority.
+enum class realtime_policy
+{
+	fifo, ///< SCHED_FIFO, runs until it blocks or a thread of higher priority is ready.
+	round_robin ///< SCHED_RR, shares the core with threads of the same priority.
+};
+
+/**
+ * \brief Settings for the worker threads of a scheduler.
+ *
+ * The default constructed config keeps the previous behaviour:
+ * one worker per hardware thread, no pinning and default scheduling.
+ */
+struct thread_config
+{
+	/// number of worker threads, 0 selects std::thread::hardware_concurrency().
+	int nr_of_threads = 0;
+	/**
+	 * \brief cpu cores worker threads are pinned to.
+	 *
+	 * worker i is pinned to cpu_cores[i % cpu_cores.size()].
+	 * If empty, threads are not pinned.
+	 */
+	std::vector<int> cpu_cores{};
+	/// if > 0 threads are run with policy at this priority.
+	int realtime_priority = 0;
+	realtime_policy policy = realtime_policy::fifo;
+	/**
+	 * \brief bytes of stack every thread touches when it starts, 0 touches none.
+	 *
+	 * Faults in the pages of the stack before the first tick,
+	 * so the first deep call in a tick does not wait for the kernel.
+	 * Together with lock_memory the pages stay resident.
+	 */
+	size_t prefault_stack = 0;
+	/**
+	 * \brief locks all current and future pages of the process in memory, before threads start.
+	 *
+	 * Affects the whole process and is not undone when the threads stop,
+	 * see lock_process_memory.
+	 */
+	bool lock_memory = false;
+	/// worker i is named "<worker_name> <i>" in traces.
+	std::string worker_name = "worker";
+	/**
+	 * \brief time idle workers of parallel_scheduler spin for new tasks before they sleep.
+	 *
+	 * Spinning saves the wake up of a sleeping thread at the start of every tick,
+	 * which takes several microseconds and more on virtualised hosts,
+	 * at the cost of a busy core while idle. A spin as long as the fastest tick
+	 * keeps the workers awake from one tick to the next.
+	 * Zero lets workers sleep immediately, which favours power efficiency.
+	 */
+	std::chrono::microseconds idle_spin{0};
+
+	/// returns number of threads to start, resolves nr_of_threads == 0.
+	/// \post result >= 1
+	int resolved_nr_of_threads() const;
+};
+
+/**
+ * \brief applies affinity and scheduling settings of config to thread.
+ * \param t thread to configure
+ * \param config settings to apply
+ * \param worker_index index of the thread in its pool, used to select the cpu core.
+ * \pre t.joinable()
+ * \throws std::system_error if the operating system rejects the settings.
+ */
+void apply_thread_config(std::thread& t, const thread_config& config, size_t worker_index);
+
+/**
+ * \brief locks all current and future pages of the process in memory, see man 2 mlockall.
+ *
+ * Pages are then never swapped out between ticks, memory mapped later is faulted in
+ * when it is mapped. Needs CAP_IPC_LOCK or a sufficient RLIMIT_MEMLOCK.
+ * \throws std::system_error if the operating system rejects the lock.
+ */
+void lock_process_memory();
+
+/// touches bytes of the stack of the calling thread, so its pages are faulted in.
+void prefault_stack(size_t bytes);
+
+} /* namespace thread */
+} /* namespace fc */
+
+#endif /* SRC_SCHEDULER_THREADCONFIG_HPP_ */
@@ -0,0 +1,186 @@
+#include <flexcore/scheduler/timer_service.hpp>
+
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+
+namespace fc
+{
+
+constexpr uint32_t timer_service::timer_id::invalid;
+constexpr size_t timer_service::slot_bits;
+constexpr size_t timer_service::slots_per_level;
+constexpr size_t timer_service::levels;
+constexpr int32_t timer_service::none;
+
+timer_service::timer_service(duration resolution, std::shared_ptr<const clock_domain> clock)
+	: timer_service(resolution, clock->steady_now(), clock)
+{
+}
+
+timer_service::timer_service(duration resolution, time_point start,
+		std::shared_ptr<const clock_domain> clock)
+	: tick_length(resolution)
+	, clock_(std::move(clock))
+	, current(0)
+{
+	assert(clock_);
+	if (resolution <= duration::zero())
+		throw std::invalid_argument("resolution of timer_service needs to be positive");
+	current = start.time_since_epoch() / tick_length;
+	for (auto& level : wheel)
+		level.fill(none);
+}
+
+int64_t timer_service::tick_of(time_point t) const
+{
+	// timers fire at the first tick at or after their expiry.
+	const auto since_epoch = t.time_since_epoch();
+	auto tick = since_epoch / tick_length;
+	if (since_epoch % tick_length > duration::zero())
+		++tick;
+	return tick;
+}
+
+timer_service::timer_id timer_service::schedule_at(time_point expiry, std::function<void()> action)
+{
+	uint32_t index = 0;
+	if (free_timers.empty())
+	{
+		index = static_cast<uint32_t>(timers.size());
+		timers.emplace_back();
+	}
+	else
+	{
+		index = free_timers.back();
+		free_timers.pop_back();
+	}
+	auto& t = timers[index];
+	t.action = std::move(action);
+	t.expiry = tick_of(expiry);
+	t.active = true;
+	++scheduled;
+	// the current tick has already been processed, expired timers fire on the next one.
+	insert(index, 1);
+	return timer_id{index, t.generation};
+}
+
+bool timer_service::is_scheduled(timer_id id) const noexcept
+{
+	return id.index < timers.size() && timers[id.index].active
+			&& timers[id.index].generation == id.generation;
+}
+
+bool timer_service::cancel(timer_id id)
+{
+	if (!is_scheduled(id))
+		return false;
+	unlink(id.index);
+	release(id.index);
+	return true;
+}
+
+void timer_service::insert(uint32_t index, int64_t min_delta)
+{
+	auto& t = timers[index];
+	auto delta = std::max(t.expiry - current, min_delta);
+	size_t level = 0;
+	while (level + 1 != levels
+			&& delta >= static_cast<int64_t>(1) << (slot_bits * (level + 1)))
+		++level;
+	// timers beyond the wheel wait in the last slot of the top level and are put back later.
+	const auto max_delta = (static_cast<int64_t>(1) << (slot_bits * levels)) - 1;
+	delta = std::min(delta, max_delta);
+	const auto slot = static_cast<size_t>(
+			((current + delta) >> (slot_bits * level)) & (slots_per_level - 1));
+
+	t.level = static_cast<uint8_t>(level);
+	t.slot = static_cast<uint8_t>(slot);
+	t.prev = none;
+	t.next = wheel[level][slot];
+	if (t.next != none)
+		timers[t.next].prev = static_cast<int32_t>(index);
+	wheel[level][slot] = static_cast<int32_t>(index);
+}
+
+void timer_service::unlink(uint32_t index)
+{
+	auto& t = timers[index];
+	if (t.level == levels)
+		return;
+	if (t.prev != none)
+		timers[t.prev].next = t.next;
+	else
+		wheel[t.level][t.slot] = t.next;
+	if (t.next != none)
+		timers[t.next].prev = t.prev;
+	t.level = levels;
+	t.prev = t.next = none;
+}
+
+void timer_service::release(uint32_t index)
+{
+	auto& t = timers[index];
+	t.action = nullptr;
+	t.active = false;
+	++t.generation;
+	--scheduled;
+	free_timers.push_back(index);
+}
+
+void timer_service::cascade(size_t level, size_t slot)
+{
+	auto index = wheel[level][slot];
+	wheel[level][slot] = none;
+	while (index != none)
+	{
+		const auto next = timers[index].next;
+		timers[index].level = levels;
+		// timers expiring now go to the slot of the current tick, which is fired next.
+		insert(static_cast<uint32_t>(index), 0);
+		index = next;
+	}
+}
+
+void timer_service::advance_to(time_point now)
+{
+	const auto target = now.time_since_epoch() / tick_length;
+	if (scheduled == 0)
+	{
+		current = std::max(current, target);
+		return;
+	}
+	while (current < target && scheduled != 0)
+	{
+		++current;
+		for (size_t level = 1; level != levels; ++level)
+		{
+			if (((current >> (slot_bits * (level - 1))) & (slots_per_level - 1)) != 0)
+				break;
+			cascade(level, (current >> (slot_bits * level)) & (slots_per_level - 1));
+		}
+
+		auto& slot = wheel[0][current & (slots_per_level - 1)];
+		for (auto index = slot; index != none; index = timers[index].next)
+			expired.push_back(timer_id{static_cast<uint32_t>(index), timers[index].generation});
+		for (const auto& id : expired)
+		{
+			timers[id.index].level = levels;
+			timers[id.index].prev = timers[id.index].next = none;
+		}
+		slot = none;
+		for (const auto& id : expired)
+		{
+			// earlier actions of this tick may have cancelled the timer.
+			if (!is_scheduled(id))
+				continue;
+			auto action = std::move(timers[id.index].action);
+			release(id.index);
+			action();
+		}
+		expired.clear();
+	}
+	current = std::max(current, target);
+}
+
+} /* namespace fc */
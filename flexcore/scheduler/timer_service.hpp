@@ -0,0 +1,117 @@
+#ifndef SRC_SCHEDULER_TIMER_SERVICE_HPP_
+#define SRC_SCHEDULER_TIMER_SERVICE_HPP_
+
+#include <flexcore/scheduler/clock.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace fc
+{
+
+/**
+ * \brief One-shot timers on the virtual clock, kept in a hierarchical timing wheel.
+ *
+ * Time is divided into ticks of resolution, timers fire on the first call of advance_to
+ * at or after their expiry, rounded up to the next tick.
+ * Every parallel_region owns a service advanced on its work tick, see parallel_region::timers.
+ *
+ * Scheduling and cancelling take constant time, advancing takes constant time per tick
+ * plus the expired timers. Timers far in the future are moved to lower levels of the wheel
+ * only a few times, idle timers cost nothing per tick. Without timers advancing does nothing.
+ *
+ * Actions may schedule and cancel timers, including themselves.
+ * Not thread safe, the service is used from the thread running its region.
+ */
+class timer_service
+{
+public:
+	using duration = virtual_clock::steady::duration;
+	using time_point = virtual_clock::steady::time_point;
+
+	/// identifies a scheduled timer, stays unique when the timer has fired or was cancelled.
+	struct timer_id
+	{
+		uint32_t index = invalid;
+		uint32_t generation = 0;
+		static constexpr uint32_t invalid = UINT32_MAX;
+	};
+
+	/**
+	 * \param resolution length of a tick, usually the tick of the region.
+	 * \param clock clock schedule measures delays on, the service starts at its current time.
+	 * \pre resolution > 0
+	 * \pre clock != nullptr
+	 */
+	explicit timer_service(duration resolution,
+			std::shared_ptr<const clock_domain> clock = clock_domain::global());
+	/// \param start time the service starts at.
+	timer_service(duration resolution, time_point start,
+			std::shared_ptr<const clock_domain> clock = clock_domain::global());
+
+	/// schedules action to run once, at the first tick at or after expiry.
+	timer_id schedule_at(time_point expiry, std::function<void()> action);
+	/// schedules action to run once, delay after the current time of clock().
+	timer_id schedule(duration delay, std::function<void()> action)
+	{
+		return schedule_at(clock_->steady_now() + delay, std::move(action));
+	}
+	/// cancels the timer, returns false if it has already fired or was cancelled.
+	bool cancel(timer_id id);
+	/// returns true if the timer is scheduled and has not fired yet.
+	bool is_scheduled(timer_id id) const noexcept;
+
+	/// runs the actions of all timers expired at now, tick by tick, in no order within a tick.
+	void advance_to(time_point now);
+
+	/// returns the number of scheduled timers.
+	size_t nr_of_timers() const noexcept { return scheduled; }
+	duration resolution() const noexcept { return tick_length; }
+	const clock_domain& clock() const noexcept { return *clock_; }
+
+private:
+	static constexpr size_t slot_bits = 6;
+	static constexpr size_t slots_per_level = size_t(1) << slot_bits;
+	static constexpr size_t levels = 4;
+	static constexpr int32_t none = -1;
+
+	struct timer
+	{
+		std::function<void()> action;
+		int64_t expiry = 0;
+		uint32_t generation = 0;
+		bool active = false;
+		/// position in the wheel, level == levels if the timer is in no slot.
+		uint8_t level = levels;
+		uint8_t slot = 0;
+		int32_t prev = none;
+		int32_t next = none;
+	};
+
+	int64_t tick_of(time_point t) const;
+	/// puts the timer into the slot for its expiry, expired timers into to the given slot.
+	void insert(uint32_t index, int64_t min_delta);
+	void unlink(uint32_t index);
+	/// moves the timers of a slot of a higher level to lower levels.
+	void cascade(size_t level, size_t slot);
+	void release(uint32_t index);
+
+	const duration tick_length;
+	std::shared_ptr<const clock_domain> clock_;
+	/// last tick processed by advance_to.
+	int64_t current;
+	std::vector<timer> timers;
+	std::vector<uint32_t> free_timers;
+	std::array<std::array<int32_t, slots_per_level>, levels> wheel;
+	size_t scheduled = 0;
+	/// timers taken from a slot while they are fired, reused between ticks.
+	std::vector<timer_id> expired;
+};
+
+} /* namespace fc */
+
+#endif /* SRC_SCHEDULER_TIMER_SERVICE_HPP_ */
@@ -0,0 +1,118 @@
+#include <flexcore/scheduler/timing.hpp>
+
+#include <algorithm>
+
+namespace fc
+{
+namespace thread
+{
+
+constexpr size_t histogram_snapshot::nr_of_buckets;
+constexpr size_t duration_histogram::nr_of_buckets;
+
+wall_clock::steady::duration histogram_snapshot::upper_bound(size_t bucket)
+{
+	if (bucket + 1 >= nr_of_buckets)
+		return wall_clock::steady::duration::max();
+	return std::chrono::duration_cast<wall_clock::steady::duration>(
+			std::chrono::microseconds(uint64_t{1} << bucket));
+}
+
+wall_clock::steady::duration histogram_snapshot::mean() const
+{
+	if (count == 0)
+		return wall_clock::steady::duration::zero();
+	return total / count;
+}
+
+histogram_snapshot& histogram_snapshot::operator+=(const histogram_snapshot& other)
+{
+	for (size_t i = 0; i != nr_of_buckets; ++i)
+		buckets[i] += other.buckets[i];
+	count += other.count;
+	total += other.total;
+	max = std::max(max, other.max);
+	return *this;
+}
+
+size_t duration_histogram::bucket_of(wall_clock::steady::duration d) noexcept
+{
+	auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+	size_t bucket = 0;
+	while (us > 0 && bucket + 1 < nr_of_buckets)
+	{
+		us >>= 1;
+		++bucket;
+	}
+	return bucket;
+}
+
+void duration_histogram::record(wall_clock::steady::duration d) noexcept
+{
+	d = std::max(d, wall_clock::steady::duration::zero());
+	// there is a single writer, relaxed increments are enough to not lose values.
+	buckets[bucket_of(d)].fetch_add(1, std::memory_order_relaxed);
+	total.fetch_add(d.count(), std::memory_order_relaxed);
+	if (d.count() > max.load(std::memory_order_relaxed))
+		max.store(d.count(), std::memory_order_relaxed);
+	count.fetch_add(1, std::memory_order_release);
+}
+
+void duration_histogram::reset() noexcept
+{
+	for (auto& bucket : buckets)
+		bucket.store(0, std::memory_order_relaxed);
+	total.store(0, std::memory_order_relaxed);
+	max.store(0, std::memory_order_relaxed);
+	count.store(0, std::memory_order_release);
+}
+
+histogram_snapshot duration_histogram::snapshot() const noexcept
+{
+	histogram_snapshot result;
+	result.count = count.load(std::memory_order_acquire);
+	for (size_t i = 0; i != nr_of_buckets; ++i)
+		result.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+	result.total = wall_clock::steady::duration(total.load(std::memory_order_relaxed));
+	result.max = wall_clock::steady::duration(max.load(std::memory_order_relaxed));
+	return result;
+}
+
+namespace
+{
+std::string microseconds(wall_clock::steady::duration d)
+{
+	return std::to_string(
+			std::chrono::duration_cast<std::chrono::microseconds>(d).count()) + "us";
+}
+
+std::string describe(const task_overrun& task)
+{
+	std::string result = "\"" + task.name + "\" (tick " + microseconds(task.tick)
+			+ ") late by " + microseconds(task.late_by);
+	if (task.running_for == task.running_for.zero())
+		return result + ", still queued";
+	return result + ", running for " + microseconds(task.running_for);
+}
+}
+
+std::string to_string(const overrun_report& report)
+{
+	std::string result = "task " + describe(report.task);
+	if (!report.workers.empty())
+	{
+		result += "\nworkers in last profiled cycle:";
+		for (const auto& worker : report.workers)
+			result += "\n  " + worker.name + " " + microseconds(worker.time);
+	}
+	if (!report.busy_tasks.empty())
+	{
+		result += "\nother tasks not done:";
+		for (const auto& task : report.busy_tasks)
+			result += "\n  " + describe(task);
+	}
+	return result;
+}
+
+} /* namespace thread */
+} /* namespace fc */
@@ -0,0 +1,129 @@
+#ifndef SRC_SCHEDULER_TIMING_HPP_
+#define SRC_SCHEDULER_TIMING_HPP_
+
+#include <flexcore/scheduler/clock.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fc
+{
+namespace thread
+{
+
+/// copy of the values of a duration_histogram at a single point in time.
+struct histogram_snapshot
+{
+	static constexpr size_t nr_of_buckets = 32;
+
+	/**
+	 * \brief returns the exclusive upper bound of the durations counted in bucket.
+	 * Bucket 0 counts durations below 1us, bucket i durations in [2^(i-1)us, 2^i us).
+	 * The last bucket counts all durations larger than that.
+	 */
+	static wall_clock::steady::duration upper_bound(size_t bucket);
+
+	/// returns the mean of all recorded durations, zero if none have been recorded.
+	wall_clock::steady::duration mean() const;
+	/// adds the durations counted in other, used to aggregate histograms of several sources.
+	histogram_snapshot& operator+=(const histogram_snapshot& other);
+
+	std::array<uint64_t, nr_of_buckets> buckets{};
+	uint64_t count = 0;
+	wall_clock::steady::duration total = wall_clock::steady::duration::zero();
+	wall_clock::steady::duration max = wall_clock::steady::duration::zero();
+};
+
+/**
+ * \brief histogram of durations with logarithmic buckets.
+ *
+ * Intended to be written by a single thread at a time and read by any thread.
+ * Recording takes no locks, snapshots can be taken while durations are recorded,
+ * they might then miss the most recent values.
+ */
+class duration_histogram
+{
+public:
+	static constexpr size_t nr_of_buckets = histogram_snapshot::nr_of_buckets;
+
+	duration_histogram() = default;
+	duration_histogram(const duration_histogram&) = delete;
+
+	/// adds d to the histogram, negative durations are recorded as zero.
+	void record(wall_clock::steady::duration d) noexcept;
+	histogram_snapshot snapshot() const noexcept;
+	/// removes all recorded durations. \pre no durations are recorded concurrently.
+	void reset() noexcept;
+
+	/// returns the index of the bucket d is counted in.
+	static size_t bucket_of(wall_clock::steady::duration d) noexcept;
+
+private:
+	using rep = wall_clock::steady::duration::rep;
+	std::array<std::atomic<uint64_t>, nr_of_buckets> buckets{};
+	std::atomic<uint64_t> count{0};
+	std::atomic<rep> total{0};
+	std::atomic<rep> max{0};
+};
+
+/// timing of a single periodic_task, as reported by cycle_control::timing.
+struct task_timing
+{
+	/// id of the region of the task, empty for tasks without region.
+	std::string name;
+	virtual_clock::steady::duration tick;
+	/// time spent executing the work of the task.
+	histogram_snapshot execution;
+	/// time between handing the task to the scheduler and the start of its execution.
+	histogram_snapshot queueing;
+	size_t skipped_cycles;
+};
+
+/// timings of all tasks of a cycle_control and of its main loop.
+struct timing_report
+{
+	std::vector<task_timing> tasks;
+	/// time by which cycles of the main loop exceeded their duration.
+	histogram_snapshot main_loop_overrun;
+};
+
+/// time spent by a single worker of a region in a profiled cycle, see work_groups.
+struct worker_timing
+{
+	/// name given when the worker was added, usually the full name of its node.
+	std::string name;
+	wall_clock::steady::duration time;
+};
+
+/// a task which was not done at the end of its cycle, see cycle_control::report_overrun.
+struct task_overrun
+{
+	/// id of the region of the task, empty for tasks without region.
+	std::string name;
+	virtual_clock::steady::duration tick;
+	/// time by which the task has passed the end of its cycle.
+	wall_clock::steady::duration late_by;
+	/// time since the task started executing, zero if it is still queued.
+	wall_clock::steady::duration running_for;
+};
+
+/// what a task overrunning its cycle and the rest of the system were doing at that time.
+struct overrun_report
+{
+	task_overrun task;
+	/// time of the workers of the region in its last profiled cycle, slowest first.
+	std::vector<worker_timing> workers;
+	/// other tasks which were not done at the time either, they shared the scheduler.
+	std::vector<task_overrun> busy_tasks;
+};
+
+/// returns a human readable multi line description of report.
+std::string to_string(const overrun_report& report);
+
+} /* namespace thread */
+} /* namespace fc */
+
+#endif /* SRC_SCHEDULER_TIMING_HPP_ */
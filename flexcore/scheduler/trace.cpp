@@ -0,0 +1,244 @@
+#include <flexcore/scheduler/trace.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ostream>
+
+namespace fc
+{
+namespace thread
+{
+
+namespace detail
+{
+namespace
+{
+std::atomic<uint64_t> next_rings_id{1};
+
+size_t power_of_two(size_t n)
+{
+	size_t result = 1;
+	while (result < n)
+		result <<= 1;
+	return result;
+}
+}
+
+/// events of a single thread, written only by that thread.
+struct event_rings::ring
+{
+	explicit ring(size_t size) : records(new record[size]) {}
+
+	struct record
+	{
+		std::atomic<uint64_t> event{0};
+		std::atomic<wall_clock::steady::rep> time{0};
+	};
+	std::unique_ptr<record[]> records;
+	/// number of events written so far, the newest ring_size are kept.
+	std::atomic<uint64_t> written{0};
+	/// guarded by the mutex of event_rings.
+	std::string thread_name;
+};
+
+event_rings::event_rings(size_t events_per_thread, bool overwrite)
+	: id(next_rings_id++), ring_size(power_of_two(events_per_thread)), overwrite(overwrite)
+{
+}
+
+event_rings::~event_rings() = default;
+
+event_rings::ring& event_rings::ring_of_this_thread()
+{
+	// threads usually record to a single set of rings, which is checked first.
+	thread_local std::vector<std::pair<uint64_t, ring*>> cache;
+	if (!cache.empty() && cache.back().first == id)
+		return *cache.back().second;
+	for (auto it = cache.begin(); it != cache.end(); ++it)
+	{
+		if (it->first != id)
+			continue;
+		std::swap(*it, cache.back());
+		return *cache.back().second;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	rings.push_back(std::make_unique<ring>(ring_size));
+	rings.back()->thread_name = "thread " + std::to_string(rings.size());
+	cache.emplace_back(id, rings.back().get());
+	return *rings.back();
+}
+
+void event_rings::record(uint64_t event) noexcept
+{
+	auto& r = ring_of_this_thread();
+	const auto i = r.written.load(std::memory_order_relaxed);
+	if (!overwrite && i >= ring_size)
+		return;
+	auto& entry = r.records[i & (ring_size - 1)];
+	entry.event.store(event, std::memory_order_relaxed);
+	entry.time.store(wall_clock::steady::now().time_since_epoch().count(),
+			std::memory_order_relaxed);
+	r.written.store(i + 1, std::memory_order_release);
+}
+
+void event_rings::name_this_thread(std::string name)
+{
+	auto& r = ring_of_this_thread();
+	std::lock_guard<std::mutex> lock(mutex);
+	r.thread_name = std::move(name);
+}
+
+std::vector<event_rings::thread_events> event_rings::snapshot() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<thread_events> result;
+	result.reserve(rings.size());
+	for (const auto& r : rings)
+	{
+		const auto end = r->written.load(std::memory_order_acquire);
+		const auto begin = end > ring_size ? end - ring_size : 0;
+		thread_events copied{r->thread_name, {}};
+		copied.events.reserve(end - begin);
+		for (auto i = begin; i != end; ++i)
+		{
+			const auto& entry = r->records[i & (ring_size - 1)];
+			copied.events.emplace_back(entry.event.load(std::memory_order_relaxed),
+					wall_clock::steady::time_point{wall_clock::steady::duration{
+							entry.time.load(std::memory_order_relaxed)}});
+		}
+		// events overwritten while copying, or being overwritten now, are dropped.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const auto now_written = r->written.load(std::memory_order_relaxed);
+		if (overwrite && now_written >= ring_size)
+		{
+			const auto first_valid = now_written - ring_size + 1;
+			if (first_valid > begin)
+				copied.events.erase(copied.events.begin(), copied.events.begin()
+						+ static_cast<std::ptrdiff_t>(std::min(first_valid, end) - begin));
+		}
+		result.push_back(std::move(copied));
+	}
+	return result;
+}
+} // namespace detail
+
+trace_recorder::trace_recorder(size_t events_per_thread, mode m)
+	: rings(events_per_thread, m == mode::flight_recorder)
+{
+}
+
+uint32_t trace_recorder::add_name(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(names_mutex);
+	const auto it = std::find(names.begin(), names.end(), name);
+	if (it != names.end())
+		return static_cast<uint32_t>(it - names.begin());
+	names.push_back(name);
+	return static_cast<uint32_t>(names.size() - 1);
+}
+
+trace_snapshot trace_recorder::snapshot() const
+{
+	trace_snapshot result;
+	// names are copied last, so they contain the names of all events copied.
+	for (auto& thread : rings.snapshot())
+	{
+		trace_snapshot::thread_trace trace{std::move(thread.thread_name), {}};
+		trace.events.reserve(thread.events.size());
+		for (const auto& e : thread.events)
+			trace.events.push_back(trace_event{static_cast<trace_event::phase>(e.first & 3),
+					static_cast<uint32_t>(e.first >> 2), e.second});
+		result.threads.push_back(std::move(trace));
+	}
+	std::lock_guard<std::mutex> lock(names_mutex);
+	result.names = names;
+	return result;
+}
+
+namespace
+{
+void write_json_string(std::ostream& stream, const std::string& str)
+{
+	stream << '"';
+	for (const char c : str)
+	{
+		switch (c)
+		{
+		case '"': stream << "\\\""; break;
+		case '\\': stream << "\\\\"; break;
+		case '\n': stream << "\\n"; break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20)
+				stream << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 0xf];
+			else
+				stream << c;
+		}
+	}
+	stream << '"';
+}
+
+const char* phase_name(trace_event::phase kind)
+{
+	switch (kind)
+	{
+	case trace_event::phase::begin: return "B";
+	case trace_event::phase::end: return "E";
+	case trace_event::phase::instant: return "i";
+	}
+	return "i";
+}
+}
+
+void write_chrome_trace(std::ostream& stream, const trace_snapshot& trace)
+{
+	auto origin = wall_clock::steady::time_point::max();
+	for (const auto& thread : trace.threads)
+		if (!thread.events.empty())
+			origin = std::min(origin, thread.events.front().time);
+
+	stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	const auto separate = [&stream, &first]()
+	{
+		if (!first)
+			stream << ',';
+		first = false;
+	};
+	for (size_t tid = 0; tid != trace.threads.size(); ++tid)
+	{
+		const auto& thread = trace.threads[tid];
+		separate();
+		stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << tid
+				<< ",\"args\":{\"name\":";
+		write_json_string(stream, thread.name);
+		stream << "}}";
+
+		size_t depth = 0;
+		for (const auto& e : thread.events)
+		{
+			if (e.kind == trace_event::phase::end && depth == 0)
+				continue;
+			if (e.kind == trace_event::phase::begin)
+				++depth;
+			else if (e.kind == trace_event::phase::end)
+				--depth;
+			char timestamp[32];
+			std::snprintf(timestamp, sizeof(timestamp), "%.3f",
+					std::chrono::duration<double, std::micro>(e.time - origin).count());
+			separate();
+			stream << "{\"name\":";
+			write_json_string(stream, e.name < trace.names.size()
+					? trace.names[e.name] : std::string{"unnamed"});
+			stream << ",\"cat\":\"flexcore\",\"ph\":\"" << phase_name(e.kind)
+					<< "\",\"ts\":" << timestamp << ",\"pid\":0,\"tid\":" << tid;
+			if (e.kind == trace_event::phase::instant)
+				stream << ",\"s\":\"t\"";
+			stream << '}';
+		}
+	}
+	stream << "]}\n";
+}
+
+} // namespace thread
+} // namespace fc
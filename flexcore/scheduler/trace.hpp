@@ -0,0 +1,162 @@
+#ifndef SRC_SCHEDULER_TRACE_HPP_
+#define SRC_SCHEDULER_TRACE_HPP_
+
+#include <flexcore/scheduler/clock.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fc
+{
+namespace thread
+{
+
+namespace detail
+{
+/**
+ * \brief rings of timestamped events, one per thread, written without locks.
+ *
+ * Every thread records to a ring of its own, which is allocated on its first event.
+ * Afterwards recording takes neither locks nor allocations,
+ * a timestamp and three relaxed atomic stores per event.
+ * Rings either keep the most recent events, or stop recording once full.
+ */
+class event_rings
+{
+public:
+	/// events kept by a ring, oldest first, with the name of its thread.
+	struct thread_events
+	{
+		std::string thread_name;
+		/// events as given to record and the time they were recorded.
+		std::vector<std::pair<uint64_t, wall_clock::steady::time_point>> events;
+	};
+
+	/**
+	 * \param events_per_thread size of every ring, rounded up to a power of two.
+	 * \param overwrite true if the oldest events are overwritten by new ones.
+	 */
+	event_rings(size_t events_per_thread, bool overwrite);
+	event_rings(const event_rings&) = delete;
+	event_rings& operator=(const event_rings&) = delete;
+	~event_rings();
+
+	void record(uint64_t event) noexcept;
+	/// names the ring of the calling thread, cold path.
+	void name_this_thread(std::string name);
+	/**
+	 * \brief copies the events of all rings, MT-safe.
+	 * Misses the events being written, as well as the oldest event of a full ring,
+	 * which might be overwritten while it is copied.
+	 */
+	std::vector<thread_events> snapshot() const;
+
+private:
+	struct ring;
+	ring& ring_of_this_thread();
+
+	/// distinguishes sets of rings in the caches of threads, even if they share an address.
+	const uint64_t id;
+	const size_t ring_size;
+	const bool overwrite;
+	mutable std::mutex mutex;
+	std::vector<std::unique_ptr<ring>> rings;
+};
+} // namespace detail
+
+/// a single event of a trace_snapshot.
+struct trace_event
+{
+	enum class phase
+	{
+		begin,
+		end,
+		instant
+	};
+	phase kind;
+	/// index of the name of the event in trace_snapshot::names.
+	uint32_t name;
+	wall_clock::steady::time_point time;
+};
+
+/// events recorded by trace_recorder, oldest first for every thread.
+struct trace_snapshot
+{
+	struct thread_trace
+	{
+		std::string name;
+		std::vector<trace_event> events;
+	};
+	std::vector<thread_trace> threads;
+	std::vector<std::string> names;
+};
+
+/**
+ * \brief flight recorder of the timeline of cycle_control and its scheduler.
+ *
+ * Records what every thread does as slices between begin and end and as instant events,
+ * see cycle_control::set_trace. Like the node_profiler, every thread records
+ * to a ring of its own without locks, which makes the recorder cheap enough
+ * to run all the time. A snapshot is taken on demand, for example after an overrun,
+ * and written with write_chrome_trace.
+ */
+class trace_recorder
+{
+public:
+	/// what happens to a full ring.
+	enum class mode
+	{
+		/// oldest events are overwritten, the ring keeps the recent past.
+		flight_recorder,
+		/// further events are dropped, the ring keeps the start of the trace.
+		until_full
+	};
+
+	explicit trace_recorder(size_t events_per_thread = 1 << 16, mode m = mode::flight_recorder);
+
+	/// returns the index of name for begin, end and instant, cold path.
+	uint32_t add_name(const std::string& name);
+	/// names the calling thread in the trace, cold path.
+	void name_this_thread(std::string name) { rings.name_this_thread(std::move(name)); }
+
+	/// begins a slice of the calling thread, slices of a thread nest.
+	void begin(uint32_t name) noexcept { record(trace_event::phase::begin, name); }
+	/// ends the innermost slice of the calling thread.
+	void end(uint32_t name) noexcept { record(trace_event::phase::end, name); }
+	/// records an event without duration.
+	void instant(uint32_t name) noexcept { record(trace_event::phase::instant, name); }
+
+	/// copies the events of all threads, MT-safe.
+	trace_snapshot snapshot() const;
+
+private:
+	void record(trace_event::phase kind, uint32_t name) noexcept
+	{
+		rings.record(static_cast<uint64_t>(name) << 2 | static_cast<uint64_t>(kind));
+	}
+
+	detail::event_rings rings;
+	mutable std::mutex names_mutex;
+	std::vector<std::string> names;
+};
+
+/**
+ * \brief writes trace in the JSON format of the Chrome trace viewer.
+ *
+ * The format is opened by chrome://tracing as well as by the Perfetto UI.
+ * Times are given in microseconds since the oldest event of the trace.
+ * Ends of slices which began before the oldest event kept are left out.
+ */
+void write_chrome_trace(std::ostream& stream, const trace_snapshot& trace);
+
+} // namespace thread
+} // namespace fc
+
+#endif /* SRC_SCHEDULER_TRACE_HPP_ */
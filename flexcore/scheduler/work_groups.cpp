@@ -0,0 +1,179 @@
+#include <flexcore/scheduler/work_groups.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+namespace fc
+{
+
+void worker_handle::reset()
+{
+	if (!group)
+		return;
+	// the groups are gone with their region, the worker went with them.
+	if (auto g = groups.lock())
+		g->remove(group, id);
+	groups.reset();
+	group = nullptr;
+}
+
+void work_groups::operator()()
+{
+	const bool profile = profile_every != 0 && --cycles_until_profile == 0;
+	if (profile)
+	{
+		cycles_until_profile = profile_every;
+		samples.assign(size(), wall_clock::steady::duration::zero());
+	}
+	if (component_pool)
+		run_components(profile);
+	else
+		run_groups(profile);
+	if (profile)
+		store_profile();
+}
+
+void work_groups::run_worker(
+		detail::work_group_base& group, size_t index, size_t slot, bool profile)
+{
+	if (!profile)
+	{
+		group.run(index, index + 1);
+		return;
+	}
+	const auto start = wall_clock::steady::now();
+	group.run(index, index + 1);
+	samples[slot] = wall_clock::steady::now() - start;
+}
+
+void work_groups::run_groups(bool profile)
+{
+	size_t offset = 0;
+	for (auto* group : order)
+	{
+		actions::detail::for_each_chunk(policy, group->size(),
+				[this, group, offset, profile](size_t, size_t begin, size_t end)
+				{
+					if (!profile)
+					{
+						group->run(begin, end);
+						return;
+					}
+					for (auto i = begin; i != end; ++i)
+						run_worker(*group, i, offset + i, true);
+				});
+		offset += group->size();
+	}
+}
+
+void work_groups::store_profile()
+{
+	std::vector<thread::worker_timing> result;
+	result.reserve(samples.size());
+	size_t slot = 0;
+	for (const auto* group : order)
+	{
+		for (size_t i = 0; i != group->size(); ++i, ++slot)
+		{
+			const auto name = names.find(group->owner(i));
+			result.push_back(thread::worker_timing{
+					name == names.end() ? std::string{"unnamed worker"} : name->second,
+					samples[slot]});
+		}
+	}
+	std::stable_sort(result.begin(), result.end(),
+			[](const thread::worker_timing& lhs, const thread::worker_timing& rhs)
+			{
+				return lhs.time > rhs.time;
+			});
+	std::lock_guard<std::mutex> lock(profile_mutex);
+	profile.swap(result);
+}
+
+std::vector<thread::worker_timing> work_groups::last_profile() const
+{
+	std::lock_guard<std::mutex> lock(profile_mutex);
+	return profile;
+}
+
+void work_groups::set_components(
+		std::map<const void*, size_t> component_of_owner, thread::scheduler& pool)
+{
+	components = std::move(component_of_owner);
+	component_pool = &pool;
+	nr_of_components_ = 0;
+	for (const auto& c : components)
+		nr_of_components_ = std::max(nr_of_components_, c.second + 1);
+	schedule_valid = false;
+}
+
+void work_groups::clear_components()
+{
+	components.clear();
+	component_pool = nullptr;
+	nr_of_components_ = 0;
+	schedule_valid = false;
+}
+
+std::vector<const void*> work_groups::owners() const
+{
+	std::vector<const void*> result;
+	for (const auto* group : order)
+		for (size_t i = 0; i != group->size(); ++i)
+			if (const auto* owner = group->owner(i))
+				result.push_back(owner);
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+	return result;
+}
+
+void work_groups::remove(detail::work_group_base* group, size_t id)
+{
+	if (const auto* owner = group->remove(id))
+		names.erase(owner);
+	schedule_valid = false;
+}
+
+void work_groups::update_schedule()
+{
+	unassigned.clear();
+	schedule.assign(nr_of_components_, {});
+	size_t slot = 0;
+	for (auto* group : order)
+	{
+		for (size_t i = 0; i != group->size(); ++i, ++slot)
+		{
+			const auto it = components.find(group->owner(i));
+			if (it == components.end())
+				unassigned.push_back(scheduled_worker{group, i, slot});
+			else
+				schedule[it->second].push_back(scheduled_worker{group, i, slot});
+		}
+	}
+	schedule_valid = true;
+}
+
+void work_groups::run_components(bool profile)
+{
+	if (!schedule_valid)
+		update_schedule();
+	for (const auto& w : unassigned)
+		run_worker(*w.group, w.index, w.slot, profile);
+	// every component is a chunk of its own at most, small ones are combined.
+	const actions::parallel_policy component_policy{component_pool, 2, 1};
+	actions::detail::for_each_chunk(component_policy, schedule.size(),
+			[this, profile](size_t, size_t begin, size_t end)
+			{
+				for (auto c = begin; c != end; ++c)
+					for (const auto& w : schedule[c])
+						run_worker(*w.group, w.index, w.slot, profile);
+			});
+}
+
+size_t work_groups::size() const noexcept
+{
+	return std::accumulate(order.begin(), order.end(), size_t(0),
+			[](size_t sum, const detail::work_group_base* group) { return sum + group->size(); });
+}
+
+} // namespace fc
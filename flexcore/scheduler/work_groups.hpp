@@ -0,0 +1,258 @@
+#ifndef SRC_SCHEDULER_WORK_GROUPS_HPP_
+#define SRC_SCHEDULER_WORK_GROUPS_HPP_
+
+#include <flexcore/range/parallel_actions.hpp>
+#include <flexcore/scheduler/clock.hpp>
+#include <flexcore/scheduler/timing.hpp>
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+namespace fc
+{
+
+namespace detail
+{
+/// type erased group of worker actions, one virtual call runs the whole group.
+class work_group_base
+{
+public:
+	virtual ~work_group_base() = default;
+	/// runs the workers [begin, end) of the group in order.
+	virtual void run(size_t begin, size_t end) = 0;
+	/// removes the worker with id and returns its owner.
+	virtual const void* remove(size_t id) = 0;
+	virtual size_t size() const noexcept = 0;
+	/// owner given when the worker at index was added.
+	virtual const void* owner(size_t index) const noexcept = 0;
+};
+
+/// workers of the same type, stored by value next to each other.
+template<class action_t>
+class work_group final : public work_group_base
+{
+public:
+	size_t add(action_t action, const void* owner)
+	{
+		workers.push_back(entry{next_id, owner, std::move(action)});
+		return next_id++;
+	}
+
+	void run(size_t begin, size_t end) override
+	{
+		for (auto i = begin; i != end; ++i)
+			workers[i].action();
+	}
+
+	const void* remove(size_t id) override
+	{
+		// actions like lambdas are not assignable, so the remaining ones are moved over.
+		const void* owner = nullptr;
+		std::vector<entry> remaining;
+		remaining.reserve(workers.size());
+		for (auto& e : workers)
+		{
+			if (e.id != id)
+				remaining.push_back(std::move(e));
+			else
+				owner = e.owner;
+		}
+		workers.swap(remaining);
+		return owner;
+	}
+
+	size_t size() const noexcept override { return workers.size(); }
+	const void* owner(size_t index) const noexcept override { return workers[index].owner; }
+
+private:
+	struct entry
+	{
+		size_t id;
+		const void* owner;
+		action_t action;
+	};
+	std::vector<entry> workers;
+	size_t next_id = 0;
+};
+} // namespace detail
+
+class work_groups;
+
+/// removes its worker from the work_groups on destruction.
+class worker_handle
+{
+public:
+	worker_handle() = default;
+	worker_handle(std::weak_ptr<work_groups> groups, detail::work_group_base* group, size_t id)
+		: groups(std::move(groups)), group(group), id(id)
+	{
+	}
+	worker_handle(worker_handle&& other) noexcept { swap(other); }
+	worker_handle& operator=(worker_handle&& other) noexcept
+	{
+		reset();
+		swap(other);
+		return *this;
+	}
+	~worker_handle() { reset(); }
+
+	/// removes the worker now, if it has not been removed yet.
+	void reset();
+
+private:
+	void swap(worker_handle& other) noexcept
+	{
+		std::swap(groups, other.groups);
+		std::swap(group, other.group);
+		std::swap(id, other.id);
+	}
+
+	std::weak_ptr<work_groups> groups;
+	detail::work_group_base* group = nullptr;
+	size_t id = 0;
+};
+
+/**
+ * \brief Worker actions of a parallel_region, grouped by their type.
+ *
+ * A region with thousands of worker nodes would otherwise call thousands of
+ * std::function handlers connected to its work tick one by one.
+ * work_groups stores actions of the same type contiguously by value
+ * and calls them in a loop, one virtual call per group.
+ * Groups run in the order their first worker was added, workers of a group in the order
+ * they were added. Workers of different types are thus not run in the order they were added.
+ *
+ * With a parallel policy set, the workers of large groups are split into chunks,
+ * which are run in parallel on the scheduler of the policy.
+ * Only use this if workers of the region do not depend on each other within a cycle.
+ *
+ * Alternatively, workers can be split by the components they belong to, see set_components.
+ * Components run in parallel, the workers of one component serially in their usual order.
+ *
+ * With profiling enabled, every n-th cycle the time of each worker is measured,
+ * see enable_profiling. Other cycles cost a single branch.
+ *
+ * Workers must not be added or removed while the groups are run.
+ */
+class work_groups : public std::enable_shared_from_this<work_groups>
+{
+public:
+	/// component of workers, whose owner is not in the map given to set_components.
+	static constexpr size_t no_component = static_cast<size_t>(-1);
+
+	/**
+	 * \brief adds action to the group of its type.
+	 * \param owner identifies the worker for set_components, usually the node of the action.
+	 * \param name name of the owner in profiles, usually the full name of the node.
+	 * \returns handle which removes the worker, when it is destroyed.
+	 */
+	template<class action_t>
+	worker_handle add(action_t action, const void* owner = nullptr, std::string name = {})
+	{
+		using group_t = detail::work_group<std::decay_t<action_t>>;
+		auto& group = groups[std::type_index(typeid(group_t))];
+		if (!group)
+		{
+			group = std::make_unique<group_t>();
+			order.push_back(group.get());
+		}
+		const auto id = static_cast<group_t&>(*group).add(std::move(action), owner);
+		schedule_valid = false;
+		if (owner && !name.empty())
+			names[owner] = std::move(name);
+		return worker_handle{shared_from_this(), group.get(), id};
+	}
+
+	/// Runs all workers, connected to the work tick by parallel_region.
+	void operator()();
+
+	/// sets the policy by which groups are split into chunks run in parallel.
+	void set_parallel_policy(const actions::parallel_policy& p) { policy = p; }
+
+	/**
+	 * \brief runs workers by component instead of by group.
+	 *
+	 * Components are sets of workers which do not depend on workers of other components
+	 * within a cycle, like connected components of the graph of the region.
+	 * Whole components run in parallel on pool, the workers of one component serially.
+	 * Workers with owners missing in component_of_owner run first, before all components.
+	 * The parallel policy is not used while components are set.
+	 *
+	 * \param component_of_owner index of component by owner of worker.
+	 */
+	void set_components(std::map<const void*, size_t> component_of_owner, thread::scheduler& pool);
+	/// runs workers by group again.
+	void clear_components();
+	/**
+	 * \brief measures the time of each worker every n-th cycle.
+	 * \param every_nth_cycle n, zero disables profiling.
+	 * \pre workers are not run concurrently.
+	 */
+	void enable_profiling(size_t every_nth_cycle)
+	{
+		profile_every = every_nth_cycle;
+		cycles_until_profile = 1;
+	}
+	/// returns the times of the workers in the last profiled cycle, slowest first, MT-safe.
+	std::vector<thread::worker_timing> last_profile() const;
+
+	/// distinct owners of all workers, without nullptr.
+	std::vector<const void*> owners() const;
+	/// number of components set, zero if workers run by group.
+	size_t nr_of_components() const noexcept { return nr_of_components_; }
+
+	/// number of workers in all groups.
+	size_t size() const noexcept;
+
+private:
+	friend class worker_handle;
+	void remove(detail::work_group_base* group, size_t id);
+
+	struct scheduled_worker
+	{
+		detail::work_group_base* group;
+		size_t index;
+		/// index in the order of all workers by group, used for profiles.
+		size_t slot;
+	};
+	/// runs worker index of group, measuring its time into slot if profiling this cycle.
+	void run_worker(detail::work_group_base& group, size_t index, size_t slot, bool profile);
+	void run_groups(bool profile);
+	void run_components(bool profile);
+	/// publishes the times measured in this cycle as last_profile.
+	void store_profile();
+	/// sorts the workers by component, after workers or components have changed.
+	void update_schedule();
+
+	actions::parallel_policy policy{nullptr};
+	std::map<const void*, size_t> components;
+	thread::scheduler* component_pool = nullptr;
+	size_t nr_of_components_ = 0;
+	bool schedule_valid = false;
+	/// workers without component, which run before the components.
+	std::vector<scheduled_worker> unassigned;
+	/// workers by component.
+	std::vector<std::vector<scheduled_worker>> schedule;
+
+	/// names of owners for profiles.
+	std::map<const void*, std::string> names;
+	size_t profile_every = 0;
+	size_t cycles_until_profile = 1;
+	/// times of the workers in the current profiled cycle, by slot.
+	std::vector<wall_clock::steady::duration> samples;
+	mutable std::mutex profile_mutex;
+	std::vector<thread::worker_timing> profile;
+	std::map<std::type_index, std::unique_ptr<detail::work_group_base>> groups;
+	/// groups in the order of their first worker.
+	std::vector<detail::work_group_base*> order;
+};
+
+} // namespace fc
+
+#endif /* SRC_SCHEDULER_WORK_GROUPS_HPP_ */
@@ -0,0 +1,239 @@
+#include <flexcore/scheduler/workstealingscheduler.hpp>
+
+#include <cassert>
+#include <utility>
+
+namespace fc
+{
+namespace thread
+{
+
+work_stealing_scheduler::work_stealing_scheduler(thread_config conf)
+	: config(std::move(conf))
+	, workers()
+	, thread_pool()
+	, do_work(false)
+	, pending_tasks(0)
+	, next_worker(0)
+{
+	for (int i = 0, e = config.resolved_nr_of_threads(); i != e; ++i)
+		workers.push_back(std::make_unique<worker_queue>());
+	start();
+}
+
+void work_stealing_scheduler::start()
+{
+	do_work = true;
+	if (config.lock_memory)
+		lock_process_memory();
+	for (size_t i = 0; i != workers.size(); ++i)
+	{
+		thread_pool.emplace_back([this, i]()
+		{
+			prefault_stack(config.prefault_stack);
+			work_loop(i);
+		});
+		try
+		{
+			apply_thread_config(thread_pool.back(), config, i);
+		}
+		catch (...)
+		{
+			//threads need to be joined before they are destroyed
+			stop();
+			throw;
+		}
+	}
+
+	assert(!workers.empty()); //check invariant
+	assert(workers.size() == thread_pool.size());
+}
+
+void work_stealing_scheduler::work_loop(size_t id)
+{
+	auto& own = *workers[id];
+	while (do_work)
+	{
+		task_t task;
+		if (try_get_task(id, task))
+		{
+			if (task)
+				task();
+			own.busy = false;
+		}
+		else
+			wait_for_tasks(id);
+	}
+}
+
+bool work_stealing_scheduler::try_get_task(size_t id, task_t& task)
+{
+	// own queue first, taken from the front to keep the order tasks were added in.
+	{
+		auto& own = *workers[id];
+		queue_lock lock(own.mtx);
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.front());
+			own.tasks.pop_front();
+			own.busy = true;
+			--pending_tasks;
+			const bool work_left = !own.tasks.empty();
+			lock.unlock();
+			// we are busy now, somebody else has to take care of the rest.
+			if (work_left)
+				wake_helper(id);
+			return true;
+		}
+	}
+	// steal from the back of the queues of busy workers, starting with the next neighbour
+	// to spread thieves over all victims.
+	for (size_t i = 1; i != workers.size(); ++i)
+	{
+		auto& victim = *workers[(id + i) % workers.size()];
+		if (!victim.busy)
+			continue;
+		queue_lock lock(victim.mtx, std::try_to_lock);
+		if (lock && !victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.back());
+			victim.tasks.pop_back();
+			workers[id]->busy = true;
+			--pending_tasks;
+			const bool work_left = !victim.tasks.empty();
+			lock.unlock();
+			if (work_left)
+				wake_helper(id);
+			return true;
+		}
+	}
+	return false;
+}
+
+void work_stealing_scheduler::wait_for_tasks(size_t id)
+{
+	// sleeping is set with the queue locked and push_task checks it with the queue locked.
+	// Thus either the worker sees the new task or push_task sees the sleeping worker.
+	// woken is set by wake_helper with the queue locked as well, even if the worker
+	// is still awake, thus a wake up is never lost.
+	auto& own = *workers[id];
+	queue_lock lock(own.mtx);
+	// tasks in other queues may have been added, while this worker was still looking
+	// for work, thus it needs to look again instead of sleeping on them.
+	if (own.tasks.empty() && !own.woken && pending_tasks.load() != 0)
+	{
+		lock.unlock();
+		std::this_thread::yield();
+		return;
+	}
+	own.sleeping = true;
+	while (own.tasks.empty() && !own.woken && do_work)
+		own.signal.wait(lock);
+	own.woken = false;
+	own.sleeping = false;
+}
+
+void work_stealing_scheduler::push_task(task_t new_task, size_t id)
+{
+	// an idle but awake target will take the task itself.
+	if (enqueue(std::move(new_task), id))
+		wake_helper(id);
+}
+
+bool work_stealing_scheduler::enqueue(task_t new_task, size_t id)
+{
+	auto& target = *workers[id];
+	++pending_tasks;
+	queue_lock lock(target.mtx);
+	target.tasks.push_back(std::move(new_task));
+	if (target.sleeping)
+	{
+		target.signal.notify_one();
+		return false;
+	}
+	return target.busy;
+}
+
+void work_stealing_scheduler::wake_helper(size_t id)
+{
+	for (size_t i = 1; i != workers.size(); ++i)
+	{
+		auto& helper = *workers[(id + i) % workers.size()];
+		// busy helpers look for tasks to steal, once they are done.
+		if (helper.busy)
+			continue;
+		// a helper which is about to sleep keeps the wake up and looks for tasks again.
+		queue_lock lock(helper.mtx);
+		if (!helper.woken)
+		{
+			helper.woken = true;
+			if (helper.sleeping)
+				helper.signal.notify_one();
+			return;
+		}
+	}
+}
+
+void work_stealing_scheduler::add_task(task_t new_task)
+{
+	assert(!workers.empty()); //check invariant
+	push_task(std::move(new_task), next_worker++ % workers.size());
+}
+
+void work_stealing_scheduler::add_affine_task(task_t new_task, size_t worker_hint)
+{
+	assert(!workers.empty()); //check invariant
+	if (worker_hint == any_worker)
+		add_task(std::move(new_task));
+	else
+		push_task(std::move(new_task), worker_hint % workers.size());
+}
+
+void work_stealing_scheduler::add_tasks(std::vector<affine_task>& batch)
+{
+	assert(!workers.empty()); //check invariant
+	// wake at most one helper for the whole batch, it wakes further helpers if needed.
+	size_t busy_target = any_worker;
+	for (auto& t : batch)
+	{
+		const size_t id = t.worker_hint == any_worker
+				? next_worker++ % workers.size()
+				: t.worker_hint % workers.size();
+		if (enqueue(std::move(t.task), id))
+			busy_target = id;
+	}
+	if (busy_target != any_worker)
+		wake_helper(busy_target);
+	batch.clear();
+}
+
+void work_stealing_scheduler::stop() noexcept
+{
+	do_work = false;
+	for (auto& worker : workers)
+	{
+		// lock is necessary, to not notify between check and wait of a worker.
+		queue_lock lock(worker->mtx);
+		worker->signal.notify_all();
+	}
+	for (auto& thread : thread_pool)
+	{
+		if (thread.joinable())
+			thread.join();
+	}
+	assert(!workers.empty()); //check invariant
+}
+
+work_stealing_scheduler::~work_stealing_scheduler()
+{
+	//first stop all threads, destroying running threads is illegal
+	stop();
+}
+
+size_t work_stealing_scheduler::nr_of_waiting_tasks() const
+{
+	return pending_tasks;
+}
+
+} /* namespace thread */
+} /* namespace fc */
@@ -0,0 +1,112 @@
+#ifndef SRC_SCHEDULER_WORKSTEALINGSCHEDULER_HPP_
+#define SRC_SCHEDULER_WORKSTEALINGSCHEDULER_HPP_
+
+#include <flexcore/scheduler/scheduler.hpp>
+#include <flexcore/scheduler/threadconfig.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fc
+{
+namespace thread
+{
+
+/**
+ * \brief scheduler based on a threadpool where every worker owns a task queue.
+ *
+ * New tasks are distributed round robin over the queues of the workers,
+ * unless they are added with a worker hint, then they are put in the queue of that worker.
+ * A worker takes tasks from the front of its own queue.
+ * If its own queue is empty, it steals tasks from the back of the queues of busy workers.
+ * Tasks queued for an idle worker are left to it, thus affine tasks stay on their worker
+ * unless that worker is occupied.
+ * Idle workers sleep on their own queue, there is no single lock
+ * shared by all workers and the thread adding tasks.
+ *
+ * Can be used as a drop-in replacement for parallel_scheduler.
+ * The number of worker threads, their cpu affinity and priority are set by a thread_config.
+ *
+ * \invariant workers.size() > 0
+ * \invariant workers.size() == thread_pool.size()
+ */
+class work_stealing_scheduler : public scheduler
+{
+public:
+	/**
+	 * \brief starts worker threads according to config.
+	 * \throws std::system_error if affinity or priority of config cannot be applied.
+	 */
+	explicit work_stealing_scheduler(thread_config config = thread_config{});
+	work_stealing_scheduler(const work_stealing_scheduler&) = delete;
+	~work_stealing_scheduler() override;
+
+	/// adds a new task to the queue of the next worker and wakes an idle worker.
+	void add_task(task_t new_task) override;
+	/// adds a new task to the queue of worker worker_hint % nr_of_threads().
+	void add_affine_task(task_t new_task, size_t worker_hint) override;
+	/// adds tasks to the queues of their workers and wakes at most one extra helper.
+	void add_tasks(std::vector<affine_task>& batch) override;
+	/// stops the work loop of all threads
+	void stop() noexcept override;
+	size_t nr_of_waiting_tasks() const override;
+	/// returns the number of worker threads in the pool.
+	size_t nr_of_threads() const override { return thread_pool.size(); }
+
+private:
+	/// task queue owned by a single worker, other workers may steal from it.
+	struct worker_queue
+	{
+		std::deque<task_t> tasks;
+		std::mutex mtx;
+		/// signals the owner of the queue, if it is sleeping.
+		std::condition_variable signal;
+		/// true while owner waits on signal, only written with mtx locked.
+		std::atomic<bool> sleeping{false};
+		/**
+		 * \brief owner was woken to help busy workers, guarded by mtx.
+		 * Also set while the owner is awake, its next wait then returns right away.
+		 */
+		bool woken{false};
+		/// true while owner executes a task, only busy workers are stolen from.
+		std::atomic<bool> busy{false};
+	};
+	using queue_lock = std::unique_lock<std::mutex>;
+
+	/// startes the work loop of all threads
+	void start();
+	/// infinite work loop of worker with index id.
+	void work_loop(size_t id);
+	/// try to get a task from own queue first, then from the queues of the other workers.
+	bool try_get_task(size_t id, task_t& task);
+	/// blocks worker id until it has tasks, is woken to help or the scheduler is stopped.
+	void wait_for_tasks(size_t id);
+	/// pushes task to queue of worker with index id and wakes a helper if necessary.
+	void push_task(task_t new_task, size_t id);
+	/**
+	 * \brief pushes task to queue of worker with index id and wakes it if it sleeps.
+	 * \return true if the worker is busy and a helper should be woken.
+	 */
+	bool enqueue(task_t new_task, size_t id);
+	/// wakes a single idle worker other than worker id to steal work.
+	void wake_helper(size_t id);
+
+	thread_config config;
+	std::vector<std::unique_ptr<worker_queue>> workers;
+	std::vector<std::thread> thread_pool;
+	std::atomic<bool> do_work; ///< flag indicates threads to keep working.
+	/// number of tasks which have been added, but not yet taken by a worker.
+	std::atomic<size_t> pending_tasks;
+	/// used to distribute new tasks round robin
+	std::atomic<size_t> next_worker;
+};
+
+} /* namespace thread */
+} /* namespace fc */
+
+#endif /* SRC_SCHEDULER_WORKSTEALINGSCHEDULER_HPP_ */
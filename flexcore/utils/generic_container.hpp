@@ -8,8 +8,13 @@
 #ifndef SRC_UTIL_GENERIC_CONTAINER_HPP_
 #define SRC_UTIL_GENERIC_CONTAINER_HPP_
 
-#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
 #include <memory>
+#include <new>
+#include <utility>
+#include <vector>
 
 namespace fc
 {
@@ -43,6 +48,174 @@ private:
 	std::vector<std::shared_ptr<void>> store;
 };
 
+namespace detail
+{
+/// address of id identifies T, without the overhead of typeid.
+template <class T>
+struct type_id
+{
+	static constexpr char id = 0;
+};
+template <class T>
+constexpr char type_id<T>::id;
+
+template <class T>
+void destroy_objects(void* objects, size_t count) noexcept
+{
+	auto typed = static_cast<T*>(objects);
+	while (count != 0)
+		typed[--count].~T();
+}
+
+/**
+ * \brief arena of objects of a single type, which is erased.
+ *
+ * Objects are stored in chunks of raw memory, which double in size up to max_chunk objects.
+ * Objects never move, chunks are freed together with the bucket.
+ */
+class typed_bucket
+{
+public:
+	using destroy_t = void (*)(void* objects, size_t count);
+
+	typed_bucket(const void* type, size_t object_size, destroy_t destroy)
+		: type(type), object_size(object_size), destroy(destroy)
+	{
+	}
+	typed_bucket(const typed_bucket&) = delete;
+	typed_bucket(typed_bucket&& other) noexcept
+		: type(other.type)
+		, object_size(other.object_size)
+		, destroy(other.destroy)
+		, chunks(std::move(other.chunks))
+	{
+	}
+	~typed_bucket()
+	{
+		// objects added later may refer to earlier ones, so they go first.
+		for (auto chunk = chunks.rbegin(); chunk != chunks.rend(); ++chunk)
+		{
+			destroy(chunk->memory, chunk->size);
+			::operator delete(chunk->memory);
+		}
+	}
+
+	/// returns memory for the next object, which is counted by commit.
+	void* slot()
+	{
+		if (chunks.empty() || chunks.back().size == chunks.back().capacity)
+		{
+			const size_t capacity = chunks.empty() ? first_chunk
+					: std::min(chunks.back().capacity * 2, size_t{max_chunk});
+			chunks.reserve(chunks.size() + 1);
+			chunks.push_back(chunk{::operator new(capacity * object_size), 0, capacity});
+		}
+		auto& last = chunks.back();
+		return static_cast<char*>(last.memory) + last.size * object_size;
+	}
+	/// counts the object constructed in the memory returned by slot.
+	void commit() noexcept
+	{
+		assert(!chunks.empty() && chunks.back().size < chunks.back().capacity);
+		++chunks.back().size;
+	}
+
+	size_t size() const noexcept
+	{
+		size_t result = 0;
+		for (const auto& chunk : chunks)
+			result += chunk.size;
+		return result;
+	}
+
+	const void* const type;
+
+	enum : size_t
+	{
+		first_chunk = 8,
+		max_chunk = 1024
+	};
+
+private:
+	struct chunk
+	{
+		void* memory;
+		size_t size;
+		size_t capacity;
+	};
+	const size_t object_size;
+	const destroy_t destroy;
+	std::vector<chunk> chunks;
+};
+} // namespace detail
+
+/**
+ * \brief stores arbitrary objects with their type erased, objects of the same type contiguously.
+ *
+ * Same interface as generic_container, intended for many small objects,
+ * like the connectables and nodes of a large graph.
+ * Instead of an allocation with its own control block per object,
+ * objects of each type are placed in chunks of an arena of that type.
+ * Thus add allocates only when a chunk is full, which happens less often the more
+ * objects of a type are added, and objects of the same type are close in memory.
+ * References to added objects stay valid until the container is destroyed.
+ *
+ * Objects are destroyed in reverse order of addition among their type,
+ * types in reverse order of the first addition of an object of that type.
+ * Types with an alignment larger than std::max_align_t are not supported.
+ */
+class typed_container
+{
+public:
+	typed_container() = default;
+	typed_container(const typed_container&) = delete;
+	typed_container& operator=(const typed_container&) = delete;
+
+	~typed_container()
+	{
+		while (!buckets.empty())
+			buckets.pop_back();
+	}
+
+	/// adds a new element and takes ownership of it.
+	template <class T, class... Args>
+	T& add(Args&&... args)
+	{
+		static_assert(alignof(T) <= alignof(std::max_align_t),
+				"typed_container does not support over-aligned types.");
+		auto& bucket = bucket_of(&detail::type_id<T>::id, sizeof(T), &detail::destroy_objects<T>);
+		auto object = new (bucket.slot()) T(std::forward<Args>(args)...);
+		bucket.commit();
+		return *object;
+	}
+
+	/// returns the number of objects held.
+	size_t size() const noexcept
+	{
+		size_t result = 0;
+		for (const auto& bucket : buckets)
+			result += bucket.size();
+		return result;
+	}
+
+private:
+	detail::typed_bucket& bucket_of(
+			const void* type, size_t object_size, detail::typed_bucket::destroy_t destroy)
+	{
+		// few types are held, usually many objects of a type are added in a row.
+		if (last < buckets.size() && buckets[last].type == type)
+			return buckets[last];
+		for (last = 0; last != buckets.size(); ++last)
+			if (buckets[last].type == type)
+				return buckets[last];
+		buckets.emplace_back(type, object_size, destroy);
+		return buckets.back();
+	}
+
+	std::vector<detail::typed_bucket> buckets;
+	size_t last = 0;
+};
+
 }
 
 #endif /* SRC_UTIL_GENERIC_CONTAINER_HPP_ */
@@ -0,0 +1,133 @@
+#ifndef SRC_UTILS_KEY_ROUTING_HPP_
+#define SRC_UTILS_KEY_ROUTING_HPP_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace fc
+{
+
+/**
+ * \brief Routing policies of nodes which keep ports by key,
+ * like n_ary_switch, pair_splitter and pair_joiner.
+ *
+ * All policies keep the addresses of ports stable, as connections refer to them.
+ */
+
+/// keeps ports in a std::map, keys need operator <. Lookup is logarithmic.
+struct ordered_keys {};
+
+/// keeps ports in a std::unordered_map, keys need std::hash and operator ==.
+struct hashed_keys {};
+
+/**
+ * \brief keeps ports in a vector indexed by the key, lookup is a single array index.
+ *
+ * Keys need to be small non-negative integers, the vector grows to the largest key used.
+ */
+struct dense_keys {};
+
+namespace detail
+{
+
+/**
+ * \brief map of keys to ports with the interface shared by all routing policies.
+ *
+ * find returns nullptr for unknown keys, emplace inserts a port for a new key.
+ */
+template<class routing, class key_t, class port_t>
+class key_map;
+
+template<class key_t, class port_t>
+class key_map<ordered_keys, key_t, port_t>
+{
+public:
+	port_t* find(const key_t& key)
+	{
+		const auto it = ports.find(key);
+		return it == ports.end() ? nullptr : &it->second;
+	}
+	const port_t* find(const key_t& key) const
+	{
+		const auto it = ports.find(key);
+		return it == ports.end() ? nullptr : &it->second;
+	}
+	port_t& emplace(const key_t& key, port_t port)
+	{
+		return ports.emplace(key, std::move(port)).first->second;
+	}
+	bool empty() const noexcept { return ports.empty(); }
+
+private:
+	std::map<key_t, port_t> ports;
+};
+
+template<class key_t, class port_t>
+class key_map<hashed_keys, key_t, port_t>
+{
+public:
+	port_t* find(const key_t& key)
+	{
+		const auto it = ports.find(key);
+		return it == ports.end() ? nullptr : &it->second;
+	}
+	const port_t* find(const key_t& key) const
+	{
+		const auto it = ports.find(key);
+		return it == ports.end() ? nullptr : &it->second;
+	}
+	port_t& emplace(const key_t& key, port_t port)
+	{
+		return ports.emplace(key, std::move(port)).first->second;
+	}
+	bool empty() const noexcept { return ports.empty(); }
+
+private:
+	std::unordered_map<key_t, port_t> ports;
+};
+
+template<class key_t, class port_t>
+class key_map<dense_keys, key_t, port_t>
+{
+	static_assert(std::is_integral<key_t>::value || std::is_enum<key_t>::value,
+			"dense_keys needs integer keys.");
+public:
+	port_t* find(const key_t& key) noexcept
+	{
+		const auto i = static_cast<size_t>(key);
+		return i < ports.size() ? ports[i].get() : nullptr;
+	}
+	const port_t* find(const key_t& key) const noexcept
+	{
+		const auto i = static_cast<size_t>(key);
+		return i < ports.size() ? ports[i].get() : nullptr;
+	}
+	port_t& emplace(const key_t& key, port_t port)
+	{
+		const auto i = static_cast<size_t>(key);
+		if (i >= ports.size())
+			ports.resize(i + 1);
+		if (!ports[i])
+		{
+			ports[i] = std::make_unique<port_t>(std::move(port));
+			++nr_of_ports;
+		}
+		return *ports[i];
+	}
+	bool empty() const noexcept { return nr_of_ports == 0; }
+
+private:
+	// ports are allocated separately, so growing the vector does not move them.
+	std::vector<std::unique_ptr<port_t>> ports;
+	size_t nr_of_ports = 0;
+};
+
+} // namespace detail
+} // namespace fc
+
+#endif /* SRC_UTILS_KEY_ROUTING_HPP_ */
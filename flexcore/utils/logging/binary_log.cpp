@@ -0,0 +1,172 @@
+#include <flexcore/utils/logging/binary_log.hpp>
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace fc
+{
+
+constexpr size_t binary_log_record::max_payload;
+
+log_string_table& log_string_table::global()
+{
+	static log_string_table table;
+	return table;
+}
+
+log_string_id log_string_table::intern(const std::string& str)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto inserted = ids.emplace(str, static_cast<log_string_id>(strings.size()));
+	if (inserted.second)
+		strings.push_back(str);
+	return inserted.first->second;
+}
+
+std::string log_string_table::lookup(log_string_id id) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return strings.at(id);
+}
+
+void log_string_table::write(std::ostream& stream) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto nr_of_strings = static_cast<uint32_t>(strings.size());
+	stream.write(reinterpret_cast<const char*>(&nr_of_strings), sizeof(nr_of_strings));
+	for (const auto& str : strings)
+	{
+		const auto length = static_cast<uint32_t>(str.size());
+		stream.write(reinterpret_cast<const char*>(&length), sizeof(length));
+		stream.write(str.data(), length);
+	}
+}
+
+void log_string_table::read(std::istream& stream)
+{
+	uint32_t nr_of_strings = 0;
+	if (!stream.read(reinterpret_cast<char*>(&nr_of_strings), sizeof(nr_of_strings)))
+		throw std::runtime_error("log_string_table could not read the number of strings");
+	std::vector<std::string> new_strings(nr_of_strings);
+	for (auto& str : new_strings)
+	{
+		uint32_t length = 0;
+		stream.read(reinterpret_cast<char*>(&length), sizeof(length));
+		str.resize(length);
+		if (!stream.read(&str[0], length))
+			throw std::runtime_error("log_string_table could not read a string");
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	strings = std::move(new_strings);
+	ids.clear();
+	for (log_string_id i = 0; i != strings.size(); ++i)
+		ids.emplace(strings[i], i);
+}
+
+namespace
+{
+template<class T>
+T read_value(const char*& in)
+{
+	T value;
+	std::memcpy(&value, in, sizeof(T));
+	in += sizeof(T);
+	return value;
+}
+
+/// writes the argument at in to stream and advances in behind it.
+void format_argument(std::ostream& stream, const char*& in)
+{
+	using argument = binary_log_record::argument;
+	switch (static_cast<argument>(*in++))
+	{
+	case argument::signed_integer:
+		stream << read_value<int64_t>(in);
+		break;
+	case argument::unsigned_integer:
+		stream << read_value<uint64_t>(in);
+		break;
+	case argument::floating_point:
+		stream << read_value<double>(in);
+		break;
+	case argument::boolean:
+		stream << std::boolalpha << read_value<bool>(in) << std::noboolalpha;
+		break;
+	case argument::string:
+	{
+		const auto length = read_value<uint16_t>(in);
+		stream.write(in, length);
+		in += length;
+		break;
+	}
+	}
+}
+} // anonymous namespace
+
+std::string format_record(const binary_log_record& record, const log_string_table& table)
+{
+	const auto format = table.lookup(record.format);
+	std::ostringstream stream;
+	const char* in = record.payload.data();
+	size_t remaining = record.nr_of_arguments;
+	size_t pos = 0;
+	for (;;)
+	{
+		const auto placeholder = format.find("{}", pos);
+		if (placeholder == std::string::npos || remaining == 0)
+			break;
+		stream.write(format.data() + pos, placeholder - pos);
+		format_argument(stream, in);
+		--remaining;
+		pos = placeholder + 2;
+	}
+	stream.write(format.data() + pos, format.size() - pos);
+	return stream.str();
+}
+
+namespace
+{
+/// size of the part of the record in front of the payload.
+constexpr size_t header_size = offsetof(binary_log_record, payload);
+}
+
+void write_binary(std::ostream& stream, const binary_log_record& record)
+{
+	stream.write(reinterpret_cast<const char*>(&record), header_size);
+	stream.write(record.payload.data(), record.payload_size);
+}
+
+bool read_binary(std::istream& stream, binary_log_record& record)
+{
+	if (!stream.read(reinterpret_cast<char*>(&record), header_size))
+		return false;
+	if (record.payload_size > binary_log_record::max_payload
+			|| !stream.read(record.payload.data(), record.payload_size))
+		throw std::runtime_error("binary log record is truncated or corrupt");
+	return true;
+}
+
+binary_log_client::binary_log_client() : binary_log_client("(null)")
+{
+}
+
+binary_log_client::binary_log_client(const node& node_)
+	: channel(log_string_table::global().intern(node_.name()))
+	, region(log_string_table::global().intern(
+			node_.graph_info().region() ? node_.graph_info().region()->get_id().key : ""))
+	, threshold(&detail::threshold_of(node_.name()))
+{
+}
+
+binary_log_client::binary_log_client(const std::string& channel_name)
+	: channel(log_string_table::global().intern(channel_name))
+	, region(log_string_table::global().intern(""))
+	, threshold(&detail::threshold_of(channel_name))
+{
+}
+
+} // namespace fc
@@ -0,0 +1,262 @@
+#ifndef SRC_LOGGING_BINARY_LOG_HPP_
+#define SRC_LOGGING_BINARY_LOG_HPP_
+
+#include <flexcore/utils/logging/logger.hpp>
+#include <flexcore/scheduler/clock.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace fc
+{
+
+/// id of a string in a log_string_table.
+using log_string_id = uint32_t;
+
+/**
+ * \brief Table of the format strings and channel names referenced by binary_log_record.
+ *
+ * Records only store ids of strings, the table maps them back.
+ * Offline decoders read the table written by the logging process.
+ */
+class log_string_table
+{
+public:
+	/// returns the table of this process, used by log_format and binary_log_client.
+	static log_string_table& global();
+
+	/// adds str to the table if it is not contained yet and returns its id, thread safe.
+	log_string_id intern(const std::string& str);
+	/// returns the string of id, thread safe. \throws std::out_of_range if id is unknown.
+	std::string lookup(log_string_id id) const;
+
+	/// writes all strings of the table to stream in binary form.
+	void write(std::ostream& stream) const;
+	/// replaces the strings of the table by the ones read from stream.
+	void read(std::istream& stream);
+
+private:
+	mutable std::mutex mutex;
+	std::vector<std::string> strings;
+	std::unordered_map<std::string, log_string_id> ids;
+};
+
+/**
+ * \brief Format string of binary log messages, each {} is replaced by an argument.
+ *
+ * Construction interns the format in the global log_string_table,
+ * thus formats are best kept as static objects.
+ * \code{cpp}
+ * static const fc::log_format cycle_format{"cycle {} took {} us"};
+ * client.write(cycle_format, cycle, duration);
+ * \endcode
+ */
+class log_format
+{
+public:
+	explicit log_format(const std::string& format)
+		: id_(log_string_table::global().intern(format))
+	{
+	}
+	log_string_id id() const noexcept { return id_; }
+private:
+	log_string_id id_;
+};
+
+/**
+ * \brief Log message as format id and raw arguments, formatted only when read.
+ *
+ * The record is trivially copyable and has a fixed size,
+ * writing one is a handful of stores and a memcpy per argument.
+ * Arguments which do not fit into the payload are dropped.
+ */
+struct binary_log_record
+{
+	static constexpr size_t max_payload = 224;
+
+	/// type of an argument in the payload, stored in front of its value.
+	enum class argument : uint8_t
+	{
+		signed_integer,
+		unsigned_integer,
+		floating_point,
+		boolean,
+		/// uint16_t length followed by the characters.
+		string
+	};
+
+	/// time of the virtual steady clock when the record was written.
+	virtual_clock::steady::rep time = 0;
+	log_string_id format = 0;
+	log_string_id channel = 0;
+	/// id of the key of the region of the node, which wrote the record.
+	log_string_id region = 0;
+	level severity = level::info;
+	uint8_t nr_of_arguments = 0;
+	uint16_t payload_size = 0;
+	std::array<char, max_payload> payload;
+};
+
+static_assert(std::is_trivially_copyable<binary_log_record>{},
+		"binary_log_record is copied bytewise into queues and files.");
+
+/**
+ * \brief formats record by replacing each {} of its format by the next argument.
+ *
+ * \param table contains the format of record,
+ * the global table for records written by this process.
+ */
+std::string format_record(const binary_log_record& record,
+		const log_string_table& table = log_string_table::global());
+
+/**
+ * \brief writes record to stream in binary form, only the used part of the payload is written.
+ * Values are written in the byte order of the host.
+ */
+void write_binary(std::ostream& stream, const binary_log_record& record);
+/// reads a record written by write_binary. \returns false at the end of stream.
+bool read_binary(std::istream& stream, binary_log_record& record);
+
+namespace detail
+{
+inline void append_argument(binary_log_record& record,
+		binary_log_record::argument type, const void* value, size_t size)
+{
+	if (record.payload_size + 1 + size > binary_log_record::max_payload)
+		return;
+	record.payload[record.payload_size] = static_cast<char>(type);
+	std::memcpy(record.payload.data() + record.payload_size + 1, value, size);
+	record.payload_size += 1 + size;
+	++record.nr_of_arguments;
+}
+
+inline void append_string(binary_log_record& record, const char* str, size_t length)
+{
+	const auto free = binary_log_record::max_payload - record.payload_size;
+	if (free < 1 + sizeof(uint16_t))
+		return;
+	const auto stored = static_cast<uint16_t>(std::min(length, free - 1 - sizeof(uint16_t)));
+	char* out = record.payload.data() + record.payload_size;
+	*out = static_cast<char>(binary_log_record::argument::string);
+	std::memcpy(out + 1, &stored, sizeof(stored));
+	std::memcpy(out + 1 + sizeof(stored), str, stored);
+	record.payload_size += 1 + sizeof(stored) + stored;
+	++record.nr_of_arguments;
+}
+
+inline void append(binary_log_record& record, bool value)
+{
+	append_argument(record, binary_log_record::argument::boolean, &value, sizeof(value));
+}
+
+template<class T, std::enable_if_t<std::is_integral<T>{} && std::is_signed<T>{}, int> = 0>
+void append(binary_log_record& record, T value)
+{
+	const auto widened = static_cast<int64_t>(value);
+	append_argument(record, binary_log_record::argument::signed_integer,
+			&widened, sizeof(widened));
+}
+
+template<class T, std::enable_if_t<std::is_integral<T>{} && std::is_unsigned<T>{}, int> = 0>
+void append(binary_log_record& record, T value)
+{
+	const auto widened = static_cast<uint64_t>(value);
+	append_argument(record, binary_log_record::argument::unsigned_integer,
+			&widened, sizeof(widened));
+}
+
+template<class T, std::enable_if_t<std::is_floating_point<T>{}, int> = 0>
+void append(binary_log_record& record, T value)
+{
+	const auto widened = static_cast<double>(value);
+	append_argument(record, binary_log_record::argument::floating_point,
+			&widened, sizeof(widened));
+}
+
+template<class T, std::enable_if_t<std::is_enum<T>{}, int> = 0>
+void append(binary_log_record& record, T value)
+{
+	append(record, static_cast<std::underlying_type_t<T>>(value));
+}
+
+inline void append(binary_log_record& record, const char* str)
+{
+	append_string(record, str, std::strlen(str));
+}
+
+inline void append(binary_log_record& record, const std::string& str)
+{
+	append_string(record, str.data(), str.size());
+}
+} // namespace detail
+
+/**
+ * \brief Log client writing binary records, which are formatted later.
+ *
+ * Callers pass numbers as they are instead of formatting them into strings.
+ * With asynchronous logging enabled in the logger, records are queued and formatted
+ * by the background thread, otherwise they are formatted right away.
+ * If binary logs are added to the logger, records are written to them without formatting,
+ * together with log_string_table::global() they can be decoded offline.
+ *
+ * Like log_client, the client is not MT-safe but models a value type.
+ */
+class binary_log_client
+{
+public:
+	/// Construct a client with the channel "(null)".
+	binary_log_client();
+	/// Construct a client which logs with the name and region of node_.
+	explicit binary_log_client(const node& node_);
+	/// Construct a client which logs to the given channel.
+	explicit binary_log_client(const std::string& channel);
+
+	/// writes a record of format and args with the specified severity level.
+	template<class... args_t>
+	void write(level severity, const log_format& format, const args_t&... args)
+	{
+		if (!enabled(severity))
+			return;
+		binary_log_record record;
+		record.time = virtual_clock::steady::now().time_since_epoch().count();
+		record.format = format.id();
+		record.channel = channel;
+		record.region = region;
+		record.severity = severity;
+		using expand = int[];
+		(void)expand{0, (detail::append(record, args), 0)...};
+		submit(record);
+	}
+
+	/// writes a record of format and args with level::info.
+	template<class... args_t>
+	void write(const log_format& format, const args_t&... args)
+	{
+		write(level::info, format, args...);
+	}
+
+	/// returns true if records of severity are written by this client, lock-free.
+	bool enabled(level severity = level::info) const noexcept
+	{
+		return detail::log_enabled(*threshold, severity);
+	}
+
+private:
+	void submit(const binary_log_record& record);
+
+	log_string_id channel;
+	log_string_id region;
+	const detail::log_threshold* threshold;
+};
+
+} // namespace fc
+
+#endif /* SRC_LOGGING_BINARY_LOG_HPP_ */
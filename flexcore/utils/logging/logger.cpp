@@ -2,8 +2,12 @@
 #define BOOST_ALL_DYN_LINK
 #define BOOST_LOG_USE_NATIVE_SYSLOG
 #include <flexcore/utils/logging/logger.hpp>
+#include <flexcore/utils/logging/binary_log.hpp>
+#include <flexcore/scheduler/mpsc_queue.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
 #include <boost/utility/empty_deleter.hpp>
 #include <boost/log/attributes/clock.hpp>
+#include <boost/log/attributes/mutable_constant.hpp>
 #include <boost/log/expressions.hpp>
 #include <boost/log/sinks/text_file_backend.hpp>
 #include <boost/log/sinks/text_ostream_backend.hpp>
@@ -14,9 +18,16 @@
 #include <boost/log/common.hpp>
 #include <boost/log/core.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <ios>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 /**
  * Boost log has the following design:
@@ -143,54 +154,529 @@ stream_handle logger::add_stream_log(std::ostream& stream, logger::flush flush,
 	return stream_handle(cleanup_fun);
 }
 
+namespace
+{
+/// streams registered with add_binary_log.
+struct binary_logs
+{
+	std::mutex mutex;
+	std::vector<std::ostream*> streams;
+};
+
+binary_logs& get_binary_logs()
+{
+	static binary_logs logs;
+	return logs;
+}
+
+/// writes record to the binary logs, \returns false if there are none.
+bool write_to_binary_logs(const binary_log_record& record)
+{
+	auto& logs = get_binary_logs();
+	std::lock_guard<std::mutex> lock(logs.mutex);
+	if (logs.streams.empty())
+		return false;
+	for (auto* stream : logs.streams)
+		write_binary(*stream, record);
+	return true;
+}
+
+/// passes record to the binary logs, or formatted to the other backends if there are none.
+template<class source>
+void log_binary_record(source& lg, const binary_log_record& record)
+{
+	if (write_to_binary_logs(record))
+		return;
+	const auto& table = log_string_table::global();
+	BOOST_LOG_CHANNEL_SEV(lg, table.lookup(record.channel), record.severity)
+			<< format_record(record, table);
+}
+} // anonymous namespace
+
+stream_handle logger::add_binary_log(std::ostream& stream)
+{
+	auto& logs = get_binary_logs();
+	{
+		std::lock_guard<std::mutex> lock(logs.mutex);
+		logs.streams.push_back(&stream);
+	}
+	return stream_handle([&logs, s = &stream]()
+	{
+		std::lock_guard<std::mutex> lock(logs.mutex);
+		logs.streams.erase(std::remove(logs.streams.begin(), logs.streams.end(), s),
+				logs.streams.end());
+	});
+}
+
+namespace detail
+{
+/**
+ * Queue and background thread of asynchronous logging.
+ * Writers only push to the queue, the thread is the single consumer
+ * and logs the records with a logger of its own.
+ */
+class async_log_writer
+{
+public:
+	using time_stamp = attributes::utc_clock::value_type;
+
+	struct record
+	{
+		std::string channel;
+		std::string message;
+		level severity = level::info;
+		time_stamp time;
+	};
+
+	explicit async_log_writer(size_t capacity) : queue(capacity), binary_queue(capacity) {}
+
+	/// \returns false if the message was not queued, as asynchronous logging is disabled.
+	bool try_write(const std::string& channel, const std::string& msg, level severity)
+	{
+		if (!enabled.load(std::memory_order_acquire))
+			return false;
+		record rec{channel, msg, severity, attributes::utc_time_traits::get_clock()};
+		if (queue.push(rec))
+			queued.fetch_add(1, std::memory_order_release);
+		else
+			dropped.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/// \returns false if the record was not queued, as asynchronous logging is disabled.
+	bool try_write(const binary_log_record& record)
+	{
+		if (!enabled.load(std::memory_order_acquire))
+			return false;
+		auto copy = record;
+		if (binary_queue.push(copy))
+			queued.fetch_add(1, std::memory_order_release);
+		else
+			dropped.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	void start()
+	{
+		std::lock_guard<std::mutex> lock(control);
+		if (worker.joinable())
+			return;
+		running.store(true);
+		worker = std::thread([this]() { run(); });
+		enabled.store(true, std::memory_order_release);
+	}
+
+	void stop()
+	{
+		std::lock_guard<std::mutex> lock(control);
+		enabled.store(false, std::memory_order_release);
+		if (!worker.joinable())
+			return;
+		running.store(false);
+		worker.join();
+	}
+
+	void flush()
+	{
+		const auto target = queued.load(std::memory_order_acquire);
+		while (running.load() && written.load(std::memory_order_acquire) < target)
+			std::this_thread::sleep_for(idle_wait);
+	}
+
+	size_t nr_of_dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+	/// time the thread sleeps if the queue is empty, bounds the delay of messages.
+	static constexpr std::chrono::milliseconds idle_wait{1};
+
+	void run()
+	{
+		sources::severity_channel_logger<level, std::string> lg;
+		attributes::mutable_constant<time_stamp> stamp{time_stamp{}};
+		// attributes of the source take precedence over the global time stamp.
+		lg.add_attribute("TimeStamp", stamp);
+		record rec;
+		binary_log_record binary;
+		for (;;)
+		{
+			// check before draining, so nothing queued before stop is lost.
+			const bool stopping = !running.load();
+			while (queue.pop(rec))
+			{
+				stamp.set(rec.time);
+				BOOST_LOG_CHANNEL_SEV(lg, rec.channel, rec.severity) << rec.message;
+				written.fetch_add(1, std::memory_order_release);
+			}
+			while (binary_queue.pop(binary))
+			{
+				stamp.set(attributes::utc_time_traits::get_clock());
+				log_binary_record(lg, binary);
+				written.fetch_add(1, std::memory_order_release);
+			}
+			if (stopping)
+				return;
+			std::this_thread::sleep_for(idle_wait);
+		}
+	}
+
+	thread::mpsc_queue<record> queue;
+	thread::mpsc_queue<binary_log_record> binary_queue;
+	std::atomic<bool> enabled{false};
+	std::atomic<bool> running{false};
+	std::atomic<uint64_t> queued{0};
+	std::atomic<uint64_t> written{0};
+	std::atomic<size_t> dropped{0};
+	/// serializes start and stop.
+	std::mutex control;
+	std::thread worker;
+};
+
+constexpr std::chrono::milliseconds async_log_writer::idle_wait;
+} // namespace detail
+
+namespace
+{
+/// set once asynchronous logging has been enabled, lives as long as the logger.
+std::atomic<detail::async_log_writer*> async_writer{nullptr};
+}
+
+void logger::enable_async(size_t capacity)
+{
+	if (!async)
+	{
+		async = std::make_unique<detail::async_log_writer>(capacity);
+		async_writer.store(async.get(), std::memory_order_release);
+	}
+	async->start();
+}
+
+void logger::disable_async()
+{
+	if (async)
+		async->stop();
+}
+
+void logger::flush_async()
+{
+	if (async)
+		async->flush();
+}
+
+size_t logger::dropped_messages() const
+{
+	return async ? async->nr_of_dropped() : 0;
+}
+
+namespace detail
+{
+std::atomic<int> global_log_threshold{static_cast<int>(level::debug)};
+
+log_threshold& threshold_of(const std::string& channel)
+{
+	// thresholds are never removed, clients keep pointers to them.
+	static std::mutex mutex;
+	static std::unordered_map<std::string, std::unique_ptr<log_threshold>> thresholds;
+	std::lock_guard<std::mutex> lock(mutex);
+	auto& threshold = thresholds[channel];
+	if (!threshold)
+		threshold = std::make_unique<log_threshold>();
+	return *threshold;
+}
+} // namespace detail
+
+void logger::set_threshold(level most_verbose)
+{
+	detail::global_log_threshold.store(static_cast<int>(most_verbose), std::memory_order_relaxed);
+}
+
+level logger::threshold() const
+{
+	return static_cast<level>(detail::global_log_threshold.load(std::memory_order_relaxed));
+}
+
+void logger::set_channel_threshold(const std::string& channel, level most_verbose)
+{
+	detail::threshold_of(channel).channel_level.store(
+			static_cast<int>(most_verbose), std::memory_order_relaxed);
+}
+
+void logger::reset_channel_threshold(const std::string& channel)
+{
+	detail::threshold_of(channel).channel_level.store(-1, std::memory_order_relaxed);
+}
+
+namespace detail
+{
+struct log_rate_limit
+{
+	using clock = std::chrono::steady_clock;
+
+	/// messages written per interval, 0 if unlimited.
+	std::atomic<size_t> messages{0};
+	std::atomic<clock::rep> interval{std::chrono::duration_cast<clock::duration>(
+			std::chrono::seconds{5}).count()};
+
+	// interval shared by all clients, only used for the limits of regions.
+	std::atomic<clock::rep> start{0};
+	std::atomic<size_t> written{0};
+	std::atomic<size_t> suppressed{0};
+
+	bool limited() const noexcept { return messages.load(std::memory_order_relaxed) != 0; }
+	clock::duration get_interval() const noexcept
+	{
+		return clock::duration{interval.load(std::memory_order_relaxed)};
+	}
+};
+
+namespace
+{
+std::atomic<size_t> suppressed_log_messages{0};
+
+/// returns the limit of name, which lives as long as the program.
+log_rate_limit& rate_limit_of(const std::string& name, bool region)
+{
+	// limits are never removed, clients keep pointers to them.
+	static std::mutex mutex;
+	static std::unordered_map<std::string, std::unique_ptr<log_rate_limit>> limits[2];
+	std::lock_guard<std::mutex> lock(mutex);
+	auto& limit = limits[region][name];
+	if (!limit)
+		limit = std::make_unique<log_rate_limit>();
+	return *limit;
+}
+
+/// returns the limit of the region, nullptr for nodes without region.
+log_rate_limit* region_rate_limit(const parallel_region* region)
+{
+	return region ? &rate_limit_of(region->get_id().key, true) : nullptr;
+}
+
+void set_limit(log_rate_limit& limit, size_t messages, std::chrono::milliseconds interval)
+{
+	limit.interval.store(std::chrono::duration_cast<log_rate_limit::clock::duration>(
+			interval).count(), std::memory_order_relaxed);
+	limit.messages.store(messages, std::memory_order_relaxed);
+}
+
+/// "5s" for whole seconds, "250ms" otherwise.
+std::string to_string(log_rate_limit::clock::duration interval)
+{
+	const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(interval).count();
+	return ms % 1000 == 0 ? std::to_string(ms / 1000) + "s" : std::to_string(ms) + "ms";
+}
+} // anonymous namespace
+} // namespace detail
+
+void logger::set_rate_limit(const std::string& channel, size_t messages,
+		std::chrono::milliseconds interval)
+{
+	detail::set_limit(detail::rate_limit_of(channel, false), messages, interval);
+}
+
+void logger::set_region_rate_limit(const std::string& region, size_t messages,
+		std::chrono::milliseconds interval)
+{
+	detail::set_limit(detail::rate_limit_of(region, true), messages, interval);
+}
+
+size_t logger::suppressed_messages() const
+{
+	return detail::suppressed_log_messages.load(std::memory_order_relaxed);
+}
+
 logger::logger()
 {
 	// add the time stamp to every record (this does not mean that it gets output automatically).
 	core::get()->add_global_attribute("TimeStamp", attributes::utc_clock{});
 }
 
+logger::~logger()
+{
+	disable_async();
+	async_writer.store(nullptr);
+}
+
 class log_client::log_client_impl
 {
 public:
-	explicit log_client_impl(const node& node_)
-	    : log_client_impl(node_.name())
+	using clock = detail::log_rate_limit::clock;
+
+	log_client_impl(const std::string& channel, detail::log_rate_limit* region_limit)
+	    : channel(channel), lg(keywords::channel = channel)
+	    , limit(&detail::rate_limit_of(channel, false)), region_limit(region_limit)
+	{
+	}
+
+	// a copy counts its messages on its own.
+	log_client_impl(const log_client_impl& other)
+	    : channel(other.channel), lg(other.lg), limit(other.limit), region_limit(other.region_limit)
 	{
 	}
 
-	explicit log_client_impl(const std::string& channel)
-	    : lg(keywords::channel = channel)
+	~log_client_impl() { report(); }
+
+	bool admits(level severity)
 	{
+		const bool own = limit->limited();
+		const bool region = region_limit && region_limit->limited();
+		if (!own && !region)
+			return true;
+
+		const auto now = clock::now();
+		if (own)
+		{
+			if (now - start >= limit->get_interval())
+			{
+				report();
+				start = now;
+				written = 0;
+			}
+			if (written >= limit->messages.load(std::memory_order_relaxed))
+				return discard(severity, suppressed);
+		}
+		if (region && !admitted_by_region(now))
+			return discard(severity, suppressed_by_region);
+		++written;
+		return true;
 	}
 
 	void write(const std::string& msg, level severity)
 	{
-		BOOST_LOG_SEV(lg, severity) << msg;
+		if (limit->limited())
+		{
+			if (has_last && msg == last)
+			{
+				discard(severity, repeated);
+				return;
+			}
+			// repetitions are reported before the message, which ends them.
+			if (repeated != 0)
+				report();
+			has_last = true;
+			last = msg;
+		}
+		publish(msg, severity);
 	}
 private:
+	void publish(const std::string& msg, level severity)
+	{
+		const auto async = async_writer.load(std::memory_order_acquire);
+		if (async && async->try_write(channel, msg, severity))
+			return;
+		BOOST_LOG_SEV(lg, severity) << msg;
+	}
+
+	bool discard(level severity, size_t& counter)
+	{
+		++counter;
+		most_severe = std::min(most_severe, static_cast<int>(severity));
+		detail::suppressed_log_messages.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	/// counts the message against the interval of the region, which any client may restart.
+	bool admitted_by_region(clock::time_point now)
+	{
+		auto region_start = region_limit->start.load(std::memory_order_relaxed);
+		if (now.time_since_epoch().count() - region_start >= region_limit->get_interval().count()
+				&& region_limit->start.compare_exchange_strong(region_start,
+						now.time_since_epoch().count(), std::memory_order_relaxed))
+		{
+			region_limit->written.store(0, std::memory_order_relaxed);
+			const auto discarded = region_limit->suppressed.exchange(0, std::memory_order_relaxed);
+			if (discarded != 0)
+				publish(std::to_string(discarded) + " messages of the region suppressed in the last "
+						+ detail::to_string(region_limit->get_interval()), level::warning);
+		}
+		if (region_limit->written.fetch_add(1, std::memory_order_relaxed)
+				< region_limit->messages.load(std::memory_order_relaxed))
+			return true;
+		region_limit->suppressed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	/// writes what has been discarded since the last report.
+	void report()
+	{
+		const auto discarded = suppressed + suppressed_by_region;
+		if (repeated != 0 || discarded != 0)
+		{
+			std::string msg;
+			if (repeated != 0)
+				msg = "message \"" + last + "\" repeated " + std::to_string(repeated) + " times";
+			if (discarded != 0)
+				msg += (msg.empty() ? "" : ", ") + std::to_string(discarded)
+						+ (repeated != 0 ? " more" : "") + " messages suppressed";
+			publish(msg + " in the last " + detail::to_string(limit->get_interval()),
+					static_cast<level>(most_severe));
+		}
+		repeated = suppressed = suppressed_by_region = 0;
+		most_severe = static_cast<int>(level::debug);
+	}
+
+	std::string channel;
 	sources::severity_channel_logger<level, std::string> lg;
+	detail::log_rate_limit* limit;
+	/// nullptr for clients without region.
+	detail::log_rate_limit* region_limit;
+
+	// current interval of the limit of the channel.
+	clock::time_point start{};
+	size_t written = 0;
+	size_t repeated = 0;
+	size_t suppressed = 0;
+	size_t suppressed_by_region = 0;
+	int most_severe = static_cast<int>(level::debug);
+	/// last message written, repetitions of it are counted instead.
+	std::string last;
+	bool has_last = false;
 };
 
-void log_client::write(const std::string& msg, level severity)
+bool log_client::admits(level severity)
+{
+	return log_client_pimpl->admits(severity);
+}
+
+void log_client::write_admitted(const std::string& msg, level severity)
 {
 	log_client_pimpl->write(msg, severity);
 }
 
+void log_client::write(const std::string& msg, level severity)
+{
+	if (enabled(severity) && admits(severity))
+		write_admitted(msg, severity);
+}
+
+void binary_log_client::submit(const binary_log_record& record)
+{
+	const auto async = async_writer.load(std::memory_order_acquire);
+	if (async && async->try_write(record))
+		return;
+	static thread_local sources::severity_channel_logger<level, std::string> lg;
+	log_binary_record(lg, record);
+}
+
 log_client::log_client() : log_client("(null)")
 {
 }
 
 log_client::log_client(const node& node_)
-    : log_client_pimpl(std::make_unique<log_client::log_client_impl>(node_))
+    : log_client_pimpl(std::make_unique<log_client::log_client_impl>(node_.name(),
+    		detail::region_rate_limit(node_.graph_info().region())))
+    , threshold(&detail::threshold_of(node_.name()))
 {
 }
 
 log_client::log_client(const std::string& channel)
-    : log_client_pimpl(std::make_unique<log_client::log_client_impl>(channel))
+    : log_client_pimpl(std::make_unique<log_client::log_client_impl>(channel, nullptr))
+    , threshold(&detail::threshold_of(channel))
 {
 }
 
 log_client::log_client(const log_client& other)
     : log_client_pimpl(std::make_unique<log_client::log_client_impl>(*other.log_client_pimpl))
+    , threshold(other.threshold)
 {
 }
 
@@ -199,6 +685,7 @@ log_client::log_client(const log_client& other)
 log_client& log_client::operator=(log_client other)
 {
 	std::swap(log_client_pimpl, other.log_client_pimpl);
+	std::swap(threshold, other.threshold);
 	return *this;
 }
 
@@ -3,16 +3,25 @@
 
 #include <flexcore/extended/node_fwd.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
 #include <syslog.h>
+#include <type_traits>
+#include <utility>
 
 namespace fc
 {
 
+namespace detail
+{
+class async_log_writer;
+}
+
 /**
  * \brief Enumeration of severity levels corresponding to the posix syslog api.
  * See man 3 syslog.
@@ -29,6 +38,34 @@ enum class level : char
 	debug = LOG_DEBUG
 };
 
+namespace detail
+{
+/// threshold of a single channel, shared by all clients of the channel.
+struct log_threshold
+{
+	/// most verbose level written by the channel, -1 if the global threshold applies.
+	std::atomic<int> channel_level{-1};
+};
+
+/// most verbose level written by channels without a threshold of their own.
+extern std::atomic<int> global_log_threshold;
+
+/// returns the threshold of channel, which lives as long as the program.
+log_threshold& threshold_of(const std::string& channel);
+
+/// checks severity against the thresholds with two relaxed loads, never blocks.
+inline bool log_enabled(const log_threshold& threshold, level severity) noexcept
+{
+	const auto channel_level = threshold.channel_level.load(std::memory_order_relaxed);
+	const auto limit = channel_level < 0
+			? global_log_threshold.load(std::memory_order_relaxed) : channel_level;
+	return static_cast<int>(severity) <= limit;
+}
+
+/// rate limit of a channel or a region, see logger::set_rate_limit.
+struct log_rate_limit;
+} // namespace detail
+
 /**
  * \brief A handle that will run the deleter function on destruction.
  * This is used to make sure that a stream that is added to the logger using add_stream_log will be
@@ -85,10 +122,90 @@ public:
 	stream_handle add_stream_log(std::ostream& stream, logger::flush flush,
 	                             logger::cleanup cleanup);
 
+	/**
+	 * \brief sets the most verbose level written by channels without a threshold of their own.
+	 *
+	 * Messages of less severe levels are discarded by the clients before they reach
+	 * the backends, write overloads taking a function do not even build them.
+	 * Thresholds can be changed at any time from any thread. The default is level::debug.
+	 */
+	void set_threshold(level most_verbose);
+	level threshold() const;
+	/// sets the most verbose level written by clients of channel, overrides set_threshold.
+	void set_channel_threshold(const std::string& channel, level most_verbose);
+	/// makes channel follow the threshold set by set_threshold again.
+	void reset_channel_threshold(const std::string& channel);
+
+	/**
+	 * \brief limits the messages every client of channel writes to messages per interval.
+	 *
+	 * Messages beyond the limit are discarded by the client before they are queued
+	 * or formatted, write overloads taking a function do not even build them.
+	 * A message equal to the last one the client wrote is counted, but not written again.
+	 * Repetitions are reported before the next other message, for example
+	 * "message "X" repeated 512 times in the last 5s", the other discarded messages
+	 * by the first write of the client after the interval.
+	 * Reports have the most severe level of the messages they count.
+	 * Limits can be changed at any time from any thread, channels have none by default.
+	 * \param messages written per interval, 0 removes the limit.
+	 */
+	void set_rate_limit(const std::string& channel, size_t messages,
+			std::chrono::milliseconds interval = std::chrono::seconds{5});
+	/**
+	 * \brief limits the messages the clients of the nodes of region write together.
+	 *
+	 * Applies on top of the limits of the channels, thus a single misbehaving node
+	 * cannot flood the log of its region. Messages discarded are reported by the first
+	 * client writing after the interval. The limit is approximate, while clients
+	 * in several threads start a new interval at once.
+	 * \param region key of the region_id.
+	 * \param messages written per interval, 0 removes the limit.
+	 */
+	void set_region_rate_limit(const std::string& region, size_t messages,
+			std::chrono::milliseconds interval = std::chrono::seconds{5});
+	/// returns the number of messages discarded by rate limits.
+	size_t suppressed_messages() const;
+
+	/**
+	 * \brief add a backend for records of binary_log_client, which are written unformatted.
+	 *
+	 * While binary logs are registered, binary records are only written to them
+	 * and not formatted for the other backends. Decode them with read_binary and format_record.
+	 * The same rules for the lifetime of stream as for add_stream_log apply.
+	 *
+	 * \returns A stream_handle that removes the stream from the logger on destruction.
+	 */
+	stream_handle add_binary_log(std::ostream& stream);
+
+	/**
+	 * \brief makes log_client::write return after queueing the message.
+	 *
+	 * A background thread takes the messages from a bounded lock-free queue
+	 * and passes them to the backends, thus formatting and writing to files or syslog
+	 * no longer happens in the thread of the caller, for example in a work tick.
+	 * Messages written while the queue is full are dropped and counted,
+	 * messages beyond a rate limit are discarded before they reach the queue.
+	 * Records keep the time at which they were written by log_client.
+	 *
+	 * \param capacity maximum number of queued messages, rounded up to a power of two.
+	 * Only used by the first call, the queue is kept when asynchronous logging is disabled.
+	 */
+	void enable_async(size_t capacity = 4096);
+	/// writes all queued messages and makes log_client::write synchronous again.
+	void disable_async();
+	/// blocks until the messages queued before the call have been passed to the backends.
+	void flush_async();
+	/// returns the number of messages dropped because the queue was full.
+	size_t dropped_messages() const;
+
+	~logger();
+
 private:
 	logger();
 	logger(const logger&) = delete;
 	logger& operator=(const logger&) = delete;
+
+	std::unique_ptr<detail::async_log_writer> async;
 };
 
 /**
@@ -97,15 +214,43 @@ private:
  *
  * The client is not MT-safe but models a value type,
  * so a copy of a client can safely be used in another thread.
+ * Every client counts its messages against the rate limit of its channel on its own,
+ * see logger::set_rate_limit, a copy starts with no messages counted.
  */
 class log_client
 {
 public:
 	/// Write msg to the log with the specified severity level.
 	void write(const std::string& msg, level = level::info);
+
+	/**
+	 * \brief Write the message returned by make_msg, which is only called if severity is enabled.
+	 * \code{cpp}
+	 * client.write([&]{ return "value " + std::to_string(x); }, fc::level::debug);
+	 * \endcode
+	 */
+	template<class message_fun, class = std::enable_if_t<std::is_convertible<
+			decltype(std::declval<message_fun&>()()), std::string>{}>>
+	void write(message_fun&& make_msg, level severity = level::info)
+	{
+		if (enabled(severity) && admits(severity))
+			write_admitted(make_msg(), severity);
+	}
+
+	/// returns true if messages of severity are written by this client, lock-free.
+	bool enabled(level severity = level::info) const noexcept
+	{
+		return detail::log_enabled(*threshold, severity);
+	}
+
 	/// Construct a log_client with the region name "null"
 	log_client();
-	/// Construct a log_client which logs from the passed region.
+	/**
+	 * \brief Construct a log_client which logs from the passed node.
+	 *
+	 * The channel is the name of the node, messages count against the rate limit
+	 * of the region of the node as well.
+	 */
 	explicit log_client(const node& node_);
 
 	/// Construct a log_client which logs to a given boost::log::channel
@@ -116,8 +261,13 @@ public:
 	log_client(log_client&&);
 	~log_client();
 private:
+	/// counts a message against the rate limits, \returns false if it is discarded.
+	bool admits(level severity);
+	void write_admitted(const std::string& msg, level severity);
+
 	class log_client_impl;
 	std::unique_ptr<log_client_impl> log_client_pimpl;
+	const detail::log_threshold* threshold;
 };
 
 ///Log client which provides a std stream interface to write log messages.
@@ -146,6 +296,9 @@ public:
 
 	stream_log_proxy operator<<(const std::string& msg);
 
+	/// returns true if messages are written with the severity of this client.
+	bool enabled() const noexcept { return log.enabled(severity); }
+
 	static_assert(std::is_move_constructible<stream_log_proxy>::value,
 	              "stream_log_proxy should be move constructible");
 
@@ -154,6 +307,16 @@ private:
 	const level severity;
 };
 
+/**
+ * \brief streams into stream_log_client only if its severity is enabled,
+ * the streamed expressions are not evaluated otherwise.
+ * \code{cpp}
+ * FLEXCORE_LOG_STREAM(debug_stream) << "value " << std::to_string(x);
+ * \endcode
+ */
+#define FLEXCORE_LOG_STREAM(stream_client) \
+	if (!(stream_client).enabled()) {} else (stream_client)
+
 inline stream_log_client::stream_log_client(log_client log, level severity)
     : log(std::move(log)), severity(severity)
 {
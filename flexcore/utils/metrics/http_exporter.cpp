@@ -0,0 +1,131 @@
+#include <flexcore/utils/metrics/http_exporter.hpp>
+
+#include <cerrno>
+#include <system_error>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace fc
+{
+namespace metrics
+{
+
+namespace
+{
+/// time the background thread waits for connections, before it checks for shut down.
+constexpr int poll_timeout_ms = 50;
+/// requests of scrapers are small, larger ones are not read any further.
+constexpr size_t max_request_size = 8192;
+
+[[noreturn]] void throw_errno(int error, const char* what)
+{
+	throw std::system_error(error, std::generic_category(), what);
+}
+
+void send_all(int connection, const std::string& data)
+{
+	size_t sent = 0;
+	while (sent != data.size())
+	{
+		const auto n = ::send(connection, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+		if (n <= 0)
+			return;
+		sent += static_cast<size_t>(n);
+	}
+}
+
+std::string response(const std::string& status, const std::string& body)
+{
+	return "HTTP/1.1 " + status + "\r\n"
+			"Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+			"Content-Length: " + std::to_string(body.size()) + "\r\n"
+			"Connection: close\r\n\r\n" + body;
+}
+}
+
+http_exporter::http_exporter(const registry& r, uint16_t port, const std::string& bind_address)
+	: metrics(r)
+{
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	if (::inet_pton(AF_INET, bind_address.c_str(), &address.sin_addr) != 1)
+		throw std::system_error(EINVAL, std::generic_category(),
+				"http_exporter needs an IPv4 bind address");
+
+	socket = ::socket(AF_INET, SOCK_STREAM, 0);
+	if (socket < 0)
+		throw_errno(errno, "http_exporter could not open socket");
+	const int reuse = 1;
+	::setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	socklen_t length = sizeof(address);
+	if (::bind(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+			|| ::listen(socket, 8) != 0
+			|| ::getsockname(socket, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+	{
+		const auto error = errno;
+		::close(socket);
+		throw_errno(error, "http_exporter could not listen on socket");
+	}
+	port_ = ntohs(address.sin_port);
+	thread = std::thread{[this]() { serve(); }};
+}
+
+http_exporter::~http_exporter()
+{
+	keep_running.store(false);
+	thread.join();
+	::close(socket);
+}
+
+void http_exporter::serve()
+{
+	while (keep_running.load())
+	{
+		pollfd listening{socket, POLLIN, 0};
+		if (::poll(&listening, 1, poll_timeout_ms) <= 0)
+			continue;
+		const int connection = ::accept(socket, nullptr, nullptr);
+		if (connection < 0)
+			continue;
+		answer(connection);
+		::close(connection);
+	}
+}
+
+void http_exporter::answer(int connection)
+{
+	// a stuck client must not block the exporter for long.
+	timeval timeout{1, 0};
+	::setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	std::string request;
+	char buffer[1024];
+	while (request.find("\r\n\r\n") == std::string::npos && request.size() < max_request_size)
+	{
+		const auto n = ::recv(connection, buffer, sizeof(buffer), 0);
+		if (n <= 0)
+			return;
+		request.append(buffer, static_cast<size_t>(n));
+	}
+
+	const auto line_end = request.find("\r\n");
+	const auto request_line = request.substr(0, line_end);
+	const bool is_metrics = request_line.compare(0, 13, "GET /metrics ") == 0
+			|| request_line.compare(0, 13, "GET /metrics?") == 0;
+	if (!is_metrics)
+	{
+		send_all(connection, response("404 Not Found", "not found, metrics are at /metrics\n"));
+		return;
+	}
+	send_all(connection, response("200 OK", metrics.scrape()));
+	++scrapes_;
+}
+
+} // namespace metrics
+} // namespace fc
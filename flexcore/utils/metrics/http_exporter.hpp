@@ -0,0 +1,59 @@
+#ifndef SRC_UTILS_METRICS_HTTP_EXPORTER_HPP_
+#define SRC_UTILS_METRICS_HTTP_EXPORTER_HPP_
+
+#include <flexcore/utils/metrics/registry.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace fc
+{
+namespace metrics
+{
+
+/**
+ * \brief serves the metrics of a registry over HTTP, for Prometheus to scrape.
+ *
+ * A background thread answers GET requests of path /metrics with registry::scrape,
+ * one connection at a time, all other requests with 404.
+ * The threads of flexcore are not involved, they only keep their counters as usual.
+ * \pre the registry outlives the exporter.
+ */
+class http_exporter
+{
+public:
+	/**
+	 * \param port TCP port to listen on, zero picks a free one.
+	 * \param bind_address IPv4 address to listen on, by default only local connections.
+	 * \throws std::system_error if the port cannot be bound.
+	 */
+	explicit http_exporter(const registry& r, uint16_t port = 0,
+			const std::string& bind_address = "127.0.0.1");
+	http_exporter(const http_exporter&) = delete;
+	http_exporter& operator=(const http_exporter&) = delete;
+	/// stops serving and joins the background thread.
+	~http_exporter();
+
+	/// TCP port the exporter listens on.
+	uint16_t port() const noexcept { return port_; }
+	/// number of requests answered with metrics.
+	size_t scrapes() const noexcept { return scrapes_.load(); }
+
+private:
+	void serve();
+	void answer(int connection);
+
+	const registry& metrics;
+	int socket = -1;
+	uint16_t port_ = 0;
+	std::atomic<bool> keep_running{true};
+	std::atomic<size_t> scrapes_{0};
+	std::thread thread;
+};
+
+} // namespace metrics
+} // namespace fc
+
+#endif /* SRC_UTILS_METRICS_HTTP_EXPORTER_HPP_ */
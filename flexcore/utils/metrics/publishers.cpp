@@ -0,0 +1,102 @@
+#include <flexcore/utils/metrics/publishers.hpp>
+#include <flexcore/extended/graph/graph.hpp>
+#include <flexcore/scheduler/cyclecontrol.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+#include <flexcore/utils/logging/logger.hpp>
+
+#include <chrono>
+#include <map>
+
+namespace fc
+{
+namespace metrics
+{
+
+collector_handle publish(registry& r, const thread::cycle_control& control)
+{
+	return r.add([&control](metric_writer& out)
+	{
+		const auto report = control.timing();
+		for (const auto& task : report.tasks)
+		{
+			const labels l{{"region", task.name},
+					{"tick_ms", std::to_string(std::chrono::duration_cast<
+							std::chrono::milliseconds>(task.tick).count())}};
+			out.histogram("flexcore_task_execution_seconds",
+					"Time spent executing the work of the task.", l, task.execution);
+			out.histogram("flexcore_task_queueing_seconds",
+					"Time between work being added and the start of its execution.",
+					l, task.queueing);
+			out.counter("flexcore_task_skipped_cycles_total",
+					"Cycles skipped, since the task was not done in time.", l,
+					static_cast<double>(task.skipped_cycles));
+		}
+		out.histogram("flexcore_main_loop_overrun_seconds",
+				"Time by which cycles of the main loop exceeded their duration.", {},
+				report.main_loop_overrun);
+		out.gauge("flexcore_scheduler_waiting_tasks",
+				"Tasks waiting in the queue of the scheduler.", {},
+				static_cast<double>(control.nr_of_tasks()));
+	});
+}
+
+collector_handle publish(registry& r, const graph::connection_graph& graph)
+{
+	// names of ports are kept between scrapes, only ports added since are looked up.
+	return r.add([&graph, names = std::map<graph::unique_id, labels>{},
+			version = graph::graph_version{}](metric_writer& out) mutable
+	{
+		const auto statistics = graph.statistics();
+		if (statistics.empty())
+			return;
+		auto changes = graph.changes_since(version);
+		version = changes.version;
+		for (const auto& port : changes.new_ports)
+			names[port.port_properties.id()] = labels{
+					{"node", port.node_properties.name()},
+					{"port", port.port_properties.description()}};
+		for (const auto& port : statistics)
+		{
+			const auto name = names.find(port.first);
+			const auto& l = name == names.end() ? labels{} : name->second;
+			out.counter("flexcore_port_events_total", "Events sent through the port.", l,
+					static_cast<double>(port.second.events));
+			out.counter("flexcore_port_bytes_total", "Bytes of tokens passed by the port.", l,
+					static_cast<double>(port.second.bytes));
+			out.counter("flexcore_port_pulls_total", "States pulled through the port.", l,
+					static_cast<double>(port.second.pulls));
+		}
+	});
+}
+
+collector_handle publish(registry& r, const parallel_region& region)
+{
+	return r.add([&region](metric_writer& out)
+	{
+		const auto& memory = region.memory();
+		const labels l{{"region", region.get_id().key}};
+		out.gauge("flexcore_region_memory_bytes",
+				"Bytes charged to the region by its nodes and buffers.", l,
+				static_cast<double>(memory.used()));
+		out.gauge("flexcore_region_memory_peak_bytes",
+				"Maximum of the bytes charged to the region.", l,
+				static_cast<double>(memory.peak()));
+		if (memory.soft_limit() != thread::memory_account::unlimited)
+			out.gauge("flexcore_region_memory_soft_limit_bytes",
+					"Bytes above which buffers of the region drop events.", l,
+					static_cast<double>(memory.soft_limit()));
+	});
+}
+
+collector_handle publish(registry& r, const logger& log)
+{
+	return r.add([&log](metric_writer& out)
+	{
+		out.counter("flexcore_log_dropped_messages_total",
+				"Messages dropped as the queue of the asynchronous logger was full.", {},
+				static_cast<double>(log.dropped_messages()));
+	});
+}
+
+} // namespace metrics
+} // namespace fc
@@ -0,0 +1,81 @@
+#ifndef SRC_UTILS_METRICS_PUBLISHERS_HPP_
+#define SRC_UTILS_METRICS_PUBLISHERS_HPP_
+
+#include <flexcore/utils/metrics/registry.hpp>
+
+#include <string>
+
+namespace fc
+{
+class logger;
+class parallel_region;
+
+namespace graph
+{
+class connection_graph;
+}
+namespace thread
+{
+class cycle_control;
+}
+
+namespace metrics
+{
+
+/**
+ * \brief publishes the timing of cycle_control and its scheduler.
+ *
+ * flexcore_task_execution_seconds and flexcore_task_queueing_seconds by region,
+ * flexcore_task_skipped_cycles_total, flexcore_main_loop_overrun_seconds as jitter of cycles
+ * and flexcore_scheduler_waiting_tasks as depth of the queue of the scheduler.
+ * \pre control outlives the returned handle.
+ */
+collector_handle publish(registry& r, const thread::cycle_control& control);
+
+/**
+ * \brief publishes the port_counters of graph.
+ *
+ * flexcore_port_events_total, flexcore_port_bytes_total and flexcore_port_pulls_total
+ * by node and port, only ports with counters enabled are published.
+ * \pre graph outlives the returned handle.
+ */
+collector_handle publish(registry& r, const graph::connection_graph& graph);
+
+/**
+ * \brief publishes the memory account of region.
+ *
+ * flexcore_region_memory_bytes, flexcore_region_memory_peak_bytes
+ * and flexcore_region_memory_soft_limit_bytes if a limit is set, by region.
+ * \pre region outlives the returned handle.
+ */
+collector_handle publish(registry& r, const parallel_region& region);
+
+/// publishes flexcore_log_dropped_messages_total of the asynchronous queue of log.
+collector_handle publish(registry& r, const logger& log);
+
+/**
+ * \brief publishes the dropped, queued and carried over events of an event_buffer by name.
+ * \pre buffer outlives the returned handle.
+ */
+template<class buffer_t>
+collector_handle publish_buffer(registry& r, std::string name, const buffer_t& buffer)
+{
+	return r.add([name = std::move(name), &buffer](metric_writer& out)
+	{
+		const labels l{{"buffer", name}};
+		out.counter("flexcore_buffer_dropped_events_total",
+				"Events dropped by the buffer as it was full.", l,
+				static_cast<double>(buffer.dropped_events()));
+		out.gauge("flexcore_buffer_queued_events",
+				"Events switched to the passive side, not yet sent.", l,
+				static_cast<double>(buffer.queued_events()));
+		out.gauge("flexcore_buffer_backlog_events",
+				"Events carried over to later cycles by the drain limit.", l,
+				static_cast<double>(buffer.backlog_events()));
+	});
+}
+
+} // namespace metrics
+} // namespace fc
+
+#endif /* SRC_UTILS_METRICS_PUBLISHERS_HPP_ */
@@ -0,0 +1,163 @@
+#include <flexcore/utils/metrics/registry.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+
+namespace fc
+{
+namespace metrics
+{
+
+namespace
+{
+std::string number(double value)
+{
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.12g", value);
+	return buffer;
+}
+
+double seconds(wall_clock::steady::duration d)
+{
+	return std::chrono::duration<double>(d).count();
+}
+
+std::string escape(const std::string& value)
+{
+	std::string result;
+	result.reserve(value.size());
+	for (const char c : value)
+	{
+		if (c == '\\' || c == '"')
+			result += '\\';
+		if (c == '\n')
+		{
+			result += "\\n";
+			continue;
+		}
+		result += c;
+	}
+	return result;
+}
+
+std::string render(const labels& sample_labels)
+{
+	if (sample_labels.empty())
+		return {};
+	std::string result = "{";
+	for (const auto& label : sample_labels)
+	{
+		if (result.size() > 1)
+			result += ',';
+		result += label.first + "=\"" + escape(label.second) + '"';
+	}
+	return result + '}';
+}
+
+const char* type_name(metric_type type)
+{
+	switch (type)
+	{
+	case metric_type::counter: return "counter";
+	case metric_type::gauge: return "gauge";
+	case metric_type::histogram: return "histogram";
+	}
+	return "untyped";
+}
+}
+
+metric_writer::family& metric_writer::family_of(
+		const std::string& name, const std::string& help, metric_type type)
+{
+	const auto inserted = index.emplace(name, families.size());
+	if (inserted.second)
+		families.push_back(family{name, help, type, {}});
+	auto& f = families[inserted.first->second];
+	if (f.type != type)
+		throw std::invalid_argument{"metric " + name + " was written with a different type"};
+	return f;
+}
+
+void metric_writer::counter(const std::string& name, const std::string& help,
+		const labels& sample_labels, double value)
+{
+	family_of(name, help, metric_type::counter).lines.push_back(
+			name + render(sample_labels) + ' ' + number(value));
+}
+
+void metric_writer::gauge(const std::string& name, const std::string& help,
+		const labels& sample_labels, double value)
+{
+	family_of(name, help, metric_type::gauge).lines.push_back(
+			name + render(sample_labels) + ' ' + number(value));
+}
+
+void metric_writer::histogram(const std::string& name, const std::string& help,
+		const labels& sample_labels, const thread::histogram_snapshot& durations)
+{
+	auto& lines = family_of(name, help, metric_type::histogram).lines;
+	// buckets of Prometheus are cumulative, the last one has no upper bound.
+	uint64_t cumulative = 0;
+	for (size_t i = 0; i != durations.buckets.size(); ++i)
+	{
+		cumulative += durations.buckets[i];
+		auto with_bound = sample_labels;
+		with_bound.emplace_back("le", i + 1 == durations.buckets.size()
+				? std::string{"+Inf"}
+				: number(seconds(thread::histogram_snapshot::upper_bound(i))));
+		lines.push_back(name + "_bucket" + render(with_bound) + ' ' + number(cumulative));
+	}
+	const auto suffix = render(sample_labels);
+	lines.push_back(name + "_count" + suffix + ' ' + number(durations.count));
+	lines.push_back(name + "_sum" + suffix + ' ' + number(seconds(durations.total)));
+}
+
+std::string metric_writer::text() const
+{
+	std::string result;
+	for (const auto& f : families)
+	{
+		result += "# HELP " + f.name + ' ' + f.help + '\n';
+		result += "# TYPE " + f.name + ' ' + type_name(f.type) + '\n';
+		for (const auto& line : f.lines)
+			result += line + '\n';
+	}
+	return result;
+}
+
+void collector_handle::reset()
+{
+	if (auto l = list.lock())
+	{
+		std::lock_guard<std::mutex> lock(l->mutex);
+		l->collectors.erase(id);
+	}
+	list.reset();
+}
+
+collector_handle registry::add(collector c)
+{
+	std::lock_guard<std::mutex> lock(list->mutex);
+	const auto id = list->next_id++;
+	list->collectors.emplace(id, std::move(c));
+	return collector_handle{list, id};
+}
+
+std::string registry::scrape() const
+{
+	metric_writer writer;
+	std::lock_guard<std::mutex> lock(list->mutex);
+	for (const auto& c : list->collectors)
+		c.second(writer);
+	return writer.text();
+}
+
+size_t registry::size() const
+{
+	std::lock_guard<std::mutex> lock(list->mutex);
+	return list->collectors.size();
+}
+
+} // namespace metrics
+} // namespace fc
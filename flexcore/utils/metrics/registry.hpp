@@ -0,0 +1,147 @@
+#ifndef SRC_UTILS_METRICS_REGISTRY_HPP_
+#define SRC_UTILS_METRICS_REGISTRY_HPP_
+
+#include <flexcore/scheduler/timing.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fc
+{
+/// Runtime metrics of flexcore in the text format of Prometheus.
+namespace metrics
+{
+
+/// pairs of label name and value, which identify a sample within its metric.
+using labels = std::vector<std::pair<std::string, std::string>>;
+
+enum class metric_type
+{
+	counter,
+	gauge,
+	histogram
+};
+
+/**
+ * \brief collects the samples written by the collectors during a single scrape.
+ *
+ * Samples of the same metric are grouped, even if written by different collectors.
+ * Durations of histograms are converted to seconds.
+ */
+class metric_writer
+{
+public:
+	/// writes value of a monotonic counter, name should end with _total.
+	void counter(const std::string& name, const std::string& help,
+			const labels& sample_labels, double value);
+	/// writes the current value of a gauge.
+	void gauge(const std::string& name, const std::string& help,
+			const labels& sample_labels, double value);
+	/// writes the buckets, count and sum of a histogram of durations.
+	void histogram(const std::string& name, const std::string& help,
+			const labels& sample_labels, const thread::histogram_snapshot& durations);
+
+	/// returns all samples in the text exposition format of Prometheus.
+	std::string text() const;
+
+private:
+	struct family
+	{
+		std::string name;
+		std::string help;
+		metric_type type;
+		std::vector<std::string> lines;
+	};
+	/// \throws std::invalid_argument if name is used for a metric of a different type.
+	family& family_of(const std::string& name, const std::string& help, metric_type type);
+
+	std::vector<family> families;
+	std::map<std::string, size_t> index;
+};
+
+namespace detail
+{
+/// collectors of a registry, shared with the handles which remove them.
+struct collector_list
+{
+	std::mutex mutex;
+	std::map<size_t, std::function<void(metric_writer&)>> collectors;
+	size_t next_id = 0;
+};
+}
+
+/// removes its collector from the registry on destruction.
+class collector_handle
+{
+public:
+	collector_handle() = default;
+	collector_handle(std::weak_ptr<detail::collector_list> list, size_t id)
+		: list(std::move(list)), id(id)
+	{
+	}
+	collector_handle(collector_handle&& other) noexcept { swap(other); }
+	collector_handle& operator=(collector_handle&& other) noexcept
+	{
+		reset();
+		swap(other);
+		return *this;
+	}
+	~collector_handle() { reset(); }
+
+	/// removes the collector now, waits for a running scrape to finish first.
+	void reset();
+
+private:
+	void swap(collector_handle& other) noexcept
+	{
+		std::swap(list, other.list);
+		std::swap(id, other.id);
+	}
+
+	std::weak_ptr<detail::collector_list> list;
+	size_t id = 0;
+};
+
+/**
+ * \brief registry of the collectors, which publish the metrics of an application.
+ *
+ * Metrics are pulled: collectors read the counters and histograms their components
+ * keep anyway, like the lock-free duration_histograms of cycle_control,
+ * only when the registry is scraped. Publishing thus adds nothing to the hot path.
+ * See publish for collectors of the parts of flexcore.
+ */
+class registry
+{
+public:
+	using collector = std::function<void(metric_writer&)>;
+
+	/**
+	 * \brief adds collector, which is called on every scrape.
+	 *
+	 * Collectors are called under the lock of the registry,
+	 * thus once the handle is destroyed, the collector is no longer called
+	 * and the objects it reads may be destroyed.
+	 * \returns handle which removes the collector, when it is destroyed.
+	 */
+	collector_handle add(collector c);
+
+	/// calls all collectors and returns their samples in the text format of Prometheus.
+	std::string scrape() const;
+
+	/// number of collectors added.
+	size_t size() const;
+
+private:
+	std::shared_ptr<detail::collector_list> list = std::make_shared<detail::collector_list>();
+};
+
+} // namespace metrics
+} // namespace fc
+
+#endif /* SRC_UTILS_METRICS_REGISTRY_HPP_ */
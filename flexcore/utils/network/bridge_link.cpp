@@ -0,0 +1,290 @@
+#include <flexcore/utils/network/bridge_link.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace fc
+{
+namespace net
+{
+
+namespace
+{
+constexpr uint32_t frame_magic = 0x46434246; // "FCBF"
+
+struct frame_header
+{
+	uint32_t magic;
+	compression codec;
+	uint64_t sequence;
+	int64_t send_time;
+	uint32_t nr_of_events;
+	/// size of the payload before compression.
+	uint32_t payload_size;
+};
+
+using event_size_t = uint32_t;
+
+/// appends src to out, runs of zero bytes become a zero followed by the length of the run.
+void compress_zero_runs(const std::vector<char>& src, std::vector<char>& out)
+{
+	for (size_t i = 0; i != src.size();)
+	{
+		if (src[i] != 0)
+		{
+			out.push_back(src[i++]);
+			continue;
+		}
+		uint8_t run = 0;
+		while (i != src.size() && src[i] == 0 && run != 255)
+		{
+			++run;
+			++i;
+		}
+		out.push_back(0);
+		out.push_back(static_cast<char>(run));
+	}
+}
+
+/// \returns false if src is no valid encoding of size bytes.
+bool decompress_zero_runs(const char* src, const char* end, size_t size, std::vector<char>& out)
+{
+	out.clear();
+	out.reserve(size);
+	while (src != end)
+	{
+		if (*src != 0)
+		{
+			out.push_back(*src++);
+			continue;
+		}
+		if (++src == end)
+			return false;
+		out.insert(out.end(), static_cast<uint8_t>(*src++), 0);
+	}
+	return out.size() == size;
+}
+
+[[noreturn]] void throw_errno(int error, const char* what)
+{
+	throw std::system_error(error, std::generic_category(), what);
+}
+} // anonymous namespace
+
+link_statistics link_counters::snapshot() const noexcept
+{
+	link_statistics result;
+	result.frames = frames.load(std::memory_order_relaxed);
+	result.events = events.load(std::memory_order_relaxed);
+	result.bytes = bytes.load(std::memory_order_relaxed);
+	result.dropped_events = dropped_events.load(std::memory_order_relaxed);
+	result.lost_frames = lost_frames.load(std::memory_order_relaxed);
+	result.latency = latency.snapshot();
+	return result;
+}
+
+frame_writer::frame_writer(const bridge_config& config_) : config(config_)
+{
+	if (config.max_frame_size <= sizeof(frame_header) + sizeof(event_size_t))
+		throw std::invalid_argument("max_frame_size of bridge_config is too small");
+	payload.reserve(config.max_frame_size);
+	frame.reserve(config.max_frame_size);
+}
+
+bool frame_writer::fits(size_t size) const noexcept
+{
+	// compression is not taken into account, as it might not reduce the size.
+	return sizeof(frame_header) + payload.size() + sizeof(event_size_t) + size
+			<= config.max_frame_size;
+}
+
+bool frame_writer::fits_empty(size_t size) const noexcept
+{
+	return sizeof(frame_header) + sizeof(event_size_t) + size <= config.max_frame_size;
+}
+
+void frame_writer::add(const_byte_span event)
+{
+	const auto size = static_cast<event_size_t>(event.size);
+	const auto* size_bytes = reinterpret_cast<const char*>(&size);
+	payload.insert(payload.end(), size_bytes, size_bytes + sizeof(size));
+	payload.insert(payload.end(), event.begin(), event.end());
+	++nr_of_events;
+}
+
+const_byte_span frame_writer::finish(uint64_t sequence)
+{
+	frame_header header{};
+	header.magic = frame_magic;
+	header.sequence = sequence;
+	header.send_time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			wall_clock::system::now().time_since_epoch()).count();
+	header.nr_of_events = nr_of_events;
+	header.payload_size = static_cast<uint32_t>(payload.size());
+
+	frame.resize(sizeof(header));
+	if (config.codec == compression::zero_runs)
+		compress_zero_runs(payload, frame);
+	// compressed frames larger than the original are sent uncompressed.
+	if (config.codec == compression::none || frame.size() > sizeof(header) + payload.size())
+	{
+		frame.resize(sizeof(header));
+		frame.insert(frame.end(), payload.begin(), payload.end());
+		header.codec = compression::none;
+	}
+	else
+	{
+		header.codec = config.codec;
+	}
+	std::memcpy(frame.data(), &header, sizeof(header));
+
+	payload.clear();
+	nr_of_events = 0;
+	return const_byte_span{frame.data(), frame.size()};
+}
+
+bool frame_reader::parse(const_byte_span datagram)
+{
+	frame_header header;
+	if (datagram.size < sizeof(header))
+		return false;
+	std::memcpy(&header, datagram.data, sizeof(header));
+	if (header.magic != frame_magic)
+		return false;
+
+	const auto* payload = datagram.data + sizeof(header);
+	switch (header.codec)
+	{
+	case compression::none:
+		if (datagram.size - sizeof(header) != header.payload_size)
+			return false;
+		position = payload;
+		break;
+	case compression::zero_runs:
+		if (!decompress_zero_runs(payload, datagram.end(), header.payload_size, decompressed))
+			return false;
+		position = decompressed.data();
+		break;
+	default:
+		return false;
+	}
+	end = position + header.payload_size;
+	sequence_ = header.sequence;
+	send_time_ = wall_clock::system::time_point{std::chrono::duration_cast<
+			wall_clock::system::duration>(std::chrono::nanoseconds{header.send_time})};
+	nr_of_events = header.nr_of_events;
+	remaining = header.nr_of_events;
+	return true;
+}
+
+bool frame_reader::next(const_byte_span& event) noexcept
+{
+	if (remaining == 0 || static_cast<size_t>(end - position) < sizeof(event_size_t))
+		return false;
+	event_size_t size;
+	std::memcpy(&size, position, sizeof(size));
+	if (static_cast<size_t>(end - position) - sizeof(size) < size)
+		return false;
+	event = const_byte_span{position + sizeof(size), size};
+	position += sizeof(size) + size;
+	--remaining;
+	return true;
+}
+
+udp_sender::udp_sender(const std::string& host, uint16_t port)
+{
+	addrinfo hints{};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_DGRAM;
+	addrinfo* result = nullptr;
+	const auto service = std::to_string(port);
+	const int error = ::getaddrinfo(host.c_str(), service.c_str(), &hints, &result);
+	if (error != 0)
+		throw std::system_error(EHOSTUNREACH, std::generic_category(), ::gai_strerror(error));
+
+	int last_error = 0;
+	for (auto* address = result; address; address = address->ai_next)
+	{
+		socket = ::socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK,
+				address->ai_protocol);
+		if (socket < 0)
+		{
+			last_error = errno;
+			continue;
+		}
+		// connecting a datagram socket fixes the destination, send needs no address.
+		if (::connect(socket, address->ai_addr, address->ai_addrlen) == 0)
+			break;
+		last_error = errno;
+		::close(socket);
+		socket = -1;
+	}
+	::freeaddrinfo(result);
+	if (socket < 0)
+		throw_errno(last_error, "udp_sender could not connect socket");
+}
+
+udp_sender::~udp_sender()
+{
+	::close(socket);
+}
+
+bool udp_sender::send(const_byte_span datagram) noexcept
+{
+	return ::send(socket, datagram.data, datagram.size, 0)
+			== static_cast<ssize_t>(datagram.size);
+}
+
+udp_receiver::udp_receiver(uint16_t port, const std::string& bind_address)
+{
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	if (::inet_pton(AF_INET, bind_address.c_str(), &address.sin_addr) != 1)
+		throw std::system_error(EINVAL, std::generic_category(),
+				"udp_receiver needs an IPv4 bind address");
+
+	socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	if (socket < 0)
+		throw_errno(errno, "udp_receiver could not open socket");
+	socklen_t length = sizeof(address);
+	if (::bind(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+			|| ::getsockname(socket, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+	{
+		const auto error = errno;
+		::close(socket);
+		throw_errno(error, "udp_receiver could not bind socket");
+	}
+	port_ = ntohs(address.sin_port);
+}
+
+udp_receiver::~udp_receiver()
+{
+	::close(socket);
+}
+
+bool udp_receiver::receive(std::vector<char>& buffer) noexcept
+{
+	// the largest possible datagram, so none are truncated.
+	constexpr size_t max_datagram = 65536;
+	buffer.resize(max_datagram);
+	const auto size = ::recv(socket, buffer.data(), buffer.size(), 0);
+	if (size < 0)
+	{
+		buffer.clear();
+		return false;
+	}
+	buffer.resize(static_cast<size_t>(size));
+	return true;
+}
+
+} // namespace net
+} // namespace fc
@@ -0,0 +1,200 @@
+#ifndef SRC_NETWORK_BRIDGE_LINK_HPP_
+#define SRC_NETWORK_BRIDGE_LINK_HPP_
+
+#include <flexcore/scheduler/timing.hpp>
+#include <flexcore/utils/serialisation/byte_span.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fc
+{
+/// Transport of events and states between flexcore processes on different machines.
+namespace net
+{
+
+/// compression of the payload of frames.
+enum class compression : uint32_t
+{
+	none = 0,
+	/// replaces runs of zero bytes by their length, cheap and effective for sparse data.
+	zero_runs = 1
+};
+
+/// parameters of a bridge link.
+struct bridge_config
+{
+	/**
+	 * maximum size of a single datagram, events of one tick which do not fit
+	 * are sent in further datagrams. Must not exceed 65507, the limit of UDP over IPv4.
+	 */
+	size_t max_frame_size = 65000;
+	compression codec = compression::none;
+};
+
+/// values of link_counters at a single point in time.
+struct link_statistics
+{
+	uint64_t frames = 0;
+	uint64_t events = 0;
+	/// bytes of the datagrams, including headers and after compression.
+	uint64_t bytes = 0;
+	/// events which could not be sent or decoded.
+	uint64_t dropped_events = 0;
+	/// frames missing in the sequence of received frames.
+	uint64_t lost_frames = 0;
+	/**
+	 * time between sending and receiving frames, measured with the system clocks
+	 * of both machines, thus only meaningful if they are synchronized.
+	 */
+	thread::histogram_snapshot latency;
+};
+
+/**
+ * \brief throughput and latency counters of one end of a link.
+ * Written by the thread of the region of the node, read from any thread.
+ */
+class link_counters
+{
+public:
+	void count_frame(uint64_t nr_of_events, uint64_t nr_of_bytes) noexcept
+	{
+		frames.fetch_add(1, std::memory_order_relaxed);
+		events.fetch_add(nr_of_events, std::memory_order_relaxed);
+		bytes.fetch_add(nr_of_bytes, std::memory_order_relaxed);
+	}
+	void count_dropped(uint64_t nr_of_events = 1) noexcept
+	{
+		dropped_events.fetch_add(nr_of_events, std::memory_order_relaxed);
+	}
+	void count_lost(uint64_t nr_of_frames) noexcept
+	{
+		lost_frames.fetch_add(nr_of_frames, std::memory_order_relaxed);
+	}
+	void record_latency(wall_clock::steady::duration d) noexcept { latency.record(d); }
+
+	link_statistics snapshot() const noexcept;
+
+private:
+	std::atomic<uint64_t> frames{0};
+	std::atomic<uint64_t> events{0};
+	std::atomic<uint64_t> bytes{0};
+	std::atomic<uint64_t> dropped_events{0};
+	std::atomic<uint64_t> lost_frames{0};
+	thread::duration_histogram latency;
+};
+
+/**
+ * \brief collects serialized events into frames of a bridge link.
+ *
+ * A frame consists of a header with sequence number, send time, number of events
+ * and size of the payload, followed by the payload of events preceded by their sizes.
+ * Buffers are reused for every frame.
+ */
+class frame_writer
+{
+public:
+	explicit frame_writer(const bridge_config& config);
+
+	/// returns true if an event of size bytes still fits into the current frame.
+	bool fits(size_t size) const noexcept;
+	/// returns true if an event of size bytes fits into an empty frame.
+	bool fits_empty(size_t size) const noexcept;
+	/// appends event to the current frame. \pre fits(event.size)
+	void add(const_byte_span event);
+
+	bool empty() const noexcept { return nr_of_events == 0; }
+	size_t size() const noexcept { return nr_of_events; }
+
+	/**
+	 * \brief completes the frame with header and compression and starts the next one.
+	 * \returns the bytes of the frame, valid until the next call of finish.
+	 */
+	const_byte_span finish(uint64_t sequence);
+
+private:
+	bridge_config config;
+	std::vector<char> payload;
+	std::vector<char> frame;
+	uint32_t nr_of_events = 0;
+};
+
+/// reads the events of a frame written by frame_writer.
+class frame_reader
+{
+public:
+	/**
+	 * \brief parses datagram, the reader refers to it until the next parse.
+	 * \returns false if datagram is no valid frame.
+	 */
+	bool parse(const_byte_span datagram);
+
+	/// reads the next event of the frame, \returns false after the last one.
+	bool next(const_byte_span& event) noexcept;
+
+	uint64_t sequence() const noexcept { return sequence_; }
+	/// time of the system clock of the sender when the frame was sent.
+	wall_clock::system::time_point send_time() const noexcept { return send_time_; }
+	size_t size() const noexcept { return nr_of_events; }
+
+private:
+	std::vector<char> decompressed;
+	const char* position = nullptr;
+	const char* end = nullptr;
+	uint64_t sequence_ = 0;
+	wall_clock::system::time_point send_time_;
+	uint32_t nr_of_events = 0;
+	uint32_t remaining = 0;
+};
+
+/// non-blocking UDP socket sending datagrams to a single destination.
+class udp_sender
+{
+public:
+	/// \throws std::system_error if host cannot be resolved or no socket can be opened.
+	udp_sender(const std::string& host, uint16_t port);
+	udp_sender(const udp_sender&) = delete;
+	udp_sender& operator=(const udp_sender&) = delete;
+	~udp_sender();
+
+	/// sends datagram, \returns false if it could not be sent right away.
+	bool send(const_byte_span datagram) noexcept;
+
+private:
+	int socket = -1;
+};
+
+/// non-blocking UDP socket receiving datagrams on a port.
+class udp_receiver
+{
+public:
+	/**
+	 * \param port port to listen on, zero picks a free one, see port().
+	 * \throws std::system_error if the socket cannot be opened or bound.
+	 */
+	explicit udp_receiver(uint16_t port, const std::string& bind_address = "0.0.0.0");
+	udp_receiver(const udp_receiver&) = delete;
+	udp_receiver& operator=(const udp_receiver&) = delete;
+	~udp_receiver();
+
+	/**
+	 * \brief receives a waiting datagram into buffer, which is resized to its size.
+	 * \returns false if no datagram is waiting.
+	 */
+	bool receive(std::vector<char>& buffer) noexcept;
+
+	/// port the socket is bound to.
+	uint16_t port() const noexcept { return port_; }
+
+private:
+	int socket = -1;
+	uint16_t port_ = 0;
+};
+
+} // namespace net
+} // namespace fc
+
+#endif /* SRC_NETWORK_BRIDGE_LINK_HPP_ */
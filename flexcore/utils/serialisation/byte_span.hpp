@@ -0,0 +1,75 @@
+#ifndef SRC_SERIALISATION_BYTE_SPAN_HPP_
+#define SRC_SERIALISATION_BYTE_SPAN_HPP_
+
+#include <cstddef>
+#include <streambuf>
+#include <vector>
+
+namespace fc
+{
+
+/**
+ * \brief View of serialized bytes, which are owned by someone else.
+ *
+ * Spans returned by serializers stay valid until the next call of the serializer.
+ */
+struct const_byte_span
+{
+	const char* data = nullptr;
+	size_t size = 0;
+
+	const char* begin() const noexcept { return data; }
+	const char* end() const noexcept { return data + size; }
+	bool empty() const noexcept { return size == 0; }
+};
+
+/**
+ * \brief Archive tag for serializers, which copies objects bytewise.
+ *
+ * Only usable with trivially copyable types. The layout is the one in memory,
+ * thus serialized objects are only readable on the same platform with the same compiler.
+ */
+struct fixed_layout {};
+
+namespace detail
+{
+/// streambuf appending to a vector, which keeps its capacity between objects.
+class vector_streambuf : public std::streambuf
+{
+public:
+	explicit vector_streambuf(std::vector<char>& buffer) : buffer(buffer) {}
+
+protected:
+	int_type overflow(int_type c) override
+	{
+		if (!traits_type::eq_int_type(c, traits_type::eof()))
+			buffer.push_back(traits_type::to_char_type(c));
+		return traits_type::not_eof(c);
+	}
+
+	std::streamsize xsputn(const char* s, std::streamsize n) override
+	{
+		buffer.insert(buffer.end(), s, s + n);
+		return n;
+	}
+
+private:
+	std::vector<char>& buffer;
+};
+
+/// read-only streambuf over the bytes of a span, does not copy them.
+class span_streambuf : public std::streambuf
+{
+public:
+	explicit span_streambuf(const_byte_span bytes)
+	{
+		// the get area is never written to, streambuf just lacks a const interface.
+		auto* begin = const_cast<char*>(bytes.data);
+		setg(begin, begin, begin + bytes.size);
+	}
+};
+} // namespace detail
+
+} // namespace fc
+
+#endif /* SRC_SERIALISATION_BYTE_SPAN_HPP_ */
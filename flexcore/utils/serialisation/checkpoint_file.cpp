@@ -0,0 +1,248 @@
+#include <flexcore/utils/serialisation/checkpoint_file.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fc
+{
+
+namespace
+{
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+		"checkpoints are published by lock-free atomics in the mapped file.");
+
+constexpr char magic[8] = {'F', 'C', 'C', 'H', 'K', 'P', 'N', 'T'};
+constexpr uint32_t format_version = 1;
+constexpr size_t file_header_size = 4096;
+
+struct file_header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	/// bytes used by the header and all entries.
+	std::atomic<uint64_t> used;
+};
+
+struct entry_header
+{
+	uint64_t key_size;
+	uint64_t slot_capacity;
+	/// set once the entry is replaced by a larger one.
+	std::atomic<uint64_t> superseded;
+};
+
+struct slot_header
+{
+	/// zero while the slot is being written or has never been.
+	std::atomic<uint64_t> sequence;
+	uint64_t size;
+};
+
+/// entries and slots are aligned to 8 bytes, so their headers can be used in place.
+constexpr size_t align(size_t size) { return (size + 7) & ~size_t(7); }
+
+size_t slot_size(size_t capacity) { return sizeof(slot_header) + align(capacity); }
+
+size_t entry_size(size_t key_size, size_t capacity)
+{
+	return sizeof(entry_header) + align(key_size) + 2 * slot_size(capacity);
+}
+
+[[noreturn]] void throw_errno(const char* what)
+{
+	throw std::system_error(errno, std::generic_category(), what);
+}
+
+size_t round_to_pages(size_t size)
+{
+	const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	return std::max(page, (size + page - 1) / page * page);
+}
+
+file_header& header_of(char* mapping) { return *reinterpret_cast<file_header*>(mapping); }
+
+entry_header& entry_at(char* mapping, size_t entry)
+{
+	return *reinterpret_cast<entry_header*>(mapping + entry);
+}
+
+const char* key_of(char* mapping, size_t entry)
+{
+	return mapping + entry + sizeof(entry_header);
+}
+
+slot_header& slot_at(char* mapping, size_t entry, int slot)
+{
+	const auto& e = entry_at(mapping, entry);
+	return *reinterpret_cast<slot_header*>(mapping + entry + sizeof(entry_header)
+			+ align(e.key_size) + slot * slot_size(e.slot_capacity));
+}
+
+/// the newer slot of entry, which may never have been written.
+int newer_slot(char* mapping, size_t entry)
+{
+	return slot_at(mapping, entry, 1).sequence.load(std::memory_order_acquire)
+			> slot_at(mapping, entry, 0).sequence.load(std::memory_order_acquire) ? 1 : 0;
+}
+} // anonymous namespace
+
+constexpr size_t checkpoint_file::default_capacity;
+constexpr size_t checkpoint_file::npos;
+
+checkpoint_file::checkpoint_file(const std::string& path, size_t capacity)
+{
+	const int file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (file < 0)
+		throw_errno("checkpoint_file could not open file");
+	struct stat info{};
+	if (::fstat(file, &info) != 0)
+	{
+		::close(file);
+		throw_errno("checkpoint_file could not read size of file");
+	}
+
+	bool valid = false;
+	if (static_cast<size_t>(info.st_size) >= file_header_size)
+	{
+		char existing[sizeof(magic) + sizeof(uint32_t)];
+		valid = ::pread(file, existing, sizeof(existing), 0) == static_cast<ssize_t>(sizeof(existing))
+				&& std::memcmp(existing, magic, sizeof(magic)) == 0
+				&& std::memcmp(existing + sizeof(magic), &format_version, sizeof(uint32_t)) == 0;
+	}
+	mapping_size = valid ? static_cast<size_t>(info.st_size) : round_to_pages(capacity);
+	if (!valid && (::ftruncate(file, 0) != 0
+			|| ::ftruncate(file, static_cast<off_t>(mapping_size)) != 0))
+	{
+		const auto error = errno;
+		::close(file);
+		errno = error;
+		throw_errno("checkpoint_file could not create file");
+	}
+
+	void* mapped = ::mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	::close(file);
+	if (mapped == MAP_FAILED)
+		throw_errno("checkpoint_file could not map file");
+	mapping = static_cast<char*>(mapped);
+
+	auto& header = header_of(mapping);
+	if (!valid)
+	{
+		// the new file reads as zero, only the header needs to be set.
+		std::memcpy(header.magic, magic, sizeof(magic));
+		header.version = format_version;
+		new (&header.used) std::atomic<uint64_t>(file_header_size);
+		return;
+	}
+
+	// entries written completely are counted in used, thus can be read in place.
+	const auto used = std::min<size_t>(header.used.load(std::memory_order_acquire), mapping_size);
+	for (size_t entry = file_header_size; entry + sizeof(entry_header) <= used;)
+	{
+		const auto& e = entry_at(mapping, entry);
+		const auto size = entry_size(e.key_size, e.slot_capacity);
+		if (size > used - entry)
+			break;
+		if (!e.superseded.load(std::memory_order_acquire))
+			keys[std::string{key_of(mapping, entry), e.key_size}] = entry;
+		entry += size;
+	}
+}
+
+checkpoint_file::~checkpoint_file()
+{
+	::munmap(mapping, mapping_size);
+}
+
+size_t checkpoint_file::find(const std::string& key) const
+{
+	const std::lock_guard<std::mutex> lock{mutex};
+	const auto it = keys.find(key);
+	return it == keys.end() ? npos : it->second;
+}
+
+size_t checkpoint_file::entry(const std::string& key, size_t size)
+{
+	const std::lock_guard<std::mutex> lock{mutex};
+	const auto it = keys.find(key);
+	if (it != keys.end())
+		return it->second;
+	const auto entry = allocate(key, size);
+	keys[key] = entry;
+	return entry;
+}
+
+const_byte_span checkpoint_file::read(size_t entry) const
+{
+	assert(entry != npos);
+	auto& slot = slot_at(mapping, entry, newer_slot(mapping, entry));
+	if (slot.sequence.load(std::memory_order_acquire) == 0)
+		return {};
+	return const_byte_span{reinterpret_cast<const char*>(&slot) + sizeof(slot_header),
+			static_cast<size_t>(slot.size)};
+}
+
+size_t checkpoint_file::write(size_t entry, const_byte_span bytes)
+{
+	assert(entry != npos);
+	auto& e = entry_at(mapping, entry);
+	if (bytes.size > e.slot_capacity)
+	{
+		const std::lock_guard<std::mutex> lock{mutex};
+		std::string key{key_of(mapping, entry), e.key_size};
+		// room to grow, so a growing state does not move with every write.
+		const auto moved = allocate(key, 2 * bytes.size);
+		write(moved, bytes);
+		e.superseded.store(1, std::memory_order_release);
+		keys[key] = moved;
+		return moved;
+	}
+
+	const auto newer = newer_slot(mapping, entry);
+	const auto sequence = slot_at(mapping, entry, newer).sequence.load(std::memory_order_relaxed);
+	auto& slot = slot_at(mapping, entry, 1 - newer);
+	// the older slot is invalid until its bytes are complete.
+	slot.sequence.store(0, std::memory_order_release);
+	std::memcpy(reinterpret_cast<char*>(&slot) + sizeof(slot_header), bytes.data, bytes.size);
+	slot.size = bytes.size;
+	slot.sequence.store(sequence + 1, std::memory_order_release);
+	return entry;
+}
+
+size_t checkpoint_file::used() const noexcept
+{
+	return header_of(mapping).used.load(std::memory_order_acquire);
+}
+
+size_t checkpoint_file::allocate(const std::string& key, size_t size)
+{
+	auto& header = header_of(mapping);
+	const auto entry = static_cast<size_t>(header.used.load(std::memory_order_relaxed));
+	const auto needed = entry_size(key.size(), size);
+	if (needed > mapping_size - entry)
+		throw std::length_error("checkpoint_file is full");
+
+	// a previous process might have died while allocating here.
+	std::memset(mapping + entry, 0, needed);
+	auto& e = entry_at(mapping, entry);
+	e.key_size = key.size();
+	e.slot_capacity = size;
+	std::memcpy(mapping + entry + sizeof(entry_header), key.data(), key.size());
+	header.used.store(entry + needed, std::memory_order_release);
+	return entry;
+}
+
+} // namespace fc
@@ -0,0 +1,81 @@
+#ifndef SRC_SERIALISATION_CHECKPOINT_FILE_HPP_
+#define SRC_SERIALISATION_CHECKPOINT_FILE_HPP_
+
+#include <flexcore/utils/serialisation/byte_span.hpp>
+
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace fc
+{
+
+/**
+ * \brief Memory mapped file of named states, which survives the process writing it.
+ *
+ * The file consists of a header and entries, one for every key.
+ * Every entry has two slots, a write goes to the older one and then publishes it
+ * by its sequence number. If the process dies while writing,
+ * the entry still holds the bytes written before.
+ * States are written in place, only the entries written cost any time.
+ * An entry which outgrows its slots is replaced by a larger one at the end of the file.
+ *
+ * The file is not synced, it survives the crash of the process, not of the system.
+ * Entries are created under a lock, different entries can be written concurrently,
+ * a single entry must only be written and read by one thread at a time.
+ */
+class checkpoint_file
+{
+public:
+	static constexpr size_t default_capacity = 16 << 20;
+	/// returned for keys without an entry.
+	static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+	/**
+	 * \brief opens the checkpoints at path, or creates the file if there are none.
+	 *
+	 * An existing file with other content is replaced.
+	 * \param capacity size of a new file, rounded up to a multiple of the page size.
+	 * \throws std::system_error if the file cannot be opened, created or mapped.
+	 */
+	explicit checkpoint_file(const std::string& path, size_t capacity = default_capacity);
+	checkpoint_file(const checkpoint_file&) = delete;
+	checkpoint_file& operator=(const checkpoint_file&) = delete;
+	~checkpoint_file();
+
+	/// returns the entry of key, npos if there is none.
+	size_t find(const std::string& key) const;
+	/**
+	 * \brief returns the entry of key, creates it with room for size bytes if there is none.
+	 * \throws std::length_error if the file is full.
+	 */
+	size_t entry(const std::string& key, size_t size);
+
+	/// returns the bytes last written to entry, which are valid until it is written again.
+	const_byte_span read(size_t entry) const;
+	/**
+	 * \brief writes bytes to entry.
+	 * \returns the entry of the key now, which changes if the bytes did not fit.
+	 * \throws std::length_error if the bytes did not fit and the file is full.
+	 */
+	size_t write(size_t entry, const_byte_span bytes);
+
+	/// number of bytes of the file used by its header and entries.
+	size_t used() const noexcept;
+	size_t capacity() const noexcept { return mapping_size; }
+
+private:
+	size_t allocate(const std::string& key, size_t size);
+
+	char* mapping = nullptr;
+	size_t mapping_size = 0;
+	/// protects keys and the allocation of entries.
+	mutable std::mutex mutex;
+	std::unordered_map<std::string, size_t> keys;
+};
+
+} // namespace fc
+
+#endif /* SRC_SERIALISATION_CHECKPOINT_FILE_HPP_ */
@@ -1,8 +1,14 @@
 #ifndef SRC_SERIALISATION_DESERIALIZER_HPP_
 #define SRC_SERIALISATION_DESERIALIZER_HPP_
 
+#include <flexcore/utils/serialisation/byte_span.hpp>
+
+#include <cstring>
+#include <istream>
+#include <stdexcept>
 #include <string>
 #include <sstream>
+#include <type_traits>
 
 namespace fc
 {
@@ -27,6 +33,50 @@ public:
 	}
 };
 
+/**
+ * \brief Deserializes data_t from bytes, without copying them into a string.
+ *
+ * Counterpart of buffered_serializer, the bytes are read where they are.
+ * \tparam archive_t type of archive used for deserialization, a Cereal archive or fixed_layout.
+ */
+template<class data_t, class archive_t>
+class span_deserializer
+{
+public:
+	using result_t = data_t;
+	/**
+	 * \throws exception depending on archive used,
+	 * if serialized cannot be deserialized to data_t.
+	 */
+	data_t operator()(const_byte_span serialized)
+	{
+		detail::span_streambuf streambuf{serialized};
+		std::istream stream{&streambuf};
+		data_t output;
+		archive_t{stream}(output);
+		return output;
+	}
+};
+
+/// Deserializes trivially copyable objects by copying their bytes.
+template<class data_t>
+class span_deserializer<data_t, fixed_layout>
+{
+	static_assert(std::is_trivially_copyable<data_t>{},
+			"fixed_layout deserialization copies objects bytewise.");
+public:
+	using result_t = data_t;
+	/// \throws std::invalid_argument if serialized does not have the size of data_t.
+	data_t operator()(const_byte_span serialized)
+	{
+		if (serialized.size != sizeof(data_t))
+			throw std::invalid_argument("size of serialized object does not match its type");
+		data_t output;
+		std::memcpy(&output, serialized.data, sizeof(data_t));
+		return output;
+	}
+};
+
 }
 
 #endif /* SRC_SERIALISATION_DESERIALIZER_HPP_ */
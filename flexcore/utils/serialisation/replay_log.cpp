@@ -0,0 +1,246 @@
+#include <flexcore/utils/serialisation/replay_log.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fc
+{
+
+namespace
+{
+constexpr char magic[8] = {'F', 'C', 'R', 'E', 'P', 'L', 'A', 'Y'};
+constexpr uint32_t format_version = 1;
+/// the file header takes a whole page, so chunks can be mapped at page aligned offsets.
+constexpr size_t file_header_size = 4096;
+
+struct file_header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t chunk_size;
+};
+
+struct chunk_header
+{
+	int64_t first_time;
+	int64_t last_time;
+	/// bytes used by header and records.
+	uint64_t used;
+};
+
+struct record_header
+{
+	int64_t time;
+	uint64_t size;
+};
+
+/// records are aligned to 8 bytes, so their headers can be read in place.
+constexpr size_t align(size_t size) { return (size + 7) & ~size_t(7); }
+
+[[noreturn]] void throw_errno(const char* what)
+{
+	throw std::system_error(errno, std::generic_category(), what);
+}
+
+size_t round_to_pages(size_t size)
+{
+	const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	return std::max(page, (size + page - 1) / page * page);
+}
+} // anonymous namespace
+
+constexpr size_t replay_log_writer::default_chunk_size;
+
+replay_log_writer::replay_log_writer(const std::string& path, size_t chunk_size_)
+	: chunk_size(round_to_pages(chunk_size_))
+	, last_time(std::numeric_limits<virtual_clock::steady::rep>::min())
+{
+	file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (file < 0)
+		throw_errno("replay_log_writer could not create file");
+
+	file_header header{};
+	std::memcpy(header.magic, magic, sizeof(magic));
+	header.version = format_version;
+	header.chunk_size = chunk_size;
+	if (::ftruncate(file, file_header_size) != 0
+			|| ::pwrite(file, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)))
+	{
+		const auto error = errno;
+		::close(file);
+		errno = error;
+		throw_errno("replay_log_writer could not write header");
+	}
+}
+
+replay_log_writer::~replay_log_writer()
+{
+	unmap_chunk();
+	::close(file);
+}
+
+void replay_log_writer::append(virtual_clock::steady::time_point time, const_byte_span bytes)
+{
+	const auto t = time.time_since_epoch().count();
+	if (t < last_time)
+		throw std::invalid_argument("records of a replay log need to be appended in order of time");
+	const auto record_size = sizeof(record_header) + align(bytes.size);
+	if (sizeof(chunk_header) + record_size > chunk_size)
+		throw std::length_error("record does not fit into a chunk of the replay log");
+
+	auto* header = reinterpret_cast<chunk_header*>(chunk);
+	if (!chunk || header->used + record_size > chunk_size)
+	{
+		map_next_chunk();
+		header = reinterpret_cast<chunk_header*>(chunk);
+		header->first_time = t;
+	}
+
+	auto* out = chunk + header->used;
+	const record_header rh{t, bytes.size};
+	std::memcpy(out, &rh, sizeof(rh));
+	std::memcpy(out + sizeof(rh), bytes.data, bytes.size);
+	header->last_time = t;
+	header->used += record_size;
+	last_time = t;
+	++nr_of_records;
+}
+
+void replay_log_writer::map_next_chunk()
+{
+	unmap_chunk();
+	const auto offset = file_header_size + nr_of_chunks * chunk_size;
+	if (::ftruncate(file, static_cast<off_t>(offset + chunk_size)) != 0)
+		throw_errno("replay_log_writer could not grow file");
+	void* mapped = ::mmap(nullptr, chunk_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			file, static_cast<off_t>(offset));
+	if (mapped == MAP_FAILED)
+		throw_errno("replay_log_writer could not map chunk");
+	chunk = static_cast<char*>(mapped);
+	++nr_of_chunks;
+	// new parts of the file read as zero, only used needs to be set.
+	reinterpret_cast<chunk_header*>(chunk)->used = sizeof(chunk_header);
+}
+
+void replay_log_writer::unmap_chunk() noexcept
+{
+	if (!chunk)
+		return;
+	::munmap(chunk, chunk_size);
+	chunk = nullptr;
+}
+
+replay_log_reader::replay_log_reader(const std::string& path)
+{
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		throw_errno("replay_log_reader could not open file");
+	struct stat info{};
+	if (::fstat(file, &info) != 0)
+	{
+		::close(file);
+		throw_errno("replay_log_reader could not read size of file");
+	}
+	mapping_size = static_cast<size_t>(info.st_size);
+	if (mapping_size < file_header_size)
+	{
+		::close(file);
+		throw std::runtime_error("file is too small to be a replay log");
+	}
+	void* mapped = ::mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, file, 0);
+	::close(file);
+	if (mapped == MAP_FAILED)
+		throw_errno("replay_log_reader could not map file");
+	mapping = static_cast<const char*>(mapped);
+
+	file_header header;
+	std::memcpy(&header, mapping, sizeof(header));
+	if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != format_version
+			|| header.chunk_size < sizeof(chunk_header))
+	{
+		::munmap(const_cast<char*>(mapping), mapping_size);
+		throw std::runtime_error("file is no replay log of a known version");
+	}
+	chunk_size = header.chunk_size;
+	nr_of_chunks = (mapping_size - file_header_size) / chunk_size;
+}
+
+replay_log_reader::~replay_log_reader()
+{
+	::munmap(const_cast<char*>(mapping), mapping_size);
+}
+
+const char* replay_log_reader::chunk_begin(size_t chunk) const noexcept
+{
+	return mapping + file_header_size + chunk * chunk_size;
+}
+
+void replay_log_reader::normalize(position& pos) const noexcept
+{
+	while (pos.chunk < nr_of_chunks)
+	{
+		const auto* header = reinterpret_cast<const chunk_header*>(chunk_begin(pos.chunk));
+		if (pos.offset < header->used)
+			return;
+		++pos.chunk;
+		pos.offset = sizeof(chunk_header);
+	}
+}
+
+replay_log_reader::position replay_log_reader::begin() const noexcept
+{
+	position pos{0, sizeof(chunk_header)};
+	normalize(pos);
+	return pos;
+}
+
+replay_log_reader::position replay_log_reader::seek(virtual_clock::steady::time_point time) const
+{
+	const auto t = time.time_since_epoch().count();
+	// first chunk whose last record is not before t, chunks are ordered by time.
+	size_t low = 0;
+	size_t high = nr_of_chunks;
+	while (low < high)
+	{
+		const auto mid = low + (high - low) / 2;
+		const auto* header = reinterpret_cast<const chunk_header*>(chunk_begin(mid));
+		if (header->used == sizeof(chunk_header) || header->last_time < t)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	position pos{low, sizeof(chunk_header)};
+	normalize(pos);
+	auto next = pos;
+	replay_record record;
+	while (read(next, record) && record.time < time)
+		pos = next;
+	return pos;
+}
+
+bool replay_log_reader::read(position& pos, replay_record& record) const
+{
+	normalize(pos);
+	if (pos.chunk >= nr_of_chunks)
+		return false;
+	const auto* in = chunk_begin(pos.chunk) + pos.offset;
+	const auto* header = reinterpret_cast<const record_header*>(in);
+	record.time = virtual_clock::steady::time_point{virtual_clock::steady::duration{header->time}};
+	record.bytes = const_byte_span{in + sizeof(record_header), static_cast<size_t>(header->size)};
+	pos.offset += sizeof(record_header) + align(header->size);
+	normalize(pos);
+	return true;
+}
+
+} // namespace fc
@@ -0,0 +1,116 @@
+#ifndef SRC_SERIALISATION_REPLAY_LOG_HPP_
+#define SRC_SERIALISATION_REPLAY_LOG_HPP_
+
+#include <flexcore/scheduler/clock.hpp>
+#include <flexcore/utils/serialisation/byte_span.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace fc
+{
+
+/**
+ * \brief Appends timestamped records to a memory mapped replay log file.
+ *
+ * The file consists of a header followed by chunks of fixed size.
+ * Every chunk starts with the time of its first and last record and the number of bytes used,
+ * records follow each other and never cross chunks.
+ * Only the chunk currently written is mapped, its header is updated with every record,
+ * thus the file stays readable if the writer does not close it properly.
+ *
+ * \invariant times of appended records are not decreasing.
+ */
+class replay_log_writer
+{
+public:
+	static constexpr size_t default_chunk_size = 1 << 20;
+
+	/**
+	 * \brief creates the file at path, replacing an existing one.
+	 * \param chunk_size size of chunks, rounded up to a multiple of the page size.
+	 * \throws std::system_error if the file cannot be created or mapped.
+	 */
+	explicit replay_log_writer(const std::string& path, size_t chunk_size = default_chunk_size);
+	replay_log_writer(const replay_log_writer&) = delete;
+	replay_log_writer& operator=(const replay_log_writer&) = delete;
+	~replay_log_writer();
+
+	/**
+	 * \brief appends a record of bytes at time.
+	 * \throws std::invalid_argument if time is before the time of the last record.
+	 * \throws std::length_error if the record does not fit into a chunk.
+	 */
+	void append(virtual_clock::steady::time_point time, const_byte_span bytes);
+
+	/// number of records appended so far.
+	size_t size() const noexcept { return nr_of_records; }
+
+private:
+	void map_next_chunk();
+	void unmap_chunk() noexcept;
+
+	int file = -1;
+	size_t chunk_size;
+	size_t nr_of_chunks = 0;
+	size_t nr_of_records = 0;
+	char* chunk = nullptr;
+	virtual_clock::steady::rep last_time;
+};
+
+/// a record read from a replay log, bytes point into the mapped file.
+struct replay_record
+{
+	virtual_clock::steady::time_point time;
+	const_byte_span bytes;
+};
+
+/**
+ * \brief Reads a replay log written by replay_log_writer from a read-only mapping of the file.
+ *
+ * Records are read in place, seeking to a time searches the chunk headers
+ * and then the records of a single chunk.
+ * Reading does not modify the reader, any number of positions can be read concurrently.
+ */
+class replay_log_reader
+{
+public:
+	/// position of a record in the log.
+	struct position
+	{
+		size_t chunk = 0;
+		size_t offset = 0;
+	};
+
+	/// \throws std::system_error if the file cannot be opened, std::runtime_error if it is no replay log.
+	explicit replay_log_reader(const std::string& path);
+	replay_log_reader(const replay_log_reader&) = delete;
+	replay_log_reader& operator=(const replay_log_reader&) = delete;
+	~replay_log_reader();
+
+	/// position of the first record.
+	position begin() const noexcept;
+	/// position of the first record at or after time, the end if there is none.
+	position seek(virtual_clock::steady::time_point time) const;
+
+	/**
+	 * \brief reads the record at pos and advances pos to the next one.
+	 * \returns false if pos is at the end of the log.
+	 */
+	bool read(position& pos, replay_record& record) const;
+
+private:
+	const char* chunk_begin(size_t chunk) const noexcept;
+	/// skips to the next chunk, if pos is behind the last record of its chunk.
+	void normalize(position& pos) const noexcept;
+
+	const char* mapping = nullptr;
+	size_t mapping_size = 0;
+	size_t chunk_size = 0;
+	size_t nr_of_chunks = 0;
+};
+
+} // namespace fc
+
+#endif /* SRC_SERIALISATION_REPLAY_LOG_HPP_ */
@@ -1,8 +1,14 @@
 #ifndef SRC_SERIALISATION_SERIALIZER_HPP_
 #define SRC_SERIALISATION_SERIALIZER_HPP_
 
+#include <flexcore/utils/serialisation/byte_span.hpp>
+
+#include <cstring>
+#include <ostream>
 #include <string>
 #include <sstream>
+#include <type_traits>
+#include <vector>
 
 namespace fc
 {
@@ -33,5 +39,61 @@ public:
 private:
 };
 
+/**
+ * \brief Serializes inputs of given type into a buffer, which is reused for every object.
+ *
+ * Unlike single_object_serializer, no stream and string are constructed per object,
+ * once the buffer has grown to the size of the largest object, serializing does not allocate.
+ * Returns a view of the buffer, which is valid until the next call.
+ *
+ * \tparam data_t type of data to serialize.
+ * \tparam archive_t type of archive used for serialization, a Cereal archive or fixed_layout.
+ */
+template<class data_t, class archive_t>
+class buffered_serializer
+{
+public:
+	using result_t = const_byte_span;
+
+	buffered_serializer() = default;
+	// the streambuf refers to the buffer of this object.
+	buffered_serializer(const buffered_serializer&) : buffered_serializer() {}
+	buffered_serializer& operator=(const buffered_serializer&) { return *this; }
+
+	const_byte_span operator()(const data_t& in)
+	{
+		buffer.clear();
+		{
+			archive_t archive{stream};
+			archive(in);
+		}
+		return const_byte_span{buffer.data(), buffer.size()};
+	}
+
+private:
+	std::vector<char> buffer;
+	detail::vector_streambuf streambuf{buffer};
+	std::ostream stream{&streambuf};
+};
+
+/// Serializes trivially copyable objects by copying their bytes into the buffer.
+template<class data_t>
+class buffered_serializer<data_t, fixed_layout>
+{
+	static_assert(std::is_trivially_copyable<data_t>{},
+			"fixed_layout serialization copies objects bytewise.");
+public:
+	using result_t = const_byte_span;
+
+	const_byte_span operator()(const data_t& in) noexcept
+	{
+		std::memcpy(buffer, &in, sizeof(data_t));
+		return const_byte_span{buffer, sizeof(data_t)};
+	}
+
+private:
+	char buffer[sizeof(data_t)];
+};
+
 }  // namespace fc
 #endif /* SRC_SERIALISATION_SERIALIZER_HPP_ */
@@ -5,10 +5,188 @@
 #include <cereal/archives/json.hpp>
 #include <boost/lexical_cast.hpp>
 
+#include <cctype>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
 namespace fc
 {
 
-///Facade for setting which reads values from json.
+namespace detail
+{
+/// scanner of json text, which only finds the ends of values without parsing them.
+class json_scanner
+{
+public:
+	explicit json_scanner(const std::string& text)
+		: text(text)
+	{
+	}
+
+	/**
+	 * \brief Splits the members of the json object in text into separate documents.
+	 *
+	 * Every member is stored under its key as a json object containing only this member.
+	 * \throw ::cereal::Exception if text is no json object.
+	 */
+	std::unordered_map<std::string, std::string> split_object()
+	{
+		std::unordered_map<std::string, std::string> result;
+		skip_space();
+		expect('{');
+		skip_space();
+		if (peek() == '}')
+		{
+			++pos;
+			finish();
+			return result;
+		}
+		while (true)
+		{
+			const auto key_begin = pos;
+			const auto key = read_key();
+			const auto raw_key = text.substr(key_begin, pos - key_begin);
+			skip_space();
+			expect(':');
+			skip_space();
+			const auto value_begin = pos;
+			skip_value();
+			result[key] = "{" + raw_key + ":" + text.substr(value_begin, pos - value_begin) + "}";
+			skip_space();
+			if (peek() == ',')
+			{
+				++pos;
+				skip_space();
+				continue;
+			}
+			expect('}');
+			finish();
+			return result;
+		}
+	}
+
+private:
+	[[noreturn]] void fail() const
+	{
+		throw ::cereal::Exception("json syntax error at offset " + std::to_string(pos));
+	}
+
+	char peek() const
+	{
+		if (pos >= text.size())
+			fail();
+		return text[pos];
+	}
+
+	void expect(char c)
+	{
+		if (peek() != c)
+			fail();
+		++pos;
+	}
+
+	void skip_space()
+	{
+		while (pos != text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+			++pos;
+	}
+
+	void finish()
+	{
+		skip_space();
+		if (pos != text.size())
+			fail();
+	}
+
+	/// reads a string including quotes, returns its content with simple escapes resolved.
+	std::string read_key()
+	{
+		expect('"');
+		std::string key;
+		while (peek() != '"')
+		{
+			if (text[pos] == '\\')
+				++pos;
+			key += peek();
+			++pos;
+		}
+		++pos;
+		return key;
+	}
+
+	void skip_string()
+	{
+		expect('"');
+		while (peek() != '"')
+			pos += text[pos] == '\\' ? 2 : 1;
+		++pos;
+	}
+
+	void skip_value()
+	{
+		const char c = peek();
+		if (c == '"')
+			return skip_string();
+		if (c == '{' || c == '[')
+		{
+			const char close = c == '{' ? '}' : ']';
+			++pos;
+			skip_space();
+			if (peek() == close)
+			{
+				++pos;
+				return;
+			}
+			while (true)
+			{
+				if (close == '}')
+				{
+					skip_string();
+					skip_space();
+					expect(':');
+					skip_space();
+				}
+				skip_value();
+				skip_space();
+				if (peek() != ',')
+					break;
+				++pos;
+				skip_space();
+			}
+			expect(close);
+			return;
+		}
+		// numbers, true, false and null.
+		const auto begin = pos;
+		while (pos != text.size() && (std::isalnum(static_cast<unsigned char>(text[pos]))
+				|| text[pos] == '-' || text[pos] == '+' || text[pos] == '.'))
+			++pos;
+		if (pos == begin)
+			fail();
+	}
+
+	const std::string& text;
+	size_t pos = 0;
+};
+
+inline std::unordered_map<std::string, std::string> split_json_object(std::istream& stream)
+{
+	const std::string text(
+			std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>{});
+	return json_scanner(text).split_object();
+}
+} // namespace detail
+
+/**
+ * \brief Facade for setting which reads values from json.
+ *
+ * The document is read once on construction and split into its members,
+ * registering a setting only parses the value of its own member.
+ * Thus startup time grows with the size of the document
+ * and not with the number of settings times the size of the document.
+ */
 class json_file_setting_facade
 {
 public:
@@ -21,7 +199,7 @@ public:
 	 * by json parser, e.g. if syntax is wrong.
 	 */
 	explicit json_file_setting_facade(std::istream& stream)
-		try : archive(stream)
+		try : members(detail::split_json_object(stream))
 	{
 	}
 	catch (const ::cereal::Exception& ex)
@@ -52,6 +230,11 @@ public:
 		assert(constraint(initial_v));
 		try
 		{
+			const auto member = members.find(id.key);
+			if (member == members.end())
+				throw ::cereal::Exception("no value found");
+			std::istringstream stream(member->second);
+			cereal::JSONInputArchive archive(stream);
 			auto value = initial_v;
 			archive(cereal::make_nvp(id.key, value));
 			if (constraint(value))
@@ -89,7 +272,8 @@ public:
 	}
 
 private:
-	cereal::JSONInputArchive archive;
+	/// json objects containing a single member of the document by key.
+	std::unordered_map<std::string, std::string> members;
 };
 
 }  // namespace fc
@@ -1,9 +1,12 @@
 #ifndef SRC_SETTINGS_SETTINGS_HPP_
 #define SRC_SETTINGS_SETTINGS_HPP_
 
+#include <atomic>
 #include <cassert>
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 namespace fc
 {
@@ -59,7 +62,10 @@ public:
 		setter(initial_v);
 	}
 
-	///register setting at facade together with parallel_region
+	/**
+	 * \brief register setting at facade together with parallel_region
+	 * The region is not needed, since values of this facade never change.
+	 */
 	template<class data_t, class setter_t, class region_, class constraint_t>
 	void register_setting(setting_id id,
 			data_t initial_v,
@@ -71,6 +77,45 @@ public:
 	}
 };
 
+namespace detail
+{
+/**
+ * \brief Current value of a setting as an immutable snapshot.
+ *
+ * Readers share ownership of the snapshot they load,
+ * thus it stays valid as long as they hold it, no matter how often the value changes.
+ * A store publishes a new snapshot, the replaced one is freed by its last reader.
+ * Neither readers nor writers take a lock of their own.
+ */
+template<class data_t>
+class setting_cache
+{
+public:
+	explicit setting_cache(data_t initial)
+		: current(std::make_shared<const data_t>(std::move(initial)))
+	{
+	}
+
+	setting_cache(const setting_cache&) = delete;
+	setting_cache& operator=(const setting_cache&) = delete;
+
+	std::shared_ptr<const data_t> load() const noexcept
+	{
+		return std::atomic_load_explicit(&current, std::memory_order_acquire);
+	}
+
+	void store(data_t value)
+	{
+		std::atomic_store_explicit(&current,
+				std::shared_ptr<const data_t>(std::make_shared<const data_t>(std::move(value))),
+				std::memory_order_release);
+	}
+
+private:
+	std::shared_ptr<const data_t> current;
+};
+} // namespace detail
+
 /**
  * \brief Provides access to values which can be configured by the user.
  *
@@ -79,6 +124,11 @@ public:
  *
  * \invariant will always contain valid state of data_t. cache != nullptr
  *
+ * Reading the setting never waits for a new value to be stored.
+ * snapshot() shares the current value without copying it, it stays valid while held.
+ * Settings constructed with a parallel_region only change on its switch tick,
+ * thus they return the same value in every work tick of a cycle.
+ *
  * The Constructor will fail and throw an exception if value cannot be loaded.
  */
 template<class data_t>
@@ -103,13 +153,39 @@ public:
 			backend_facade& backend,
 			data_t initial_value,
 			constraint_t constraint = constraint_t{})
-		: cache(std::make_shared<data_t>(initial_value))
+		: cache(std::make_shared<detail::setting_cache<data_t>>(initial_value))
 	{
 		assert(constraint(initial_value));
 		backend.register_setting(
 				std::move(id), //unique id of setting in registry
 				std::move(initial_value), //initial value, in case it needs to be stored
-				[c = this->cache](data_t i){ *c = i; }, //callback to let registry write cache
+				[c = this->cache](data_t i){ c->store(std::move(i)); }, //callback to let registry write cache
+				std::move(constraint)
+				);
+
+		assert(cache != nullptr);
+	}
+
+	/**
+	 * \brief Constructs Setting, whose new values are applied on the switch tick of region.
+	 * \param region parallel_region in which the setting is read.
+	 * The other parameters are the same as in the constructor without region.
+	 */
+	template <class backend_facade, class region_t, class constraint_t = always_valid,
+			class = decltype(std::declval<region_t&>().switch_tick())>
+	setting(setting_id id,
+			backend_facade& backend,
+			region_t& region,
+			data_t initial_value,
+			constraint_t constraint = constraint_t{})
+		: cache(std::make_shared<detail::setting_cache<data_t>>(initial_value))
+	{
+		assert(constraint(initial_value));
+		backend.register_setting(
+				std::move(id),
+				std::move(initial_value),
+				[c = this->cache](data_t i){ c->store(std::move(i)); },
+				region,
 				std::move(constraint)
 				);
 
@@ -123,14 +199,25 @@ public:
 	data_t operator()() const
 	{
 		assert(cache != nullptr);
-		return *cache;
+		return *cache->load();
+	}
+
+	/**
+	 * \return Returns the setting's current value without copying it.
+	 * The value stays valid while the pointer is held, even if the setting changes.
+	 * \post return value != nullptr
+	 */
+	std::shared_ptr<const data_t> snapshot() const noexcept
+	{
+		assert(cache != nullptr);
+		return cache->load();
 	}
 
 private:
 	//cache is a shared_ptr since references store a callback to set the cache.
 	//Making the cache a shared_ptr allows users to move and copy the setting
 	//without causing dangling references in the backend.
-	std::shared_ptr<data_t> cache;
+	std::shared_ptr<detail::setting_cache<data_t>> cache;
 };
 
 } // namesapce fc
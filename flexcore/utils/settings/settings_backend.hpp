@@ -14,9 +14,16 @@
 
 #include <cereal/archives/json.hpp>
 
+#include <atomic>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <cassert>
 #include <exception>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace fc
 {
@@ -29,105 +36,124 @@ struct setting_constraint_violation : std::runtime_error
 namespace detail
 {
 
-///Type Erasure for settings setter
-class serialized_setting
-{
-public:
-	serialized_setting() = default;
-	virtual ~serialized_setting() = default;
-	virtual void write(const std::string& val) = 0;
-
-	serialized_setting(const serialized_setting&) = delete;
-	serialized_setting(serialized_setting&&) = delete;
-};
-
-template<class data_t, template<class>class Deserializer, class Setting>
-class setting_model final: public serialized_setting
-{
-public:
-	explicit setting_model(Setting s)
-		: serialized_setting()
-		, setting(std::move(s))
-	{
-	}
-
-	///write deserialized value to setting
-	void write(const std::string& val) override final
-	{
-		setting(Deserializer<data_t>{}(val));
-	}
-private:
-	Setting setting;
-};
+/// function which applies a deserialized and validated value to a setting.
+using setting_update = std::function<void()>;
 
 /**
- * \brief stores new setting value on changed and forwards on switch tick
+ * \brief collects updates of all settings of a region and applies them on its switch tick.
  *
- * \tparam data_t value stored in setting
- * \tparam callback_t callback from setting which sets new value
+ * Batches are handed over through an atomic pointer,
+ * neither writers nor the switch tick wait for each other.
+ * All updates staged together are applied in the same switch tick,
+ * thus every cycle sees a consistent configuration.
+ * Of several updates staged for a setting during one cycle, only the last one is applied,
+ * so every setting changes at most once per switch tick.
  */
-template<class data_t, class callback_t>
-class setting_forwarder
+class setting_update_batch
 {
 public:
-	explicit setting_forwarder(callback_t c)
-		: callback(std::move(c))
-		, forward_port([this](){ forward_if_changed();})
+	/// updates by the setting they write to.
+	using updates = std::map<const void*, setting_update>;
+
+	setting_update_batch()
+		: apply_port([this](){ apply_staged(); })
 	{
 	}
 
-	setting_forwarder(setting_forwarder&&) = delete;
-	setting_forwarder(const setting_forwarder&) = delete;
-
-	auto& in_forward() { return forward_port; }
+	setting_update_batch(const setting_update_batch&) = delete;
+	setting_update_batch& operator=(const setting_update_batch&) = delete;
 
-	void operator()(data_t in)
+	~setting_update_batch()
 	{
-		buffer = in;
-		changed = true;
+		delete staged.load(std::memory_order_relaxed);
 	}
 
-private:
-	callback_t callback;
-	bool changed = false;
-	fc::pure::event_sink<void> forward_port;
-	data_t buffer = data_t();
+	/// connect to the switch tick of the region.
+	auto& in_apply() { return apply_port; }
 
-	void forward_if_changed()
+	/// stages updates to be applied together on the next switch tick.
+	void stage(updates new_updates)
 	{
-		if (changed)
+		std::lock_guard<std::mutex> lock(writers);
+		std::unique_ptr<updates> batch{staged.exchange(nullptr, std::memory_order_acq_rel)};
+		if (batch)
+		{
+			for (auto& update : new_updates)
+				(*batch)[update.first] = std::move(update.second);
+		}
+		else
 		{
-			callback(buffer);
-			changed = false;
+			batch = std::make_unique<updates>(std::move(new_updates));
 		}
+		staged.store(batch.release(), std::memory_order_release);
 	}
+
+private:
+	void apply_staged()
+	{
+		std::unique_ptr<updates> batch{staged.exchange(nullptr, std::memory_order_acq_rel)};
+		if (!batch)
+			return;
+		for (auto& update : *batch)
+			update.second();
+	}
+
+	/// only serializes writers, the switch tick never locks it.
+	std::mutex writers;
+	std::atomic<updates*> staged{nullptr};
+	fc::pure::event_sink<void> apply_port;
+};
+
+///Type Erasure for settings setter
+class serialized_setting
+{
+public:
+	serialized_setting() = default;
+	virtual ~serialized_setting() = default;
+
+	/**
+	 * \brief deserializes and validates val without changing the setting.
+	 * \returns function which writes the value to the setting.
+	 */
+	virtual setting_update prepare(const std::string& val) const = 0;
+	/// batch the updates of setting are staged in, nullptr if they are applied at once.
+	virtual setting_update_batch* batch() const noexcept = 0;
+
+	serialized_setting(const serialized_setting&) = delete;
+	serialized_setting(serialized_setting&&) = delete;
 };
 
-template<class data_t, class callback_t, class constraint_t>
-struct forward_holder
+template<class data_t, template<class>class Deserializer, class Setting, class constraint_t>
+class setting_model final: public serialized_setting
 {
-	explicit forward_holder(callback_t c, constraint_t constraint)
-		: internal{std::make_unique<setting_forwarder<data_t, callback_t>>(c)}
-		, constraint(constraint)
+public:
+	setting_model(Setting s, constraint_t c, std::shared_ptr<setting_update_batch> b)
+		: serialized_setting()
+		, setting(std::move(s))
+		, constraint(std::move(c))
+		, update_batch(std::move(b))
 	{
 	}
 
-	void operator()(data_t in)
+	setting_update prepare(const std::string& val) const override final
 	{
-		if (!constraint(in))
+		auto value = Deserializer<data_t>{}(val);
+		if (!constraint(value))
 			throw setting_constraint_violation{
 					"new setting value violated constraint"};
-		(*internal)(in);
+		auto s = setting;
+		return [s, value]() mutable { s(std::move(value)); };
 	}
 
-	fc::pure::event_sink<void>& in_forward()
+	setting_update_batch* batch() const noexcept override final
 	{
-		return internal->in_forward();
+		return update_batch.get();
 	}
 
 private:
-	std::unique_ptr<setting_forwarder<data_t, callback_t>> internal;
+	Setting setting;
 	constraint_t constraint;
+	std::shared_ptr<setting_update_batch> update_batch;
 };
 
 } //namespace detail
@@ -154,53 +180,93 @@ public:
 	 * \brief Writes a serialized value to a setting identified by its id
 	 * \param id Identifier of the Setting
 	 * \param val serialized value to be written to setting
-	 * \post the setting corresponding to id has a value, which does not violate it's constraint
+	 * \post the setting corresponding to id has a value, which does not violate it's constraint.
+	 * Settings registered with a region receive the value on the next switch tick of the region.
 	 * \throws std::out_of_range if no setting with id is registered
 	 * \throws deserialisation failure if val cannot be deserialized to setting value.
 	 * \throws setting_constraint_violation if deserialized value violates constraint of setting.
 	 */
 	void write(const setting_id& id, const std::string& val)
 	{
-		try
+		write({{id, val}});
+	}
+
+	/**
+	 * \brief Writes serialized values to several settings at once.
+	 *
+	 * All values are deserialized and validated before any setting is changed,
+	 * if one of them fails, no setting changes.
+	 * The values of all settings registered with the same region
+	 * are applied together on the same switch tick of the region.
+	 * \throws the same exceptions as writing a single setting.
+	 */
+	void write(const std::vector<std::pair<setting_id, std::string>>& values)
+	{
+		struct prepared
+		{
+			const detail::serialized_setting* setting;
+			detail::setting_update update;
+		};
+		std::vector<prepared> updates;
+		updates.reserve(values.size());
+		for (const auto& value : values)
 		{
-			settings.at(id)->write(val);
+			const auto& setting = find(value.first);
+			updates.push_back(prepared{&setting, setting.prepare(value.second)});
 		}
-		catch(const std::out_of_range& /*ex*/)
+
+		std::map<detail::setting_update_batch*, detail::setting_update_batch::updates> batches;
+		for (auto& update : updates)
 		{
-			//we don't really care for the original message, which is just "map::at"
-			std::out_of_range additional_info{
-				"settings_backend no setting found with id: " + id.key
-			};
-			throw additional_info;
+			if (auto* batch = update.setting->batch())
+				batches[batch][update.setting] = std::move(update.update);
+			else
+				update.update();
 		}
+		for (auto& batch : batches)
+			batch.first->stage(std::move(batch.second));
 	}
 
 	/**
 	 * \brief Registers a new Setting ad the setting_backend, called by setting_facade
 	 * \param id Identifier of the setting
 	 * \param setting Callback to set new values
+	 * \param constraint checked for every new value before it is passed to setting.
+	 * \param batch batch the new values are staged in, nullptr to pass them at once.
 	 * \pre no setting with identifier == id is registered
 	 * \post setting is registered with id in the backend
 	 */
-	template<class data_t, class Calllback>
-	void register_setting(setting_id id, Calllback setting)
+	template<class data_t, class Calllback, class constraint_t = always_valid>
+	void register_setting(setting_id id, Calllback setting,
+			constraint_t constraint = constraint_t{},
+			std::shared_ptr<detail::setting_update_batch> batch = nullptr)
 	{
 		assert(settings.count(id) == 0);
 		settings.emplace(
 				std::move(id),
-				make_setting_model<data_t>(std::move(setting))
+				make_setting_model<data_t>(
+						std::move(setting), std::move(constraint), std::move(batch))
 				);
 	}
 
 private:
 
+	const detail::serialized_setting& find(const setting_id& id) const
+	{
+		const auto setting = settings.find(id);
+		if (setting == settings.end())
+			throw std::out_of_range{"settings_backend no setting found with id: " + id.key};
+		return *setting->second;
+	}
+
 	/// helper method to create setting model with deduced types
-	template<class data_t, class T>
-	static auto make_setting_model(T setting)
+	template<class data_t, class T, class constraint_t>
+	static auto make_setting_model(T setting, constraint_t constraint,
+			std::shared_ptr<detail::setting_update_batch> batch)
 	{
 		return std::make_unique<
-				detail::setting_model<data_t, deserializer, T>>(
-						std::move(setting));
+				detail::setting_model<data_t, deserializer, T, constraint_t>>(
+						std::move(setting), std::move(constraint), std::move(batch));
 	}
 
 
@@ -239,21 +305,15 @@ public:
 		assert(constraint(initial_v));
 		setter(initial_v);
 
-		auto set_value = [constraint, setter](const data_t& v)
-		{
-			if(constraint(v))
-				setter(v);
-			else
-				throw setting_constraint_violation{
-						"new setting value violated constraint"};
-		};
-
-		backend.register_setting<data_t>(std::move(id), set_value);
+		backend.register_setting<data_t>(std::move(id), std::move(setter), std::move(constraint));
 	}
 
 	/**
 	 * \brief registers Setting together with region.
 	 * used by the ctor of fc::setting.
+	 *
+	 * New values of all settings of the region are staged in one batch
+	 * and applied together on the switch tick of the region.
 	 */
 	template<class data_t, class setter_t, class region_t, class constraint_t>
 	void register_setting(
@@ -266,18 +326,27 @@ public:
 		assert(constraint(initial_v));
 		setter(initial_v);
 
-		//the forward_holder checks the constraint when a new value is set.
-		detail::forward_holder<data_t,setter_t, constraint_t>
-				forwarder{setter, constraint};
-
-		using fc::operator>>;
-		region.switch_tick() >> forwarder.in_forward();
-
-		backend.register_setting<data_t>(std::move(id), std::move(forwarder));
+		backend.register_setting<data_t>(std::move(id), std::move(setter),
+				std::move(constraint), batch_of(region));
 	}
 
 private:
+	template<class region_t>
+	std::shared_ptr<detail::setting_update_batch> batch_of(region_t& region)
+	{
+		auto& batch = batches[&region];
+		if (!batch)
+		{
+			batch = std::make_shared<detail::setting_update_batch>();
+			using fc::operator>>;
+			region.switch_tick() >> batch->in_apply();
+		}
+		return batch;
+	}
+
 	settings_backend& backend;
+	/// batches of updates by region, shared with the settings in the backend.
+	std::map<const void*, std::shared_ptr<detail::setting_update_batch>> batches;
 };
 
 } //namespace fc
@@ -106,4 +106,45 @@ BOOST_AUTO_TEST_CASE(test_constexpr_connectables)
 	static_assert(con(1) == 1, "");
 }
 
+BOOST_AUTO_TEST_CASE(test_constexpr_calibration_chain)
+{
+	constexpr auto celsius_to_fahrenheit = multiply(1.8) >> add(32.0);
+	static_assert(celsius_to_fahrenheit(100.0) == 212.0, "");
+	static_assert(celsius_to_fahrenheit(0.0) == 32.0, "");
+
+	constexpr auto limited = constant(5) >> multiply(3) >> clamp(0, 10);
+	static_assert(limited() == 10, "");
+}
+
+BOOST_AUTO_TEST_CASE(test_constant_folding)
+{
+	// two multiplies of the same floating point type collapse into one.
+	constexpr auto gain = multiply(2.0) >> multiply(4.0);
+	static_assert(std::is_same<std::decay_t<decltype(gain)>,
+			std::decay_t<decltype(multiply(8.0))>>{}, "");
+	static_assert(gain(1.5) == 12.0, "");
+
+	constexpr auto offset = add(1.0) >> add(2.0) >> add(3.0);
+	static_assert(std::is_same<std::decay_t<decltype(offset)>,
+			std::decay_t<decltype(add(6.0))>>{}, "");
+	BOOST_CHECK_EQUAL(offset(1.0), 7.0);
+
+	BOOST_CHECK_EQUAL((subtract(1.0) >> subtract(2.0))(4.0), 1.0);
+
+	// folding at the end of a chain keeps the head of the chain.
+	double x = 1.0;
+	auto chain = [&x](){ return x; } >> multiply(2.0) >> multiply(3.0);
+	static_assert(std::is_same<decltype(chain.sink),
+			std::decay_t<decltype(multiply(6.0))>>{}, "");
+	BOOST_CHECK_EQUAL(chain(), 6.0);
+	x = 2.0;
+	BOOST_CHECK_EQUAL(chain(), 12.0);
+
+	// integral constants are not folded, as their product might overflow.
+	auto integral = multiply(2) >> multiply(3);
+	static_assert(!std::is_same<std::decay_t<decltype(integral)>,
+			std::decay_t<decltype(multiply(6))>>{}, "");
+	BOOST_CHECK_EQUAL(integral(1), 6);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,88 @@
+#include <boost/test/unit_test.hpp>
+
+#include <flexcore/core/cow.hpp>
+#include <flexcore/extended/nodes/buffer.hpp>
+#include <flexcore/extended/ports/connection_buffer.hpp>
+#include <flexcore/ports.hpp>
+
+#include "nodes/owning_node.hpp"
+
+#include <vector>
+
+using namespace fc;
+
+BOOST_AUTO_TEST_SUITE(test_cow)
+
+namespace
+{
+using big_state = std::vector<int>;
+using shared_state = cow<big_state>;
+}
+
+BOOST_AUTO_TEST_CASE(test_write_clones_shared_values)
+{
+	shared_state state{big_state(1000, 1)};
+	BOOST_CHECK(state.unique());
+	const auto* original = &state.get();
+	// an unshared value is modified in place.
+	state.write()[0] = 2;
+	BOOST_CHECK_EQUAL(&state.get(), original);
+
+	auto copy = state;
+	BOOST_CHECK(copy.shares(state));
+	BOOST_CHECK_EQUAL(state.use_count(), 2);
+	copy.write()[0] = 3;
+	BOOST_CHECK(!copy.shares(state));
+	BOOST_CHECK_EQUAL(state.get()[0], 2);
+	BOOST_CHECK_EQUAL(copy->at(0), 3);
+	BOOST_CHECK_EQUAL(&state.get(), original);
+
+	BOOST_CHECK(state != copy);
+	copy.write()[0] = 2;
+	BOOST_CHECK(state == copy);
+	BOOST_CHECK((make_cow<big_state>(3, 7).get() == big_state{7, 7, 7}));
+}
+
+BOOST_AUTO_TEST_CASE(test_ports_share_values)
+{
+	static_assert(is_passive_source<pure::state_source<shared_state>>{}, "");
+	static_assert(std::is_same<result_of_t<pure::state_source<shared_state>>, shared_state>{}, "");
+
+	shared_state state{big_state(1000, 1)};
+	pure::state_source<shared_state> source{[&state]() { return state; }};
+	pure::state_sink<shared_state> sink;
+	source >> sink;
+	BOOST_CHECK(sink.get().shares(state));
+
+	// buffers between regions only copy the reference.
+	state_buffer<shared_state> buffer;
+	pure::state_sink<shared_state> remote;
+	source >> buffer.in();
+	buffer.out() >> remote;
+	buffer.work_tick()();
+	buffer.switch_active_passive_tick()();
+	BOOST_CHECK(remote.get().shares(state));
+	state.write()[0] = 2;
+	BOOST_CHECK_EQUAL(remote.get()->at(0), 1);
+
+	// sinks of the value itself get a copy.
+	pure::state_sink<big_state> plain;
+	source >> plain;
+	BOOST_CHECK_EQUAL(plain.get()[0], 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_hold_last_shares_values)
+{
+	tests::owning_node root{};
+	auto& buffer = root.make_child<hold_last<shared_state, tree_base_node>>(shared_state{});
+	event_source<shared_state> source{&root.node()};
+	state_sink<shared_state> sink{&root.node()};
+	source >> buffer.in();
+	buffer.out() >> sink;
+
+	const shared_state state{big_state(1000, 1)};
+	source.fire(state);
+	BOOST_CHECK(sink.get().shares(state));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,126 @@
+#include <boost/test/unit_test.hpp>
+
+#include <flexcore/core/pooled.hpp>
+#include <flexcore/extended/ports/connection_buffer.hpp>
+#include <flexcore/ports.hpp>
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace fc;
+
+BOOST_AUTO_TEST_SUITE(test_pooled)
+
+namespace
+{
+using payload = std::vector<int>;
+}
+
+BOOST_AUTO_TEST_CASE(test_payloads_are_reused)
+{
+	payload_pool<payload> pool{4};
+	const payload* first = nullptr;
+	{
+		auto value = pool.acquire();
+		BOOST_CHECK(value.unique());
+		value.write().assign(100, 1);
+		first = &value.get();
+
+		auto copy = value;
+		BOOST_CHECK(!value.unique());
+		BOOST_CHECK_EQUAL(copy->size(), 100);
+	}
+	// the payload keeps its value, including the capacity of the vector.
+	auto again = pool.acquire();
+	BOOST_CHECK_EQUAL(&again.get(), first);
+	BOOST_CHECK_EQUAL(again->size(), 100);
+	BOOST_CHECK_EQUAL(pool.size(), 1);
+	BOOST_CHECK(!pooled<payload>{});
+}
+
+BOOST_AUTO_TEST_CASE(test_exhausted_pool)
+{
+	payload_pool<payload> pool{2};
+	BOOST_CHECK_EQUAL(pool.capacity(), 2);
+	std::vector<pooled<payload>> in_use;
+	for (int i = 0; i != 3; ++i)
+		in_use.push_back(pool.acquire());
+	BOOST_CHECK_EQUAL(pool.size(), 2);
+	BOOST_CHECK_EQUAL(pool.overflows(), 1);
+
+	in_use.clear();
+	for (int i = 0; i != 2; ++i)
+		in_use.push_back(pool.acquire());
+	BOOST_CHECK_EQUAL(pool.size(), 2);
+	BOOST_CHECK_EQUAL(pool.overflows(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_pool_needs_capacity)
+{
+	BOOST_CHECK_THROW(payload_pool<payload>{0}, std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_handles_outlive_pool)
+{
+	pooled<payload> kept;
+	{
+		payload_pool<payload> pool{2};
+		kept = pool.acquire();
+		kept.write().push_back(3);
+		auto returned = pool.acquire();
+	}
+	BOOST_CHECK_EQUAL(kept->at(0), 3);
+	kept.reset();
+	BOOST_CHECK(!kept);
+}
+
+BOOST_AUTO_TEST_CASE(test_stream_between_regions)
+{
+	payload_pool<payload> pool{8};
+	pure::event_source<pooled<payload>> source;
+	event_buffer<pooled<payload>> buffer;
+	int received = 0;
+	// sinks of the payload itself are connected directly.
+	pure::event_sink<payload> sink{[&](const payload& p) { received += p.front(); }};
+	source >> buffer.in();
+	buffer.out() >> sink;
+
+	// the consumer runs on another thread, like the work of another region.
+	for (int cycle = 0; cycle != 100; ++cycle)
+	{
+		for (int i = 0; i != 3; ++i)
+		{
+			auto value = pool.acquire();
+			value.write().assign(10, 1);
+			source.fire(std::move(value));
+		}
+		buffer.switch_active_passive_tick()();
+		std::thread consumer{[&buffer] { buffer.work_tick()(); }};
+		consumer.join();
+	}
+	BOOST_CHECK_EQUAL(received, 300);
+	BOOST_CHECK_LE(pool.size(), 6);
+	BOOST_CHECK_EQUAL(pool.overflows(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_concurrent_release)
+{
+	// at most two batches are in use, the one acquired and the one being released.
+	payload_pool<payload> pool{128};
+	std::thread consumer;
+	for (int round = 0; round != 100; ++round)
+	{
+		std::vector<pooled<payload>> batch;
+		for (int i = 0; i != 64; ++i)
+			batch.push_back(pool.acquire());
+		if (consumer.joinable())
+			consumer.join();
+		consumer = std::thread{[moved = std::move(batch)]() mutable { moved.clear(); }};
+	}
+	consumer.join();
+	BOOST_CHECK_LE(pool.size(), 128);
+	BOOST_CHECK_EQUAL(pool.overflows(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
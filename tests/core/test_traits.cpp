@@ -161,7 +161,7 @@ namespace
 {
 struct accepting_registration
 {
-	void register_callback(const std::shared_ptr<std::function<void(size_t)>>&)
+	void register_callback(fc::detail::connection_breaker&)
 	{
 	}
 };
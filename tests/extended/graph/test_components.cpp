@@ -0,0 +1,153 @@
+#include <boost/test/unit_test.hpp>
+
+#include <flexcore/extended/graph/components.hpp>
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/extended/nodes/region_worker_node.hpp>
+#include <flexcore/ports.hpp>
+#include <flexcore/scheduler/cyclecontrol.hpp>
+#include <flexcore/scheduler/parallelscheduler.hpp>
+
+#include <atomic>
+
+using namespace fc;
+
+namespace
+{
+/// counts its cycles and passes the count of its predecessor on.
+class chain_node : public region_worker_node
+{
+public:
+	explicit chain_node(const node_args& node)
+		: region_worker_node([this](){ work(); }, node)
+		, in_port(this)
+		, out_port(this, [this](){ return value; })
+	{
+	}
+
+	auto& in() noexcept { return in_port; }
+	auto& out() noexcept { return out_port; }
+
+	int value = 0;
+	int cycles = 0;
+
+private:
+	void work()
+	{
+		++cycles;
+		if (in_port.is_connected())
+			value = in_port.get() + 1;
+	}
+
+	state_sink<int> in_port;
+	state_source<int> out_port;
+};
+
+struct components_fixture
+{
+	graph::connection_graph graph;
+	std::shared_ptr<parallel_region> r1 =
+			std::make_shared<parallel_region>("r1", thread::cycle_control::fast_tick);
+	std::shared_ptr<parallel_region> r2 =
+			std::make_shared<parallel_region>("r2", thread::cycle_control::fast_tick);
+	forest_owner forest{graph, "forest", r1};
+
+	chain_node& make(const std::shared_ptr<parallel_region>& r, std::string name)
+	{
+		return forest.nodes().make_child_named<chain_node>(r, std::move(name));
+	}
+};
+
+size_t component_of(const graph::region_components& components, const tree_base_node& node)
+{
+	return components.component_of_node.at(node.graph_info().get_id());
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(test_components, components_fixture)
+
+BOOST_AUTO_TEST_CASE(test_independent_components)
+{
+	auto& a1 = make(r1, "a1");
+	auto& a2 = make(r1, "a2");
+	auto& b1 = make(r1, "b1");
+	auto& b2 = make(r1, "b2");
+	auto& c = make(r2, "c");
+	a1.out() >> a2.in();
+	b1.out() >> b2.in();
+	// the edges through the other region are buffered and do not connect a and b.
+	a2.out() >> c.in();
+	c.out() >> b1.in();
+
+	const auto components = graph::independent_components(graph, *r1);
+	BOOST_CHECK_EQUAL(components.nr_of_components, 2);
+	BOOST_CHECK_EQUAL(components.component_of_node.size(), 4);
+	BOOST_CHECK_EQUAL(component_of(components, a1), 0);
+	BOOST_CHECK_EQUAL(component_of(components, a2), 0);
+	BOOST_CHECK_EQUAL(component_of(components, b1), 1);
+	BOOST_CHECK_EQUAL(component_of(components, b2), 1);
+
+	const auto other = graph::independent_components(graph, *r2);
+	BOOST_CHECK_EQUAL(other.nr_of_components, 1);
+	BOOST_CHECK_EQUAL(component_of(other, c), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_components_run_in_parallel)
+{
+	thread::thread_config config{};
+	config.nr_of_threads = 4;
+	thread::parallel_scheduler pool{config};
+
+	// four chains of three nodes, the workers of a chain keep their order.
+	std::vector<chain_node*> last;
+	for (int chain = 0; chain != 4; ++chain)
+	{
+		auto* previous = &make(r1, "first");
+		for (int i = 0; i != 2; ++i)
+		{
+			auto& next = make(r1, "next");
+			previous->out() >> next.in();
+			previous = &next;
+		}
+		last.push_back(previous);
+	}
+	BOOST_CHECK_EQUAL(graph::run_components_in_parallel(graph, *r1, pool), 4);
+	BOOST_CHECK_EQUAL(r1->workers().nr_of_components(), 4);
+
+	// a node added later runs before the components.
+	auto& late = make(r1, "late");
+	for (int i = 0; i != 3; ++i)
+		r1->ticks.in_work()();
+
+	for (auto* node : last)
+	{
+		BOOST_CHECK_EQUAL(node->cycles, 3);
+		BOOST_CHECK_EQUAL(node->value, 2);
+	}
+	BOOST_CHECK_EQUAL(late.cycles, 3);
+
+	r1->workers().clear_components();
+	r1->ticks.in_work()();
+	BOOST_CHECK_EQUAL(late.cycles, 4);
+	pool.stop();
+}
+
+BOOST_AUTO_TEST_CASE(test_many_components_run_in_parallel)
+{
+	thread::thread_config config{};
+	config.nr_of_threads = 4;
+	thread::parallel_scheduler pool{config};
+
+	// more components than chunks per thread of the pool.
+	std::vector<chain_node*> nodes;
+	for (int i = 0; i != 20; ++i)
+		nodes.push_back(&make(r1, "single"));
+	BOOST_CHECK_EQUAL(graph::run_components_in_parallel(graph, *r1, pool), 20);
+
+	for (int i = 0; i != 3; ++i)
+		r1->ticks.in_work()();
+	for (auto* node : nodes)
+		BOOST_CHECK_EQUAL(node->cycles, 3);
+	pool.stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -10,6 +10,11 @@
 
 #include <boost/mpl/list.hpp>
 
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 namespace
 {
 	struct graph_fixture
@@ -86,4 +91,190 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_graph_creation, node_t, nodes)
 	BOOST_CHECK_EQUAL(line_count, 10 + 8 + 2);
 }
 
+BOOST_AUTO_TEST_CASE(test_edge_latency)
+{
+	auto other_region = std::make_shared<fc::parallel_region>("other",
+			fc::thread::cycle_control::fast_tick);
+	auto& source = forest.nodes().make_child_named<fc::event_terminal<int>>("source");
+	auto& sink = forest.nodes().make_child_named<fc::event_terminal<int>>(other_region, "sink");
+	auto& local_sink = forest.nodes().make_child_named<fc::event_terminal<int>>("local");
+
+	fc::buffer_config traced{};
+	traced.latency_sampling = 1;
+	source.out().set_buffer_config(traced);
+	source.out() >> sink.in();
+	source.out() >> local_sink.in();
+	// histograms are only set for the connection.
+	BOOST_CHECK(!source.out().get_buffer_config().latency_histogram);
+
+	source.in()(1);
+	forest.nodes().region()->ticks.switch_buffers();
+	other_region->ticks.in_work()();
+
+	// only the connection between regions has a buffer to trace.
+	const auto latencies = graph.latencies();
+	BOOST_REQUIRE_EQUAL(latencies.size(), 1);
+	BOOST_CHECK(latencies.front().first.source.port_properties == source.out().graph_port_info);
+	BOOST_CHECK(latencies.front().first.sink.port_properties == sink.in().graph_port_info);
+	BOOST_CHECK_EQUAL(latencies.front().second.count, 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_port_counters)
+{
+	BOOST_CHECK(!graph.port_counters_enabled());
+	graph.enable_port_counters();
+	BOOST_CHECK(graph.port_counters_enabled());
+
+	auto& event_source = forest.nodes().make_child_named<fc::event_terminal<int>>("event_source");
+	auto& event_sink = forest.nodes().make_child_named<fc::event_terminal<int>>("event_sink");
+	auto& state_source = forest.nodes().make_child_named<fc::state_terminal<int>>("state_source");
+	auto& state_sink = forest.nodes().make_child_named<fc::state_terminal<int>>("state_sink");
+	event_source.out() >> event_sink.in();
+	state_source.out() >> state_sink.in();
+	[](){ return 42; } >> state_source.in();
+
+	event_source.in()(1);
+	event_source.in()(2);
+	BOOST_CHECK_EQUAL(state_sink.in().get(), 42);
+
+	const auto statistics = graph.statistics();
+	const auto fired = statistics.at(event_source.out().graph_port_info.id());
+	BOOST_CHECK_EQUAL(fired.events, 2);
+	BOOST_CHECK_EQUAL(fired.bytes, 2 * sizeof(int));
+	const auto pulled = statistics.at(state_sink.in().graph_port_info.id());
+	BOOST_CHECK_EQUAL(pulled.pulls, 1);
+	BOOST_CHECK_EQUAL(pulled.bytes, sizeof(int));
+
+	forest.visualize(out_stream, true);
+	const auto dot_string = out_stream.str();
+	BOOST_CHECK(dot_string.find(" ev/s\"") != std::string::npos);
+	BOOST_CHECK(dot_string.find(" pulls/s\"") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(test_interned_names)
+{
+	const fc::graph::symbol a{"some_name"};
+	const fc::graph::symbol b{std::string{"some_"} + "name"};
+	const fc::graph::symbol c{"other_name"};
+	BOOST_CHECK(a == b);
+	BOOST_CHECK(a != c);
+	BOOST_CHECK_EQUAL(&a.str(), &b.str());
+	BOOST_CHECK_EQUAL(c.str(), "other_name");
+
+	// nodes of the same name share the storage of their name.
+	auto& first = forest.nodes().make_child_named<fc::state_terminal<int>>("terminal");
+	auto& second = forest.nodes().make_child_named<fc::state_terminal<int>>("terminal");
+	BOOST_CHECK_EQUAL(&first.graph_info().name(), &second.graph_info().name());
+	BOOST_CHECK(!(first.graph_info() == second.graph_info()));
+}
+
+BOOST_AUTO_TEST_CASE(test_type_names)
+{
+	const auto first = fc::graph::symbol::of_type(typeid(std::vector<int>));
+	const auto second = fc::graph::symbol::of_type(typeid(std::vector<int>));
+	BOOST_CHECK(first == second);
+	BOOST_CHECK(first == fc::graph::symbol{first.str()});
+	BOOST_CHECK(first != fc::graph::symbol::of_type(typeid(int)));
+	BOOST_CHECK_EQUAL(fc::graph::symbol::of_type(typeid(int)).str(), "int");
+
+	// ports without a node name are described by their token, all sharing one string.
+	fc::graph::graph_connectable<fc::pure::event_sink<int>> a{fc::graph::graph_node_properties{""},
+			[](int) {}};
+	fc::graph::graph_connectable<fc::pure::event_sink<int>> b{fc::graph::graph_node_properties{""},
+			[](int) {}};
+	BOOST_CHECK_EQUAL(a.graph_port_info.description(), "int");
+	BOOST_CHECK_EQUAL(&a.graph_port_info.description(), &b.graph_port_info.description());
+}
+
+BOOST_AUTO_TEST_CASE(test_build_in_parallel)
+{
+	constexpr int nr_of_subtrees = 8;
+	constexpr int chain_length = 50;
+	std::vector<std::function<void(fc::owning_base_node&)>> builders;
+	for (int b = 0; b != nr_of_subtrees; ++b)
+		builders.push_back([b](fc::owning_base_node& parent)
+		{
+			auto& subtree = parent.make_child_named<fc::owning_base_node>(
+					"subtree" + std::to_string(b));
+			auto* last = &subtree.make_child_named<fc::state_terminal<int>>("terminal");
+			[b](){ return b; } >> last->in();
+			for (int i = 1; i != chain_length; ++i)
+			{
+				auto& next = subtree.make_child_named<fc::state_terminal<int>>("terminal");
+				last->out() >> next.in();
+				last = &next;
+			}
+			BOOST_CHECK_EQUAL(last->out()(), b);
+		});
+
+	fc::build_in_parallel(forest.nodes(), builders, 4);
+	// all connections between terminals have been merged into the graph.
+	BOOST_CHECK_EQUAL(graph.edges().size(),
+			static_cast<size_t>(nr_of_subtrees * (chain_length - 1)));
+
+	std::vector<std::function<void(fc::owning_base_node&)>> failing{
+			[](fc::owning_base_node&) { throw std::runtime_error("failed"); },
+			[](fc::owning_base_node& parent) { parent.make_child_named<fc::state_terminal<int>>("terminal"); }};
+	BOOST_CHECK_THROW(fc::build_in_parallel(forest.nodes(), failing, 2), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_staging_scope)
+{
+	auto& source = forest.nodes().make_child_named<fc::state_terminal<int>>("source");
+	auto& sink = forest.nodes().make_child_named<fc::state_terminal<int>>("sink");
+	{
+		fc::graph::connection_graph::staging_scope staging(graph);
+		source.out() >> sink.in();
+		BOOST_CHECK(graph.edges().empty());
+	}
+	BOOST_CHECK_EQUAL(graph.edges().size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_deferred_recording)
+{
+	fc::graph::connection_graph deferred{fc::graph::connection_graph::recording::deferred};
+	fc::forest_owner owner{deferred, "deferred", std::make_shared<fc::parallel_region>("r",
+			fc::thread::cycle_control::fast_tick)};
+	auto& source = owner.nodes().make_child_named<fc::state_terminal<int>>("source");
+	auto& sink = owner.nodes().make_child_named<fc::state_terminal<int>>("sink");
+	source.out() >> sink.in();
+
+	// the log is added to the graph when the graph is read.
+	BOOST_CHECK_EQUAL(deferred.edges().size(), 1);
+	BOOST_CHECK_EQUAL(deferred.ports().size(), 4);
+	deferred.print(out_stream);
+	BOOST_CHECK(out_stream.str().find("source") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(test_incremental_changes)
+{
+	auto& source = forest.nodes().make_child_named<fc::state_terminal<int>>("source");
+	auto& sink = forest.nodes().make_child_named<fc::state_terminal<int>>("sink \"quoted\"");
+	source.out() >> sink.in();
+
+	const auto all = graph.changes_since(fc::graph::graph_version{});
+	BOOST_CHECK_EQUAL(all.new_ports.size(), graph.ports().size());
+	BOOST_CHECK_EQUAL(all.new_edges.size(), 1);
+	BOOST_CHECK_EQUAL(all.version.edges, 1);
+
+	// nothing changed, so the next delta is empty.
+	const auto none = graph.changes_since(all.version);
+	BOOST_CHECK(none.new_ports.empty());
+	BOOST_CHECK(none.new_edges.empty());
+
+	auto& other = forest.nodes().make_child_named<fc::state_terminal<int>>("other");
+	source.out() >> other.in();
+	const auto delta = graph.changes_since(all.version);
+	BOOST_CHECK_EQUAL(delta.new_edges.size(), 1);
+	BOOST_CHECK(delta.new_edges.front().sink.node_properties.name() == "other");
+	BOOST_CHECK_EQUAL(delta.version.edges, 2);
+
+	fc::graph::write_json(out_stream, all);
+	const auto json = out_stream.str();
+	BOOST_CHECK(json.find("{\"version\":{\"ports\":") == 0);
+	BOOST_CHECK(json.find("\"node_name\":\"sink \\\"quoted\\\"\"") != std::string::npos);
+	BOOST_CHECK(json.find("\"type\":\"state\"") != std::string::npos);
+	BOOST_CHECK_EQUAL(std::count(json.begin(), json.end(), '\n'), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,106 @@
+#include <boost/test/unit_test.hpp>
+
+#include <flexcore/extended/graph/graph_image.hpp>
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/extended/nodes/terminal.hpp>
+#include <flexcore/ports.hpp>
+#include <flexcore/scheduler/cyclecontrol.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace fc;
+
+namespace
+{
+/// builds the same small application every time, with a compound node and two regions.
+void build(forest_owner& forest, const std::vector<std::shared_ptr<parallel_region>>& regions)
+{
+	auto& group = forest.nodes().make_child_named<owning_base_node>(regions[1], "group");
+	auto& a = forest.nodes().make_child_named<state_terminal<int>>("a");
+	auto& b = group.make_child_named<state_terminal<int>>("b");
+	auto& c = group.make_child_named<event_terminal<int>>("c");
+	auto& d = forest.nodes().make_child_named<event_terminal<int>>("d");
+	a.out() >> b.in();
+	c.out() >> d.in();
+}
+
+graph::graph_image round_trip(const graph::graph_image& image)
+{
+	std::stringstream stream;
+	graph::write_image(stream, image);
+	return graph::read_image(stream);
+}
+}
+
+BOOST_AUTO_TEST_SUITE(test_graph_image)
+
+BOOST_AUTO_TEST_CASE(test_capture_and_rebuild)
+{
+	graph::connection_graph graph;
+	const std::vector<std::shared_ptr<parallel_region>> regions{
+			std::make_shared<parallel_region>("fast", thread::cycle_control::fast_tick),
+			std::make_shared<parallel_region>("slow", thread::cycle_control::slow_tick)};
+	forest_owner forest{graph, "root", regions[0]};
+	build(forest, regions);
+
+	const auto image = forest.image();
+	BOOST_REQUIRE_EQUAL(image.regions.size(), 2);
+	BOOST_CHECK_EQUAL(image.regions[1].name, "slow");
+	BOOST_CHECK(image.regions[1].tick == thread::cycle_control::slow_tick);
+	BOOST_REQUIRE_EQUAL(image.nodes.size(), 6);
+	BOOST_CHECK_EQUAL(image.nodes[0].name, "root");
+	BOOST_CHECK_EQUAL(image.nodes[0].parent, graph::graph_image::none);
+	// preorder, the children of group follow it.
+	BOOST_CHECK_EQUAL(image.nodes[1].name, "group");
+	BOOST_CHECK_EQUAL(image.nodes[2].parent, 1);
+	BOOST_CHECK_EQUAL(image.nodes[2].region, 1);
+	BOOST_CHECK_EQUAL(image.nodes[4].name, "a");
+	BOOST_CHECK_EQUAL(image.edges.size(), 2);
+	for (const auto& edge : image.edges)
+		BOOST_CHECK_NE(image.ports[edge.source].node, image.ports[edge.sink].node);
+
+	const auto loaded = round_trip(image);
+	BOOST_CHECK(graph::same_topology(image, loaded));
+
+	// a restart creates the regions of the image and preallocates the graph before building.
+	graph::connection_graph rebuilt_graph{graph::connection_graph::recording::deferred};
+	const auto rebuilt_regions = graph::make_regions(loaded);
+	BOOST_REQUIRE_EQUAL(rebuilt_regions.size(), 2);
+	BOOST_CHECK_EQUAL(rebuilt_regions[1]->get_id().key, "slow");
+	forest_owner rebuilt{rebuilt_graph, "root", rebuilt_regions[0]};
+	rebuilt.reserve(loaded);
+	build(rebuilt, rebuilt_regions);
+	BOOST_CHECK(graph::same_topology(rebuilt.image(), loaded));
+
+	// a changed application does not match the image.
+	rebuilt.nodes().make_child_named<state_terminal<int>>("e");
+	BOOST_CHECK(!graph::same_topology(rebuilt.image(), loaded));
+}
+
+BOOST_AUTO_TEST_CASE(test_invalid_images)
+{
+	std::stringstream empty;
+	BOOST_CHECK_THROW(graph::read_image(empty), std::runtime_error);
+
+	graph::graph_image image;
+	image.regions.push_back({"r", thread::cycle_control::fast_tick});
+	image.nodes.push_back({"root", graph::graph_image::none, 0});
+	std::stringstream stream;
+	graph::write_image(stream, image);
+	const auto bytes = stream.str();
+	BOOST_CHECK(graph::same_topology(round_trip(image), image));
+
+	std::stringstream truncated{bytes.substr(0, bytes.size() - 3)};
+	BOOST_CHECK_THROW(graph::read_image(truncated), std::runtime_error);
+
+	// the node refers to a region, which is not in the image.
+	image.regions.clear();
+	std::stringstream dangling;
+	graph::write_image(dangling, image);
+	BOOST_CHECK_THROW(graph::read_image(dangling), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,125 @@
+#include <boost/test/unit_test.hpp>
+
+#include <flexcore/extended/graph/graph.hpp>
+#include <flexcore/extended/graph/node_profiler.hpp>
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/extended/nodes/terminal.hpp>
+#include <flexcore/ports.hpp>
+#include <flexcore/scheduler/cyclecontrol.hpp>
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(test_node_profiler)
+
+using fc::operator>>;
+
+namespace
+{
+std::shared_ptr<fc::parallel_region> make_region()
+{
+	return std::make_shared<fc::parallel_region>("r", fc::thread::cycle_control::fast_tick);
+}
+
+/// returns the time of stack in folded, -1 if it is missing.
+long long time_of(const std::string& folded, const std::string& stack)
+{
+	std::istringstream lines{folded};
+	std::string line;
+	while (std::getline(lines, line))
+	{
+		const auto space = line.rfind(' ');
+		if (line.substr(0, space) == stack)
+			return std::stoll(line.substr(space + 1));
+	}
+	return -1;
+}
+}
+
+BOOST_AUTO_TEST_CASE(test_disabled_by_default)
+{
+	fc::graph::connection_graph graph;
+	BOOST_CHECK(!graph.node_profiling());
+	fc::forest_owner forest{graph, "forest", make_region()};
+	auto& terminal = forest.nodes().make_child_named<fc::event_terminal<int>>("terminal");
+	terminal.in()(1);
+	BOOST_CHECK(!graph.node_profiling());
+}
+
+BOOST_AUTO_TEST_CASE(test_nested_nodes)
+{
+	fc::graph::connection_graph graph;
+	graph.enable_node_profiling();
+	const auto profiler = graph.node_profiling();
+	BOOST_REQUIRE(profiler);
+
+	fc::forest_owner forest{graph, "forest", make_region()};
+	auto& source = forest.nodes().make_child_named<fc::event_terminal<int>>("source");
+	auto& sink = forest.nodes().make_child_named<fc::event_terminal<int>>("sink");
+	source.out() >> sink.in();
+	fc::pure::event_sink<int> slow{[](int)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}};
+	sink.out() >> slow;
+
+	auto& provider = forest.nodes().make_child_named<fc::state_terminal<int>>("provider");
+	auto& consumer = forest.nodes().make_child_named<fc::state_terminal<int>>("consumer");
+	[](){ return 42; } >> provider.in();
+	provider.out() >> consumer.in();
+	fc::pure::state_sink<int> pull;
+	consumer.out() >> pull;
+
+	source.in()(1);
+	BOOST_CHECK_EQUAL(pull.get(), 42);
+
+	const auto profile = profiler->snapshot();
+	BOOST_REQUIRE_EQUAL(profile.threads.size(), 1);
+	// entering and leaving source, sink, consumer and provider.
+	BOOST_CHECK_EQUAL(profile.threads.front().size(), 8);
+	BOOST_CHECK(profile.threads.front().front().node == source.graph_info().get_id());
+	BOOST_CHECK(profile.threads.front().front().enter);
+
+	std::ostringstream folded;
+	fc::graph::write_folded(folded, profile);
+	const auto text = folded.str();
+	// the time of the slow sink is counted for the node calling it, without its caller.
+	BOOST_CHECK_GE(time_of(text, "source;sink"), 2000000);
+	BOOST_CHECK_GE(time_of(text, "source"), 0);
+	BOOST_CHECK_LT(time_of(text, "source"), time_of(text, "source;sink"));
+	BOOST_CHECK_GE(time_of(text, "consumer;provider"), 0);
+
+	std::ostringstream renamed;
+	fc::graph::write_folded(renamed, profile, [&](const fc::graph::unique_id& id)
+	{
+		return id == source.graph_info().get_id() ? std::string{"forest.source"}
+				: profile.names.at(id);
+	});
+	BOOST_CHECK_GE(time_of(renamed.str(), "forest.source;sink"), 2000000);
+}
+
+BOOST_AUTO_TEST_CASE(test_threads_and_ring)
+{
+	fc::graph::connection_graph graph;
+	graph.enable_node_profiling(4);
+	fc::forest_owner forest{graph, "forest", make_region()};
+	auto& terminal = forest.nodes().make_child_named<fc::event_terminal<int>>("terminal");
+
+	for (int i = 0; i != 3; ++i)
+		terminal.in()(i);
+	std::thread other{[&terminal]() { terminal.in()(3); }};
+	other.join();
+
+	const auto profile = graph.node_profiling()->snapshot();
+	BOOST_REQUIRE_EQUAL(profile.threads.size(), 2);
+	// the ring of the first thread keeps the last events, without the one written next.
+	BOOST_CHECK_EQUAL(profile.threads[0].size(), 3);
+	BOOST_CHECK_EQUAL(profile.threads[1].size(), 2);
+	std::ostringstream folded;
+	fc::graph::write_folded(folded, profile);
+	BOOST_CHECK_GE(time_of(folded.str(), "terminal"), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,117 @@
+#include <boost/test/unit_test.hpp>
+
+#include <flexcore/extended/graph/partitioning.hpp>
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/extended/nodes/terminal.hpp>
+#include <flexcore/ports.hpp>
+#include <flexcore/scheduler/cyclecontrol.hpp>
+
+#include <stdexcept>
+
+using namespace fc;
+
+namespace
+{
+struct partitioning_fixture
+{
+	graph::connection_graph graph;
+	std::shared_ptr<parallel_region> r1 =
+			std::make_shared<parallel_region>("r1", thread::cycle_control::fast_tick);
+	std::shared_ptr<parallel_region> r2 =
+			std::make_shared<parallel_region>("r2", thread::cycle_control::fast_tick);
+	forest_owner forest{graph, "forest", r1};
+
+	state_terminal<int>& make(const std::shared_ptr<parallel_region>& r, std::string name)
+	{
+		return forest.nodes().make_child_named<state_terminal<int>>(r, std::move(name));
+	}
+};
+
+size_t region_of(const graph::region_proposal& proposal, const tree_base_node& node)
+{
+	return proposal.region_of_node.at(node.graph_info().get_id());
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(test_partitioning, partitioning_fixture)
+
+BOOST_AUTO_TEST_CASE(test_minimal_cut)
+{
+	// two chains, badly spread over the two regions and connected by a single edge.
+	auto& x1 = make(r1, "x1");
+	auto& x2 = make(r1, "x2");
+	auto& x3 = make(r2, "x3");
+	auto& y1 = make(r1, "y1");
+	auto& y2 = make(r2, "y2");
+	auto& y3 = make(r2, "y3");
+	x1.out() >> x2.in();
+	x2.out() >> x3.in();
+	x3.out() >> y1.in();
+	y1.out() >> y2.in();
+	y2.out() >> y3.in();
+
+	graph::partitioning_options options;
+	options.nr_of_regions = 2;
+	const auto proposal = graph::propose_regions(graph, options);
+
+	BOOST_CHECK_EQUAL(proposal.current_cut_weight, 3.0);
+	BOOST_CHECK_EQUAL(proposal.cut_weight, 1.0);
+	BOOST_CHECK_EQUAL(region_of(proposal, x1), region_of(proposal, x2));
+	BOOST_CHECK_EQUAL(region_of(proposal, x1), region_of(proposal, x3));
+	BOOST_CHECK_EQUAL(region_of(proposal, y1), region_of(proposal, y3));
+	BOOST_CHECK_NE(region_of(proposal, x1), region_of(proposal, y1));
+	BOOST_REQUIRE_EQUAL(proposal.loads.size(), 2);
+	BOOST_CHECK_EQUAL(proposal.loads[0], proposal.loads[1]);
+}
+
+BOOST_AUTO_TEST_CASE(test_balances_measured_load)
+{
+	// the heavy region is split, even though that cuts an edge.
+	auto& a = make(r1, "a");
+	auto& b = make(r1, "b");
+	auto& c = make(r2, "c");
+	a.out() >> b.in();
+	b.out() >> c.in();
+
+	graph::partitioning_options options;
+	options.nr_of_regions = 2;
+	options.region_loads[r1.get()] = 10.0;
+	options.region_loads[r2.get()] = 1.0;
+	const auto proposal = graph::propose_regions(graph, options);
+
+	BOOST_CHECK_NE(region_of(proposal, a), region_of(proposal, b));
+	BOOST_CHECK_EQUAL(region_of(proposal, b), region_of(proposal, c));
+	BOOST_CHECK_EQUAL(proposal.cut_weight, 1.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_invalid_region_count)
+{
+	graph::partitioning_options options;
+	options.nr_of_regions = 0;
+	BOOST_CHECK_THROW(graph::propose_regions(graph, options), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_cross_numa_edges)
+{
+	auto r3 = std::make_shared<parallel_region>("r3", thread::cycle_control::fast_tick);
+	r1->set_numa_node(0);
+	r2->set_numa_node(1);
+	auto& a = make(r1, "a");
+	auto& b = make(r1, "b");
+	auto& c = make(r2, "c");
+	auto& d = make(r3, "d");
+	a.out() >> b.in();
+	b.out() >> c.in();
+	// regions without numa node are not reported.
+	c.out() >> d.in();
+
+	const auto edges = graph::cross_numa_edges(graph);
+	BOOST_REQUIRE_EQUAL(edges.size(), 1);
+	BOOST_CHECK(edges[0].edge.source.node_properties.get_id() == b.graph_info().get_id());
+	BOOST_CHECK(edges[0].edge.sink.node_properties.get_id() == c.graph_info().get_id());
+	BOOST_CHECK_EQUAL(edges[0].source_numa_node, 0);
+	BOOST_CHECK_EQUAL(edges[0].sink_numa_node, 1);
+	BOOST_CHECK_EQUAL(edges[0].weight, 1.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
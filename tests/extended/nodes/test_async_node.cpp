@@ -0,0 +1,112 @@
+#include <boost/test/unit_test.hpp>
+#include <flexcore/extended/nodes/async_node.hpp>
+#include <flexcore/ports.hpp>
+#include <flexcore/scheduler/cyclecontrol.hpp>
+#include <flexcore/scheduler/parallelscheduler.hpp>
+
+#include "nodes/owning_node.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(test_async_node)
+
+using fc::operator>>;
+
+namespace
+{
+struct async_fixture
+{
+	std::shared_ptr<fc::parallel_region> region = std::make_shared<fc::parallel_region>(
+			"MyRegion", fc::thread::cycle_control::fast_tick);
+	fc::tests::owning_node owner{region};
+	fc::thread::parallel_scheduler io{fc::thread::thread_config{2}};
+	fc::pure::event_source<int> requests;
+	std::vector<int> received;
+	fc::pure::event_sink<int> sink{[this](int i){ received.push_back(i); }};
+
+	/// runs cycles of the region until count results arrived or the time is up.
+	void run_until_received(size_t count)
+	{
+		for (int i = 0; i != 10000 && received.size() < count; ++i)
+		{
+			region->ticks.switch_buffers();
+			region->ticks.in_work()();
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	}
+};
+}
+
+BOOST_FIXTURE_TEST_CASE(test_results_arrive_in_later_cycle, async_fixture)
+{
+	std::atomic<bool> release{false};
+	auto& node = owner.make_child_named<fc::async_node<int, int>>("lookup",
+			[&release](int i)
+			{
+				while (!release)
+					std::this_thread::yield();
+				return i * 2;
+			},
+			io, 2);
+	requests >> node.in();
+	node.out() >> sink;
+
+	for (int i = 1; i != 5; ++i)
+		requests.fire(i);
+	// the worker of the region is not blocked by the running operations.
+	BOOST_CHECK_EQUAL(node.in_flight(), 2);
+	BOOST_CHECK_EQUAL(node.waiting_requests(), 2);
+	region->ticks.switch_buffers();
+	region->ticks.in_work()();
+	BOOST_CHECK(received.empty());
+
+	release = true;
+	run_until_received(4);
+	std::sort(received.begin(), received.end());
+	BOOST_CHECK((received == std::vector<int>{2, 4, 6, 8}));
+	BOOST_CHECK_EQUAL(node.in_flight(), 0);
+	BOOST_CHECK_EQUAL(node.waiting_requests(), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_errors_are_rethrown_in_region, async_fixture)
+{
+	auto& node = owner.make_child_named<fc::async_node<int, int>>("failing",
+			[](int i)
+			{
+				if (i < 0)
+					throw std::runtime_error("lookup failed");
+				return i;
+			},
+			io, 4);
+	requests >> node.in();
+	node.out() >> sink;
+
+	requests.fire(-1);
+	bool thrown = false;
+	for (int i = 0; i != 10000 && !thrown; ++i)
+	{
+		region->ticks.switch_buffers();
+		try
+		{
+			region->ticks.in_work()();
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+	BOOST_CHECK(thrown);
+
+	// the node keeps working after the error.
+	requests.fire(3);
+	run_until_received(1);
+	BOOST_CHECK((received == std::vector<int>{3}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
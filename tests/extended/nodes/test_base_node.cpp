@@ -5,6 +5,8 @@
 
 // std
 #include <memory>
+#include <string>
+#include <vector>
 
 using namespace fc;
 
@@ -94,6 +96,10 @@ BOOST_AUTO_TEST_CASE( test_name_chaining )
 	BOOST_CHECK_EQUAL(full_name(*(root.forest()),child1), "root.test_owning_node");
 	BOOST_CHECK_EQUAL(full_name(*(root.forest()),child2), "root.2");
 	BOOST_CHECK_EQUAL(full_name(*(root.forest()),child1a), "root.test_owning_node.a");
+
+	BOOST_CHECK_EQUAL(child1.full_name(), "root.test_owning_node");
+	BOOST_CHECK_EQUAL(child2.full_name(), "root.2");
+	BOOST_CHECK_EQUAL(child1a.full_name(), "root.test_owning_node.a");
 }
 
 BOOST_AUTO_TEST_CASE( test_make_child )
@@ -144,6 +150,92 @@ BOOST_AUTO_TEST_CASE( test_deletion )
 	BOOST_CHECK_EQUAL(test_node.nr_of_children(), 0);
 }
 
+namespace
+{
+class index_test_node : public owning_base_node
+{
+public:
+	static constexpr auto default_name = "index_test_node";
+	explicit index_test_node(const node_args& node) : owning_base_node(node) {}
+	forest_graph& fg() { return fg_; }
+	using owning_base_node::self;
+};
+}
+
+BOOST_AUTO_TEST_CASE( test_forest_index )
+{
+	tests::owning_node root_("root");
+	auto& parent = root_.make_child_named<index_test_node>("parent");
+	auto& fg = parent.fg();
+	const auto nr_of_nodes = fg.index.size();
+
+	std::vector<null*> children;
+	for (int i = 0; i != 1000; ++i)
+		children.push_back(&parent.make_child_named<null>("child" + std::to_string(i)));
+	BOOST_CHECK_EQUAL(fg.index.size(), nr_of_nodes + 1000);
+	BOOST_CHECK_EQUAL(children.back()->full_name(), "root.parent.child999");
+	BOOST_CHECK_EQUAL(full_name(fg, *children.front()),
+			full_name(fg.forest, *children.front()));
+
+	// erasing through the forest_graph removes the subtree from the index.
+	auto& grandchild = parent.make_child_named<index_test_node>("grandchild");
+	grandchild.make_child_named<null>("leaf");
+	erase_with_subtree(fg, grandchild.self());
+	BOOST_CHECK_EQUAL(fg.index.size(), nr_of_nodes + 1000);
+
+	// entries of erased nodes are reused, without their cached full name.
+	auto& reused = parent.make_child_named<null>("reused");
+	BOOST_CHECK_EQUAL(reused.full_name(), "root.parent.reused");
+
+	// full names are cached in the index.
+	const auto entry = fg.index.find(reused.graph_info().get_id());
+	BOOST_CHECK_EQUAL(&fg.index.full_name(entry), &fg.index.full_name(entry));
+}
+
+namespace
+{
+struct counted_node : tree_base_node
+{
+	static constexpr auto default_name = "counted_node";
+	counted_node(int& alive, const node_args& node) : tree_base_node(node), alive(alive)
+	{
+		++alive;
+	}
+	~counted_node() override { --alive; }
+	int& alive;
+	double payload[4] = {};
+};
+}
+
+BOOST_AUTO_TEST_CASE( test_node_arena )
+{
+	int alive = 0;
+	{
+		graph::connection_graph graph;
+		forest_owner owner{graph, "root",
+				std::make_shared<parallel_region>("r", thread::cycle_control::fast_tick), 4096};
+		auto& parent = owner.nodes().make_child_named<index_test_node>("parent");
+		BOOST_CHECK(parent.fg().arena.enabled());
+
+		std::vector<counted_node*> nodes;
+		for (int i = 0; i != 100; ++i)
+			nodes.push_back(&parent.make_child<counted_node>(alive));
+		BOOST_CHECK_EQUAL(alive, 100);
+		// nodes are placed next to each other in few blocks.
+		BOOST_CHECK(parent.fg().arena.nr_of_blocks() < 10);
+		BOOST_CHECK(reinterpret_cast<char*>(nodes[1]) - reinterpret_cast<char*>(nodes[0])
+				== static_cast<std::ptrdiff_t>(sizeof(counted_node)));
+
+		// destructors of nodes in the arena are still called.
+		auto& subtree = parent.make_child_named<index_test_node>("subtree");
+		subtree.make_child<counted_node>(alive);
+		BOOST_CHECK_EQUAL(alive, 101);
+		erase_with_subtree(parent.fg(), subtree.self());
+		BOOST_CHECK_EQUAL(alive, 100);
+	}
+	BOOST_CHECK_EQUAL(alive, 0);
+}
+
 namespace
 {
 template <class T>
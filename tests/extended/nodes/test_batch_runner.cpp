@@ -0,0 +1,71 @@
+#include <boost/test/unit_test.hpp>
+
+#include <flexcore/batch_runner.hpp>
+#include <flexcore/extended/base_node.hpp>
+
+#include <atomic>
+#include <vector>
+
+using namespace fc;
+
+BOOST_AUTO_TEST_SUITE( test_batch_runner )
+
+namespace
+{
+/// counts its work ticks and sums up a parameter of the simulation on each.
+struct accumulator : tree_base_node
+{
+	static constexpr auto default_name = "accumulator";
+	accumulator(int step, const node_args& node)
+		: tree_base_node(node)
+	{
+		region()->work_tick() >> [this, step]() { ++ticks; sum += step; };
+	}
+
+	int ticks = 0;
+	int sum = 0;
+};
+}
+
+BOOST_AUTO_TEST_CASE(test_parameter_sweep)
+{
+	thread::thread_config workers;
+	workers.nr_of_threads = 2;
+	batch_runner runner{workers, 3};
+	const auto global_start = virtual_clock::steady::now();
+
+	std::vector<accumulator*> results;
+	for (int step = 0; step != 8; ++step)
+	{
+		auto& instance = runner.add_instance("step " + std::to_string(step));
+		auto region = instance.add_region("fast", thread::cycle_control::fast_tick);
+		BOOST_CHECK(&region->clock() == &instance.clock());
+		results.push_back(&instance.node_owner().make_child<accumulator>(region, step));
+	}
+	BOOST_CHECK_EQUAL(runner.size(), 8);
+
+	const auto report = runner.run(30);
+	BOOST_CHECK_EQUAL(report.instances.size(), 8);
+	BOOST_CHECK_EQUAL(report.total_cycles, 8 * 30);
+	BOOST_CHECK_EQUAL(report.failed_instances, 0);
+	for (int step = 0; step != 8; ++step)
+	{
+		const auto& instance = report.instances[step];
+		BOOST_CHECK_EQUAL(instance.name, "step " + std::to_string(step));
+		BOOST_CHECK_EQUAL(instance.cycles, 30);
+		BOOST_CHECK(!instance.error);
+		BOOST_CHECK(instance.time.time_since_epoch() == std::chrono::milliseconds(300));
+		BOOST_CHECK_EQUAL(results[step]->ticks, 30);
+		BOOST_CHECK_EQUAL(results[step]->sum, 30 * step);
+	}
+	// fast region and root region of every instance.
+	BOOST_CHECK_EQUAL(report.execution.count, 8 * (30 + 3));
+	BOOST_CHECK(virtual_clock::steady::now() == global_start);
+
+	// simulations continue where they stopped.
+	const auto second = runner.run(10);
+	BOOST_CHECK(second.instances[0].time.time_since_epoch() == std::chrono::milliseconds(400));
+	BOOST_CHECK_EQUAL(results[7]->sum, 40 * 7);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
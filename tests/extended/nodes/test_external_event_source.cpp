@@ -0,0 +1,81 @@
+#include <boost/test/unit_test.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+#include <flexcore/extended/nodes/external_event_source.hpp>
+#include <flexcore/ports.hpp>
+
+#include "nodes/owning_node.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(test_external_event_source)
+
+using fc::operator>>;
+
+BOOST_AUTO_TEST_CASE(test_events_arrive_in_next_cycle)
+{
+	auto region = std::make_shared<fc::parallel_region>("MyRegion",
+			fc::thread::cycle_control::fast_tick);
+	fc::tests::owning_node owner(region);
+	auto& source = owner.make_child_named<fc::external_event_source<int>>("socket", 4);
+
+	std::vector<int> received;
+	fc::pure::event_sink<int> sink{[&received](int i){ received.push_back(i); }};
+	source.out() >> sink;
+
+	BOOST_CHECK(source.push(1));
+	BOOST_CHECK(source.push(2));
+	region->ticks.in_work()();
+	BOOST_CHECK(received.empty()); // not taken from the queue yet
+
+	region->ticks.switch_buffers();
+	region->ticks.in_work()();
+	BOOST_CHECK((received == std::vector<int>{1, 2}));
+
+	// the queue is bounded.
+	for (int i = 0; i != 5; ++i)
+		source.push(i);
+	BOOST_CHECK_EQUAL(source.dropped_events(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_multiple_producers)
+{
+	auto region = std::make_shared<fc::parallel_region>("MyRegion",
+			fc::thread::cycle_control::fast_tick);
+	fc::tests::owning_node owner(region);
+	constexpr int nr_of_producers = 4;
+	constexpr int events_per_producer = 1000;
+	auto& source = owner.make_child_named<fc::external_event_source<int>>(
+			"socket", nr_of_producers * events_per_producer);
+
+	std::vector<int> received;
+	fc::pure::event_sink<int> sink{[&received](int i){ received.push_back(i); }};
+	source.out() >> sink;
+
+	std::vector<std::thread> producers;
+	for (int p = 0; p != nr_of_producers; ++p)
+		producers.emplace_back([&source, p]()
+		{
+			for (int i = 0; i != events_per_producer; ++i)
+				source.push(p * events_per_producer + i);
+		});
+	for (auto& producer : producers)
+		producer.join();
+
+	region->ticks.switch_buffers();
+	region->ticks.in_work()();
+	BOOST_CHECK_EQUAL(source.dropped_events(), 0);
+	BOOST_REQUIRE_EQUAL(received.size(), nr_of_producers * events_per_producer);
+	// events of each producer keep their order.
+	for (int p = 0; p != nr_of_producers; ++p)
+	{
+		std::vector<int> of_producer;
+		std::copy_if(received.begin(), received.end(), std::back_inserter(of_producer),
+				[p](int i){ return i / events_per_producer == p; });
+		BOOST_CHECK(std::is_sorted(of_producer.begin(), of_producer.end()));
+		BOOST_CHECK_EQUAL(of_producer.size(), events_per_producer);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
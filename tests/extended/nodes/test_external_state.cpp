@@ -0,0 +1,83 @@
+#include <boost/test/unit_test.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+#include <flexcore/extended/nodes/external_state.hpp>
+#include <flexcore/ports.hpp>
+
+#include "nodes/owning_node.hpp"
+
+#include <atomic>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(test_external_state)
+
+using fc::operator>>;
+
+namespace
+{
+struct sample
+{
+	int first;
+	int second;
+	double third;
+};
+}
+
+BOOST_AUTO_TEST_CASE(test_value_visible_in_next_cycle)
+{
+	auto region = std::make_shared<fc::parallel_region>("MyRegion",
+			fc::thread::cycle_control::fast_tick);
+	fc::tests::owning_node owner(region);
+	auto& device = owner.make_child_named<fc::external_state<int>>("device", 7);
+
+	fc::pure::state_sink<int> sink;
+	fc::pure::state_sink<fc::state_version_t> version;
+	device.out() >> sink;
+	device.version_out() >> version;
+	BOOST_CHECK_EQUAL(sink.get(), 7);
+	BOOST_CHECK_EQUAL(version.get(), 0);
+
+	device.publish(1);
+	device.publish(2);
+	BOOST_CHECK_EQUAL(sink.get(), 7); // not taken from the seqlock yet
+
+	region->ticks.switch_buffers();
+	BOOST_CHECK_EQUAL(sink.get(), 2);
+	BOOST_CHECK_EQUAL(version.get(), 2);
+
+	region->ticks.switch_buffers();
+	BOOST_CHECK_EQUAL(sink.get(), 2);
+	BOOST_CHECK_EQUAL(version.get(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_concurrent_publishers)
+{
+	fc::thread::seqlock<sample> lock{sample{0, 0, 0.0}};
+	std::atomic<bool> done{false};
+	constexpr int nr_of_publishers = 3;
+
+	std::vector<std::thread> publishers;
+	for (int p = 0; p != nr_of_publishers; ++p)
+		publishers.emplace_back([&lock, &done, p]()
+		{
+			for (int i = 0; !done.load(); ++i)
+				lock.store(sample{i * p, i * p, static_cast<double>(i * p)});
+		});
+
+	while (lock.version() == 0)
+		std::this_thread::yield();
+
+	bool consistent = true;
+	for (int i = 0; i != 100000; ++i)
+	{
+		const auto value = lock.load();
+		consistent = consistent && value.first == value.second
+				&& value.third == static_cast<double>(value.first);
+	}
+	done = true;
+	for (auto& t : publishers)
+		t.join();
+
+	BOOST_CHECK(consistent);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,256 @@
+#include <boost/test/unit_test.hpp>
+#include <flexcore/extended/nodes/network_bridge.hpp>
+#include <flexcore/ports.hpp>
+
+#include "nodes/owning_node.hpp"
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+struct sample
+{
+	std::array<uint32_t, 32> values;
+	uint32_t number;
+};
+
+/// changed entries of sample::values, trivially copyable to be sent with fixed_layout.
+struct sample_patch
+{
+	uint32_t number;
+	uint32_t size;
+	std::array<uint32_t, 4> indices;
+	std::array<uint32_t, 4> values;
+};
+}
+
+namespace fc
+{
+template<>
+struct state_delta<sample>
+{
+	using patch_t = sample_patch;
+	static sample_patch diff(const sample& old, const sample& current)
+	{
+		sample_patch changes{current.number, 0, {}, {}};
+		for (uint32_t i = 0; i != current.values.size(); ++i)
+			if (old.values[i] != current.values[i])
+			{
+				BOOST_REQUIRE_LT(changes.size, changes.indices.size());
+				changes.indices[changes.size] = i;
+				changes.values[changes.size++] = current.values[i];
+			}
+		return changes;
+	}
+	static void patch(sample& state, const sample_patch& changes)
+	{
+		state.number = changes.number;
+		for (uint32_t i = 0; i != changes.size; ++i)
+			state.values[changes.indices[i]] = changes.values[i];
+	}
+};
+}
+
+BOOST_AUTO_TEST_SUITE(test_network_bridge)
+
+using fc::operator>>;
+
+namespace
+{
+std::shared_ptr<fc::parallel_region> make_region(const std::string& name)
+{
+	return std::make_shared<fc::parallel_region>(name, fc::thread::cycle_control::fast_tick);
+}
+
+/// runs cycles of region until done returns true, datagrams on localhost arrive almost at once.
+template<class condition_t>
+void cycle_until(fc::parallel_region& region, condition_t done)
+{
+	for (int i = 0; i != 1000 && !done(); ++i)
+	{
+		region.ticks.switch_buffers();
+		region.ticks.in_work()();
+		if (!done())
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+}
+
+BOOST_AUTO_TEST_CASE(test_frame_round_trip)
+{
+	for (auto codec : {fc::net::compression::none, fc::net::compression::zero_runs})
+	{
+		fc::net::bridge_config config;
+		config.codec = codec;
+		fc::net::frame_writer writer(config);
+		const std::vector<char> sparse(1000, 0);
+		const std::vector<char> dense{1, 2, 3};
+		writer.add(fc::const_byte_span{sparse.data(), sparse.size()});
+		writer.add(fc::const_byte_span{dense.data(), dense.size()});
+		const auto frame = writer.finish(5);
+		BOOST_CHECK(writer.empty());
+		if (codec == fc::net::compression::zero_runs)
+			BOOST_CHECK_LT(frame.size, 100);
+
+		fc::net::frame_reader reader;
+		BOOST_REQUIRE(reader.parse(frame));
+		BOOST_CHECK_EQUAL(reader.sequence(), 5);
+		BOOST_CHECK_EQUAL(reader.size(), 2);
+		fc::const_byte_span event;
+		BOOST_REQUIRE(reader.next(event));
+		BOOST_CHECK(std::vector<char>(event.begin(), event.end()) == sparse);
+		BOOST_REQUIRE(reader.next(event));
+		BOOST_CHECK(std::vector<char>(event.begin(), event.end()) == dense);
+		BOOST_CHECK(!reader.next(event));
+	}
+
+	fc::net::frame_reader reader;
+	const char garbage[] = "no frame of a bridge at all, but long enough";
+	BOOST_CHECK(!reader.parse(fc::const_byte_span{garbage, sizeof(garbage)}));
+}
+
+BOOST_AUTO_TEST_CASE(test_events_of_tick_in_one_frame)
+{
+	auto receiver_region = make_region("receiver");
+	fc::tests::owning_node receiver_owner(receiver_region);
+	auto& receiver = receiver_owner.make_child_named<fc::event_bridge_receiver<int>>(
+			"receiver", 0);
+	std::vector<int> received;
+	fc::pure::event_sink<int> sink{[&received](int i){ received.push_back(i); }};
+	receiver.out() >> sink;
+
+	auto sender_region = make_region("sender");
+	fc::tests::owning_node sender_owner(sender_region);
+	auto& sender = sender_owner.make_child_named<fc::event_bridge_sender<int>>(
+			"sender", "127.0.0.1", receiver.port());
+	fc::pure::event_source<int> source;
+	source >> sender.in();
+
+	for (int i = 0; i != 10; ++i)
+		source.fire(i);
+	BOOST_CHECK_EQUAL(sender.statistics().frames, 0); // sent on the switch tick
+	sender_region->ticks.switch_buffers();
+
+	cycle_until(*receiver_region, [&received]() { return received.size() == 10; });
+	BOOST_CHECK((received == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+	const auto sent = sender.statistics();
+	BOOST_CHECK_EQUAL(sent.frames, 1);
+	BOOST_CHECK_EQUAL(sent.events, 10);
+	const auto stats = receiver.statistics();
+	BOOST_CHECK_EQUAL(stats.frames, 1);
+	BOOST_CHECK_EQUAL(stats.events, 10);
+	BOOST_CHECK_EQUAL(stats.bytes, sent.bytes);
+	BOOST_CHECK_EQUAL(stats.lost_frames, 0);
+	BOOST_CHECK_EQUAL(stats.latency.count, 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_large_ticks_are_split)
+{
+	auto receiver_region = make_region("receiver");
+	fc::tests::owning_node receiver_owner(receiver_region);
+	auto& receiver = receiver_owner.make_child_named<fc::event_bridge_receiver<sample>>(
+			"receiver", 0);
+	std::vector<uint32_t> received;
+	fc::pure::event_sink<sample> sink{[&received](const sample& s){ received.push_back(s.number); }};
+	receiver.out() >> sink;
+
+	fc::net::bridge_config config;
+	config.max_frame_size = 1024;
+	config.codec = fc::net::compression::zero_runs;
+	auto sender_region = make_region("sender");
+	fc::tests::owning_node sender_owner(sender_region);
+	auto& sender = sender_owner.make_child_named<fc::event_bridge_sender<sample>>(
+			"sender", "127.0.0.1", receiver.port(), config);
+	fc::pure::event_source<sample> source;
+	source >> sender.in();
+
+	sample s{};
+	for (uint32_t i = 0; i != 20; ++i)
+	{
+		s.number = i;
+		source.fire(s);
+	}
+	sender_region->ticks.switch_buffers();
+
+	cycle_until(*receiver_region, [&received]() { return received.size() == 20; });
+	BOOST_REQUIRE_EQUAL(received.size(), 20);
+	for (uint32_t i = 0; i != 20; ++i)
+		BOOST_CHECK_EQUAL(received[i], i);
+	BOOST_CHECK_GT(sender.statistics().frames, 1);
+	BOOST_CHECK_EQUAL(receiver.statistics().frames, sender.statistics().frames);
+	// compression of the zeros keeps the datagrams small.
+	BOOST_CHECK_LT(sender.statistics().bytes, 20 * sizeof(sample));
+}
+
+BOOST_AUTO_TEST_CASE(test_state_bridge)
+{
+	auto receiver_region = make_region("receiver");
+	fc::tests::owning_node receiver_owner(receiver_region);
+	auto& receiver = receiver_owner.make_child_named<fc::state_bridge_receiver<sample>>(
+			"receiver", 0);
+	fc::pure::state_sink<const sample&> sink;
+	receiver.out() >> sink;
+	fc::pure::state_sink<fc::state_version_t> version;
+	receiver.version_out() >> version;
+
+	auto sender_region = make_region("sender");
+	fc::tests::owning_node sender_owner(sender_region);
+	auto& sender = sender_owner.make_child_named<fc::state_bridge_sender<sample>>(
+			"sender", "127.0.0.1", receiver.port());
+	sample value{};
+	fc::pure::state_source<sample> source{[&value]() { return value; }};
+	source >> sender.in();
+
+	BOOST_CHECK_EQUAL(version.get(), 0);
+	value.number = 3;
+	value.values.back() = 17;
+	sender_region->ticks.switch_buffers();
+
+	cycle_until(*receiver_region, [&version]() { return version.get() != 0; });
+	BOOST_CHECK_EQUAL(version.get(), 1);
+	BOOST_CHECK_EQUAL(sink.get().number, 3);
+	BOOST_CHECK_EQUAL(sink.get().values.back(), 17);
+	BOOST_CHECK_EQUAL(sender.statistics().frames, 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_state_delta_bridge)
+{
+	auto receiver_region = make_region("receiver");
+	fc::tests::owning_node receiver_owner(receiver_region);
+	auto& receiver = receiver_owner.make_child_named<fc::state_delta_bridge_receiver<sample>>(
+			"receiver", 0);
+	fc::pure::state_sink<const sample&> sink;
+	receiver.out() >> sink;
+	fc::pure::state_sink<fc::state_version_t> version;
+	receiver.version_out() >> version;
+
+	auto sender_region = make_region("sender");
+	fc::tests::owning_node sender_owner(sender_region);
+	auto& sender = sender_owner.make_child_named<fc::state_delta_bridge_sender<sample>>(
+			"sender", "127.0.0.1", receiver.port(), fc::net::bridge_config{}, 4);
+	sample value{};
+	fc::pure::state_source<sample> source{[&value]() { return value; }};
+	source >> sender.in();
+
+	// a full state, three patches, then a full state again.
+	for (uint32_t i = 1; i != 6; ++i)
+	{
+		value.number = i;
+		value.values[i] = 10 * i;
+		sender_region->ticks.switch_buffers();
+		cycle_until(*receiver_region, [&version, i]() { return version.get() == i; });
+		BOOST_CHECK_EQUAL(version.get(), i);
+		BOOST_CHECK(sink.get().values == value.values);
+		BOOST_CHECK_EQUAL(sink.get().number, i);
+	}
+	BOOST_CHECK_EQUAL(sender.statistics().frames, 5);
+	// five full states alone would take more.
+	BOOST_CHECK_LT(sender.statistics().bytes, 5 * sizeof(sample));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
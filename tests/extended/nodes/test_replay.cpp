@@ -0,0 +1,110 @@
+#include <boost/test/unit_test.hpp>
+#include <flexcore/extended/nodes/replay.hpp>
+#include <flexcore/ports.hpp>
+
+#include "nodes/owning_node.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(test_replay)
+
+using fc::operator>>;
+
+namespace
+{
+struct replay_file
+{
+	~replay_file() { std::remove(path.c_str()); }
+	const std::string path = "./test_replay.fcreplay";
+};
+
+using time_point = fc::virtual_clock::steady::time_point;
+using std::chrono::nanoseconds;
+}
+
+BOOST_FIXTURE_TEST_CASE(test_log_round_trip_and_seek, replay_file)
+{
+	constexpr int nr_of_records = 2000;
+	{
+		// small chunks to have records spread over many of them.
+		fc::replay_log_writer writer(path, 4096);
+		for (int i = 0; i != nr_of_records; ++i)
+		{
+			const std::string payload(i % 13, static_cast<char>('a' + i % 26));
+			writer.append(time_point{nanoseconds{i * 10}},
+					fc::const_byte_span{payload.data(), payload.size()});
+		}
+		BOOST_CHECK_EQUAL(writer.size(), nr_of_records);
+		BOOST_CHECK_THROW(writer.append(time_point{nanoseconds{0}}, fc::const_byte_span{}),
+				std::invalid_argument);
+		const std::string too_large(8192, 'x');
+		BOOST_CHECK_THROW(writer.append(time_point{nanoseconds{nr_of_records * 10}},
+				fc::const_byte_span{too_large.data(), too_large.size()}), std::length_error);
+	}
+
+	fc::replay_log_reader reader(path);
+	auto pos = reader.begin();
+	fc::replay_record record;
+	int count = 0;
+	while (reader.read(pos, record))
+	{
+		BOOST_CHECK(record.time == time_point{nanoseconds{count * 10}});
+		BOOST_CHECK_EQUAL(record.bytes.size, static_cast<size_t>(count % 13));
+		++count;
+	}
+	BOOST_CHECK_EQUAL(count, nr_of_records);
+
+	// seek finds the first record at or after the time.
+	pos = reader.seek(time_point{nanoseconds{10005}});
+	BOOST_REQUIRE(reader.read(pos, record));
+	BOOST_CHECK(record.time == time_point{nanoseconds{10010}});
+	pos = reader.seek(time_point{nanoseconds{10010}});
+	BOOST_REQUIRE(reader.read(pos, record));
+	BOOST_CHECK(record.time == time_point{nanoseconds{10010}});
+	pos = reader.seek(time_point{nanoseconds{nr_of_records * 10}});
+	BOOST_CHECK(!reader.read(pos, record));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_record_and_replay_nodes, replay_file)
+{
+	using clock = fc::master_clock<std::centi>;
+	const auto start = fc::virtual_clock::steady::now();
+	{
+		fc::tests::owning_node owner;
+		auto& recorder = owner.make_child_named<fc::event_recorder<int>>("recorder", path);
+		fc::pure::event_source<int> source;
+		source >> recorder.in();
+		for (int i = 0; i != 5; ++i)
+		{
+			source.fire(i);
+			source.fire(i * 10);
+			clock::advance();
+		}
+		BOOST_CHECK_EQUAL(recorder.size(), 10);
+	}
+
+	auto region = std::make_shared<fc::parallel_region>("replay",
+			fc::thread::cycle_control::fast_tick);
+	fc::tests::owning_node owner(region);
+	auto& replay = owner.make_child_named<fc::event_replay_source<int>>("replay", path);
+	std::vector<int> received;
+	fc::pure::event_sink<int> sink{[&received](int i){ received.push_back(i); }};
+	replay.out() >> sink;
+
+	// events are replayed relative to the recorded time of the third cycle.
+	replay.play_from(start + std::chrono::milliseconds(20));
+	region->ticks.in_work()();
+	BOOST_CHECK((received == std::vector<int>{2, 20}));
+	clock::advance();
+	region->ticks.in_work()();
+	BOOST_CHECK((received == std::vector<int>{2, 20, 3, 30}));
+	clock::advance();
+	region->ticks.in_work()();
+	BOOST_CHECK(replay.done());
+	BOOST_CHECK_EQUAL(received.size(), 6);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,111 @@
+#include <boost/test/unit_test.hpp>
+#include <flexcore/extended/nodes/shared_memory.hpp>
+#include <flexcore/ports.hpp>
+
+#include "nodes/owning_node.hpp"
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>
+
+BOOST_AUTO_TEST_SUITE(test_shared_memory)
+
+using fc::operator>>;
+
+namespace
+{
+/// names the segment after the process, so concurrent test runs do not collide.
+std::string segment_name(const std::string& name)
+{
+	return "/fc_test_" + name + "_" + std::to_string(::getpid());
+}
+
+struct frame
+{
+	std::array<uint16_t, 64 * 48> pixels;
+	uint32_t number;
+};
+}
+
+BOOST_AUTO_TEST_CASE(test_events_cross_segment)
+{
+	const auto name = segment_name("events");
+	fc::tests::owning_node publisher_owner;
+	auto& publisher = publisher_owner.make_child_named<fc::shared_event_publisher<int>>(
+			"publisher", name, 4);
+
+	auto region = std::make_shared<fc::parallel_region>("subscriber",
+			fc::thread::cycle_control::fast_tick);
+	fc::tests::owning_node subscriber_owner(region);
+	auto& subscriber = subscriber_owner.make_child_named<fc::shared_event_subscriber<int>>(
+			"subscriber", name);
+	std::vector<int> received;
+	fc::pure::event_sink<int> sink{[&received](int i){ received.push_back(i); }};
+	subscriber.out() >> sink;
+
+	fc::pure::event_source<int> source;
+	source >> publisher.in();
+	source.fire(1);
+	source.fire(2);
+	region->ticks.in_work()();
+	BOOST_CHECK(received.empty()); // not taken from the segment yet
+
+	region->ticks.switch_buffers();
+	region->ticks.in_work()();
+	BOOST_CHECK((received == std::vector<int>{1, 2}));
+
+	// the queue is bounded.
+	for (int i = 0; i != 5; ++i)
+		source.fire(i);
+	BOOST_CHECK_EQUAL(publisher.dropped_events(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_state_cross_segment)
+{
+	const auto name = segment_name("state");
+	auto publisher_region = std::make_shared<fc::parallel_region>("publisher",
+			fc::thread::cycle_control::fast_tick);
+	fc::tests::owning_node publisher_owner(publisher_region);
+	auto& publisher = publisher_owner.make_child_named<fc::shared_state_publisher<frame>>(
+			"publisher", name);
+	frame camera{};
+	fc::pure::state_source<frame> source{[&camera]() { return camera; }};
+	source >> publisher.in();
+
+	auto region = std::make_shared<fc::parallel_region>("subscriber",
+			fc::thread::cycle_control::fast_tick);
+	fc::tests::owning_node subscriber_owner(region);
+	auto& subscriber = subscriber_owner.make_child_named<fc::shared_state_subscriber<frame>>(
+			"subscriber", name);
+	fc::pure::state_sink<const frame&> sink;
+	subscriber.out() >> sink;
+
+	camera.number = 7;
+	camera.pixels.back() = 42;
+	publisher_region->ticks.in_work()();
+	BOOST_CHECK_EQUAL(sink.get().number, 0); // visible after the next switch tick
+
+	region->ticks.switch_buffers();
+	BOOST_CHECK_EQUAL(sink.get().number, 7);
+	BOOST_CHECK_EQUAL(sink.get().pixels.back(), 42);
+}
+
+BOOST_AUTO_TEST_CASE(test_subscriber_checks_segment)
+{
+	fc::tests::owning_node owner;
+	BOOST_CHECK_THROW(owner.make_child_named<fc::shared_state_subscriber<int>>(
+			"missing", segment_name("missing")), std::system_error);
+
+	const auto name = segment_name("mismatch");
+	owner.make_child_named<fc::shared_state_publisher<int>>("publisher", name);
+	BOOST_CHECK_THROW(owner.make_child_named<fc::shared_state_subscriber<double>>(
+			"subscriber", name), std::runtime_error);
+	BOOST_CHECK_THROW(owner.make_child_named<fc::shared_event_subscriber<int>>(
+			"subscriber", name), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -6,6 +6,8 @@
 #include <pure/sink_fixture.hpp>
 #include <nodes/owning_node.hpp>
 
+#include <vector>
+
 using namespace fc;
 
 BOOST_AUTO_TEST_SUITE(test_terminal_node)
@@ -87,4 +89,94 @@ BOOST_AUTO_TEST_CASE(test_state_terminal)
 
 }
 
+BOOST_AUTO_TEST_CASE(test_nested_state_terminals)
+{
+	float test_val = 1.0f;
+	tests::owning_node root;
+	std::vector<state_terminal<float>*> terminals;
+	for (int i = 0; i != 5; ++i)
+		terminals.push_back(&root.make_child_named<state_terminal<float>>("terminal"));
+	// the chain is collapsed regardless of the order of connections.
+	terminals[2]->out() >> terminals[3]->in();
+	terminals[3]->out() >> terminals[4]->in();
+	terminals[0]->out() >> terminals[1]->in();
+	terminals[1]->out() >> terminals[2]->in();
+	[&test_val](){ return test_val; } >> terminals[0]->in();
+
+	state_sink<float> tree_sink{&root.node()};
+	terminals.back()->out() >> tree_sink;
+	BOOST_CHECK_EQUAL(test_val, tree_sink.get());
+	test_val = 2.0f;
+	BOOST_CHECK_EQUAL(test_val, tree_sink.get());
+
+	// the connections between the terminals are still in the graph.
+	BOOST_CHECK_EQUAL(root.node().get_graph().edges().size(), 5);
+
+	// reconnecting the middle of the chain resolves the rest of it again.
+	[](){ return 3.0f; } >> terminals[2]->in();
+	BOOST_CHECK_EQUAL(3.0f, tree_sink.get());
+	BOOST_CHECK_EQUAL(test_val, terminals[1]->out()());
+}
+
+BOOST_AUTO_TEST_CASE(test_nested_state_terminals_destroyed)
+{
+	pure::state_sink<int> pure_sink;
+	state_terminal<int, pure::pure_node> last;
+	last.out() >> pure_sink;
+	{
+		state_terminal<int, pure::pure_node> first;
+		[](){ return 1; } >> first.in();
+		first.out() >> last.in();
+		BOOST_CHECK_EQUAL(1, pure_sink.get());
+	}
+	BOOST_CHECK_THROW(pure_sink.get(), not_connected);
+}
+
+BOOST_AUTO_TEST_CASE(test_nested_state_terminals_across_regions)
+{
+	tests::owning_node root;
+	auto other_region = std::make_shared<parallel_region>("other",
+			thread::cycle_control::slow_tick);
+	auto& first = root.make_child_named<state_terminal<int>>("first");
+	auto& second = root.node().make_child_named<state_terminal<int>>(other_region, "second");
+	int test_val = 1;
+	[&test_val](){ return test_val; } >> first.in();
+	first.out() >> second.in();
+
+	// the buffer between the regions is kept.
+	BOOST_CHECK_EQUAL(0, second.out()());
+	root.region()->ticks.in_work()();
+	other_region->ticks.switch_buffers();
+	BOOST_CHECK_EQUAL(1, second.out()());
+	test_val = 2;
+	BOOST_CHECK_EQUAL(1, second.out()());
+}
+
+BOOST_AUTO_TEST_CASE(test_nested_event_terminals)
+{
+	std::vector<int> received;
+	std::vector<int> fanned_out;
+	tests::owning_node root;
+	auto& first = root.make_child_named<event_terminal<int>>("first");
+	auto& middle = root.make_child_named<event_terminal<int>>("middle");
+	auto& last = root.make_child_named<event_terminal<int>>("last");
+
+	event_source<int> tree_source{&root.node()};
+	event_sink<int> tree_sink{&root.node(), [&received](int in){ received.push_back(in); }};
+	tree_source >> first.in();
+	first.out() >> middle.in();
+	middle.out() >> last.in();
+	last.out() >> tree_sink;
+
+	tree_source.fire(1);
+	BOOST_CHECK((received == std::vector<int>{1}));
+
+	// a terminal with other connections fires to all of them.
+	event_sink<int> other_sink{&root.node(), [&fanned_out](int in){ fanned_out.push_back(in); }};
+	middle.out() >> other_sink;
+	tree_source.fire(2);
+	BOOST_CHECK((received == std::vector<int>{1, 2}));
+	BOOST_CHECK((fanned_out == std::vector<int>{2}));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,74 @@
+#include <boost/test/unit_test.hpp>
+
+#include <flexcore/extended/ports/change_notifier.hpp>
+
+#include <memory>
+
+using fc::change_notifier;
+
+BOOST_AUTO_TEST_SUITE(test_change_notifier)
+
+namespace
+{
+int a_port = 0;
+int b_port = 0;
+}
+
+BOOST_AUTO_TEST_CASE(test_diamond)
+{
+	change_notifier source;
+	change_notifier left;
+	change_notifier right;
+	change_notifier bottom;
+	left.set_input(&a_port, &source);
+	right.set_input(&a_port, &source);
+	bottom.set_input(&a_port, &left);
+	bottom.set_input(&b_port, &right);
+	BOOST_CHECK(bottom.notifies());
+
+	bottom.clear();
+	left.clear();
+	source.notify();
+	BOOST_CHECK(bottom.changed());
+	BOOST_CHECK(left.changed());
+
+	// an input which does not notify makes all depending on it pull.
+	right.set_input(&b_port, nullptr);
+	BOOST_CHECK(!right.notifies());
+	BOOST_CHECK(!bottom.notifies());
+	BOOST_CHECK(left.notifies());
+	right.remove_input(&b_port);
+	BOOST_CHECK(bottom.notifies());
+}
+
+BOOST_AUTO_TEST_CASE(test_held_notifications)
+{
+	change_notifier source;
+	change_notifier held{false};
+	change_notifier sink;
+	held.set_input(&a_port, &source);
+	sink.set_input(&a_port, &held);
+	held.clear();
+	sink.clear();
+
+	source.notify();
+	BOOST_CHECK(held.changed());
+	BOOST_CHECK(!sink.changed());
+	held.notify_dependents();
+	BOOST_CHECK(sink.changed());
+}
+
+BOOST_AUTO_TEST_CASE(test_destroyed_source)
+{
+	change_notifier sink;
+	{
+		change_notifier source;
+		sink.set_input(&a_port, &source);
+		BOOST_CHECK(sink.notifies());
+		sink.clear();
+	}
+	BOOST_CHECK(sink.changed());
+	BOOST_CHECK(!sink.notifies());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,12 +3,20 @@
 #include <flexcore/extended/ports/node_aware.hpp>
 #include <flexcore/pure/pure_ports.hpp>
 #include <flexcore/extended/base_node.hpp>
+#include <flexcore/scheduler/parallelscheduler.hpp>
 #include <nodes/owning_node.hpp>
 #include <pure/sink_fixture.hpp>
 
 #include <boost/mpl/list.hpp>
 #include <boost/variant.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
 namespace
 {
 template<class base>
@@ -29,10 +37,24 @@ struct node_fixture
 
 using int_event_sink = fc::node_aware<fc::pure::sink_fixture<int>>;
 using int_event_source =  fc::node_aware<fc::pure::event_source<int>>;
+
+struct total
+{
+	int value;
+};
 }
 
 namespace fc
 {
+/// patches are differences of the value.
+template<>
+struct state_delta<total>
+{
+	using patch_t = int;
+	static int diff(const total& old, const total& current) { return current.value - old.value; }
+	static void patch(total& state, int difference) { state.value += difference; }
+};
+
 template <class T>
 struct is_active_source<useless_mixin<T>> : is_active_source<T> {};
 template <class T>
@@ -91,7 +113,7 @@ BOOST_AUTO_TEST_CASE(test_same_region)
 namespace
 {
 template<class source_t, class sink_t, class T>
-void check_mixins()
+void check_mixins(buffer_config config = buffer_config{})
 {
 	constexpr auto default_tick = thread::cycle_control::slow_tick;
 	constexpr auto different_tick = thread::cycle_control::fast_tick;
@@ -110,6 +132,7 @@ void check_mixins()
 	sink_t test_in_1(*(root_2.region()), write_param_1);
 	sink_t test_in_2(*(root_3.region()), write_param_2);
 	source_t test_out(*(root_1.region()));
+	test_out.set_buffer_config(config);
 
 	test_out >> test_in_1;
 	test_out >> test_in_2;
@@ -156,6 +179,17 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_different_region, T, token_types)
 	using test_mixin_sink = useless_mixin<node_aware<pure::event_sink<T>>>;
 	using test_mixin_source = useless_mixin<node_aware<pure::event_source<T>>>;
 	check_mixins<test_mixin_source, test_mixin_sink, T>();
+
+	buffer_config ring{buffer_config::ring_buffer, 4};
+	check_mixins<no_mixin_source, no_mixin_sink, T>(ring);
+	buffer_config coalescing{buffer_config::coalescing_buffer};
+	check_mixins<no_mixin_source, no_mixin_sink, T>(coalescing);
+	buffer_config priority{buffer_config::priority_buffer};
+	priority.max_bulk_events = 1;
+	check_mixins<no_mixin_source, no_mixin_sink, T>(priority);
+	buffer_config bounded{};
+	bounded.max_events = 1;
+	check_mixins<no_mixin_source, no_mixin_sink, T>(bounded);
 }
 
 BOOST_AUTO_TEST_CASE(test_void_event)
@@ -186,6 +220,208 @@ BOOST_AUTO_TEST_CASE(test_void_event)
 	BOOST_CHECK(written);
 }
 
+BOOST_AUTO_TEST_CASE(test_void_events_counted_across_regions)
+{
+	parallel_region region_1{"r1", fc::thread::cycle_control::fast_tick};
+	parallel_region region_2{"r2", fc::thread::cycle_control::fast_tick};
+
+	node_aware<pure::event_source<void>> source{region_1};
+	std::vector<size_t> counts;
+	node_aware<pure::event_sink<void>> sink{region_2,
+			[&counts]() { counts.push_back(1); }, [&counts](size_t n) { counts.push_back(n); }};
+	source >> sink;
+
+	for (int i = 0; i != 5; ++i)
+		source.fire();
+	source.fire_count(10);
+	region_1.ticks.switch_buffers();
+	region_2.ticks.in_work()();
+	// all events of the cycle cross the regions in a single call.
+	BOOST_CHECK(counts == std::vector<size_t>{15});
+}
+
+BOOST_AUTO_TEST_CASE(test_buffers_register_switches)
+{
+	parallel_region region_1{"r1", fc::thread::cycle_control::fast_tick};
+	parallel_region region_2{"r2", fc::thread::cycle_control::fast_tick};
+	parallel_region region_3{"r3", fc::thread::cycle_control::medium_tick};
+
+	int received = 0;
+	node_aware<pure::event_sink<int>> sink_2{region_2, [&received](int in){ received += in; }};
+	node_aware<pure::event_sink<int>> sink_3{region_3, [&received](int in){ received += in; }};
+	{
+		node_aware<pure::event_source<int>> source{region_1};
+		source >> sink_2;
+		source >> sink_3;
+		// one switch of both sides for the same tick rate, one per region otherwise.
+		BOOST_CHECK_EQUAL(region_1.buffer_switches().size(), 2);
+		BOOST_CHECK_EQUAL(region_2.buffer_switches().size(), 0);
+		BOOST_CHECK_EQUAL(region_3.buffer_switches().size(), 1);
+
+		source.fire(1);
+		region_1.ticks.switch_buffers();
+		region_2.ticks.in_work()();
+		region_3.ticks.switch_buffers();
+		region_3.ticks.in_work()();
+		BOOST_CHECK_EQUAL(received, 2);
+	}
+	// the buffers are gone with the connections of the source.
+	BOOST_CHECK_EQUAL(region_1.buffer_switches().size(), 0);
+	BOOST_CHECK_EQUAL(region_3.buffer_switches().size(), 0);
+	region_1.ticks.switch_buffers();
+	region_3.ticks.switch_buffers();
+}
+
+BOOST_AUTO_TEST_CASE(test_parallel_event_across_regions)
+{
+	parallel_region region_1{"r1", fc::thread::cycle_control::fast_tick};
+	parallel_region region_2{"r2", fc::thread::cycle_control::fast_tick};
+	fc::thread::parallel_scheduler pool{fc::thread::thread_config{2}};
+
+	node_aware<pure::parallel_event_source<int>> source{region_1, pool};
+	int local = 0;
+	int remote = 0;
+	node_aware<pure::event_sink<int>> sink{region_1, [&local](int in){ local = in; }};
+	node_aware<pure::event_sink<int>> sink2{region_2, [&remote](int in){ remote = in; }};
+	source >> sink;
+	source >> sink2;
+
+	source.fire(42);
+	BOOST_CHECK_EQUAL(local, 42);
+	BOOST_CHECK_EQUAL(remote, 0);
+	region_1.ticks.switch_buffers();
+	region_2.ticks.in_work()();
+	BOOST_CHECK_EQUAL(remote, 42);
+}
+
+BOOST_AUTO_TEST_CASE(test_shared_event_across_regions)
+{
+	parallel_region region_1{"r1", fc::thread::cycle_control::fast_tick};
+	parallel_region region_2{"r2", fc::thread::cycle_control::fast_tick};
+
+	using payload_t = std::shared_ptr<const int>;
+	node_aware<pure::shared_event_source<int>> source{region_1};
+	payload_t local;
+	payload_t remote;
+	node_aware<pure::event_sink<payload_t>> sink{region_1, [&local](payload_t in){local = in;}};
+	node_aware<pure::event_sink<payload_t>> sink2{region_2,
+			[&remote](payload_t in){remote = in;}};
+
+	source >> sink;
+	source >> sink2;
+
+	source.fire(42);
+	BOOST_REQUIRE(local);
+	BOOST_CHECK(!remote);
+
+	region_1.ticks.switch_buffers();
+	region_2.ticks.in_work()();
+	// the buffer between the regions passes on the same instance.
+	BOOST_CHECK_EQUAL(local, remote);
+	BOOST_CHECK_EQUAL(*remote, 42);
+}
+
+BOOST_AUTO_TEST_CASE(test_bounded_buffer_across_regions)
+{
+	parallel_region region_1{"r1", fc::thread::cycle_control::fast_tick};
+	parallel_region region_2{"r2", fc::thread::cycle_control::fast_tick};
+
+	node_aware<pure::event_source<int>> source{region_1};
+	std::vector<int> received;
+	node_aware<pure::event_sink<int>> sink{region_2, [&received](int i){ received.push_back(i); }};
+	size_t dropped = 0;
+	buffer_config bounded{};
+	bounded.max_events = 2;
+	bounded.overflow_handler = [&dropped](size_t n) { dropped += n; };
+	source.set_buffer_config(bounded);
+	source >> sink;
+
+	for (int i = 0; i != 5; ++i)
+		source.fire(i);
+	region_1.ticks.switch_buffers();
+	region_2.ticks.in_work()();
+	BOOST_CHECK((received == std::vector<int>{3, 4}));
+	BOOST_CHECK_EQUAL(dropped, 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_borrowed_state_across_regions)
+{
+	parallel_region region_1{"r1", fc::thread::cycle_control::fast_tick};
+	parallel_region region_2{"r2", fc::thread::cycle_control::fast_tick};
+
+	using state_t = std::vector<int>;
+	state_t state{1, 2, 3};
+	node_aware<pure::state_source<const state_t&>> source{region_1,
+			[&state]() -> const state_t& { return state; }};
+	node_aware<pure::state_sink<const state_t&>> local{region_1};
+	node_aware<pure::state_sink<const state_t&>> remote{region_2};
+
+	source >> local;
+	source >> remote;
+
+	BOOST_CHECK_EQUAL(&local.get(), &state);
+	BOOST_CHECK(remote.get().empty());
+
+	// the source region pulls the state, the region of the active sink switches.
+	region_1.ticks.in_work()();
+	region_2.ticks.switch_buffers();
+	BOOST_CHECK(remote.get() == state);
+	// reads within the same work tick borrow the same copy held by the buffer.
+	BOOST_CHECK_EQUAL(&remote.get(), &remote.get());
+}
+
+BOOST_AUTO_TEST_CASE(test_latest_state_across_regions)
+{
+	parallel_region region_1{"r1", fc::thread::cycle_control::fast_tick};
+	parallel_region region_2{"r2", fc::thread::cycle_control::medium_tick};
+
+	int state = 1;
+	node_aware<pure::state_source<int>> source{region_1, [&state]() { return state; }};
+	node_aware<pure::state_sink<int>> remote{region_2};
+	buffer_config latest{};
+	latest.state_kind = buffer_config::latest_state;
+	remote.set_buffer_config(latest);
+	source >> remote;
+
+	BOOST_CHECK_EQUAL(remote.get(), 0);
+	// the work tick of the source region publishes, no switch tick is needed.
+	region_1.ticks.in_work()();
+	BOOST_CHECK_EQUAL(remote.get(), 1);
+	state = 2;
+	region_2.ticks.switch_buffers();
+	BOOST_CHECK_EQUAL(remote.get(), 1);
+	region_1.ticks.in_work()();
+	BOOST_CHECK_EQUAL(remote.get(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_delta_state_across_regions)
+{
+	parallel_region region_1{"r1", fc::thread::cycle_control::fast_tick};
+	parallel_region region_2{"r2", fc::thread::cycle_control::fast_tick};
+
+	total state{1};
+	node_aware<pure::state_source<total>> source{region_1, [&state]() { return state; }};
+	node_aware<pure::state_sink<total>> remote{region_2};
+	// states without state_delta fall back to state_buffer.
+	node_aware<pure::state_source<int>> plain_source{region_1, [&state]() { return state.value; }};
+	node_aware<pure::state_sink<int>> plain_remote{region_2};
+	buffer_config delta{};
+	delta.state_kind = buffer_config::delta_state;
+	remote.set_buffer_config(delta);
+	plain_remote.set_buffer_config(delta);
+	source >> remote;
+	plain_source >> plain_remote;
+
+	for (int i = 0; i != 3; ++i)
+	{
+		region_1.ticks.in_work()();
+		region_2.ticks.switch_buffers();
+		BOOST_CHECK_EQUAL(remote.get().value, state.value);
+		BOOST_CHECK_EQUAL(plain_remote.get(), state.value);
+		state.value *= 3;
+	}
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE(test_traits, T, token_types)
 {
 	using full_state_sink = state_sink<T>;
@@ -373,4 +609,151 @@ BOOST_AUTO_TEST_CASE(test_state_same_region)
 	BOOST_CHECK_EQUAL(sink.get(), 1);
 }
 
+namespace
+{
+/// producer sends an event and a state to consumer every cycle.
+struct elision_setup
+{
+	std::shared_ptr<parallel_region> producer = std::make_shared<parallel_region>(
+			"producer", thread::cycle_control::fast_tick);
+	std::shared_ptr<parallel_region> consumer = std::make_shared<parallel_region>(
+			"consumer", thread::cycle_control::fast_tick);
+	node_aware<pure::event_source<int>> source{*producer};
+	std::vector<int> received;
+	std::atomic<bool> consuming{false};
+	std::atomic<bool> received_while_consuming{false};
+	node_aware<pure::event_sink<int>> sink{*consumer, [this](int v)
+			{
+				received.push_back(v);
+				if (consuming)
+					received_while_consuming = true;
+			}};
+	int state = 0;
+	node_aware<pure::state_source<int>> produced{*producer, [this]() { return state; }};
+	node_aware<pure::state_sink<int>> pulled{*consumer};
+
+	thread::cycle_control controller{std::make_unique<thread::parallel_scheduler>(two_workers())};
+
+	static thread::thread_config two_workers()
+	{
+		thread::thread_config config;
+		config.nr_of_threads = 2;
+		return config;
+	}
+
+	elision_setup()
+	{
+		source >> sink;
+		produced >> pulled;
+		producer->ticks.work_tick() >> [this]() { source.fire(++state); };
+		controller.add_task(thread::periodic_task{producer}, thread::cycle_control::fast_tick);
+		controller.add_task(thread::periodic_task{consumer}, thread::cycle_control::fast_tick);
+		controller.enable_buffer_elision();
+	}
+
+	bool elided() const
+	{
+		// registered with the passive region, the event sink and the state source.
+		auto elisions = consumer->buffer_elisions();
+		const auto state_elisions = producer->buffer_elisions();
+		elisions.insert(elisions.end(), state_elisions.begin(), state_elisions.end());
+		BOOST_CHECK_EQUAL(elisions.size(), 2);
+		return std::all_of(elisions.begin(), elisions.end(),
+				[](const std::shared_ptr<buffer_elision>& e) { return e->elided.load(); });
+	}
+};
+}
+
+BOOST_AUTO_TEST_CASE(test_buffer_elision)
+{
+	elision_setup setup;
+	setup.controller.add_dependency(*setup.producer, *setup.consumer);
+	int seen = -1;
+	setup.consumer->ticks.work_tick() >> [&]() { seen = setup.pulled.get(); };
+	setup.controller.warm_up(2);
+
+	BOOST_CHECK(setup.elided());
+	// events arrive in the cycle they are sent, instead of the next.
+	BOOST_CHECK(setup.received == (std::vector<int>{1, 2}));
+	BOOST_CHECK_EQUAL(seen, 2);
+
+	setup.controller.enable_buffer_elision(false);
+	setup.controller.warm_up(1);
+	BOOST_CHECK(!setup.elided());
+	BOOST_CHECK(setup.received == (std::vector<int>{1, 2}));
+	setup.controller.warm_up(1);
+	BOOST_CHECK(setup.received == (std::vector<int>{1, 2, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(test_buffer_elision_needs_order)
+{
+	{
+		// without a dependency the regions may run at the same time.
+		elision_setup setup;
+		setup.controller.warm_up(2);
+		BOOST_CHECK(!setup.elided());
+		BOOST_CHECK(setup.received == (std::vector<int>{1}));
+	}
+	{
+		elision_setup setup;
+		setup.controller.add_dependency(*setup.producer, *setup.consumer);
+		// an overrunning producer may still run, while the consumer starts.
+		setup.producer->set_skip_on_overrun(true);
+		setup.controller.warm_up(1);
+		BOOST_CHECK(!setup.elided());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_buffer_elision_not_under_throttling)
+{
+	elision_setup setup;
+	setup.controller.add_dependency(*setup.producer, *setup.consumer);
+	setup.controller.enable_throttling(thread::throttling_policy{});
+	// lets throttling absorb the overrun of the producer, which has no rate to step down to.
+	auto background = std::make_shared<parallel_region>(
+			"background", thread::cycle_control::fast_tick);
+	background->set_acceptable_rates({thread::cycle_control::fast_tick * 2});
+	setup.controller.add_task(thread::periodic_task{background}, thread::cycle_control::fast_tick);
+
+	// the consumer overruns its third cycle until the producer of the next cycle has sent.
+	std::atomic<int> produced{0};
+	int consumed = 0;
+	setup.producer->ticks.work_tick() >> [&] { ++produced; };
+	setup.consumer->ticks.work_tick() >> [&]
+	{
+		if (++consumed != 3)
+			return;
+		setup.consuming = true;
+		const auto give_up = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+		while (produced == 3 && std::chrono::steady_clock::now() < give_up)
+			std::this_thread::yield();
+		setup.consuming = false;
+	};
+	setup.controller.run_cycles(6);
+
+	BOOST_CHECK(!setup.elided());
+	BOOST_CHECK(!setup.received_while_consuming);
+	BOOST_CHECK(!setup.controller.last_exception());
+}
+
+BOOST_AUTO_TEST_CASE(test_buffer_elision_not_into_suspended_regions)
+{
+	elision_setup setup;
+	setup.controller.add_dependency(*setup.producer, *setup.consumer);
+	setup.controller.warm_up(2);
+	BOOST_CHECK(setup.elided());
+	BOOST_CHECK(setup.received == (std::vector<int>{1, 2}));
+
+	// events sent while the consumer is suspended are kept for it.
+	setup.consumer->suspend();
+	setup.controller.warm_up(2);
+	BOOST_CHECK(!setup.elided());
+	BOOST_CHECK(setup.received == (std::vector<int>{1, 2}));
+
+	setup.consumer->resume();
+	setup.controller.warm_up(2);
+	BOOST_CHECK(setup.elided());
+	BOOST_CHECK(setup.received == (std::vector<int>{1, 2, 3, 4, 5, 6}));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
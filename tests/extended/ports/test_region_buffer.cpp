@@ -4,6 +4,74 @@
 #include <flexcore/extended/ports/connection_buffer.hpp>
 #include <flexcore/pure/pure_ports.hpp>
 
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+struct keyed_event
+{
+	int key;
+	int value;
+};
+
+/// large state of which few cells change, counts its copies.
+struct grid
+{
+	grid() = default;
+	grid(const grid& other) : cells(other.cells) { ++copies; }
+	grid& operator=(const grid&) = default;
+
+	std::vector<int> cells = std::vector<int>(1000, 0);
+	static int copies;
+};
+int grid::copies = 0;
+
+/// negative values are urgent control events.
+struct message
+{
+	int value;
+};
+}
+
+namespace fc
+{
+template<>
+struct coalescing_key<keyed_event>
+{
+	static int key(const keyed_event& e) { return e.key; }
+};
+
+template<>
+struct event_priority<message>
+{
+	static bool urgent(const message& m) { return m.value < 0; }
+};
+
+template<>
+struct state_delta<grid>
+{
+	using patch_t = std::vector<std::pair<size_t, int>>;
+
+	static patch_t diff(const grid& old, const grid& current)
+	{
+		patch_t changes;
+		for (size_t i = 0; i != current.cells.size(); ++i)
+			if (old.cells[i] != current.cells[i])
+				changes.emplace_back(i, current.cells[i]);
+		return changes;
+	}
+	static void patch(grid& state, const patch_t& changes)
+	{
+		for (const auto& change : changes)
+			state.cells[change.first] = change.second;
+	}
+};
+}
+
 BOOST_AUTO_TEST_SUITE(test_eventbuffer)
 
 using fc::operator>>;
@@ -49,6 +117,186 @@ BOOST_AUTO_TEST_CASE( test_state_buffer )
 	BOOST_CHECK_EQUAL(sink.get(), 2);
 }
 
+BOOST_AUTO_TEST_CASE(test_latest_state_buffer)
+{
+	fc::latest_state_buffer<int> test_buffer{};
+	int test_state{1};
+	fc::pure::state_source<int> source([&test_state](){ return test_state; });
+	fc::pure::state_sink<int> sink{};
+
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+
+	BOOST_CHECK_EQUAL(sink.get(), 0);
+	// the work tick publishes directly.
+	test_buffer.work_tick()();
+	BOOST_CHECK_EQUAL(sink.get(), 1);
+	BOOST_CHECK_EQUAL(sink.get(), 1);
+
+	// several states published between reads, the reader gets the newest.
+	for (test_state = 2; test_state != 5; ++test_state)
+		test_buffer.work_tick()();
+	BOOST_CHECK_EQUAL(sink.get(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_delta_state_buffer)
+{
+	fc::delta_state_buffer<const grid&> test_buffer{2};
+	grid test_state{};
+	fc::pure::state_source<const grid&> source(
+			[&test_state]() -> const grid& { return test_state; });
+	fc::pure::state_sink<const grid&> sink{};
+
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+	grid::copies = 0;
+
+	BOOST_CHECK(test_buffer.current() == nullptr);
+	BOOST_CHECK_EQUAL(sink.get().cells.size(), 1000);
+
+	// the first state is sent as full copy, the buffer keeps another one to diff against.
+	test_state.cells[1] = 1;
+	test_buffer.work_tick()();
+	test_buffer.switch_passive_tick()();
+	test_buffer.switch_active_tick()();
+	BOOST_CHECK_EQUAL(sink.get().cells[1], 1);
+	BOOST_CHECK_EQUAL(grid::copies, 2);
+
+	// later states only as patches, which are applied to the copy of the reader.
+	test_state.cells[2] = 2;
+	test_buffer.work_tick()();
+	test_state.cells[3] = 3;
+	test_buffer.work_tick()();
+	test_buffer.switch_passive_tick()();
+	BOOST_CHECK_EQUAL(sink.get().cells[2], 0);
+	test_buffer.switch_active_tick()();
+	BOOST_CHECK(sink.get().cells == test_state.cells);
+	BOOST_CHECK_EQUAL(&sink.get(), test_buffer.current());
+	BOOST_CHECK_EQUAL(grid::copies, 2);
+
+	// a lagging reader gets a full copy instead of more than 2 patches.
+	for (int i = 4; i != 8; ++i)
+	{
+		test_state.cells[i] = i;
+		test_buffer.work_tick()();
+		test_buffer.switch_passive_tick()();
+	}
+	test_buffer.switch_active_tick()();
+	BOOST_CHECK(sink.get().cells == test_state.cells);
+	BOOST_CHECK_EQUAL(grid::copies, 3);
+
+	test_state.cells[8] = 8;
+	test_buffer.work_tick()();
+	test_buffer.switch_active_passive_tick()();
+	BOOST_CHECK(sink.get().cells == test_state.cells);
+	BOOST_CHECK_EQUAL(grid::copies, 3);
+}
+
+namespace
+{
+/// torn reads would show different values in both halves.
+struct paired_state
+{
+	int64_t first = 0;
+	int64_t second = 0;
+};
+}
+
+BOOST_AUTO_TEST_CASE(test_latest_state_buffer_concurrent)
+{
+	fc::latest_state_buffer<paired_state> test_buffer{};
+	int64_t counter = 0;
+	fc::pure::state_source<paired_state> source(
+			[&counter]() { ++counter; return paired_state{counter, counter}; });
+	fc::pure::state_sink<paired_state> sink{};
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+
+	constexpr int64_t writes = 100000;
+	std::atomic<bool> done{false};
+	std::thread writer{[&]()
+	{
+		for (int64_t i = 0; i != writes; ++i)
+			test_buffer.work_tick()();
+		done = true;
+	}};
+
+	int64_t last = 0;
+	bool consistent = true;
+	bool monotonic = true;
+	while (!done)
+	{
+		const auto state = sink.get();
+		consistent = consistent && state.first == state.second;
+		monotonic = monotonic && state.first >= last;
+		last = state.first;
+	}
+	writer.join();
+	BOOST_CHECK(consistent);
+	BOOST_CHECK(monotonic);
+	// after the writer is done, the reader sees its last state.
+	BOOST_CHECK_EQUAL(sink.get().first, writes);
+}
+
+namespace
+{
+struct no_default_state
+{
+	explicit no_default_state(int v) : value(v) {}
+	int value;
+};
+}
+
+BOOST_AUTO_TEST_CASE(test_state_buffer_without_default_constructor)
+{
+	fc::state_buffer<no_default_state> test_buffer{};
+	int test_state{1};
+	fc::pure::state_source<no_default_state> source(
+			[&test_state](){ return no_default_state{test_state}; });
+	fc::pure::state_sink<no_default_state> sink{};
+
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+
+	BOOST_CHECK(test_buffer.current() == nullptr);
+	BOOST_CHECK_THROW(sink.get(), std::runtime_error);
+
+	test_buffer.work_tick()();
+	test_buffer.switch_active_passive_tick()();
+	BOOST_CHECK_EQUAL(sink.get().value, 1);
+
+	// the borrowed state stays the same until the next switch of the active side.
+	const auto borrowed = test_buffer.current();
+	BOOST_REQUIRE(borrowed != nullptr);
+	test_state = 2;
+	test_buffer.work_tick()();
+	test_buffer.switch_passive_tick()();
+	BOOST_CHECK_EQUAL(borrowed->value, 1);
+	test_buffer.switch_active_tick()();
+	BOOST_CHECK_EQUAL(test_buffer.current()->value, 2);
+	BOOST_CHECK_EQUAL(sink.get().value, 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_state_buffer_borrowed)
+{
+	fc::state_buffer<const std::vector<int>&> test_buffer{};
+	std::vector<int> test_state{1, 2};
+	fc::pure::state_source<const std::vector<int>&> source(
+			[&test_state]() -> const std::vector<int>& { return test_state; });
+	fc::pure::state_sink<const std::vector<int>&> sink{};
+
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+
+	BOOST_CHECK(sink.get().empty());
+	test_buffer.work_tick()();
+	test_buffer.switch_active_passive_tick()();
+	// the buffer holds a single copy, which is lent to the sink.
+	BOOST_CHECK(sink.get() == test_state);
+	BOOST_CHECK_EQUAL(&sink.get(), test_buffer.current());
+	BOOST_CHECK_NE(&sink.get(), &test_state);
+}
+
 BOOST_AUTO_TEST_CASE(test_event_buffer)
 {
 	fc::event_buffer<int> test_buffer{};
@@ -84,4 +332,503 @@ BOOST_AUTO_TEST_CASE(test_event_buffer)
 	}
 }
 
+BOOST_AUTO_TEST_CASE(test_event_buffer_moves_events)
+{
+	// shared_ptr is nulled after move, the use count shows if copies remain.
+	fc::event_buffer<std::shared_ptr<int>> test_buffer{};
+	auto token = std::make_shared<int>(1);
+	long use_count = 0;
+	fc::pure::event_sink<std::shared_ptr<int>> sink(
+			[&](std::shared_ptr<int> in) { use_count = in.use_count(); });
+	fc::pure::event_source<std::shared_ptr<int>> source{};
+
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+
+	source.fire(std::shared_ptr<int>(token));
+	test_buffer.switch_active_passive_tick()();
+	test_buffer.work_tick()();
+	// only token and the event received by sink share ownership.
+	BOOST_CHECK_EQUAL(use_count, 2);
+	BOOST_CHECK_EQUAL(token.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_event_buffer_batches)
+{
+	fc::event_buffer<int> test_buffer{};
+	std::vector<size_t> batch_sizes;
+	std::vector<int> received;
+	fc::pure::event_sink<int> sink(
+			[&](int i) { received.push_back(i); },
+			[&](fc::span<const int> events)
+			{
+				batch_sizes.push_back(events.size());
+				received.insert(received.end(), events.begin(), events.end());
+			});
+	fc::pure::event_source<int> source{};
+
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+
+	source.fire(1);
+	source.fire_batch(std::vector<int>{2, 3});
+	test_buffer.switch_active_passive_tick()();
+	test_buffer.work_tick()();
+	// all events of the cycle arrive as one batch.
+	BOOST_CHECK((batch_sizes == std::vector<size_t>{3}));
+	BOOST_CHECK((received == std::vector<int>{1, 2, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(test_event_buffer_keeps_order_of_several_sinks)
+{
+	fc::event_buffer<int> test_buffer{};
+	std::vector<std::pair<int, int>> received;
+	const auto batch_sink = [&received](int id)
+	{
+		return fc::pure::event_sink<int>(
+				[&received, id](int i) { received.emplace_back(id, i); },
+				[&received, id](fc::span<const int> events)
+				{
+					for (int i : events)
+						received.emplace_back(id, i);
+				});
+	};
+	auto first = batch_sink(1);
+	auto second = batch_sink(2);
+	fc::pure::event_source<int> source{};
+
+	source >> test_buffer.in();
+	test_buffer.out() >> first;
+	test_buffer.out() >> second;
+
+	source.fire_batch(std::vector<int>{1, 2});
+	test_buffer.switch_active_passive_tick()();
+	test_buffer.work_tick()();
+	// every event reaches all sinks before the next, as if it was sent directly.
+	const std::vector<std::pair<int, int>> expected{{1, 1}, {2, 1}, {1, 2}, {2, 2}};
+	BOOST_CHECK(received == expected);
+}
+
+BOOST_AUTO_TEST_CASE(test_bounded_event_buffer)
+{
+	using fc::overflow_policy;
+	const auto received_with = [](overflow_policy policy)
+	{
+		fc::event_buffer<int> test_buffer{2, policy};
+		std::vector<int> received;
+		std::vector<size_t> overflows;
+		fc::pure::event_sink<int> sink([&](int i) { received.push_back(i); });
+		fc::pure::event_sink<size_t> overflow_sink([&](size_t n) { overflows.push_back(n); });
+		fc::pure::event_source<int> source{};
+
+		source >> test_buffer.in();
+		test_buffer.out() >> sink;
+		test_buffer.overflow() >> overflow_sink;
+
+		source.fire(1);
+		source.fire(2);
+		source.fire(3);
+		BOOST_CHECK_EQUAL(test_buffer.dropped_events(), 1);
+		BOOST_CHECK(overflows.empty());
+		test_buffer.switch_active_tick()();
+		// passive side lags behind, middle buffer is full as well.
+		source.fire(4);
+		source.fire(5);
+		test_buffer.switch_active_tick()();
+		test_buffer.switch_passive_tick()();
+		test_buffer.work_tick()();
+		BOOST_CHECK_EQUAL(test_buffer.dropped_events(), 3);
+		BOOST_CHECK((overflows == std::vector<size_t>{1, 2}));
+		return received;
+	};
+
+	BOOST_CHECK((received_with(overflow_policy::drop_oldest) == std::vector<int>{4, 5}));
+	BOOST_CHECK((received_with(overflow_policy::drop_newest) == std::vector<int>{1, 2}));
+}
+
+BOOST_AUTO_TEST_CASE(test_bounded_event_buffer_drops_many)
+{
+	fc::event_buffer<int> test_buffer{4, fc::overflow_policy::drop_oldest};
+	std::vector<int> received;
+	fc::pure::event_sink<int> sink([&](int i) { received.push_back(i); });
+	fc::pure::event_source<int> source{};
+
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+
+	for (int i = 0; i != 1000; ++i)
+		source.fire(i);
+	test_buffer.switch_active_passive_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK((received == std::vector<int>{996, 997, 998, 999}));
+	BOOST_CHECK_EQUAL(test_buffer.dropped_events(), 996);
+	// dropped events are removed in between, the buffer does not keep all of them.
+	BOOST_CHECK_LE(test_buffer.capacity(), 16);
+}
+
+BOOST_AUTO_TEST_CASE(test_event_buffer_drain_limit)
+{
+	fc::event_buffer<int> test_buffer{};
+	test_buffer.set_drain_limit(3);
+	std::vector<int> received;
+	fc::pure::event_sink<int> sink([&](int i) { received.push_back(i); });
+	fc::pure::event_source<int> source{};
+
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+
+	// events of a stalled passive side arrive at once.
+	for (int i = 0; i != 5; ++i)
+	{
+		source.fire(2 * i);
+		source.fire(2 * i + 1);
+		test_buffer.switch_active_tick()();
+	}
+	test_buffer.switch_passive_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK((received == std::vector<int>{0, 1, 2}));
+	BOOST_CHECK_EQUAL(test_buffer.backlog_events(), 7);
+	BOOST_CHECK_EQUAL(test_buffer.queued_events(), 7);
+
+	// carried over events are sent before new ones.
+	source.fire(10);
+	test_buffer.switch_active_tick()();
+	test_buffer.switch_passive_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK((received == std::vector<int>{0, 1, 2, 3, 4, 5}));
+	test_buffer.switch_active_passive_tick()();
+	test_buffer.work_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK_EQUAL(received.size(), 11);
+	for (int i = 0; i != 11; ++i)
+		BOOST_CHECK_EQUAL(received[i], i);
+	BOOST_CHECK_EQUAL(test_buffer.backlog_events(), 0);
+
+	// a budget stops after the first chunk, once it has passed.
+	fc::event_buffer<int> timed{};
+	timed.set_drain_limit(fc::event_buffer<int>::unbounded, std::chrono::nanoseconds(1));
+	size_t nr_received = 0;
+	fc::pure::event_sink<int> counter([&](int) { ++nr_received; });
+	source >> timed.in();
+	timed.out() >> counter;
+	source.fire_batch(std::vector<int>(fc::event_buffer<int>::drain_chunk * 2, 0));
+	timed.switch_active_passive_tick()();
+	timed.work_tick()();
+	BOOST_CHECK_EQUAL(nr_received, fc::event_buffer<int>::drain_chunk);
+	timed.work_tick()();
+	BOOST_CHECK_EQUAL(nr_received, fc::event_buffer<int>::drain_chunk * 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_bounded_event_buffer_throws)
+{
+	fc::event_buffer<int> test_buffer{1, fc::overflow_policy::throw_exception};
+	fc::pure::event_source<int> source{};
+	source >> test_buffer.in();
+
+	source.fire(1);
+	BOOST_CHECK_THROW(source.fire(2), std::overflow_error);
+	BOOST_CHECK_EQUAL(test_buffer.dropped_events(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_event_buffer_keeps_capacity)
+{
+	fc::event_buffer<int> test_buffer{};
+	test_buffer.reserve(4);
+	BOOST_CHECK_GE(test_buffer.capacity(), 4);
+
+	fc::pure::event_sink<int> sink([](int) {});
+	fc::pure::event_source<int> source{};
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+
+	// a single cycle with more events grows all buffers, no matter where they are swapped to.
+	for (int i = 0; i != 100; ++i)
+		source.fire(i);
+	for (int cycle = 0; cycle != 3; ++cycle)
+	{
+		test_buffer.switch_active_tick()();
+		test_buffer.switch_passive_tick()();
+		test_buffer.work_tick()();
+	}
+	BOOST_CHECK_GE(test_buffer.capacity(), 100);
+}
+
+BOOST_AUTO_TEST_CASE(test_event_buffer_soft_memory_limit)
+{
+	auto account = std::make_shared<fc::thread::memory_account>();
+	fc::event_buffer<int> test_buffer{};
+	test_buffer.account_memory(account);
+	test_buffer.reserve(4);
+	BOOST_CHECK_EQUAL(account->used(), 3 * test_buffer.capacity() * sizeof(int));
+
+	std::vector<int> received;
+	fc::pure::event_sink<int> sink([&](int i) { received.push_back(i); });
+	fc::pure::event_source<int> source{};
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+
+	// over the limit the buffer keeps the events, which fit into the memory it already has.
+	account->set_soft_limit(0);
+	const auto capacity = test_buffer.capacity();
+	for (int i = 0; i != 100; ++i)
+		source.fire(i);
+	test_buffer.switch_active_tick()();
+	test_buffer.switch_passive_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK_EQUAL(received.size(), capacity);
+	BOOST_CHECK_EQUAL(test_buffer.dropped_events(), 100 - capacity);
+	BOOST_CHECK_EQUAL(received.back(), 99);
+
+	// the limit is lifted on the next switch tick.
+	account->set_soft_limit(fc::thread::memory_account::unlimited);
+	test_buffer.switch_active_tick()();
+	received.clear();
+	for (int i = 0; i != 100; ++i)
+		source.fire(i);
+	test_buffer.switch_active_tick()();
+	test_buffer.switch_passive_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK_EQUAL(received.size(), 100);
+	BOOST_CHECK_GE(account->used(), 100 * sizeof(int));
+}
+
+BOOST_AUTO_TEST_CASE(test_event_buffer_traces_latency)
+{
+	fc::event_buffer<int> test_buffer{};
+	auto latency = std::make_shared<fc::thread::duration_histogram>();
+	test_buffer.trace_latency(latency, 2);
+	fc::pure::event_sink<int> sink([](int) {});
+	fc::pure::event_source<int> source{};
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+
+	// the first event is sampled, the second is not.
+	source.fire(1);
+	test_buffer.switch_active_passive_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK_EQUAL(latency->snapshot().count, 1);
+	source.fire(2);
+	test_buffer.switch_active_passive_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK_EQUAL(latency->snapshot().count, 1);
+
+	// events waiting for a lagging passive side are traced once, when they are sent.
+	source.fire(3);
+	test_buffer.switch_active_tick()();
+	source.fire(4);
+	source.fire(5);
+	test_buffer.switch_active_tick()();
+	test_buffer.switch_passive_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK_EQUAL(latency->snapshot().count, 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_coalescing_event_buffer)
+{
+	fc::coalescing_event_buffer<int> test_buffer{};
+	std::vector<int> received;
+	fc::pure::event_sink<int> sink([&](int i) { received.push_back(i); });
+	fc::pure::event_source<int> source{};
+
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+
+	source.fire(1);
+	source.fire(2);
+	test_buffer.switch_active_tick()();
+	// passive side lags behind, the latest event replaces the older one.
+	source.fire(3);
+	test_buffer.switch_active_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK(received.empty());
+	test_buffer.switch_passive_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK((received == std::vector<int>{3}));
+
+	// nothing new, nothing is sent again.
+	test_buffer.switch_active_passive_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK((received == std::vector<int>{3}));
+
+	source.fire(4);
+	test_buffer.switch_active_passive_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK((received == std::vector<int>{3, 4}));
+}
+
+BOOST_AUTO_TEST_CASE(test_coalescing_event_buffer_per_key)
+{
+	fc::coalescing_event_buffer<keyed_event> test_buffer{};
+	std::vector<int> received;
+	fc::pure::event_sink<keyed_event> sink([&](keyed_event e)
+	{
+		received.push_back(e.key * 10 + e.value);
+	});
+	fc::pure::event_source<keyed_event> source{};
+
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+
+	source.fire(keyed_event{1, 1});
+	source.fire(keyed_event{2, 1});
+	test_buffer.switch_active_tick()();
+	source.fire(keyed_event{1, 2});
+	test_buffer.switch_active_tick()();
+	test_buffer.switch_passive_tick()();
+	test_buffer.work_tick()();
+	// latest event of each key, in the order keys were first received.
+	BOOST_CHECK((received == std::vector<int>{12, 21}));
+}
+
+BOOST_AUTO_TEST_CASE(test_priority_event_buffer)
+{
+	fc::priority_event_buffer<message> test_buffer{2};
+	std::vector<int> received;
+	fc::pure::event_sink<message> sink([&](message m) { received.push_back(m.value); });
+	fc::pure::event_source<message> source{};
+
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+
+	const auto cycle = [&]()
+	{
+		test_buffer.switch_active_tick()();
+		test_buffer.switch_passive_tick()();
+		test_buffer.work_tick()();
+	};
+	// a burst of bulk events with a control event at its end.
+	for (int i = 1; i != 6; ++i)
+		source.fire(message{i});
+	source.fire(message{-1});
+	cycle();
+	BOOST_CHECK((received == std::vector<int>{-1, 1, 2}));
+	BOOST_CHECK_EQUAL(test_buffer.backlog_size(), 3);
+
+	// urgent events of later cycles overtake the backlog.
+	source.fire(message{6});
+	source.fire(message{-2});
+	cycle();
+	BOOST_CHECK((received == std::vector<int>{-1, 1, 2, -2, 3, 4}));
+	cycle();
+	cycle();
+	BOOST_CHECK((received == std::vector<int>{-1, 1, 2, -2, 3, 4, 5, 6}));
+	BOOST_CHECK_EQUAL(test_buffer.backlog_size(), 0);
+
+	// without limit all bulk events are sent after the urgent ones.
+	fc::priority_event_buffer<message> unlimited{};
+	received.clear();
+	source >> unlimited.in();
+	unlimited.out() >> sink;
+	source.fire(message{1});
+	source.fire(message{-1});
+	unlimited.switch_active_passive_tick()();
+	unlimited.work_tick()();
+	BOOST_CHECK((received == std::vector<int>{-1, 1}));
+}
+
+BOOST_AUTO_TEST_CASE(test_ring_event_buffer)
+{
+	fc::ring_event_buffer<int> test_buffer{3};
+	BOOST_CHECK_EQUAL(test_buffer.capacity(), 4);
+
+	std::vector<int> received;
+	fc::pure::event_sink<int> sink([&](int i) { received.push_back(i); });
+	fc::pure::event_source<int> source{};
+
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+
+	source.fire(1);
+	test_buffer.switch_active_tick()();
+	source.fire(2);
+	test_buffer.switch_passive_tick()();
+	test_buffer.work_tick()();
+	// events after the active switch wait for the next one.
+	BOOST_CHECK(received == std::vector<int>{1});
+
+	// passive side lags behind, events of several active switches are sent together.
+	test_buffer.switch_active_tick()();
+	source.fire(3);
+	test_buffer.switch_active_tick()();
+	test_buffer.switch_passive_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK((received == std::vector<int>{1, 2, 3}));
+
+	// fill the ring completely, wrapping around its end.
+	for (int i = 4; i != 8; ++i)
+		source.fire(i);
+	test_buffer.switch_active_passive_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK((received == std::vector<int>{1, 2, 3, 4, 5, 6, 7}));
+}
+
+BOOST_AUTO_TEST_CASE(test_full_ring_event_buffer)
+{
+	using fc::overflow_policy;
+	const auto received_with = [](overflow_policy policy)
+	{
+		fc::ring_event_buffer<int> test_buffer{4, policy};
+		std::vector<int> received;
+		std::vector<size_t> overflows;
+		fc::pure::event_sink<int> sink([&](int i) { received.push_back(i); });
+		fc::pure::event_sink<size_t> overflow_sink([&](size_t n) { overflows.push_back(n); });
+		fc::pure::event_source<int> source{};
+
+		source >> test_buffer.in();
+		test_buffer.out() >> sink;
+		test_buffer.overflow() >> overflow_sink;
+
+		// the first event is already published, only the others can be dropped.
+		source.fire(0);
+		test_buffer.switch_active_tick()();
+		for (int i = 1; i != 6; ++i)
+			source.fire(i);
+		test_buffer.switch_active_tick()();
+		test_buffer.switch_passive_tick()();
+		test_buffer.work_tick()();
+		BOOST_CHECK((overflows == std::vector<size_t>{2}));
+		BOOST_CHECK_EQUAL(test_buffer.dropped_events(), 2);
+		return received;
+	};
+	BOOST_CHECK((received_with(overflow_policy::drop_oldest) == std::vector<int>{0, 3, 4, 5}));
+	BOOST_CHECK((received_with(overflow_policy::drop_newest) == std::vector<int>{0, 1, 2, 3}));
+
+	// if all events are published, drop_oldest drops the new ones.
+	fc::ring_event_buffer<int> test_buffer{2};
+	std::vector<int> received;
+	fc::pure::event_sink<int> sink([&](int i) { received.push_back(i); });
+	fc::pure::event_source<int> source{};
+	source >> test_buffer.in();
+	test_buffer.out() >> sink;
+	source.fire(1);
+	source.fire(2);
+	test_buffer.switch_active_tick()();
+	source.fire(3);
+	test_buffer.switch_active_tick()();
+	test_buffer.switch_passive_tick()();
+	test_buffer.work_tick()();
+	BOOST_CHECK((received == std::vector<int>{1, 2}));
+	BOOST_CHECK_EQUAL(test_buffer.dropped_events(), 1);
+
+	fc::ring_event_buffer<int> throwing{1, overflow_policy::throw_exception};
+	fc::pure::event_source<int> throwing_source{};
+	throwing_source >> throwing.in();
+	throwing_source.fire(1);
+	BOOST_CHECK_THROW(throwing_source.fire(2), std::overflow_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_ring_event_buffer_destroys_events)
+{
+	auto token = std::make_shared<int>(0);
+	{
+		fc::ring_event_buffer<std::shared_ptr<int>> test_buffer{};
+		fc::pure::event_source<std::shared_ptr<int>> source{};
+		source >> test_buffer.in();
+		source.fire(token);
+		source.fire(token);
+		BOOST_CHECK_EQUAL(token.use_count(), 3);
+	}
+	BOOST_CHECK_EQUAL(token.use_count(), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
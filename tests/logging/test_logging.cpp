@@ -3,8 +3,15 @@
 #define BOOST_ALL_DYN_LINK
 #include <boost/test/unit_test.hpp>
 #include <flexcore/utils/logging/logger.hpp>
+#include <flexcore/utils/logging/binary_log.hpp>
 #include <tests/nodes/owning_node.hpp>
+#include <chrono>
+#include <cstdio>
 #include <sstream>
+#include <thread>
+
+#include <stdlib.h>
+#include <unistd.h>
 
 BOOST_AUTO_TEST_SUITE(test_logging)
 
@@ -90,10 +97,205 @@ BOOST_AUTO_TEST_CASE( syslog_logging_works )
 
 BOOST_AUTO_TEST_CASE( file_logging_works )
 {
-	logger::get().add_file_log("./localfile.txt");
+	// the file stays registered for the rest of the tests, keep it out of the working directory.
+	char path[] = "/tmp/flexcore_log_XXXXXX";
+	const int file = mkstemp(path);
+	BOOST_REQUIRE(file >= 0);
+	::close(file);
+	logger::get().add_file_log(path);
 	fc::log_client client;
 	client.write("writing to localfile.");
-	BOOST_CHECK(true);
+	// the backend keeps the file open, later records go to the unlinked file.
+	BOOST_CHECK_EQUAL(std::remove(path), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE( async_logging, log_test )
+{
+	logger::get().enable_async(16);
+	fc::log_client client{"async channel"};
+	expected_in_output = "[async channel] queued message.";
+	client.write("queued message.");
+	logger::get().flush_async();
+	BOOST_CHECK_NE(stream.str().find(expected_in_output), std::string::npos);
+	logger::get().disable_async();
+}
+
+BOOST_AUTO_TEST_CASE( async_logging_drops_on_full_queue )
+{
+	logger::get().enable_async(16);
+	const auto dropped_before = logger::get().dropped_messages();
+	fc::log_client client;
+	// the queue holds 16 messages, the background thread cannot take them all in time.
+	for (int i = 0; i != 10000; ++i)
+		client.write("flood");
+	logger::get().disable_async();
+	BOOST_CHECK_GT(logger::get().dropped_messages(), dropped_before);
+}
+
+BOOST_FIXTURE_TEST_CASE( binary_logging_formats_for_text_logs, log_test )
+{
+	static const fc::log_format format{"counted {} of {}"};
+	fc::binary_log_client client{"binary channel"};
+	expected_in_output = "[binary channel] counted 7 of 9";
+	client.write(fc::level::debug, format, 7, 9u);
+}
+
+BOOST_AUTO_TEST_CASE( binary_log_round_trip )
+{
+	std::stringstream binary_stream;
+	{
+		auto handle = logger::get().add_binary_log(binary_stream);
+		static const fc::log_format format{"{} is {}, {} and {} {}"};
+		fc::binary_log_client client{"round trip"};
+		client.write(format, -3, 1.5, std::string("text"), true, "literal");
+	}
+
+	// decode with a copy of the string table, like an offline decoder would.
+	std::stringstream table_stream;
+	fc::log_string_table::global().write(table_stream);
+	fc::log_string_table table;
+	table.read(table_stream);
+
+	fc::binary_log_record record;
+	BOOST_REQUIRE(fc::read_binary(binary_stream, record));
+	BOOST_CHECK_EQUAL(fc::format_record(record, table), "-3 is 1.5, text and true literal");
+	BOOST_CHECK_EQUAL(table.lookup(record.channel), "round trip");
+	BOOST_CHECK(!fc::read_binary(binary_stream, record));
+}
+
+BOOST_AUTO_TEST_CASE( binary_log_drops_arguments_beyond_payload )
+{
+	static const fc::log_format format{"{} {} {}"};
+	const std::string long_string(200, 'x');
+	fc::binary_log_record record;
+	record.format = format.id();
+	record.payload_size = 0;
+	record.nr_of_arguments = 0;
+	fc::detail::append(record, long_string);
+	fc::detail::append(record, long_string);
+	fc::detail::append(record, 1);
+	BOOST_CHECK_LE(record.payload_size, fc::binary_log_record::max_payload);
+	BOOST_CHECK_EQUAL(record.nr_of_arguments, 2);
+	// the second string is cut to the space left in the payload.
+	BOOST_CHECK_EQUAL(record.payload_size, fc::binary_log_record::max_payload);
+	BOOST_CHECK_EQUAL(fc::format_record(record).find("{}"), fc::format_record(record).size() - 2);
+}
+
+BOOST_AUTO_TEST_CASE( severity_thresholds )
+{
+	fc::log_client client{"filtered channel"};
+	BOOST_CHECK(client.enabled(fc::level::debug));
+
+	logger::get().set_threshold(fc::level::warning);
+	BOOST_CHECK(!client.enabled(fc::level::info));
+	BOOST_CHECK(client.enabled(fc::level::error));
+
+	bool built = false;
+	client.write([&built]() { built = true; return std::string("expensive"); }, fc::level::debug);
+	BOOST_CHECK(!built);
+	client.write([&built]() { built = true; return std::string("important"); }, fc::level::error);
+	BOOST_CHECK(built);
+
+	// the channel threshold overrides the global one for all clients of the channel.
+	logger::get().set_channel_threshold("filtered channel", fc::level::debug);
+	BOOST_CHECK(fc::log_client{"filtered channel"}.enabled(fc::level::debug));
+	BOOST_CHECK(client.enabled(fc::level::debug));
+	BOOST_CHECK(!fc::log_client{"other channel"}.enabled(fc::level::debug));
+	logger::get().reset_channel_threshold("filtered channel");
+	BOOST_CHECK(!client.enabled(fc::level::debug));
+
+	fc::stream_log_client debug_stream{client, fc::level::debug};
+	int evaluated = 0;
+	FLEXCORE_LOG_STREAM(debug_stream) << std::to_string(++evaluated);
+	BOOST_CHECK_EQUAL(evaluated, 0);
+
+	fc::binary_log_client binary{"filtered channel"};
+	BOOST_CHECK(!binary.enabled(fc::level::debug));
+
+	logger::get().set_threshold(fc::level::debug);
+	FLEXCORE_LOG_STREAM(debug_stream) << std::to_string(++evaluated);
+	BOOST_CHECK_EQUAL(evaluated, 1);
+}
+
+BOOST_FIXTURE_TEST_CASE( rate_limited_channel, log_test )
+{
+	using namespace std::chrono_literals;
+	logger::get().set_rate_limit("limited channel", 4, 50ms);
+	const auto suppressed_before = logger::get().suppressed_messages();
+	fc::log_client client{"limited channel"};
+
+	for (int i = 0; i != 3; ++i)
+		client.write("same failure", fc::level::error);
+	int built = 0;
+	for (int i = 0; i != 100; ++i)
+		client.write([&]() { return "failure " + std::to_string(++built); }, fc::level::warning);
+	// repetitions count against the limit, messages beyond it are not even built.
+	BOOST_CHECK_EQUAL(built, 1);
+	BOOST_CHECK_EQUAL(logger::get().suppressed_messages() - suppressed_before, 101);
+
+	// the repetitions are reported once another message is written.
+	const auto repeats = stream.str().find(
+			"<" + std::to_string(LOG_ERR) + ">[limited channel] message \"same failure\""
+			" repeated 2 times in the last 50ms");
+	BOOST_CHECK_NE(repeats, std::string::npos);
+	BOOST_CHECK_NE(stream.str().find("failure 1", repeats), std::string::npos);
+	BOOST_CHECK_EQUAL(stream.str().find("failure 2"), std::string::npos);
+
+	// the rest is reported with the most severe level discarded, once the interval is over.
+	std::this_thread::sleep_for(60ms);
+	client.write("next interval");
+	expected_in_output = "<" + std::to_string(LOG_WARNING) + ">[limited channel] "
+			"99 messages suppressed in the last 50ms";
+	BOOST_CHECK_NE(stream.str().find("next interval", stream.str().find(expected_in_output)),
+			std::string::npos);
+
+	logger::get().set_rate_limit("limited channel", 0);
+	for (int i = 0; i != 10; ++i)
+		client.write("unlimited");
+	BOOST_CHECK_EQUAL(logger::get().suppressed_messages() - suppressed_before, 101);
+}
+
+BOOST_FIXTURE_TEST_CASE( rate_limited_region, log_test )
+{
+	using namespace std::chrono_literals;
+	fc::tests::owning_node node("limited region");
+	auto& first = node.node().make_child_named<fc::tree_base_node>("first");
+	auto& second = node.node().make_child_named<fc::tree_base_node>("second");
+	logger::get().set_region_rate_limit("limited region", 2, 50ms);
+	fc::log_client first_client{first};
+	// nodes held by const reference are limited by their region as well.
+	const fc::tree_base_node& const_second = second;
+	fc::log_client second_client{const_second};
+	fc::log_client other{"unrelated"};
+
+	first_client.write("first 1");
+	first_client.write("first 2");
+	second_client.write("second 1");
+	other.write("not limited");
+	BOOST_CHECK_EQUAL(stream.str().find("second 1"), std::string::npos);
+	BOOST_CHECK_NE(stream.str().find("not limited"), std::string::npos);
+
+	std::this_thread::sleep_for(60ms);
+	second_client.write("second 2");
+	expected_in_output = "1 messages of the region suppressed in the last 50ms";
+	BOOST_CHECK_NE(stream.str().find("second 2"), std::string::npos);
+	logger::get().set_region_rate_limit("limited region", 0);
+}
+
+BOOST_FIXTURE_TEST_CASE( rate_limits_before_async_queue, log_test )
+{
+	logger::get().set_rate_limit("async limited", 1);
+	logger::get().enable_async(16);
+	const auto dropped_before = logger::get().dropped_messages();
+	fc::log_client client{"async limited"};
+	for (int i = 0; i != 10000; ++i)
+		client.write([i]() { return "flood " + std::to_string(i); });
+	logger::get().flush_async();
+	logger::get().disable_async();
+	BOOST_CHECK_EQUAL(logger::get().dropped_messages(), dropped_before);
+	expected_in_output = "[async limited] flood 0";
+	BOOST_CHECK_EQUAL(stream.str().find("flood 1"), std::string::npos);
+	logger::get().set_rate_limit("async limited", 0);
 }
 
 BOOST_AUTO_TEST_CASE( log_client_copy_and_move )
@@ -0,0 +1,205 @@
+#include <boost/test/unit_test.hpp>
+
+#include <flexcore/extended/graph/graph.hpp>
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/extended/nodes/terminal.hpp>
+#include <flexcore/extended/ports/connection_buffer.hpp>
+#include <flexcore/ports.hpp>
+#include <flexcore/scheduler/cyclecontrol.hpp>
+#include <flexcore/scheduler/parallelscheduler.hpp>
+#include <flexcore/utils/metrics/http_exporter.hpp>
+#include <flexcore/utils/metrics/publishers.hpp>
+#include <flexcore/utils/metrics/registry.hpp>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(test_metrics)
+
+using fc::operator>>;
+
+namespace
+{
+bool contains(const std::string& text, const std::string& part)
+{
+	return text.find(part) != std::string::npos;
+}
+
+/// sends request to the exporter on localhost and returns the whole response.
+std::string http_get(uint16_t port, const std::string& path)
+{
+	const int s = ::socket(AF_INET, SOCK_STREAM, 0);
+	BOOST_REQUIRE_GE(s, 0);
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	::inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+	BOOST_REQUIRE_EQUAL(::connect(s, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+	const std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+	::send(s, request.data(), request.size(), 0);
+	std::string response;
+	char buffer[4096];
+	for (auto n = ::recv(s, buffer, sizeof(buffer), 0); n > 0; n = ::recv(s, buffer, sizeof(buffer), 0))
+		response.append(buffer, static_cast<size_t>(n));
+	::close(s);
+	return response;
+}
+}
+
+BOOST_AUTO_TEST_CASE(test_text_format)
+{
+	fc::metrics::registry r;
+	auto first = r.add([](fc::metrics::metric_writer& out)
+	{
+		out.counter("events_total", "Events.", {{"port", "a"}}, 3);
+		out.gauge("depth", "Depth of \"queue\".", {}, 1.5);
+	});
+	auto second = r.add([](fc::metrics::metric_writer& out)
+	{
+		out.counter("events_total", "Events.", {{"port", "b\"c"}}, 4);
+	});
+	BOOST_CHECK_EQUAL(r.size(), 2);
+
+	const auto text = r.scrape();
+	BOOST_CHECK(contains(text, "# HELP events_total Events.\n# TYPE events_total counter\n"
+			"events_total{port=\"a\"} 3\nevents_total{port=\"b\\\"c\"} 4\n"));
+	BOOST_CHECK(contains(text, "# TYPE depth gauge\ndepth 1.5\n"));
+	// samples of a metric stay together, even if written by different collectors.
+	BOOST_CHECK_EQUAL(text.find("# TYPE events_total"), text.rfind("# TYPE events_total"));
+
+	first.reset();
+	BOOST_CHECK_EQUAL(r.size(), 1);
+	BOOST_CHECK(!contains(r.scrape(), "depth"));
+	{
+		auto conflicting = r.add([](fc::metrics::metric_writer& out)
+		{
+			out.gauge("events_total", "Events.", {}, 1);
+		});
+		BOOST_CHECK_THROW(r.scrape(), std::invalid_argument);
+	}
+	BOOST_CHECK_NO_THROW(r.scrape());
+}
+
+BOOST_AUTO_TEST_CASE(test_histogram_buckets)
+{
+	fc::thread::duration_histogram durations;
+	durations.record(std::chrono::microseconds(3));
+	durations.record(std::chrono::microseconds(3));
+	durations.record(std::chrono::milliseconds(2));
+
+	fc::metrics::metric_writer out;
+	out.histogram("work_seconds", "Work.", {{"region", "r"}}, durations.snapshot());
+	const auto text = out.text();
+	BOOST_CHECK(contains(text, "# TYPE work_seconds histogram\n"));
+	// buckets are cumulative and given in seconds.
+	BOOST_CHECK(contains(text, "work_seconds_bucket{region=\"r\",le=\"1e-06\"} 0\n"));
+	BOOST_CHECK(contains(text, "work_seconds_bucket{region=\"r\",le=\"4e-06\"} 2\n"));
+	BOOST_CHECK(contains(text, "work_seconds_bucket{region=\"r\",le=\"+Inf\"} 3\n"));
+	BOOST_CHECK(contains(text, "work_seconds_count{region=\"r\"} 3\n"));
+	BOOST_CHECK(contains(text, "work_seconds_sum{region=\"r\"} 0.002006\n"));
+}
+
+BOOST_AUTO_TEST_CASE(test_publish_cycle_control)
+{
+	namespace sched = fc::thread;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(),
+		[](auto& task) { return task.wait_until_done(sched::cycle_control::slow_tick); },
+		std::make_shared<sched::afap_main_loop>()};
+	auto region = std::make_shared<fc::parallel_region>("control", sched::cycle_control::fast_tick);
+	region->work_tick() >> []{};
+	controller.add_task(sched::periodic_task{region}, sched::cycle_control::fast_tick);
+
+	fc::metrics::registry r;
+	const auto handle = fc::metrics::publish(r, controller);
+	// every cycle waits for the task, so none of them is skipped.
+	for (uint64_t i = 1; i != 11; ++i)
+	{
+		controller.work();
+		for (int j = 0; j != 5000 && controller.timing().tasks.front().execution.count != i; ++j)
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+
+	const auto text = r.scrape();
+	BOOST_CHECK(contains(text,
+			"flexcore_task_execution_seconds_count{region=\"control\",tick_ms=\"10\"} 10\n"));
+	BOOST_CHECK(contains(text, "# TYPE flexcore_task_queueing_seconds histogram\n"));
+	BOOST_CHECK(contains(text,
+			"flexcore_task_skipped_cycles_total{region=\"control\",tick_ms=\"10\"} 0\n"));
+	BOOST_CHECK(contains(text, "flexcore_main_loop_overrun_seconds_count"));
+	BOOST_CHECK(contains(text, "# TYPE flexcore_scheduler_waiting_tasks gauge\n"));
+}
+
+BOOST_AUTO_TEST_CASE(test_publish_ports_and_buffers)
+{
+	fc::graph::connection_graph graph;
+	graph.enable_port_counters();
+	fc::forest_owner forest{graph, "forest", std::make_shared<fc::parallel_region>("r",
+			fc::thread::cycle_control::fast_tick)};
+	auto& source = forest.nodes().make_child_named<fc::event_terminal<int>>("source");
+	auto& sink = forest.nodes().make_child_named<fc::event_terminal<int>>("sink");
+	source.out() >> sink.in();
+	source.in()(1);
+	source.in()(2);
+
+	fc::event_buffer<int> buffer;
+	buffer.in()(3);
+	buffer.switch_active_passive_tick()();
+
+	fc::metrics::registry r;
+	const auto ports = fc::metrics::publish(r, graph);
+	const auto buffers = fc::metrics::publish_buffer(r, "between", buffer);
+	const auto text = r.scrape();
+	BOOST_CHECK(contains(text, "flexcore_port_events_total{node=\""));
+	BOOST_CHECK(contains(text, "flexcore_buffer_queued_events{buffer=\"between\"} 1\n"));
+	BOOST_CHECK(contains(text, "flexcore_buffer_dropped_events_total{buffer=\"between\"} 0\n"));
+	BOOST_CHECK(contains(text, "flexcore_buffer_backlog_events{buffer=\"between\"} 0\n"));
+	// the names of ports are cached, the second scrape reports the same.
+	BOOST_CHECK_EQUAL(r.scrape(), text);
+}
+
+BOOST_AUTO_TEST_CASE(test_publish_region_memory)
+{
+	fc::parallel_region region{"memory", fc::thread::cycle_control::fast_tick};
+	fc::thread::memory_charge charge{region.shared_memory_account(), 300};
+	charge.update(100);
+
+	fc::metrics::registry r;
+	const auto handle = fc::metrics::publish(r, region);
+	auto text = r.scrape();
+	BOOST_CHECK(contains(text, "flexcore_region_memory_bytes{region=\"memory\"} 100\n"));
+	BOOST_CHECK(contains(text, "flexcore_region_memory_peak_bytes{region=\"memory\"} 300\n"));
+	BOOST_CHECK(!contains(text, "flexcore_region_memory_soft_limit_bytes"));
+
+	region.memory().set_soft_limit(50);
+	BOOST_CHECK(charge.over_soft_limit());
+	text = r.scrape();
+	BOOST_CHECK(contains(text, "flexcore_region_memory_soft_limit_bytes{region=\"memory\"} 50\n"));
+}
+
+BOOST_AUTO_TEST_CASE(test_http_exporter)
+{
+	fc::metrics::registry r;
+	const auto handle = r.add([](fc::metrics::metric_writer& out)
+	{
+		out.counter("scraped_total", "Scrapes.", {}, 7);
+	});
+	fc::metrics::http_exporter exporter{r};
+	BOOST_CHECK_NE(exporter.port(), 0);
+
+	const auto response = http_get(exporter.port(), "/metrics");
+	BOOST_CHECK(contains(response, "HTTP/1.1 200 OK\r\n"));
+	BOOST_CHECK(contains(response, "Content-Type: text/plain; version=0.0.4"));
+	BOOST_CHECK(contains(response, "\r\n\r\n# HELP scraped_total Scrapes.\n"));
+	BOOST_CHECK(contains(response, "scraped_total 7\n"));
+	BOOST_CHECK(contains(http_get(exporter.port(), "/other"), "HTTP/1.1 404 Not Found\r\n"));
+	BOOST_CHECK_EQUAL(exporter.scrapes(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
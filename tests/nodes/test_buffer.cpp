@@ -88,6 +88,110 @@ BOOST_AUTO_TEST_CASE(event_range_to_state)
 
 }
 
+BOOST_AUTO_TEST_CASE(test_list_collector_backlog)
+{
+	tests::owning_node root{};
+	auto& buffer = root.make_child_named<collector_t>("collector");
+	event_source<std::vector<int>> source{&root.node()};
+	source >> buffer.in();
+
+	// unread data of several cycles is kept in order.
+	for (int i = 0; i != 4; ++i)
+	{
+		source.fire(std::vector<int>{2 * i, 2 * i + 1});
+		buffer.swap_buffers()();
+	}
+	BOOST_CHECK_EQUAL(buffer.out_backlog()(), 8);
+	BOOST_CHECK((buffer.out()() == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7}));
+	// state stays constant until the next swap.
+	BOOST_CHECK_EQUAL(buffer.out()().size(), 8);
+	buffer.swap_buffers()();
+	BOOST_CHECK_EQUAL(buffer.out_backlog()(), 0);
+
+	buffer.limit_backlog(3);
+	source.fire(std::vector<int>{1, 2});
+	buffer.swap_buffers()();
+	source.fire(std::vector<int>{3, 4});
+	buffer.swap_buffers()();
+	BOOST_CHECK_EQUAL(buffer.dropped_elements(), 1);
+	source.fire(std::vector<int>{5, 6, 7, 8});
+	buffer.swap_buffers()();
+	BOOST_CHECK_EQUAL(buffer.dropped_elements(), 5);
+	BOOST_CHECK((buffer.out()() == std::vector<int>{6, 7, 8}));
+}
+
+BOOST_AUTO_TEST_CASE(test_list_collector_view)
+{
+	tests::owning_node root{};
+	auto& buffer = root.make_child_named<collector_t>("collector");
+	event_source<std::vector<int>> source{&root.node()};
+	source >> buffer.in();
+
+	source.fire(std::vector<int>{1, 2, 3});
+	buffer.swap_buffers()();
+	const auto view = buffer.out_view()();
+	BOOST_CHECK((std::vector<int>(view.begin(), view.end()) == std::vector<int>{1, 2, 3}));
+	BOOST_CHECK(view.data() == buffer.out_view()().data()); // not copied
+
+	// reading the view consumes the data like out().
+	source.fire(std::vector<int>{4});
+	buffer.swap_buffers()();
+	BOOST_CHECK(buffer.out()() == std::vector<int>{4});
+
+	list_collector<int, swap_on_pull, pure::pure_node> pull_collector{};
+	pull_collector.in()(std::vector<int>{5, 6});
+	const auto pulled = pull_collector.out_view()();
+	BOOST_CHECK((std::vector<int>(pulled.begin(), pulled.end()) == std::vector<int>{5, 6}));
+	BOOST_CHECK(pull_collector.out_view()().empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_buffers_account_memory)
+{
+	tests::owning_node root{};
+	auto& memory = root.region()->memory();
+	const auto empty = memory.used();
+	{
+		auto& hold = root.make_child<hold_n<int, tree_base_node>>(100);
+		BOOST_CHECK_GE(memory.used(), empty + sizeof(hold) + 100 * sizeof(int));
+	}
+
+	auto& buffer = root.make_child_named<collector_t>("collector");
+	event_source<std::vector<int>> source{&root.node()};
+	source >> buffer.in();
+	const auto before = memory.used();
+	source.fire(std::vector<int>(1000, 1));
+	buffer.swap_buffers()();
+	BOOST_CHECK_GE(memory.used(), before + 1000 * sizeof(int));
+
+	// over the soft limit only the newest cycle is kept.
+	memory.set_soft_limit(before);
+	source.fire(std::vector<int>{1, 2});
+	buffer.swap_buffers()();
+	BOOST_CHECK_EQUAL(buffer.dropped_elements(), 1000);
+	BOOST_CHECK((buffer.out()() == std::vector<int>{1, 2}));
+}
+
+BOOST_AUTO_TEST_CASE(test_hold_n_view)
+{
+	tests::owning_node root{};
+	auto& buffer = root.make_child<hold_n<int, tree_base_node>>(3);
+	event_source<int> source{&root.node()};
+	source >> buffer.in();
+
+	BOOST_CHECK(buffer.out_view()().empty());
+	for (int i = 0; i != 5; ++i)
+	{
+		source.fire(i);
+		const auto view = buffer.out_view()();
+		BOOST_CHECK_EQUAL(view.size(), buffer.out()().size());
+		BOOST_CHECK(std::vector<int>(view.begin(), view.end()) == buffer.out()());
+	}
+	// the circular buffer has wrapped around.
+	const auto view = buffer.out_view()();
+	BOOST_CHECK_EQUAL(view[0], 2);
+	BOOST_CHECK_EQUAL(view[2], 4);
+}
+
 BOOST_AUTO_TEST_CASE(test_hold_last)
 {
 	tests::owning_node root{};
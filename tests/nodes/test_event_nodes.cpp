@@ -2,6 +2,8 @@
 
 #include <flexcore/extended/nodes/event_nodes.hpp>
 
+#include <vector>
+
 
 using namespace fc;
 
@@ -50,6 +52,37 @@ BOOST_AUTO_TEST_CASE(test_gate_with_control)
 	BOOST_CHECK_EQUAL(test_val, 0);
 }
 
+BOOST_AUTO_TEST_CASE(test_gate_with_latched_control)
+{
+	gate_with_control<int> test_gate;
+
+	int test_val = 0;
+	int pulls = 0;
+	bool control_val = true;
+	auto sink = [&test_val](int i){ test_val = i; };
+	auto control = [&control_val, &pulls](){ ++pulls; return control_val; };
+
+	test_gate.out() >> sink;
+	control >> test_gate.in_control();
+
+	auto latch = test_gate.latch_tick();
+	latch();
+	control_val = false;
+	test_gate.in()(1);
+	test_gate.in()(2);
+	BOOST_CHECK_EQUAL(test_val, 2);
+	BOOST_CHECK_EQUAL(pulls, 1);
+
+	latch();
+	test_gate.in()(3);
+	BOOST_CHECK_EQUAL(test_val, 2);
+
+	test_gate.in_control_event()(true);
+	test_gate.in()(4);
+	BOOST_CHECK_EQUAL(test_val, 4);
+	BOOST_CHECK_EQUAL(pulls, 2);
+}
+
 BOOST_AUTO_TEST_CASE(test_gate_with_void_token)
 {
 	gate_with_control<void> test_gate;
@@ -114,4 +147,21 @@ BOOST_AUTO_TEST_CASE(test_pair_splitter_joiner)
 
 }
 
+BOOST_AUTO_TEST_CASE(test_dense_and_hashed_routing)
+{
+	fc::pair_splitter<size_t, int, fc::pure::pure_node, fc::dense_keys> splitter;
+	fc::pair_joiner<size_t, int, fc::pure::pure_node, fc::hashed_keys> joiner;
+	joiner.out() >> splitter.in();
+
+	std::vector<int> received(4, 0);
+	for (size_t key = 0; key != received.size(); ++key)
+		splitter.out(key) >> [&received, key](int in){ received[key] = in; };
+	BOOST_CHECK(&splitter.out(2) == &splitter.out(2));
+
+	joiner.in(3)(30);
+	joiner.in(0)(10);
+	joiner.in(100)(5); // no port for key 100, dropped
+	BOOST_CHECK((received == std::vector<int>{10, 0, 0, 30}));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
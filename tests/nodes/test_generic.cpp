@@ -5,6 +5,12 @@
 #include "owning_node.hpp"
 #include <pure/sink_fixture.hpp>
 
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(test_generic_nodes)
 
 using fc::operator>>;
@@ -68,6 +74,136 @@ BOOST_AUTO_TEST_CASE(test_n_ary_switch_events)
 	BOOST_CHECK_EQUAL(buffer.empty(), false);
 }
 
+BOOST_AUTO_TEST_CASE(test_n_ary_switch_latched_dense)
+{
+	fc::tests::owning_node root{};
+	fc::event_source<int> source_1(&root.node());
+	fc::event_source<int> source_7(&root.node());
+	auto& test_switch = root.make_child_named<fc::n_ary_switch<
+			int, fc::event_tag, size_t, fc::tree_base_node, fc::dense_keys>>("switch");
+
+	size_t switch_param{1};
+	int pulls{0};
+	fc::state_source<size_t> config(&root.node(),
+			[&switch_param, &pulls](){ ++pulls; return switch_param; });
+
+	std::vector<int> buffer;
+	fc::event_sink<int> sink(
+			&root.node(), [&buffer](auto in){buffer.push_back(in);});
+
+	source_1 >> test_switch.in(1);
+	source_7 >> test_switch.in(7);
+	config >> test_switch.control();
+	test_switch.out() >> sink;
+
+	auto latch = test_switch.latch_tick();
+	latch();
+	BOOST_CHECK_EQUAL(pulls, 1);
+
+	switch_param = 7; // not visible before the next tick
+	source_1.fire(1);
+	source_1.fire(2);
+	source_7.fire(7);
+	BOOST_CHECK((buffer == std::vector<int>{1, 2}));
+	BOOST_CHECK_EQUAL(pulls, 1);
+
+	latch();
+	buffer.clear();
+	source_1.fire(1);
+	source_7.fire(7);
+	BOOST_CHECK((buffer == std::vector<int>{7}));
+}
+
+BOOST_AUTO_TEST_CASE(test_n_ary_switch_state_latched_hashed)
+{
+	fc::tests::owning_node root{};
+	auto& test_switch = root.make_child_named<fc::n_ary_switch<
+			int, fc::state_tag, std::string, fc::tree_base_node, fc::hashed_keys>>("switch");
+	fc::state_source<int> left(&root.node(), [](){ return 1; });
+	std::string switch_param{"left"};
+	fc::state_source<std::string> config(
+			&root.node(), [&switch_param](){ return switch_param; });
+
+	left >> test_switch.in("left");
+	config >> test_switch.control();
+	auto latch = test_switch.latch_tick();
+
+	switch_param = "right";
+	latch();
+	BOOST_CHECK_THROW(test_switch.out()(), std::out_of_range);
+
+	// ports added after the tick are found for the latched key.
+	fc::state_source<int> right(&root.node(), [](){ return 2; });
+	right >> test_switch.in("right");
+	BOOST_CHECK_EQUAL(test_switch.out()(), 2);
+
+	switch_param = "left";
+	BOOST_CHECK_EQUAL(test_switch.out()(), 2);
+	latch();
+	BOOST_CHECK_EQUAL(test_switch.out()(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_n_ary_switch_control_event)
+{
+	fc::tests::owning_node root{};
+	fc::event_source<int> source_0(&root.node());
+	fc::event_source<int> source_1(&root.node());
+	fc::event_source<size_t> select(&root.node());
+	auto& test_switch = root.make_child_named<
+			fc::n_ary_switch<int, fc::event_tag>>("switch");
+
+	std::vector<int> buffer;
+	fc::event_sink<int> sink(
+			&root.node(), [&buffer](auto in){buffer.push_back(in);});
+
+	// the control state is never pulled, it is not connected at all.
+	source_0 >> test_switch.in(0);
+	source_1 >> test_switch.in(1);
+	select >> test_switch.control_event();
+	test_switch.out() >> sink;
+
+	select.fire(1);
+	source_0.fire(0);
+	source_1.fire(1);
+	select.fire(0);
+	source_0.fire(2);
+	source_1.fire(3);
+	BOOST_CHECK((buffer == std::vector<int>{1, 2}));
+}
+
+BOOST_AUTO_TEST_CASE(test_watch_bank)
+{
+	auto region = std::make_shared<fc::parallel_region>("region",
+			fc::thread::cycle_control::fast_tick);
+	fc::tests::owning_node root{region};
+	auto& bank = root.make_child_named<fc::watch_bank<double>>("bank");
+
+	std::vector<double> states{1.0, 5.0, 10.0};
+	std::vector<std::unique_ptr<fc::state_source<double>>> sources;
+	for (size_t i = 0; i != states.size(); ++i)
+	{
+		BOOST_CHECK_EQUAL(bank.add(4.0), i);
+		sources.push_back(std::make_unique<fc::state_source<double>>(
+				&root.node(), [&states, i](){ return states[i]; }));
+		*sources.back() >> bank.in(i);
+	}
+	bank.set_threshold(2, 20.0);
+
+	std::vector<std::pair<size_t, double>> fired;
+	fc::event_sink<std::pair<size_t, double>> sink(&root.node(),
+			[&fired](auto in){ fired.push_back(in); });
+	bank.out() >> sink;
+
+	region->ticks.in_work()();
+	BOOST_CHECK((fired == std::vector<std::pair<size_t, double>>{{1, 5.0}}));
+
+	fired.clear();
+	states[0] = 4.5;
+	states[2] = 21.0;
+	region->ticks.in_work()();
+	BOOST_CHECK((fired == std::vector<std::pair<size_t, double>>{{0, 4.5}, {1, 5.0}, {2, 21.0}}));
+}
+
 BOOST_AUTO_TEST_CASE(watch_node)
 {
 	fc::tests::owning_node root{};
@@ -2,8 +2,15 @@
 
 #include <flexcore/extended/nodes/state_nodes.hpp>
 
+#include <flexcore/scheduler/parallelscheduler.hpp>
+
 #include "owning_node.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <thread>
+
 BOOST_AUTO_TEST_SUITE( test_state_nodes )
 
 using fc::operator>>;
@@ -36,6 +43,86 @@ BOOST_AUTO_TEST_CASE(test_dynamic_merge)
 }
 
 
+BOOST_AUTO_TEST_CASE(test_dynamic_merge_reuses_buffer)
+{
+	fc::dynamic_merger<int, pure_node> merger{};
+	for (int i = 0; i != 200; ++i)
+		[i](){ return i; } >> merger.in();
+
+	const auto& merged = merger.out_ref()();
+	BOOST_CHECK_EQUAL(merged.size(), 200);
+	BOOST_CHECK_EQUAL(merged.back(), 199);
+	BOOST_CHECK_EQUAL(merger.out_ref()().data(), merged.data());
+
+	fc::thread::thread_config config{};
+	config.nr_of_threads = 2;
+	fc::thread::parallel_scheduler pool{config};
+	merger.pull_in_parallel(fc::actions::parallel_policy{&pool, 10, 10});
+	std::vector<int> expected(200);
+	std::iota(expected.begin(), expected.end(), 0);
+	BOOST_CHECK(merger.out()() == expected);
+	pool.stop();
+}
+
+BOOST_AUTO_TEST_CASE(test_merge_in_parallel)
+{
+	std::atomic<int> started{0};
+	// each input waits for the other, which only returns in time if they are pulled in parallel.
+	const auto slow = [&started](int value)
+	{
+		++started;
+		const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (started < 2 && std::chrono::steady_clock::now() < until)
+			std::this_thread::yield();
+		return started >= 2 ? value : 0;
+	};
+	auto add = fc::make_merge([](int a, int b){ return a + b; });
+	fc::pure::state_source<int> two([&slow](){ return slow(2); });
+	fc::pure::state_source<int> three([&slow](){ return slow(3); });
+	fc::mux(two, three) >> add.mux();
+
+	fc::thread::thread_config config{};
+	config.nr_of_threads = 2;
+	fc::thread::parallel_scheduler pool{config};
+	add.pull_in_parallel(&pool);
+	BOOST_CHECK_EQUAL(add(), 5);
+	pool.stop();
+}
+
+BOOST_AUTO_TEST_CASE(test_memoized_diamond)
+{
+	// source -> left, right -> top, each node is evaluated once per cycle.
+	int source_calls = 0;
+	fc::tick_cache<int, pure_node> source{};
+	[&source_calls](){ ++source_calls; return 2; } >> source.in();
+
+	auto left = fc::make_merge([](int a){ return a + 1; });
+	auto right = fc::make_merge([](int a){ return a * 3; });
+	auto top = fc::make_merge([](int a, int b){ return a * b; });
+	left.memoize_per_tick();
+	right.memoize_per_tick();
+	top.memoize_per_tick();
+	source.out() >> left.in<0>();
+	source.out() >> right.in<0>();
+	[&left](){ return left(); } >> top.in<0>();
+	[&right](){ return right(); } >> top.in<1>();
+
+	BOOST_CHECK_EQUAL(top(), 18);
+	BOOST_CHECK_EQUAL(top(), 18);
+	BOOST_CHECK_EQUAL(left(), 3);
+	BOOST_CHECK_EQUAL(source_calls, 1);
+
+	fc::master_clock<std::centi>::advance();
+	BOOST_CHECK_EQUAL(top(), 18);
+	BOOST_CHECK_EQUAL(source_calls, 2);
+
+	// without memoization every pull evaluates the inputs.
+	top.memoize_per_tick(false);
+	left.memoize_per_tick(false);
+	top();
+	BOOST_CHECK_EQUAL(source_calls, 2);
+}
+
 BOOST_AUTO_TEST_CASE(test_state_cache)
 {
 	fc::state_cache<int, pure_node> cache{};
@@ -52,6 +139,26 @@ BOOST_AUTO_TEST_CASE(test_state_cache)
 	BOOST_CHECK_EQUAL(cache.out()(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(test_versioned_state_cache)
+{
+	fc::versioned_state<int, pure_node> state{1};
+	fc::state_cache<int, pure_node> cache{};
+
+	int pulls = 0;
+	state.out() >> [&pulls](const int& i) -> const int& { ++pulls; return i; } >> cache.in();
+	state.version_out() >> cache.version();
+
+	BOOST_CHECK_EQUAL(cache.out()(), 1);
+	BOOST_CHECK_EQUAL(cache.out()(), 1);
+	BOOST_CHECK_EQUAL(cache.out_ref()(), 1);
+	BOOST_CHECK_EQUAL(pulls, 1); // version has not changed
+
+	state.in()(2);
+	BOOST_CHECK_EQUAL(cache.out()(), 2);
+	BOOST_CHECK_EQUAL(cache.out()(), 2);
+	BOOST_CHECK_EQUAL(pulls, 2);
+}
+
 BOOST_AUTO_TEST_CASE(test_current_state)
 {
 	fc::tests::owning_node root{};
@@ -87,4 +194,102 @@ BOOST_AUTO_TEST_CASE(test_current_state)
 	BOOST_CHECK_EQUAL(test_node.out()(), 2);
 }
 
+BOOST_AUTO_TEST_CASE(test_current_state_version)
+{
+	fc::tests::owning_node root{};
+	auto region = std::make_shared<fc::parallel_region>("MyRegion",
+			fc::thread::cycle_control::fast_tick);
+	auto& test_node = root.make_child<fc::current_state<int>>(region);
+
+	int test_val{1};
+	fc::state_version_t version{0};
+	int pulls = 0;
+	[&]() { ++pulls; return test_val; } >> test_node.in();
+	[&version]() { return version; } >> test_node.version();
+
+	region->ticks.work.fire();
+	region->ticks.work.fire();
+	BOOST_CHECK_EQUAL(test_node.out()(), 1);
+	BOOST_CHECK_EQUAL(pulls, 1);
+
+	test_val = 2;
+	++version;
+	region->ticks.work.fire();
+	BOOST_CHECK_EQUAL(test_node.out()(), 2);
+	BOOST_CHECK_EQUAL(pulls, 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_notified_state_cache)
+{
+	fc::versioned_state<int, pure_node> a{1};
+	fc::versioned_state<int, pure_node> b{2};
+	int merges = 0;
+	auto add = fc::make_merge([&merges](const int& x, const int& y){ ++merges; return x + y; });
+	fc::state_cache<int, pure_node> cache{};
+	a.out() >> add.in<0>();
+	b.out() >> add.in<1>();
+	add >> cache.in();
+
+	BOOST_CHECK_EQUAL(cache.out()(), 3);
+	BOOST_CHECK_EQUAL(cache.out()(), 3);
+	BOOST_CHECK_EQUAL(merges, 1);
+
+	// the change of a source is pushed through the merge to the cache.
+	b.in()(5);
+	b.in()(4);
+	BOOST_CHECK_EQUAL(cache.out()(), 5);
+	BOOST_CHECK_EQUAL(cache.out_ref()(), 5);
+	BOOST_CHECK_EQUAL(merges, 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_notified_current_state)
+{
+	fc::tests::owning_node root{};
+	auto region = root.region();
+	auto& config = root.make_child<fc::versioned_state<int, fc::tree_base_node>>(1);
+	int offset = 10;
+	int merges = 0;
+	auto op = [&merges](const int& x, int y){ ++merges; return x + y; };
+	auto& add = root.make_child_named<
+			fc::merge_node<decltype(op), int(const int&, int), fc::tree_base_node>>("add", op);
+	auto& current = root.make_child<fc::current_state<int>>(region);
+	config.out() >> add.in<0>();
+	fc::state_source<int> other{&root.node(), [](){ return 0; }};
+	other >> add.in<1>();
+	add >> current.in();
+
+	// with a source which does not notify, the state is pulled every tick.
+	region->ticks.work.fire();
+	region->ticks.work.fire();
+	BOOST_CHECK_EQUAL(merges, 2);
+	BOOST_CHECK_EQUAL(current.out()(), 1);
+
+	config.out() >> add.in<1>();
+	region->ticks.work.fire();
+	region->ticks.work.fire();
+	BOOST_CHECK_EQUAL(merges, 3);
+	BOOST_CHECK_EQUAL(current.out()(), 2);
+
+	config.in()(offset);
+	BOOST_CHECK_EQUAL(current.out()(), 2);
+	region->ticks.work.fire();
+	region->ticks.work.fire();
+	BOOST_CHECK_EQUAL(merges, 4);
+	BOOST_CHECK_EQUAL(current.out()(), 20);
+}
+
+BOOST_AUTO_TEST_CASE(test_notified_through_connectables)
+{
+	fc::versioned_state<int, pure_node> state{1};
+	fc::state_cache<int, pure_node> cache{};
+	int factor = 2;
+	// the lambda might change on its own, thus the cache does not rely on notifications.
+	state.out() >> [&factor](const int& i){ return i * factor; } >> cache.in();
+	BOOST_CHECK_EQUAL(cache.out()(), 2);
+	factor = 3;
+	BOOST_CHECK_EQUAL(cache.out()(), 2);
+	cache.update()();
+	BOOST_CHECK_EQUAL(cache.out()(), 3);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,74 @@
+#include <boost/test/unit_test.hpp>
+
+#include <flexcore/extended/nodes/window_aggregates.hpp>
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/pure/event_sources.hpp>
+#include <flexcore/pure/state_sink.hpp>
+#include <flexcore/pure/pure_node.hpp>
+
+#include "owning_node.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <numeric>
+
+using namespace fc;
+
+BOOST_AUTO_TEST_SUITE(test_window_aggregates)
+
+BOOST_AUTO_TEST_CASE(test_moving_sum)
+{
+	tests::owning_node root{};
+	auto& sum = root.make_child<moving_sum<int, tree_base_node>>(3);
+	event_source<int> source{&root.node()};
+	state_sink<int> sink{&root.node()};
+	source >> sum.in();
+	sum.out() >> sink;
+
+	BOOST_CHECK_EQUAL(sink.get(), 0);
+	source.fire(1);
+	source.fire(2);
+	BOOST_CHECK_EQUAL(sink.get(), 3);
+	source.fire(3);
+	source.fire(4);
+	// 1 has left the window
+	BOOST_CHECK_EQUAL(sink.get(), 9);
+}
+
+BOOST_AUTO_TEST_CASE(test_aggregates_equal_recomputation)
+{
+	constexpr size_t window_size = 5;
+	moving_mean<int, pure::pure_node> mean{window_size};
+	moving_variance<int, pure::pure_node> variance{window_size};
+	moving_min<int, pure::pure_node> min{window_size};
+	moving_max<int, pure::pure_node> max{window_size};
+
+	pure::event_source<int> source;
+	source >> mean.in();
+	source >> variance.in();
+	source >> min.in();
+	source >> max.in();
+
+	std::deque<int> window;
+	for (int i = 0; i != 50; ++i)
+	{
+		const int value = (i * 37) % 11 - 5;
+		source.fire(value);
+		window.push_back(value);
+		if (window.size() > window_size)
+			window.pop_front();
+
+		const double expected_mean =
+				std::accumulate(window.begin(), window.end(), 0.0) / window.size();
+		const double expected_variance = std::accumulate(window.begin(), window.end(), 0.0,
+				[expected_mean](double acc, int x)
+				{ return acc + (x - expected_mean) * (x - expected_mean); }) / window.size();
+
+		BOOST_CHECK_CLOSE(mean.out()() + 10.0, expected_mean + 10.0, 1e-9);
+		BOOST_CHECK_CLOSE(variance.out()() + 1.0, expected_variance + 1.0, 1e-9);
+		BOOST_CHECK_EQUAL(min.out()(), *std::min_element(window.begin(), window.end()));
+		BOOST_CHECK_EQUAL(max.out()(), *std::max_element(window.begin(), window.end()));
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,10 +2,21 @@
 
 #include <flexcore/pure/event_sinks.hpp>
 #include <flexcore/pure/event_sources.hpp>
+#include <flexcore/pure/parallel_event_source.hpp>
+#include <flexcore/pure/static_event_source.hpp>
 #include <flexcore/core/connection.hpp>
+#include <flexcore/core/connectables.hpp>
+#include <flexcore/scheduler/parallelscheduler.hpp>
 
 #include <tests/pure/sink_fixture.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(test_events)
 
 using namespace fc;
@@ -42,6 +53,93 @@ BOOST_AUTO_TEST_CASE( split_events )
 	test_sink_2.expect(2);
 }
 
+//sinks of a parallel_event_source run concurrently and are all done when fire returns
+BOOST_AUTO_TEST_CASE( parallel_events )
+{
+	thread::parallel_scheduler pool{thread::thread_config{2}};
+	pure::parallel_event_source<int> test_event{pool};
+	std::atomic<int> started{0};
+	std::atomic<int> received{0};
+	std::atomic<bool> overlapped{false};
+	const auto heavy = [&](int in)
+	{
+		++started;
+		// waits for the other sink, which only returns in time if they run in parallel.
+		const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (started < 2 && std::chrono::steady_clock::now() < until)
+			std::this_thread::yield();
+		if (started >= 2)
+			overlapped = true;
+		received += in;
+	};
+	pure::event_sink<int> test_sink_1{heavy};
+	pure::event_sink<int> test_sink_2{heavy};
+	test_event >> test_sink_1;
+	test_event >> test_sink_2;
+
+	test_event.fire(1);
+	BOOST_CHECK_EQUAL(received, 2);
+	BOOST_CHECK(overlapped);
+
+	std::vector<int> batch{1, 2};
+	test_event.fire_batch_move(batch);
+	BOOST_CHECK_EQUAL(received, 8);
+
+	// without pool it fires serially, like event_source.
+	test_event.set_pool(nullptr);
+	test_event.fire(1);
+	BOOST_CHECK_EQUAL(received, 10);
+
+	test_event.set_pool(&pool);
+	pure::event_sink<int> failing{[](int) { throw std::runtime_error("sink failed"); }};
+	test_event >> failing;
+	BOOST_CHECK_THROW(test_event.fire(1), std::runtime_error);
+}
+
+//all sinks of a shared_event_source receive the same payload
+BOOST_AUTO_TEST_CASE( shared_events )
+{
+	pure::shared_event_source<std::vector<int>> test_event{};
+	std::vector<const std::vector<int>*> received;
+	auto record = [&received](std::shared_ptr<const std::vector<int>> in)
+	{
+		received.push_back(in.get());
+	};
+	pure::event_sink<std::shared_ptr<const std::vector<int>>> test_sink_1{record};
+	pure::event_sink<std::shared_ptr<const std::vector<int>>> test_sink_2{record};
+
+	test_event >> test_sink_1;
+	test_event >> [](std::shared_ptr<const std::vector<int>> in) { return in->size(); }
+			>> [](size_t size) { BOOST_CHECK_EQUAL(size, 3); };
+	test_event >> test_sink_2;
+
+	test_event.fire(std::vector<int>{1, 2, 3});
+	BOOST_REQUIRE_EQUAL(received.size(), 2);
+	BOOST_CHECK(received[0] != nullptr);
+	BOOST_CHECK_EQUAL(received[0], received[1]);
+}
+
+//handlers of a static_event_source are fixed at construction and called in order
+BOOST_AUTO_TEST_CASE( static_events )
+{
+	std::vector<int> received;
+	pure::event_sink<int> sink{[&received](int i){ received.push_back(i); }};
+	auto source = pure::make_static_event_source<int>(
+			[&received](int i){ received.push_back(i * 10); },
+			std::ref(sink),
+			fc::identity{} >> [&received](int i){ received.push_back(-i); });
+	static_assert(decltype(source)::nr_connected_handlers() == 3, "");
+
+	source.fire(1);
+	source.fire(2);
+	BOOST_CHECK((received == std::vector<int>{10, 1, -1, 20, 2, -2}));
+
+	int count = 0;
+	auto void_source = pure::make_static_event_source<void>([&count](){ ++count; });
+	void_source.fire();
+	BOOST_CHECK_EQUAL(count, 1);
+}
+
 //events can be sent between event_sources and event_sink
 BOOST_AUTO_TEST_CASE( in_port )
 {
@@ -219,6 +317,33 @@ BOOST_AUTO_TEST_CASE(test_sink_deleted_callback)
 	}
 }
 
+BOOST_AUTO_TEST_CASE(test_disconnect_in_any_order)
+{
+	pure::event_source<int> test_source{};
+	std::vector<std::unique_ptr<disconnecting_event_sink<int>>> sinks;
+	for (int i = 0; i != 100; ++i)
+	{
+		sinks.push_back(std::make_unique<disconnecting_event_sink<int>>());
+		test_source >> *sinks.back();
+	}
+	// a sink connected twice is disconnected twice.
+	test_source >> *sinks.front();
+	BOOST_CHECK_EQUAL(test_source.nr_connected_handlers(), 101);
+
+	// remove every other sink, starting at the front, so handlers are moved around.
+	for (size_t i = 0; i < sinks.size(); i += 2)
+		sinks[i].reset();
+	BOOST_CHECK_EQUAL(test_source.nr_connected_handlers(), 50);
+
+	test_source.fire(1);
+	for (size_t i = 1; i < sinks.size(); i += 2)
+		BOOST_CHECK_EQUAL(*(sinks[i]->storage), 1);
+
+	sinks.clear();
+	BOOST_CHECK_EQUAL(test_source.nr_connected_handlers(), 0);
+	test_source.fire(2);
+}
+
 BOOST_AUTO_TEST_CASE(test_delete_with_lambda_in_connection)
 {
 	disconnecting_event_sink<int> test_sink{};
@@ -342,4 +467,100 @@ BOOST_AUTO_TEST_CASE( type_changing_lambda_with_void )
 	BOOST_CHECK(called_2);
 }
 
+BOOST_AUTO_TEST_CASE( batch_events )
+{
+	pure::event_source<int> src{};
+	std::vector<int> singles;
+	std::vector<size_t> batch_sizes;
+	std::vector<int> batched;
+	pure::event_sink<int> batch_sink{
+		[&](int i) { singles.push_back(i); },
+		[&](span<const int> events)
+		{
+			batch_sizes.push_back(events.size());
+			batched.insert(batched.end(), events.begin(), events.end());
+		}};
+	pure::event_sink<int> plain_sink{[&](int i) { singles.push_back(i); }};
+	std::vector<int> connected;
+	src >> batch_sink;
+	src >> plain_sink;
+	src >> [&](int i) { return i * 2; } >> [&](int i) { connected.push_back(i); };
+
+	const std::vector<int> events{1, 2, 3};
+	src.fire_batch(events);
+	// only the sink with a batch action receives the events at once.
+	BOOST_CHECK(batch_sizes == std::vector<size_t>{3});
+	BOOST_CHECK(batched == events);
+	BOOST_CHECK(singles == events);
+	BOOST_CHECK((connected == std::vector<int>{2, 4, 6}));
+
+	src.fire_batch(span<const int>{});
+	BOOST_CHECK((batch_sizes == std::vector<size_t>{3, 0}));
+}
+
+BOOST_AUTO_TEST_CASE( counted_void_events )
+{
+	pure::event_source<void> src{};
+	int singles = 0;
+	std::vector<size_t> counts;
+	pure::event_sink<void> count_sink{[&]() { ++singles; }, [&](size_t n) { counts.push_back(n); }};
+	int plain = 0;
+	pure::event_sink<void> plain_sink{[&]() { ++plain; }};
+	int connected = 0;
+	src >> count_sink;
+	src >> plain_sink;
+	src >> [&]() { ++connected; };
+
+	src.fire_count(3);
+	// only the sink with a count action receives the events in one call.
+	BOOST_CHECK(counts == std::vector<size_t>{3});
+	BOOST_CHECK_EQUAL(singles, 0);
+	BOOST_CHECK_EQUAL(plain, 3);
+	BOOST_CHECK_EQUAL(connected, 3);
+
+	src.fire_count(0);
+	src.fire();
+	BOOST_CHECK(counts == std::vector<size_t>{3});
+	BOOST_CHECK_EQUAL(singles, 1);
+}
+
+BOOST_AUTO_TEST_CASE( batch_events_moved_to_last_connection )
+{
+	pure::event_source<std::shared_ptr<int>> src{};
+	std::vector<std::shared_ptr<int>> received;
+	src >> [&](std::shared_ptr<int> p) { received.push_back(std::move(p)); };
+	std::vector<std::shared_ptr<int>> events{std::make_shared<int>(1), std::make_shared<int>(2)};
+	src.fire_batch_move(events);
+	BOOST_CHECK_EQUAL(received.size(), 2);
+	BOOST_CHECK_EQUAL(received.front().use_count(), 1);
+	BOOST_CHECK(!events.front());
+}
+
+// connections are removed from either side, also after the active port has been moved.
+BOOST_AUTO_TEST_CASE( connection_breakers_follow_moved_source )
+{
+	int sum = 0;
+	auto sink = std::make_unique<pure::event_sink<int>>([&sum](int i){ sum += i; });
+	pure::event_sink<int> other{[&sum](int i){ sum += 10 * i; }};
+
+	pure::event_source<int> source;
+	source >> *sink;
+	source >> *sink;
+	source >> other;
+	pure::event_source<int> moved{std::move(source)};
+	moved.fire(1);
+	BOOST_CHECK_EQUAL(sum, 12);
+
+	sink.reset();
+	BOOST_CHECK_EQUAL(moved.nr_connected_handlers(), 1);
+	moved.fire(1);
+	BOOST_CHECK_EQUAL(sum, 22);
+
+	{
+		pure::event_source<int> short_lived;
+		short_lived >> other;
+	}
+	// other must not try to disconnect from the destroyed source.
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -98,4 +98,41 @@ BOOST_AUTO_TEST_CASE( non_moving )
 	BOOST_CHECK(!moved);
 }
 
+namespace
+{
+/// token counting how often it has been copied.
+struct copy_counter
+{
+	explicit copy_counter(int& copy_count) : copies(&copy_count) {}
+	copy_counter(const copy_counter& other) : copies(other.copies) { ++*copies; }
+	copy_counter(copy_counter&&) = default;
+	copy_counter& operator=(const copy_counter&) = delete;
+	copy_counter& operator=(copy_counter&&) = default;
+
+	int* copies;
+};
+}
+
+BOOST_AUTO_TEST_CASE( last_handler_receives_rvalue )
+{
+	int copies = 0;
+	pure::event_source<copy_counter> source{};
+	pure::event_sink<copy_counter> sink([](copy_counter){});
+	pure::event_sink<copy_counter> sink2([](copy_counter){});
+
+	source >> sink;
+	source.fire(copy_counter{copies});
+	BOOST_CHECK_EQUAL(copies, 0);
+
+	source >> sink2;
+	source.fire(copy_counter{copies});
+	BOOST_CHECK_EQUAL(copies, 1);
+
+	// lvalues are still copied for every handler.
+	copies = 0;
+	copy_counter token{copies};
+	source.fire(token);
+	BOOST_CHECK_EQUAL(copies, 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
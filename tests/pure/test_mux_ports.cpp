@@ -3,6 +3,8 @@
 #include <flexcore/pure/mux_ports.hpp>
 #include <flexcore/core/connection.hpp>
 
+#include <vector>
+
 using namespace fc;
 
 BOOST_AUTO_TEST_SUITE(mux_ports)
@@ -73,4 +75,51 @@ BOOST_AUTO_TEST_CASE(event_src_to_mux_sink)
 	           sink_b);
 	src.fire(fire_val);
 }
+
+BOOST_FIXTURE_TEST_CASE(mux_array_merge_sink, mux_fixture)
+{
+	pure::state_sink<int> sink;
+	std::move(muxed_sources)
+	    >> [](int x) { return x * 10; }
+	    >> array_merge<int>(reductions::sum{})
+	    >> sink;
+	BOOST_CHECK_EQUAL(sink.get(), 60);
+}
+
+BOOST_AUTO_TEST_CASE(merge_range_reductions)
+{
+	std::vector<pure::state_source<int>> sources;
+	for (int i = 0; i != 100; ++i)
+		sources.emplace_back([i] { return (i * 37) % 101; });
+
+	pure::state_sink<int> sum, min, max;
+	merge_range<int>(sources, reductions::sum{}) >> sum;
+	merge_range<int>(sources, reductions::min{}) >> min;
+	merge_range<int>(sources, reductions::max{}) >> max;
+	int expected = 0;
+	for (int i = 0; i != 100; ++i)
+		expected += (i * 37) % 101;
+	BOOST_CHECK_EQUAL(sum.get(), expected);
+	BOOST_CHECK_EQUAL(min.get(), 0);
+	BOOST_CHECK_EQUAL(max.get(), 100);
+}
+
+BOOST_AUTO_TEST_CASE(merge_range_any_stops)
+{
+	int pulled = 0;
+	bool value = false;
+	std::vector<pure::state_source<bool>> sources;
+	for (int i = 0; i != 64; ++i)
+		sources.emplace_back([&pulled, &value, i] { ++pulled; return value && i == 10; });
+
+	auto any_true = merge_range<bool>(sources, reductions::any{});
+	BOOST_CHECK_EQUAL(any_true.size(), 64);
+	BOOST_CHECK(!any_true());
+	BOOST_CHECK_EQUAL(pulled, 64);
+
+	pulled = 0;
+	value = true;
+	BOOST_CHECK(any_true());
+	BOOST_CHECK_EQUAL(pulled, 11);
+}
 BOOST_AUTO_TEST_SUITE_END()
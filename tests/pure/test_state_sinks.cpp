@@ -2,7 +2,13 @@
 
 #include <flexcore/pure/state_sink.hpp>
 #include <flexcore/pure/state_sources.hpp>
+#include <flexcore/pure/static_state_sink.hpp>
 #include <flexcore/core/connection.hpp>
+#include <flexcore/core/connectables.hpp>
+#include <flexcore/scheduler/parallelscheduler.hpp>
+
+#include <stdexcept>
+#include <vector>
 
 using namespace fc;
 
@@ -150,4 +156,65 @@ BOOST_AUTO_TEST_CASE(state_source_connect_after_move)
 	BOOST_CHECK_THROW(sink.get(), std::bad_function_call);
 }
 
+BOOST_AUTO_TEST_CASE(borrowed_states)
+{
+	const std::vector<int> state{1, 2, 3};
+	pure::state_source<const std::vector<int>&> src{
+			[&state]() -> const std::vector<int>& { return state; }};
+	pure::state_sink<const std::vector<int>&> sink{};
+	pure::state_sink<const int&> element_sink{};
+
+	src >> sink;
+	src >> [](const std::vector<int>& v) -> const int& { return v.back(); } >> element_sink;
+
+	// neither the state nor the part of it selected by the connection are copied.
+	BOOST_CHECK_EQUAL(&sink.get(), &state);
+	BOOST_CHECK_EQUAL(&element_sink.get(), &state.back());
+}
+
+//the connection of a static_state_sink is fixed at construction and keeps its type
+BOOST_AUTO_TEST_CASE(static_state_sink)
+{
+	int x = 1;
+	auto chain = [&x]() { return x; } >> [](int i) { return i * 2; } >> fc::identity{};
+	auto sink = pure::make_static_state_sink(chain);
+	static_assert(std::is_same<decltype(sink),
+			pure::static_state_sink<int, decltype(chain)>>{}, "");
+	BOOST_CHECK_EQUAL(sink.get(), 2);
+	x = 3;
+	BOOST_CHECK_EQUAL(sink.get(), 6);
+
+	pure::state_source<const std::vector<int>&> src{
+			[]() -> const std::vector<int>& { static const std::vector<int> v{4, 5}; return v; }};
+	auto borrowing = pure::make_static_state_sink<const std::vector<int>&>(std::ref(src));
+	BOOST_CHECK_EQUAL(&borrowing.get(), &src());
+}
+
+BOOST_AUTO_TEST_CASE( test_async_get )
+{
+	thread::parallel_scheduler pool{thread::thread_config{1}};
+	pure::state_sink<int> sink{};
+	BOOST_CHECK_THROW(sink.async_get(pool), fc::not_connected);
+
+	int pulls = 0;
+	pure::state_source<int> source{[&pulls]() { return ++pulls; }};
+	source >> sink;
+	auto future = sink.async_get(pool);
+	BOOST_CHECK(future.valid());
+	BOOST_CHECK_EQUAL(future.get(), 1);
+	BOOST_CHECK(!future.valid());
+
+	// pulls not yet started by the pool are done by the calling thread.
+	pool.stop();
+	auto unstarted = sink.async_get(pool);
+	BOOST_CHECK(!unstarted.is_ready());
+	BOOST_CHECK_EQUAL(unstarted.get(), 2);
+
+	pure::state_sink<int> failing_sink{};
+	pure::state_source<int> failing{[]() -> int { throw std::runtime_error("pull failed"); }};
+	failing >> failing_sink;
+	auto failed = failing_sink.async_get(pool);
+	BOOST_CHECK_THROW(failed.get(), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
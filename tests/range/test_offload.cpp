@@ -0,0 +1,94 @@
+#include <boost/test/unit_test.hpp>
+
+#include <flexcore/core/connection.hpp>
+#include <flexcore/pure/pure_ports.hpp>
+#include <flexcore/range/offload.hpp>
+#include <flexcore/scheduler/parallelscheduler.hpp>
+
+#include <memory>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+using namespace fc;
+
+namespace
+{
+struct offload_fixture
+{
+	offload_fixture()
+	{
+		std::iota(input.begin(), input.end(), 0);
+	}
+	~offload_fixture() { pool.stop(); }
+
+	thread::parallel_scheduler pool{};
+	std::shared_ptr<const offload::host_backend> backend =
+			std::make_shared<offload::host_backend>(
+					offload::host_backend{actions::parallel_policy{&pool, 1000, 100}});
+	std::vector<int> input = std::vector<int>(10000);
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(test_offload, offload_fixture)
+
+BOOST_AUTO_TEST_CASE(test_chain)
+{
+	const auto weights = offload::to_device(backend)(std::vector<int>(input.size(), 3));
+	auto chain = offload::to_device(backend)
+			>> offload::map([](int x) { return x + 1; })
+			>> offload::zip([](int x, int w) { return x * w; }, weights)
+			>> offload::to_host();
+
+	const auto result = chain(input);
+	BOOST_REQUIRE_EQUAL(result.size(), input.size());
+	for (size_t i = 0; i != input.size(); ++i)
+		BOOST_CHECK_EQUAL(result[i], (input[i] + 1) * 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_stages_are_fused)
+{
+	auto stages = offload::map([](int x) { return x + 1; })
+			>> offload::map([](int x) { return x * 2; })
+			>> offload::map([](int x) { return x - 3; });
+	static_assert(offload::detail::is_elementwise<decltype(stages)>{},
+			"consecutive element-wise stages are fused into one.");
+
+	auto chain = offload::to_device(backend) >> offload::map([](int x) { return x + 1; })
+			>> offload::map([](int x) { return x * 2; });
+	static_assert(offload::detail::ends_in_elementwise<decltype(chain)>{},
+			"stages following a chain are fused into its last stage.");
+
+	const auto device = offload::to_device(backend)(input);
+	const auto result = stages(device);
+	for (size_t i = 0; i != input.size(); ++i)
+		BOOST_CHECK_EQUAL(result.data()[i], (input[i] + 1) * 2 - 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_shared_vectors)
+{
+	const auto device = offload::to_device(backend)(input);
+	auto copy = device;
+	BOOST_CHECK(copy.shares(device));
+	// stages write to a clone if their input is shared.
+	const auto doubled = offload::map([](int x) { return x * 2; })(copy);
+	BOOST_CHECK(!doubled.shares(device));
+	BOOST_CHECK_EQUAL(device.data()[10], 10);
+	BOOST_CHECK_EQUAL(doubled.data()[10], 20);
+	BOOST_CHECK_EQUAL(device.size(), input.size());
+}
+
+BOOST_AUTO_TEST_CASE(test_ports)
+{
+	long result = 0;
+	pure::event_source<std::vector<int>> source;
+	pure::event_sink<long> sink{[&result](long r) { result = r; }};
+	// device vectors pass between stages as handles, without copies to the host.
+	source >> offload::to_device(backend) >> offload::map([](int x) { return x * 2; })
+			>> [](offload::device_vector<int> v) { return v; }
+			>> offload::reduce([](long a, long b) { return a + b; }, 0L) >> sink;
+	source.fire(input);
+	BOOST_CHECK_EQUAL(result, std::accumulate(input.begin(), input.end(), 0L) * 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,131 @@
+#include <boost/test/unit_test.hpp>
+
+#include <flexcore/core/connection.hpp>
+#include <flexcore/range/parallel_actions.hpp>
+#include <flexcore/scheduler/parallelscheduler.hpp>
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+using namespace fc;
+
+namespace
+{
+thread::thread_config four_threads()
+{
+	thread::thread_config config{};
+	config.nr_of_threads = 4;
+	return config;
+}
+
+struct scheduler_fixture
+{
+	scheduler_fixture()
+	{
+		std::iota(vec.begin(), vec.end(), 0);
+	}
+	~scheduler_fixture() { pool.stop(); }
+
+	thread::parallel_scheduler pool{four_threads()};
+	actions::parallel_policy policy{&pool, 1000, 100};
+	std::vector<int> vec = std::vector<int>(10000);
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(test_parallel_actions, scheduler_fixture)
+
+BOOST_AUTO_TEST_CASE(test_nr_of_chunks)
+{
+	BOOST_CHECK_EQUAL(policy.nr_of_chunks(0), 0);
+	BOOST_CHECK_EQUAL(policy.nr_of_chunks(999), 1);
+	BOOST_CHECK_EQUAL(policy.nr_of_chunks(1000), 10);
+	BOOST_CHECK_EQUAL(policy.nr_of_chunks(10000), 16);
+	BOOST_CHECK_EQUAL(actions::parallel_policy{}.nr_of_chunks(10000000), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_parallel_equals_serial)
+{
+	const auto twice = [](int i){ return i*2;};
+	const auto is_odd = [](int i){ return i % 3 == 1;};
+
+	BOOST_CHECK(actions::parallel_map(twice, policy)(vec) == actions::map(twice)(vec));
+	BOOST_CHECK(actions::parallel_zip(std::plus<>(), vec, policy)(vec)
+			== actions::zip(std::plus<>(), vec)(vec));
+	BOOST_CHECK(actions::parallel_filter(is_odd, policy)(vec)
+			== actions::filter(is_odd)(vec));
+	BOOST_CHECK_EQUAL(parallel_sum(policy, 10)(vec), sum(10)(vec));
+
+	auto chain = actions::parallel_filter(is_odd, policy)
+			>> actions::parallel_map(twice, policy)
+			>> parallel_sum(policy, 0);
+	auto serial_chain = actions::filter(is_odd) >> actions::map(twice) >> sum(0);
+	BOOST_CHECK_EQUAL(chain(vec), serial_chain(vec));
+}
+
+BOOST_AUTO_TEST_CASE(test_small_chunks_are_not_empty)
+{
+	// 16 wanted chunks of 2 elements would cover 32 elements.
+	const actions::parallel_policy small_chunks{&pool, 2, 1};
+	BOOST_CHECK_EQUAL(small_chunks.chunk_size(20), 2);
+	BOOST_CHECK_EQUAL(small_chunks.nr_of_chunks(20), 10);
+
+	for (size_t size = 2; size != 100; ++size)
+	{
+		std::vector<int> small(size);
+		std::iota(small.begin(), small.end(), 0);
+		std::atomic<size_t> covered{0};
+		std::atomic<bool> empty{false};
+		const auto chunks = actions::detail::for_each_chunk(small_chunks, size,
+				[&](size_t, size_t b, size_t e)
+				{
+					if (b >= e || e > size)
+						empty = true;
+					else
+						covered += e - b;
+				});
+		BOOST_CHECK_EQUAL(chunks, small_chunks.nr_of_chunks(size));
+		BOOST_CHECK(!empty);
+		BOOST_CHECK_EQUAL(covered.load(), size);
+
+		const auto is_odd = [](int i){ return i % 2 == 1;};
+		BOOST_CHECK_EQUAL(parallel_sum(small_chunks, 10)(small), sum(10)(small));
+		BOOST_CHECK(actions::parallel_filter(is_odd, small_chunks)(small)
+				== actions::filter(is_odd)(small));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_small_ranges_are_serial)
+{
+	std::vector<int> small {1, 2, 3};
+	const auto caller = std::this_thread::get_id();
+	auto on_caller = actions::parallel_map([caller](int i)
+			{ return std::this_thread::get_id() == caller ? i : -1; }, policy);
+	BOOST_CHECK(on_caller(small) == small);
+	BOOST_CHECK_EQUAL(parallel_sum(policy, 0)(std::vector<int>{}), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_exceptions_are_rethrown)
+{
+	auto throwing = actions::parallel_map([](int i)
+			{ if (i == 5000) throw std::runtime_error("test"); return i; }, policy);
+	BOOST_CHECK_THROW(throwing(vec), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_from_task_of_same_scheduler)
+{
+	// all workers are busy with tasks, which use the scheduler themselves.
+	std::atomic<int> correct{0};
+	for (int i = 0; i != 8; ++i)
+		pool.add_task([this, &correct]
+		{
+			if (parallel_sum(policy, 0)(vec) == sum(0)(vec))
+				++correct;
+		});
+	while (correct.load() != 8)
+		std::this_thread::yield();
+	BOOST_CHECK_EQUAL(correct.load(), 8);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
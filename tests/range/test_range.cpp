@@ -3,6 +3,8 @@
 #include <flexcore/core/connection.hpp>
 #include <flexcore/range/actions.hpp>
 
+#include <numeric>
+
 using namespace fc;
 
 BOOST_AUTO_TEST_SUITE(test_range)
@@ -39,5 +41,61 @@ BOOST_AUTO_TEST_CASE(test_zip)
 	BOOST_CHECK(result == squared_vec);
 }
 
+BOOST_AUTO_TEST_CASE(test_actions_into_buffer)
+{
+	std::vector<int> vec {-4, -3, -2, -1, 0, 1, 2, 3, 4};
+
+	auto chain = actions::filter_into([](int i){ return i < 0;}, std::vector<int>{})
+			>> actions::map_into([](int i){ return i*2.0f;}, std::vector<float>{});
+	const std::vector<float> expected {-8, -6, -4, -2};
+	BOOST_CHECK(chain(vec) == expected);
+
+	// buffers keep their memory between calls.
+	const auto data = chain(vec).data();
+	vec.resize(6);
+	BOOST_CHECK(chain(vec) == expected);
+	BOOST_CHECK_EQUAL(chain(vec).data(), data);
+	BOOST_CHECK_EQUAL(chain.source.target.size(), 4);
+
+	// rvalues are modified in place.
+	std::vector<int> moved {1, 2, 3};
+	const auto moved_data = moved.data();
+	auto result = actions::map([](int i){ return i+1;})(std::move(moved));
+	BOOST_CHECK_EQUAL(result.data(), moved_data);
+}
+
+BOOST_AUTO_TEST_CASE(test_fused_map)
+{
+	std::vector<int> vec {0, 1, 2, 3, 4};
+	auto twice = actions::map([](int i){ return i*2;});
+
+	auto fused = twice >> actions::map([](int i){ return i+1;});
+	static_assert(actions::detail::is_inplace_map<decltype(fused)>{},
+			"map >> map is fused into a single map.");
+	BOOST_CHECK(fused(vec) == (std::vector<int>{1, 3, 5, 7, 9}));
+
+	// maps at the end of a chain are fused as well.
+	auto chain = actions::filter([](int i){ return i > 1;})
+			>> actions::map([](int i){ return i*2;})
+			>> actions::map([](int i){ return i+1;})
+			>> sum(0);
+	BOOST_CHECK_EQUAL(chain(vec), 5 + 7 + 9);
+}
+
+BOOST_AUTO_TEST_CASE(test_lanewise_reduce)
+{
+	for (size_t size : {0, 1, 7, 8, 9, 16, 100})
+	{
+		std::vector<int> vec(size);
+		std::iota(vec.begin(), vec.end(), 1);
+		const auto expected =
+				std::accumulate(vec.begin(), vec.end(), 10);
+		BOOST_CHECK_EQUAL(lanewise_sum(10)(vec), expected);
+		BOOST_CHECK_EQUAL(lanewise_reduce(std::plus<>(), 10)(vec), expected);
+	}
+
+	std::vector<float> floats(1000, 0.5f);
+	BOOST_CHECK_CLOSE(lanewise_sum(0.0f)(floats), 500.0f, 0.001);
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+#include <boost/test/unit_test.hpp>
+
+#include <flexcore/core/connection.hpp>
+#include <flexcore/extended/nodes/buffer.hpp>
+#include <flexcore/pure/event_sources.hpp>
+#include <flexcore/pure/event_sinks.hpp>
+#include <flexcore/pure/pure_node.hpp>
+#include <flexcore/pure/state_sink.hpp>
+#include <flexcore/range/soa_vector.hpp>
+
+using namespace fc;
+
+namespace
+{
+// x, y, intensity
+using points = soa_vector<float, float, int>;
+
+points make_points()
+{
+	points p;
+	p.push_back(std::make_tuple(1.0f, 2.0f, 10));
+	p.push_back(std::make_tuple(3.0f, 4.0f, 20));
+	p.push_back(std::make_tuple(5.0f, 6.0f, 30));
+	return p;
+}
+}
+
+BOOST_AUTO_TEST_SUITE(test_soa_vector)
+
+BOOST_AUTO_TEST_CASE(test_columns)
+{
+	auto p = make_points();
+	BOOST_CHECK_EQUAL(p.size(), 3);
+	BOOST_CHECK((p.column<2>() == std::vector<int>{10, 20, 30}));
+	BOOST_CHECK(p[1] == std::make_tuple(3.0f, 4.0f, 20));
+
+	const std::vector<std::tuple<float, float, int>> rows(p.begin(), p.end());
+	BOOST_CHECK(points{rows} == p);
+
+	p.clear();
+	BOOST_CHECK(p.empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_column_actions)
+{
+	auto chain = actions::filter_column<2>([](int i){ return i > 10; })
+			>> actions::map_column<0>([](float x){ return x * 2; })
+			>> actions::zip_columns<0, 1, 1>(std::plus<>());
+
+	const auto result = chain(make_points());
+	BOOST_CHECK(result.column<0>() == (std::vector<float>{6.0f, 10.0f}));
+	BOOST_CHECK(result.column<1>() == (std::vector<float>{10.0f, 16.0f}));
+	BOOST_CHECK(result.column<2>() == (std::vector<int>{20, 30}));
+}
+
+BOOST_AUTO_TEST_CASE(test_soa_through_ports)
+{
+	pure::event_source<points> source;
+	points received;
+	pure::event_sink<points> sink{[&received](points p){ received = std::move(p); }};
+	source >> sink;
+
+	auto p = make_points();
+	const auto data = p.column<0>().data();
+	source.fire(std::move(p));
+	BOOST_CHECK(received == make_points());
+	// a single connection moves the columns.
+	BOOST_CHECK_EQUAL(received.column<0>().data(), data);
+}
+
+BOOST_AUTO_TEST_CASE(test_soa_into_collector)
+{
+	using collector_t = list_collector<points::value_type, swap_on_pull, pure::pure_node>;
+	collector_t collector{};
+	pure::state_sink<std::vector<points::value_type>> sink{};
+	collector.out() >> sink;
+
+	collector.in()(make_points());
+	collector.in()(std::make_tuple(7.0f, 8.0f, 40));
+
+	const points collected{sink.get()};
+	BOOST_CHECK_EQUAL(collected.size(), 4);
+	BOOST_CHECK((collected.column<2>() == std::vector<int>{10, 20, 30, 40}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,60 @@
+#include <boost/test/unit_test.hpp>
+
+#include <flexcore/core/connection.hpp>
+#include <flexcore/range/views.hpp>
+
+using namespace fc;
+
+BOOST_AUTO_TEST_SUITE(test_views)
+
+BOOST_AUTO_TEST_CASE(test_pipeline_equals_actions)
+{
+	std::vector<int> vec {-4, -3, -2, -1, 0, 1, 2, 3, 4};
+	const auto is_negative = [](int i){ return i < 0;};
+	const auto twice = [](int i){ return i*2;};
+
+	auto eager = actions::filter(is_negative) >> actions::map(twice);
+	auto lazy = views::filter(is_negative) >> views::map(twice);
+	static_assert(views::detail::is_pipeline<decltype(lazy)>{},
+			"views connected with >> are a single pipeline");
+
+	BOOST_CHECK(lazy(vec) == eager(vec));
+	BOOST_CHECK((views::filter(is_negative) >> views::map(twice) >> sum(0))(vec) == -20);
+}
+
+BOOST_AUTO_TEST_CASE(test_pipeline_changes_type)
+{
+	std::vector<int> vec {0, 1, 2};
+	auto to_float = views::map([](int i){ return i + 0.5f;});
+
+	std::vector<float> expected {0.5f, 1.5f, 2.5f};
+	BOOST_CHECK(to_float(vec) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(test_pipeline_zip)
+{
+	std::vector<int> vec {0, 1, 2, 3, 4};
+	auto source = [vec](){ return vec; };
+
+	// zip pairs with the elements that passed the filter, like actions::zip.
+	auto connection = source
+			>> views::filter([](int i){ return i % 2 == 0;})
+			>> views::zip([](auto a, auto b){return a*b;}, std::vector<int>{1, 2, 3});
+
+	std::vector<int> expected {0, 4, 12};
+	BOOST_CHECK(connection() == expected);
+	// zip starts at the beginning of its range for every call.
+	BOOST_CHECK(connection() == expected);
+}
+
+BOOST_AUTO_TEST_CASE(test_pipeline_reduce)
+{
+	std::vector<int> vec {1, 2, 3, 4};
+	auto squares = views::map([](int i){ return i*i;});
+
+	BOOST_CHECK_EQUAL((squares >> sum(0))(vec), 30);
+	BOOST_CHECK_EQUAL((squares >> lanewise_sum(0))(vec), 30);
+	BOOST_CHECK_EQUAL((squares >> reduce(std::multiplies<>(), 1))(vec), 576);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
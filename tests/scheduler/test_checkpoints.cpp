@@ -0,0 +1,211 @@
+#include <flexcore/scheduler/checkpoints.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+#include <flexcore/scheduler/cyclecontrol.hpp>
+#include <flexcore/extended/nodes/buffer.hpp>
+#include <flexcore/extended/nodes/state_nodes.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../nodes/owning_node.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace fc;
+
+BOOST_AUTO_TEST_SUITE(test_checkpoints)
+
+namespace
+{
+/// path of a checkpoint file, which is removed with the fixture.
+struct temp_file
+{
+	temp_file()
+	{
+		char pattern[] = "/tmp/flexcore_checkpoints_XXXXXX";
+		const int file = mkstemp(pattern);
+		BOOST_REQUIRE(file >= 0);
+		::close(file);
+		path = pattern;
+	}
+	~temp_file() { std::remove(path.c_str()); }
+
+	std::string path;
+};
+
+std::string as_string(const_byte_span bytes) { return std::string{bytes.begin(), bytes.end()}; }
+const_byte_span as_bytes(const std::string& s) { return const_byte_span{s.data(), s.size()}; }
+
+void switch_tick(parallel_region& region) { region.ticks.switch_buffers(); }
+void work_tick(parallel_region& region) { region.ticks.in_work()(); }
+}
+
+BOOST_AUTO_TEST_CASE(file_keeps_entries)
+{
+	temp_file tmp;
+	{
+		checkpoint_file file{tmp.path, 10000};
+		// capacity is rounded up to whole pages.
+		BOOST_CHECK(file.capacity() >= 10000);
+		BOOST_CHECK_EQUAL(file.find("a"), checkpoint_file::npos);
+		const auto a = file.entry("a", 8);
+		BOOST_CHECK_EQUAL(file.entry("a", 8), a);
+		BOOST_CHECK(file.read(a).empty());
+		BOOST_CHECK_EQUAL(file.write(a, as_bytes("first")), a);
+		BOOST_CHECK_EQUAL(file.write(a, as_bytes("second")), a);
+		BOOST_CHECK_EQUAL(as_string(file.read(a)), "second");
+		file.write(file.entry("b", 1), as_bytes("b"));
+	}
+
+	checkpoint_file reopened{tmp.path};
+	BOOST_CHECK_EQUAL(as_string(reopened.read(reopened.find("a"))), "second");
+	BOOST_CHECK_EQUAL(as_string(reopened.read(reopened.find("b"))), "b");
+	BOOST_CHECK_EQUAL(reopened.find("c"), checkpoint_file::npos);
+}
+
+BOOST_AUTO_TEST_CASE(file_moves_growing_entries)
+{
+	temp_file tmp;
+	const std::string large(100, 'x');
+	{
+		checkpoint_file file{tmp.path};
+		const auto a = file.entry("a", 4);
+		file.write(a, as_bytes("abcd"));
+		const auto used = file.used();
+		const auto moved = file.write(a, as_bytes(large));
+		BOOST_CHECK(moved != a);
+		BOOST_CHECK(file.used() > used);
+		BOOST_CHECK_EQUAL(file.find("a"), moved);
+		BOOST_CHECK_EQUAL(as_string(file.read(moved)), large);
+		// the moved entry has room to grow, further writes stay in place.
+		BOOST_CHECK_EQUAL(file.write(moved, as_bytes(large + large)), moved);
+
+		std::string full(file.capacity(), 'y');
+		BOOST_CHECK_THROW(file.write(moved, as_bytes(full)), std::length_error);
+	}
+
+	// the superseded entry is not read back.
+	checkpoint_file reopened{tmp.path};
+	BOOST_CHECK_EQUAL(as_string(reopened.read(reopened.find("a"))), large + large);
+}
+
+BOOST_AUTO_TEST_CASE(file_replaces_other_content)
+{
+	temp_file tmp;
+	std::ofstream(tmp.path) << "no checkpoints in here";
+	checkpoint_file file{tmp.path};
+	BOOST_CHECK_EQUAL(file.find("no"), checkpoint_file::npos);
+	file.write(file.entry("a", 1), as_bytes("a"));
+	BOOST_CHECK_EQUAL(as_string(file.read(file.find("a"))), "a");
+}
+
+BOOST_AUTO_TEST_CASE(only_changed_states_are_written)
+{
+	temp_file tmp;
+	auto file = std::make_shared<checkpoint_file>(tmp.path);
+	auto checkpoints = std::make_shared<region_checkpoints>(file);
+
+	int a = 1;
+	int b = 2;
+	int serialized = 0;
+	auto counted = [&](int& state)
+	{
+		return checkpoints->add(state == a ? "a" : "b",
+				[&]() { ++serialized; return const_byte_span{
+						reinterpret_cast<const char*>(&state), sizeof(int)}; },
+				[](const_byte_span) {});
+	};
+	auto handle_a = counted(a);
+	auto handle_b = counted(b);
+	BOOST_CHECK_EQUAL(checkpoints->size(), 2);
+
+	// new states are written once.
+	(*checkpoints)();
+	BOOST_CHECK_EQUAL(serialized, 2);
+	(*checkpoints)();
+	BOOST_CHECK_EQUAL(serialized, 2);
+
+	a = 3;
+	handle_a.mark_changed();
+	handle_a.mark_changed();
+	(*checkpoints)();
+	BOOST_CHECK_EQUAL(serialized, 3);
+
+	// a removed state is no longer written, even if it was marked before.
+	handle_b.mark_changed();
+	handle_b.reset();
+	handle_b.mark_changed();
+	BOOST_CHECK_EQUAL(checkpoints->size(), 1);
+	(*checkpoints)();
+	BOOST_CHECK_EQUAL(serialized, 3);
+
+	int restored = 0;
+	add_checkpoint<fixed_layout>(*checkpoints, "a", restored);
+	BOOST_CHECK_EQUAL(restored, 3);
+}
+
+BOOST_AUTO_TEST_CASE(nodes_are_restored)
+{
+	temp_file tmp;
+	const auto run = [&](auto check)
+	{
+		auto region = std::make_shared<parallel_region>("region",
+				thread::cycle_control::fast_tick);
+		region->enable_checkpoints(std::make_shared<checkpoint_file>(tmp.path));
+		tests::owning_node root{region};
+		auto& last = root.make_child_named<hold_last<int, tree_base_node>>("last", 0);
+		last.checkpoint();
+		auto& history = root.make_child_named<hold_n<int, tree_base_node>>("history", 3);
+		history.checkpoint();
+		auto& cache = root.make_child_named<current_state<double>>("cache");
+		cache.checkpoint("cached");
+		check(*region, last, history, cache);
+	};
+
+	int value = 0;
+	run([&](auto& region, auto& last, auto& history, auto& cache)
+	{
+		BOOST_CHECK_EQUAL(last.out()(), 0);
+		BOOST_CHECK(history.out()().empty());
+
+		pure::event_source<int> source;
+		source >> last.in();
+		source >> history.in();
+		[&value]() { return value * 0.5; } >> cache.in();
+		for (value = 1; value != 6; ++value)
+		{
+			source.fire(value);
+			work_tick(region);
+			switch_tick(region);
+		}
+		// changes after the last switch tick are lost.
+		source.fire(42);
+	});
+
+	run([&](auto&, auto& last, auto& history, auto& cache)
+	{
+		BOOST_CHECK_EQUAL(last.out()(), 5);
+		BOOST_CHECK((history.out()() == std::vector<int>{3, 4, 5}));
+		BOOST_CHECK_EQUAL(cache.out()(), 2.5);
+	});
+}
+
+BOOST_AUTO_TEST_CASE(nodes_without_checkpoints)
+{
+	auto region = std::make_shared<parallel_region>("region", thread::cycle_control::fast_tick);
+	BOOST_CHECK(region->checkpoints() == nullptr);
+	tests::owning_node root{region};
+	auto& last = root.make_child<hold_last<int, tree_base_node>>(1);
+	last.checkpoint();
+	pure::event_source<int> source;
+	source >> last.in();
+	source.fire(2);
+	switch_tick(*region);
+	BOOST_CHECK_EQUAL(last.out()(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
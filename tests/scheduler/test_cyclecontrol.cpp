@@ -5,15 +5,22 @@
  *      Author: jschwan
  */
 
+#include <flexcore/extended/ports/connection_buffer.hpp>
+#include <flexcore/extended/ports/node_aware.hpp>
+#include <flexcore/pure/pure_ports.hpp>
+#include <flexcore/scheduler/capacity_profile.hpp>
 #include <flexcore/scheduler/cyclecontrol.hpp>
 #include <flexcore/scheduler/parallelscheduler.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <iomanip>
 #include <ctime>
 #include <future>
+#include <sstream>
+#include <sched.h>
 #include <unistd.h>
 
 using namespace fc;
@@ -53,14 +60,810 @@ BOOST_AUTO_TEST_CASE( test_cyclecontrol_task_not_finished_in_time)
 	BOOST_CHECK(terminate_thread);
 }
 
+BOOST_AUTO_TEST_CASE(test_periodic_task_wait_until_done)
+{
+	std::atomic<bool> release{false};
+	fc::thread::periodic_task task{[&release]
+	{
+		while (!release)
+			std::this_thread::yield();
+	}};
+	BOOST_CHECK(task.done());
+	task.set_work_to_do(true);
+	BOOST_CHECK(!task.done());
+
+	auto worker = std::async(std::launch::async, [&task]{ task(); });
+	BOOST_CHECK(!task.wait_until_done(std::chrono::milliseconds(1)));
+	release = true;
+	BOOST_CHECK(task.wait_until_done(fc::thread::cycle_control::slow_tick));
+	BOOST_CHECK(task.done());
+	worker.wait();
+}
+
 BOOST_AUTO_TEST_CASE(test_adding_tasks_to_running_scheduler)
 {
 	namespace sched = fc::thread;
 	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>()};
 	controller.start();
-	BOOST_CHECK_THROW(controller.add_task(sched::periodic_task{[]{}}, sched::cycle_control::fast_tick), std::runtime_error);
+	std::atomic<int> count{0};
+	BOOST_CHECK_NO_THROW(controller.add_task(
+			sched::periodic_task{[&count]{ ++count; }}, sched::cycle_control::fast_tick));
+	for (int i = 0; i != 500 && count == 0; ++i)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	BOOST_CHECK_GT(count, 0);
+	controller.stop();
+	BOOST_CHECK_THROW(controller.add_task(sched::periodic_task{[]{}}, sched::cycle_control::fast_tick / 2), std::invalid_argument);
+	BOOST_CHECK_THROW(controller.add_task(sched::periodic_task{[]{}}, virtual_clock::duration::zero()), std::invalid_argument);
+	BOOST_CHECK_NO_THROW(controller.add_task(sched::periodic_task{[]{}}, 2 * sched::cycle_control::slow_tick));
+}
+
+BOOST_AUTO_TEST_CASE(test_add_and_remove_regions_while_running)
+{
+	namespace sched = fc::thread;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(),
+		[](auto& task) { return task.wait_until_done(sched::cycle_control::slow_tick); },
+		std::make_shared<sched::afap_main_loop>()};
+
+	auto steady = std::make_shared<parallel_region>("steady", sched::cycle_control::fast_tick);
+	std::atomic<int> steady_count{0};
+	steady->work_tick() >> [&steady_count]{ ++steady_count; };
+	controller.add_task(sched::periodic_task{steady}, sched::cycle_control::fast_tick);
+	controller.start();
+
+	const auto wait_for = [](auto condition)
+	{
+		for (int i = 0; i != 5000 && !condition(); ++i)
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		return condition();
+	};
+	// regions are plugged in with the same and with a new tick rate.
+	auto added = std::make_shared<parallel_region>("added", sched::cycle_control::fast_tick);
+	auto slow = std::make_shared<parallel_region>("slow", sched::cycle_control::medium_tick);
+	std::atomic<int> added_count{0};
+	std::atomic<int> slow_count{0};
+	added->work_tick() >> [&added_count]{ ++added_count; };
+	slow->work_tick() >> [&slow_count]{ ++slow_count; };
+	controller.add_task(sched::periodic_task{added}, sched::cycle_control::fast_tick);
+	controller.add_task(sched::periodic_task{slow}, sched::cycle_control::medium_tick);
+	BOOST_CHECK(wait_for([&]{ return added_count > 10 && slow_count > 1; }));
+
+	controller.remove_tasks(*added);
+	const int steady_before = steady_count;
+	BOOST_CHECK(wait_for([&]{ return steady_count > steady_before + 10; }));
+	const int removed_count = added_count;
+	BOOST_CHECK(wait_for([&]{ return steady_count > steady_before + 20; }));
+	BOOST_CHECK_EQUAL(added_count, removed_count);
+	controller.stop();
+	BOOST_CHECK(!controller.last_exception());
+	BOOST_CHECK_EQUAL(controller.timing().tasks.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_changes_of_busy_tick_rate_do_not_stall)
+{
+	namespace sched = fc::thread;
+	// the blocked region must not take the only worker.
+	thread::thread_config two_workers;
+	two_workers.nr_of_threads = 2;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(two_workers),
+		[](auto& task) { return task.wait_until_done(sched::cycle_control::slow_tick); },
+		std::make_shared<sched::realtime_main_loop>()};
+	// a clock of its own starts with a cycle of all rates, instead of waiting for a slow tick.
+	auto clock = std::make_shared<clock_domain>();
+	controller.set_clock(clock);
+
+	auto fast = std::make_shared<parallel_region>(
+			"fast", sched::cycle_control::fast_tick, clock);
+	auto blocked = std::make_shared<parallel_region>(
+			"blocked", sched::cycle_control::slow_tick, clock);
+	std::atomic<int> fast_count{0};
+	std::atomic<bool> entered{false};
+	std::atomic<bool> release{false};
+	fast->work_tick() >> [&fast_count]{ ++fast_count; };
+	blocked->work_tick() >> [&]
+	{
+		entered = true;
+		while (!release)
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+	};
+	controller.add_task(sched::periodic_task{fast}, sched::cycle_control::fast_tick);
+	controller.add_task(sched::periodic_task{blocked}, sched::cycle_control::slow_tick);
+	controller.start();
+
+	const auto wait_for = [](auto condition)
+	{
+		for (int i = 0; i != 5000 && !condition(); ++i)
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		return condition();
+	};
+	BOOST_REQUIRE(wait_for([&]{ return entered.load(); }));
+	// the slow bucket is busy, its changes wait while the fast tick goes on.
+	std::atomic<int> added_count{0};
+	controller.add_task(sched::periodic_task{[&added_count]{ ++added_count; }},
+			sched::cycle_control::slow_tick);
+	const int fast_before = fast_count;
+	BOOST_CHECK(wait_for([&]{ return fast_count > fast_before + 10; }));
+	BOOST_CHECK_EQUAL(added_count, 0);
+
+	BOOST_CHECK_EQUAL(controller.timing().tasks.size(), 2);
+
+	// taken over once the bucket is idle, it runs with the next slow tick.
+	release = true;
+	BOOST_CHECK(wait_for([&]{ return controller.timing().tasks.size() == 3; }));
+	controller.stop();
+	BOOST_CHECK(!controller.last_exception());
+}
+
+BOOST_AUTO_TEST_CASE(test_arbitrary_tick_rates)
+{
+	namespace sched = fc::thread;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(),
+		[](auto& task) { return task.wait_until_done(sched::cycle_control::slow_tick); },
+		std::make_shared<sched::afap_main_loop>()};
+	// 250Hz base rate
+	controller.set_min_tick(std::chrono::milliseconds(4));
+	BOOST_CHECK(controller.min_tick() == std::chrono::milliseconds(4));
+	BOOST_CHECK_THROW(controller.add_task(sched::periodic_task{[]{}}, sched::cycle_control::fast_tick),
+			std::invalid_argument);
+
+	std::atomic<int> count_4ms{0};
+	std::atomic<int> count_12ms{0};
+	controller.add_task(sched::periodic_task{[&] { ++count_4ms; }}, std::chrono::milliseconds(4));
+	controller.add_task(sched::periodic_task{[&] { ++count_12ms; }}, std::chrono::milliseconds(12));
+	BOOST_CHECK_THROW(controller.set_min_tick(std::chrono::milliseconds(8)), std::invalid_argument);
+
+	const auto start = virtual_clock::steady::now();
+	for (int i = 0; i != 12; ++i)
+		controller.work();
+	controller.stop();
+	BOOST_CHECK(virtual_clock::steady::now() - start == std::chrono::milliseconds(48));
+	BOOST_CHECK_EQUAL(count_4ms, 12);
+	BOOST_CHECK_EQUAL(count_12ms, 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_region_dependencies)
+{
+	namespace sched = fc::thread;
+	thread::thread_config two_workers;
+	two_workers.nr_of_threads = 2;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(two_workers),
+		[](auto& task) { return task.wait_until_done(sched::cycle_control::slow_tick); },
+		std::make_shared<sched::afap_main_loop>()};
+
+	auto first = std::make_shared<parallel_region>("first", sched::cycle_control::fast_tick);
+	auto second = std::make_shared<parallel_region>("second", sched::cycle_control::fast_tick);
+	// added in reverse order, so without the dependency second would be started first.
+	controller.add_task(sched::periodic_task{second}, sched::cycle_control::fast_tick);
+	controller.add_task(sched::periodic_task{first}, sched::cycle_control::fast_tick);
+	controller.add_dependency(*first, *second);
+	BOOST_CHECK_THROW(controller.add_dependency(*second, *first), std::invalid_argument);
+
+	std::atomic<int> first_count{0};
+	std::vector<int> seen_by_second;
+	first->work_tick() >> [&first_count]
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		++first_count;
+	};
+	second->work_tick() >> [&]{ seen_by_second.push_back(first_count); };
+
+	for (int i = 0; i != 10; ++i)
+		controller.work();
+	controller.stop();
+
+	BOOST_CHECK_EQUAL(seen_by_second.size(), 10);
+	for (size_t i = 0; i != seen_by_second.size(); ++i)
+		BOOST_CHECK_EQUAL(seen_by_second[i], i + 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_dependent_regions_switch_before_work)
+{
+	namespace sched = fc::thread;
+	thread::thread_config two_workers;
+	two_workers.nr_of_threads = 2;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(two_workers),
+		[](auto& task) { return task.wait_until_done(sched::cycle_control::slow_tick); },
+		std::make_shared<sched::afap_main_loop>()};
+
+	auto first = std::make_shared<parallel_region>("first", sched::cycle_control::fast_tick);
+	auto second = std::make_shared<parallel_region>("second", sched::cycle_control::fast_tick);
+	// reads from buffers of second, without any order to first or second.
+	auto reader = std::make_shared<parallel_region>("reader", sched::cycle_control::fast_tick);
+	controller.add_task(sched::periodic_task{first}, sched::cycle_control::fast_tick);
+	controller.add_task(sched::periodic_task{second}, sched::cycle_control::fast_tick);
+	controller.add_task(sched::periodic_task{reader}, sched::cycle_control::fast_tick);
+	controller.add_dependency(*first, *second);
+
+	std::atomic<int> second_switches{0};
+	std::atomic<int> switches_during_work{0};
+	second->switch_tick() >> [&second_switches]{ ++second_switches; };
+	first->work_tick() >> []
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	};
+	reader->work_tick() >> [&]
+	{
+		const int before = second_switches.load();
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		switches_during_work += second_switches.load() - before;
+	};
+
+	for (int i = 0; i != 10; ++i)
+		controller.work();
+	controller.stop();
+
+	BOOST_CHECK_EQUAL(second_switches.load(), 10);
+	BOOST_CHECK_EQUAL(switches_during_work.load(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_successor_of_overrunning_region_runs)
+{
+	namespace sched = fc::thread;
+	thread::thread_config two_workers;
+	two_workers.nr_of_threads = 2;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(two_workers)};
+	controller.enable_throttling(sched::throttling_policy{});
+
+	auto first = std::make_shared<parallel_region>("first", sched::cycle_control::fast_tick);
+	auto second = std::make_shared<parallel_region>("second", sched::cycle_control::fast_tick);
+	// lets throttling absorb the overrun of first.
+	auto background = std::make_shared<parallel_region>(
+			"background", sched::cycle_control::fast_tick);
+	background->set_acceptable_rates({sched::cycle_control::fast_tick * 2});
+	controller.add_task(sched::periodic_task{first}, sched::cycle_control::fast_tick);
+	controller.add_task(sched::periodic_task{second}, sched::cycle_control::fast_tick);
+	controller.add_task(sched::periodic_task{background}, sched::cycle_control::fast_tick);
+	controller.add_dependency(*first, *second);
+
+	int first_count = 0;
+	std::atomic<int> second_count{0};
+	first->work_tick() >> [&first_count]
+	{
+		if (++first_count == 3)
+			std::this_thread::sleep_for(std::chrono::milliseconds(25));
+	};
+	second->work_tick() >> [&second_count]{ ++second_count; };
+	controller.run_cycles(10);
+
+	// the successor waits for the overrunning work and runs again afterwards.
+	BOOST_CHECK_EQUAL(second_count.load(), first_count);
+	BOOST_CHECK_GE(second_count.load(), 5);
+	BOOST_CHECK(!controller.last_exception());
+}
+
+BOOST_AUTO_TEST_CASE(test_cycle_time)
+{
+	namespace sched = fc::thread;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(),
+		[](auto& task) { return task.wait_until_done(sched::cycle_control::slow_tick); },
+		std::make_shared<sched::afap_main_loop>()};
+	auto fast = std::make_shared<parallel_region>("fast", sched::cycle_control::fast_tick);
+	auto medium = std::make_shared<parallel_region>("medium", sched::cycle_control::medium_tick);
+	controller.add_task(sched::periodic_task{fast}, sched::cycle_control::fast_tick);
+	controller.add_task(sched::periodic_task{medium}, sched::cycle_control::medium_tick);
+
+	std::vector<virtual_clock::steady::time_point> fast_times;
+	std::vector<virtual_clock::steady::time_point> medium_times;
+	fast->work_tick() >> [&]{ fast_times.push_back(fast->cycle_time()); };
+	medium->work_tick() >> [&]{ medium_times.push_back(medium->cycle_time()); };
+
+	const auto start = virtual_clock::steady::now();
+	for (int i = 0; i != 20; ++i)
+		controller.work();
+	controller.stop();
+
+	BOOST_REQUIRE_EQUAL(fast_times.size(), 20);
+	BOOST_CHECK_EQUAL(medium_times.size(), 2);
+	for (size_t i = 0; i != fast_times.size(); ++i)
+		BOOST_CHECK(fast_times[i] == start + sched::cycle_control::fast_tick * (i + 1));
+	// the slower region keeps the time of its own cycle.
+	for (const auto& t : medium_times)
+		BOOST_CHECK(std::find(fast_times.begin(), fast_times.end(), t) != fast_times.end());
+}
+
+BOOST_AUTO_TEST_CASE(test_independent_clocks)
+{
+	namespace sched = fc::thread;
+	const auto global_start = virtual_clock::steady::now();
+	const auto simulate = [](int cycles)
+	{
+		auto clock = std::make_shared<clock_domain>();
+		sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(),
+			[](auto& task) { return task.wait_until_done(sched::cycle_control::slow_tick); },
+			std::make_shared<sched::afap_main_loop>()};
+		controller.set_clock(clock);
+		auto region = std::make_shared<parallel_region>(
+				"simulation", sched::cycle_control::fast_tick, clock);
+		BOOST_CHECK(region->new_region("child", sched::cycle_control::fast_tick)->shared_clock()
+				== clock);
+		std::vector<virtual_clock::steady::time_point> times;
+		region->work_tick() >> [&]{ times.push_back(region->cycle_time()); };
+		controller.add_task(sched::periodic_task{region}, sched::cycle_control::fast_tick);
+		for (int i = 0; i != cycles; ++i)
+			controller.work();
+		controller.stop();
+		return times;
+	};
+
+	auto slow = std::async(std::launch::async, simulate, 20);
+	auto fast = std::async(std::launch::async, simulate, 50);
+	const auto slow_times = slow.get();
+	const auto fast_times = fast.get();
+	BOOST_REQUIRE_EQUAL(slow_times.size(), 20);
+	BOOST_REQUIRE_EQUAL(fast_times.size(), 50);
+	for (size_t i = 0; i != fast_times.size(); ++i)
+	{
+		const auto expected = virtual_clock::steady::time_point{
+			sched::cycle_control::fast_tick * (i + 1)};
+		BOOST_CHECK(fast_times[i] == expected);
+		if (i < slow_times.size())
+			BOOST_CHECK(slow_times[i] == expected);
+	}
+	BOOST_CHECK(virtual_clock::steady::now() == global_start);
+
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>()};
+	controller.set_clock(std::make_shared<clock_domain>());
+	auto global_region = std::make_shared<parallel_region>("global", sched::cycle_control::fast_tick);
+	BOOST_CHECK_THROW(controller.add_task(sched::periodic_task{global_region},
+			sched::cycle_control::fast_tick), std::invalid_argument);
+	controller.add_task(sched::periodic_task{[]{}}, sched::cycle_control::fast_tick);
+	BOOST_CHECK_THROW(controller.set_clock(clock_domain::global()), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_skip_on_overrun)
+{
+	namespace sched = fc::thread;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>()};
+	std::atomic<bool> release{false};
+	std::atomic<int> count{0};
+	sched::periodic_task best_effort{[&]
+	{
+		while (!release)
+			std::this_thread::yield();
+		++count;
+	}};
+	best_effort.set_skip_on_overrun(true);
+	BOOST_CHECK(best_effort.skips_on_overrun());
+	controller.add_task(std::move(best_effort), sched::cycle_control::fast_tick);
+
+	controller.work(); // starts task
+	controller.work(); // task still running, cycle skipped instead of reporting a timeout
+	BOOST_CHECK(!controller.last_exception());
+	release = true;
 	controller.stop();
-	BOOST_CHECK_THROW(controller.add_task(sched::periodic_task{[]{}}, 2 * sched::cycle_control::slow_tick), std::invalid_argument);
+	BOOST_CHECK_EQUAL(count, 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_warm_up)
+{
+	namespace sched = fc::thread;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>()};
+	std::atomic<int> count{0};
+	// slower than its tick, which would be a timeout in realtime.
+	sched::periodic_task slow{[&]
+	{
+		std::this_thread::sleep_for(sched::cycle_control::fast_tick * 2);
+		++count;
+	}};
+	controller.add_task(std::move(slow), sched::cycle_control::fast_tick);
+
+	controller.warm_up(3);
+	BOOST_CHECK_EQUAL(count, 3);
+	BOOST_CHECK(!controller.last_exception());
+	const auto timing = controller.timing();
+	BOOST_REQUIRE_EQUAL(timing.tasks.size(), 1);
+	BOOST_CHECK_EQUAL(timing.tasks[0].execution.count, 0);
+	BOOST_CHECK_EQUAL(timing.tasks[0].skipped_cycles, 0);
+	BOOST_CHECK_EQUAL(timing.main_loop_overrun.count, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_completion_counter)
+{
+	thread::detail::completion_counter completion;
+	thread::periodic_task task{[] {}};
+	task.set_completion_counter(&completion);
+
+	task.set_work_to_do(true);
+	task.set_work_to_do(true);
+	BOOST_CHECK_EQUAL(completion.busy.load(), 1);
+	task();
+	BOOST_CHECK_EQUAL(completion.busy.load(), 0);
+	task.set_work_to_do(false);
+	BOOST_CHECK_EQUAL(completion.busy.load(), 0);
+
+	// cycles added while running count once, until the last of them is finished.
+	BOOST_CHECK(task.add_cycle());
+	BOOST_CHECK(!task.add_cycle());
+	BOOST_CHECK_EQUAL(completion.busy.load(), 1);
+	BOOST_CHECK(task.finish_cycle());
+	BOOST_CHECK_EQUAL(completion.busy.load(), 1);
+	BOOST_CHECK(!task.finish_cycle());
+	BOOST_CHECK_EQUAL(completion.busy.load(), 0);
+	BOOST_CHECK(task.done());
+}
+
+BOOST_AUTO_TEST_CASE(test_completion_latch)
+{
+	thread::detail::completion_counter completion;
+	completion.add();
+	BOOST_CHECK(!completion.wait_until_done(
+			wall_clock::steady::now() + std::chrono::milliseconds(1)));
+
+	completion.add();
+	completion.add();
+	std::thread worker{[&completion]
+	{
+		for (int i = 0; i != 3; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			completion.finish();
+		}
+	}};
+	BOOST_CHECK(completion.wait_until_done(wall_clock::steady::now() + std::chrono::seconds(10)));
+	BOOST_CHECK_EQUAL(completion.busy.load(), 0);
+	worker.join();
+}
+
+BOOST_AUTO_TEST_CASE(test_capacity_profile)
+{
+	std::stringstream file;
+	{
+		// the first run records the capacity the buffer has grown to.
+		fc::event_buffer<int> buffer;
+		fc::thread::capacity_profile profile;
+		profile.track("sensor buffer", buffer);
+		for (int i = 0; i != 100; ++i)
+			buffer.in()(i);
+		buffer.switch_active_passive_tick()();
+		profile.record();
+		BOOST_CHECK_GE(profile.recorded("sensor buffer"), 100);
+		profile.write(file);
+	}
+
+	fc::event_buffer<int> buffer;
+	fc::thread::capacity_profile profile;
+	profile.read(file);
+	BOOST_CHECK_GE(profile.recorded("sensor buffer"), 100);
+	BOOST_CHECK_EQUAL(profile.recorded("other"), 0);
+	profile.track("sensor buffer", buffer);
+	profile.apply();
+	BOOST_CHECK_GE(buffer.capacity(), 100);
+
+	std::stringstream invalid{"sensor buffer many\n"};
+	BOOST_CHECK_THROW(profile.read(invalid), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_suspend_region)
+{
+	namespace sched = fc::thread;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(),
+		[](auto& task) { return task.wait_until_done(sched::cycle_control::slow_tick); },
+		std::make_shared<sched::afap_main_loop>()};
+
+	auto region = std::make_shared<parallel_region>("paused", sched::cycle_control::fast_tick);
+	controller.add_task(sched::periodic_task{region}, sched::cycle_control::fast_tick);
+	std::atomic<int> work_count{0};
+	std::atomic<int> switch_count{0};
+	int suspend_count = 0;
+	int resume_count = 0;
+	region->work_tick() >> [&work_count]{ ++work_count; };
+	region->switch_tick() >> [&switch_count]{ ++switch_count; };
+	region->suspend_tick() >> [&suspend_count]{ ++suspend_count; };
+	region->resume_tick() >> [&resume_count]{ ++resume_count; };
+
+	controller.work();
+	controller.work();
+	region->suspend();
+	BOOST_CHECK(region->suspended());
+	controller.work();
+	const int works_before = work_count;
+	const int switches_before = switch_count;
+	for (int i = 0; i != 5; ++i)
+		controller.work();
+	BOOST_CHECK_EQUAL(work_count, works_before);
+	BOOST_CHECK_EQUAL(switch_count, switches_before);
+	BOOST_CHECK_EQUAL(suspend_count, 1);
+	BOOST_CHECK_EQUAL(resume_count, 0);
+
+	region->resume();
+	controller.work();
+	controller.work();
+	controller.stop();
+	BOOST_CHECK_EQUAL(resume_count, 1);
+	BOOST_CHECK_EQUAL(work_count, works_before + 2);
+	BOOST_CHECK_EQUAL(switch_count, switches_before + 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_throttling)
+{
+	namespace sched = fc::thread;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>()};
+	sched::throttling_policy policy;
+	policy.overrun_cycles = 2;
+	policy.headroom_cycles = 3;
+	controller.enable_throttling(policy);
+
+	auto critical = std::make_shared<parallel_region>("critical", sched::cycle_control::fast_tick);
+	critical->set_priority(1);
+	auto background = std::make_shared<parallel_region>(
+			"background", sched::cycle_control::fast_tick);
+	background->set_acceptable_rates({sched::cycle_control::fast_tick * 2});
+	std::atomic<bool> release{false};
+	critical->work_tick() >> [&release]
+	{
+		while (!release)
+			std::this_thread::yield();
+	};
+	controller.add_task(sched::periodic_task{critical}, sched::cycle_control::fast_tick);
+	controller.add_task(sched::periodic_task{background}, sched::cycle_control::fast_tick);
+
+	const auto rate_of = [&controller](const std::string& name)
+	{
+		for (const auto& task : controller.timing().tasks)
+			if (task.name == name)
+				return task.tick;
+		return virtual_clock::steady::duration::zero();
+	};
+	const auto cycle_when_idle = [&controller]
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		controller.work();
+	};
+
+	controller.work(); // starts critical, which blocks
+	controller.work(); // overruns are absorbed, as background can be slowed down
+	controller.work();
+	BOOST_CHECK(!controller.last_exception());
+	release = true;
+	cycle_when_idle();
+	BOOST_CHECK(rate_of("background") == sched::cycle_control::fast_tick * 2);
+	BOOST_CHECK(rate_of("critical") == sched::cycle_control::fast_tick);
+
+	// nothing left to slow down, overruns are reported again.
+	release = false;
+	controller.work();
+	controller.work();
+	BOOST_CHECK(controller.last_exception());
+	release = true;
+
+	// with headroom, background gets its rate back.
+	for (int i = 0; i != 5; ++i)
+		cycle_when_idle();
+	BOOST_CHECK(rate_of("background") == sched::cycle_control::fast_tick);
+	controller.stop();
+}
+
+BOOST_AUTO_TEST_CASE(test_overrun_report)
+{
+	namespace sched = fc::thread;
+	sched::cycle_control* self = nullptr;
+	std::vector<sched::overrun_report> reports;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(),
+		[&self, &reports](auto& task)
+		{
+			reports.push_back(self->report_overrun(task));
+			return true;
+		},
+		std::make_shared<sched::afap_main_loop>()};
+	self = &controller;
+
+	auto slow = std::make_shared<parallel_region>("slow", sched::cycle_control::fast_tick);
+	auto other = std::make_shared<parallel_region>("other", sched::cycle_control::fast_tick);
+	slow->workers().enable_profiling(1);
+	std::atomic<bool> release{false};
+	std::atomic<int> runs{0};
+	const int fast_owner = 0;
+	const int blocking_owner = 0;
+	auto fast = slow->add_worker([]{}, &fast_owner, "fast");
+	auto blocking = slow->add_worker([&]
+	{
+		if (++runs == 2)
+			while (!release)
+				std::this_thread::yield();
+		else
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}, &blocking_owner, "blocking");
+	other->work_tick() >> [&runs, &release]
+	{
+		if (runs == 2)
+			while (!release)
+				std::this_thread::yield();
+	};
+	controller.add_task(sched::periodic_task{slow}, sched::cycle_control::fast_tick);
+	controller.add_task(sched::periodic_task{other}, sched::cycle_control::fast_tick);
+
+	controller.work(); // profiles the workers
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	controller.work(); // blocks
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	controller.work();
+	release = true;
+	controller.stop();
+
+	BOOST_REQUIRE(!reports.empty());
+	const auto& report = reports.front();
+	BOOST_CHECK_EQUAL(report.task.name, "slow");
+	BOOST_CHECK(report.task.tick == sched::cycle_control::fast_tick);
+	BOOST_REQUIRE_EQUAL(report.workers.size(), 2);
+	BOOST_CHECK_EQUAL(report.workers.front().name, "blocking");
+	BOOST_CHECK(report.workers.front().time >= std::chrono::milliseconds(2));
+	BOOST_REQUIRE_EQUAL(report.busy_tasks.size(), 1);
+	BOOST_CHECK_EQUAL(report.busy_tasks.front().name, "other");
+
+	const auto text = sched::to_string(report);
+	BOOST_CHECK(text.find("\"slow\"") != std::string::npos);
+	BOOST_CHECK(text.find("blocking") != std::string::npos);
+	BOOST_CHECK(text.find("\"other\"") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(test_precise_realtime_main_loop)
+{
+	namespace sched = fc::thread;
+	auto loop = std::make_shared<sched::precise_realtime_main_loop>();
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(), loop};
+	std::atomic<int> count{0};
+	controller.add_task(sched::periodic_task{[&count] { ++count; }},
+			sched::cycle_control::fast_tick);
+
+	controller.start();
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	controller.stop();
+
+	BOOST_CHECK_GE(count, 5);
+	BOOST_CHECK(loop->last_wakeup_error() >= wall_clock::steady::duration::zero());
+	BOOST_CHECK(loop->max_wakeup_error() >= loop->last_wakeup_error());
+	BOOST_TEST_MESSAGE("Max wake up error: "
+			<< std::chrono::duration_cast<std::chrono::microseconds>(
+					loop->max_wakeup_error()).count() << "us");
+}
+
+BOOST_AUTO_TEST_CASE(test_replay_main_loop)
+{
+	namespace sched = fc::thread;
+	auto loop = std::make_shared<sched::replay_main_loop>();
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(), loop};
+
+	std::vector<virtual_clock::steady::time_point> medium_times;
+	size_t cycles_for_medium_times = 0;
+	std::atomic<bool> done{false};
+	controller.add_task(sched::periodic_task{[&]
+	{
+		if (medium_times.size() < 20)
+		{
+			medium_times.push_back(virtual_clock::steady::now());
+			cycles_for_medium_times = loop->cycles_executed();
+		}
+		else
+			done = true;
+	}}, sched::cycle_control::medium_tick);
+
+	controller.start();
+	while (!done)
+		std::this_thread::yield();
+	controller.stop();
+
+	// clock is advanced before tasks run, the tasks see the end of their cycle.
+	for (size_t i = 1; i < medium_times.size(); ++i)
+		BOOST_CHECK(medium_times[i] - medium_times[i - 1] == sched::cycle_control::medium_tick);
+	// idle cycles in between are skipped
+	BOOST_CHECK_EQUAL(medium_times.size(), 20);
+	BOOST_CHECK_LE(cycles_for_medium_times, medium_times.size() + 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_pipelined_afap_main_loop)
+{
+	namespace sched = fc::thread;
+	constexpr size_t cycles_ahead = 3;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(),
+		std::make_shared<sched::afap_main_loop>(cycles_ahead)};
+
+	std::atomic<size_t> slow_count{0};
+	std::atomic<size_t> fast_count{0};
+	std::atomic<size_t> max_lag{0};
+	controller.add_task(sched::periodic_task{[&]
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+		++slow_count;
+	}}, sched::cycle_control::fast_tick);
+	controller.add_task(sched::periodic_task{[&]
+	{
+		const size_t fast = ++fast_count;
+		const size_t slow = slow_count.load();
+		if (fast > slow && fast - slow > max_lag.load())
+			max_lag.store(fast - slow);
+	}}, sched::cycle_control::fast_tick);
+
+	controller.start();
+	while (slow_count.load() < 50)
+		std::this_thread::yield();
+	controller.stop();
+
+	// the slow task falls behind, but catches up on every cycle without skipping any.
+	BOOST_CHECK_EQUAL(slow_count.load(), fast_count.load());
+	BOOST_CHECK_LE(max_lag.load(), cycles_ahead + 1);
+	BOOST_CHECK(!controller.last_exception());
+}
+
+BOOST_AUTO_TEST_CASE(test_pipelined_afap_main_loop_keeps_buffered_regions)
+{
+	namespace sched = fc::thread;
+	constexpr size_t cycles_ahead = 3;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(),
+		std::make_shared<sched::afap_main_loop>(cycles_ahead)};
+
+	// the regions have no declared dependency, only the buffer of their connection.
+	auto producer = std::make_shared<parallel_region>("producer", sched::cycle_control::fast_tick);
+	auto consumer = std::make_shared<parallel_region>("consumer", sched::cycle_control::fast_tick);
+	node_aware<pure::event_source<size_t>> source{*producer};
+	std::atomic<size_t> received{0};
+	node_aware<pure::event_sink<size_t>> sink{*consumer, [&](size_t) { ++received; }};
+	source >> sink;
+
+	std::atomic<size_t> produced{0};
+	std::atomic<size_t> consumed{0};
+	std::atomic<size_t> max_lag{0};
+	producer->ticks.work_tick() >> [&]
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+		source.fire(++produced);
+	};
+	consumer->ticks.work_tick() >> [&]
+	{
+		const size_t consumer_cycle = ++consumed;
+		const size_t producer_cycle = produced.load();
+		if (consumer_cycle > producer_cycle && consumer_cycle - producer_cycle > max_lag.load())
+			max_lag.store(consumer_cycle - producer_cycle);
+	};
+	controller.add_task(sched::periodic_task{producer}, sched::cycle_control::fast_tick);
+	controller.add_task(sched::periodic_task{consumer}, sched::cycle_control::fast_tick);
+
+	controller.start();
+	while (produced.load() < 50)
+		std::this_thread::yield();
+	controller.stop();
+
+	// neither region runs ahead of the other, as both switch the buffer.
+	BOOST_CHECK_LE(max_lag.load(), 1);
+	BOOST_CHECK_LE(consumed.load(), produced.load() + 1);
+	BOOST_CHECK_LE(received.load(), produced.load());
+	BOOST_CHECK(!controller.last_exception());
+}
+
+BOOST_AUTO_TEST_CASE(test_fast_main_loop_full_slow_tick)
+{
+	namespace sched = fc::thread;
+	using cycle = sched::cycle_control;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(),
+		[](auto& task)
+		{
+			const bool res{task.wait_until_done(sched::cycle_control::slow_tick)};
+			assert(res);
+			return res;
+		}, //we don't react to timeouts here, just continue working
+		std::make_shared<sched::afap_main_loop>()};
+	// the cycles start from zero, independent of other tests advancing the global clock.
+	controller.set_clock(std::make_shared<clock_domain>());
+	auto count_fast = 0ull;
+	auto count_medium = 0ull;
+	auto count_slow = 0ull;
+	std::atomic_bool slow_done{false};
+	controller.add_task(sched::periodic_task{[&] { ++count_fast; }}, cycle::fast_tick);
+	controller.add_task(sched::periodic_task{[&] { ++count_medium; }}, cycle::medium_tick);
+	// all tasks run in the first cycle, stop after the second run of the slow task,
+	// so the other tasks run for a full slow tick independent of thread scheduling.
+	controller.add_task(sched::periodic_task{[&]() {
+		if (++count_slow == 2)
+			slow_done.store(true);
+	}}, cycle::slow_tick);
+	controller.start();
+	while (!slow_done.load())
+		std::this_thread::yield();
+	controller.stop();
+	auto ratio_fast_medium = static_cast<double>(count_fast) / count_medium;
+	auto ratio_medium_slow = static_cast<double>(count_medium) / count_slow;
+	auto ratio_fast_slow = static_cast<double>(count_fast) / count_slow;
+	BOOST_CHECK_CLOSE_FRACTION(ratio_fast_medium, 10.0, 1);
+	BOOST_CHECK_CLOSE_FRACTION(ratio_medium_slow, 10.0, 1);
+	BOOST_CHECK_CLOSE_FRACTION(ratio_fast_slow, 100.0, 1);
 }
 
 BOOST_AUTO_TEST_CASE(test_fast_main_loop)
@@ -102,4 +905,52 @@ BOOST_AUTO_TEST_CASE(test_fast_main_loop)
 	BOOST_TEST_MESSAGE("Medium count: " << count_medium);
 	BOOST_TEST_MESSAGE("Slow count: " << count_slow);
 }
+namespace
+{
+/// records the cpu the main loop runs on.
+class cpu_recording_loop final : public thread::main_loop
+{
+public:
+	void loop_body(const std::function<void(void)>& work) override
+	{
+		cpu.store(sched_getcpu());
+		work();
+		std::this_thread::sleep_for(std::chrono::milliseconds{1});
+	}
+	void arm() override {}
+
+	std::atomic<int> cpu{-1};
+};
+}
+
+BOOST_AUTO_TEST_CASE(test_main_loop_config)
+{
+	cpu_set_t allowed;
+	BOOST_REQUIRE_EQUAL(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+	int last_allowed = 0;
+	for (int cpu = 0; cpu != CPU_SETSIZE; ++cpu)
+		if (CPU_ISSET(cpu, &allowed))
+			last_allowed = cpu;
+
+	auto loop = std::make_shared<cpu_recording_loop>();
+	thread::cycle_control controller{std::make_unique<thread::parallel_scheduler>(), loop};
+	thread::thread_config config;
+	config.cpu_cores = {CPU_SETSIZE};
+	config.prefault_stack = 256 << 10;
+	controller.set_main_loop_config(config);
+	BOOST_CHECK_EQUAL(controller.main_loop_config().prefault_stack, config.prefault_stack);
+	// the main loop is stopped again without a cycle, if its settings are rejected.
+	BOOST_CHECK_THROW(controller.start(), std::system_error);
+	BOOST_CHECK_EQUAL(loop->cpu.load(), -1);
+
+	config.cpu_cores = {last_allowed};
+	controller.set_main_loop_config(config);
+	controller.start();
+	BOOST_CHECK_THROW(controller.set_main_loop_config(config), std::runtime_error);
+	while (loop->cpu.load() < 0)
+		std::this_thread::yield();
+	controller.stop();
+	BOOST_CHECK_EQUAL(loop->cpu.load(), last_allowed);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
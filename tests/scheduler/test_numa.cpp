@@ -0,0 +1,142 @@
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/scheduler/cyclecontrol.hpp>
+#include <flexcore/scheduler/numascheduler.hpp>
+#include <flexcore/scheduler/trace.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <sys/stat.h>
+
+using namespace fc;
+
+BOOST_AUTO_TEST_SUITE(test_numa)
+
+namespace
+{
+/// two nodes sharing cpu 0, which exists on every machine the tests run on.
+thread::numa_topology two_nodes()
+{
+	return thread::numa_topology{{{0, {0}}, {1, {0}}}};
+}
+}
+
+BOOST_AUTO_TEST_CASE(test_cpu_list)
+{
+	BOOST_CHECK((thread::parse_cpu_list("0-3,8,10-11\n") == std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+	BOOST_CHECK(thread::parse_cpu_list("").empty());
+	BOOST_CHECK_THROW(thread::parse_cpu_list("3-1"), std::invalid_argument);
+	BOOST_CHECK_THROW(thread::parse_cpu_list("1;2"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_detect)
+{
+	char root[] = "/tmp/flexcore_numa_XXXXXX";
+	BOOST_REQUIRE(mkdtemp(root));
+	const std::string dir = root;
+	for (const auto& node : {std::make_pair("node1", "2-3\n"), std::make_pair("node0", "0-1\n"),
+			std::make_pair("node2", "\n")})
+	{
+		mkdir((dir + "/" + node.first).c_str(), 0700);
+		std::ofstream(dir + "/" + node.first + "/cpulist") << node.second;
+	}
+	mkdir((dir + "/power").c_str(), 0700);
+
+	const auto topology = thread::numa_topology::detect(dir);
+	// nodes without cpus are left out.
+	BOOST_REQUIRE_EQUAL(topology.nodes.size(), 2);
+	BOOST_CHECK_EQUAL(topology.nodes[0].id, 0);
+	BOOST_CHECK((topology.nodes[1].cpus == std::vector<int>{2, 3}));
+	BOOST_CHECK_EQUAL(topology.node_of_cpu(3), 1);
+	BOOST_CHECK_EQUAL(topology.node_of_cpu(4), thread::any_numa_node);
+
+	std::system(("rm -r " + dir).c_str());
+	const auto fallback = thread::numa_topology::detect(dir);
+	BOOST_REQUIRE_EQUAL(fallback.nodes.size(), 1);
+	BOOST_CHECK(!fallback.nodes[0].cpus.empty());
+
+	const auto config = thread::numa_thread_config(topology, 1);
+	BOOST_CHECK_EQUAL(config.nr_of_threads, 2);
+	BOOST_CHECK((config.cpu_cores == std::vector<int>{2, 3}));
+	BOOST_CHECK_THROW(thread::numa_thread_config(topology, 2), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_scheduler_pools)
+{
+	thread::thread_config base;
+	base.nr_of_threads = 2;
+	thread::numa_scheduler scheduler{two_nodes(), base};
+	BOOST_CHECK_EQUAL(scheduler.nr_of_threads(), 4);
+	BOOST_CHECK_EQUAL(scheduler.worker_on_numa_node(1, 0), 2);
+	BOOST_CHECK_EQUAL(scheduler.worker_on_numa_node(1, 3), 3);
+	BOOST_CHECK_EQUAL(scheduler.worker_on_numa_node(5, 3), 3);
+	BOOST_CHECK_EQUAL(scheduler.numa_node_of_worker(1), 0);
+	BOOST_CHECK_EQUAL(scheduler.numa_node_of_worker(3), 1);
+
+	std::atomic<int> done{0};
+	std::vector<thread::scheduler::affine_task> batch;
+	for (size_t i = 0; i != 8; ++i)
+		batch.push_back({[&done] { ++done; }, i % 2 ? thread::scheduler::any_worker : i});
+	scheduler.add_tasks(batch);
+	BOOST_CHECK(batch.empty());
+	scheduler.add_affine_task([&done] { ++done; }, 3);
+	scheduler.add_task([&done] { ++done; });
+	for (int i = 0; i != 10000 && done != 10; ++i)
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	BOOST_CHECK_EQUAL(done, 10);
+}
+
+BOOST_AUTO_TEST_CASE(test_region_runs_on_its_node)
+{
+	namespace sched = fc::thread;
+	sched::thread_config base;
+	base.nr_of_threads = 1;
+	sched::cycle_control controller{std::make_unique<sched::numa_scheduler>(two_nodes(), base),
+		[](auto& task) { return task.wait_until_done(sched::cycle_control::slow_tick); },
+		std::make_shared<sched::afap_main_loop>()};
+	auto region = std::make_shared<parallel_region>("local", sched::cycle_control::fast_tick);
+	region->set_numa_node(1);
+	std::atomic<int> cycles{0};
+	region->work_tick() >> [&cycles]{ ++cycles; };
+	controller.add_task(sched::periodic_task{region}, sched::cycle_control::fast_tick);
+	auto trace = std::make_shared<sched::trace_recorder>();
+	controller.set_trace(trace);
+
+	controller.start();
+	for (int i = 0; i != 5000 && cycles < 3; ++i)
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	controller.stop();
+	BOOST_CHECK(!controller.last_exception());
+	BOOST_CHECK_GE(cycles, 3);
+
+	const auto snapshot = trace->snapshot();
+	const auto has_thread = [&snapshot](const std::string& name)
+	{
+		return std::any_of(snapshot.threads.begin(), snapshot.threads.end(),
+				[&name](const sched::trace_snapshot::thread_trace& t) { return t.name == name; });
+	};
+	BOOST_CHECK(has_thread("node 1 worker 0"));
+	BOOST_CHECK(!has_thread("node 0 worker 0"));
+}
+
+BOOST_AUTO_TEST_CASE(test_numa_arena)
+{
+	node_arena arena{64, 0};
+	BOOST_CHECK_EQUAL(arena.numa_node(), 0);
+	auto* first = static_cast<char*>(arena.allocate(48, 8));
+	std::fill(first, first + 48, 'x');
+	arena.allocate(48, 8);
+	BOOST_CHECK_EQUAL(arena.nr_of_blocks(), 2);
+
+	auto memory = thread::allocate_on_numa_node(4096, 0);
+	BOOST_REQUIRE(memory);
+	BOOST_CHECK_EQUAL(memory[4095], 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,8 +2,13 @@
 #include <flexcore/scheduler/parallelregion.hpp>
 #include <flexcore/scheduler/cyclecontrol.hpp>
 
+#include <flexcore/scheduler/parallelscheduler.hpp>
+
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <vector>
+
 // Little hack to get access to infrastructure internals
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpragmas"       // tell gcc to ignore the unknown warning below
@@ -76,5 +81,119 @@ BOOST_AUTO_TEST_CASE(test_region_cloning)
 	BOOST_CHECK(region_2_worked);
 }
 
+BOOST_AUTO_TEST_CASE(test_worker_groups)
+{
+	auto region = std::make_shared<fc::parallel_region>("r1", fast_tick);
+	std::vector<int> calls;
+	const auto worker_a = [&calls](int i){ return [&calls, i](){ calls.push_back(i); }; };
+	const auto worker_b = [&calls](int i){ return [&calls, i](){ calls.push_back(-i); }; };
+
+	auto a1 = region->add_worker(worker_a(1));
+	auto b1 = region->add_worker(worker_b(1));
+	auto a2 = region->add_worker(worker_a(2));
+	{
+		auto a3 = region->add_worker(worker_a(3));
+		BOOST_CHECK_EQUAL(region->workers().size(), 4);
+	}
+	BOOST_CHECK_EQUAL(region->workers().size(), 3);
+
+	parallel_tester::work_tick(region);
+	// workers of the same type run together in the order they were added.
+	BOOST_CHECK((calls == std::vector<int>{1, 2, -1}));
+
+	calls.clear();
+	a1.reset();
+	parallel_tester::work_tick(region);
+	BOOST_CHECK((calls == std::vector<int>{2, -1}));
+}
+
+BOOST_AUTO_TEST_CASE(test_parallel_worker_groups)
+{
+	fc::thread::thread_config config{};
+	config.nr_of_threads = 4;
+	fc::thread::parallel_scheduler pool{config};
+
+	auto region = std::make_shared<fc::parallel_region>("r1", fast_tick);
+	region->workers().set_parallel_policy(fc::actions::parallel_policy{&pool, 100, 10});
+
+	std::vector<int> counters(1000, 0);
+	std::vector<fc::worker_handle> handles;
+	for (auto& counter : counters)
+		handles.push_back(region->add_worker([&counter](){ ++counter; }));
+
+	for (int i = 0; i != 3; ++i)
+		parallel_tester::work_tick(region);
+	BOOST_CHECK(std::all_of(counters.begin(), counters.end(), [](int c){ return c == 3; }));
+	pool.stop();
+}
+
+BOOST_AUTO_TEST_CASE(test_small_parallel_worker_groups)
+{
+	fc::thread::thread_config config{};
+	config.nr_of_threads = 4;
+	fc::thread::parallel_scheduler pool{config};
+
+	// less workers than wanted chunks of the smallest size.
+	auto region = std::make_shared<fc::parallel_region>("r1", fast_tick);
+	region->workers().set_parallel_policy(fc::actions::parallel_policy{&pool, 2, 1});
+
+	std::vector<int> counters(20, 0);
+	std::vector<fc::worker_handle> handles;
+	for (auto& counter : counters)
+		handles.push_back(region->add_worker([&counter](){ ++counter; }));
+
+	for (int i = 0; i != 3; ++i)
+		parallel_tester::work_tick(region);
+	BOOST_CHECK(std::all_of(counters.begin(), counters.end(), [](int c){ return c == 3; }));
+	pool.stop();
+}
+
+
+namespace
+{
+/// records its switches, like a buffer of a connection.
+template<int kind>
+struct switch_recorder
+{
+	void switch_active_buffers() { calls->push_back(kind); }
+	void switch_passive_buffers() { calls->push_back(-kind); }
+	void switch_active_passive_buffers() { calls->push_back(10 * kind); }
+	std::vector<int>* calls;
+};
+}
+
+BOOST_AUTO_TEST_CASE(test_buffer_switches)
+{
+	using phase = fc::switch_registry::phase;
+	auto region = std::make_shared<fc::parallel_region>("r1", fast_tick);
+	std::vector<int> calls;
+	switch_recorder<1> a{&calls};
+	switch_recorder<2> b{&calls};
+	switch_recorder<3> c{&calls};
+
+	auto a_active = region->add_switch(a, phase::active);
+	auto b_both = region->add_switch(b, phase::active_passive);
+	auto a_passive = region->add_switch(a, phase::passive);
+	{
+		auto c_active = region->add_switch(c, phase::active);
+		BOOST_CHECK_EQUAL(region->buffer_switches().size(), 4);
+	}
+	BOOST_CHECK_EQUAL(region->buffer_switches().size(), 3);
+
+	parallel_tester::switch_tick(region);
+	std::sort(calls.begin(), calls.end());
+	BOOST_CHECK((calls == std::vector<int>{-1, 1, 20}));
+
+	calls.clear();
+	a_active.reset();
+	b_both = fc::switch_handle{};
+	parallel_tester::switch_tick(region);
+	BOOST_CHECK((calls == std::vector<int>{-1}));
+
+	// handles may outlive the region.
+	region.reset();
+	a_passive.reset();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -9,7 +9,12 @@
 #include <flexcore/scheduler/parallelscheduler.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 using namespace fc;
 
@@ -127,4 +132,164 @@ BOOST_AUTO_TEST_CASE(test_main_loop)
 
 }
 
+BOOST_AUTO_TEST_CASE(test_thread_config)
+{
+	thread::thread_config config;
+	config.nr_of_threads = 3;
+	config.cpu_cores = {0};
+
+	std::atomic<int> counter{0};
+	{
+		thread::parallel_scheduler scheduler{config};
+		BOOST_CHECK_EQUAL(scheduler.nr_of_threads(), 3);
+		for (int i = 0; i != 10; ++i)
+			scheduler.add_task([&counter]{ ++counter; });
+		while (counter != 10)
+			std::this_thread::yield();
+	}
+	BOOST_CHECK_EQUAL(counter, 10);
+
+	thread::parallel_scheduler default_scheduler;
+	BOOST_CHECK_EQUAL(default_scheduler.nr_of_threads(),
+			static_cast<size_t>(thread::parallel_scheduler::num_threads()));
+}
+
+BOOST_AUTO_TEST_CASE(test_add_tasks_batch)
+{
+	thread::thread_config config;
+	config.nr_of_threads = 3;
+	thread::parallel_scheduler scheduler{config};
+
+	std::atomic<int> counter{0};
+	std::vector<thread::scheduler::affine_task> batch;
+	for (int i = 0; i != 100; ++i)
+		batch.push_back({[&counter]{ ++counter; }, thread::scheduler::any_worker});
+	scheduler.add_tasks(batch);
+	BOOST_CHECK(batch.empty());
+
+	while (counter != 100)
+		std::this_thread::yield();
+	BOOST_CHECK_EQUAL(scheduler.nr_of_waiting_tasks(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_priority_order)
+{
+	thread::thread_config config;
+	config.nr_of_threads = 1;
+	thread::parallel_scheduler scheduler{config};
+
+	std::atomic<bool> release{false};
+	std::atomic<bool> blocked{false};
+	scheduler.add_task([&]
+	{
+		blocked = true;
+		while (!release)
+			std::this_thread::yield();
+	});
+	while (!blocked)
+		std::this_thread::yield();
+
+	std::mutex order_mutex;
+	std::vector<int> order;
+	std::atomic<int> executed{0};
+	std::vector<thread::scheduler::affine_task> batch;
+	for (int priority : {0, 5, 1, 5})
+		batch.push_back({[&, priority]
+			{
+				std::lock_guard<std::mutex> lock(order_mutex);
+				order.push_back(priority);
+				++executed;
+			}, thread::scheduler::any_worker, priority});
+	scheduler.add_tasks(batch);
+	release = true;
+
+	while (executed != 4)
+		std::this_thread::yield();
+	std::lock_guard<std::mutex> lock(order_mutex);
+	const std::vector<int> expected{5, 5, 1, 0};
+	BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(test_claimed_tasks_yield_to_priority)
+{
+	thread::thread_config config;
+	config.nr_of_threads = 1;
+	thread::parallel_scheduler scheduler{config};
+
+	std::atomic<bool> release{false};
+	std::atomic<bool> blocked{false};
+	std::mutex order_mutex;
+	std::vector<int> order;
+	std::atomic<int> executed{0};
+	const auto record = [&](int priority)
+	{
+		std::lock_guard<std::mutex> lock(order_mutex);
+		order.push_back(priority);
+		++executed;
+	};
+	// the only worker claims the whole batch at once and blocks in its first task.
+	std::vector<thread::scheduler::affine_task> batch;
+	batch.push_back({[&]
+		{
+			blocked = true;
+			while (!release)
+				std::this_thread::yield();
+			record(0);
+		}, thread::scheduler::any_worker, 0});
+	for (int i = 0; i != 2; ++i)
+		batch.push_back({[&] { record(0); }, thread::scheduler::any_worker, 0});
+	scheduler.add_tasks(batch);
+	while (!blocked)
+		std::this_thread::yield();
+	// claimed tasks still wait for a worker.
+	BOOST_CHECK_EQUAL(scheduler.nr_of_waiting_tasks(), 2);
+
+	batch.push_back({[&] { record(5); }, thread::scheduler::any_worker, 5});
+	scheduler.add_tasks(batch);
+	BOOST_CHECK_EQUAL(scheduler.nr_of_waiting_tasks(), 3);
+	release = true;
+
+	while (executed != 4)
+		std::this_thread::yield();
+	std::lock_guard<std::mutex> lock(order_mutex);
+	const std::vector<int> expected{0, 5, 0, 0};
+	BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+	BOOST_CHECK_EQUAL(scheduler.nr_of_waiting_tasks(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_idle_spin)
+{
+	thread::thread_config config;
+	config.nr_of_threads = 2;
+	config.idle_spin = std::chrono::milliseconds(10);
+	thread::parallel_scheduler scheduler{config};
+
+	std::atomic<int> executed{0};
+	for (int round = 0; round != 3; ++round)
+	{
+		// tasks added while workers spin as well as after they went to sleep.
+		if (round == 2)
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		std::vector<thread::scheduler::affine_task> batch;
+		for (int i = 0; i != 4; ++i)
+			batch.push_back({[&executed] { ++executed; }, thread::scheduler::any_worker, 0});
+		scheduler.add_tasks(batch);
+		scheduler.add_task([&executed] { ++executed; });
+		while (executed != 5 * (round + 1))
+			std::this_thread::yield();
+	}
+	BOOST_CHECK_EQUAL(executed, 15);
+	BOOST_CHECK_EQUAL(scheduler.nr_of_waiting_tasks(), 0);
+	// stopping does not wait for the spin to end.
+	scheduler.stop();
+}
+
+BOOST_AUTO_TEST_CASE(test_invalid_thread_config)
+{
+	thread::thread_config config;
+	config.nr_of_threads = 1;
+	config.cpu_cores = {-1}; // no valid cpu core
+	BOOST_CHECK_THROW(thread::parallel_scheduler{config}, std::system_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,136 @@
+#include <flexcore/extended/base_node.hpp>
+#include <flexcore/extended/nodes/terminal.hpp>
+#include <flexcore/ports.hpp>
+#include <flexcore/scheduler/cyclecontrol.hpp>
+#include <flexcore/scheduler/parallelscheduler.hpp>
+#include <flexcore/scheduler/realtime_checks.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace fc;
+
+BOOST_AUTO_TEST_SUITE(test_realtime_checks)
+
+namespace
+{
+std::shared_ptr<thread::realtime_checks> make_checks()
+{
+	// no logging in tests, violations are inspected directly.
+	return std::make_shared<thread::realtime_checks>([](const thread::realtime_violation&) {});
+}
+}
+
+BOOST_AUTO_TEST_CASE(test_hooks_installed)
+{
+	// tests/CMakeLists.txt links the hooks, builds without them detect nothing.
+	BOOST_WARN(thread::realtime_checks::hooks_installed());
+}
+
+BOOST_AUTO_TEST_CASE(test_allocation_names_node)
+{
+	graph::connection_graph graph;
+	graph.enable_node_tracking();
+	BOOST_CHECK(graph.tracks_nodes());
+	const auto region = std::make_shared<parallel_region>("control",
+			thread::cycle_control::fast_tick);
+	region->set_realtime(true);
+	forest_owner forest{graph, "forest", region};
+	auto& terminal = forest.nodes().make_child_named<event_terminal<int>>("terminal");
+	std::vector<std::unique_ptr<int>> values;
+	pure::event_sink<int> allocating{[&](int v) { values.push_back(std::make_unique<int>(v)); }};
+	terminal.out() >> allocating;
+	region->ticks.work_tick() >> [&]() { terminal.in()(1); };
+
+	thread::cycle_control controller{std::make_unique<thread::parallel_scheduler>()};
+	const auto checks = make_checks();
+	controller.enable_realtime_checks(checks);
+	BOOST_CHECK_EQUAL(controller.get_realtime_checks(), checks);
+	controller.add_task(thread::periodic_task{region}, thread::cycle_control::fast_tick);
+	controller.warm_up(1);
+
+	BOOST_CHECK_EQUAL(values.size(), 1);
+	if (!thread::realtime_checks::hooks_installed())
+		return;
+	BOOST_CHECK_GE(checks->nr_of_violations(), 1);
+	const auto violations = checks->violations();
+	BOOST_REQUIRE(!violations.empty());
+	const auto& first = violations.front();
+	BOOST_CHECK(first.what == thread::realtime_violation::kind::allocation);
+	BOOST_CHECK_EQUAL(first.task, "control");
+	BOOST_CHECK_EQUAL(first.node, terminal.full_name());
+	BOOST_CHECK_GT(first.bytes, 0);
+	BOOST_CHECK_NE(thread::to_string(first).find(terminal.full_name()), std::string::npos);
+
+	checks->clear();
+	BOOST_CHECK_EQUAL(checks->nr_of_violations(), 0);
+	BOOST_CHECK(checks->violations().empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_lock)
+{
+	thread::cycle_control controller{std::make_unique<thread::parallel_scheduler>()};
+	const auto checks = make_checks();
+	controller.enable_realtime_checks(checks);
+	std::mutex mutex;
+	int count = 0;
+	thread::periodic_task locking{[&]
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		++count;
+	}};
+	locking.set_realtime(true);
+	BOOST_CHECK(locking.is_realtime());
+	controller.add_task(std::move(locking), thread::cycle_control::fast_tick);
+	controller.warm_up(2);
+
+	BOOST_CHECK_EQUAL(count, 2);
+	if (!thread::realtime_checks::hooks_installed())
+		return;
+	const auto violations = checks->violations();
+	BOOST_REQUIRE_EQUAL(violations.size(), 2);
+	BOOST_CHECK(violations[0].what == thread::realtime_violation::kind::lock);
+	BOOST_CHECK_EQUAL(violations[0].task, "task");
+	BOOST_CHECK(violations[0].node.empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_clean_task)
+{
+	thread::cycle_control controller{std::make_unique<thread::parallel_scheduler>()};
+	const auto checks = make_checks();
+	controller.enable_realtime_checks(checks);
+	std::atomic<int> count{0};
+	thread::periodic_task clean{[&] { ++count; }};
+	clean.set_realtime(true);
+	controller.add_task(std::move(clean), thread::cycle_control::fast_tick);
+	controller.warm_up(3);
+
+	BOOST_CHECK_EQUAL(count, 3);
+	BOOST_CHECK_EQUAL(checks->nr_of_violations(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_only_realtime_tasks)
+{
+	thread::cycle_control controller{std::make_unique<thread::parallel_scheduler>()};
+	const auto checks = make_checks();
+	std::vector<std::unique_ptr<int>> values;
+	const auto region = std::make_shared<parallel_region>("best effort",
+			thread::cycle_control::fast_tick);
+	region->ticks.work_tick() >> [&]() { values.push_back(std::make_unique<int>(1)); };
+	thread::periodic_task task{region};
+	// the region takes precedence over the task.
+	task.set_realtime(true);
+	BOOST_CHECK(!task.is_realtime());
+	controller.add_task(std::move(task), thread::cycle_control::fast_tick);
+	// checks enabled after the task is added apply to it as well.
+	controller.enable_realtime_checks(checks);
+	controller.warm_up(2);
+
+	BOOST_CHECK_EQUAL(values.size(), 2);
+	BOOST_CHECK_EQUAL(checks->nr_of_violations(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
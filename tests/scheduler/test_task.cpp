@@ -0,0 +1,71 @@
+#include <flexcore/scheduler/task.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <functional>
+#include <memory>
+
+using fc::thread::unique_task;
+
+BOOST_AUTO_TEST_SUITE(test_task)
+
+BOOST_AUTO_TEST_CASE(test_empty_task)
+{
+	unique_task task;
+	BOOST_CHECK(!task);
+	unique_task null_task{nullptr};
+	BOOST_CHECK(!null_task);
+}
+
+BOOST_AUTO_TEST_CASE(test_call_and_move)
+{
+	int counter = 0;
+	unique_task task{[&counter]{ ++counter; }};
+	BOOST_CHECK(task);
+	task();
+	BOOST_CHECK_EQUAL(counter, 1);
+
+	unique_task moved{std::move(task)};
+	BOOST_CHECK(!task);
+	moved();
+	BOOST_CHECK_EQUAL(counter, 2);
+
+	task = std::move(moved);
+	BOOST_CHECK(!moved);
+	task();
+	BOOST_CHECK_EQUAL(counter, 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_move_only_callable)
+{
+	auto value = std::make_unique<int>(0);
+	int* observed = value.get();
+	unique_task task{[v = std::move(value)]{ ++*v; }};
+	task();
+	unique_task other{std::move(task)};
+	other();
+	BOOST_CHECK_EQUAL(*observed, 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_callable_destroyed)
+{
+	auto shared = std::make_shared<int>(0);
+	{
+		unique_task task{[shared]{}};
+		BOOST_CHECK_EQUAL(shared.use_count(), 2);
+		unique_task other;
+		other = std::move(task);
+		BOOST_CHECK_EQUAL(shared.use_count(), 2);
+	}
+	BOOST_CHECK_EQUAL(shared.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_std_function_fits)
+{
+	int counter = 0;
+	std::function<void()> fun = [&counter]{ ++counter; };
+	unique_task task{fun};
+	task();
+	BOOST_CHECK_EQUAL(counter, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,148 @@
+#include <flexcore/scheduler/timer_service.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+#include <flexcore/extended/nodes/timer.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "nodes/owning_node.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace fc;
+
+BOOST_AUTO_TEST_SUITE(test_timer_service)
+
+namespace
+{
+using std::chrono::milliseconds;
+using time_point = timer_service::time_point;
+
+time_point at(int64_t ms) { return time_point{milliseconds(ms)}; }
+}
+
+BOOST_AUTO_TEST_CASE(test_fires_at_first_tick_after_expiry)
+{
+	timer_service timers{milliseconds(10), at(0)};
+	std::vector<int> fired;
+	timers.schedule_at(at(350), [&fired]() { fired.push_back(350); });
+	timers.schedule_at(at(355), [&fired]() { fired.push_back(355); });
+	const auto cancelled = timers.schedule_at(at(100), [&fired]() { fired.push_back(100); });
+	BOOST_CHECK_EQUAL(timers.nr_of_timers(), 3);
+	BOOST_CHECK(timers.cancel(cancelled));
+	BOOST_CHECK(!timers.cancel(cancelled));
+
+	timers.advance_to(at(340));
+	BOOST_CHECK(fired.empty());
+	timers.advance_to(at(350));
+	BOOST_CHECK((fired == std::vector<int>{350}));
+	// expiries between ticks are rounded up.
+	timers.advance_to(at(360));
+	BOOST_CHECK((fired == std::vector<int>{350, 355}));
+	BOOST_CHECK_EQUAL(timers.nr_of_timers(), 0);
+
+	BOOST_CHECK_THROW(timer_service(milliseconds(0)), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_actions_reschedule)
+{
+	timer_service timers{milliseconds(10), at(0)};
+	int periods = 0;
+	std::function<void()> periodic = [&]()
+	{
+		if (++periods != 5)
+			timers.schedule_at(at(100 * (periods + 1)), periodic);
+	};
+	timers.schedule_at(at(100), periodic);
+	auto late = timers.schedule_at(at(250), []() { BOOST_FAIL("cancelled timer fired"); });
+	// timers due in the current tick fire on the next one.
+	timer_service::timer_id early;
+	timers.schedule_at(at(200), [&]() { timers.cancel(late); early = timers.schedule_at(at(0), []{}); });
+
+	timers.advance_to(at(200));
+	BOOST_CHECK(timers.is_scheduled(early));
+	timers.advance_to(at(2000));
+	BOOST_CHECK_EQUAL(periods, 5);
+	BOOST_CHECK(!timers.is_scheduled(early));
+	BOOST_CHECK_EQUAL(timers.nr_of_timers(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_random_timers)
+{
+	// covers all levels of the wheel, including timers beyond its range.
+	timer_service timers{milliseconds(1), at(0)};
+	std::mt19937 random{42};
+	std::uniform_int_distribution<int64_t> expiry{0, int64_t(1) << 26};
+	std::vector<int64_t> expiries;
+	std::vector<int64_t> fired_at;
+	int64_t now = 0;
+	for (int i = 0; i != 2000; ++i)
+	{
+		expiries.push_back(i < 100 ? i : expiry(random));
+		fired_at.push_back(-1);
+		timers.schedule_at(at(expiries.back()), [&fired_at, &now, i]()
+		{
+			BOOST_CHECK_EQUAL(fired_at[i], -1);
+			fired_at[i] = now;
+		});
+	}
+	std::uniform_int_distribution<int64_t> step{1, 1 << 12};
+	std::vector<int64_t> advances;
+	while (timers.nr_of_timers() != 0)
+	{
+		now += step(random);
+		advances.push_back(now);
+		timers.advance_to(at(now));
+	}
+	// every timer fired at the first advance at or after its expiry.
+	for (size_t i = 0; i != expiries.size(); ++i)
+	{
+		const auto first = std::lower_bound(advances.begin(), advances.end(), expiries[i]);
+		BOOST_REQUIRE(first != advances.end());
+		BOOST_CHECK_EQUAL(fired_at[i], *first);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_one_shot_timer_node)
+{
+	auto region = std::make_shared<parallel_region>("timers", thread::cycle_control::fast_tick);
+	tests::owning_node owner(region);
+	auto& timer = owner.make_child_named<one_shot_timer>("timeout");
+	pure::event_source<virtual_clock::steady::duration> start;
+	pure::event_source<void> cancel;
+	int expired = 0;
+	pure::event_sink<void> sink{[&expired]() { ++expired; }};
+	start >> timer.in_start();
+	cancel >> timer.in_cancel();
+	timer.out() >> sink;
+
+	const auto cycle = [&region]()
+	{
+		master_clock<std::centi>::advance();
+		region->ticks.in_work()();
+	};
+	// other tests may have left the virtual clock between two ticks.
+	const auto tick = thread::cycle_control::fast_tick;
+	const auto offset = virtual_clock::steady::now().time_since_epoch() % tick;
+	if (offset != virtual_clock::steady::duration::zero())
+		master_clock<std::centi>::advance(tick - offset);
+
+	start.fire(std::chrono::milliseconds(35));
+	BOOST_CHECK(timer.running());
+	for (int i = 0; i != 3; ++i)
+		cycle();
+	BOOST_CHECK_EQUAL(expired, 0);
+	cycle();
+	BOOST_CHECK_EQUAL(expired, 1);
+	BOOST_CHECK(!timer.running());
+
+	start.fire(std::chrono::milliseconds(10));
+	cancel.fire();
+	cycle();
+	cycle();
+	BOOST_CHECK_EQUAL(expired, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
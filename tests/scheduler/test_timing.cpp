@@ -0,0 +1,74 @@
+#include <flexcore/scheduler/cyclecontrol.hpp>
+#include <flexcore/scheduler/parallelscheduler.hpp>
+#include <flexcore/scheduler/timing.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <numeric>
+#include <thread>
+
+using namespace fc;
+using thread::duration_histogram;
+
+BOOST_AUTO_TEST_SUITE(test_timing)
+
+BOOST_AUTO_TEST_CASE(test_histogram_buckets)
+{
+	using std::chrono::microseconds;
+	BOOST_CHECK_EQUAL(duration_histogram::bucket_of(std::chrono::nanoseconds(500)), 0);
+	BOOST_CHECK_EQUAL(duration_histogram::bucket_of(microseconds(1)), 1);
+	BOOST_CHECK_EQUAL(duration_histogram::bucket_of(microseconds(3)), 2);
+	BOOST_CHECK_EQUAL(duration_histogram::bucket_of(microseconds(1024)), 11);
+	BOOST_CHECK_EQUAL(duration_histogram::bucket_of(std::chrono::hours(1000)),
+			duration_histogram::nr_of_buckets - 1);
+
+	for (size_t i = 0; i + 1 != duration_histogram::nr_of_buckets; ++i)
+	{
+		const auto bound = thread::histogram_snapshot::upper_bound(i);
+		BOOST_CHECK_EQUAL(duration_histogram::bucket_of(bound), i + 1);
+		BOOST_CHECK_EQUAL(duration_histogram::bucket_of(bound - microseconds(1)), i);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_histogram_snapshot)
+{
+	duration_histogram histogram;
+	histogram.record(std::chrono::microseconds(10));
+	histogram.record(std::chrono::microseconds(30));
+	histogram.record(-std::chrono::microseconds(5));
+
+	const auto snapshot = histogram.snapshot();
+	BOOST_CHECK_EQUAL(snapshot.count, 3);
+	BOOST_CHECK_EQUAL(std::accumulate(snapshot.buckets.begin(), snapshot.buckets.end(),
+			uint64_t{0}), 3);
+	BOOST_CHECK_EQUAL(snapshot.buckets[0], 1);
+	BOOST_CHECK(snapshot.max == std::chrono::microseconds(30));
+	BOOST_CHECK(snapshot.mean() == std::chrono::nanoseconds(40000) / 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_cycle_control_timing)
+{
+	namespace sched = fc::thread;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>()};
+	auto region = std::make_shared<parallel_region>("timed", sched::cycle_control::fast_tick);
+	region->work_tick() >> []{ std::this_thread::sleep_for(std::chrono::milliseconds(1)); };
+	controller.add_task(sched::periodic_task{region}, sched::cycle_control::fast_tick);
+
+	controller.start();
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	// polling while running needs to be possible
+	const auto running_report = controller.timing();
+	controller.stop();
+
+	BOOST_REQUIRE_EQUAL(running_report.tasks.size(), 1);
+	const auto report = controller.timing();
+	const auto& task = report.tasks.front();
+	BOOST_CHECK_EQUAL(task.name, "timed");
+	BOOST_CHECK(task.tick == sched::cycle_control::fast_tick);
+	BOOST_CHECK_GE(task.execution.count, 1);
+	BOOST_CHECK_EQUAL(task.queueing.count, task.execution.count);
+	BOOST_CHECK(task.execution.max >= std::chrono::milliseconds(1));
+	BOOST_CHECK_GE(report.main_loop_overrun.count, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
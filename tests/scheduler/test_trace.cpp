@@ -0,0 +1,133 @@
+#include <flexcore/scheduler/cyclecontrol.hpp>
+#include <flexcore/scheduler/parallelscheduler.hpp>
+#include <flexcore/scheduler/trace.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace fc;
+
+BOOST_AUTO_TEST_SUITE(test_trace)
+
+namespace
+{
+size_t count(const thread::trace_snapshot& trace, const std::string& name,
+		thread::trace_event::phase kind)
+{
+	size_t result = 0;
+	for (const auto& t : trace.threads)
+		result += std::count_if(t.events.begin(), t.events.end(),
+				[&](const thread::trace_event& e)
+				{
+					return e.kind == kind && trace.names.at(e.name) == name;
+				});
+	return result;
+}
+}
+
+BOOST_AUTO_TEST_CASE(test_rings)
+{
+	using phase = thread::trace_event::phase;
+	thread::trace_recorder flight{4};
+	thread::trace_recorder full{4, thread::trace_recorder::mode::until_full};
+	const auto a = flight.add_name("a");
+	BOOST_CHECK_EQUAL(flight.add_name("a"), a);
+	const auto b = full.add_name("b");
+	flight.name_this_thread("test");
+	for (int i = 0; i != 3; ++i)
+	{
+		flight.begin(a);
+		flight.end(a);
+		full.instant(b);
+		full.instant(b);
+	}
+	std::thread other{[&flight, a]() { flight.instant(a); }};
+	other.join();
+
+	const auto recent = flight.snapshot();
+	BOOST_REQUIRE_EQUAL(recent.threads.size(), 2);
+	BOOST_CHECK_EQUAL(recent.threads[0].name, "test");
+	// the flight recorder keeps the newest events but the one which is written next.
+	BOOST_REQUIRE_EQUAL(recent.threads[0].events.size(), 3);
+	BOOST_CHECK(recent.threads[0].events.back().kind == phase::end);
+	BOOST_CHECK(recent.threads[1].events.front().kind == phase::instant);
+	BOOST_CHECK(std::is_sorted(recent.threads[0].events.begin(), recent.threads[0].events.end(),
+			[](const thread::trace_event& l, const thread::trace_event& r)
+			{
+				return l.time < r.time;
+			}));
+
+	BOOST_CHECK_EQUAL(full.snapshot().threads.at(0).events.size(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_chrome_trace)
+{
+	thread::trace_recorder trace{4};
+	const auto slice = trace.add_name("slice \"quoted\"");
+	trace.begin(slice);
+	trace.end(slice);
+	trace.instant(slice);
+	trace.end(slice);
+	trace.instant(slice);
+	// the oldest begin is cut off, its end is left out.
+
+	std::ostringstream out;
+	thread::write_chrome_trace(out, trace.snapshot());
+	const auto json = out.str();
+	BOOST_CHECK_EQUAL(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0);
+	BOOST_CHECK(json.find("\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"thread 1\"}")
+			!= std::string::npos);
+	BOOST_CHECK(json.find("\"name\":\"slice \\\"quoted\\\"\",\"cat\":\"flexcore\",\"ph\":\"i\"")
+			!= std::string::npos);
+	BOOST_CHECK(json.find("\"ph\":\"E\"") == std::string::npos);
+	BOOST_CHECK(json.find("\"s\":\"t\"") != std::string::npos);
+	BOOST_CHECK_EQUAL(json.substr(json.size() - 3), "]}\n");
+}
+
+BOOST_AUTO_TEST_CASE(test_cycle_control_timeline)
+{
+	namespace sched = fc::thread;
+	sched::thread_config config;
+	config.nr_of_threads = 2;
+	sched::cycle_control controller{std::make_unique<sched::parallel_scheduler>(config),
+		[](auto& task) { return task.wait_until_done(sched::cycle_control::slow_tick); },
+		std::make_shared<sched::afap_main_loop>()};
+	auto region = std::make_shared<parallel_region>("traced", sched::cycle_control::fast_tick);
+	region->work_tick() >> []{};
+	controller.add_task(sched::periodic_task{region}, sched::cycle_control::fast_tick);
+
+	auto trace = std::make_shared<sched::trace_recorder>();
+	controller.set_trace(trace);
+	auto late = std::make_shared<parallel_region>("late", sched::cycle_control::medium_tick);
+	late->work_tick() >> []{};
+	controller.add_task(sched::periodic_task{late}, sched::cycle_control::medium_tick);
+
+	controller.start();
+	BOOST_CHECK_THROW(controller.set_trace(nullptr), std::runtime_error);
+	for (int i = 0; i != 5000 && count(trace->snapshot(), "late",
+			sched::trace_event::phase::end) < 2; ++i)
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	controller.stop();
+	BOOST_CHECK(!controller.last_exception());
+
+	using phase = sched::trace_event::phase;
+	const auto snapshot = trace->snapshot();
+	BOOST_CHECK_GE(count(snapshot, "late", phase::end), 2);
+	BOOST_CHECK_GE(count(snapshot, "traced", phase::begin), 2);
+	BOOST_CHECK_GE(count(snapshot, "switch tick traced", phase::instant), 2);
+	BOOST_CHECK_GE(count(snapshot, "main loop cycle", phase::begin), 2);
+	BOOST_CHECK_GE(count(snapshot, "wait for tasks", phase::end), 2);
+	BOOST_CHECK_GE(count(snapshot, "run tasks", phase::begin), 2);
+	const auto has_thread = [&snapshot](const std::string& name)
+	{
+		return std::any_of(snapshot.threads.begin(), snapshot.threads.end(),
+				[&name](const sched::trace_snapshot::thread_trace& t) { return t.name == name; });
+	};
+	BOOST_CHECK(has_thread("main loop"));
+	BOOST_CHECK(has_thread("worker 0") || has_thread("worker 1"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,146 @@
+#include <flexcore/scheduler/cyclecontrol.hpp>
+#include <flexcore/scheduler/workstealingscheduler.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+
+using namespace fc;
+
+namespace
+{
+std::unique_ptr<thread::cycle_control> make_work_stealing_cycle_control()
+{
+	return std::make_unique<thread::cycle_control>(
+			std::make_unique<thread::work_stealing_scheduler>());
+}
+}
+
+BOOST_AUTO_TEST_SUITE(test_work_stealing_scheduler)
+
+BOOST_AUTO_TEST_CASE(test_all_tasks_executed)
+{
+	constexpr int nr_of_tasks{1000};
+	std::atomic<int> counter{0};
+	{
+		thread::work_stealing_scheduler scheduler;
+		for (int i = 0; i != nr_of_tasks; ++i)
+			scheduler.add_task([&counter]{ ++counter; });
+
+		while (counter != nr_of_tasks)
+			std::this_thread::yield();
+		BOOST_CHECK_EQUAL(scheduler.nr_of_waiting_tasks(), 0);
+	}
+	BOOST_CHECK_EQUAL(counter, nr_of_tasks);
+}
+
+BOOST_AUTO_TEST_CASE(test_blocked_worker_tasks_are_stolen)
+{
+	thread::thread_config two_workers;
+	two_workers.nr_of_threads = 2;
+	thread::work_stealing_scheduler scheduler{two_workers};
+	std::atomic<bool> release{false};
+	std::atomic<int> counter{0};
+	// block one worker, the tasks queued behind it need to be stolen by others.
+	scheduler.add_task([&release]{ while (!release) std::this_thread::yield(); });
+	for (int i = 0; i != 100; ++i)
+		scheduler.add_task([&counter]{ ++counter; });
+
+	while (counter != 100)
+		std::this_thread::yield();
+	release = true;
+	BOOST_CHECK_EQUAL(counter, 100);
+}
+
+BOOST_AUTO_TEST_CASE(test_helper_going_to_sleep_is_woken)
+{
+	thread::thread_config two_workers;
+	two_workers.nr_of_threads = 2;
+	thread::work_stealing_scheduler scheduler{two_workers};
+	// the helper just went idle in every round, a wake up might reach it before it sleeps.
+	for (int round = 0; round != 200; ++round)
+	{
+		std::atomic<bool> release{false};
+		std::atomic<bool> blocking{false};
+		std::atomic<bool> stolen{false};
+		std::atomic<bool> done{false};
+		scheduler.add_affine_task([&]
+		{
+			blocking = true;
+			while (!release)
+				std::this_thread::yield();
+			done = true;
+		}, 0);
+		while (!blocking)
+			std::this_thread::yield();
+		scheduler.add_affine_task([&stolen]{ stolen = true; }, 0);
+
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+		while (!stolen && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::yield();
+		const bool stolen_in_time = stolen;
+		release = true;
+		// both tasks refer to this round, the blocked worker runs the second itself otherwise.
+		while (!done || !stolen)
+			std::this_thread::yield();
+		BOOST_REQUIRE(stolen_in_time);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_add_tasks_batch)
+{
+	thread::thread_config two_workers;
+	two_workers.nr_of_threads = 2;
+	thread::work_stealing_scheduler scheduler{two_workers};
+
+	std::atomic<int> counter{0};
+	std::vector<thread::scheduler::affine_task> batch;
+	for (size_t i = 0; i != 100; ++i)
+		batch.push_back({[&counter]{ ++counter; }, i % 3});
+	scheduler.add_tasks(batch);
+	BOOST_CHECK(batch.empty());
+
+	while (counter != 100)
+		std::this_thread::yield();
+	BOOST_CHECK_EQUAL(scheduler.nr_of_waiting_tasks(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_affine_tasks_stay_on_worker)
+{
+	thread::thread_config two_workers;
+	two_workers.nr_of_threads = 2;
+	thread::work_stealing_scheduler scheduler{two_workers};
+	std::set<std::thread::id> executing_threads;
+	for (int i = 0; i != 20; ++i)
+	{
+		std::atomic<bool> done{false};
+		scheduler.add_affine_task([&]
+		{
+			executing_threads.insert(std::this_thread::get_id());
+			done = true;
+		}, 1);
+		while (!done)
+			std::this_thread::yield();
+	}
+	// the other worker is idle, it has no reason to take tasks of worker 1.
+	BOOST_CHECK_EQUAL(executing_threads.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_cycle_control_with_work_stealing)
+{
+	auto controller = make_work_stealing_cycle_control();
+	std::atomic<int> counter{0};
+	for (int i = 0; i != 20; ++i)
+		controller->add_task(thread::periodic_task{[&counter]{ ++counter; }},
+				thread::cycle_control::fast_tick);
+
+	controller->work();
+	while (counter != 20)
+		std::this_thread::yield();
+	controller->stop();
+	BOOST_CHECK_EQUAL(counter, 20);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
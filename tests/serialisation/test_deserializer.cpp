@@ -6,6 +6,7 @@
 #include <boost/mpl/list.hpp>
 
 #include <limits>
+#include <stdexcept>
 #include <vector>
 #include <iostream>
 
@@ -150,4 +151,40 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_archive_types, T, archive_types)
 	round_trip_test<cereal::XMLInputArchive, cereal::XMLOutputArchive>(T{1, 2, 3});
 }
 
+BOOST_AUTO_TEST_CASE(test_buffered_round_trip)
+{
+	auto round_trip = buffered_serializer<std::vector<double>, cereal::BinaryOutputArchive>{}
+			>> span_deserializer<std::vector<double>, cereal::BinaryInputArchive>{};
+
+	const std::vector<double> test_vec = { 0.0, 1.1, 2.2, 3.3 };
+	BOOST_CHECK(round_trip(test_vec) == test_vec);
+	// the buffer is reused, a smaller object does not see the rest of the last one.
+	BOOST_CHECK(round_trip(std::vector<double>{4.4}) == std::vector<double>{4.4});
+}
+
+BOOST_AUTO_TEST_CASE(test_buffered_serializer_reuses_buffer)
+{
+	buffered_serializer<std::vector<int>, cereal::BinaryOutputArchive> serializer;
+	const auto first = serializer(std::vector<int>(100, 1));
+	const auto second = serializer(std::vector<int>(50, 2));
+	BOOST_CHECK(first.data == second.data);
+	BOOST_CHECK_LT(second.size, first.size);
+}
+
+BOOST_AUTO_TEST_CASE(test_fixed_layout)
+{
+	struct point { int x; double y; };
+	buffered_serializer<point, fixed_layout> serializer;
+	span_deserializer<point, fixed_layout> deserializer;
+
+	const auto bytes = serializer(point{1, 2.5});
+	BOOST_CHECK_EQUAL(bytes.size, sizeof(point));
+	const auto result = deserializer(bytes);
+	BOOST_CHECK_EQUAL(result.x, 1);
+	BOOST_CHECK_EQUAL(result.y, 2.5);
+
+	BOOST_CHECK_THROW(deserializer(const_byte_span{bytes.data, bytes.size - 1}),
+			std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
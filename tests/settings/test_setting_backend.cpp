@@ -1,6 +1,11 @@
 #include <boost/test/unit_test.hpp>
 #include <flexcore/utils/settings/settings.hpp>
 #include <flexcore/utils/settings/settings_backend.hpp>
+#include <flexcore/scheduler/cyclecontrol.hpp>
+#include <flexcore/scheduler/parallelregion.hpp>
+
+#include <memory>
+#include <string>
 
 BOOST_AUTO_TEST_SUITE(test_setting_registry)
 
@@ -135,4 +140,85 @@ BOOST_AUTO_TEST_CASE(test_moving_and_copying)
 	BOOST_CHECK_EQUAL(copy_setting(), 2);
 }
 
+BOOST_AUTO_TEST_CASE(test_region_setting_changes_on_switch_tick)
+{
+	fc::settings_backend backend{};
+	fc::settings_facade facade{backend};
+	auto region = std::make_shared<fc::parallel_region>("region",
+			fc::thread::cycle_control::fast_tick);
+
+	fc::setting<std::string> my_setting =
+			{fc::setting_id{"setting_id"}, facade, *region, std::string{"initial"}};
+	const auto before = my_setting.snapshot();
+	BOOST_CHECK_EQUAL(*before, "initial");
+
+	backend.write(fc::setting_id{"setting_id"}, std::string{"{\"value\": \"first\"" "}"});
+	backend.write(fc::setting_id{"setting_id"}, std::string{"{\"value\": \"second\"" "}"});
+	//new values are only visible after the switch tick of the region.
+	BOOST_CHECK_EQUAL(my_setting(), "initial");
+
+	region->ticks.switch_buffers();
+	BOOST_CHECK_EQUAL(my_setting(), "second");
+
+	region->ticks.switch_buffers();
+	BOOST_CHECK_EQUAL(my_setting(), "second");
+
+	backend.write(fc::setting_id{"setting_id"}, std::string{"{\"value\": \"third\"" "}"});
+	region->ticks.switch_buffers();
+	BOOST_CHECK_EQUAL(my_setting(), "third");
+	//the replaced values stay valid as long as they are held.
+	BOOST_CHECK_EQUAL(*before, "initial");
+}
+
+BOOST_AUTO_TEST_CASE(test_snapshot_outlives_changes)
+{
+	fc::settings_backend backend{};
+	fc::settings_facade facade{backend};
+
+	fc::setting<std::string> my_setting =
+			{fc::setting_id{"setting_id"}, facade, std::string{"initial"}};
+	const auto before = my_setting.snapshot();
+
+	backend.write(fc::setting_id{"setting_id"}, std::string{"{\"value\": \"first\"" "}"});
+	backend.write(fc::setting_id{"setting_id"}, std::string{"{\"value\": \"second\"" "}"});
+	BOOST_CHECK_EQUAL(my_setting(), "second");
+	BOOST_CHECK_EQUAL(*my_setting.snapshot(), "second");
+	BOOST_CHECK_EQUAL(*before, "initial");
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_applied_together_on_switch_tick)
+{
+	fc::settings_backend backend{};
+	fc::settings_facade facade{backend};
+	auto region = std::make_shared<fc::parallel_region>("region",
+			fc::thread::cycle_control::fast_tick);
+	const auto positive = [](auto in){ return in > 0; };
+
+	fc::setting<int> width = {fc::setting_id{"width"}, facade, *region, 1, positive};
+	fc::setting<int> height = {fc::setting_id{"height"}, facade, *region, 1, positive};
+	fc::setting<int> immediate = {fc::setting_id{"immediate"}, facade, 1};
+
+	backend.write({{fc::setting_id{"width"}, "{\"value\": 640" "}"},
+			{fc::setting_id{"height"}, "{\"value\": 480" "}"},
+			{fc::setting_id{"immediate"}, "{\"value\": 2" "}"}});
+	BOOST_CHECK_EQUAL(immediate(), 2);
+	BOOST_CHECK_EQUAL(width(), 1);
+	BOOST_CHECK_EQUAL(height(), 1);
+
+	region->ticks.switch_buffers();
+	BOOST_CHECK_EQUAL(width(), 640);
+	BOOST_CHECK_EQUAL(height(), 480);
+
+	//if one value is invalid, no setting changes.
+	BOOST_CHECK_THROW(backend.write({{fc::setting_id{"width"}, "{\"value\": 800" "}"},
+			{fc::setting_id{"height"}, "{\"value\": -1" "}"}}),
+			fc::setting_constraint_violation);
+	BOOST_CHECK_THROW(backend.write({{fc::setting_id{"width"}, "{\"value\": 800" "}"},
+			{fc::setting_id{"missing"}, "{\"value\": 1" "}"}}),
+			std::out_of_range);
+	region->ticks.switch_buffers();
+	BOOST_CHECK_EQUAL(width(), 640);
+	BOOST_CHECK_EQUAL(height(), 480);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
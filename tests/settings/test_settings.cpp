@@ -85,4 +85,32 @@ BOOST_AUTO_TEST_CASE(test_incorrect_data_type)
 	BOOST_CHECK_THROW(generate_illegal_setting(),cereal::Exception);
 }
 
+BOOST_AUTO_TEST_CASE(test_many_settings_from_json_file)
+{
+	std::stringstream ss;
+	ss << "{ \"nested\": { \"a\": [1, {\"b\": \"}\"}], \"c\": null }";
+	for (int i = 0; i != 1000; ++i)
+		ss << ", \"setting_" << i << "\": " << i;
+	ss << ", \"name\": \"with \\\"quotes\\\"\" }";
+
+	json_file_setting_facade backend{ss};
+
+	for (int i = 0; i < 1000; i += 111)
+	{
+		setting<int> int_setting =
+				{setting_id{"setting_" + std::to_string(i)}, backend, -1};
+		BOOST_CHECK_EQUAL(int_setting(), i);
+	}
+
+	setting<std::string> name_setting = {setting_id{"name"}, backend, ""};
+	BOOST_CHECK_EQUAL(name_setting(), "with \"quotes\"");
+
+	auto missing_setting = [&backend]()
+	{
+		setting<int> missing = {setting_id{"missing"}, backend, 0};
+		return missing();
+	};
+	BOOST_CHECK_THROW(missing_setting(), cereal::Exception);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,10 @@
 #include <flexcore/utils/settings/jsonfile_setting_backend.hpp>
 #include <flexcore/ports.hpp>
 
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 using namespace fc;
 
 BOOST_AUTO_TEST_SUITE(test_generic_container)
@@ -19,6 +23,62 @@ BOOST_AUTO_TEST_CASE(test_storage)
 	source.fire(3);
 }
 
+BOOST_AUTO_TEST_CASE(test_typed_storage)
+{
+	typed_container tc;
+	pure::event_source<int> source;
+	int sum = 0;
+
+	std::vector<pure::event_sink<int>*> sinks;
+	for (int i = 0; i != 100; ++i)
+	{
+		auto& sink = tc.add<pure::event_sink<int>>([&sum](int in){ sum += in; });
+		source >> sink;
+		sinks.push_back(&sink);
+		tc.add<std::string>("name");
+	}
+	BOOST_CHECK_EQUAL(tc.size(), 200);
+	// objects of a type share a chunk, until it is full.
+	BOOST_CHECK_EQUAL(sinks[1], sinks[0] + 1);
+
+	source.fire(2);
+	BOOST_CHECK_EQUAL(sum, 200);
+}
+
+namespace
+{
+struct tracked
+{
+	tracked(std::vector<int>& destroyed, int id) : destroyed(destroyed), id(id)
+	{
+		if (id < 0)
+			throw std::invalid_argument("negative id");
+	}
+	~tracked() { destroyed.push_back(id); }
+	std::vector<int>& destroyed;
+	int id;
+};
+}
+
+BOOST_AUTO_TEST_CASE(test_typed_destruction)
+{
+	std::vector<int> destroyed;
+	{
+		typed_container tc;
+		for (int i = 0; i != 20; ++i)
+			tc.add<tracked>(destroyed, i);
+		BOOST_CHECK_THROW(tc.add<tracked>(destroyed, -1), std::invalid_argument);
+		BOOST_CHECK_EQUAL(tc.size(), 20);
+		BOOST_CHECK_EQUAL(tc.add<tracked>(destroyed, 20).id, 20);
+		BOOST_CHECK(destroyed.empty());
+	}
+	std::vector<int> expected;
+	for (int i = 20; i >= 0; --i)
+		expected.push_back(i);
+	BOOST_CHECK_EQUAL_COLLECTIONS(destroyed.begin(), destroyed.end(),
+			expected.begin(), expected.end());
+}
+
 BOOST_AUTO_TEST_CASE(test_setting_container)
 {
 	int default_value = 0;